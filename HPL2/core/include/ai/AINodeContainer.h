@@ -71,9 +71,15 @@ namespace hpl {
 		const tString& GetName(){ return msName;}
 		int GetID(){ return mlID; }
 
+		/**
+		 * Index of the node in its container, always in [0, GetNodeNum()).
+		 */
+		int GetIndex() const { return mlIndex; }
+
 	private:
 		tString msName;
 		int mlID;
+		int mlIndex;
 		cVector3f mvPosition;
 		void *mpUserData;
 
@@ -203,7 +209,7 @@ namespace hpl {
 
 
 		/**
-		 * Compile the added nodes.
+		 * Compile the added nodes. The edges of each node are built in parallel with the job manager, if there is one.
 		 */
 		void Compile();
 
@@ -264,18 +270,38 @@ namespace hpl {
 
 
 		/**
-		 * Saves all the node connections to file.
+		 * A hash of the nodes, the settings and the static bodies that the edges are checked against. If it has not
+		 * changed since the edges were saved, compiling again would give the same edges.
+		 */
+		tString GetGeometryHash();
+
+		/**
+		 * Hash of the static bodies in the physics world, serializing the mesh shapes. This is slow, so the world
+		 * only makes it once and shares it between all of its containers.
+		 */
+		static uint64_t GetStaticBodiesHash(iPhysicsWorld *apPhysicsWorld);
+
+		/**
+		 * Saves all the node connections to file, together with the geometry hash.
 		 */
 		void SaveToFile(const tWString &asFile);
 		/**
 		* Loads all node connections from file. Only to be done after all nodes are loaded.
+		* \param abCheckHash if true, nothing is loaded unless the saved geometry hash is the same as the current.
+		* \return true if the connections were loaded.
 		*/
-		void LoadFromFile(const tWString &asFile);
+		bool LoadFromFile(const tWString &asFile, bool abCheckHash=false);
 
 	private:
 		cVector2l GetGridPosFromLocal(const cVector2f &avLocalPos);
 		cAIGridNode* GetGrid(const cVector2l& avPos);
 
+		int GetFreePathRays(const cVector3f &avStart, const cVector3f &avEnd, int alRayNum, cVector3f *apStarts, cVector3f *apEnds);
+
+		void CompileNode(cAINode *apNode);
+		bool CompileFreePath(const cVector3f &avStart, const cVector3f &avEnd);
+		static void CompileNodesJob(void *apData, int alStart, int alEnd);
+
 		tString msName;
 		tString msNodeName;
 
@@ -283,6 +309,7 @@ namespace hpl {
 		cVector3f mvSize;
 
 		cAINodeRayCallback *mpRayCallback;
+		iPhysicsRayQuery *mpCompileRayQuery;
 		tAINodeVec mvNodes;
 		tAINodeNameMap m_mapNodesByName;
 		tAINodeIDMap m_mapNodesByID;
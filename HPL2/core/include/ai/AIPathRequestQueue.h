@@ -0,0 +1,223 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef HPL_AI_PATH_REQUEST_QUEUE_H
+#define HPL_AI_PATH_REQUEST_QUEUE_H
+
+#include "system/SystemTypes.h"
+#include "math/MathTypes.h"
+#include "system/JobManager.h"
+
+#include "ai/AStar.h"
+
+namespace hpl {
+
+	class cAINodeContainer;
+	class iMutex;
+
+	//--------------------------------------
+
+	enum eAIPathRequestState
+	{
+		eAIPathRequestState_Invalid,	//No request with the handle exists
+		eAIPathRequestState_Pending,	//Waiting for ray checks or being solved
+		eAIPathRequestState_Found,
+		eAIPathRequestState_NotFound,
+
+		eAIPathRequestState_LastEnum
+	};
+
+	//--------------------------------------
+
+	/**
+	 * Read-only copy of the node graph of a container. Search jobs only ever touch this and never the
+	 * container itself.
+	 */
+	class cAINodeGraphSnapshot
+	{
+	public:
+		cAINodeGraphSnapshot(cAINodeContainer *apContainer);
+
+		int GetNodeNum() const { return (int)mvPositions.size(); }
+
+		std::vector<cVector3f> mvPositions;
+		std::vector<int> mvEdgeStart;	//Edges of node i are [mvEdgeStart[i], mvEdgeStart[i+1])
+		std::vector<int> mvEdgeNodes;
+		std::vector<float> mvEdgeDistances;
+	};
+
+	//--------------------------------------
+
+	class cAIPathRequest
+	{
+	public:
+		int mlHandle;
+		int mlPriority;
+		int mlMaxIterations;
+		iAStarCallback *mpCallback;	//If set, the request is solved on the main thread
+
+		cVector3f mvStart;
+		cVector3f mvGoal;
+
+		bool mbRaysChecked;
+		bool mbCancelled;
+		bool mbFound;	//Set by the search
+		eAIPathRequestState mState;
+
+		std::vector<int> mvStartNodes;
+		std::vector<float> mvStartDistances;
+		std::vector<int> mvGoalNodes;
+
+		std::vector<int> mvPath; //Goal first, same order as cAStarHandler::GetPath
+	};
+
+	typedef std::map<int, cAIPathRequest*> tAIPathRequestMap;
+	typedef tAIPathRequestMap::iterator tAIPathRequestMapIt;
+
+	typedef std::vector<cAIPathRequest*> tAIPathRequestVec;
+
+	//--------------------------------------
+
+	/**
+	 * Search data for solving one request at a time. Each job borrows one from the queue.
+	 */
+	class cAIPathSearch
+	{
+	public:
+		cAIPathSearch(cAINodeContainer *apContainer, const cAINodeGraphSnapshot *apGraph);
+
+		void Solve(cAIPathRequest *apRequest);
+
+	private:
+		void AddOpenNode(int alNode, int alParent, float afDistance);
+		int PopBestNode();
+		void HeapSiftUp(int alIdx);
+		void HeapSiftDown(int alIdx);
+
+		cAINodeContainer *mpContainer;
+		const cAINodeGraphSnapshot *mpGraph;
+		cVector3f mvGoal;
+
+		//Per node search data, valid if the generation matches the current search
+		std::vector<int> mvGenerations;
+		std::vector<int> mvGoalGenerations;
+		std::vector<int> mvHeapIndices;
+		std::vector<int> mvParents;
+		std::vector<float> mvCosts;
+		std::vector<float> mvDistances;
+		int mlGeneration;
+
+		std::vector<int> mvOpenHeap;
+	};
+
+	typedef std::vector<cAIPathSearch*> tAIPathSearchVec;
+
+	//--------------------------------------
+
+	/**
+	 * Solves path requests for a node container on the global job manager. The physics part of a request (free path
+	 * checks from start and goal to nearby nodes) is done in Update, on the main thread, with a budget on
+	 * the number of rays per call. The graph search is then done by a job on a snapshot of the graph.
+	 */
+	class cAIPathRequestQueue
+	{
+	public:
+		cAIPathRequestQueue(cAINodeContainer *apContainer);
+		~cAIPathRequestQueue();
+
+		cAINodeContainer* GetContainer(){ return mpContainer;}
+
+		/**
+		 * Adds a path request. Requests with higher priority get their ray checks done first.
+		 * \param apCallback used to skip edges, same as in cAStarHandler. Requests with a callback are solved on the main thread.
+		 * \return handle used to poll the request.
+		 */
+		int RequestPath(const cVector3f& avStart, const cVector3f& avGoal, int alPriority=0, iAStarCallback *apCallback=NULL);
+
+		/**
+		 * Finds a path right away on the calling thread, same as cAStarHandler::GetPath. Only call from the main thread.
+		 * \param apNodeList the path, goal node first. Empty if there is a free path to the goal.
+		 * \return true if a path was found.
+		 */
+		bool GetPath(const cVector3f& avStart, const cVector3f& avGoal, tAINodeList *apNodeList, iAStarCallback *apCallback=NULL);
+
+		eAIPathRequestState GetRequestState(int alHandle);
+
+		/**
+		 * Gets the result of a request that is no longer pending and releases it, the handle is invalid after this.
+		 * \param apNodeList the path, goal node first (same as cAStarHandler::GetPath). Empty if there is a free path to the goal.
+		 * \return true if a path was found.
+		 */
+		bool GetRequestResult(int alHandle, tAINodeList *apNodeList);
+
+		/**
+		 * Releases a request, any result is thrown away.
+		 */
+		void CancelRequest(int alHandle);
+
+		/**
+		 * Does ray checks for waiting requests and collects solved ones. Shall be called once per frame.
+		 */
+		void Update();
+
+		/**
+		 * Set max number of free path checks done per update. At least one request is always processed.
+		 */
+		void SetMaxRayChecksPerUpdate(int alX){ mlMaxRayChecksPerUpdate = alX;}
+		int GetMaxRayChecksPerUpdate(){ return mlMaxRayChecksPerUpdate;}
+
+		/**
+		 * Set max number of times the search is iterated. -1 = until open list is empty
+		 */
+		void SetMaxIterations(int alX){ mlMaxIterations = alX;}
+
+	private:
+		int CheckRequestRays(cAIPathRequest *apRequest);
+		cAIPathRequest* PopSolveRequest();
+
+		cAIPathSearch* PopSearchOrRequeue(cAIPathRequest *apRequest);
+		cAIPathRequest* AddSolvedAndPopNext(cAIPathRequest *apRequest, cAIPathSearch *apSearch);
+
+		static void SolveRequestJob(void *apData, int alStart, int alEnd);
+
+		cAINodeContainer *mpContainer;
+		cAINodeGraphSnapshot *mpGraph;
+		cAIPathSearch *mpMainSearch; //Used for requests solved on the main thread
+
+		int mlHandleCount;
+		int mlMaxRayChecksPerUpdate;
+		int mlMaxIterations;
+
+		tAIPathRequestMap m_mapRequests;
+		tAIPathRequestVec mvWaitingRequests;
+
+		//Shared with jobs, only use when mpMutex is locked
+		iMutex *mpMutex;
+		tAIPathRequestVec mvSolveRequests;
+		tAIPathRequestVec mvSolvedRequests;
+		tAIPathSearchVec mvFreeSearches;
+		int mlSearchNum;
+
+		cJobCounter mSolveJobCounter;
+	};
+
+	//--------------------------------------
+
+};
+#endif // HPL_AI_PATH_REQUEST_QUEUE_H
@@ -44,6 +44,7 @@ namespace hpl {
 	class cAStarNode
 	{
 	public:
+		cAStarNode();
 		cAStarNode(cAINode *apAINode);
 
 		float mfCost;
@@ -51,17 +52,14 @@ namespace hpl {
 
 		cAStarNode *mpParent;
 		cAINode *mpAINode;
-	};
 
-	class cAStarNodeCompare
-	{
-	public:
-		bool operator()(cAStarNode* apNodeA,cAStarNode* apNodeB) const;
+		int mlGeneration;		//Node is only valid for the search with the same generation
+		int mlGoalGeneration;	//Node is a goal node for the search with the same generation
+		int mlHeapIndex;		//Position in the open heap, -1 = closed
 	};
 
-
-	typedef std::set<cAStarNode*,cAStarNodeCompare> tAStarNodeSet;
-	typedef tAStarNodeSet::iterator tAStarNodeSetIt;
+	typedef std::vector<cAStarNode> tAStarNodeVec;
+	typedef std::vector<cAStarNode*> tAStarNodePtrVec;
 
 	//--------------------------------------
 	class cAStarHandler;
@@ -99,6 +97,12 @@ namespace hpl {
 
 		cAStarNode* GetBestNode();
 
+		void SetupNodes();
+		cAStarNode* GetNode(cAINode *apAINode);
+
+		void HeapSiftUp(int alIdx);
+		void HeapSiftDown(int alIdx);
+
 		float Cost(float afDistance, cAINode *apAINode, cAStarNode *apParent);
 		float Heuristic(const cVector3f& avStart, const cVector3f& avGoal);
 
@@ -107,7 +111,6 @@ namespace hpl {
 		cVector3f mvGoal;
 
         cAStarNode* mpGoalNode;
-		tAINodeSet m_setGoalNodes;
 
 		cAINodeContainer *mpContainer;
 
@@ -115,8 +118,13 @@ namespace hpl {
 
 		iAStarCallback *mpCallback;
 
-		tAStarNodeSet m_setOpenList;
-		tAStarNodeSet m_setClosedList;
+		//One node per AI node, indexed by cAINode::GetIndex. Reused between searches, the generation
+		//tells what nodes have been visited by the current search.
+		tAStarNodeVec mvNodes;
+		int mlGeneration;
+
+		//Binary min-heap on cost
+		tAStarNodePtrVec mvOpenHeap;
 	};
 
 };
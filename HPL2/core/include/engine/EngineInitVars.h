@@ -44,6 +44,19 @@ namespace hpl {
 		};
 		cEngineVars mGame;
 
+		////////////////////////////////
+		// System
+		class cSystemVars
+		{
+		public:
+			cSystemVars() :
+				mlJobWorkerNum(-1)
+			{}
+
+			int mlJobWorkerNum; //Below 0 means one worker per core except for the main thread.
+		};
+		cSystemVars mSystem;
+
 		////////////////////////////////
 		// Graphics
 		class cGraphicsVars
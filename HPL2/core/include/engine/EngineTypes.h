@@ -30,7 +30,8 @@ namespace hpl {
 
 	enum eHplAPI
 	{
-		eHplAPI_OpenGL
+		eHplAPI_OpenGL,
+		eHplAPI_Null		//No window or GPU, all graphics commands are only recorded. Used for benchmarking.
 	};
 
 	//---------------------------------------
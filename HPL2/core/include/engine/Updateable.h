@@ -22,13 +22,14 @@
 
 #include "engine/EngineTypes.h"
 #include "system/SystemTypes.h"
+#include "system/Profiler.h"
 
 namespace hpl {
 
 	class iUpdateable
 	{
 	public:
-		iUpdateable(const tString& asName) : msName(asName){}
+		iUpdateable(const tString& asName) : msName(asName), mpProfileZoneName(""), mlProfileZoneGeneration(0){}
 		virtual ~iUpdateable() {}
 
 		virtual void OnPostBufferSwap(){}
@@ -113,8 +114,24 @@ namespace hpl {
 
 		const tString& GetName(){ return msName;}
 
+		/**
+		 * The name as a profiler zone name, only looked up again when the profiler has been initialized anew.
+		 */
+		const char* GetProfileZoneName()
+		{
+			int lGeneration = cProfiler::GetGeneration();
+			if(mlProfileZoneGeneration != lGeneration)
+			{
+				mpProfileZoneName = cProfiler::GetZoneName(msName);
+				mlProfileZoneGeneration = lGeneration;
+			}
+			return mpProfileZoneName;
+		}
+
 	private:
 		tString msName;
+		const char *mpProfileZoneName;
+		int mlProfileZoneGeneration;
 	};
 };
 
@@ -39,12 +39,13 @@ namespace hpl {
 
 		/**
 		 * Creates a new key frame. These should be added in sequential order.
+		 * The frames are stored in an array, so the pointer returned is only valid until the next frame is created.
 		 * \param afTime the time for the key frame.
 		 */
 		cKeyFrame* CreateKeyFrame(float afTime);
 		void ClearKeyFrames();
 
-		inline cKeyFrame* GetKeyFrame(int alIndex){ return mvKeyFrames[alIndex];}
+		inline cKeyFrame* GetKeyFrame(int alIndex){ return &mvKeyFrames[alIndex];}
 		inline int GetKeyFrameNum(){ return (int) mvKeyFrames.size();}
 
 		inline tAnimTransformFlag GetTransformFlags(){ return mTransformFlags;}
@@ -55,23 +56,31 @@ namespace hpl {
 		 * \param apNode The node with it's base pose
 		 * \param afTime The time at which to apply the animation
 		 * \param afWeight The weight of the animation, a value from 0 to 1.
+		 * \param apCursor Key frame index found at the last call, see GetKeyFramesAtTime.
 		 */
-		void ApplyToNode(cNode3D* apNode, float afTime, float afWeight,bool bLoop=true);
+		void ApplyToNode(cNode3D* apNode, float afTime, float afWeight,bool bLoop=true, int *apCursor=NULL);
+
+		/**
+		 * Same as ApplyToNode, but adds to a rotation and translation instead of a node.
+		 */
+		void ApplyToPose(cQuaternion& aqRotation, cVector3f& avTranslation, float afTime, float afWeight, int *apCursor=NULL);
 
 		/**
 		 * Get a KeyFrame that contains an interpolated value.
 		 * \param afTime The time from which to create the key frame.
 		 */
-		cKeyFrame GetInterpolatedKeyFrame(float afTime,bool bLoop=true);
+		cKeyFrame GetInterpolatedKeyFrame(float afTime,bool bLoop=true, int *apCursor=NULL);
 
         /**
          * Gets key frames between for a specific time.
          * \param afTime The time
          * \param &apKeyFrameA The frame that is equal to or before time
          * \param &apKeyFrameB The frame that is after time.
+         * \param apCursor If not NULL, the index of frame B found at the last call. It is checked (and the frame after it) before
+         * searching, so playing an animation only costs a search when jumping in time. Is updated with the new index.
          * \return Weight of the different frames. 0 = 100% A, 1 = 100% B 0.5 = 50% A and 50% B
          */
-        float GetKeyFramesAtTime(float afTime, cKeyFrame** apKeyFrameA,cKeyFrame** apKeyFrameB,bool bLoop=true);
+        float GetKeyFramesAtTime(float afTime, cKeyFrame** apKeyFrameA,cKeyFrame** apKeyFrameB,bool bLoop=true, int *apCursor=NULL);
 
 		void Smooth(float afAmount, float afPow, int alSamples,bool abTranslation, bool abRotation);
 
@@ -81,11 +90,14 @@ namespace hpl {
 		int GetNodeIndex(){ return mlNodeIdx;}
 
 	private:
+		int FindKeyFrameAfter(float afTime, int *apCursor);
+
 		tString msName;
 
 		int mlNodeIdx;
 
-		tKeyFramePtrVec mvKeyFrames;
+		tKeyFrameVec mvKeyFrames;
+		tFloatVec mvKeyFrameTimes;
 		tAnimTransformFlag mTransformFlags;
 
 		float mfMaxFrameTime;
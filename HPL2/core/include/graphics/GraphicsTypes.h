@@ -687,6 +687,7 @@ namespace hpl {
 	#define eRenderableFlag_VisibleInReflection		(0x00000002)
 	#define eRenderableFlag_VisibleInNonReflection	(0x00000004)
 	#define eRenderableFlag_ContainerDebug			(0x00000008)
+	#define eRenderableFlag_Occluder				(0x00000010)	//Solid enough to be drawn into the software occlusion buffer
 
 	//---------------------------------------
 
@@ -24,6 +24,8 @@
 #include "math/MathTypes.h"
 #include "system/SystemTypes.h"
 
+#include <stdint.h>
+
 namespace hpl {
 
 	//---------------------------------------------
@@ -39,6 +41,45 @@ namespace hpl {
 
 	//---------------------------------------------
 
+	/**
+	 * A packed sort key together with the object it belongs to. Keys are built once per object and list,
+	 * so that sorting never needs to look at materials.
+	 */
+	struct cRenderListSortEntry
+	{
+		uint64_t mlKey;
+		iRenderable *mpObject;
+	};
+
+	typedef std::vector<cRenderListSortEntry> tRenderListSortEntryVec;
+
+	//---------------------------------------------
+
+	/**
+	 * Maps pointers (programs, textures, vertex buffers, etc) to small, dense ids that can be packed into
+	 * sort keys. Ids are given out in the order pointers are first seen and are only valid until the next Clear.
+	 */
+	class cRenderListIdMap
+	{
+	public:
+		cRenderListIdMap();
+
+		void Clear();
+		unsigned int GetId(const void *apPtr);
+		unsigned int GetId(uint64_t alValue);
+
+	private:
+		void Grow();
+
+		std::vector<uint64_t> mvKeys;
+		std::vector<unsigned int> mvIds;
+		std::vector<unsigned int> mvGenerations;
+		unsigned int mlGeneration;
+		unsigned int mlCount;
+	};
+
+	//---------------------------------------------
+
 	class cRenderList
 	{
 	public:
@@ -76,6 +117,9 @@ namespace hpl {
 	private:
 		void CompileArray(eRenderListType aType);
 
+		uint64_t GetSortKey(eRenderListType aType, iRenderable *apObject);
+		void RadixSort(tRenderListSortEntryVec& avEntries);
+
 		void FindNearestLargeSurfacePlane();
 
 		float mfFrameTime;
@@ -90,6 +134,14 @@ namespace hpl {
 		std::vector<cFogArea*> mvFogAreas;
 
 		tRenderableVec mvSortedArrays[eRenderListType_LastEnum];
+
+		tRenderListSortEntryVec mvSortEntries;
+		tRenderListSortEntryVec mvSortTemp;
+		cRenderListIdMap mProgramIds;
+		cRenderListIdMap mTextureIds;
+		cRenderListIdMap mTextureSetIds;
+		cRenderListIdMap mVertexBufferIds;
+		cRenderListIdMap mMatrixIds;
 	};
 
 	//---------------------------------------------
@@ -23,6 +23,7 @@
 #include "graphics/GraphicsTypes.h"
 #include "math/MathTypes.h"
 #include "scene/SceneTypes.h"
+#include "scene/RenderableContainer.h"
 
 #include "graphics/RenderFunctions.h"
 
@@ -42,11 +43,13 @@ namespace hpl {
 	class cRenderList;
 	class cProgramComboManager;
 	class iLight;
+	class cLightSpot;
 	class iOcclusionQuery;
 	class cBoundingVolume;
 	class iRenderableContainer;
 	class iRenderableContainerNode;
 	class cVisibleRCNodeTracker;
+	class cSoftwareOcclusion;
 
 	//---------------------------------------------
 
@@ -144,6 +147,8 @@ namespace hpl {
 
 		std::vector<cFogAreaRenderData> mvFogRenderData;
 
+		cSoftwareOcclusion *mpSoftwareOcclusion;	//Created when first used
+
         ////////////////////////////
 		//General settings
 		bool mbLog;
@@ -154,10 +159,13 @@ namespace hpl {
 		//Render settings
 		int mlMinimumObjectsBeforeOcclusionTesting;
 		int mlSampleVisiblilityLimit;
+		float mfOcclusionQueryGroupSize;		//Nodes with a radius smaller than this times their distance are queried as a whole, like a leaf.
 		bool mbIsReflection;
 		bool mbClipReflectionScreenRect;
 
 		bool mbUseOcclusionCulling;
+		bool mbUseSoftwareOcclusionCulling;		//Cull on the CPU against large occluders instead of using GPU queries.
+		int mlSoftwareOcclusionMaxOccluders;
 
 		bool mbUseEdgeSmooth;
 
@@ -187,6 +195,7 @@ namespace hpl {
 		//Output
 		int mlNumberOfLightsRendered;
 		int mlNumberOfOcclusionQueries;
+		int mlNumberOfSoftwareOccluders;
 
 		////////////////////////////
 		//Debug
@@ -240,6 +249,26 @@ namespace hpl {
 
 	//---------------------------------------------
 
+	/**
+	 * Data used when getting the shadow casters for a spot light. Each light has its own, so several lights can be gathered at the same time.
+	 */
+	class cShadowCasterGatherData
+	{
+	public:
+		iLight *mpLight;
+		cFrustum *mpLightFrustum;
+		cFrustum *mpViewFrustum;
+
+		eFrustumPlane mvBeyondLightAndViewPlanes[eFrustumPlane_LastEnum]; //Use to check if an caster is not going to affect view.
+		int mlBeyondLightAndViewPlaneNum;
+		bool mbLightBehindNearPlane;
+
+		std::vector<std::pair<float, iRenderable*> > mvCasters; //Squared distance to light and object.
+		tRenderableContainerObjectRangeVec mvObjectRanges;
+	};
+
+	//---------------------------------------------
+
 
 	class iRenderer : public iRenderFunctions
 	{
@@ -334,6 +363,14 @@ namespace hpl {
 		void CheckForVisibleAndAddToList(iRenderableContainer *apContainer, tRenderableFlag alNeededFlags);
 
 		void CheckNodesAndAddToListIterative(iRenderableContainerNode *apNode, tRenderableFlag alNeededFlags);
+		int GetNodeCullPlanes(const cPlanef **appPlanes);
+
+		/**
+		 * Draws the largest occluders in view into the software occlusion buffer and makes CheckForVisibleAndAddToList use it.
+		 * Nothing is done unless enabled in the settings.
+		 */
+		void SetupSoftwareOcclusion(tRenderableFlag alNeededFlags);
+		bool CheckObjectIsSoftwareOccluded(iRenderable *apObject);
 
 
 		/**
@@ -350,13 +387,41 @@ namespace hpl {
 		void PushUpVisibility(iRenderableContainerNode *apNode);
 		void RenderNodeBoundingBox(iRenderableContainerNode *apNode, iOcclusionQuery *apQuery);
 		int RenderAndAddNodeObjects(iRenderableContainerNode *apNode, tRenderCHCObjectCallbackFunc apRenderCallback, tRenderableFlag alNeededFlags);
+		int RenderAndAddNodeTreeObjects(iRenderableContainerNode *apNode, tRenderCHCObjectCallbackFunc apRenderCallback, tRenderableFlag alNeededFlags);
+		bool NodeIsOcclusionQueryLeaf(iRenderableContainerNode *apNode);
 
 		void PushNodeChildrenToStack(tRendererSortedNodeSet& a_setNodeStack, iRenderableContainerNode *apNode, int alNeededFlags);
 		void AddAndRenderNodeOcclusionQuery(tNodeOcclusionPairList *apList, iRenderableContainerNode *apNode, bool abObjectsRendered);
 
-		bool CheckShadowCasterContributesToView(iRenderable *apObject);
-		void GetShadowCastersIterative(iRenderableContainerNode *apNode, eCollision aPrevCollision);
-		void GetShadowCasters(iRenderableContainer *apContainer, tRenderableVec& avObjectVec, cFrustum *apLightFrustum);
+		bool CheckShadowCasterContributesToView(iRenderable *apObject, cShadowCasterGatherData *apData);
+		void GetShadowCastersIterative(iRenderableContainerNode *apNode, eCollision aPrevCollision, cShadowCasterGatherData *apData);
+		void CheckShadowCasterAndAddToVec(iRenderable *apObject, eCollision aNodeCollision, cShadowCasterGatherData *apData);
+		void GetShadowCasters(iRenderableContainer *apContainer, cShadowCasterGatherData *apData);
+
+		/**
+		 * Sets up the light and view variables in the data. Must be called on the main thread, since the light frustum is updated.
+		 */
+		void SetupShadowCasterGatherData(cLightSpot *apLight, cShadowCasterGatherData *apData);
+		/**
+		 * Gets and sorts the casters of the light in the data. Can be run in a job if the containers and the bounding volumes of the objects
+		 * are updated before, since getting a bounding volume that is not up to date writes to it.
+		 */
+		void GatherShadowCasters(cShadowCasterGatherData *apData);
+		void UpdateShadowCasterContainers(tObjectVariabilityFlag alObjectTypes);
+		/**
+		 * Updates the BVs of the casters in the nodes that one of the pre gathered light frustums reaches, the jobs do not look at any others.
+		 */
+		void UpdateShadowCasterBoundingVolumes(iRenderableContainerNode *apNode, bool abInsideLightFrustum);
+
+		/**
+		 * Gets the shadow casters for all the lights at once, using the job manager if there is one. SetupShadowMapRendering then uses these
+		 * instead of gathering them again. Lights that are not spot lights or use occlusion culling of casters are skipped.
+		 * The result is valid until ClearPreGatheredShadowCasters is called, the containers must not change until then.
+		 */
+		void PreGatherShadowCasters(const std::vector<iLight*>& avLights);
+		void ClearPreGatheredShadowCasters();
+		static void PreGatherShadowCastersJob(void *apData, int alStart, int alEnd);
+
 		bool SetupShadowMapRendering(iLight *apLight);
 
 		static bool RenderShadowCasterCHCStaticCallback(iRenderer *apRenderer, iRenderable *apObject);
@@ -467,6 +532,14 @@ namespace hpl {
 		float mfScissorLastTanHalfFov;
 
 		tRenderableVec mvShadowCasters;
+		tRenderableContainerObjectRangeVec mvContainerObjectRanges;
+
+		cShadowCasterGatherData mShadowCasterData;
+		std::vector<cShadowCasterGatherData*> mvPreGatheredShadowCasters;
+		int mlPreGatheredShadowCasterNum;
+
+		cSoftwareOcclusion *mpCurrentSoftwareOcclusion;
+		std::vector<std::pair<float, iRenderable*> > mvSoftwareOccluderCandidates;
 
 		static int mlRenderFrameCount;
 		float mfTimeCount;
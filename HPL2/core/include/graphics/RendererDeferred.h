@@ -312,6 +312,7 @@ namespace hpl {
 
 		std::vector<cDeferredLight*> mvTempDeferredLights;
 		std::vector<cDeferredLight*> mvSortedLights[eDeferredLightList_LastEnum];
+		std::vector<iLight*> mvShadowCastingLights;
 
 		iGpuProgram *mpSkyBoxProgram;
 		iGpuProgram *mpLightStencilProgram;
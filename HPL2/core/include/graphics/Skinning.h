@@ -0,0 +1,85 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef HPL_SKINNING_H
+#define HPL_SKINNING_H
+
+#include "math/MathTypes.h"
+
+namespace hpl {
+
+	//---------------------------------------------
+
+	/**
+	 * Input and output arrays for skinning a range of vertices. Weights and bones are fixed 4 per vertex streams,
+	 * a vertex uses weights until the first 0 weight. Vertices with a 0 first weight are left untouched.
+	 */
+	class cSkinningData
+	{
+	public:
+		const float *mpBindPos;
+		const float *mpBindNormal;
+		const float *mpBindTangent;
+
+		float *mpSkinPos;
+		float *mpSkinNormal;
+		float *mpSkinTangent;
+
+		int mlPosStride;
+
+		const float *mpWeights;
+		const unsigned char *mpBones;
+
+		const cMatrixf *mpBoneMatrices;
+		const float *mpBoneColumns;		//Created with cSkinning::SetupBoneColumns
+	};
+
+	//---------------------------------------------
+
+	class cSkinning
+	{
+	public:
+		/**
+		 * Stores the upper 3x4 part of the bone matrices column wise, 16 floats per bone, as used by the SIMD kernel.
+		 */
+		static void SetupBoneColumns(const cMatrixf *apBoneMatrices, int alBoneNum, std::vector<float> &avColumns);
+
+		/**
+		 * Skins vertices [alStart, alEnd). Ranges that do not overlap can be skinned at the same time.
+		 * Uses SSE when available and gives the exact same result as SkinVerticesScalar.
+		 */
+		static void SkinVertices(const cSkinningData &aData, int alStart, int alEnd);
+
+		static void SkinVerticesScalar(const cSkinningData &aData, int alStart, int alEnd);
+
+		/**
+		 * Skins vertices [0, alVertexNum). Meshes with more than GetParallelGrainSize() vertices are split into ranges of
+		 * that size and skinned on the global job manager, if there is one. The result is the same as SkinVertices.
+		 */
+		static void SkinVerticesParallel(const cSkinningData &aData, int alVertexNum);
+
+		static int GetParallelGrainSize();
+
+		static bool UsesSimd();
+	};
+
+	//---------------------------------------------
+
+};
+#endif // HPL_SKINNING_H
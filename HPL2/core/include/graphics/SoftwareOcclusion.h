@@ -0,0 +1,139 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef HPL_SOFTWARE_OCCLUSION_H
+#define HPL_SOFTWARE_OCCLUSION_H
+
+#include "math/MathTypes.h"
+#include "scene/RenderableContainer.h"
+
+namespace hpl {
+
+	//---------------------------------------------
+
+	class iRenderable;
+	class cFrustum;
+
+	//---------------------------------------------
+
+	/**
+	 * A triangle in screen space, depth is stored as 1/w so it can be interpolated linearly.
+	 */
+	class cSoftOcclusionTriangle
+	{
+	public:
+		float mfX[3];
+		float mfY[3];
+		float mfInvW[3];
+	};
+
+	typedef std::vector<cSoftOcclusionTriangle> tSoftOcclusionTriangleVec;
+
+	//---------------------------------------------
+
+	class cSoftOcclusionMesh
+	{
+	public:
+		const float *mpPositions;
+		int mlStride;
+		const unsigned int *mpIndices;
+		int mlIndexNum;
+		cMatrixf m_mtxModel;
+	};
+
+	//---------------------------------------------
+
+	/**
+	 * Rasterizes occluders into a small depth buffer on the CPU and tests boxes against it. Each 8x8 tile keeps the
+	 * farthest depth in it, so most boxes are rejected or accepted without looking at single pixels.
+	 * Does not use any GPU resources, so results are ready the same frame.
+	 */
+	class cSoftwareOcclusion : public iRenderableContainerNodeFilter
+	{
+	public:
+		/**
+		 * Sizes are rounded up to whole tiles.
+		 */
+		cSoftwareOcclusion(int alWidth=256, int alHeight=128);
+		~cSoftwareOcclusion();
+
+		/**
+		 * Clears the buffer and occluders and sets up the view. Returns false if the frustum is not a perspective one,
+		 * all boxes are then visible until the next call.
+		 */
+		bool BeginFrame(cFrustum *apFrustum);
+
+		/**
+		 * Adds the triangles in the vertex buffer of the object. The data is read in Rasterize, so it must stay valid until then.
+		 */
+		void AddOccluder(iRenderable *apObject);
+		void AddOccluderMesh(const float *apPositions, int alStride, const unsigned int *apIndices, int alIndexNum, const cMatrixf &a_mtxModel);
+
+		/**
+		 * Transforms and draws all occluders using the job manager (if there is one) and builds the tile depths.
+		 */
+		void Rasterize();
+
+		/**
+		 * Returns false only if the box is behind the occluders everywhere. The screen rect of the box is grown by
+		 * one pixel since occluder coverage is sampled at pixel centers.
+		 */
+		bool IsAABBVisible(const cVector3f &avMin, const cVector3f &avMax) const;
+		bool IsNodeVisible(const cVector3f &avMin, const cVector3f &avMax){ return IsAABBVisible(avMin, avMax);}
+
+		bool IsActive() const { return mbActive;}
+
+		int GetWidth() const { return mlWidth;}
+		int GetHeight() const { return mlHeight;}
+		float GetDepth(int alX, int alY) const { return mvDepth[alY*mlWidth + alX];}
+
+		int GetOccluderNum() const { return (int)mvOccluders.size();}
+		int GetTriangleNum() const;
+
+		static bool UsesSimd();
+
+	private:
+		static void TransformOccludersJob(void *apData, int alStart, int alEnd);
+		static void RasterizeTileRowsJob(void *apData, int alStart, int alEnd);
+
+		void TransformOccluder(int alIdx);
+		void AddTriangle(const cVector3f *apClipPos, tSoftOcclusionTriangleVec *apTriangles);
+		void RasterizeTriangle(const cSoftOcclusionTriangle &aTri, int alY0, int alY1);
+		void BuildTileDepth(int alTileY);
+
+		int mlWidth;
+		int mlHeight;
+		int mlTilesX;
+		int mlTilesY;
+
+		bool mbActive;
+		cMatrixf m_mtxViewProj;
+		float mfNearClipW;
+
+		std::vector<float> mvDepth;
+		std::vector<float> mvTileDepth;
+
+		std::vector<cSoftOcclusionMesh> mvOccluders;
+		std::vector<tSoftOcclusionTriangleVec> mvOccluderTriangles;
+	};
+
+	//---------------------------------------------
+
+};
+#endif // HPL_SOFTWARE_OCCLUSION_H
@@ -38,7 +38,6 @@ namespace hpl {
 				mpLowLevelGraphics(apLowLevelGraphics),
 				mbUseMipMaps(false),
 				mbIsCompressed(false),
-				mlMemorySize(0),
 				mPixelFormat(ePixelFormat_Unknown),
 				mWrapS(eTextureWrap_Repeat), mWrapT(eTextureWrap_Repeat),mWrapR(eTextureWrap_Repeat),
 				mfFrameTime(1), mAnimMode(eTextureAnimMode_Loop), mlSizeDownScaleLevel(0), mvMinDownScaleSize(16,16,16),
@@ -96,8 +95,6 @@ namespace hpl {
 
 		virtual void AutoGenerateMipmaps()=0;
 
-		int GetMemorySize(){ return mlMemorySize;}
-
 		void SetFrameTime(float afX){ mfFrameTime = afX;}
 		float GetFrameTime(){ return mfFrameTime;}
 
@@ -131,8 +128,6 @@ namespace hpl {
 
 		cVector3l mvSize;
 
-		int mlMemorySize;
-
 		eTextureWrap mWrapS;
 		eTextureWrap mWrapT;
 		eTextureWrap mWrapR;
@@ -33,6 +33,8 @@
 #include "system/Mutex.h"
 #include "system/Platform.h"
 #include "system/SHA1.h"
+#include "system/Profiler.h"
+#include "system/JobManager.h"
 
 #include "input/Input.h"
 #include "input/InputDevice.h"
@@ -71,6 +73,7 @@
 #include "graphics/Animation.h"
 #include "graphics/AnimationTrack.h"
 #include "graphics/OcclusionQuery.h"
+#include "graphics/SoftwareOcclusion.h"
 #include "graphics/VideoStream.h"
 #include "graphics/Bitmap.h"
 #include "graphics/FrameTexture.h"
@@ -173,6 +176,7 @@
 
 #include "ai/AI.h"
 #include "ai/AStar.h"
+#include "ai/AIPathRequestQueue.h"
 #include "ai/AINodeContainer.h"
 #include "ai/AINodeGenerator.h"
 #include "ai/StateMachine.h"
@@ -57,6 +57,7 @@ namespace hpl {
 
 		void SaveToSerializedData(cBinaryBuffer* apBinBuffer);
 		void CreateFromSerializedData(cBinaryBuffer* apBinBuffer);
+		bool CreateFromSerializedMemory(const void *apData, size_t alSize);
 
 		NewtonCollision* GetNewtonCollision(){ return mpNewtonCollision;}
 
@@ -0,0 +1,94 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef HPL_GPU_PROGRAM_NULL_H
+#define HPL_GPU_PROGRAM_NULL_H
+
+#include "graphics/GPUProgram.h"
+#include "graphics/GPUShader.h"
+
+namespace hpl {
+
+	class cLowLevelGraphicsNull;
+
+	//-------------------------------------------------
+
+	/**
+	 * Shader that accepts any code without compiling it.
+	 */
+	class cGpuShaderNull : public iGpuShader
+	{
+	public:
+		cGpuShaderNull(const tString& asName, eGpuShaderType aType, eGpuProgramFormat aProgramFormat) :
+				iGpuShader(asName, _W(""), aType, aProgramFormat){}
+
+		bool Reload(){ return false;}
+		void Unload(){}
+		void Destroy(){}
+
+		bool SamplerNeedsTextureUnitSetup(){ return false;}
+
+		bool CreateFromFile(const tWString& asFile, const tString& asEntry="main", bool abPrintInfoIfFail=true){ return true;}
+		bool CreateFromString(const char *apStringData, const tString& asEntry="main", bool abPrintInfoIfFail=true){ return true;}
+	};
+
+	//-------------------------------------------------
+
+	/**
+	 * Program that hands out an id for each variable name and records binds and variable sets.
+	 */
+	class cGpuProgramNull : public iGpuProgram
+	{
+	public:
+		cGpuProgramNull(const tString& asName, eGpuProgramFormat aProgramFormat, cLowLevelGraphicsNull* apLowLevelGraphics);
+		~cGpuProgramNull();
+
+		bool Link(){ return true;}
+
+		void Bind();
+		void UnBind(){}
+
+		bool CanAccessAPIMatrix(){ return true;}
+
+		bool SetSamplerToUnit(const tString& asSamplerName, int alUnit){ return true;}
+
+		int GetVariableId(const tString& asName);
+		bool GetVariableAsId(const tString& asName, int alId){ return true;}
+
+		bool SetInt(int alVarId, int alX);
+		bool SetFloat(int alVarId, float afX);
+		bool SetVec2f(int alVarId, float afX,float afY);
+		bool SetVec3f(int alVarId, float afX,float afY,float afZ);
+		bool SetVec4f(int alVarId, float afX,float afY,float afZ, float afW);
+		bool SetMatrixf(int alVarId, const cMatrixf& mMtx);
+		bool SetMatrixf(int alVarId, eGpuShaderMatrix mType, eGpuShaderMatrixOp mOp);
+
+		unsigned int mlId;
+		unsigned int mlLastUsedPass;
+
+	private:
+		bool RecordVariableSet(int alVarId);
+
+		cLowLevelGraphicsNull* mpNullGraphics;
+		std::map<tString, int> m_mapVariableIds;
+	};
+
+	//-------------------------------------------------
+
+};
+#endif // HPL_GPU_PROGRAM_NULL_H
@@ -0,0 +1,417 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef HPL_LOWLEVELGRAPHICS_NULL_H
+#define HPL_LOWLEVELGRAPHICS_NULL_H
+
+#include "graphics/LowLevelGraphics.h"
+#include "math/MathTypes.h"
+
+#include <stdint.h>
+
+namespace hpl {
+
+	//-------------------------------------------------
+
+	/**
+	 * Commands up to and including eNullGfxCommand_BindVertexBuffer change state and are checked for redundancy.
+	 */
+	enum eNullGfxCommand
+	{
+		eNullGfxCommand_ColorWrite,
+		eNullGfxCommand_DepthWrite,
+		eNullGfxCommand_Cull,
+		eNullGfxCommand_DepthTest,
+		eNullGfxCommand_AlphaTest,
+		eNullGfxCommand_Stencil,
+		eNullGfxCommand_Scissor,
+		eNullGfxCommand_ClipPlane,
+		eNullGfxCommand_Color,
+		eNullGfxCommand_Blend,
+		eNullGfxCommand_PolygonOffset,
+		eNullGfxCommand_Matrix,
+		eNullGfxCommand_TextureEnv,
+		eNullGfxCommand_SetTexture,
+		eNullGfxCommand_BindProgram,
+		eNullGfxCommand_BindVertexBuffer,
+
+		eNullGfxCommand_SetProgramVar,
+		eNullGfxCommand_SetFrameBuffer,
+		eNullGfxCommand_ClearFrameBuffer,
+		eNullGfxCommand_DrawVertexBuffer,
+		eNullGfxCommand_DrawImmediate,
+		eNullGfxCommand_BeginOcclusionQuery,
+		eNullGfxCommand_EndOcclusionQuery,
+
+		eNullGfxCommand_LastEnum
+	};
+
+	#define kNullGfxMaxCommandTargets (16)
+
+	//-------------------------------------------------
+
+	/**
+	 * A recorded command. Target is the sub state, unit or matrix and value is a hash of the state,
+	 * the id of the resource or the number of indices/vertices drawn.
+	 */
+	class cNullGfxCommand
+	{
+	public:
+		unsigned char mType;
+		unsigned char mlTarget;
+		unsigned int mlValue;
+	};
+
+	typedef std::vector<cNullGfxCommand> tNullGfxCommandVec;
+
+	//-------------------------------------------------
+
+	/**
+	 * Counters for everything rendered to one frame buffer, a new pass starts each time the frame buffer is set.
+	 * The counters are 64 bit since the same class sums up all frames of a long run.
+	 */
+	class cNullGfxPassStats
+	{
+	public:
+		cNullGfxPassStats();
+
+		void Add(const cNullGfxPassStats &aStats);
+
+		tString msFrameBufferName;
+
+		int mlCommandStart;
+		int64_t mlCommandNum;
+
+		int64_t mlDrawCalls;
+		int64_t mlImmediateDrawCalls;
+		int64_t mlIndicesDrawn;
+
+		int64_t mlStateChanges;
+		int64_t mlRedundantStateChanges;
+
+		int64_t mlTextureBinds;
+		int64_t mlProgramBinds;
+		int64_t mlVertexBufferBinds;
+		int64_t mlProgramVarSets;
+
+		int64_t mlUniqueTextures;
+		int64_t mlUniquePrograms;
+		int64_t mlUniqueVertexBuffers;
+
+		int64_t mlClears;
+		int64_t mlOcclusionQueries;
+	};
+
+	typedef std::vector<cNullGfxPassStats> tNullGfxPassStatsVec;
+
+	//-------------------------------------------------
+
+	/**
+	 * Graphics that need no window or GPU. Resources are stubs that only keep sizes (and vertex data, which the
+	 * rest of the engine reads) and everything sent to the graphics is recorded, so the CPU side of the renderers
+	 * can be profiled and the batching checked on machines without a GPU.
+	 * A frame ends at SwapBuffers, the commands and stats of the last frame are then available.
+	 */
+	class cLowLevelGraphicsNull : public iLowLevelGraphics
+	{
+	public:
+		cLowLevelGraphicsNull();
+		~cLowLevelGraphicsNull();
+
+		/////////////////////////////////////////////////////
+		/////////////// GENERAL SETUP ///////////////////////
+		/////////////////////////////////////////////////////
+
+		bool Init(	int alWidth, int alHeight, int alDisplay, int alBpp, int abFullscreen, int alMultisampling,
+					eGpuProgramFormat aGpuProgramFormat,const tString& asWindowCaption,
+					const cVector2l &avWindowPos);
+
+		eGpuProgramFormat GetGpuProgramFormat(){ return mGpuProgramFormat;}
+
+		int GetCaps(eGraphicCaps aType);
+
+		void ShowCursor(bool abX){}
+
+        void SetWindowGrab(bool abX){}
+
+        void SetRelativeMouse(bool abX){}
+
+        void SetWindowCaption(const tString &asName){}
+
+        bool GetWindowMouseFocus(){ return true;}
+
+        bool GetWindowInputFocus(){ return true;}
+
+        bool GetWindowIsVisible(){ return true;}
+
+		bool GetFullscreenModeActive() { return false; }
+
+		void SetVsyncActive(bool abX, bool abAdaptive){}
+
+		void SetMultisamplingActive(bool abX){}
+
+		void SetGammaCorrection(float afX){ mfGammaCorrection = afX;}
+		float GetGammaCorrection(){ return mfGammaCorrection;}
+
+		int GetMultisampling(){ return mlMultisampling;}
+
+		cVector2f GetScreenSizeFloat();
+		const cVector2l& GetScreenSizeInt();
+
+		/////////////////////////////////////////////////////
+		/////////////// DATA CREATION //////////////////////
+		/////////////////////////////////////////////////////
+
+		iFontData* CreateFontData(const tString &asName);
+
+		iTexture* CreateTexture(const tString &asName, eTextureType aType, eTextureUsage aUsage);
+
+		iVertexBuffer* CreateVertexBuffer(	eVertexBufferType aType,
+											eVertexBufferDrawType aDrawType,
+											eVertexBufferUsageType aUsageType,
+											int alReserveVtxSize=0,int alReserveIdxSize=0);
+
+		iGpuProgram* CreateGpuProgram(const tString& asName);
+		iGpuShader* CreateGpuShader(const tString& asName, eGpuShaderType aType);
+
+		iFrameBuffer* CreateFrameBuffer(const tString& asName);
+		iDepthStencilBuffer* CreateDepthStencilBuffer(const cVector2l& avSize, int alDepthBits, int alStencilBits);
+
+		iOcclusionQuery* CreateOcclusionQuery();
+
+		/////////////////////////////////////////////////////
+		/////////// FRAME BUFFER OPERATIONS ///////
+		/////////////////////////////////////////////////////
+
+		void ClearFrameBuffer(tClearFrameBufferFlag aFlags);
+
+		void SetClearColor(const cColor& aCol){}
+		void SetClearDepth(float afDepth){}
+		void SetClearStencil(int alVal){}
+
+		void CopyFrameBufferToTexure(	iTexture* apTex, const cVector2l &avPos,
+									const cVector2l &avSize, const cVector2l &avTexOffset=0);
+		cBitmap* CopyFrameBufferToBitmap(const cVector2l &avScreenPos=0, const cVector2l &avScreenSize=-1);
+
+		void WaitAndFinishRendering(){}
+		void FlushRendering(){}
+		void SwapBuffers();
+
+		void SetCurrentFrameBuffer(iFrameBuffer* apFrameBuffer, const cVector2l &avPos = 0, const cVector2l& avSize = -1);
+		iFrameBuffer* GetCurrentFrameBuffer() { return mpFrameBuffer; }
+
+		void SetFrameBufferDrawTargets(int *apTargets, int alNumOfTargets);
+
+		/////////////////////////////////////////////////////
+		/////////// RENDER STATE ////////////////////////////
+		/////////////////////////////////////////////////////
+
+		void SetColorWriteActive(bool abR,bool abG,bool abB,bool abA);
+		void SetDepthWriteActive(bool abX);
+
+		void SetCullActive(bool abX);
+		void SetCullMode(eCullMode aMode);
+
+		void SetDepthTestActive(bool abX);
+		void SetDepthTestFunc(eDepthTestFunc aFunc);
+
+		void SetAlphaTestActive(bool abX);
+		void SetAlphaTestFunc(eAlphaTestFunc aFunc,float afRef);
+
+		void SetStencilActive(bool abX);
+		void SetStencilWriteMask(unsigned int alMask);
+		void SetStencil(eStencilFunc aFunc,int alRef, unsigned int aMask,
+						eStencilOp aFailOp,eStencilOp aZFailOp,eStencilOp aZPassOp);
+		void SetStencilTwoSide(	eStencilFunc aFrontFunc,eStencilFunc aBackFunc,
+								int alRef, unsigned int aMask,
+								eStencilOp aFrontFailOp,eStencilOp aFrontZFailOp,eStencilOp aFrontZPassOp,
+								eStencilOp aBackFailOp,eStencilOp aBackZFailOp,eStencilOp aBackZPassOp);
+
+		void SetScissorActive(bool abX);
+		void SetScissorRect(const cVector2l& avPos, const cVector2l& avSize);
+
+		void SetClipPlane(int alIdx, const cPlanef& aPlane);
+		cPlanef GetClipPlane(int alIdx);
+		void SetClipPlaneActive(int alIdx, bool abX);
+
+		void SetColor(const cColor &aColor);
+
+		void SetBlendActive(bool abX);
+		void SetBlendFunc(eBlendFunc aSrcFactor, eBlendFunc aDestFactor);
+		void SetBlendFuncSeparate(	eBlendFunc aSrcFactorColor, eBlendFunc aDestFactorColor,
+									eBlendFunc aSrcFactorAlpha, eBlendFunc aDestFactorAlpha);
+
+		void SetPolygonOffsetActive(bool abX);
+		void SetPolygonOffset(float afBias,float afSlopeScaleBias);
+
+		/////////////////////////////////////////////////////
+		/////////// MATRIX //////////////////////////////////
+		/////////////////////////////////////////////////////
+
+		void PushMatrix(eMatrix aMtxType);
+		void PopMatrix(eMatrix aMtxType);
+		void SetIdentityMatrix(eMatrix aMtxType);
+
+		void SetMatrix(eMatrix aMtxType, const cMatrixf& a_mtxA);
+
+		void SetOrthoProjection(const cVector2f& avSize, float afMin, float afMax);
+		void SetOrthoProjection(const cVector3f& avMin, const cVector3f& avMax);
+
+		/////////////////////////////////////////////////////
+		/////////// TEXTURE OPERATIONS ///////////////////////
+		/////////////////////////////////////////////////////
+
+		void SetTexture(unsigned int alUnit,iTexture* apTex);
+		void SetActiveTextureUnit(unsigned int alUnit){}
+		void SetTextureEnv(eTextureParam aParam, int alVal);
+		void SetTextureConstantColor(const cColor &aColor);
+
+
+		/////////////////////////////////////////////////////
+		/////////// DRAWING ///////////////////////////////
+		/////////////////////////////////////////////////////
+
+		void DrawTriangle(tVertexVec& avVtx);
+
+		void DrawQuad(	const cVector3f &avPos,const cVector2f &avSize, const cColor& aColor=cColor(1,1));
+		void DrawQuad(	const cVector3f &avPos,const cVector2f &avSize,
+						const cVector2f &avMinTexCoord,const cVector2f &avMaxTexCoord,
+						const cColor& aColor=cColor(1,1));
+		void DrawQuad(	const cVector3f &avPos,const cVector2f &avSize,
+						const cVector2f &avMinTexCoord0,const cVector2f &avMaxTexCoord0,
+						const cVector2f &avMinTexCoord1,const cVector2f &avMaxTexCoord1,
+						const cColor& aColor=cColor(1,1));
+
+		void DrawQuad(const tVertexVec &avVtx);
+		void DrawQuad(const tVertexVec &avVtx, const cColor aCol);
+		void DrawQuad(const tVertexVec &avVtx,const float afZ);
+		void DrawQuad(const tVertexVec &avVtx,const float afZ,const cColor &aCol);
+		void DrawQuadMultiTex(const tVertexVec &avVtx,const tVector3fVec &avExtraUvs);
+
+		void DrawLine(const cVector3f& avBegin, const cVector3f& avEnd, cColor aCol);
+		void DrawLine(const cVector3f& avBegin, const cColor& aBeginCol, const cVector3f& avEnd, const cColor& aEndCol);
+
+		void DrawBoxMinMax(const cVector3f& avMin, const cVector3f& avMax, cColor aCol);
+		void DrawSphere(const cVector3f& avPos, float afRadius, cColor aCol);
+		void DrawSphere(const cVector3f& avPos, float afRadius, cColor aColX, cColor aColY, cColor aColZ);
+
+		void DrawLineQuad(const cRect2f& aRect, float afZ, cColor aCol);
+		void DrawLineQuad(const cVector3f &avPos,const cVector2f &avSize, cColor aCol);
+
+		/////////////////////////////////////////////////////
+		/////////// VERTEX BATCHING /////////////////////////
+		/////////////////////////////////////////////////////
+
+		void AddVertexToBatch(const cVertex *apVtx){ ++mlBatchVertexNum;}
+		void AddVertexToBatch(const cVertex *apVtx, const cVector3f* avTransform){ ++mlBatchVertexNum;}
+		void AddVertexToBatch(const cVertex *apVtx, const cMatrixf* aMtx){ ++mlBatchVertexNum;}
+
+		void AddVertexToBatch_Size2D(const cVertex *apVtx, const cVector3f* avTransform,
+										const cColor* apCol,const float& mfW, const float& mfH){ ++mlBatchVertexNum;}
+
+		void AddVertexToBatch_Raw(	const cVector3f& avPos, const cColor &aColor,
+									const cVector3f& avTex){ ++mlBatchVertexNum;}
+
+
+		void AddTexCoordToBatch(unsigned int alUnit,const cVector3f *apCoord){}
+		void SetBatchTextureUnitActive(unsigned int alUnit,bool abActive){}
+
+		void AddIndexToBatch(int alIndex){ ++mlBatchIndexNum;}
+
+		void FlushTriBatch(tVtxBatchFlag aTypeFlags, bool abAutoClear=true);
+		void FlushQuadBatch(tVtxBatchFlag aTypeFlags, bool abAutoClear=true);
+		void ClearBatch();
+
+		/////////////////////////////////////////////////////
+		/////////// RECORDING ///////////////////////////////
+		/////////////////////////////////////////////////////
+
+		/**
+		 * If false only the stats are updated, this is a bit faster when the stream is not needed.
+		 */
+		void SetRecordCommands(bool abX){ mbRecordCommands = abX;}
+		bool GetRecordCommands(){ return mbRecordCommands;}
+
+		/**
+		 * The sample count all occlusion queries return. The default makes everything visible, so every frame does the same work.
+		 */
+		void SetOcclusionQuerySampleCount(unsigned int alX){ mlOcclusionQuerySampleCount = alX;}
+		unsigned int GetOcclusionQuerySampleCount(){ return mlOcclusionQuerySampleCount;}
+
+		const tNullGfxCommandVec& GetLastFrameCommands(){ return mvLastFrameCommands;}
+		const tNullGfxPassStatsVec& GetLastFramePassStats(){ return mvLastFramePasses;}
+		const cNullGfxPassStats& GetLastFrameStats(){ return mLastFrameStats;}
+
+		/**
+		 * Sum of all frames since the last reset.
+		 */
+		const cNullGfxPassStats& GetTotalStats(){ return mTotalStats;}
+		int GetTotalFrameCount(){ return mlTotalFrameCount;}
+		void ResetTotalStats();
+
+		void LogLastFrameStats();
+
+		static const char* GetCommandName(eNullGfxCommand aType);
+
+		/**
+		 * Used by the resources, returns a new id. 0 is never used, so it can mean no resource.
+		 */
+		unsigned int GetNewResourceId(){ return ++mlResourceIdCount;}
+
+		/**
+		 * Records a command. If apLastUsedPass is set, it is the pass the resource was last bound in and is used to count unique resources.
+		 */
+		void AddCommand(eNullGfxCommand aType, int alTarget, unsigned int alValue, unsigned int *apLastUsedPass=NULL);
+
+	private:
+		void BeginPass(iFrameBuffer *apFrameBuffer);
+		void EndPass();
+
+		cVector2l mvScreenSize;
+		int mlMultisampling;
+		eGpuProgramFormat mGpuProgramFormat;
+		float mfGammaCorrection;
+
+		iFrameBuffer* mpFrameBuffer;
+		cPlanef mvClipPlanes[kMaxClipPlanes];
+
+		int mlBatchVertexNum;
+		int mlBatchIndexNum;
+
+		bool mbRecordCommands;
+		unsigned int mlOcclusionQuerySampleCount;
+		unsigned int mlResourceIdCount;
+
+		unsigned int mvLastStateValue[eNullGfxCommand_BindVertexBuffer+1][kNullGfxMaxCommandTargets];
+		bool mvLastStateIsSet[eNullGfxCommand_BindVertexBuffer+1][kNullGfxMaxCommandTargets];
+
+		unsigned int mlPassCount;
+		cNullGfxPassStats mCurrentPass;
+
+		tNullGfxCommandVec mvCommands;
+		tNullGfxPassStatsVec mvPasses;
+
+		tNullGfxCommandVec mvLastFrameCommands;
+		tNullGfxPassStatsVec mvLastFramePasses;
+		cNullGfxPassStats mLastFrameStats;
+
+		cNullGfxPassStats mTotalStats;
+		int mlTotalFrameCount;
+	};
+};
+#endif // HPL_LOWLEVELGRAPHICS_NULL_H
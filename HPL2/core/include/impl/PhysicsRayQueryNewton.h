@@ -0,0 +1,70 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef HPL_PHYSICS_RAY_QUERY_NEWTON_H
+#define HPL_PHYSICS_RAY_QUERY_NEWTON_H
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+#include <Newton.h>
+
+#include "physics/PhysicsTypes.h"
+#include "math/MathTypes.h"
+
+namespace hpl {
+
+	class iPhysicsWorld;
+
+	//------------------------------------------
+
+	class cPhysicsRayQueryBodyNewton
+	{
+	public:
+		const NewtonCollision *mpCollision;
+		cMatrixf m_mtxInvWorld;
+		cVector3f mvMin;
+		cVector3f mvMax;
+	};
+
+	typedef std::vector<cPhysicsRayQueryBodyNewton> tPhysicsRayQueryBodyNewtonVec;
+
+	//------------------------------------------
+
+	/**
+	 * Casts against the collisions of the bodies directly with NewtonCollisionRayCast. NewtonWorldRayCast sorts the
+	 * broadphase cells while casting and can not be used from several threads at once.
+	 */
+	class cPhysicsRayQueryNewton : public iPhysicsRayQuery
+	{
+	public:
+		cPhysicsRayQueryNewton(iPhysicsWorld *apWorld, iPhysicsRayCallback *apFilter);
+		~cPhysicsRayQueryNewton();
+
+		bool Intersects(const cVector3f &avOrigin, const cVector3f& avEnd);
+		int GetBodyNum(){ return (int)mvBodies.size();}
+
+	private:
+		tPhysicsRayQueryBodyNewtonVec mvBodies;
+	};
+
+	//------------------------------------------
+
+};
+#endif // HPL_PHYSICS_RAY_QUERY_NEWTON_H
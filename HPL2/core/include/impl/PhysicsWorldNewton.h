@@ -60,6 +60,7 @@ namespace hpl {
 
 		iCollideShape* CreateMeshShape(iVertexBuffer *apVtxBuffer);
 		iCollideShape* LoadMeshShapeFromBuffer(cBinaryBuffer *apBuffer);
+		iCollideShape* LoadMeshShapeFromMemory(const void *apData, size_t alSize);
 		void SaveMeshShapeToBuffer(iCollideShape* apMeshShape, cBinaryBuffer *apBuffer);
 
 		iCollideShape* CreateCompundShape(tCollideShapeVec &avShapes);
@@ -95,6 +96,8 @@ namespace hpl {
 							bool abCalcDist, bool abCalcNormal, bool abCalcPoint,
 							bool abUsePrefilter = false);
 
+		iPhysicsRayQuery* CreateRayQuery(iPhysicsRayCallback *apFilter);
+
 		bool CheckShapeCollision(	iCollideShape* apShapeA, const cMatrixf& a_mtxA,
 						iCollideShape* apShapeB, const cMatrixf& a_mtxB,
 						cCollideData & aCollideData, int alMaxPoints,
@@ -36,7 +36,10 @@ namespace hpl {
 	class cSDLEngineSetup : public iLowLevelEngineSetup
 	{
 	public:
-		cSDLEngineSetup(tFlag alHplSetupFlags);
+		/**
+		 * If abNullGraphics is true, no window is opened and a cLowLevelGraphicsNull is used.
+		 */
+		cSDLEngineSetup(tFlag alHplSetupFlags, bool abNullGraphics=false);
 		~cSDLEngineSetup();
 
 		cInput* CreateInput(cGraphics* apGraphics);
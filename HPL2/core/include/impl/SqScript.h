@@ -24,9 +24,27 @@
 #include "impl/LowLevelSystemSDL.h"
 #include <angelscript.h>
 
+class CScriptString;
+
 
 namespace hpl {
 
+	//------------------------------------------------------
+
+	class cSqScriptFunc
+	{
+	public:
+		int mlId;
+		int mlParamNum;
+		int mvParamTypeIds[kMaxScriptArgs];
+		asDWORD mvParamFlags[kMaxScriptArgs];
+	};
+
+	typedef std::map<tString, cSqScriptFunc> tSqScriptFuncMap;
+	typedef tSqScriptFuncMap::iterator tSqScriptFuncMapIt;
+
+	//------------------------------------------------------
+
 	class cSqScript : public iScript
 	{
 	public:
@@ -41,13 +59,25 @@ namespace hpl {
 		bool Run(const tString& asFuncLine);
 		bool Run(int alHandle);
 
+		bool RunCallback(const tString& asFunc, const cScriptArgs& aArgs);
+
 	private:
+		cSqScriptFunc* GetFunc(const tString& asFunc);
+		bool SetArgs(asIScriptContext *apContext, cSqScriptFunc *apFunc, const cScriptArgs& aArgs, CScriptString **apStrings);
+
+		asIScriptContext* PushContext();
+		void PopContext();
+
 		asIScriptEngine *mpScriptEngine;
 		cScriptOutput *mpScriptOutput;
 
-		asIScriptContext *mpContext;
+		std::vector<asIScriptContext*> mvContexts; //One per nested call, contexts are kept between calls.
+		int mlContextDepth;
 		asIScriptModule *mpModule;
 
+		tSqScriptFuncMap m_mapFuncs;
+		int mlStringTypeId;
+
 		int mlHandle;
 		tString msModuleName;
 
@@ -0,0 +1,85 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef HPL_TEXTURE_NULL_H
+#define HPL_TEXTURE_NULL_H
+
+#include "graphics/Texture.h"
+
+namespace hpl {
+
+	class cLowLevelGraphicsNull;
+
+	//-------------------------------------------------
+
+	/**
+	 * Texture that only keeps its size and format, no data is stored.
+	 */
+	class cTextureNull : public iTexture
+	{
+	public:
+		cTextureNull(const tString &asName, eTextureType aType, eTextureUsage aUsage, cLowLevelGraphicsNull* apLowLevelGraphics);
+		~cTextureNull();
+
+		bool CreateFromBitmap(cBitmap* pBmp);
+		bool CreateAnimFromBitmapVec(std::vector<cBitmap*> *avBitmaps);
+		bool CreateCubeFromBitmapVec(std::vector<cBitmap*> *avBitmaps);
+		bool CreateFromRawData(const cVector3l &avSize,ePixelFormat aPixelFormat, unsigned char *apData);
+
+		void SetRawData(	int alLevel, const cVector3l& avOffset, const cVector3l& avSize,
+							ePixelFormat aPixelFormat, void *apData){}
+
+		void Update(float afTimeStep);
+
+		void SetFilter(eTextureFilter aFilter){ mFilter = aFilter;}
+		void SetAnisotropyDegree(float afX){ mfAnisotropyDegree = afX;}
+
+		void SetWrapS(eTextureWrap aMode){ mWrapS = aMode;}
+		void SetWrapT(eTextureWrap aMode){ mWrapT = aMode;}
+		void SetWrapR(eTextureWrap aMode){ mWrapR = aMode;}
+		void SetWrapSTR(eTextureWrap aMode){ mWrapS = aMode; mWrapT = aMode; mWrapR = aMode;}
+
+		void SetCompareMode(eTextureCompareMode aMode){ mCompareMode = aMode;}
+		void SetCompareFunc(eTextureCompareFunc aFunc){ mCompareFunc = aFunc;}
+
+		void AutoGenerateMipmaps(){}
+
+		bool HasAnimation(){ return mlFrameNum > 1;}
+		void NextFrame();
+		void PrevFrame();
+		float GetT();
+		float GetTimeCount(){ return mfTimeCount;}
+		void SetTimeCount(float afX){ mfTimeCount = afX;}
+		int GetCurrentLowlevelHandle(){ return (int)mlId;}
+
+		unsigned int mlId;
+		unsigned int mlLastUsedPass;
+
+	private:
+		void SetSizeFromBitmap(cBitmap *apBmp);
+		void StepFrame(float afStep);
+
+		int mlFrameNum;
+		float mfTimeCount;
+		float mfTimeDir;
+	};
+
+	//-------------------------------------------------
+
+};
+#endif // HPL_TEXTURE_NULL_H
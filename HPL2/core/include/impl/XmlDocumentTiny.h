@@ -39,10 +39,10 @@ namespace hpl {
 		bool LoadDataFromFile(const tWString& asPath);
 		bool SaveDataToFile(const tWString& asPath);
 
-		void LoadFromTinyXMLData(TiXmlElement* apTinyElem, cXmlElement *apDestElem);
+		bool ParseData(char *apData);
+
 		void SaveToTinyXMLData(TiXmlElement* apTinyElem, cXmlElement *apSrcElem);
 
-		bool CreateTinyXMLFromFile(TiXmlDocument* pDoc,const tWString& asPath);
 		bool SaveTinyXMLToFile(TiXmlDocument* pDoc,const tWString& asPath);
 	};
 
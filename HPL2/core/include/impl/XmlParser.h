@@ -0,0 +1,69 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef HPL_XML_PARSER_H
+#define HPL_XML_PARSER_H
+
+#include "resources/XmlDocument.h"
+
+namespace hpl {
+
+	//-------------------------------------
+
+	/**
+	 * Parses XML text straight into the elements of a document. The text is changed in place and attribute values
+	 * point into it, so it must be allocated from the string pool of the document. Only elements and attributes are
+	 * kept, text, comments and declarations are skipped. Entities and encodings are handled the same way as TinyXML.
+	 */
+	class cXmlParser
+	{
+	public:
+		cXmlParser();
+
+		/**
+		 * apData must be null terminated. The first element is loaded into the document itself.
+		 */
+		bool Parse(iXmlDocument *apDoc, char *apData);
+
+		const tString& GetErrorDesc(){ return msErrorDesc;}
+		int GetErrorRow(){ return mlErrorRow;}
+		int GetErrorCol(){ return mlErrorCol;}
+
+	private:
+		char* ParseElement(char *apData, cXmlElement *apElement, bool *apIsEmpty);
+		char* ParseDeclaration(char *apData);
+		char* SkipTo(char *apData, const char *apEnd, const char *apErrorDesc);
+		char* DecodeText(char *apStart, char *apEnd);
+		char* DecodeEntity(char *apData, char **apDest);
+
+		char* SetError(const char *apDesc, const char *apPos);
+
+		char *mpDataStart;
+		bool mbUTF8;
+		bool mbEncodingKnown;
+
+		tString msErrorDesc;
+		int mlErrorRow;
+		int mlErrorCol;
+	};
+
+	//-------------------------------------
+
+};
+#endif // HPL_XML_PARSER_H
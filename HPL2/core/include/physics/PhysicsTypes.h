@@ -105,6 +105,24 @@ namespace hpl {
 
 	//----------------------------------------------------
 
+	/**
+	 * A snapshot of bodies that rays can be tested against from several threads at once. The bodies must not be
+	 * moved or destroyed while the query is alive.
+	 */
+	class iPhysicsRayQuery
+	{
+	public:
+		virtual ~iPhysicsRayQuery(){}
+
+		/**
+		 * Returns true if the ray hits any of the bodies. Thread safe.
+		 */
+		virtual bool Intersects(const cVector3f &avOrigin, const cVector3f& avEnd)=0;
+		virtual int GetBodyNum()=0;
+	};
+
+	//----------------------------------------------------
+
 	class cCollideData;
 
 	class iPhysicsWorldCollisionCallback
@@ -132,6 +132,11 @@ namespace hpl {
 		 * The buffer position must be pointing to where the data is saved!
 		 */
 		virtual iCollideShape* LoadMeshShapeFromBuffer(cBinaryBuffer *apBuffer)=0;
+		/**
+		 * Same as LoadMeshShapeFromBuffer but reads the data saved by SaveMeshShapeToBuffer directly from memory.
+		 * Returns NULL if the data is broken.
+		 */
+		virtual iCollideShape* LoadMeshShapeFromMemory(const void *apData, size_t alSize)=0;
 		/**
 		 * The shape must be a mesh shape!
 		 */
@@ -237,6 +242,12 @@ namespace hpl {
 							bool abCalcDist, bool abCalcNormal, bool abCalcPoint,
 							bool abUsePrefilter=false)=0;
 
+		/**
+		 * Creates a ray query with all bodies that apFilter->BeforeIntersect accepts right now. Unlike CastRay the query
+		 * can be used from worker threads. Destroy with hplDelete.
+		 */
+		virtual iPhysicsRayQuery* CreateRayQuery(iPhysicsRayCallback *apFilter)=0;
+
 		virtual void RenderShapeDebugGeometry(	iCollideShape *apShape, const cMatrixf& a_mtxTransform,
 												iLowLevelGraphics *apLowLevel, const cColor& aColor)=0;
 
@@ -35,6 +35,7 @@ namespace hpl {
 	class iBitmapLoader;
 	class cResources;
 	class cGraphics;
+	class iMutex;
 
 	//------------------------------------------------------------
 
@@ -44,6 +45,9 @@ namespace hpl {
 		cBitmapLoaderHandler(cResources* apResources, cGraphics* apGraphics);
 		~cBitmapLoaderHandler();
 
+		/**
+		 * Can be called from any thread, loads are done one at a time since the loaders are not thread safe.
+		 */
 		cBitmap* LoadBitmap(const tWString& asFile, tBitmapLoadFlag aFlags);
 		bool SaveBitmap(cBitmap* apBitmap, const tWString& asFile, tBitmapSaveFlag aFlags);
 
@@ -52,6 +56,8 @@ namespace hpl {
 
 		cResources* mpResources;
 		cGraphics* mpGraphics;
+
+		iMutex *mpLoadMutex;
 	};
 
 };
@@ -53,6 +53,8 @@ namespace hpl {
 		bool GetUseFastloadMaterial(){ return mbUseFastloadMaterial;}
 
 	private:
+		size_t GetMeshMemorySize(cMesh *apMesh);
+
 		cGraphics* mpGraphics;
 		cResources* mpResources;
 
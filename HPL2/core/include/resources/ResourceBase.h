@@ -26,6 +26,8 @@
 
 namespace hpl {
 
+	class iResourceManager;
+
 	class iResourceBase
 	{
 	public:
@@ -59,13 +61,19 @@ namespace hpl {
 
 		unsigned long GetTime(){return mlTime;}
 		unsigned long GetPrio(){return mlPrio;}
-		unsigned long GetSize(){return mlSize;}
+
+		/**
+		 * Number of bytes the resource holds (pixels, samples, vertices, etc). 0 if not known.
+		 * Set before the resource is added to a manager, the manager counts the size it had when added.
+		 */
+		size_t GetMemorySize(){return mlMemorySize;}
+		void SetMemorySize(size_t alSize){mlMemorySize = alSize;}
 
 		void SetLogDestruction(bool abX){ mbLogDestruction = abX;}
 
 		unsigned int GetUserCount(){return mlUserCount;}
 		void IncUserCount();
-		void DecUserCount(){if(mlUserCount>0)mlUserCount--;}
+		void DecUserCount();
 		bool HasUsers(){ return mlUserCount>0;}
 
 		static bool GetLogCreateAndDelete(){ return mbLogCreateAndDelete;}
@@ -78,14 +86,24 @@ namespace hpl {
 
 		unsigned int mlPrio; //dunno if this will be of any use.
 		unsigned long mlTime; //Time for creation.
-		unsigned long mlSize; //for completion. Not used yet.
+		size_t mlMemorySize;
 
 		unsigned int mlUserCount;
         unsigned long mlHandle;
 		bool mbLogDestruction;
 
 	private:
+		friend class iResourceManager;
+
 		tWString msFullPath;
+
+		//Set by the manager the resource is added to. Resources without users are kept in the
+		//unused list of the manager, least recently used first.
+		iResourceManager *mpResourceManager;
+		iResourceBase *mpPrevUnused;
+		iResourceBase *mpNextUnused;
+		size_t mlAccountedMemorySize;
+		unsigned int mlUnusedStamp;
 	};
 
 };
@@ -51,8 +51,39 @@ namespace hpl {
 
 		cResourceBaseIterator GetResourceBaseIterator();
 
+		/**
+		 * Destroys resources without users, least recently used first, until at most alMaxToKeep resources are left.
+		 */
 		void DestroyUnused(int alMaxToKeep);
 
+		/**
+		 * Destroys resources without users, least recently used first, until the memory usage is at most alMaxMemory.
+		 * \return Number of bytes freed.
+		 */
+		size_t DestroyUnusedMemory(size_t alMaxMemory);
+
+		/**
+		 * Destroys the least recently used resource without users. Returns false if there is none.
+		 */
+		bool DestroyOldestUnused();
+
+		/**
+		 * Max number of bytes to keep, 0 means no budget. Checked in EnforceMemoryBudget, which is called by cResources each update.
+		 */
+		void SetMemoryBudget(size_t alBytes){ mlMemoryBudget = alBytes;}
+		size_t GetMemoryBudget(){ return mlMemoryBudget;}
+		void EnforceMemoryBudget();
+
+		size_t GetMemoryUsage(){ return mlMemoryUsage;}
+		size_t GetUnusedMemoryUsage(){ return mlUnusedMemoryUsage;}
+		int GetResourceNum(){ return (int)m_mapResources.size();}
+		int GetUnusedResourceNum(){ return mlUnusedNum;}
+
+		/**
+		 * Used when comparing the unused resources of different managers. 0 if there are none.
+		 */
+		unsigned int GetOldestUnusedStamp();
+
 		virtual void Destroy(iResourceBase* apResource)=0;
 		virtual void DestroyAll();
 
@@ -81,10 +112,27 @@ namespace hpl {
 		iResourceBase* FindLoadedResource(const tString &asName, tWString &asFilePath, int *apEqualCount=NULL);
 		void AddResource(iResourceBase* apResource, bool abLog=true, bool abAddToSet=true);
 		void RemoveResource(iResourceBase* apResource);
+		bool IsInManager(iResourceBase* apResource);
 
 		tString GetTabs();
 		static int mlTabCount;
 
+	private:
+		friend class iResourceBase;
+
+		void AddToUnusedList(iResourceBase* apResource);
+		void RemoveFromUnusedList(iResourceBase* apResource);
+
+		iResourceBase *mpFirstUnused;
+		iResourceBase *mpLastUnused;
+		int mlUnusedNum;
+
+		size_t mlMemoryBudget;
+		size_t mlMemoryUsage;
+		size_t mlUnusedMemoryUsage;
+
+		static unsigned int mlUnusedStampCount;
+
 	};
 
 };
@@ -0,0 +1,185 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef HPL_RESOURCE_STREAMER_H
+#define HPL_RESOURCE_STREAMER_H
+
+#include "system/SystemTypes.h"
+#include "system/Thread.h"
+#include "graphics/GraphicsTypes.h"
+
+#include <list>
+#include <atomic>
+
+namespace hpl {
+
+	//----------------------------------------
+
+	class cResources;
+	class iResourceBase;
+	class iMutex;
+
+	//----------------------------------------
+
+	enum eResourceRequestState
+	{
+		eResourceRequestState_Pending,
+		eResourceRequestState_Done,
+		eResourceRequestState_Failed,
+
+		eResourceRequestState_LastEnum
+	};
+
+	//----------------------------------------
+
+	/**
+	 * Handle to a resource that is being loaded by the streamer. Is deleted by cResourceStreamer::ReleaseRequest or CancelRequest.
+	 */
+	class iResourceRequest
+	{
+	friend class cResourceStreamer;
+	public:
+		iResourceRequest(const tString& asName, const tWString& asPath);
+		virtual ~iResourceRequest(){}
+
+		const tString& GetName(){ return msName;}
+		const tWString& GetPath(){ return msPath;}
+
+		eResourceRequestState GetState(){ return mState;}
+		bool IsDone(){ return mState != eResourceRequestState_Pending;}
+
+		/**
+		 * The loaded resource, NULL while pending or if failed. It has a user count just like when it is created by the manager
+		 * (except sound data, which gets users when channels are created). That count is given to whoever releases the request.
+		 */
+		iResourceBase* GetResource(){ return mpResource;}
+
+	protected:
+		/**
+		 * Run on a worker thread. File reading and CPU decoding only, no graphics or sound API calls and no use of the managers.
+		 * Returns false if loading failed.
+		 */
+		virtual bool LoadData()=0;
+
+		/**
+		 * Run on the main thread once LoadData is done. Creates the resource using the data loaded, NULL if failed.
+		 */
+		virtual iResourceBase* CreateResource(cResources *apResources)=0;
+		virtual void DestroyResource(cResources *apResources, iResourceBase *apResource)=0;
+
+		/**
+		 * Reads the file to get it into the OS file cache, for resources that are created from file by the manager.
+		 */
+		static bool PrefetchFile(const tWString& asPath);
+
+		bool mbCreatesResource;
+
+	private:
+		void Load();
+
+		tString msName;
+		tWString msPath;
+
+		eResourceRequestState mState;
+		iResourceBase *mpResource;
+
+		std::atomic<bool> mbLoaded;
+		bool mbLoadFailed;
+	};
+
+	typedef std::list<iResourceRequest*> tResourceRequestList;
+	typedef tResourceRequestList::iterator tResourceRequestListIt;
+
+	//----------------------------------------
+
+	/**
+	 * Loads resources in the background. Requests are read and decoded in order on a loader thread of its own (so the job
+	 * workers are not blocked by the disk), and are then created on the main thread in Update, which stops once the upload
+	 * time budget for the frame is used up. Textures are decoded on the loader thread and only uploaded on the main thread.
+	 * Meshes, materials and sounds are read on the loader thread so the file is cached when the manager loads it on the main thread.
+	 */
+	class cResourceStreamer : public iThreadClass
+	{
+	public:
+		cResourceStreamer(cResources *apResources);
+		~cResourceStreamer();
+
+		iResourceRequest* RequestTexture(	const tString& asName, bool abUseMipMaps, eTextureType aType= eTextureType_2D,
+											eTextureUsage aUsage=eTextureUsage_Normal, unsigned int alTextureSizeLevel=0);
+		iResourceRequest* RequestMesh(const tString& asName);
+		iResourceRequest* RequestMaterial(const tString& asName);
+		iResourceRequest* RequestSoundData(const tString& asName);
+
+		/**
+		 * Only reads the file, the request has no resource. Used to overlap file reading with other loading.
+		 */
+		iResourceRequest* RequestPrefetch(const tWString& asPath);
+
+		/**
+		 * Deletes the request and returns the resource, the caller then owns its user count. A pending request is cancelled and NULL is returned.
+		 */
+		iResourceBase* ReleaseRequest(iResourceRequest *apRequest);
+		/**
+		 * Deletes the request and destroys the resource, if it has been created.
+		 */
+		void CancelRequest(iResourceRequest *apRequest);
+
+		/**
+		 * Finishes the request right away, ignoring the time budget.
+		 */
+		void WaitForRequest(iResourceRequest *apRequest);
+		void WaitForAll();
+
+		/**
+		 * Creates resources of requests that are done loading, called by cResources each update.
+		 */
+		void Update();
+
+		/**
+		 * Time in ms spent creating resources each update. At least one resource is created each update.
+		 */
+		void SetUploadTimeBudget(unsigned long alMs){ mlUploadTimeBudget = alMs;}
+		unsigned long GetUploadTimeBudget(){ return mlUploadTimeBudget;}
+
+		int GetPendingNum(){ return (int)mlstRequests.size();}
+
+		void UpdateThread();
+
+	private:
+		iResourceRequest* AddRequest(iResourceRequest *apRequest);
+		bool RemoveFromLoadQueue(iResourceRequest *apRequest);
+		void FinishRequest(iResourceRequest *apRequest);
+		void DestroyReleasedRequests();
+
+		cResources *mpResources;
+
+		iThread *mpThread;
+		iMutex *mpLoadQueueMutex;
+		tResourceRequestList mlstLoadQueue;
+
+		tResourceRequestList mlstRequests;
+		tResourceRequestList mlstReleasedRequests;
+
+		unsigned long mlUploadTimeBudget;
+	};
+
+	//----------------------------------------
+
+};
+#endif // HPL_RESOURCE_STREAMER_H
@@ -53,6 +53,7 @@ namespace hpl {
 	class cEntFileManager;
 	class cMeshManager;
 	class cVideoManager;
+	class cResourceStreamer;
 	class cConfigFile;
 	class cArea2D;
 	class cSound;
@@ -227,8 +228,23 @@ namespace hpl {
 		cVideoManager* GetVideoManager(){ return mpVideoManager;}
 		cEntFileManager* GetEntFileManager(){ return mpEntFileManager; }
 
+		cResourceStreamer* GetResourceStreamer(){ return mpResourceStreamer; }
+
 		iLowLevelSystem* GetLowLevelSystem(){ return mpLowLevelSystem;}
 
+		/**
+		 * Max number of bytes for all managers that keep unused resources around (textures, sounds, sound entities and particles).
+		 * When exceeded, the least recently used of those are destroyed in Update. 0 means no budget. Each manager
+		 * can also have its own budget, see iResourceManager::SetMemoryBudget.
+		 */
+		void SetMemoryBudget(size_t alBytes){ mlMemoryBudget = alBytes;}
+		size_t GetMemoryBudget(){ return mlMemoryBudget;}
+
+		/**
+		 * Summed memory usage of all managers.
+		 */
+		size_t GetMemoryUsage();
+
 		static void SetForceCacheLoadingAndSkipSaving(bool abX){ mbForceCacheLoadingAndSkipSaving = abX;}
 		static bool GetForceCacheLoadingAndSkipSaving(){ return mbForceCacheLoadingAndSkipSaving ;}
 
@@ -242,6 +258,8 @@ namespace hpl {
 		cFileSearcher *mpFileSearcher;
 
         tResourceManagerList mlstManagers;
+		tResourceManagerList mlstCachingManagers;
+		size_t mlMemoryBudget;
 		cImageManager *mpImageManager;
 		cGpuShaderManager *mpGpuShaderManager;
 		cParticleManager* mpParticleManager;
@@ -255,6 +273,8 @@ namespace hpl {
 		cVideoManager *mpVideoManager;
 		cEntFileManager *mpEntFileManager;
 
+		cResourceStreamer *mpResourceStreamer;
+
 		cLanguageFile *mpLanguageFile;
 
 		cMeshManager* mpMeshManager;
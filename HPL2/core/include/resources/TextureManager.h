@@ -29,6 +29,7 @@ namespace hpl {
 	class cResources;
 	class iTexture;
 	class cBitmapLoaderHandler;
+	class cBitmap;
 
 	//------------------------------------------------------
 
@@ -64,26 +65,40 @@ namespace hpl {
 								unsigned int alTextureSizeLevel=0);
 
 
+		/**
+		 * Creates a texture from a bitmap loaded elsewhere (eg by the resource streamer), or gets the texture if asPath
+		 * already is loaded. The bitmap is not deleted. Increases the user count like the other create methods.
+		 */
+		iTexture* CreateFromBitmap(	const tString& asName, const tWString& asPath, cBitmap *apBitmap,
+									bool abUseMipMaps, eTextureType aType, eTextureUsage aUsage=eTextureUsage_Normal,
+									unsigned int alTextureSizeLevel=0);
+
+		/**
+		 * Checks if a texture is loaded, trying all supported formats if asName has no extension.
+		 * \param &asFilePath The path of the file if the texture is not loaded, else "".
+		 * \return The texture if loaded, else NULL.
+		 */
+		iTexture* FindTexture2D(const tString &asName, tWString &asFilePath);
+
 		void Destroy(iResourceBase* apResource);
+		void DestroyAll();
 		void Unload(iResourceBase* apResource);
 
 		void Update(float afTimeStep);
 
-		int GetMemoryUsage(){ return mlMemoryUsage;}
-
 	private:
 		iTexture* CreateSimpleTexture(const tString& asName,bool abUseMipMaps,
 									eTextureUsage aUsage, eTextureType aType,
 									unsigned int alTextureSizeLevel);
 
-		iTexture* FindTexture2D(const tString &asName, tWString &asFilePath);
+		iTexture* CreateTextureFromBitmap(	const tString& asName, const tWString& asPath, cBitmap *apBitmap,
+											bool abUseMipMaps, eTextureType aType, eTextureUsage aUsage,
+											unsigned int alTextureSizeLevel);
 
 		tTextureAttenuationMap m_mapAttenuationTextures;
 
 		tStringVec mvCubeSideSuffixes;
 
-		int mlMemoryUsage;
-
 		cGraphics* mpGraphics;
 		cResources* mpResources;
 		cBitmapLoaderHandler *mpBitmapLoaderHandler;
@@ -37,6 +37,8 @@ namespace hpl {
 	class iPhysicsMaterial;
 	class cResourceVarsObject;
 	class iPhysicsBody;
+	class iVertexBuffer;
+	class iResourceRequest;
 
 	//----------------------------------------
 
@@ -48,7 +50,7 @@ namespace hpl {
 	#define MAP_CACHE_FORMAT_MAGIC_NUMBER		0xF441451F
 #endif
 
-	#define MAP_CACHE_FORMAT_VERSION			219676930
+	#define MAP_CACHE_FORMAT_VERSION			219676931
 
 	//----------------------------------------
 
@@ -79,6 +81,30 @@ namespace hpl {
 
 	//----------------------------------------
 
+	/**
+	 * A sequence of static sub meshes that are combined into a single mesh or physics body. The destination
+	 * vertex buffer is set up on the main thread, filled by the combine workers and then used to create the
+	 * mesh entity or body on the main thread again, in the order the batches were added.
+	 */
+	class cHplMapCombineBatch
+	{
+	public:
+		bool mbBody;
+
+		std::vector<iVertexBuffer*> mvSrcBuffers;
+		std::vector<cMatrixf> mvSrcMatrices;
+		iVertexBuffer *mpVtxBuffer;
+
+		cSubMeshEntity *mpFirstObject;
+		iPhysicsMaterial *mpPhysicsMaterial;
+		bool mbCharCollider;
+	};
+
+	typedef std::vector<cHplMapCombineBatch*> tHplMapCombineBatchVec;
+	typedef tHplMapCombineBatchVec::iterator tHplMapCombineBatchVecIt;
+
+	//----------------------------------------
+
 	class cHplMapShape
 	{
 	public:
@@ -126,6 +152,8 @@ namespace hpl {
 		void SaveCacheFile(const tWString& asFile);
 
 		void LoadFileIndicies(cXmlElement* apXmlContents);
+		void PrefetchFiles(const tStringVec& avFiles);
+		void CancelPrefetches();
 
 		void LoadStaticObjects(cXmlElement* apXmlContents);
 		void BuildCombinedStaticMeshes(cRenderableContainer_BoxTree *apContainer);
@@ -138,10 +166,14 @@ namespace hpl {
 		void CreateStaticObjectCombo(cXmlElement* apElement, tMeshEntityList& alstMeshEntities,
 									cRenderableContainer_BoxTree *apDecalContainer);
 
-		void IterateLeafNodesAndBuildMeshes(iRenderableContainerNode *apNode);
+		void IterateLeafNodesAndAddBatches(iRenderableContainerNode *apNode, tHplMapCombineBatchVec &avBatches);
 		void CombineAndCreateMeshesAndPhysics(tRenderableList *apObjectList);
-		void CombineObjectsAndCreateMeshEntity(tRenderableVec &avObjects, int alFirstIdx, int alLastIdx);
-		void CombineObjectsAndCreatePhysics(std::vector<cHplMapPhysicsObject> &avObjects, int alFirstIdx, int alLastIdx);
+		void AddCombineBatches(tRenderableList *apObjectList, tHplMapCombineBatchVec &avBatches);
+		void AddMeshCombineBatch(tRenderableVec &avObjects, int alFirstIdx, int alLastIdx, tHplMapCombineBatchVec &avBatches);
+		void AddPhysicsCombineBatch(std::vector<cHplMapPhysicsObject> &avObjects, int alFirstIdx, int alLastIdx, tHplMapCombineBatchVec &avBatches);
+		void BuildCombineBatches(tHplMapCombineBatchVec &avBatches);
+		void CreateMeshEntityFromBatch(cHplMapCombineBatch *apBatch);
+		void CreatePhysicsFromBatch(cHplMapCombineBatch *apBatch);
 
 		void LoadEntities(cXmlElement* apXmlContents);
 		void CreateLoadedEntity(cXmlElement* apElement, tEFL_LightBillboardConnectionList *apLightBillboardList);
@@ -163,8 +195,8 @@ namespace hpl {
 		tStringVec mvFileIndices_Decals;
 
 		int mlSortingTimeTotal;
-		int mlCombineMeshTimeTotal;
-		int mlCombineBodyTimeTotal;
+		int mlCombineFillTimeTotal;
+		int mlCombineCreateTimeTotal;
 
 		cWorld* mpCurrentWorld;
 		iPhysicsWorld *mpCurrentPhysicsWorld;
@@ -176,14 +208,11 @@ namespace hpl {
 		int mlStaticMeshBodiesCreated;
 		int mlStaticMeshEntitiesCreated;
 
-		float *mpShortNegPosFloatTable;
-		float *mpByteNegPosFloatTable;
-		float *mpBytePosFloatTable;
-
 		tWString msCacheFileExt;
 
 		tWorldLoadFlag mlCurrentFlags;
 		tHplMapStaticUserDataList mlstTempStaticUserData;
+		std::vector<iResourceRequest*> mvPrefetchRequests; //Canceled at the end of each load.
 	};
 
 };
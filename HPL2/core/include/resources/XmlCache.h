@@ -0,0 +1,58 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef HPL_XML_CACHE_H
+#define HPL_XML_CACHE_H
+
+#include "system/SystemTypes.h"
+
+namespace hpl {
+
+	//----------------------------------------
+
+	#define XML_CACHE_FORMAT_MAGIC_NUMBER		0x434D5848
+	#define XML_CACHE_FORMAT_VERSION			1
+
+	//----------------------------------------
+
+	class iXmlDocument;
+
+	//----------------------------------------
+
+	/**
+	 * Pre-parsed XML documents, saved next to the source file with "_cache" added to the extension (eg "chair.ent_cache").
+	 * A cache is used if the size and modified date of the source are the same as when it was saved, or if the contents
+	 * still have the same hash. The cache is read into the string pool of the document and used in place.
+	 */
+	class cXmlCache
+	{
+	public:
+		static tWString GetCacheFile(const tWString& asFile);
+
+		/**
+		 * Returns false if there is no valid and up to date cache.
+		 */
+		static bool Load(iXmlDocument *apDoc, const tWString& asFile);
+		static bool Save(iXmlDocument *apDoc, const tWString& asFile);
+	};
+
+	//----------------------------------------
+
+};
+#endif // HPL_XML_CACHE_H
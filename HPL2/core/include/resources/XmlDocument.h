@@ -24,6 +24,8 @@
 #include "graphics/GraphicsTypes.h"
 #include "math/MathTypes.h"
 
+#include <string.h>
+
 namespace hpl {
 
 	//-------------------------------------
@@ -39,6 +41,47 @@ namespace hpl {
 
 	class iXmlNode;
 	class cXmlElement;
+	class cXmlParser;
+
+	//-------------------------------------
+
+	/**
+	 * Owns the strings of a document. Strings are allocated from large blocks that are only freed when the pool is cleared,
+	 * names are interned so that each name is only stored once and can be compared by pointer.
+	 */
+	class cXmlStringPool
+	{
+	public:
+		cXmlStringPool();
+		~cXmlStringPool();
+
+		/**
+		 * Allocates memory that stays valid until the pool is cleared. alAlignment must be a power of two.
+		 */
+		char* Allocate(size_t alSize, size_t alAlignment=1);
+
+		const char* AddString(const char *apString, size_t alLength);
+		const char* AddString(const char *apString){ return AddString(apString, strlen(apString));}
+
+		/**
+		 * Returns the stored copy of the name, the same pointer is returned for all equal names.
+		 */
+		const char* AddName(const char *apName, size_t alLength);
+		const char* AddName(const char *apName){ return AddName(apName, strlen(apName));}
+
+		void Clear();
+
+	private:
+		void GrowNameTable();
+
+		std::vector<char*> mvBlocks;
+		char *mpBlockData;
+		size_t mlBlockPos;
+		size_t mlBlockSize;
+
+		std::vector<const char*> mvNameTable;
+		size_t mlNameNum;
+	};
 
 	typedef std::list<iXmlNode*> tXmlNodeList;
 	typedef tXmlNodeList::iterator tXmlNodeListIt;
@@ -83,11 +126,23 @@ namespace hpl {
 
 	//-------------------------------------
 
-	typedef std::map<tString, tString> tAttributeMap;
-	typedef tAttributeMap::iterator tAttributeMapIt;
+	class cXmlAttribute
+	{
+	public:
+		cXmlAttribute() : mpName(NULL), mpValue(NULL), mlValueSize(0) {}
+
+		const char *mpName;	//Interned in the string pool
+		const char *mpValue;
+		size_t mlValueSize;	//Bytes allocated for the value by SetAttribute, 0 if the value is loaded and might be shared
+	};
+
+	typedef std::vector<cXmlAttribute> tXmlAttributeVec;
+	typedef tXmlAttributeVec::iterator tXmlAttributeVecIt;
 
 	class cXmlElement : public iXmlNode
 	{
+	friend class cXmlParser;
+	friend class cXmlCache;
 	public:
 		cXmlElement(const tString& asName, iXmlNode* apParent);
 		virtual ~cXmlElement();
@@ -112,17 +167,31 @@ namespace hpl {
 		void SetAttributeVector3f(const tString& asName, const cVector3f& avVal);
 		void SetAttributeColor(const tString& asName, const cColor& aVal);
 
+		void DestroyAttributes();
+
+		/**
+		 * Attributes in the order they were added. The strings are owned by the string pool.
+		 */
+		tXmlAttributeVec* GetAttributes(){ return &mvAttributes;}
 
-		tAttributeMap* GetAttributeMap(){ return &m_mapAttributes;}
+		/**
+		 * The pool the strings of the element are stored in, shared by all elements of a document.
+		 */
+		cXmlStringPool* GetStringPool();
+
+	protected:
+		cXmlStringPool *mpStringPool;
+		bool mbOwnsStringPool;
 
 	private:
-		tAttributeMap m_mapAttributes;
+		tXmlAttributeVec mvAttributes;
 	};
 
 	//-------------------------------------
 
 	class iXmlDocument : public cXmlElement
 	{
+	friend class cXmlCache;
 	public:
 		iXmlDocument(const tString& asName);
 		virtual ~iXmlDocument();
@@ -130,7 +199,10 @@ namespace hpl {
 		void SetPath(const tWString& asPath) { msFile = asPath; }
 		const tWString& GetPath() { return msFile; }
 
-		bool CreateFromFile(const tWString& asPath);
+		/**
+		 * If abUseCache is true, a binary cache next to the file is loaded instead if it is up to date, else it is created.
+		 */
+		bool CreateFromFile(const tWString& asPath, bool abUseCache=false);
 		bool Save();
 		bool SaveToFile(const tWString& asPath);
 
@@ -144,6 +216,11 @@ namespace hpl {
 	protected:
 		void SaveErrorInfo(const tString& asDesc, int alRow, int alCol) { msErrorDesc = asDesc; mlErrorRow = alRow; mlErrorCol = alCol; }
 
+		/**
+		 * Removes all children and attributes and frees the string pool.
+		 */
+		void ClearData();
+
 	private:
 		virtual bool LoadDataFromFile(const tWString& asPath)=0;
 		virtual bool SaveDataToFile(const tWString& asPath)=0;
@@ -118,6 +118,17 @@ namespace hpl {
 		float GetFadeStep(){ return mfFadeStep;}
 		void SetFadeStep(float afX){ mfFadeStep = afX;}
 
+		/**
+		 * Index of the bone or node state each track is applied to, set when the state is added to an entity. -1 = none.
+		 */
+		void SetTrackNodeIndex(int alTrack, int alIndex){ mvTrackNodeIndices[alTrack] = alIndex;}
+		int GetTrackNodeIndex(int alTrack){ return mvTrackNodeIndices[alTrack];}
+
+		/**
+		 * Key frame cursor for each track, passed to cAnimationTrack::ApplyToNode.
+		 */
+		int* GetTrackKeyFrameCursor(int alTrack){ return &mvTrackKeyFrameCursors[alTrack];}
+
 	private:
 		tString msName;
 
@@ -127,6 +138,9 @@ namespace hpl {
 
 		std::vector<cAnimationEvent*> mvEvents;
 
+		tIntVec mvTrackNodeIndices;
+		tIntVec mvTrackKeyFrameCursors;
+
 		//Properties of the animation
 		float mfLength;
 		float mfWeight;
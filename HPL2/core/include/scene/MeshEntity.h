@@ -207,6 +207,11 @@ namespace hpl {
 
 		void CreateNodes();
 
+		void BindAnimationState(cAnimationState *apAnimState);
+
+		void SetupBonePose();
+		void UpdateBonePose(float afTimeStep);
+
 		void UpdateNodeMatrixRec(cNode3D *apNode);
 
 		void HandleAnimationEvent(cAnimationEvent *apEvent);
@@ -230,6 +235,7 @@ namespace hpl {
 		tRenderableFlag mlRenderFlags;
 
 		bool mbBoneMatricesNeedUpdate;
+		bool mbBoneMatricesFromPose;
 		int mlBoneMatricesTransformCount;
 
 		cMatrixf m_mtxInvWorldMatrix;
@@ -251,6 +257,14 @@ namespace hpl {
 
 		std::vector<cMatrixf> mvBoneMatrices;
 
+		//Flat bone pose, used when only animations move the skeleton
+		tIntVec mvBonePoseOrder;			//Bone indices with parents before children
+		tIntVec mvBoneParentIndices;		//-1 = attached to the root
+		std::vector<cQuaternion> mvBonePoseRotations;
+		std::vector<cVector3f> mvBonePoseTranslations;
+		std::vector<cMatrixf> mvBonePoseMatrices;	//Model space
+		std::vector<float> mvBoneColumns; //Bone matrices laid out for cSkinning
+
 		bool mbSkeletonPhysics;
 		bool mbSkeletonPhysicsFading;
 		float mfSkeletonPhysicsFadeSpeed;
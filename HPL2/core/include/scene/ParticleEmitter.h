@@ -101,36 +101,20 @@ namespace hpl {
 
 	//-------------------------------------------------------------------
 
+	/**
+	 * Per particle data that is not touched every frame. The data that is (position, velocity, color, etc) is
+	 * kept in the streams of cParticlePool.
+	 */
 	class cParticle
 	{
 	public:
 		cParticle(){}
 
-		cVector3f mvPos;
-		cVector3f mvLastPos;
 		cVector3f mvLastCollidePos;
-		cVector3f mvAcc;
-		cVector3f mvVel;
 
 		float mfSpeedMul;
 		float mfMaxSpeed;
 
-		cColor mStartColor;
-		cColor mColor;
-
-		cVector2f mvStartSize;
-		cVector2f mvSize;
-
-		float mfStartLife;
-		float mfLife;
-		float mfLifeSize_MiddleStart;
-		float mfLifeSize_MiddleEnd;
-
-		float mfLifeColor_MiddleStart;
-		float mfLifeColor_MiddleEnd;
-
-		int mlSubDivNum;
-
 		float mfBounceAmount;
 		int mlBounceCount;
 
@@ -138,7 +122,6 @@ namespace hpl {
 
 		// NEW
 
-		float mfSpin;
 		float mfSpinVel;
 		float mfSpinFactor;
 
@@ -157,11 +140,65 @@ namespace hpl {
 
 	//-------------------------------------------------------------------
 
-	typedef std::vector<cParticle*> tParticleVec;
+	typedef std::vector<cParticle> tParticleVec;
 	typedef tParticleVec::iterator tParticleVecIt;
 
 	//-------------------------------------------------------------------
 
+	/**
+	 * Particles stored as one contiguous array per attribute. Particle i is at index i in all of the streams
+	 * and the live particles are always [0, num). The kernels work on whole streams at a time.
+	 */
+	class cParticlePool
+	{
+	public:
+		void Setup(int alMaxParticles);
+
+		int GetMaxSize(){ return (int)mvPos.size();}
+
+		/**
+		 * Copies particle alSrc to alDest. The cold data is swapped so that the beam point memory is kept.
+		 */
+		void MoveParticle(int alDest, int alSrc);
+
+		/**
+		 * Does LastPos = Pos, Pos += Vel*T, Vel += Acc*T + VelAdd and Life -= T for particles [0, alNum).
+		 */
+		void Integrate(int alNum, float afTimeStep, const cVector3f& avVelAdd);
+
+		/**
+		 * Writes the transformed positions of particles [0, alNum) to mvDrawPos as x,y,z,1.
+		 * \param apMtx matrix to transform with, NULL means no transform.
+		 * \param abLastPos if true mvLastPos is transformed into mvDrawLastPos instead.
+		 */
+		void TransformPositions(int alNum, const cMatrixf* apMtx, bool abLastPos=false);
+
+		std::vector<cVector3f> mvPos;
+		std::vector<cVector3f> mvLastPos;
+		std::vector<cVector3f> mvVel;
+		std::vector<cVector3f> mvAcc;
+
+		std::vector<cColor> mvColor;
+		std::vector<cColor> mvStartColor;
+
+		std::vector<cVector2f> mvSize;
+		std::vector<cVector2f> mvStartSize;
+
+		std::vector<float> mvLife;
+		std::vector<float> mvStartLife;
+
+		std::vector<float> mvSpin;
+		std::vector<int> mvSubDivNum;
+
+		tParticleVec mvData;
+
+		//Scratch streams used when filling the vertex buffer, 4 floats per particle.
+		std::vector<float> mvDrawPos;
+		std::vector<float> mvDrawLastPos;
+	};
+
+	//-------------------------------------------------------------------
+
 	//////////////////////////////////////////////////////
 	/////////////// PARTICLE SYSTEM //////////////////////
 	//////////////////////////////////////////////////////
@@ -212,10 +249,10 @@ namespace hpl {
 
 	protected:
 		void SwapRemove(unsigned int alIndex);
-		cParticle* CreateParticle();
+		int CreateParticle();
 
 		virtual void UpdateMotion(float afTimeStep)=0;
-		virtual void SetParticleDefaults(cParticle *apParticle)=0;
+		virtual void SetParticleDefaults(int alIdx)=0;
 
 		cGraphics *mpGraphics;
 		cResources *mpResources;
@@ -223,7 +260,7 @@ namespace hpl {
 		tString msDataName;
 		cVector3f mvDataSize;
 
-		tParticleVec mvParticles;
+		cParticlePool mParticles;
 		unsigned int mlNumOfParticles;
 		unsigned int mlMaxParticles;
 
@@ -265,7 +265,7 @@ namespace hpl {
 
 	private:
 		void UpdateMotion(float afTimeStep);
-		void SetParticleDefaults(cParticle *apParticle);
+		void SetParticleDefaults(int alIdx);
 
 
 		cParticleEmitterData_UserData *mpData;
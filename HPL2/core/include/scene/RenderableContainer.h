@@ -56,6 +56,34 @@ namespace hpl {
 
 	//-------------------------------------------
 
+	/**
+	 * A run of objects that share the frustum collision of the node they are stored in.
+	 */
+	class cRenderableContainerObjectRange
+	{
+	public:
+		iRenderable **mpObjects;
+		int mlObjectNum;
+		eCollision mFrustumCollision;
+	};
+
+	typedef std::vector<cRenderableContainerObjectRange> tRenderableContainerObjectRangeVec;
+
+	//-------------------------------------------
+
+	/**
+	 * Extra test for nodes that touch the frustum. Nodes it returns false for are skipped together with everything below them.
+	 */
+	class iRenderableContainerNodeFilter
+	{
+	public:
+		virtual ~iRenderableContainerNodeFilter(){}
+
+		virtual bool IsNodeVisible(const cVector3f &avMin, const cVector3f &avMax)=0;
+	};
+
+	//-------------------------------------------
+
 	class cRenderableContainerObjectCallback : public iRenderableCallback
 	{
 	public:
@@ -164,6 +192,14 @@ namespace hpl {
 
 		virtual void RenderDebug(cRendererCallbackFunctions *apFunctions)=0;
 
+		/**
+		 * Fills avRanges with the objects in nodes that touch the frustum, are not outside any of the cull planes and
+		 * pass the filter (if any). Returns false if the container has no flat representation, then the nodes must be walked from GetRoot().
+		 */
+		virtual bool GetFrustumObjectRanges(cFrustum *apFrustum, const cPlanef *apCullPlanes, int alCullPlaneNum,
+											tRenderableContainerObjectRangeVec &avRanges,
+											iRenderableContainerNodeFilter *apNodeFilter=NULL){ return false; }
+
 	private:
 		void CheckNeedPropertyUpdateIteration(iRenderableContainerNode* apNode);
 		void CheckNeedAABBUpdateIteration(iRenderableContainerNode* apNode);
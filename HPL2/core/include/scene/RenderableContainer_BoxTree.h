@@ -46,6 +46,27 @@ namespace hpl {
 
 	//-------------------------------------------
 
+	/**
+	 * Up to four sibling nodes with their AABBs laid out per axis, so all of them can be tested against a plane at once.
+	 */
+	class cBoxTreeFlatPacket
+	{
+	public:
+		float mvMinX[4], mvMinY[4], mvMinZ[4];
+		float mvMaxX[4], mvMaxY[4], mvMaxZ[4];
+
+		int mvChildPacket[4];	//-1 if node has no children
+		int mvObjectStart[4];
+		int mvObjectNum[4];
+
+		int mlNodeNum;
+		int mlNextPacket;		//Packet with the rest of the siblings, -1 if none.
+	};
+
+	typedef std::vector<cBoxTreeFlatPacket> tBoxTreeFlatPacketVec;
+
+	//-------------------------------------------
+
 	class cRCNode_BoxTree : public iRenderableContainerNode
 	{
 	friend class cRenderableContainer_BoxTree;
@@ -75,6 +96,10 @@ namespace hpl {
 
 		void RenderDebug(cRendererCallbackFunctions *apFunctions);
 
+		bool GetFrustumObjectRanges(cFrustum *apFrustum, const cPlanef *apCullPlanes, int alCullPlaneNum,
+									tRenderableContainerObjectRangeVec &avRanges,
+									iRenderableContainerNodeFilter *apNodeFilter=NULL);
+
 		void SetMinLeafObjects(int alX){mlMinLeafObjects = alX;}
 		int GetMinLeafObjects(){ return mlMinLeafObjects;}
 
@@ -97,6 +122,7 @@ namespace hpl {
 	private:
 		void CompileTempNode(cBoxTreeTempNode *apNode, int alLevel, int alSplitAxis);
 		void BuildNodeFromTemp(cBoxTreeTempNode *apTempNode, cRCNode_BoxTree *apNode, int alLevel);
+		int BuildFlatPacket(tRenderableContainerNodeList *apNodeList);
 
 		void RenderDebugNode(cRendererCallbackFunctions *apFunctions, cRCNode_BoxTree *apNode, int alLevel);
 
@@ -119,6 +145,9 @@ namespace hpl {
 
 		tRenderableList m_mlstTempObjects;
 
+		tBoxTreeFlatPacketVec mvFlatPackets;
+		tRenderableVec mvFlatObjects;
+
 		cRenderableContainerObjectCallback *mpObjectCalllback;
 	};
 
@@ -48,6 +48,10 @@ namespace hpl {
 
 	//-------------------------------------------
 
+	/**
+	 * Node in a dynamic AABB tree. Leaves hold exactly one object and internal nodes exactly two children.
+	 * Nodes are allocated from a pool in the container and never delete their children.
+	 */
 	class cRCNode_DynBoxTree : public iRenderableContainerNode
 	{
 	friend class cRenderableContainer_DynBoxTree;
@@ -56,36 +60,38 @@ namespace hpl {
 		cRCNode_DynBoxTree();
 		~cRCNode_DynBoxTree();
 
-		void UpdateBeforeUse();
+		inline bool IsLeaf() const { return mpObject != NULL;}
 
-		void RemoveObject(iRenderable *apObject);
+		inline const cVector3f& GetFatMin() const{ return mvFatMin;}
+		inline const cVector3f& GetFatMax() const{ return mvFatMax;}
 
-		void RecalculateSplit();
-		void RecalculateAABB();
-
-		void ObjectMoved();
+		inline int GetHeight() const { return mlHeight;}
 
 	private:
-		cRenderableContainer_DynBoxTree *mpContainer;
-
-		int mlSplitAxis;
-		float mfSplitPlane;
+		void SetChild(int alIdx, cRCNode_DynBoxTree *apChild);
+		void UpdateFromChildren();
 
-		bool mbRecalculateSplit;
-		bool mbRecalculateSplitAxis;
-		bool mbRecalculateAABB;
-        bool mbObjectMoved;
+		cRenderableContainer_DynBoxTree *mpContainer;
 
-		bool mbIsSplit;
+		cRCNode_DynBoxTree *mpChild[2];
+		iRenderable *mpObject;
 
-		int mlIgnoreSplitCount;
-		int mlGarbageCollectCount;
+		cVector3f mvFatMin;
+		cVector3f mvFatMax;
 
-		cVector3f mvMeanPosition;
+		int mlHeight;
 	};
 
+	typedef std::vector<cRCNode_DynBoxTree*> tRCNode_DynBoxTreeVec;
+
 	//-------------------------------------------
 
+	/**
+	 * Objects are kept in leaves with an enlarged ("fat") AABB. A moved object only changes the tree when it leaves its fat AABB,
+	 * it is then removed and inserted again using the surface area heuristic. Nodes on the changed path are rotated
+	 * if that lowers the surface area, and always if the children differ more than one in height, so the tree stays
+	 * good and balanced without any full rebuilds.
+	 */
 	class cRenderableContainer_DynBoxTree : public iRenderableContainer
 	{
 	friend class cRCNode_DynBoxTree;
@@ -101,45 +107,55 @@ namespace hpl {
 
         void Compile();
 
+		/**
+		 * Inserts all objects again with new fat AABBs. Only needed for debugging, the tree is kept in shape as objects move.
+		 */
 		void RebuildNodes();
 
 		void RenderDebug(cRendererCallbackFunctions *apFunctions);
 
+		int GetNodeNum(){ return mlNodeNum;}
+		int GetTreeHeight(){ return mpTreeRoot ? mpTreeRoot->mlHeight : 0;}
+
 	private:
-		void AddNodeObjectsToRoot(cRCNode_DynBoxTree *apNode);
 		void SpecificUpdateBeforeRendering();
 
 		void RenderDebugNode(cRendererCallbackFunctions *apFunctions, cRCNode_DynBoxTree *apNode, int alLevel);
 
-		void RemoveNode(cRCNode_DynBoxTree *apNode);
-		void CheckNodeAABBNeedsUpdateIterative(cRCNode_DynBoxTree *apNode, iRenderable *apObject);
+		cRCNode_DynBoxTree* CreateNode();
+		void ReleaseNode(cRCNode_DynBoxTree *apNode);
 
-		cRCNode_DynBoxTree *GetAddNode(cRCNode_DynBoxTree *apStartNode, iRenderable *apObject);
-		void AddObjectToNodeIterative(cRCNode_DynBoxTree *apNode, iRenderable *apObject);
+		void SetLeafAABB(cRCNode_DynBoxTree *apLeaf);
+		void InsertLeaf(cRCNode_DynBoxTree *apLeaf);
+		void RemoveLeaf(cRCNode_DynBoxTree *apLeaf);
+		void ReplaceChild(cRCNode_DynBoxTree *apParent, cRCNode_DynBoxTree *apOldChild, cRCNode_DynBoxTree *apNewChild);
 
-		int GetSplitGroup(iRenderable *apObject, float afSplitPlane, int alAxis, const cVector3f &avNodeSize);
+		void RefitAndRotateUpwards(cRCNode_DynBoxTree *apNode);
+		void RotateNode(cRCNode_DynBoxTree *apNode);
+		void RefitTightAABBUpwards(cRCNode_DynBoxTree *apLeaf);
+		void UpdateRootAABB();
 
 		void UpdateObjectInContainer(iRenderable* apObject);
-		void CheckForFitIterative(cRCNode_DynBoxTree *apNode, cBoundingVolume *apBV);
 
+		void GetLeavesIterative(cRCNode_DynBoxTree *apNode, tRCNode_DynBoxTreeVec &avLeaves);
+		void ReleaseInternalNodesIterative(cRCNode_DynBoxTree *apNode);
 
-		cRCNode_DynBoxTree mRoot;
 
-		int mlSplitThreshold;
-		float mfMaxIntersectionAmount;
-		int mlMaxIgnoreSplitCount;
-		int mlMaxGarbageCollectCount;
+		cRCNode_DynBoxTree mRoot;
+		cRCNode_DynBoxTree *mpTreeRoot;
 
-		int mlRebuildCount;
-		int mlMaxRebuildCount;
+		float mfFatMargin;
+		float mfFatSizeMul;
+		float mfMaxFatAreaMul;
 
-		cRCNode_DynBoxTree *mpCheckForFitTempNode;
+		int mlNodeNum;
+		int mlNodeBlockSize;
+		tRCNode_DynBoxTreeVec mvNodeBlocks;
+		tRCNode_DynBoxTreeVec mvFreeNodes;
 
 		tRenderableSet m_setObjectsToUpdate;
 
 		cDynBoxTreeObjectCallback *mpObjectCalllback;
-
-		cRCNode_DynBoxTree *mpTempNode;
 	};
 
 	//-------------------------------------------
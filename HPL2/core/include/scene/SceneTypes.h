@@ -194,6 +194,7 @@ namespace hpl
 	class cGuiSetEntity;
 	class cAINodeContainer;
 	class cAStarHandler;
+	class cAIPathRequestQueue;
 	class cRopeEntity;
 	class cFogArea;
 	class cAnimationState;
@@ -240,6 +241,9 @@ namespace hpl
 	typedef std::list<cAStarHandler*> tAStarHandlerList;
 	typedef std::list<cAStarHandler*>::iterator tAStarHandlerIt;
 
+	typedef std::list<cAIPathRequestQueue*> tAIPathRequestQueueList;
+	typedef std::list<cAIPathRequestQueue*>::iterator tAIPathRequestQueueListIt;
+
 	typedef std::vector<cAnimationState*> tAnimationStateVec;
 	typedef tAnimationStateVec::iterator tAnimationStateVecIt;
 
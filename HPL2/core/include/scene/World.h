@@ -20,6 +20,8 @@
 #ifndef HPL_WORLD_H
 #define HPL_WORLD_H
 
+#include <stdint.h>
+
 #include "system/SystemTypes.h"
 #include "graphics/GraphicsTypes.h"
 #include "math/MathTypes.h"
@@ -63,6 +65,7 @@ namespace hpl {
 	class cSoundEntity;
 	class cAINodeContainer;
 	class cAStarHandler;
+	class cAIPathRequestQueue;
 	class cAINodeGeneratorParams;
 	class iVertexBuffer;
 	class iTexture;
@@ -339,6 +342,17 @@ namespace hpl {
 		cAStarHandler* CreateAStarHandler(cAINodeContainer* apContainer);
 		void DestroyAStarHandler(cAStarHandler* apHandler);
 
+		/**
+		 * Gets the path request queue for a container, it is created the first time. All users of a container share the queue.
+		 */
+		cAIPathRequestQueue* GetAIPathRequestQueue(cAINodeContainer* apContainer);
+
+		/**
+		 * Hash of the static bodies that node containers check edges against. Made the first time it is needed and then
+		 * kept, static bodies are not expected to change once the map is loaded.
+		 */
+		uint64_t GetAIStaticBodiesHash();
+
 		void AddAINode(const tString &asName, int alID, const tString &asType, const cVector3f &avPosition);
 		tTempAiNodeList* GetAINodeList(const tString &asType);
 
@@ -361,6 +375,7 @@ namespace hpl {
 
 		void UpdateEntities(float afTimeStep);
 		void UpdateParticles(float afTimeStep);
+		void UpdateAIPathRequests();
 		void UpdateLights(float afTimeStep);
 		void UpdateSoundEntities(float afTimeStep);
 
@@ -380,6 +395,9 @@ namespace hpl {
 		iPhysicsWorld *mpPhysicsWorld;
 		bool mbAutoDeletePhysicsWorld;
 
+		uint64_t mlAIStaticBodiesHash;
+		bool mbAIStaticBodiesHashValid;
+
 		bool mbIsSoundEmitter;
 
 		cVector3f mvWorldSize;
@@ -421,6 +439,7 @@ namespace hpl {
 
 		tAINodeContainerList mlstAINodeContainers;
 		tAStarHandlerList mlstAStarHandlers;
+		tAIPathRequestQueueList mlstAIPathRequestQueues;
 		tTempNodeContainerMap m_mapTempNodes;
 
 		cNode3D* mpRootNode;
@@ -21,6 +21,7 @@
 #define HPL_SOUNDHANDLER_H
 
 #include <list>
+#include <unordered_map>
 
 #include "system/SystemTypes.h"
 #include "math/MathTypes.h"
@@ -72,14 +73,20 @@ namespace hpl {
 
 	//----------------------------------------
 
+	/**
+	 * Entries are pooled by the handler, they are set up when a sound is played and released when it has stopped.
+	 */
 	class cSoundEntry
 	{
+	friend class cSoundHandler;
 	public:
-		cSoundEntry(const tString& asName, iSoundChannel* apSound, float afVolume,
+		cSoundEntry();
+		~cSoundEntry();
+
+		void Setup(	const tString& asName, iSoundChannel* apSound, float afVolume,
 					eSoundEntryType aType, bool ab3D,
 					bool abStream,int alId,
 					cSoundHandler *apSoundHandler);
-		~cSoundEntry();
 
 		bool Update(float afTimeStep);
 
@@ -116,6 +123,10 @@ namespace hpl {
 		void UpdateSpeedMulFade(float afTimeStep);
 
 		void Update3DSpecifics(float afTimeStep);
+		bool CheckIsBlocked(const cVector3f& avListenerPos);
+		float GetUnblockedVolume(const cVector3f& avListenerPos);
+
+		void Release();
 
 		tString msName;
 		iSoundChannel* mpSound;
@@ -143,10 +154,18 @@ namespace hpl {
 		float mfBlockFadeDest;
 		float mfBlockFadeSpeed;
 
+		bool mbBlocked;
+		bool mbBlockCheckNeeded;
+		int mlBlockCheckCount;
+		cVector3f mvBlockCheckSoundPos;
+		cVector3f mvBlockCheckListenerPos;
+
 		bool mbStream;
 		bool mbStopDisabled;
 
 		iSoundEntryCallback *mpCallback;
+
+		cSoundEntry *mpNextWithName;
 	};
 
 	//----------------------------------------
@@ -158,10 +177,13 @@ namespace hpl {
 
 	//----------------------------------------
 
-	typedef std::list<cSoundEntry*> tSoundEntryList;
+	typedef std::vector<cSoundEntry*> tSoundEntryList;
 	typedef tSoundEntryList::iterator tSoundEntryListIt;
 	typedef cSTLIterator<cSoundEntry,tSoundEntryList,tSoundEntryListIt> tSoundEntryIterator;
 
+	typedef std::unordered_map<tString, cSoundEntry*> tSoundEntryNameMap;
+	typedef tSoundEntryNameMap::iterator tSoundEntryNameMapIt;
+
 	class cResources;
 
 	//----------------------------------------
@@ -224,6 +246,9 @@ namespace hpl {
 
 		bool IsPlaying(const tString& asName);
 
+		/**
+		 * Checks if an entry is still playing the sound it was given with the id. Entries are pooled, so the pointer is always safe to check.
+		 */
 		bool IsValid(cSoundEntry *apEntry, int alID);
 
 		/**
@@ -253,15 +278,47 @@ namespace hpl {
 
 		bool CheckSoundIsBlocked(const cVector3f& avSoundPosition);
 
+		/**
+		 * Max number of rays cast each update to check if 3D sounds are blocked. Sounds that need a check are sorted by how long
+		 * they have waited and their priority, the rest wait until the next update. New sounds are always checked right away. 0 = no limit.
+		 */
+		void SetBlockRayBudget(int alX){ mlBlockRayBudget = alX;}
+		int GetBlockRayBudget(){ return mlBlockRayBudget;}
+
+		/**
+		 * A sound is checked again when it or the listener has moved this far since the last check, or when the interval
+		 * (in updates) has passed, so moving bodies (like doors) are noticed.
+		 */
+		void SetBlockCheckMoveThreshold(float afX){ mfBlockCheckMoveThreshold = afX;}
+		float GetBlockCheckMoveThreshold(){ return mfBlockCheckMoveThreshold;}
+		void SetBlockCheckInterval(int alX){ mlBlockCheckInterval = alX;}
+		int GetBlockCheckInterval(){ return mlBlockCheckInterval;}
+
+		/**
+		 * Number of rays cast and number of checks that used the last result instead, in the last update.
+		 */
+		int GetBlockRayCount(){ return mlBlockRayCount;}
+		int GetBlockRaysSavedCount(){ return mlBlockRaysSavedCount;}
+
 	private:
 		cSoundEntry* GetEntry(const tString& asName);
 
+		cSoundEntry* CreateEntry();
+		void ReleaseEntry(cSoundEntry *apEntry);
+		bool HasEntriesOfTypes(tFlag aTypes);
+
+		void UpdateBlockChecks();
+		void CastBlockRay(cSoundEntry *apEntry, const cVector3f& avListenerPos);
+
 		iLowLevelSound* mpLowLevelSound;
 		cResources* mpResources;
 
-		tSoundEntryList m_lstSoundEntries;
+		tSoundEntryList mvSoundEntries;
+		tSoundEntryNameMap m_mapSoundEntryNames;	//First (oldest) entry for each name, the rest are linked from it.
+		int mvSoundEntryTypeNum[2];					//World and gui entries, to skip entries of types not asked for.
 
-		//tSoundEntryList m_lstSoundEntriesPool;
+		std::vector<cSoundEntry*> mvSoundEntryBlocks;
+		std::vector<cSoundEntry*> mvFreeSoundEntries;
 
 		bool mbSilent;
 
@@ -269,6 +326,13 @@ namespace hpl {
 
 		cSoundRayCallback mSoundRayCallback;
 
+		int mlBlockRayBudget;
+		float mfBlockCheckMoveThreshold;
+		int mlBlockCheckInterval;
+		int mlBlockRayCount;
+		int mlBlockRaysSavedCount;
+		std::vector<std::pair<float, cSoundEntry*> > mvBlockCheckQueue;
+
 		int mlCount;
 		int mlIdCount;
 
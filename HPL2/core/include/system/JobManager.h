@@ -0,0 +1,189 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef HPL_JOB_MANAGER_H
+#define HPL_JOB_MANAGER_H
+
+#include "system/SystemTypes.h"
+#include "system/Thread.h"
+
+#include <deque>
+#include <list>
+#include <atomic>
+
+namespace hpl {
+
+	//--------------------------------------------------------
+
+	class iMutex;
+	class cJobManager;
+
+	//--------------------------------------------------------
+
+	/**
+	 * Function run by a job, on the index range [alStart, alEnd).
+	 */
+	typedef void (*tJobFunc)(void *apData, int alStart, int alEnd);
+
+	//--------------------------------------------------------
+
+	/**
+	 * Number of jobs left in a group. Increased when a job is added and decreased when it is done.
+	 */
+	class cJobCounter
+	{
+	friend class cJobManager;
+	public:
+		cJobCounter() : mlCount(0) {}
+
+		bool IsDone() const { return mlCount.load() == 0;}
+		int GetCount() const { return mlCount.load();}
+
+	private:
+		std::atomic<int> mlCount;
+	};
+
+	//--------------------------------------------------------
+
+	class cJob
+	{
+	public:
+		tJobFunc mpFunc;
+		void *mpData;
+		int mlStart;
+		int mlEnd;
+
+		cJobCounter *mpCounter;		//Decreased when the job is done, can be NULL
+		cJobCounter *mpWaitCounter;	//The job is not started until this is done, can be NULL
+	};
+
+	typedef std::list<cJob> tJobList;
+	typedef tJobList::iterator tJobListIt;
+
+	//--------------------------------------------------------
+
+	/**
+	 * The owner adds and takes jobs at the back, other threads steal from the front. If apCounter is set, only a job
+	 * with that counter is taken.
+	 */
+	class cJobQueue
+	{
+	public:
+		cJobQueue();
+		~cJobQueue();
+
+		void PushBack(const cJob& aJob);
+		bool PopBack(cJob* apJob, cJobCounter *apCounter=NULL);
+		bool StealFront(cJob* apJob, cJobCounter *apCounter=NULL);
+
+	private:
+		iMutex *mpMutex;
+		std::deque<cJob> mdqJobs;
+	};
+
+	//--------------------------------------------------------
+
+	class cJobWorker : public iThreadClass
+	{
+	public:
+		cJobWorker(cJobManager *apManager, int alQueue);
+		~cJobWorker();
+
+		void UpdateThread();
+
+		iThread *mpThread;
+
+	private:
+		cJobManager *mpManager;
+		int mlQueue;
+	};
+
+	//--------------------------------------------------------
+
+	/**
+	 * A fixed pool of worker threads with one job queue each. Jobs added from a worker go to its own queue, jobs added
+	 * from other threads go to a shared queue. Idle workers steal from the other queues and sleep a millisecond when
+	 * there is nothing to do. Jobs with an unfinished wait counter are kept aside until the counter is done. Threads that wait for jobs help out by
+	 * running jobs until the wait is over, so waiting from inside a job is fine.
+	 */
+	class cJobManager
+	{
+	friend class cJobWorker;
+	public:
+		/**
+		 * \param alWorkerNum number of worker threads, -1 = number of cores minus one (for the main thread).
+		 */
+		cJobManager(int alWorkerNum=-1);
+		~cJobManager();
+
+		int GetWorkerNum(){ return (int)mvWorkers.size();}
+
+		/**
+		 * Adds a job that is run on [alStart, alEnd). If apWaitCounter is set, the job is not started until it is done.
+		 */
+		void AddJob(tJobFunc apFunc, void *apData, int alStart, int alEnd, cJobCounter *apCounter, cJobCounter *apWaitCounter=NULL);
+
+		/**
+		 * Splits [alStart, alEnd) into ranges of at least alGrainSize and adds a job for each.
+		 */
+		void AddParallelFor(int alStart, int alEnd, int alGrainSize, tJobFunc apFunc, void *apData, cJobCounter *apCounter, cJobCounter *apWaitCounter=NULL);
+
+		/**
+		 * Same as AddParallelFor but returns when all of the range is done. Runs directly when the range is only one job.
+		 */
+		void ParallelFor(int alStart, int alEnd, int alGrainSize, tJobFunc apFunc, void *apData);
+
+		/**
+		 * Runs jobs of the counter's group until it is done. Other jobs are only run while some of the group is kept
+		 * aside for a wait counter, as the group can not finish before those have run.
+		 */
+		void Wait(cJobCounter *apCounter);
+
+		/**
+		 * Runs one job if there is any. Returns false if no job could be found.
+		 */
+		bool RunJob();
+
+		/**
+		 * The manager created by cSystem, NULL if there is none. Code that has no access to cSystem can use this and
+		 * run the work itself if it is NULL.
+		 */
+		static cJobManager* GetGlobal(){ return mpGlobal;}
+
+	private:
+		int GetCurrentQueue();
+		bool FindJob(int alQueue, cJob* apJob, cJobCounter *apCounter);
+		bool RunJob(int alQueue, cJobCounter *apCounter=NULL);
+		void QueuePendingJobs();
+		bool HasPendingJobs(cJobCounter *apCounter);
+
+		std::vector<cJobQueue*> mvQueues; //One per worker and the shared queue last
+		std::vector<cJobWorker*> mvWorkers;
+
+		iMutex *mpPendingMutex;
+		tJobList mlstPendingJobs;
+		std::atomic<int> mlPendingNum;
+
+		static cJobManager *mpGlobal;
+	};
+
+	//--------------------------------------------------------
+
+};
+#endif // HPL_JOB_MANAGER_H
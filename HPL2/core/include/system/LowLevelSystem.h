@@ -31,25 +31,6 @@
 namespace hpl {
 
 	//--------------------------------------------------------
-#define UPDATE_TIMING_ENABLED
-#ifdef UPDATE_TIMING_ENABLED
-	#define START_TIMING_EX(x,y)	LogUpdate("Updating %s in file %s at line %d\n",x,__FILE__,__LINE__); \
-								unsigned int y##_lTime = cPlatform::GetApplicationTime();
-	#define START_TIMING(x)	LogUpdate("Updating %s in file %s at line %d\n",#x,__FILE__,__LINE__); \
-								unsigned int x##_lTime = cPlatform::GetApplicationTime();
-	#define STOP_TIMING(x)	LogUpdate(" Time spent: %d ms\n",cPlatform::GetApplicationTime() - x##_lTime);
-	#define START_TIMING_TAB(x)	LogUpdate("\tUpdating %s in file %s at line %d\n",#x,__FILE__,__LINE__); \
-							unsigned int x##_lTime = cPlatform::GetApplicationTime();
-	#define STOP_TIMING_TAB(x)	LogUpdate("\t Time spent: %d ms\n",cPlatform::GetApplicationTime() - x##_lTime);
-#else
-	#define START_TIMING_EX(x,y)
-	#define START_TIMING(x)
-	#define STOP_TIMING(x)
-	#define START_TIMING_TAB(x)
-	#define STOP_TIMING_TAB(x)
-#endif
-
-	//--------------------------------------------------------
 
 	class iScript;
 
@@ -23,6 +23,12 @@
 #include "system/SystemTypes.h"
 
 #include <cstdarg>
+#include <stdint.h>
+
+//SSE is always there on x64, on 32 bit x86 only when the compiler is set to use it.
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#define HPL_USE_SSE
+#endif
 
 namespace hpl {
 
@@ -59,6 +65,14 @@ namespace hpl {
 		static tWString GetFullFilePath(const tWString& asFilePath);
 		static FILE *OpenFile(const tWString& asFileName, const tWString asMode);
 
+		/**
+		* Maps a file read only into memory.
+		* \param apSize gets the size of the file.
+		* \return pointer to the data or NULL if the file could not be mapped. Must be released with UnmapFile.
+		*/
+		static const void* MapFile(const tWString& asFileName, size_t *apSize);
+		static void UnmapFile(const void *apData, size_t alSize);
+
 		static cDate FileModifiedDate(const tWString& asFilePath);
 		static cDate FileCreationDate(const tWString& asFilePath);
 
@@ -90,6 +104,10 @@ namespace hpl {
 		//////////////////////////////////////////////////////
 
 		static unsigned long GetApplicationTime();
+		/**
+		 * High resolution time in nanoseconds. The start point is undefined, only use for measuring time between two calls.
+		 */
+		static uint64_t GetApplicationTimeNanoSec();
 		static void Sleep (unsigned int alMilliSecs);
 
 		//////////////////////////////////////////////////////
@@ -144,6 +162,11 @@ namespace hpl {
 
 		static iMutex* CreateMutEx(); // If you name this method CreateMutex strange stuff will happen :S
 
+		/**
+		 * Number of logical CPU cores, at least 1.
+		 */
+		static int GetCPUCount();
+
 	private:
         static void CreateMessageBoxBase(eMsgBoxType eType, const wchar_t* asCaption, const wchar_t* fmt, va_list ap);
 
@@ -0,0 +1,192 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef HPL_PROFILER_H
+#define HPL_PROFILER_H
+
+#include "system/SystemTypes.h"
+
+#include <stdint.h>
+
+namespace hpl {
+
+	//--------------------------------------------------------
+
+	//Zone names must stay valid until the profiler is shut down, use string literals or cProfiler::GetZoneName.
+	#define PROFILE_ZONE(x)				cProfilerScope x##_ProfileZone(#x);
+	#define PROFILE_ZONE_EX(asName,x)	cProfilerScope x##_ProfileZone(asName);
+	#define PROFILE_BEGIN(x)			cProfiler::BeginZone(#x);
+	#define PROFILE_END(x)				cProfiler::EndZone();
+
+	//--------------------------------------------------------
+
+	class iMutex;
+
+	//--------------------------------------------------------
+
+	class cProfilerZoneData
+	{
+	public:
+		const char *mpName;
+		uint64_t mlStart;	//Nanoseconds, cPlatform::GetApplicationTimeNanoSec
+		uint64_t mlEnd;
+		int mlDepth;
+		int mlFrame;
+	};
+
+	//--------------------------------------------------------
+
+	/**
+	 * Zones recorded by a single thread. Zones are added when they end, the oldest zones are overwritten when full.
+	 */
+	class cProfilerThreadBuffer
+	{
+	public:
+		cProfilerThreadBuffer(int alId, int alSize);
+		~cProfilerThreadBuffer();
+
+		void Add(const cProfilerZoneData& aZone);
+
+		int mlId;
+		tString msName;
+
+		std::vector<cProfilerZoneData> mvZones;
+		size_t mlWritePos;
+		size_t mlZoneNum;
+
+		int mlDepth;
+		std::vector<uint64_t> mvStartTimes;
+		std::vector<const char*> mvStartNames;
+
+		iMutex *mpMutex; //Locked when adding and when reading from another thread
+	};
+
+	typedef std::vector<cProfilerThreadBuffer*> tProfilerThreadBufferVec;
+
+	//--------------------------------------------------------
+
+	/**
+	 * A zone in the aggregated frame tree. Zones with the same name and parent are added together.
+	 */
+	class cProfilerZoneStats
+	{
+	public:
+		const char *mpName;
+		int mlThread;
+		int mlDepth;
+		int mlParent;		//Index in the stats vector, -1 = root
+
+		int mlCalls;
+		double mfTotalTime;	//Milliseconds
+		double mfMaxTime;
+	};
+
+	typedef std::vector<cProfilerZoneStats> tProfilerZoneStatsVec;
+
+	//--------------------------------------------------------
+
+	/**
+	 * Records nested timing zones on all threads. Each thread writes to a ring buffer of its own, so recording only
+	 * takes a timer read and an uncontended lock. Zones can be aggregated per frame or saved in the Chrome trace format
+	 * (load in chrome://tracing).
+	 */
+	class cProfiler
+	{
+	public:
+		static void Init(int alBufferSize=16384);
+		static void Exit();
+
+		static void SetActive(bool abX){ mbActive = abX;}
+		static bool IsActive(){ return mbActive;}
+
+		static void BeginZone(const char *apName);
+		static void EndZone();
+
+		/**
+		 * Gets a name that stays valid as long as the profiler is initialized. Meant for zones with names that are not literals.
+		 */
+		static const char* GetZoneName(const tString& asName);
+
+		/**
+		 * Increased each time the profiler is initialized, 0 = not initialized. Names from GetZoneName can be cached
+		 * as long as this stays the same.
+		 */
+		static int GetGeneration();
+
+		/**
+		 * Sets the name of the calling thread, shown in traces.
+		 */
+		static void SetThreadName(const tString& asName);
+
+		/**
+		 * Ends the current frame and aggregates all zones recorded during it. Shall be called once per frame by the main loop.
+		 */
+		static void NewFrame();
+		static int GetFrame(){ return mlFrame;}
+
+		/**
+		 * Zones of the last ended frame, parents are always before children.
+		 */
+		static const tProfilerZoneStatsVec& GetLastFrameStats(){ return mvLastFrameStats;}
+		static double GetLastFrameTime(){ return mfLastFrameTime;}
+
+		/**
+		 * Frames that take longer than this (in ms) have their zone tree written to the log. 0 = disabled.
+		 */
+		static void SetSpikeLogLimit(double afX){ mfSpikeLogLimit = afX;}
+		static double GetSpikeLogLimit(){ return mfSpikeLogLimit;}
+
+		static void LogLastFrame();
+
+		/**
+		 * Saves all zones still in the ring buffers as Chrome trace JSON.
+		 */
+		static bool SaveChromeTrace(const tWString& asFile);
+
+	private:
+		static cProfilerThreadBuffer* GetThreadBuffer();
+		static void AggregateFrame(int alFrame);
+
+		static bool mbActive;
+		static int mlBufferSize;
+		static int mlFrame;
+		static uint64_t mlFrameStart;
+
+		static iMutex *mpMutex;
+		static tProfilerThreadBufferVec mvThreadBuffers;
+		static tStringSet m_setZoneNames;
+
+		static tProfilerZoneStatsVec mvLastFrameStats;
+		static double mfLastFrameTime;
+		static double mfSpikeLogLimit;
+	};
+
+	//--------------------------------------------------------
+
+	class cProfilerScope
+	{
+	public:
+		cProfilerScope(const char *apName){ cProfiler::BeginZone(apName);}
+		~cProfilerScope(){ cProfiler::EndZone();}
+	};
+
+	//--------------------------------------------------------
+
+};
+#endif // HPL_PROFILER_H
@@ -31,6 +31,70 @@
 
 namespace hpl {
 
+	//------------------------------------------------------
+
+	enum eScriptArgType
+	{
+		eScriptArgType_Bool,
+		eScriptArgType_Int,
+		eScriptArgType_Float,
+		eScriptArgType_String,
+
+		eScriptArgType_LastEnum,
+	};
+
+	#define kMaxScriptArgs 6
+
+	/**
+	 * Arguments for iScript::RunCallback, added in the order of the function parameters. At most kMaxScriptArgs
+	 * can be added, adding more makes the args invalid and RunCallback will refuse to run them.
+	 */
+	class cScriptArgs
+	{
+	public:
+		cScriptArgs() : mlNum(0), mbValid(true) {}
+
+		cScriptArgs& AddBool(bool abX){ if(HasSpace()){ mvTypes[mlNum] = eScriptArgType_Bool; mvInts[mlNum++] = abX ? 1 : 0;} return *this;}
+		cScriptArgs& AddInt(int alX){ if(HasSpace()){ mvTypes[mlNum] = eScriptArgType_Int; mvInts[mlNum++] = alX;} return *this;}
+		cScriptArgs& AddFloat(float afX){ if(HasSpace()){ mvTypes[mlNum] = eScriptArgType_Float; mvFloats[mlNum++] = afX;} return *this;}
+		cScriptArgs& AddString(const tString& asX){ if(HasSpace()){ mvTypes[mlNum] = eScriptArgType_String; mvStrings[mlNum++] = asX;} return *this;}
+
+		/**
+		 * False if more than kMaxScriptArgs were added.
+		 */
+		bool IsValid() const { return mbValid;}
+
+		int GetNum() const { return mlNum;}
+		eScriptArgType GetType(int alIdx) const { return mvTypes[alIdx];}
+
+		bool GetBool(int alIdx) const { return mvInts[alIdx]!=0;}
+		int GetInt(int alIdx) const { return mvInts[alIdx];}
+		float GetFloat(int alIdx) const { return mvFloats[alIdx];}
+		const tString& GetString(int alIdx) const { return mvStrings[alIdx];}
+
+		/**
+		 * The arguments as script code, for example: ("name", 3)
+		 */
+		tString ToString() const;
+
+	private:
+		bool HasSpace()
+		{
+			if(mlNum < kMaxScriptArgs) return true;
+			mbValid = false;
+			return false;
+		}
+
+		int mlNum;
+		bool mbValid;
+		eScriptArgType mvTypes[kMaxScriptArgs];
+		int mvInts[kMaxScriptArgs];
+		float mvFloats[kMaxScriptArgs];
+		tString mvStrings[kMaxScriptArgs];
+	};
+
+	//------------------------------------------------------
+
 	class iScript : public iResourceBase
 	{
 	public:
@@ -55,6 +119,13 @@ namespace hpl {
 		virtual bool Run(const tString& asFuncLine)=0;
 
 		virtual bool Run(int alHandle)=0;
+
+		/**
+		 * Runs a func with arguments, for example RunCallback("test", cScriptArgs().AddInt(15)). The func is only looked
+		 * up the first time and the arguments are passed directly, so unlike Run(asFuncLine) nothing is compiled.
+		 * \return true if everything was ok, else false
+		 */
+		virtual bool RunCallback(const tString& asFunc, const cScriptArgs& aArgs)=0;
 	};
 };
 #endif // HPL_SCRIPT_H
@@ -24,6 +24,7 @@ namespace hpl {
 
 	class iLowLevelSystem;
 	class cLogicTimer;
+	class cJobManager;
 
 	class cSystem
 	{
@@ -33,6 +34,12 @@ namespace hpl {
 
 		iLowLevelSystem* GetLowLevel();
 
+		/**
+		 * Creates the job manager.
+		 * \param alJobWorkerNum Number of worker threads, below 0 means one per core except for the main thread.
+		 */
+		void Init(int alJobWorkerNum);
+
 		/**
 		 * Creates a logic timer.
 		 * \param alUpdatesPerSec Frequency of the timer.
@@ -40,8 +47,14 @@ namespace hpl {
 		 */
 		cLogicTimer * CreateLogicTimer(unsigned int alUpdatesPerSec);
 
+		/**
+		 * Worker threads for running work in parallel. NULL before Init.
+		 */
+		cJobManager* GetJobManager(){ return mpJobManager;}
+
 	private:
         iLowLevelSystem *mpLowLevelSystem;
+		cJobManager *mpJobManager;
 	};
 
 };
@@ -21,9 +21,15 @@
 
 #include "scene/World.h"
 #include "physics/PhysicsBody.h"
+#include "physics/CollideShape.h"
+#include "physics/PhysicsWorld.h"
+#include "resources/BinaryBuffer.h"
+#include "math/BoundingVolume.h"
 #include "system/String.h"
 #include "system/LowLevelSystem.h"
 #include "system/Platform.h"
+#include "system/JobManager.h"
+#include "system/Profiler.h"
 
 #include "math/Math.h"
 
@@ -42,6 +48,9 @@ namespace hpl {
 
 	cAINode::cAINode()
 	{
+		mlID = -1;
+		mlIndex = -1;
+		mpUserData = NULL;
 	}
 
 	//-----------------------------------------------------------------------
@@ -248,6 +257,7 @@ namespace hpl {
 		msNodeName = asNodeName;
 
 		mpRayCallback = hplNew( cAINodeRayCallback, () );
+		mpCompileRayQuery = NULL;
 
 		mlMaxNodeEnds = 5;
 		mlMinNodeEnds = 2;
@@ -288,6 +298,7 @@ namespace hpl {
 		cAINode *pNode = hplNew( cAINode, () );
 		pNode->msName = asName;
 		pNode->mlID = alID;
+		pNode->mlIndex = (int)mvNodes.size();
 		pNode->mvPosition = avPosition;
 		pNode->mpUserData = apUserData;
 
@@ -340,83 +351,32 @@ namespace hpl {
 
 	void cAINodeContainer::Compile()
 	{
+		PROFILE_ZONE(AINodeCompile);
+
 		BuildNodeGridMap();
 
-		tAINodeVecIt CurrentNodeIt = mvNodes.begin();
-		for(; CurrentNodeIt != mvNodes.end(); ++CurrentNodeIt)
+		////////////////////////////////////////
+		//Take a snapshot of the static bodies, it can be ray cast from the workers while CastRay can not.
+		iPhysicsWorld *pPhysicsWorld = mpWorld->GetPhysicsWorld();
+		if(pPhysicsWorld)
 		{
-			cAINode *pNode = *CurrentNodeIt;
-
-			////////////////////////////////////////
-			//Add the ends that are connected to the node.
-			/*Log("Node %s checks: ",pNode->GetName().c_str());
-			tAINodeVecIt EndNodeIt = mvNodes.begin();
-			for(; EndNodeIt != mvNodes.end(); ++EndNodeIt)
-			{
-				cAINode *pEndNode = *EndNodeIt;
-
-				if(pEndNode == pNode) continue;
-				float fDist = cMath::Vector3Dist(pNode->mvPosition, pEndNode->mvPosition);
-				if(fDist > mfMaxEndDistance*2) continue;
-				Log("'%s'(%f) ",pEndNode->GetName().c_str(),fDist);
-
-				float fHeight = fabs(pNode->mvPosition.y - pEndNode->mvPosition.y);
-
-				if(	fHeight <= mfMaxHeight &&
-				FreePath(pNode->mvPosition, pEndNode->mvPosition,-1,eAIFreePathFlag_SkipDynamic))
-				{
-				pNode->AddEdge(pEndNode);
-				Log("Added!");
-				}
-				Log(", ");
-			}
-			Log("\n");*/
-			//Log("Node %s checks: ",pNode->GetName().c_str());
-			cAINodeIterator nodeIt = GetNodeIterator(pNode->mvPosition,mfMaxEndDistance*1.5f);
-			while(nodeIt.HasNext())
-			{
-				cAINode *pEndNode = nodeIt.Next();
-
-                if(pEndNode == pNode) continue;
-				float fDist = cMath::Vector3Dist(pNode->mvPosition, pEndNode->mvPosition);
-				if(fDist > mfMaxEndDistance*2) continue;
-				//Log("'%s'(%f) ",pEndNode->GetName().c_str(),fDist);
-
-				float fHeight = fabs(pNode->mvPosition.y - pEndNode->mvPosition.y);
-
-				tAIFreePathFlag flag = eAIFreePathFlag_SkipDynamic | eAIFreePathFlag_SkipVolatile;
-				if(	fHeight <= mfMaxHeight &&
-					FreePath(pNode->mvPosition, pEndNode->mvPosition,-1,flag))
-				{
-					pNode->AddEdge(pEndNode);
-					//Log("Added!");
-				}
-				//Log(", ");
-			}
-			//Log("\n");
-
-
-			///////////////////////////////////////
-			//Sort nodes and remove unwanted ones.
-			std::sort(pNode->mvEdges.begin(), pNode->mvEdges.end(), cSortEndNodes());
-
-			//Resize if to too large
-			if(mlMaxNodeEnds > 0 && (int)pNode->mvEdges.size() > mlMaxNodeEnds)
-			{
-				pNode->mvEdges.resize(mlMaxNodeEnds);
-			}
+			cAINodeRayCallback rayFilter;
+			rayFilter.SetFlags(eAIFreePathFlag_SkipDynamic | eAIFreePathFlag_SkipVolatile);
+			mpCompileRayQuery = pPhysicsWorld->CreateRayQuery(&rayFilter);
+		}
 
-			//Remove ends to far, but skip if min nodes is not met
-			for(size_t i=0; i< pNode->mvEdges.size(); ++i)
-			{
-				if( pNode->mvEdges[i].mfDistance > mfMaxEndDistance && (int)i >= mlMinNodeEnds)
-				{
-					pNode->mvEdges.resize(i);
-					break;
-				}
-			}
+		////////////////////////////////////////
+		//Build the edges, each node only changes its own edges.
+		cJobManager *pJobManager = cJobManager::GetGlobal();
+		if(pJobManager)
+			pJobManager->ParallelFor(0, (int)mvNodes.size(), 16, CompileNodesJob, this);
+		else
+			CompileNodesJob(this, 0, (int)mvNodes.size());
 
-			//Log("  Final edge count: %d\n",pNode->mvEdges.size());
+		if(mpCompileRayQuery)
+		{
+			hplDelete(mpCompileRayQuery);
+			mpCompileRayQuery = NULL;
 		}
 	}
 
@@ -514,22 +474,8 @@ namespace hpl {
 		iPhysicsWorld *pPhysicsWorld = mpWorld->GetPhysicsWorld();
 		if(pPhysicsWorld==NULL) return true;
 
-
-		if(alRayNum<0 || alRayNum>5) alRayNum =5;
-
-		/////////////////////////////
-		//Calculate the right vector
-		const cVector3f vForward = cMath::Vector3Normalize(avEnd - avStart);
-		const cVector3f vUp = cVector3f(0,1.0f,0);
-		const cVector3f vRight = cMath::Vector3Cross(vForward, vUp);
-
-		//Get the center
-		const cVector3f vStartCenter = mbNodeIsAtCenter ? avStart : avStart + cVector3f(0,mvSize.y/2,0);
-		const cVector3f vEndCenter  = mbNodeIsAtCenter ? avEnd : avEnd + cVector3f(0,mvSize.y/2,0);
-
-		//Get the half with and height. Make them a little smaller so that player can slide over funk on floor.
-		const float fHalfWidth = mvSize.x * 0.4f;
-		const float fHalfHeight = mvSize.y * 0.4f;
+		cVector3f vStarts[5], vEnds[5];
+		alRayNum = GetFreePathRays(avStart, avEnd, alRayNum, vStarts, vEnds);
 
 		//Setup ray callback
 		mpRayCallback->SetFlags(aFlags);
@@ -537,14 +483,10 @@ namespace hpl {
 		//Iterate through all the rays.
 		for(int i=0; i< alRayNum; ++i)
 		{
-			cVector3f vAdd = vRight * (gvPosAdds[i].x*fHalfWidth) + vUp * (gvPosAdds[i].y*fHalfHeight);
-			cVector3f vStart = vStartCenter + vAdd;
-			cVector3f vEnd = vEndCenter + vAdd;
-
 			mpRayCallback->Reset();
 			mpRayCallback->mpCallback = apCallback;
 
-			pPhysicsWorld->CastRay(mpRayCallback,vStart,vEnd,false,false,false,true);
+			pPhysicsWorld->CastRay(mpRayCallback,vStarts[i],vEnds[i],false,false,false,true);
 
 			if(mpRayCallback->Intersected()) return false;
 		}
@@ -554,11 +496,109 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	static void HashAddData(uint64_t &alHash, const void *apData, size_t alSize)
+	{
+		//64 bit FNV-1a
+		const unsigned char *pData = static_cast<const unsigned char*>(apData);
+		for(size_t i=0; i<alSize; ++i)
+		{
+			alHash ^= pData[i];
+			alHash *= 1099511628211ULL;
+		}
+	}
+
+	/**
+	 * Shapes are hashed by type, size and offset. The volume is 0 for meshes, so mesh shapes also hash their
+	 * serialized collision data, which is built from the vertices and indices.
+	 */
+	static void HashAddShape(uint64_t &alHash, iPhysicsWorld *apPhysicsWorld, iCollideShape *apShape)
+	{
+		int lType = (int)apShape->GetType();
+		int lSubShapeNum = apShape->GetSubShapeNum();
+
+		HashAddData(alHash, &lType, sizeof(int));
+		HashAddData(alHash, &lSubShapeNum, sizeof(int));
+		HashAddData(alHash, &apShape->GetSize().x, sizeof(float)*3);
+		HashAddData(alHash, &apShape->GetOffset().m[0][0], sizeof(float)*16);
+
+		if(apShape->GetType() == eCollideShapeType_Mesh)
+		{
+			cBinaryBuffer meshBuffer;
+			apPhysicsWorld->SaveMeshShapeToBuffer(apShape, &meshBuffer);
+			if(meshBuffer.GetSize() > 0) HashAddData(alHash, meshBuffer.GetDataPointer(), meshBuffer.GetSize());
+		}
+		else if(apShape->GetType() == eCollideShapeType_Compound)
+		{
+			for(int i=0; i<lSubShapeNum; ++i)
+			{
+				HashAddShape(alHash, apPhysicsWorld, apShape->GetSubShape(i));
+			}
+		}
+	}
+
+	tString cAINodeContainer::GetGeometryHash()
+	{
+		uint64_t lHash = 14695981039346656037ULL;
+
+		////////////////////////////////////
+		// Nodes and settings
+		for(size_t i=0; i< mvNodes.size(); ++i)
+		{
+			cAINode *pNode = mvNodes[i];
+			HashAddData(lHash, pNode->msName.c_str(), pNode->msName.size());
+			HashAddData(lHash, &pNode->mvPosition.x, sizeof(float)*3);
+		}
+		HashAddData(lHash, &mvSize.x, sizeof(float)*3);
+		HashAddData(lHash, &mbNodeIsAtCenter, sizeof(bool));
+		HashAddData(lHash, &mlMaxNodeEnds, sizeof(int));
+		HashAddData(lHash, &mlMinNodeEnds, sizeof(int));
+		HashAddData(lHash, &mfMaxEndDistance, sizeof(float));
+		HashAddData(lHash, &mfMaxHeight, sizeof(float));
+
+		////////////////////////////////////
+		// Static bodies, cached by the world
+		uint64_t lBodiesHash = mpWorld->GetAIStaticBodiesHash();
+		HashAddData(lHash, &lBodiesHash, sizeof(uint64_t));
+
+		char sBuffer[32];
+		sprintf(sBuffer, "%08x%08x", (unsigned int)(lHash >> 32), (unsigned int)(lHash & 0xFFFFFFFF));
+		return sBuffer;
+	}
+
+	//-----------------------------------------------------------------------
+
+	uint64_t cAINodeContainer::GetStaticBodiesHash(iPhysicsWorld *apPhysicsWorld)
+	{
+		uint64_t lHash = 14695981039346656037ULL;
+		if(apPhysicsWorld==NULL) return lHash;
+
+		//The same bodies that Compile checks free paths against.
+		cAINodeRayCallback rayFilter;
+		rayFilter.SetFlags(eAIFreePathFlag_SkipDynamic | eAIFreePathFlag_SkipVolatile);
+
+		cPhysicsBodyIterator bodyIt = apPhysicsWorld->GetBodyIterator();
+		while(bodyIt.HasNext())
+		{
+			iPhysicsBody *pBody = bodyIt.Next();
+			if(pBody->IsActive()==false || rayFilter.BeforeIntersect(pBody)==false) continue;
+
+			HashAddData(lHash, &pBody->GetWorldMatrix().m[0][0], sizeof(float)*16);
+			HashAddData(lHash, &pBody->GetBoundingVolume()->GetMin().x, sizeof(float)*3);
+			HashAddData(lHash, &pBody->GetBoundingVolume()->GetMax().x, sizeof(float)*3);
+			HashAddShape(lHash, apPhysicsWorld, pBody->GetShape());
+		}
+
+		return lHash;
+	}
+
+	//-----------------------------------------------------------------------
+
 	void cAINodeContainer::SaveToFile(const tWString &asFile)
 	{
 		TiXmlDocument* pXmlDoc = hplNew( TiXmlDocument,() );
 
 		TiXmlElement *pRootElem = static_cast<TiXmlElement*>(pXmlDoc->InsertEndChild(TiXmlElement("AINodes")));
+		pRootElem->SetAttribute("GeometryHash", GetGeometryHash().c_str());
 
 		for(size_t i=0; i< mvNodes.size(); ++i)
 		{
@@ -592,12 +632,12 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
-	void cAINodeContainer::LoadFromFile(const tWString &asFile)
+	bool cAINodeContainer::LoadFromFile(const tWString &asFile, bool abCheckHash)
 	{
 		BuildNodeGridMap();
 
 		FILE *pFile = cPlatform::OpenFile(asFile, _W("rb"));
-		if(pFile==NULL) return;
+		if(pFile==NULL) return false;
 
 		TiXmlDocument* pXmlDoc = hplNew( TiXmlDocument, () );
 		if(pXmlDoc->LoadFile(pFile)==false)
@@ -605,12 +645,24 @@ namespace hpl {
 			Warning("Couldn't open XML file %s\n",cString::To8Char(asFile).c_str());
 			fclose(pFile);
 			hplDelete(pXmlDoc);
-			return;
+			return false;
 		}
 		fclose(pFile);
 
 		TiXmlElement *pRootElem = pXmlDoc->RootElement();
 
+		////////////////////////////////////
+		// Skip if nodes or geometry have changed since saving
+		if(abCheckHash)
+		{
+			tString sSavedHash = cString::ToString(pRootElem->Attribute("GeometryHash"),"");
+			if(sSavedHash != GetGeometryHash())
+			{
+				hplDelete(pXmlDoc);
+				return false;
+			}
+		}
+
 		TiXmlElement *pNodeElem = pRootElem->FirstChildElement("Node");
 		for(; pNodeElem != NULL; pNodeElem = pNodeElem->NextSiblingElement("Node"))
 		{
@@ -635,6 +687,8 @@ namespace hpl {
 		}
 
 		hplDelete(pXmlDoc);
+
+		return true;
 	}
 	//-----------------------------------------------------------------------
 
@@ -644,6 +698,110 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	int cAINodeContainer::GetFreePathRays(const cVector3f &avStart, const cVector3f &avEnd, int alRayNum, cVector3f *apStarts, cVector3f *apEnds)
+	{
+		if(alRayNum<0 || alRayNum>5) alRayNum =5;
+
+		/////////////////////////////
+		//Calculate the right vector
+		const cVector3f vForward = cMath::Vector3Normalize(avEnd - avStart);
+		const cVector3f vUp = cVector3f(0,1.0f,0);
+		const cVector3f vRight = cMath::Vector3Cross(vForward, vUp);
+
+		//Get the center
+		const cVector3f vStartCenter = mbNodeIsAtCenter ? avStart : avStart + cVector3f(0,mvSize.y/2,0);
+		const cVector3f vEndCenter  = mbNodeIsAtCenter ? avEnd : avEnd + cVector3f(0,mvSize.y/2,0);
+
+		//Get the half with and height. Make them a little smaller so that player can slide over funk on floor.
+		const float fHalfWidth = mvSize.x * 0.4f;
+		const float fHalfHeight = mvSize.y * 0.4f;
+
+		for(int i=0; i< alRayNum; ++i)
+		{
+			cVector3f vAdd = vRight * (gvPosAdds[i].x*fHalfWidth) + vUp * (gvPosAdds[i].y*fHalfHeight);
+			apStarts[i] = vStartCenter + vAdd;
+			apEnds[i] = vEndCenter + vAdd;
+		}
+
+		return alRayNum;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cAINodeContainer::CompileNode(cAINode *apNode)
+	{
+		////////////////////////////////////////
+		//Add the ends that are connected to the node.
+		cAINodeIterator nodeIt = GetNodeIterator(apNode->mvPosition,mfMaxEndDistance*1.5f);
+		while(nodeIt.HasNext())
+		{
+			cAINode *pEndNode = nodeIt.Next();
+
+			if(pEndNode == apNode) continue;
+			float fDist = cMath::Vector3Dist(apNode->mvPosition, pEndNode->mvPosition);
+			if(fDist > mfMaxEndDistance*2) continue;
+
+			float fHeight = fabs(apNode->mvPosition.y - pEndNode->mvPosition.y);
+
+			if(	fHeight <= mfMaxHeight &&
+				CompileFreePath(apNode->mvPosition, pEndNode->mvPosition))
+			{
+				apNode->AddEdge(pEndNode);
+			}
+		}
+
+		///////////////////////////////////////
+		//Sort nodes and remove unwanted ones.
+		std::sort(apNode->mvEdges.begin(), apNode->mvEdges.end(), cSortEndNodes());
+
+		//Resize if to too large
+		if(mlMaxNodeEnds > 0 && (int)apNode->mvEdges.size() > mlMaxNodeEnds)
+		{
+			apNode->mvEdges.resize(mlMaxNodeEnds);
+		}
+
+		//Remove ends to far, but skip if min nodes is not met
+		for(size_t i=0; i< apNode->mvEdges.size(); ++i)
+		{
+			if( apNode->mvEdges[i].mfDistance > mfMaxEndDistance && (int)i >= mlMinNodeEnds)
+			{
+				apNode->mvEdges.resize(i);
+				break;
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool cAINodeContainer::CompileFreePath(const cVector3f &avStart, const cVector3f &avEnd)
+	{
+		if(mpCompileRayQuery==NULL) return true;
+
+		cVector3f vStarts[5], vEnds[5];
+		int lRayNum = GetFreePathRays(avStart, avEnd, -1, vStarts, vEnds);
+
+		for(int i=0; i< lRayNum; ++i)
+		{
+			if(mpCompileRayQuery->Intersects(vStarts[i], vEnds[i])) return false;
+		}
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cAINodeContainer::CompileNodesJob(void *apData, int alStart, int alEnd)
+	{
+		cAINodeContainer *pContainer = static_cast<cAINodeContainer*>(apData);
+
+		for(int i=alStart; i<alEnd; ++i)
+		{
+			pContainer->CompileNode(pContainer->mvNodes[i]);
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
 	cVector2l cAINodeContainer::GetGridPosFromLocal(const cVector2f &avLocalPos)
 	{
 		cVector2l vGridPos;
@@ -0,0 +1,657 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ai/AIPathRequestQueue.h"
+
+#include "ai/AINodeContainer.h"
+
+#include "system/Platform.h"
+#include "system/Mutex.h"
+#include "system/LowLevelSystem.h"
+
+#include "math/Math.h"
+
+#include <algorithm>
+
+namespace hpl {
+
+	//////////////////////////////////////////////////////////////////////////
+	// GRAPH SNAPSHOT
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	cAINodeGraphSnapshot::cAINodeGraphSnapshot(cAINodeContainer *apContainer)
+	{
+		int lNodeNum = apContainer->GetNodeNum();
+
+		mvPositions.resize(lNodeNum);
+		mvEdgeStart.resize(lNodeNum+1);
+
+		for(int i=0; i<lNodeNum; ++i)
+		{
+			cAINode *pNode = apContainer->GetNode(i);
+			mvPositions[i] = pNode->GetPosition();
+			mvEdgeStart[i] = (int)mvEdgeNodes.size();
+
+			for(int edge=0; edge<pNode->GetEdgeNum(); ++edge)
+			{
+				cAINodeEdge *pEdge = pNode->GetEdge(edge);
+				mvEdgeNodes.push_back(pEdge->mpNode->GetIndex());
+				mvEdgeDistances.push_back(pEdge->mfDistance);
+			}
+		}
+		mvEdgeStart[lNodeNum] = (int)mvEdgeNodes.size();
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// SEARCH
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	cAIPathSearch::cAIPathSearch(cAINodeContainer *apContainer, const cAINodeGraphSnapshot *apGraph)
+	{
+		mpContainer = apContainer;
+		mpGraph = apGraph;
+
+		int lNodeNum = mpGraph->GetNodeNum();
+		mvGenerations.resize(lNodeNum, 0);
+		mvGoalGenerations.resize(lNodeNum, 0);
+		mvHeapIndices.resize(lNodeNum, -1);
+		mvParents.resize(lNodeNum, -1);
+		mvCosts.resize(lNodeNum, 0);
+		mvDistances.resize(lNodeNum, 0);
+		mlGeneration = 0;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cAIPathSearch::Solve(cAIPathRequest *apRequest)
+	{
+		//////////////////////
+		// Set up
+		++mlGeneration;
+		mvOpenHeap.resize(0);
+		mvGoal = apRequest->mvGoal;
+
+		apRequest->mbFound = false;
+		apRequest->mvPath.resize(0);
+
+		for(size_t i=0; i<apRequest->mvGoalNodes.size(); ++i)
+			mvGoalGenerations[apRequest->mvGoalNodes[i]] = mlGeneration;
+
+		for(size_t i=0; i<apRequest->mvStartNodes.size(); ++i)
+			AddOpenNode(apRequest->mvStartNodes[i], -1, apRequest->mvStartDistances[i]);
+
+		//////////////////////
+		// Iterate, same as cAStarHandler::IterateAlgorithm
+		int lGoalNode = -1;
+		int lIterationCount=0;
+		while(mvOpenHeap.empty()==false && (apRequest->mlMaxIterations <0 || lIterationCount < apRequest->mlMaxIterations))
+		{
+			int lNode = PopBestNode();
+
+			if(mvGoalGenerations[lNode] == mlGeneration)
+			{
+				lGoalNode = lNode;
+				break;
+			}
+
+			int lEdgeEnd = mpGraph->mvEdgeStart[lNode+1];
+			for(int edge = mpGraph->mvEdgeStart[lNode]; edge < lEdgeEnd; ++edge)
+			{
+				//The callback is only set for requests solved on the main thread, so the container can be used.
+				if(	apRequest->mpCallback &&
+					apRequest->mpCallback->CanAddNode(mpContainer->GetNode(lNode), mpContainer->GetNode(mpGraph->mvEdgeNodes[edge]))==false)
+				{
+					continue;
+				}
+
+				AddOpenNode(mpGraph->mvEdgeNodes[edge], lNode, mvDistances[lNode] + mpGraph->mvEdgeDistances[edge]);
+			}
+
+			++lIterationCount;
+		}
+
+		//////////////////////
+		// Build path
+		if(lGoalNode >= 0)
+		{
+			apRequest->mbFound = true;
+			for(int lNode = lGoalNode; lNode >= 0; lNode = mvParents[lNode])
+			{
+				apRequest->mvPath.push_back(lNode);
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cAIPathSearch::AddOpenNode(int alNode, int alParent, float afDistance)
+	{
+		const cVector3f& vPos = mpGraph->mvPositions[alNode];
+
+		//Same cost and heuristic as cAStarHandler
+		float fCost = afDistance;
+		if(alParent >= 0) fCost *= 1+fabs(vPos.y - mpGraph->mvPositions[alParent].y);
+		fCost += cMath::Vector3Dist(vPos, mvGoal);
+
+		if(mvGenerations[alNode] == mlGeneration)
+		{
+			if(mvHeapIndices[alNode] < 0 || fCost >= mvCosts[alNode]) return;
+
+			mvDistances[alNode] = afDistance;
+			mvCosts[alNode] = fCost;
+			mvParents[alNode] = alParent;
+			HeapSiftUp(mvHeapIndices[alNode]);
+			return;
+		}
+
+		mvGenerations[alNode] = mlGeneration;
+		mvDistances[alNode] = afDistance;
+		mvCosts[alNode] = fCost;
+		mvParents[alNode] = alParent;
+
+		mvHeapIndices[alNode] = (int)mvOpenHeap.size();
+		mvOpenHeap.push_back(alNode);
+		HeapSiftUp(mvHeapIndices[alNode]);
+	}
+
+	//-----------------------------------------------------------------------
+
+	int cAIPathSearch::PopBestNode()
+	{
+		int lBestNode = mvOpenHeap[0];
+		int lLastNode = mvOpenHeap.back();
+		mvOpenHeap.pop_back();
+		if(lLastNode != lBestNode)
+		{
+			mvOpenHeap[0] = lLastNode;
+			mvHeapIndices[lLastNode] = 0;
+			HeapSiftDown(0);
+		}
+
+		mvHeapIndices[lBestNode] = -1;
+		return lBestNode;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cAIPathSearch::HeapSiftUp(int alIdx)
+	{
+		int lNode = mvOpenHeap[alIdx];
+		while(alIdx > 0)
+		{
+			int lParent = (alIdx-1) / 2;
+			int lParentNode = mvOpenHeap[lParent];
+			if(mvCosts[lParentNode] <= mvCosts[lNode]) break;
+
+			mvOpenHeap[alIdx] = lParentNode;
+			mvHeapIndices[lParentNode] = alIdx;
+			alIdx = lParent;
+		}
+		mvOpenHeap[alIdx] = lNode;
+		mvHeapIndices[lNode] = alIdx;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cAIPathSearch::HeapSiftDown(int alIdx)
+	{
+		int lCount = (int)mvOpenHeap.size();
+		int lNode = mvOpenHeap[alIdx];
+		while(true)
+		{
+			int lChild = alIdx*2 + 1;
+			if(lChild >= lCount) break;
+
+			if(lChild+1 < lCount && mvCosts[mvOpenHeap[lChild+1]] < mvCosts[mvOpenHeap[lChild]]) ++lChild;
+
+			int lChildNode = mvOpenHeap[lChild];
+			if(mvCosts[lNode] <= mvCosts[lChildNode]) break;
+
+			mvOpenHeap[alIdx] = lChildNode;
+			mvHeapIndices[lChildNode] = alIdx;
+			alIdx = lChild;
+		}
+		mvOpenHeap[alIdx] = lNode;
+		mvHeapIndices[lNode] = alIdx;
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// CONSTRUCTORS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	cAIPathRequestQueue::cAIPathRequestQueue(cAINodeContainer *apContainer)
+	{
+		mpContainer = apContainer;
+		mpGraph = hplNew( cAINodeGraphSnapshot, (apContainer) );
+		mpMainSearch = hplNew( cAIPathSearch, (mpContainer, mpGraph) );
+
+		mlHandleCount = 0;
+		mlMaxRayChecksPerUpdate = 30;
+		mlMaxIterations = -1;
+		mlSearchNum = 0;
+
+		mpMutex = cPlatform::CreateMutEx();
+	}
+
+	//-----------------------------------------------------------------------
+
+	cAIPathRequestQueue::~cAIPathRequestQueue()
+	{
+		cJobManager *pJobManager = cJobManager::GetGlobal();
+		if(pJobManager) pJobManager->Wait(&mSolveJobCounter);
+
+		//All jobs are done, so all requests are in the map now.
+		STLMapDeleteAll(m_mapRequests);
+		STLDeleteAll(mvFreeSearches);
+
+		hplDelete(mpMainSearch);
+		hplDelete(mpMutex);
+		hplDelete(mpGraph);
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// PUBLIC METHODS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	int cAIPathRequestQueue::RequestPath(const cVector3f& avStart, const cVector3f& avGoal, int alPriority, iAStarCallback *apCallback)
+	{
+		cAIPathRequest *pRequest = hplNew( cAIPathRequest, () );
+		pRequest->mlHandle = ++mlHandleCount;
+		pRequest->mlPriority = alPriority;
+		pRequest->mlMaxIterations = mlMaxIterations;
+		pRequest->mpCallback = apCallback;
+		pRequest->mvStart = avStart;
+		pRequest->mvGoal = avGoal;
+		pRequest->mbRaysChecked = false;
+		pRequest->mbCancelled = false;
+		pRequest->mbFound = false;
+		pRequest->mState = eAIPathRequestState_Pending;
+
+		m_mapRequests.insert(tAIPathRequestMap::value_type(pRequest->mlHandle, pRequest));
+		mvWaitingRequests.push_back(pRequest);
+
+		return pRequest->mlHandle;
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool cAIPathRequestQueue::GetPath(const cVector3f& avStart, const cVector3f& avGoal, tAINodeList *apNodeList, iAStarCallback *apCallback)
+	{
+		cAIPathRequest request;
+		request.mlHandle = -1;
+		request.mlPriority = 0;
+		request.mlMaxIterations = mlMaxIterations;
+		request.mpCallback = apCallback;
+		request.mvStart = avStart;
+		request.mvGoal = avGoal;
+		request.mbRaysChecked = false;
+		request.mbCancelled = false;
+		request.mbFound = false;
+		request.mState = eAIPathRequestState_Pending;
+
+		CheckRequestRays(&request);
+		if(request.mState == eAIPathRequestState_Pending)
+		{
+			mpMainSearch->Solve(&request);
+			request.mState = request.mbFound ? eAIPathRequestState_Found : eAIPathRequestState_NotFound;
+		}
+
+		if(apNodeList)
+		{
+			for(size_t i=0; i<request.mvPath.size(); ++i)
+			{
+				apNodeList->push_back(mpContainer->GetNode(request.mvPath[i]));
+			}
+		}
+
+		return request.mState == eAIPathRequestState_Found;
+	}
+
+	//-----------------------------------------------------------------------
+
+	eAIPathRequestState cAIPathRequestQueue::GetRequestState(int alHandle)
+	{
+		tAIPathRequestMapIt it = m_mapRequests.find(alHandle);
+		if(it == m_mapRequests.end() || it->second->mbCancelled) return eAIPathRequestState_Invalid;
+
+		return it->second->mState;
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool cAIPathRequestQueue::GetRequestResult(int alHandle, tAINodeList *apNodeList)
+	{
+		tAIPathRequestMapIt it = m_mapRequests.find(alHandle);
+		if(it == m_mapRequests.end()) return false;
+
+		cAIPathRequest *pRequest = it->second;
+		if(pRequest->mbCancelled || pRequest->mState == eAIPathRequestState_Pending) return false;
+
+		bool bFound = pRequest->mState == eAIPathRequestState_Found;
+		if(apNodeList)
+		{
+			for(size_t i=0; i<pRequest->mvPath.size(); ++i)
+			{
+				apNodeList->push_back(mpContainer->GetNode(pRequest->mvPath[i]));
+			}
+		}
+
+		m_mapRequests.erase(it);
+		hplDelete(pRequest);
+
+		return bFound;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cAIPathRequestQueue::CancelRequest(int alHandle)
+	{
+		tAIPathRequestMapIt it = m_mapRequests.find(alHandle);
+		if(it == m_mapRequests.end()) return;
+
+		cAIPathRequest *pRequest = it->second;
+
+		//If it is being solved, it is deleted when collected in Update.
+		if(pRequest->mbRaysChecked && pRequest->mState == eAIPathRequestState_Pending)
+		{
+			pRequest->mbCancelled = true;
+			return;
+		}
+
+		STLFindAndRemove(mvWaitingRequests, pRequest);
+		m_mapRequests.erase(it);
+		hplDelete(pRequest);
+	}
+
+	//-----------------------------------------------------------------------
+
+	static bool SortFunc_RequestPriority(cAIPathRequest *apRequestA, cAIPathRequest *apRequestB)
+	{
+		if(apRequestA->mlPriority != apRequestB->mlPriority)
+			return apRequestA->mlPriority > apRequestB->mlPriority;
+
+		return apRequestA->mlHandle < apRequestB->mlHandle;
+	}
+
+	void cAIPathRequestQueue::Update()
+	{
+		////////////////////////////////
+		// Collect solved requests
+		tAIPathRequestVec vSolved;
+		mpMutex->Lock();
+		vSolved.swap(mvSolvedRequests);
+		mpMutex->Unlock();
+
+		for(size_t i=0; i<vSolved.size(); ++i)
+		{
+			cAIPathRequest *pRequest = vSolved[i];
+			if(pRequest->mbCancelled)
+			{
+				m_mapRequests.erase(pRequest->mlHandle);
+				hplDelete(pRequest);
+				continue;
+			}
+
+			pRequest->mState = pRequest->mbFound ? eAIPathRequestState_Found : eAIPathRequestState_NotFound;
+		}
+
+		////////////////////////////////
+		// Do ray checks for waiting requests, highest priority first
+		if(mvWaitingRequests.empty()) return;
+
+		std::stable_sort(mvWaitingRequests.begin(), mvWaitingRequests.end(), SortFunc_RequestPriority);
+
+		tAIPathRequestVec vToSolve;
+		int lRayChecks=0;
+		size_t lProcessed=0;
+		for(; lProcessed<mvWaitingRequests.size(); ++lProcessed)
+		{
+			if(lProcessed>0 && lRayChecks >= mlMaxRayChecksPerUpdate) break;
+
+			cAIPathRequest *pRequest = mvWaitingRequests[lProcessed];
+			lRayChecks += CheckRequestRays(pRequest);
+
+			if(pRequest->mState == eAIPathRequestState_Pending)
+				vToSolve.push_back(pRequest);
+		}
+		mvWaitingRequests.erase(mvWaitingRequests.begin(), mvWaitingRequests.begin()+lProcessed);
+
+		////////////////////////////////
+		// Solve requests with callbacks here, and add a job for each of the others.
+		// Without a job manager, everything is solved here.
+		cJobManager *pJobManager = cJobManager::GetGlobal();
+		if(pJobManager && mlSearchNum < pJobManager->GetWorkerNum()+1)
+		{
+			//One search for each thread that can run jobs. Created here, since allocation is not thread safe.
+			mpMutex->Lock();
+			for(; mlSearchNum < pJobManager->GetWorkerNum()+1; ++mlSearchNum)
+			{
+				mvFreeSearches.push_back(hplNew( cAIPathSearch, (mpContainer, mpGraph) ));
+			}
+			mpMutex->Unlock();
+		}
+
+		for(size_t i=0; i<vToSolve.size(); ++i)
+		{
+			cAIPathRequest *pRequest = vToSolve[i];
+			if(pJobManager==NULL || pRequest->mpCallback)
+			{
+				mpMainSearch->Solve(pRequest);
+				pRequest->mState = pRequest->mbFound ? eAIPathRequestState_Found : eAIPathRequestState_NotFound;
+				continue;
+			}
+
+			mpMutex->Lock();
+			mvSolveRequests.push_back(pRequest);
+			mpMutex->Unlock();
+
+			pJobManager->AddJob(SolveRequestJob, this, 0, 1, &mSolveJobCounter);
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// PRIVATE METHODS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	int cAIPathRequestQueue::CheckRequestRays(cAIPathRequest *apRequest)
+	{
+		//This is the physics part of cAStarHandler::GetPath
+		int lRayChecks=0;
+		apRequest->mbRaysChecked = true;
+
+		const cVector3f& vStart = apRequest->mvStart;
+		const cVector3f& vGoal = apRequest->mvGoal;
+		float fMaxHeight = mpContainer->GetMaxHeight()*1.5f;
+
+		/////////////////////////////////////////////////
+		// check if there is free path from start to goal
+		float fHeight = fabs(vStart.y - vGoal.y);
+		if(fHeight <= fMaxHeight)
+		{
+			++lRayChecks;
+			if(mpContainer->FreePath(vStart,vGoal,-1,eAIFreePathFlag_SkipDynamic))
+			{
+				apRequest->mState = eAIPathRequestState_Found;
+				return lRayChecks;
+			}
+		}
+
+		float fMaxDist = mpContainer->GetMaxEdgeDistance()*2;
+
+		/////////////////////
+		//Check with Start
+		cAINodeIterator startNodeIt =  mpContainer->GetNodeIterator(vStart,fMaxDist);
+		while(startNodeIt.HasNext())
+		{
+			cAINode *pAINode = startNodeIt.Next();
+
+			float fNodeHeight = fabs(vStart.y - pAINode->GetPosition().y);
+			float fDist = cMath::Vector3Dist(vStart,pAINode->GetPosition());
+			if(fDist < fMaxDist && fNodeHeight <= fMaxHeight)
+			{
+				++lRayChecks;
+				if(mpContainer->FreePath(vStart,pAINode->GetPosition(),-1,eAIFreePathFlag_SkipDynamic))
+				{
+					apRequest->mvStartNodes.push_back(pAINode->GetIndex());
+					apRequest->mvStartDistances.push_back(fDist);
+				}
+			}
+		}
+
+		/////////////////////
+		//Check with Goal
+		cAINodeIterator goalNodeIt =  mpContainer->GetNodeIterator(vGoal,fMaxDist);
+		while(goalNodeIt.HasNext())
+		{
+			cAINode *pAINode = goalNodeIt.Next();
+
+			float fNodeHeight = fabs(vGoal.y - pAINode->GetPosition().y);
+			float fDist = cMath::Vector3Dist(vGoal,pAINode->GetPosition());
+			if(fDist < fMaxDist && fNodeHeight <= fMaxHeight)
+			{
+				++lRayChecks;
+				if(mpContainer->FreePath(vGoal,pAINode->GetPosition(),-1,eAIFreePathFlag_SkipDynamic))
+				{
+					apRequest->mvGoalNodes.push_back(pAINode->GetIndex());
+				}
+			}
+		}
+
+		//No need to search if there is nothing to start from or reach.
+		if(apRequest->mvStartNodes.empty() || apRequest->mvGoalNodes.empty())
+		{
+			apRequest->mState = eAIPathRequestState_NotFound;
+		}
+
+		return lRayChecks;
+	}
+
+	//-----------------------------------------------------------------------
+
+	cAIPathRequest* cAIPathRequestQueue::PopSolveRequest()
+	{
+		cAIPathRequest *pRequest = NULL;
+
+		mpMutex->Lock();
+		if(mvSolveRequests.empty()==false)
+		{
+			pRequest = mvSolveRequests.front();
+			mvSolveRequests.erase(mvSolveRequests.begin());
+		}
+		mpMutex->Unlock();
+
+		return pRequest;
+	}
+
+	//-----------------------------------------------------------------------
+
+	/**
+	 * Returns a free search. If there is none, the request is put first in the queue again and NULL is returned.
+	 * All searches are then used by jobs, and these pick the request up when done (see AddSolvedAndPopNext).
+	 */
+	cAIPathSearch* cAIPathRequestQueue::PopSearchOrRequeue(cAIPathRequest *apRequest)
+	{
+		cAIPathSearch *pSearch = NULL;
+
+		mpMutex->Lock();
+		if(mvFreeSearches.empty()==false)
+		{
+			pSearch = mvFreeSearches.back();
+			mvFreeSearches.pop_back();
+		}
+		else
+		{
+			//Happens when more threads than searches run jobs, e.g. when another thread helps out in cJobManager::Wait.
+			if(mlSearchNum==0) Error("No path searches created, request %d will not be solved!\n", apRequest->mlHandle);
+
+			mvSolveRequests.insert(mvSolveRequests.begin(), apRequest);
+		}
+		mpMutex->Unlock();
+
+		return pSearch;
+	}
+
+	//-----------------------------------------------------------------------
+
+	/**
+	 * Adds the solved request and returns the next request to solve with the search. If there is none, the search is
+	 * given back and NULL is returned. Done in one lock, so a request put back by PopSearchOrRequeue is never missed.
+	 */
+	cAIPathRequest* cAIPathRequestQueue::AddSolvedAndPopNext(cAIPathRequest *apRequest, cAIPathSearch *apSearch)
+	{
+		cAIPathRequest *pNextRequest = NULL;
+
+		mpMutex->Lock();
+		mvSolvedRequests.push_back(apRequest);
+
+		if(mvSolveRequests.empty()==false)
+		{
+			pNextRequest = mvSolveRequests.front();
+			mvSolveRequests.erase(mvSolveRequests.begin());
+		}
+		else
+		{
+			mvFreeSearches.push_back(apSearch);
+		}
+		mpMutex->Unlock();
+
+		return pNextRequest;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cAIPathRequestQueue::SolveRequestJob(void *apData, int alStart, int alEnd)
+	{
+		cAIPathRequestQueue *pQueue = static_cast<cAIPathRequestQueue*>(apData);
+
+		//Each job solves one request, which one does not matter since they are queued in priority order.
+		cAIPathRequest *pRequest = pQueue->PopSolveRequest();
+		if(pRequest==NULL) return;
+
+		cAIPathSearch *pSearch = pQueue->PopSearchOrRequeue(pRequest);
+		if(pSearch==NULL) return;
+
+		//Keep solving while there are requests, since some might have been put back by jobs without a search.
+		while(pRequest)
+		{
+			pSearch->Solve(pRequest);
+			pRequest = pQueue->AddSolvedAndPopNext(pRequest, pSearch);
+		}
+	}
+
+	//-----------------------------------------------------------------------
+}
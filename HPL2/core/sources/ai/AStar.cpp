@@ -34,17 +34,26 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
-	cAStarNode::cAStarNode(cAINode *apAINode)
+	cAStarNode::cAStarNode()
 	{
+		mfCost = 0;
+		mfDistance = 0;
 		mpParent = NULL;
-		mpAINode = apAINode;
+		mpAINode = NULL;
+		mlGeneration = 0;
+		mlGoalGeneration = 0;
+		mlHeapIndex = -1;
 	}
 
-	//-----------------------------------------------------------------------
-
-	bool cAStarNodeCompare::operator()(cAStarNode* apNodeA,cAStarNode* apNodeB) const
+	cAStarNode::cAStarNode(cAINode *apAINode)
 	{
-		return apNodeA->mpAINode < apNodeB->mpAINode;
+		mfCost = 0;
+		mfDistance = 0;
+		mpParent = NULL;
+		mpAINode = apAINode;
+		mlGeneration = 0;
+		mlGoalGeneration = 0;
+		mlHeapIndex = -1;
 	}
 
 
@@ -63,14 +72,15 @@ namespace hpl {
 		mpContainer = apContainer;
 
 		mpCallback = NULL;
+
+		mpGoalNode = NULL;
+		mlGeneration = 0;
 	}
 
 	//-----------------------------------------------------------------------
 
 	cAStarHandler::~cAStarHandler()
 	{
-		STLDeleteAll(m_setClosedList);
-		STLDeleteAll(m_setOpenList);
 	}
 
 	//-----------------------------------------------------------------------
@@ -96,10 +106,8 @@ namespace hpl {
 
 		////////////////////////////////////////////////
 		//Reset all variables
-		//These should just be cleared and pools used instead.
-		STLDeleteAll(m_setClosedList);
-		STLDeleteAll(m_setOpenList);
-		m_setGoalNodes.clear();
+		SetupNodes();
+		mvOpenHeap.resize(0);
 		mpGoalNode=NULL;
 
 		//Set goal position
@@ -148,7 +156,7 @@ namespace hpl {
 				//Check if path is clear
 				if(mpContainer->FreePath(avGoal,pAINode->GetPosition(),-1, eAIFreePathFlag_SkipDynamic))
 				{
-					m_setGoalNodes.insert(pAINode);
+					GetNode(pAINode)->mlGoalGeneration = mlGeneration;
 				}
 			}
 		}
@@ -182,7 +190,7 @@ namespace hpl {
 				//Check if path is clear
 				if(mpContainer->FreePath(avGoal,pAINode->GetPosition(),3))
 				{
-					m_setGoalNodes.insert(pAINode);
+					GetNode(pAINode)->mlGoalGeneration = mlGeneration;
 				}
 			}
 		}*/
@@ -224,7 +232,7 @@ namespace hpl {
 	void cAStarHandler::IterateAlgorithm()
 	{
 		int lIterationCount=0;
-		while(m_setOpenList.empty()==false && (mlMaxIterations <0 || lIterationCount < mlMaxIterations))
+		while(mvOpenHeap.empty()==false && (mlMaxIterations <0 || lIterationCount < mlMaxIterations))
 		{
 			cAStarNode *pNode = GetBestNode();
 			cAINode *pAINode = pNode->mpAINode;
@@ -262,54 +270,128 @@ namespace hpl {
 	{
 		//TODO: free path check with dynamic objects here.
 
-		//TODO: Some pooling here would be good.
-		cAStarNode *pNode = hplNew( cAStarNode, (apAINode) );
+		cAStarNode *pNode = GetNode(apAINode);
+		float fCost = Cost(afDistance,apAINode,apParent) + Heuristic(apAINode->GetPosition(), mvGoal);
 
-		//Check if it is in closed list.
-		tAStarNodeSetIt it = m_setClosedList.find(pNode);
-		if(it != m_setClosedList.end()){
-			hplDelete(pNode);
-			return;
-		}
+		//////////////////////
+		// Already visited
+		if(pNode->mlGeneration == mlGeneration)
+		{
+			//In closed list, skip.
+			if(pNode->mlHeapIndex < 0) return;
+
+			//In open list, only update if the new path is better.
+			if(fCost >= pNode->mfCost) return;
 
-		//Try to add it to the open list
-		std::pair<tAStarNodeSetIt, bool> testPair = m_setOpenList.insert(pNode);
-		if(testPair.second == false){
-			hplDelete(pNode);
+			pNode->mfDistance = afDistance;
+			pNode->mfCost = fCost;
+			pNode->mpParent = apParent;
+			HeapSiftUp(pNode->mlHeapIndex);
 			return;
 		}
 
+		//////////////////////
+		// Add to open list
+		pNode->mlGeneration = mlGeneration;
 		pNode->mfDistance = afDistance;
-		pNode->mfCost = Cost(afDistance,apAINode,apParent) + Heuristic(pNode->mpAINode->GetPosition(), mvGoal);
+		pNode->mfCost = fCost;
 		pNode->mpParent = apParent;
+
+		pNode->mlHeapIndex = (int)mvOpenHeap.size();
+		mvOpenHeap.push_back(pNode);
+		HeapSiftUp(pNode->mlHeapIndex);
 	}
 
 	//-----------------------------------------------------------------------
 
 	cAStarNode* cAStarHandler::GetBestNode()
 	{
-		tAStarNodeSetIt it = m_setOpenList.begin();
-		tAStarNodeSetIt bestIt = it;
-		cAStarNode* pBestNode = *it; ++it;
+		cAStarNode* pBestNode = mvOpenHeap[0];
+
+		//Remove node from open, moving the last node to the top
+		cAStarNode* pLastNode = mvOpenHeap.back();
+		mvOpenHeap.pop_back();
+		if(pLastNode != pBestNode)
+		{
+			mvOpenHeap[0] = pLastNode;
+			pLastNode->mlHeapIndex = 0;
+			HeapSiftDown(0);
+		}
+
+		//Add to closed list
+		pBestNode->mlHeapIndex = -1;
 
-		//Iterate open list and find the best node.
-		for(; it != m_setOpenList.end(); ++it)
+		return pBestNode;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cAStarHandler::SetupNodes()
+	{
+		//Make sure there is a node for every AI node. Only done when nodes are added to the container.
+		int lNodeNum = mpContainer->GetNodeNum();
+		if((int)mvNodes.size() != lNodeNum)
 		{
-			cAStarNode *pNode = *it;
-			if(pBestNode->mfCost > pNode->mfCost)
+			mvNodes.resize(lNodeNum);
+			for(int i=0; i<lNodeNum; ++i)
 			{
-				pBestNode = pNode;
-				bestIt = it;
+				mvNodes[i] = cAStarNode(mpContainer->GetNode(i));
 			}
+			mlGeneration = 0;
 		}
 
-		//Remove node from open
-		m_setOpenList.erase(bestIt);
+		//New generation, this resets all nodes without touching them
+		++mlGeneration;
+	}
 
-		//Add to closed list
-		m_setClosedList.insert(pBestNode);
+	//-----------------------------------------------------------------------
 
-		return pBestNode;
+	cAStarNode* cAStarHandler::GetNode(cAINode *apAINode)
+	{
+		return &mvNodes[apAINode->GetIndex()];
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cAStarHandler::HeapSiftUp(int alIdx)
+	{
+		cAStarNode *pNode = mvOpenHeap[alIdx];
+		while(alIdx > 0)
+		{
+			int lParent = (alIdx-1) / 2;
+			cAStarNode *pParentNode = mvOpenHeap[lParent];
+			if(pParentNode->mfCost <= pNode->mfCost) break;
+
+			mvOpenHeap[alIdx] = pParentNode;
+			pParentNode->mlHeapIndex = alIdx;
+			alIdx = lParent;
+		}
+		mvOpenHeap[alIdx] = pNode;
+		pNode->mlHeapIndex = alIdx;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cAStarHandler::HeapSiftDown(int alIdx)
+	{
+		int lCount = (int)mvOpenHeap.size();
+		cAStarNode *pNode = mvOpenHeap[alIdx];
+		while(true)
+		{
+			int lChild = alIdx*2 + 1;
+			if(lChild >= lCount) break;
+
+			if(lChild+1 < lCount && mvOpenHeap[lChild+1]->mfCost < mvOpenHeap[lChild]->mfCost) ++lChild;
+
+			cAStarNode *pChildNode = mvOpenHeap[lChild];
+			if(pNode->mfCost <= pChildNode->mfCost) break;
+
+			mvOpenHeap[alIdx] = pChildNode;
+			pChildNode->mlHeapIndex = alIdx;
+			alIdx = lChild;
+		}
+		mvOpenHeap[alIdx] = pNode;
+		pNode->mlHeapIndex = alIdx;
 	}
 
 	//-----------------------------------------------------------------------
@@ -337,10 +419,7 @@ namespace hpl {
 
 	bool cAStarHandler::IsGoalNode(cAINode *apAINode)
 	{
-		tAINodeSetIt it = m_setGoalNodes.find(apAINode);
-		if(it == m_setGoalNodes.end()) return false;
-
-		return true;
+		return GetNode(apAINode)->mlGoalGeneration == mlGeneration;
 	}
 
 	//-----------------------------------------------------------------------
@@ -35,6 +35,7 @@
 #include "system/Platform.h"
 #include "system/Timer.h"
 #include "system/Mutex.h"
+#include "system/Profiler.h"
 
 #include "input/Input.h"
 #include "input/Mouse.h"
@@ -168,6 +169,7 @@ namespace hpl {
 		switch(aApi)
 		{
 			case eHplAPI_OpenGL: pGameSetup = hplNew(cSDLEngineSetup, (alHplModuleFlags) ); break;
+			case eHplAPI_Null: pGameSetup = hplNew(cSDLEngineSetup, (alHplModuleFlags, true) ); break;
 		}
 
 		return hplNew( cEngine,  (pGameSetup,alHplModuleFlags, apVars) );
@@ -195,6 +197,8 @@ namespace hpl {
 
 	cEngine::cEngine(iLowLevelEngineSetup *apGameSetup,tFlag alHplSetupFlags, cEngineInitVars *apVars)
 	{
+		cProfiler::Init();
+
 		GameInit(apGameSetup,alHplSetupFlags, apVars);
 
 		//Set up variables
@@ -232,6 +236,9 @@ namespace hpl {
 		Log(" Creating system module\n");
 		mpSystem = mpGameSetup->CreateSystem();
 
+		//The job manager is created right away, since the other modules might use it when created.
+		mpSystem->Init(apVars->mSystem.mlJobWorkerNum);
+
 		Log(" Creating resource module\n");
 		mpResources = mpGameSetup->CreateResources(mpGraphics);
 
@@ -388,6 +395,8 @@ namespace hpl {
 		Log(" Deleting game setup provided by user\n");
 		hplDelete(mpGameSetup);
 
+		cProfiler::Exit();
+
 		Log("HPL Exit was successful!\n");
 	}
 
@@ -429,6 +438,11 @@ namespace hpl {
 
 		while(!GetGameIsDone())
 		{
+			//////////////////////////
+			//Start a new profiler frame, the zone covers this iteration of the loop.
+			cProfiler::NewFrame();
+			PROFILE_ZONE(Frame)
+
 			//////////////////////////
 			//Check if application is in focus.
 			if(mbWaitIfAppOutOfFocus) CheckIfAppInFocusElseWait();
@@ -447,6 +461,7 @@ namespace hpl {
 			{
 				//////////////////////////
 				//Update logic.
+				PROFILE_BEGIN(Logic)
 				while(mpLogicTimer->WantUpdate() && !GetGameIsDone())
 				{
 					/////////////////////////////////////////////
@@ -486,6 +501,7 @@ namespace hpl {
 					mfGameTime += GetStepSize();
 				}
 				mpLogicTimer->EndUpdateLoop();
+				PROFILE_END(Logic)
 			}
 
 			//if(GetGameIsDone()) Log("1\n");
@@ -504,13 +520,13 @@ namespace hpl {
 			if(bBufferSwap)
 			{
 				bBufferSwap = false;
-				START_TIMING(WaitAndFinishRendering)
+				PROFILE_BEGIN(WaitAndFinishRendering)
 				//mpGraphics->GetLowLevel()->WaitAndFinishRendering();
-				STOP_TIMING(WaitAndFinishRendering)
+				PROFILE_END(WaitAndFinishRendering)
 
-				START_TIMING(SwapBuffers)
+				PROFILE_BEGIN(SwapBuffers)
 				mpGraphics->GetLowLevel()->SwapBuffers();
-				STOP_TIMING(SwapBuffers)
+				PROFILE_END(SwapBuffers)
 
 				//Log("Swap done: %d\n", cPlatform::GetApplicationTime());
 				mpUpdater->RunMessage(eUpdateableMessage_OnPostBufferSwap);
@@ -529,22 +545,22 @@ namespace hpl {
 				UpdateFrameTimer();
 
 				//On draw callback sending that to gui, etc
-				START_TIMING(OnDraw)
+				PROFILE_BEGIN(OnDraw)
 				mpUpdater->RunMessage(eUpdateableMessage_OnDraw, mfFrameTime);
-				STOP_TIMING(OnDraw)
+				PROFILE_END(OnDraw)
 
 				//Render this frame
-				START_TIMING(RenderAll)
+				PROFILE_BEGIN(RenderAll)
 				mpScene->Render(mfFrameTime, tSceneRenderFlag_All);
-				STOP_TIMING(RenderAll)
+				PROFILE_END(RenderAll)
 
-				START_TIMING(PostRender)
+				PROFILE_BEGIN(PostRender)
 				mpUpdater->RunMessage(eUpdateableMessage_OnPostRender, mfFrameTime);
-				STOP_TIMING(PostRender)
+				PROFILE_END(PostRender)
 
-				START_TIMING(FlushRender)
+				PROFILE_BEGIN(FlushRender)
 				mpGraphics->GetLowLevel()->FlushRendering();
-				STOP_TIMING(FlushRender)
+				PROFILE_END(FlushRender)
 
 				//Update fps counter.
 				mpFPSCounter->AddFrame();
@@ -22,6 +22,7 @@
 #include "engine/Updateable.h"
 #include "system/LowLevelSystem.h"
 #include "system/Platform.h"
+#include "system/Profiler.h"
 
 namespace hpl {
 
@@ -76,13 +77,39 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	static const char* gvUpdateableMessageNames[eUpdateableMessage_LastEnum] =
+	{
+		"OnPostBufferSwap",
+		"OnStart",
+		"OnDraw",
+		"OnPostRender",
+		"PreUpdate",
+		"Update",
+		"PostUpdate",
+		"OnQuit",
+		"OnExit",
+		"Reset",
+		"OnPauseUpdate",
+		"AppGotInputFocus",
+		"AppGotMouseFocus",
+		"AppGotVisibility",
+		"AppLostInputFocus",
+		"AppLostMouseFocus",
+		"AppLostVisibility",
+		"AppDeviceWasPlugged",
+		"AppDeviceWasRemoved",
+	};
+
 	void cUpdater::RunMessage(eUpdateableMessage aMessage, float afX)
 	{
+		PROFILE_ZONE_EX(gvUpdateableMessageNames[aMessage], message)
+
 		if(aMessage != eUpdateableMessage_Update)
 		{
 			for(tUpdateableListIt it = mlstGlobalUpdateableList.begin();it!=mlstGlobalUpdateableList.end();++it)
 			{
 				iUpdateable *pUpdateable = *it;
+				PROFILE_ZONE_EX(pUpdateable->GetProfileZoneName(), game)
 				pUpdateable->RunMessage(aMessage, afX);
 			}
 
@@ -92,7 +119,10 @@ namespace hpl {
 				for(tUpdateableListIt it = mpCurrentUpdates->begin();it!=mpCurrentUpdates->end();++it)
 				{
 					iUpdateable *pUpdateable = *it;
-					pUpdateable->RunMessage(aMessage, afX);
+					{
+						PROFILE_ZONE_EX(pUpdateable->GetProfileZoneName(), game)
+						pUpdateable->RunMessage(aMessage, afX);
+					}
 
 					//In case the container is change, do not do any more updating.
 					if(mpCurrentUpdates != pCurrentUpdateContainer) break;;
@@ -107,9 +137,8 @@ namespace hpl {
 				//Log("pUpdateable %d, ", pUpdateable);
 				//Log("'%s'\n", pUpdateable->GetName().c_str());
 
-				START_TIMING_EX(pUpdateable->GetName().c_str(),game)
+				PROFILE_ZONE_EX(pUpdateable->GetProfileZoneName(), game)
 				pUpdateable->RunMessage(aMessage, afX);
-				STOP_TIMING(game)
 			}
 
 			if(mpCurrentUpdates)
@@ -121,9 +150,10 @@ namespace hpl {
 					//Log("pUpdateable %d, ", pUpdateable);
 					//Log("'%s'\n", pUpdateable->GetName().c_str());
 
-					START_TIMING_EX(pUpdateable->GetName().c_str(),game)
-					pUpdateable->RunMessage(aMessage, afX);
-					STOP_TIMING(game)
+					{
+						PROFILE_ZONE_EX(pUpdateable->GetProfileZoneName(), game)
+						pUpdateable->RunMessage(aMessage, afX);
+					}
 
 					//In case the container is change, do not do any more updating.
 					if(mpCurrentUpdates != pCurrentUpdateContainer) break;;
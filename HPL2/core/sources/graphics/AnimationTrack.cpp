@@ -24,6 +24,8 @@
 #include "system/LowLevelSystem.h"
 #include "scene/Node3D.h"
 
+#include <algorithm>
+
 namespace hpl {
 
 	//////////////////////////////////////////////////////////////////////////
@@ -48,7 +50,6 @@ namespace hpl {
 
 	cAnimationTrack::~cAnimationTrack()
 	{
-		STLDeleteAll(mvKeyFrames);
 	}
 
 	//-----------------------------------------------------------------------
@@ -62,52 +63,63 @@ namespace hpl {
 	void cAnimationTrack::ResizeKeyFrames(int alSize)
 	{
 		mvKeyFrames.reserve(alSize);
+		mvKeyFrameTimes.reserve(alSize);
 	}
 
 	//-----------------------------------------------------------------------
 
 	cKeyFrame* cAnimationTrack::CreateKeyFrame(float afTime)
 	{
-		cKeyFrame* pFrame = hplNew( cKeyFrame,());
-		pFrame->time = afTime;
+		cKeyFrame Frame;
+		Frame.time = afTime;
 
-		//Check so that this is the first
+		//Check so that this is the last
         if(afTime > mfMaxFrameTime || mvKeyFrames.empty())
 		{
-			mvKeyFrames.push_back(pFrame);
+			mvKeyFrames.push_back(Frame);
+			mvKeyFrameTimes.push_back(afTime);
 			mfMaxFrameTime = afTime;
+
+			return &mvKeyFrames.back();
 		}
-		else
-		{
-			tKeyFramePtrVecIt it = mvKeyFrames.begin();
-			for(; it != mvKeyFrames.end(); it++)
-			{
-				if(afTime < (*it)->time)
-				{
-					break;
-				}
-			}
-			mvKeyFrames.insert(it,pFrame);
-		}
 
-        return pFrame;
+		//Insert after all frames with the same or lower time
+		size_t lIdx = std::upper_bound(mvKeyFrameTimes.begin(), mvKeyFrameTimes.end(), afTime) - mvKeyFrameTimes.begin();
+		mvKeyFrames.insert(mvKeyFrames.begin() + lIdx, Frame);
+		mvKeyFrameTimes.insert(mvKeyFrameTimes.begin() + lIdx, afTime);
+
+        return &mvKeyFrames[lIdx];
 	}
 
 	//-----------------------------------------------------------------------
 
 	void cAnimationTrack::ClearKeyFrames()
 	{
-		STLDeleteAll(mvKeyFrames);
 		mvKeyFrames.clear();
+		mvKeyFrameTimes.clear();
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cAnimationTrack::ApplyToNode(cNode3D* apNode, float afTime, float afWeight, bool bLoop, int *apCursor)
+	{
+		if(mvKeyFrames.empty()) return;
+
+		cQuaternion qRot = cQuaternion::Identity;
+		cVector3f vTrans(0);
+		ApplyToPose(qRot, vTrans, afTime, afWeight, apCursor);
+
+		apNode->AddRotation(qRot);
+		apNode->AddTranslation(vTrans);
 	}
 
 	//-----------------------------------------------------------------------
 
-	void cAnimationTrack::ApplyToNode(cNode3D* apNode, float afTime, float afWeight, bool bLoop)
+	void cAnimationTrack::ApplyToPose(cQuaternion& aqRotation, cVector3f& avTranslation, float afTime, float afWeight, int *apCursor)
 	{
 		if(mvKeyFrames.empty()) return;
 
-		cKeyFrame Frame = GetInterpolatedKeyFrame(afTime);
+		cKeyFrame Frame = GetInterpolatedKeyFrame(afTime, true, apCursor);
 
 		//Scale
 		//Skip this for now...
@@ -117,16 +129,15 @@ namespace hpl {
 
 		//Rotation
 		cQuaternion qRot = cMath::QuaternionSlerp(afWeight, cQuaternion::Identity, Frame.rotation, true);
-		apNode->AddRotation(qRot);
+		aqRotation = cMath::QuaternionMul(qRot, aqRotation);
 
 		//Translation
-		cVector3f vTrans = Frame.trans * afWeight;
-		apNode->AddTranslation(vTrans);
+		avTranslation += Frame.trans * afWeight;
 	}
 
 	//-----------------------------------------------------------------------
 
-	cKeyFrame cAnimationTrack::GetInterpolatedKeyFrame(float afTime, bool bLoop)
+	cKeyFrame cAnimationTrack::GetInterpolatedKeyFrame(float afTime, bool bLoop, int *apCursor)
 	{
 		cKeyFrame ResultKeyFrame;
 		ResultKeyFrame.time = afTime;
@@ -141,7 +152,7 @@ namespace hpl {
 		cKeyFrame *pKeyFrameA = NULL;
 		cKeyFrame *pKeyFrameB = NULL;
 
-		float fT = GetKeyFramesAtTime(afTime, &pKeyFrameA, &pKeyFrameB, bLoop);
+		float fT = GetKeyFramesAtTime(afTime, &pKeyFrameA, &pKeyFrameB, bLoop, apCursor);
 
 
         if(fT == 0.0f)
@@ -201,7 +212,7 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
-	float cAnimationTrack::GetKeyFramesAtTime(float afTime, cKeyFrame** apKeyFrameA,cKeyFrame** apKeyFrameB, bool bLoop)
+	float cAnimationTrack::GetKeyFramesAtTime(float afTime, cKeyFrame** apKeyFrameA,cKeyFrame** apKeyFrameB, bool bLoop, int *apCursor)
 	{
 		float fTotalAnimLength = mpParent->GetLength();
 
@@ -214,8 +225,8 @@ namespace hpl {
 		//If longer than max time return last frame and first
 		if(afTime >= mfMaxFrameTime)
 		{
-			*apKeyFrameA = mvKeyFrames[mvKeyFrames.size()-1];
-			*apKeyFrameB = mvKeyFrames[0];
+			*apKeyFrameA = &mvKeyFrames[mvKeyFrames.size()-1];
+			*apKeyFrameB = &mvKeyFrames[0];
 
 			//Get T between end to start again. (the last frame doesn't mean the anim is over.
 			// In that case wrap to the first frame).
@@ -226,36 +237,25 @@ namespace hpl {
 			return 0.0f;//(afTime - (*apKeyFrameA)->time) / fDeltaT;
 		}
 
-		//Get the number of frames
-		const int lSize = (int)mvKeyFrames.size();
-
 		//Find the second frame.
-		int lIdxB=-1;
-		for(int i=0; i< lSize; i++)
-		{
-			if(afTime <= mvKeyFrames[i]->time)
-			{
-				lIdxB = i;
-				break;
-			}
-		}
+		int lIdxB = FindKeyFrameAfter(afTime, apCursor);
 
 		//If first frame was found, the lowest time is not 0.
 		//If so return the first frame only.
 		if(lIdxB == 0)
 		{
-			*apKeyFrameA = mvKeyFrames[0];
-			*apKeyFrameB = mvKeyFrames[0];
+			*apKeyFrameA = &mvKeyFrames[0];
+			*apKeyFrameB = &mvKeyFrames[0];
 			return 0.0f;
 		}
 
 		//Get the frames
-		*apKeyFrameA = mvKeyFrames[lIdxB-1];
-		*apKeyFrameB = mvKeyFrames[lIdxB];
+		*apKeyFrameA = &mvKeyFrames[lIdxB-1];
+		*apKeyFrameB = &mvKeyFrames[lIdxB];
 
-		float fDeltaT = (*apKeyFrameB)->time - (*apKeyFrameA)->time;
+		float fDeltaT = mvKeyFrameTimes[lIdxB] - mvKeyFrameTimes[lIdxB-1];
 
-		return (afTime - (*apKeyFrameA)->time) / fDeltaT;
+		return (afTime - mvKeyFrameTimes[lIdxB-1]) / fDeltaT;
 	}
 
 	//-----------------------------------------------------------------------
@@ -352,5 +352,33 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	int cAnimationTrack::FindKeyFrameAfter(float afTime, int *apCursor)
+	{
+		const int lSize = (int)mvKeyFrameTimes.size();
+
+		////////////////////////////
+		//Check the frame found last time and the one after it, one of these is it when the animation is played.
+		if(apCursor)
+		{
+			int lIdx = *apCursor;
+			for(int i=0; i<2 && lIdx>=0 && lIdx<lSize; ++i, ++lIdx)
+			{
+				if(afTime <= mvKeyFrameTimes[lIdx] && (lIdx==0 || afTime > mvKeyFrameTimes[lIdx-1]))
+				{
+					*apCursor = lIdx;
+					return lIdx;
+				}
+			}
+		}
+
+		////////////////////////////
+		//Search for the first frame with a time equal to or after time.
+		int lIdx = (int)(std::lower_bound(mvKeyFrameTimes.begin(), mvKeyFrameTimes.end(), afTime) - mvKeyFrameTimes.begin());
+		if(lIdx >= lSize) lIdx = lSize-1;
+
+		if(apCursor) *apCursor = lIdx;
+		return lIdx;
+	}
+
 	//-----------------------------------------------------------------------
 }
\ No newline at end of file
@@ -34,6 +34,7 @@
 #include "math/Frustum.h"
 
 #include <algorithm>
+#include <string.h>
 
 namespace hpl {
 
@@ -226,6 +227,12 @@ namespace hpl {
 		{
 			mvSortedArrays[i].resize(0);
 		}
+
+		mProgramIds.Clear();
+		mTextureIds.Clear();
+		mTextureSetIds.Clear();
+		mVertexBufferIds.Clear();
+		mMatrixIds.Clear();
 	}
 
 	//-----------------------------------------------------------------------
@@ -284,177 +291,248 @@ namespace hpl {
 	//-----------------------------------------------------------------------
 
 	//////////////////////////////////////////////////////////////////////////
-	// PRIVATE METHODS
+	// ID MAP
 	//////////////////////////////////////////////////////////////////////////
 
 	//-----------------------------------------------------------------------
 
-	static bool SortFunc_Z(iRenderable* apObjectA, iRenderable *apObjectB)
+	static inline uint64_t HashSortValue(uint64_t alX)
 	{
-		cMaterial *pMatA = apObjectA->GetMaterial();
-		cMaterial *pMatB = apObjectB->GetMaterial();
-
-		//////////////////////////
-		//Alpha mode
-		if(pMatA->GetAlphaMode() != pMatB->GetAlphaMode())
-		{
-			return pMatA->GetAlphaMode() < pMatB->GetAlphaMode();
-		}
+		alX ^= alX >> 33;
+		alX *= 0xff51afd7ed558ccdULL;
+		alX ^= alX >> 33;
+		alX *= 0xc4ceb9fe1a85ec53ULL;
+		alX ^= alX >> 33;
+		return alX;
+	}
 
-		//////////////////////////
-		//If alpha, sort by texture (we know alpha is same for both materials, so can just test one)
-		if(	pMatA->GetAlphaMode() == eMaterialAlphaMode_Trans )
-		{
-			if(pMatA->GetProgram(0,eMaterialRenderMode_Z) != pMatB->GetProgram(0,eMaterialRenderMode_Z))
-			{
-				return pMatA->GetProgram(0,eMaterialRenderMode_Z) < pMatB->GetProgram(0,eMaterialRenderMode_Z);
-			}
+	//-----------------------------------------------------------------------
 
-			if(pMatA->GetTexture(eMaterialTexture_Diffuse) != pMatB->GetTexture(eMaterialTexture_Diffuse))
-			{
-				return pMatA->GetTexture(eMaterialTexture_Diffuse) < pMatB->GetTexture(eMaterialTexture_Diffuse);
-			}
-		}
+	cRenderListIdMap::cRenderListIdMap()
+	{
+		mlGeneration = 1;
+		mlCount = 0;
 
-		//////////////////////////
-		//View space depth, no need to test further since Z should almost never be the same for two objects.
-		// use ">" since we want to render things closest to the screen first.
-		return apObjectA->GetViewSpaceZ() > apObjectB->GetViewSpaceZ();
-		//return apObjectA < apObjectB;
+		mvKeys.resize(256);
+		mvIds.resize(256);
+		mvGenerations.resize(256, 0);
 	}
 
 	//-----------------------------------------------------------------------
 
-	static bool SortFunc_Diffuse(iRenderable* apObjectA, iRenderable *apObjectB)
+	void cRenderListIdMap::Clear()
 	{
-		cMaterial *pMatA = apObjectA->GetMaterial();
-		cMaterial *pMatB = apObjectB->GetMaterial();
-
-		//////////////////////////
-		//Program
-		if(pMatA->GetProgram(0,eMaterialRenderMode_Diffuse) != pMatB->GetProgram(0,eMaterialRenderMode_Diffuse))
+		//Bumping the generation invalidates all slots without touching them.
+		++mlGeneration;
+		mlCount = 0;
+		if(mlGeneration==0)
 		{
-			return pMatA->GetProgram(0,eMaterialRenderMode_Diffuse) < pMatB->GetProgram(0,eMaterialRenderMode_Diffuse);
+			std::fill(mvGenerations.begin(), mvGenerations.end(), 0);
+			mlGeneration = 1;
 		}
+	}
 
-		//////////////////////////
-		//Texture
-		for(int i=0;i<kMaxTextureUnits; ++i)
-		{
-			iTexture *pTexA = pMatA->GetTextureInUnit(eMaterialRenderMode_Diffuse,i);
-			iTexture *pTexB = pMatB->GetTextureInUnit(eMaterialRenderMode_Diffuse,i);
-			if(pTexA != pTexB) return pTexA < pTexB;
-		}
+	//-----------------------------------------------------------------------
 
-		//////////////////////////
-		//Vertex buffer
-        if(apObjectA->GetVertexBuffer() != apObjectB->GetVertexBuffer())
-		{
-			return apObjectA->GetVertexBuffer() < apObjectB->GetVertexBuffer();
-		}
+	unsigned int cRenderListIdMap::GetId(const void *apPtr)
+	{
+		return GetId((uint64_t)(size_t)apPtr);
+	}
 
-		//////////////////////////
-		//Matrix
-		if(apObjectA->GetModelMatrixPtr() != apObjectB->GetModelMatrixPtr())
+	unsigned int cRenderListIdMap::GetId(uint64_t alValue)
+	{
+		if((mlCount+1)*2 > mvKeys.size()) Grow();
+
+		size_t lMask = mvKeys.size()-1;
+		size_t lSlot = (size_t)HashSortValue(alValue) & lMask;
+		while(mvGenerations[lSlot] == mlGeneration)
 		{
-			return apObjectA->GetModelMatrixPtr() < apObjectB->GetModelMatrixPtr();
+			if(mvKeys[lSlot] == alValue) return mvIds[lSlot];
+			lSlot = (lSlot+1) & lMask;
 		}
 
-		//////////////////////////
-		//Object
-        return apObjectA < apObjectB;
+		mvGenerations[lSlot] = mlGeneration;
+		mvKeys[lSlot] = alValue;
+		mvIds[lSlot] = mlCount;
+		return mlCount++;
 	}
 
 	//-----------------------------------------------------------------------
 
-	static bool SortFunc_Translucent(iRenderable* apObjectA, iRenderable *apObjectB)
+	void cRenderListIdMap::Grow()
 	{
-		////////////////////////
-		//If there is a large plane, then need to sort objects according to this first!
-		if(apObjectA->GetLargePlaneSurfacePlacement() != apObjectB->GetLargePlaneSurfacePlacement())
+		std::vector<uint64_t> vOldKeys;
+		std::vector<unsigned int> vOldIds;
+		std::vector<unsigned int> vOldGenerations;
+		vOldKeys.swap(mvKeys);
+		vOldIds.swap(mvIds);
+		vOldGenerations.swap(mvGenerations);
+
+		size_t lNewSize = vOldKeys.size()*2;
+		mvKeys.resize(lNewSize);
+		mvIds.resize(lNewSize);
+		mvGenerations.assign(lNewSize, 0);
+
+		size_t lMask = lNewSize-1;
+		for(size_t i=0; i<vOldKeys.size(); ++i)
 		{
-			return apObjectA->GetLargePlaneSurfacePlacement() < apObjectB->GetLargePlaneSurfacePlacement();
+			if(vOldGenerations[i] != mlGeneration) continue;
+
+			size_t lSlot = (size_t)HashSortValue(vOldKeys[i]) & lMask;
+			while(mvGenerations[lSlot] == mlGeneration) lSlot = (lSlot+1) & lMask;
+
+			mvGenerations[lSlot] = mlGeneration;
+			mvKeys[lSlot] = vOldKeys[i];
+			mvIds[lSlot] = vOldIds[i];
 		}
+	}
 
-		//////////////////////////
-		//View space depth, no need to test further since Z should almost never be the same for two objects.
-		return apObjectA->GetViewSpaceZ() < apObjectB->GetViewSpaceZ();
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// PRIVATE METHODS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	/**
+	 * Turns a float into an unsigned int that has the same ordering.
+	 */
+	static inline uint32_t FloatToSortableBits(float afX)
+	{
+		uint32_t lBits;
+		memcpy(&lBits, &afX, sizeof(uint32_t));
+		return (lBits & 0x80000000u) ? ~lBits : (lBits | 0x80000000u);
+	}
+
+	static inline uint64_t PackSortId(unsigned int alId, int alBits, int alShift)
+	{
+		uint64_t lMax = (((uint64_t)1) << alBits) -1;
+		uint64_t lId = alId < lMax ? (uint64_t)alId : lMax; //If there are too many ids, the last ones just end up in the same batch.
+		return lId << alShift;
 	}
 
 	//-----------------------------------------------------------------------
 
-	static bool SortFunc_Decal(iRenderable* apObjectA, iRenderable *apObjectB)
+	uint64_t cRenderList::GetSortKey(eRenderListType aType, iRenderable *apObject)
 	{
-		cMaterial *pMatA = apObjectA->GetMaterial();
-		cMaterial *pMatB = apObjectB->GetMaterial();
+		cMaterial *pMat = apObject->GetMaterial();
 
+		switch(aType)
+		{
 		//////////////////////////
-		//Texture
-		if(pMatA->GetTexture(eMaterialTexture_Illumination) != pMatB->GetTexture(eMaterialTexture_Illumination))
+		// Z: Alpha mode | (if alpha) Program | Diffuse texture | Depth (closest to the screen first)
+		case eRenderListType_Z:
 		{
-			return pMatA->GetTexture(eMaterialTexture_Illumination) < pMatB->GetTexture(eMaterialTexture_Illumination);
+			uint64_t lKey = PackSortId(pMat->GetAlphaMode(), 1, 63);
+			if(pMat->GetAlphaMode() == eMaterialAlphaMode_Trans)
+			{
+				lKey |= PackSortId(mProgramIds.GetId(pMat->GetProgram(0,eMaterialRenderMode_Z)), 11, 52);
+				lKey |= PackSortId(mTextureIds.GetId(pMat->GetTexture(eMaterialTexture_Diffuse)), 20, 32);
+			}
+			lKey |= (uint64_t)(~FloatToSortableBits(apObject->GetViewSpaceZ()));
+			return lKey;
 		}
 
 		//////////////////////////
-		//Vertex buffer
-		if(apObjectA->GetVertexBuffer() != apObjectB->GetVertexBuffer())
+		// Diffuse: Program | Texture set | Vertex buffer | Matrix
+		case eRenderListType_Diffuse:
 		{
-			return apObjectA->GetVertexBuffer() < apObjectB->GetVertexBuffer();
+			uint64_t lTexSetHash = 0;
+			for(int i=0;i<kMaxTextureUnits; ++i)
+			{
+				lTexSetHash = HashSortValue(lTexSetHash ^ (uint64_t)(size_t)pMat->GetTextureInUnit(eMaterialRenderMode_Diffuse,i));
+			}
+
+			return	PackSortId(mProgramIds.GetId(pMat->GetProgram(0,eMaterialRenderMode_Diffuse)), 12, 52) |
+					PackSortId(mTextureSetIds.GetId(lTexSetHash), 16, 36) |
+					PackSortId(mVertexBufferIds.GetId(apObject->GetVertexBuffer()), 18, 18) |
+					PackSortId(mMatrixIds.GetId(apObject->GetModelMatrixPtr()), 18, 0);
 		}
 
 		//////////////////////////
-		//Matrix
-		if(apObjectA->GetModelMatrixPtr() != apObjectB->GetModelMatrixPtr())
+		// Translucent: Large plane placement | Depth (furthest away first)
+		case eRenderListType_Translucent:
+			return	PackSortId(apObject->GetLargePlaneSurfacePlacement()+1, 2, 32) |
+					(uint64_t)FloatToSortableBits(apObject->GetViewSpaceZ());
+
+		//////////////////////////
+		// Decal: Texture | Vertex buffer | Matrix
+		case eRenderListType_Decal:
+			return	PackSortId(mTextureIds.GetId(pMat->GetTexture(eMaterialTexture_Illumination)), 16, 48) |
+					PackSortId(mVertexBufferIds.GetId(apObject->GetVertexBuffer()), 20, 28) |
+					PackSortId(mMatrixIds.GetId(apObject->GetModelMatrixPtr()), 28, 0);
+
+		//////////////////////////
+		// Illumination: Texture | Vertex buffer | Matrix | Illumination amount
+		case eRenderListType_Illumination:
 		{
-			return apObjectA->GetModelMatrixPtr() < apObjectB->GetModelMatrixPtr();
+			float fAmount = cMath::Clamp(apObject->GetIlluminationAmount(), 0.0f, 1.0f);
+			return	PackSortId(mTextureIds.GetId(pMat->GetTexture(eMaterialTexture_Illumination)), 16, 48) |
+					PackSortId(mVertexBufferIds.GetId(apObject->GetVertexBuffer()), 16, 32) |
+					PackSortId(mMatrixIds.GetId(apObject->GetModelMatrixPtr()), 16, 16) |
+					PackSortId((unsigned int)(fAmount * 65535.0f), 16, 0);
+		}
 		}
 
-		//////////////////////////
-		//Vector (just so that order stays the same
-        return apObjectA->GetWorldPosition()  < apObjectB->GetWorldPosition();
+		return 0;
 	}
 
 	//-----------------------------------------------------------------------
 
-	static bool SortFunc_Illumination(iRenderable* apObjectA, iRenderable *apObjectB)
+	/**
+	 * Stable LSD radix sort, 8 bits per pass. Passes where all keys share the same byte are skipped,
+	 * which is common since the keys rarely use all of their bits.
+	 */
+	void cRenderList::RadixSort(tRenderListSortEntryVec& avEntries)
 	{
-		cMaterial *pMatA = apObjectA->GetMaterial();
-		cMaterial *pMatB = apObjectB->GetMaterial();
+		size_t lCount = avEntries.size();
+		if(lCount < 2) return;
 
-		//////////////////////////
-		//Texture
-		if(pMatA->GetTexture(eMaterialTexture_Illumination) != pMatB->GetTexture(eMaterialTexture_Illumination))
-		{
-			return pMatA->GetTexture(eMaterialTexture_Illumination) < pMatB->GetTexture(eMaterialTexture_Illumination);
-		}
+		size_t vHistogram[8][256];
+		memset(vHistogram, 0, sizeof(vHistogram));
 
-		//////////////////////////
-		//Vertex buffer
-		if(apObjectA->GetVertexBuffer() != apObjectB->GetVertexBuffer())
+		for(size_t i=0; i<lCount; ++i)
 		{
-			return apObjectA->GetVertexBuffer() < apObjectB->GetVertexBuffer();
+			uint64_t lKey = avEntries[i].mlKey;
+			for(int pass=0; pass<8; ++pass)
+			{
+				++vHistogram[pass][(lKey >> (pass*8)) & 0xff];
+			}
 		}
 
-		//////////////////////////
-		//Matrix
-		if(apObjectA->GetModelMatrixPtr() != apObjectB->GetModelMatrixPtr())
+		mvSortTemp.resize(lCount);
+		cRenderListSortEntry *pSrc = &avEntries[0];
+		cRenderListSortEntry *pDest = &mvSortTemp[0];
+
+		for(int pass=0; pass<8; ++pass)
 		{
-			return apObjectA->GetModelMatrixPtr() < apObjectB->GetModelMatrixPtr();
-		}
+			size_t *pHistogram = vHistogram[pass];
+			int lShift = pass*8;
 
-		//////////////////////////
-		//Illumination amount
-		return apObjectA->GetIlluminationAmount() < apObjectB->GetIlluminationAmount();
-	}
+			//Skip if every key has the same value in this byte
+			if(pHistogram[(pSrc[0].mlKey >> lShift) & 0xff] == lCount) continue;
 
-	//-----------------------------------------------------------------------
+			size_t lOffset =0;
+			for(int i=0; i<256; ++i)
+			{
+				size_t lNum = pHistogram[i];
+				pHistogram[i] = lOffset;
+				lOffset += lNum;
+			}
 
-	typedef bool (*tSortRenderableFunc)(iRenderable*,iRenderable*);
+			for(size_t i=0; i<lCount; ++i)
+			{
+				pDest[pHistogram[(pSrc[i].mlKey >> lShift) & 0xff]++] = pSrc[i];
+			}
 
-	static tSortRenderableFunc vSortFunctions[eRenderListType_LastEnum] = {SortFunc_Z,SortFunc_Diffuse,SortFunc_Translucent,SortFunc_Decal,SortFunc_Illumination};
+			std::swap(pSrc, pDest);
+		}
 
-	//-----------------------------------------------------------------------
+		if(pSrc != &avEntries[0]) avEntries.swap(mvSortTemp);
+	}
 
+	//-----------------------------------------------------------------------
 
 	void cRenderList::CompileArray(eRenderListType aType)
 	{
@@ -464,9 +542,27 @@ namespace hpl {
 		else if(aType == eRenderListType_Illumination)	pSourceVec = &mvIllumObjects;
 		else											pSourceVec = &mvSolidObjects;
 
-		mvSortedArrays[aType] = *pSourceVec;	//Should be fastest way to copy right, or use memcopy?
+		////////////////////////////
+		// Build keys
+		size_t lCount = pSourceVec->size();
+		mvSortEntries.resize(lCount);
+		for(size_t i=0; i<lCount; ++i)
+		{
+			iRenderable *pObject = (*pSourceVec)[i];
+			mvSortEntries[i].mlKey = GetSortKey(aType, pObject);
+			mvSortEntries[i].mpObject = pObject;
+		}
+
+		////////////////////////////
+		// Sort and copy to array
+		RadixSort(mvSortEntries);
 
-		std::sort(mvSortedArrays[aType].begin(), mvSortedArrays[aType].end(), vSortFunctions[aType]);
+		tRenderableVec& vSortedArray = mvSortedArrays[aType];
+		vSortedArray.resize(lCount);
+		for(size_t i=0; i<lCount; ++i)
+		{
+			vSortedArray[i] = mvSortEntries[i].mpObject;
+		}
 	}
 
 	//-----------------------------------------------------------------------
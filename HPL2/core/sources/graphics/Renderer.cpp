@@ -25,6 +25,8 @@
 #include "system/LowLevelSystem.h"
 #include "system/PreprocessParser.h"
 #include "system/String.h"
+#include "system/Profiler.h"
+#include "system/JobManager.h"
 
 #include "graphics/Graphics.h"
 #include "graphics/Texture.h"
@@ -41,6 +43,7 @@
 #include "graphics/Mesh.h"
 #include "graphics/SubMesh.h"
 #include "graphics/OcclusionQuery.h"
+#include "graphics/SoftwareOcclusion.h"
 
 #include "resources/Resources.h"
 #include "resources/LowLevelResources.h"
@@ -113,6 +116,8 @@ namespace hpl {
 
 		mpVisibleNodeTracker = hplNew( cVisibleRCNodeTracker, () );
 
+		mpSoftwareOcclusion = NULL;
+
 		////////////////////////
 		// Setup data
 		mlCurrentOcclusionObject = 0;
@@ -129,6 +134,7 @@ namespace hpl {
 		//Change this later I assume:
 		mlMinimumObjectsBeforeOcclusionTesting = 0;//8;//8 should be good default, giving a good amount of colliders, or? Clarifiction: Minium num of object rendered until node visibility tests start!
 		mlSampleVisiblilityLimit = 3;
+		mfOcclusionQueryGroupSize = 0.1f;
 
 		mbUseCallbacks = true;
 
@@ -136,6 +142,9 @@ namespace hpl {
 
 		mbUseOcclusionCulling = true;
 
+		mbUseSoftwareOcclusionCulling = false;
+		mlSoftwareOcclusionMaxOccluders = 64;
+
 		mMaxShadowMapResolution = eShadowMapResolution_High;
 		if(mbIsReflection)
 			mMaxShadowMapResolution = eShadowMapResolution_Medium;
@@ -160,6 +169,7 @@ namespace hpl {
 		// Set up Output Variables
 		mlNumberOfLightsRendered =0;
 		mlNumberOfOcclusionQueries =0;
+		mlNumberOfSoftwareOccluders =0;
 
 		////////////////////////
 		// Set up Private Variables
@@ -179,6 +189,7 @@ namespace hpl {
 	{
 		hplDelete(mpRenderList);
 		hplDelete(mpVisibleNodeTracker);
+		if(mpSoftwareOcclusion) hplDelete(mpSoftwareOcclusion);
 
 		STLDeleteAll(mvOcclusionObjectPool);
 
@@ -218,6 +229,7 @@ namespace hpl {
 		//Render settings
 		RenderSettingsCopy(mlMinimumObjectsBeforeOcclusionTesting);
 		RenderSettingsCopy(mlSampleVisiblilityLimit);
+		RenderSettingsCopy(mfOcclusionQueryGroupSize);
 
 		mpReflectionSettings->mbUseScissorRect = false;
 
@@ -427,6 +439,10 @@ namespace hpl {
 
 		mlActiveOcclusionQueryNum =0;
 
+		mpCurrentSoftwareOcclusion = NULL;
+
+		mlPreGatheredShadowCasterNum =0;
+
 		//////////////
 		// Create programs
 		cParserVarContainer vars;
@@ -450,6 +466,7 @@ namespace hpl {
 		DestroyShadowMaps();
 
 		STLDeleteAll(mvOcclusionQueryPool);
+		STLDeleteAll(mvPreGatheredShadowCasters);
 
 		if(mpShapeBox) hplDelete(mpShapeBox);
 
@@ -556,6 +573,7 @@ namespace hpl {
 		mpCallbackList = apCallbackList;
 
 		mbOcclusionPlanesActive = true;
+		mpCurrentSoftwareOcclusion = NULL;
 
 		////////////////////////////////
 		//Initialize render functions
@@ -897,6 +915,12 @@ namespace hpl {
 		{
 			if(	frustumCollision == eCollision_Outside) return;
 			if(CheckNodeIsVisible(apNode)==false)		return;
+
+			if(	mpCurrentSoftwareOcclusion &&
+				mpCurrentSoftwareOcclusion->IsAABBVisible(apNode->GetMin(), apNode->GetMax())==false)
+			{
+				return;
+			}
 		}
 
 		////////////////////////
@@ -924,6 +948,8 @@ namespace hpl {
 			    if(	frustumCollision == eCollision_Inside ||
 					pObject->CollidesWithFrustum(mpCurrentFrustum))
 				{
+					if(CheckObjectIsSoftwareOccluded(pObject)) continue;
+
 					mpCurrentRenderList->AddObject(pObject);
 				}
 			}
@@ -934,13 +960,134 @@ namespace hpl {
 
 	void iRenderer::CheckForVisibleAndAddToList(iRenderableContainer *apContainer, tRenderableFlag alNeededFlags)
 	{
+		PROFILE_ZONE(CheckForVisibleAndAddToList)
+
 		apContainer->UpdateBeforeRendering();
 
+		////////////////////////////////
+		//Use flat representation if the container has one.
+		const cPlanef *pCullPlanes;
+		int lCullPlaneNum = GetNodeCullPlanes(&pCullPlanes);
+		if(apContainer->GetFrustumObjectRanges(mpCurrentFrustum, pCullPlanes, lCullPlaneNum, mvContainerObjectRanges, mpCurrentSoftwareOcclusion))
+		{
+			for(size_t i=0; i<mvContainerObjectRanges.size(); ++i)
+			{
+				const cRenderableContainerObjectRange &range = mvContainerObjectRanges[i];
+				for(int j=0; j<range.mlObjectNum; ++j)
+				{
+					iRenderable *pObject = range.mpObjects[j];
+					if(CheckObjectIsVisible(pObject, alNeededFlags)==false) continue;
+
+					if(	range.mFrustumCollision == eCollision_Inside ||
+						pObject->CollidesWithFrustum(mpCurrentFrustum))
+					{
+						if(CheckObjectIsSoftwareOccluded(pObject)) continue;
+
+						mpCurrentRenderList->AddObject(pObject);
+					}
+				}
+			}
+			return;
+		}
+
 		CheckNodesAndAddToListIterative(apContainer->GetRoot(), alNeededFlags);
 	}
 
 	//-----------------------------------------------------------------------
 
+	/**
+	 * Gets the planes that nodes need to be on the positive side of, returns the number of planes.
+	 */
+	int iRenderer::GetNodeCullPlanes(const cPlanef **appPlanes)
+	{
+		if(mbOcclusionPlanesActive==false || mvCurrentOcclusionPlanes.empty())
+		{
+			*appPlanes = NULL;
+			return 0;
+		}
+
+		*appPlanes = &mvCurrentOcclusionPlanes[0];
+		return (int)mvCurrentOcclusionPlanes.size();
+	}
+
+	//-----------------------------------------------------------------------
+
+	static bool SortFunc_SoftwareOccluders(const std::pair<float, iRenderable*> &aA, const std::pair<float, iRenderable*> &aB)
+	{
+		return aA.first > aB.first;
+	}
+
+	void iRenderer::SetupSoftwareOcclusion(tRenderableFlag alNeededFlags)
+	{
+		mpCurrentSoftwareOcclusion = NULL;
+		mpCurrentSettings->mlNumberOfSoftwareOccluders =0;
+		if(mpCurrentSettings->mbUseSoftwareOcclusionCulling==false) return;
+
+		PROFILE_ZONE(SetupSoftwareOcclusion)
+
+		if(mpCurrentSettings->mpSoftwareOcclusion==NULL)
+			mpCurrentSettings->mpSoftwareOcclusion = hplNew( cSoftwareOcclusion, () );
+
+		cSoftwareOcclusion *pOcclusion = mpCurrentSettings->mpSoftwareOcclusion;
+		if(pOcclusion->BeginFrame(mpCurrentFrustum)==false) return;
+
+		////////////////////////////////
+		//Get occluders in view, these are static only.
+		iRenderableContainer *pContainer = mpCurrentWorld->GetRenderableContainer(eWorldContainerType_Static);
+		pContainer->UpdateBeforeRendering();
+
+		const cPlanef *pCullPlanes;
+		int lCullPlaneNum = GetNodeCullPlanes(&pCullPlanes);
+		if(pContainer->GetFrustumObjectRanges(mpCurrentFrustum, pCullPlanes, lCullPlaneNum, mvContainerObjectRanges)==false) return;
+
+		mvSoftwareOccluderCandidates.resize(0);
+		for(size_t i=0; i<mvContainerObjectRanges.size(); ++i)
+		{
+			const cRenderableContainerObjectRange &range = mvContainerObjectRanges[i];
+			for(int j=0; j<range.mlObjectNum; ++j)
+			{
+				iRenderable *pObject = range.mpObjects[j];
+				if(pObject->GetRenderFlagBit(eRenderableFlag_Occluder)==false) continue;
+				if(CheckObjectIsVisible(pObject, alNeededFlags)==false) continue;
+				if(range.mFrustumCollision != eCollision_Inside && pObject->CollidesWithFrustum(mpCurrentFrustum)==false) continue;
+
+				//Large and close objects hide the most.
+				cBoundingVolume *pBV = pObject->GetBoundingVolume();
+				float fDistSqr = cMath::Vector3DistSqr(pBV->GetWorldCenter(), mpCurrentFrustum->GetOrigin());
+				float fSize = pBV->GetRadius() * pBV->GetRadius() / cMath::Max(fDistSqr, 0.0001f);
+
+				mvSoftwareOccluderCandidates.push_back(std::pair<float, iRenderable*>(fSize, pObject));
+			}
+		}
+
+		int lOccluderNum = cMath::Min((int)mvSoftwareOccluderCandidates.size(), mpCurrentSettings->mlSoftwareOcclusionMaxOccluders);
+		std::partial_sort(	mvSoftwareOccluderCandidates.begin(), mvSoftwareOccluderCandidates.begin() + lOccluderNum,
+							mvSoftwareOccluderCandidates.end(), SortFunc_SoftwareOccluders);
+
+		////////////////////////////////
+		//Draw occluders
+		for(int i=0; i<lOccluderNum; ++i)
+		{
+			pOcclusion->AddOccluder(mvSoftwareOccluderCandidates[i].second);
+		}
+		pOcclusion->Rasterize();
+
+		mpCurrentSettings->mlNumberOfSoftwareOccluders = lOccluderNum;
+		mpCurrentSoftwareOcclusion = pOcclusion;
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool iRenderer::CheckObjectIsSoftwareOccluded(iRenderable *apObject)
+	{
+		if(mpCurrentSoftwareOcclusion==NULL) return false;
+
+		cBoundingVolume *pBV = apObject->GetBoundingVolume();
+		return mpCurrentSoftwareOcclusion->IsAABBVisible(pBV->GetMin(), pBV->GetMax())==false;
+	}
+
+	//-----------------------------------------------------------------------
+
 	/**
 	* Inserts the child nodes in apNode in a_setNodeStack.
 	*/
@@ -1147,6 +1294,53 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	/**
+	 * Renders the objects in the node and all of its children, using the frustum collision of the node.
+	 */
+	int iRenderer::RenderAndAddNodeTreeObjects(iRenderableContainerNode *apNode, tRenderCHCObjectCallbackFunc apRenderCallback, tRenderableFlag alNeededFlags)
+	{
+		int lRenderedObjects = RenderAndAddNodeObjects(apNode, apRenderCallback, alNeededFlags);
+
+		tRenderableContainerNodeListIt childIt = apNode->GetChildNodeList()->begin();
+		for(; childIt != apNode->GetChildNodeList()->end(); ++childIt)
+		{
+			iRenderableContainerNode *pChildNode = *childIt;
+			pChildNode->UpdateBeforeUse();
+
+			if(	pChildNode->UsesFlagsAndVisibility() &&
+				(pChildNode->HasVisibleObjects()==false || (pChildNode->GetRenderFlags() & alNeededFlags) != alNeededFlags))
+			{
+				continue;
+			}
+
+			eCollision frustumCollision =	apNode->GetPrevFrustumCollision() == eCollision_Inside ?
+													eCollision_Inside : mpCurrentFrustum->CollideNode(pChildNode);
+			if(frustumCollision == eCollision_Outside) continue;
+
+			pChildNode->SetPrevFrustumCollision(frustumCollision);
+
+			lRenderedObjects += RenderAndAddNodeTreeObjects(pChildNode, apRenderCallback, alNeededFlags);
+		}
+
+		return lRenderedObjects;
+	}
+
+	//-----------------------------------------------------------------------
+
+	/**
+	 * Leaves and nodes that are small on screen get a single query for everything in them. Without this a tree with
+	 * one object per leaf (like the dynamic container) would use a query for every small object.
+	 */
+	bool iRenderer::NodeIsOcclusionQueryLeaf(iRenderableContainerNode *apNode)
+	{
+		if(apNode->HasChildNodes()==false) return true;
+		if(apNode->GetParent()==NULL) return false; //View distance is not set for root nodes
+
+		return apNode->GetRadius() < cMath::Abs(apNode->GetViewDistance()) * mpCurrentSettings->mfOcclusionQueryGroupSize;
+	}
+
+	//-----------------------------------------------------------------------
+
 	cVisibleRCNodeTracker *gpCurrentVisibleNodeTracker = NULL;
     void iRenderer::PushUpVisibility(iRenderableContainerNode *apNode)
 	{
@@ -1179,6 +1373,8 @@ namespace hpl {
 																bool abSetupRenderStates,
 																tRenderCHCObjectCallbackFunc apRenderObjectCallback)
 	{
+		PROFILE_ZONE(CheckForVisibleObjectsAddToListAndRenderZ)
+
 		START_RENDER_PASS(CHC_Culling);
 
 		////////////////////////////
@@ -1262,8 +1458,8 @@ namespace hpl {
 				setNodeStack.erase(firstIt); //This is most likely very slow... use list?
 
 				//////////////////////////
-				// Check if node is a leaf
-				bool bNodeIsLeaf = pNode->HasChildNodes()==false;
+				// Check if node is a leaf, or small enough to be queried as one
+				bool bNodeIsLeaf = NodeIsOcclusionQueryLeaf(pNode);
 
 				//////////////////////////
 				// Check if near plane is inside node AABB
@@ -1294,7 +1490,7 @@ namespace hpl {
 
 					//////////////////////////
 					//Render node objects after AABB so that an object does not occlude its own node.
-					if(bRenderObjects) RenderAndAddNodeObjects(pNode,pRenderCallback, alNeededFlags);
+					if(bRenderObjects) RenderAndAddNodeTreeObjects(pNode,pRenderCallback, alNeededFlags);
 
 					//Debug:
 					// Skipping any queries, so must push up visible if this node was visible
@@ -1375,13 +1571,22 @@ namespace hpl {
 						PushUpVisibility(pNode);
 
 						////////////////
-						//Add child nodes to stack if any (also checks if they have needed flags are in frustum)
-						PushNodeChildrenToStack(setNodeStack, pNode, alNeededFlags);
-
-						////////////////
-						//Render objects if any and not already rendered.
-						if(bObjectsRendered==false){
-							RenderAndAddNodeObjects(pNode,pRenderCallback, alNeededFlags);
+						//Nodes queried as leaves render everything in them (if not already rendered).
+						if(NodeIsOcclusionQueryLeaf(pNode))
+						{
+							if(bObjectsRendered==false) RenderAndAddNodeTreeObjects(pNode,pRenderCallback, alNeededFlags);
+						}
+						else
+						{
+							////////////////
+							//Add child nodes to stack if any (also checks if they have needed flags are in frustum)
+							PushNodeChildrenToStack(setNodeStack, pNode, alNeededFlags);
+
+							////////////////
+							//Render objects if any and not already rendered.
+							if(bObjectsRendered==false){
+								RenderAndAddNodeObjects(pNode,pRenderCallback, alNeededFlags);
+							}
 						}
 					}
 					else
@@ -1405,15 +1610,6 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
-	static tRenderableVec* gpLightShadowCasterVec=NULL;
-	static cFrustum *gpLightFrustum=NULL;
-	static cFrustum *gpViewFrustum=NULL;
-	static eFrustumPlane gvBeyondLightAndViewPlanes[6]; //Use to check if an caster is not going to affect view.
-	static int glBeyondLightAndViewPlaneNum;
-	static bool gbLightBehindNearPlane;
-
-	//-----------------------------------------------------------------------
-
 	static bool BoxIntersectOrInsidePlane(const cPlanef& aPlane,cVector3f *apCornerVec)
 	{
 		for(int corner =0; corner < 8; ++corner)
@@ -1444,7 +1640,7 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
-	bool iRenderer::CheckShadowCasterContributesToView(iRenderable *apObject)
+	bool iRenderer::CheckShadowCasterContributesToView(iRenderable *apObject, cShadowCasterGatherData *apData)
 	{
 		//This should be always true since the shadow map might be saved and will then end up faulty if some objects have been dismissed!
 		return true;
@@ -1458,11 +1654,11 @@ namespace hpl {
 		//////////////////////////////////////
 		//If light is behind near plane, one must check if object in front of near plane
 		bool bObjectMightOnNearPlane=false;
-		if(gbLightBehindNearPlane)
+		if(apData->mbLightBehindNearPlane)
 		{
 			return true;	//Temp, until I can come up with a qay to resolve the issues.
 
-			const cPlanef& nearPlane = gpViewFrustum->GetPlane(eFrustumPlane_Near);
+			const cPlanef& nearPlane = apData->mpViewFrustum->GetPlane(eFrustumPlane_Near);
 			float fDist = cMath::PlaneToPointDist(nearPlane, pBV->GetWorldCenter());
 
 			//Object is outside of near plane.
@@ -1482,10 +1678,10 @@ namespace hpl {
 		// Sphere test
 		int lOutsideCount=0;
 		int lInsideCount=0;
-		for(int i=0; i<glBeyondLightAndViewPlaneNum; ++i)
+		for(int i=0; i<apData->mlBeyondLightAndViewPlaneNum; ++i)
 		{
-			eFrustumPlane frustumPlane = gvBeyondLightAndViewPlanes[i];
-			const cPlanef& cameraPlane = gpViewFrustum->GetPlane(frustumPlane);
+			eFrustumPlane frustumPlane = apData->mvBeyondLightAndViewPlanes[i];
+			const cPlanef& cameraPlane = apData->mpViewFrustum->GetPlane(frustumPlane);
 
 			float fDist = cMath::PlaneToPointDist(cameraPlane, pBV->GetWorldCenter());
 
@@ -1503,7 +1699,7 @@ namespace hpl {
 
 		//Log("3\n");
 		// If all was inside, then we are sure it contributes
-		if(lInsideCount == glBeyondLightAndViewPlaneNum) return true;
+		if(lInsideCount == apData->mlBeyondLightAndViewPlaneNum) return true;
 
 		//Log("4\n");
 		// If any was outside, we are sure it does NOT contribute
@@ -1528,7 +1724,7 @@ namespace hpl {
 		if(lOutsideCount > 0 && bObjectMightOnNearPlane)
 		{
 			//If object is not fully inside, it contributes
-			if(BoxInsidePlane(gpViewFrustum->GetPlane(eFrustumPlane_Near),vCorners)==false)
+			if(BoxInsidePlane(apData->mpViewFrustum->GetPlane(eFrustumPlane_Near),vCorners)==false)
 			{
 				return true;
 			}
@@ -1543,7 +1739,7 @@ namespace hpl {
 		if(bObjectMightOnNearPlane)
 		{
 			//If object is not fully inside, it contributes
-			if(BoxInsidePlane(gpViewFrustum->GetPlane(eFrustumPlane_Near),vCorners)==false)
+			if(BoxInsidePlane(apData->mpViewFrustum->GetPlane(eFrustumPlane_Near),vCorners)==false)
 			{
 				return true;
 			}
@@ -1552,10 +1748,10 @@ namespace hpl {
 		//Log("7\n");
 		//Iterate all planes separating between contributing and not.
 		bool bContributes;
-		for(int plane=0; plane<glBeyondLightAndViewPlaneNum; ++plane)
+		for(int plane=0; plane<apData->mlBeyondLightAndViewPlaneNum; ++plane)
 		{
-			eFrustumPlane frustumPlane = gvBeyondLightAndViewPlanes[plane];
-			const cPlanef& cameraPlane = gpViewFrustum->GetPlane(frustumPlane);
+			eFrustumPlane frustumPlane = apData->mvBeyondLightAndViewPlanes[plane];
+			const cPlanef& cameraPlane = apData->mpViewFrustum->GetPlane(frustumPlane);
 
 			bContributes = BoxIntersectOrInsidePlane(cameraPlane, vCorners);
 
@@ -1569,8 +1765,7 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
-
-	void iRenderer::GetShadowCastersIterative(iRenderableContainerNode *apNode, eCollision aPrevCollision)
+	void iRenderer::GetShadowCastersIterative(iRenderableContainerNode *apNode, eCollision aPrevCollision, cShadowCasterGatherData *apData)
 	{
 		///////////////////////////////////////
 		//Make sure node is updated
@@ -1578,7 +1773,7 @@ namespace hpl {
 
 		///////////////////////////////////////
 		//Get frustum collision, if previous was inside, then this is too!
-		eCollision frustumCollision = aPrevCollision == eCollision_Inside ? aPrevCollision : gpLightFrustum->CollideNode(apNode);
+		eCollision frustumCollision = aPrevCollision == eCollision_Inside ? aPrevCollision : apData->mpLightFrustum->CollideNode(apNode);
 
 		///////////////////////////////////
 		//Check if visible but always iterate the root node!
@@ -1595,7 +1790,7 @@ namespace hpl {
 			for(tRenderableContainerNodeListIt childIt = apNode->GetChildNodeList()->begin(); childIt != apNode->GetChildNodeList()->end(); ++childIt)
 			{
 				iRenderableContainerNode *pChildNode = *childIt;
-				GetShadowCastersIterative(pChildNode, frustumCollision);
+				GetShadowCastersIterative(pChildNode, frustumCollision, apData);
 			}
 		}
 
@@ -1605,61 +1800,77 @@ namespace hpl {
 		{
 			for(tRenderableListIt it = apNode->GetObjectList()->begin(); it != apNode->GetObjectList()->end(); ++it)
 			{
-				iRenderable *pObject = *it;
+				CheckShadowCasterAndAddToVec(*it, frustumCollision, apData);
+			}
+		}
+	}
 
-				/////////
-				//Check so visible and shadow caster
-				if(	CheckObjectIsVisible(pObject, eRenderableFlag_ShadowCaster)==false ||
-					pObject->GetMaterial() == NULL ||
-					pObject->GetMaterial()->GetType()->IsTranslucent())
-				{
-					continue;
-				}
+	//-----------------------------------------------------------------------
 
-				/////////
-				//Check if in frustum
-				if(	frustumCollision != eCollision_Inside &&
-					gpLightFrustum->CollideBoundingVolume(pObject->GetBoundingVolume()) == eCollision_Outside)
-				{
-					continue;
-				}
+	void iRenderer::CheckShadowCasterAndAddToVec(iRenderable *apObject, eCollision aNodeCollision, cShadowCasterGatherData *apData)
+	{
+		/////////
+		//Check so visible and shadow caster
+		if(	CheckObjectIsVisible(apObject, eRenderableFlag_ShadowCaster)==false ||
+			apObject->GetMaterial() == NULL ||
+			apObject->GetMaterial()->GetType()->IsTranslucent())
+		{
+			return;
+		}
 
-				/////////
-				// Check if it contributes to scene
-				if(CheckShadowCasterContributesToView(pObject)==false) continue;
+		/////////
+		//Check if in frustum
+		if(	aNodeCollision != eCollision_Inside &&
+			apData->mpLightFrustum->CollideBoundingVolume(apObject->GetBoundingVolume()) == eCollision_Outside)
+		{
+			return;
+		}
 
+		/////////
+		// Check if it contributes to scene
+		if(CheckShadowCasterContributesToView(apObject, apData)==false) return;
 
-				///////////////////////////////
-				// Add object!
 
-				//Calculate the view space Z (just a squared distance)
-				pObject->SetViewSpaceZ(cMath::Vector3DistSqr(pObject->GetBoundingVolume()->GetWorldCenter(),
-															gpLightFrustum->GetOrigin()));
+		///////////////////////////////
+		// Add object!
 
-				//Add to list
-				gpLightShadowCasterVec->push_back(pObject);
-			}
-		}
+		//The distance is kept in the data and not set as view space Z, since other lights might be gathered at the same time.
+		float fDistSqr = cMath::Vector3DistSqr(apObject->GetBoundingVolume()->GetWorldCenter(), apData->mpLightFrustum->GetOrigin());
+
+		//Add to list
+		apData->mvCasters.push_back(std::pair<float, iRenderable*>(fDistSqr, apObject));
 	}
 
 	//-----------------------------------------------------------------------
 
-	void iRenderer::GetShadowCasters(iRenderableContainer *apContainer, tRenderableVec& avObjectVec, cFrustum *apLightFrustum)
+	void iRenderer::GetShadowCasters(iRenderableContainer *apContainer, cShadowCasterGatherData *apData)
 	{
-		apContainer->UpdateBeforeRendering();
-
-		gpLightFrustum = apLightFrustum;
-		gpLightShadowCasterVec = &avObjectVec;
+		////////////////////////////////
+		//Use flat representation if the container has one.
+		const cPlanef *pCullPlanes;
+		int lCullPlaneNum = GetNodeCullPlanes(&pCullPlanes);
+		if(apContainer->GetFrustumObjectRanges(apData->mpLightFrustum, pCullPlanes, lCullPlaneNum, apData->mvObjectRanges))
+		{
+			for(size_t i=0; i<apData->mvObjectRanges.size(); ++i)
+			{
+				const cRenderableContainerObjectRange &range = apData->mvObjectRanges[i];
+				for(int j=0; j<range.mlObjectNum; ++j)
+				{
+					CheckShadowCasterAndAddToVec(range.mpObjects[j], range.mFrustumCollision, apData);
+				}
+			}
+			return;
+		}
 
-		GetShadowCastersIterative(apContainer->GetRoot(), eCollision_Outside);
+		GetShadowCastersIterative(apContainer->GetRoot(), eCollision_Outside, apData);
 	}
 
 	//-----------------------------------------------------------------------
 
-	static bool SortFunc_ShadowCasters(iRenderable* apObjectA, iRenderable *apObjectB)
+	static bool SortFunc_ShadowCasters(const std::pair<float, iRenderable*> &aCasterA, const std::pair<float, iRenderable*> &aCasterB)
 	{
-		cMaterial *pMatA = apObjectA->GetMaterial();
-		cMaterial *pMatB = apObjectB->GetMaterial();
+		cMaterial *pMatA = aCasterA.second->GetMaterial();
+		cMaterial *pMatB = aCasterB.second->GetMaterial();
 
 		//////////////////////////
 		//Alpha mode
@@ -1684,32 +1895,28 @@ namespace hpl {
 		}
 
 		//////////////////////////
-		//View space depth, no need to test further since Z should almost never be the same for two objects.
-		//View space z is really just BB dist dis squared, so use "<"
-		return apObjectA->GetViewSpaceZ() < apObjectB->GetViewSpaceZ();
+		//Distance to light, no need to test further since it should almost never be the same for two objects.
+		//Distance is squared, so use "<"
+		return aCasterA.first < aCasterB.first;
 	}
 
 	//-----------------------------------------------------------------------
 
-	bool iRenderer::SetupShadowMapRendering(iLight *apLight)
+	void iRenderer::SetupShadowCasterGatherData(cLightSpot *apLight, cShadowCasterGatherData *apData)
 	{
-		/////////////////////////
-		// Get light data
-		if(apLight->GetLightType() != eLightType_Spot) return false; //Only support spot lights for now...
+		cFrustum *pLightFrustum = apLight->GetFrustum();
 
-		cLightSpot *pSpotLight = static_cast<cLightSpot*>(apLight);
-		cFrustum *pLightFrustum = pSpotLight->GetFrustum();
-
-		//Set the view frustum, needed in some functions cause the current is set for the light during rendering.
-		gpViewFrustum = mpCurrentFrustum;
+		apData->mpLight = apLight;
+		apData->mpLightFrustum = pLightFrustum;
+		apData->mpViewFrustum = mpCurrentFrustum;
 
 		/////////////////////////
 		// Get the camera planes that face away from the light
-		glBeyondLightAndViewPlaneNum =0;
+		apData->mlBeyondLightAndViewPlaneNum =0;
 		cVector3f vLightForward = pLightFrustum->GetForward();
 		for(int i=0; i<eFrustumPlane_LastEnum; ++i)
 		{
-			const cPlanef& cameraPlane = gpViewFrustum->GetPlane((eFrustumPlane)i);
+			const cPlanef& cameraPlane = mpCurrentFrustum->GetPlane((eFrustumPlane)i);
 
 			//Check so plane is facing the light
 			// Above 0 because GetForward from frustum is inverted.
@@ -1717,30 +1924,193 @@ namespace hpl {
 			cVector3f vPlaneNormal = cameraPlane.GetNormal();
 			if(cMath::Vector3Dot(vPlaneNormal, vLightForward) > 0)
 			{
-				gvBeyondLightAndViewPlanes[glBeyondLightAndViewPlaneNum] = (eFrustumPlane)i;
-				++glBeyondLightAndViewPlaneNum;
+				apData->mvBeyondLightAndViewPlanes[apData->mlBeyondLightAndViewPlaneNum] = (eFrustumPlane)i;
+				++apData->mlBeyondLightAndViewPlaneNum;
 			}
 		}
 
 		/////////////////////////
 		// See if light is behind near plane
-		if(cMath::PlaneToPointDist(gpViewFrustum->GetPlane(eFrustumPlane_Near), pLightFrustum->GetOrigin()) < 0)
+		if(cMath::PlaneToPointDist(mpCurrentFrustum->GetPlane(eFrustumPlane_Near), pLightFrustum->GetOrigin()) < 0)
 		{
-			gbLightBehindNearPlane = true;
+			apData->mbLightBehindNearPlane = true;
 		}
 		else
 		{
-			gbLightBehindNearPlane = false;
+			apData->mbLightBehindNearPlane = false;
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	void iRenderer::GatherShadowCasters(cShadowCasterGatherData *apData)
+	{
+		//Clear list
+		apData->mvCasters.resize(0); //No clear, so we keep all in memory.
+
+		//Get the objects
+		if(apData->mpLight->GetShadowCastersAffected() & eObjectVariabilityFlag_Dynamic)
+			GetShadowCasters(mpCurrentWorld->GetRenderableContainer(eWorldContainerType_Dynamic), apData);
+
+		if(apData->mpLight->GetShadowCastersAffected() & eObjectVariabilityFlag_Static)
+			GetShadowCasters(mpCurrentWorld->GetRenderableContainer(eWorldContainerType_Static), apData);
+
+		//Sort the list
+		if(apData->mvCasters.empty()==false)
+			std::sort(apData->mvCasters.begin(), apData->mvCasters.end(), SortFunc_ShadowCasters);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void iRenderer::UpdateShadowCasterContainers(tObjectVariabilityFlag alObjectTypes)
+	{
+		if(alObjectTypes & eObjectVariabilityFlag_Dynamic)
+			mpCurrentWorld->GetRenderableContainer(eWorldContainerType_Dynamic)->UpdateBeforeRendering();
+
+		if(alObjectTypes & eObjectVariabilityFlag_Static)
+			mpCurrentWorld->GetRenderableContainer(eWorldContainerType_Static)->UpdateBeforeRendering();
+	}
+
+	//-----------------------------------------------------------------------
+
+	void iRenderer::UpdateShadowCasterBoundingVolumes(iRenderableContainerNode *apNode, bool abInsideLightFrustum)
+	{
+		apNode->UpdateBeforeUse();
+
+		///////////////////////////////////
+		//Skip nodes outside of all light frustums, same test as in GetShadowCastersIterative. The root is always iterated there too.
+		if(abInsideLightFrustum==false && apNode->GetParent())
+		{
+			bool bOutsideAll = true;
+			for(int i=0; i<mlPreGatheredShadowCasterNum; ++i)
+			{
+				eCollision frustumCollision = mvPreGatheredShadowCasters[i]->mpLightFrustum->CollideNode(apNode);
+				if(frustumCollision == eCollision_Outside) continue;
+
+				bOutsideAll = false;
+				if(frustumCollision == eCollision_Inside)
+				{
+					abInsideLightFrustum = true;
+					break;
+				}
+			}
+			if(bOutsideAll) return;
 		}
 
+		if(apNode->HasObjects())
+		{
+			for(tRenderableListIt it = apNode->GetObjectList()->begin(); it != apNode->GetObjectList()->end(); ++it)
+			{
+				iRenderable *pObject = *it;
+				if(CheckObjectIsVisible(pObject, eRenderableFlag_ShadowCaster)==false) continue;
+
+				//Getting the center updates both the transform and the size of the BV.
+				pObject->GetBoundingVolume()->GetWorldCenter();
+			}
+		}
+
+		for(tRenderableContainerNodeListIt childIt = apNode->GetChildNodeList()->begin(); childIt != apNode->GetChildNodeList()->end(); ++childIt)
+		{
+			UpdateShadowCasterBoundingVolumes(*childIt, abInsideLightFrustum);
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	void iRenderer::PreGatherShadowCasters(const std::vector<iLight*>& avLights)
+	{
+		PROFILE_ZONE(PreGatherShadowCasters)
+
+		mlPreGatheredShadowCasterNum =0;
+
+		////////////////////////////////
+		//Set up the data for each light, this updates the light frustums and so is not done in the jobs.
+		tObjectVariabilityFlag lObjectTypes =0;
+		for(size_t i=0; i<avLights.size(); ++i)
+		{
+			iLight *pLight = avLights[i];
+			if(pLight->GetLightType() != eLightType_Spot || pLight->GetOcclusionCullShadowCasters()) continue;
+
+			if(mlPreGatheredShadowCasterNum >= (int)mvPreGatheredShadowCasters.size())
+				mvPreGatheredShadowCasters.push_back(hplNew( cShadowCasterGatherData, () ));
+
+			SetupShadowCasterGatherData(static_cast<cLightSpot*>(pLight), mvPreGatheredShadowCasters[mlPreGatheredShadowCasterNum]);
+			++mlPreGatheredShadowCasterNum;
+
+			lObjectTypes |= pLight->GetShadowCastersAffected();
+		}
+
+		if(mlPreGatheredShadowCasterNum==0) return;
+
+		////////////////////////////////
+		//Update the containers and the bounding volumes here. The BVs are updated when first used after a move (also from the skeleton),
+		//so the jobs would otherwise write to them, and several lights can test the same object at once.
+		//Static objects never move and all their BVs are updated when the static container is compiled, so only the dynamic ones are needed,
+		//and only in the parts of the tree that some light reaches.
+		UpdateShadowCasterContainers(lObjectTypes);
+		if(lObjectTypes & eObjectVariabilityFlag_Dynamic)
+			UpdateShadowCasterBoundingVolumes(mpCurrentWorld->GetRenderableContainer(eWorldContainerType_Dynamic)->GetRoot(), false);
+
+		////////////////////////////////
+		//Gather casters, one light per job.
+		cJobManager *pJobManager = cJobManager::GetGlobal();
+		if(pJobManager)	pJobManager->ParallelFor(0, mlPreGatheredShadowCasterNum, 1, PreGatherShadowCastersJob, this);
+		else			PreGatherShadowCastersJob(this, 0, mlPreGatheredShadowCasterNum);
+	}
+
+	void iRenderer::ClearPreGatheredShadowCasters()
+	{
+		mlPreGatheredShadowCasterNum =0;
+	}
+
+	void iRenderer::PreGatherShadowCastersJob(void *apData, int alStart, int alEnd)
+	{
+		iRenderer *pRenderer = static_cast<iRenderer*>(apData);
+		for(int i=alStart; i<alEnd; ++i)
+		{
+			pRenderer->GatherShadowCasters(pRenderer->mvPreGatheredShadowCasters[i]);
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool iRenderer::SetupShadowMapRendering(iLight *apLight)
+	{
 		/////////////////////////
-		// If culling by occlusion, skip rest of function
-		if(apLight->GetOcclusionCullShadowCasters())
+		// Get light data
+		if(apLight->GetLightType() != eLightType_Spot) return false; //Only support spot lights for now...
+
+		cLightSpot *pSpotLight = static_cast<cLightSpot*>(apLight);
+
+		/////////////////////////
+		// Use the casters if gathered already
+		cShadowCasterGatherData *pData = NULL;
+		for(int i=0; i<mlPreGatheredShadowCasterNum; ++i)
 		{
-			//mvShadowCasters.resize(0); //Debug reasons only, remove later!
-			return true;
+			if(mvPreGatheredShadowCasters[i]->mpLight == apLight)
+			{
+				pData = mvPreGatheredShadowCasters[i];
+				break;
+			}
 		}
 
+		/////////////////////////
+		// Else set up the light data here. Also needed for culling by occlusion.
+		if(pData==NULL)
+		{
+			pData = &mShadowCasterData;
+			SetupShadowCasterGatherData(pSpotLight, pData);
+
+			// If culling by occlusion, skip rest of function
+			if(apLight->GetOcclusionCullShadowCasters())
+			{
+				//mvShadowCasters.resize(0); //Debug reasons only, remove later!
+				return true;
+			}
+
+			UpdateShadowCasterContainers(apLight->GetShadowCastersAffected());
+			GatherShadowCasters(pData);
+		}
 
 		/////////////////////////
 		// Get objects to render
@@ -1748,19 +2118,15 @@ namespace hpl {
 		//Clear list
 		mvShadowCasters.resize(0); //No clear, so we keep all in memory.
 
-		//Get the objects
-		if(apLight->GetShadowCastersAffected() & eObjectVariabilityFlag_Dynamic)
-			GetShadowCasters(mpCurrentWorld->GetRenderableContainer(eWorldContainerType_Dynamic),mvShadowCasters, pSpotLight->GetFrustum());
-
-		if(apLight->GetShadowCastersAffected() & eObjectVariabilityFlag_Static)
-			GetShadowCasters(mpCurrentWorld->GetRenderableContainer(eWorldContainerType_Static),mvShadowCasters, pSpotLight->GetFrustum());
+		//Get the objects, these are already sorted.
+		for(size_t i=0; i<pData->mvCasters.size(); ++i)
+		{
+			mvShadowCasters.push_back(pData->mvCasters[i].second);
+		}
 
 		//See if any objects where added.
 		if(mvShadowCasters.empty()) return false;
 
-		//Sort the list
-		std::sort(mvShadowCasters.begin(), mvShadowCasters.end(), SortFunc_ShadowCasters);
-
 		return true;
 	}
 
@@ -1783,7 +2149,7 @@ namespace hpl {
 		}
 
 		//Check so it affects the view frustum
-		if(CheckShadowCasterContributesToView(apObject)==false) return false;
+		if(CheckShadowCasterContributesToView(apObject, &mShadowCasterData)==false) return false;
 
 		//mvShadowCasters.push_back(apObject); //Debug. Only to see what object are rendered.
 
@@ -1816,6 +2182,8 @@ namespace hpl {
 
 	void iRenderer::RenderShadowMap(iLight *apLight, iFrameBuffer *apShadowBuffer)
 	{
+		PROFILE_ZONE(RenderShadowMap)
+
 		if(mbLog){
 			Log("---\nBegin Rendering Shadow Map for light '%s' / %d to buffer %d\n",apLight->GetName().c_str(), apLight, apShadowBuffer);
 		}
@@ -23,6 +23,7 @@
 
 #include "system/LowLevelSystem.h"
 #include "system/String.h"
+#include "system/Profiler.h"
 #include "system/PreprocessParser.h"
 
 #include "graphics/Graphics.h"
@@ -841,6 +842,8 @@ namespace hpl {
 
 	void cRendererDeferred::RenderObjects()
 	{
+		PROFILE_ZONE(RenderObjects)
+
 		//Set up variables used in rendering later on.
 		SetupRenderVariables();
 
@@ -853,7 +856,7 @@ namespace hpl {
 
 		///////////////////////////
 		//Occlusion testing
-		if(mpCurrentSettings->mbUseOcclusionCulling)
+		if(mpCurrentSettings->mbUseOcclusionCulling && mpCurrentSettings->mbUseSoftwareOcclusionCulling==false)
 		{
 			CheckForVisibleObjectsAddToListAndRenderZ(	mpCurrentSettings->mpVisibleNodeTracker,eObjectVariabilityFlag_All, lVisibleFlags,
 														true, NULL);
@@ -871,12 +874,16 @@ namespace hpl {
 
 		}
 		///////////////////////////
-		//Brute force
+		//Brute force, with software occlusion culling if set.
 		else
 		{
+			SetupSoftwareOcclusion(lVisibleFlags);
+
 			CheckForVisibleAndAddToList(mpCurrentWorld->GetRenderableContainer(eWorldContainerType_Static), lVisibleFlags);
 			CheckForVisibleAndAddToList(mpCurrentWorld->GetRenderableContainer(eWorldContainerType_Dynamic), lVisibleFlags);
 
+			mpCurrentSoftwareOcclusion = NULL;
+
 			mpCurrentRenderList->Compile(	eRenderListCompileFlag_Z |
 											eRenderListCompileFlag_Diffuse |
 											eRenderListCompileFlag_Translucent |
@@ -977,6 +984,8 @@ namespace hpl {
 
 	void cRendererDeferred::RenderZ()
 	{
+		PROFILE_ZONE(RenderZ)
+
 		START_RENDER_PASS(EarlyZ);
 
 		SetDepthTest(true);
@@ -1045,6 +1054,8 @@ namespace hpl {
 
 	void cRendererDeferred::RenderGbuffer()
 	{
+		PROFILE_ZONE(RenderGbuffer)
+
 		START_RENDER_PASS(GBuffer);
 
 		SetDepthTestFunc(eDepthTestFunc_Equal);
@@ -1232,6 +1243,8 @@ namespace hpl {
 
 	void cRendererDeferred::RenderEdgeSmooth()
 	{
+		PROFILE_ZONE(RenderEdgeSmooth)
+
 		if(mbEdgeSmoothLoaded==false || mpCurrentSettings->mbUseEdgeSmooth==false) return;
 		//if(mbEdgeSmoothLoaded==false) return;
 
@@ -1482,6 +1495,8 @@ namespace hpl {
 
 	void cRendererDeferred::RenderLightShadowMap(cDeferredLight* apLightData)
 	{
+		PROFILE_ZONE(RenderLightShadowMap)
+
 		//Setup render states
 		SetDepthTestFunc(eDepthTestFunc_LessOrEqual);
 
@@ -1633,6 +1648,8 @@ namespace hpl {
 
 	void cRendererDeferred::SetupLightsAndRenderQueries()
 	{
+		PROFILE_ZONE(SetupLightsAndRenderQueries)
+
 		//////////////////////////
 		// Check query results from last frame and clear list.
 		tLightSet setPrevVisibleLights;
@@ -2535,12 +2552,26 @@ namespace hpl {
 
 	void cRendererDeferred::RenderLights()
 	{
+		PROFILE_ZONE(RenderLights)
+
 		START_RENDER_PASS(Lights);
 
 		/////////////////////////////////////////
 		// Sort the Lights and place them in the lists
 		InitLightRendering();
 
+		/////////////////////////////////////////
+		// Get the shadow casters for all lights at once, so only the rendering is left when drawing each light.
+		mvShadowCastingLights.resize(0);
+		for(int i=0; i<eDeferredLightList_LastEnum; ++i)
+		{
+			for(size_t j=0; j<mvSortedLights[i].size(); ++j)
+			{
+				if(mvSortedLights[i][j]->mbCastShadows) mvShadowCastingLights.push_back(mvSortedLights[i][j]->mpLight);
+			}
+		}
+		PreGatherShadowCasters(mvShadowCastingLights);
+
 
 		/////////////////////////////////////////
 		// Render SSAO (used by box lights)
@@ -2589,6 +2620,8 @@ namespace hpl {
 		// Skip for now...
 		//RenderLights_Batches();
 
+		ClearPreGatheredShadowCasters();
+
 		////////////////////////////
 		//Reset settings
 		SetStencilActive(false);
@@ -2635,6 +2668,8 @@ namespace hpl {
 
 	void cRendererDeferred::RenderIllumination()
 	{
+		PROFILE_ZONE(RenderIllumination)
+
 		if(mpCurrentRenderList->ArrayHasObjects(eRenderListType_Illumination)==false) return;
 
 		START_RENDER_PASS(Illumination);
@@ -2677,6 +2712,8 @@ namespace hpl {
 
 	void cRendererDeferred::RenderDecals()
 	{
+		PROFILE_ZONE(RenderDecals)
+
 		if(mpCurrentRenderList->ArrayHasObjects(eRenderListType_Decal)==false) return;
 
 		START_RENDER_PASS(Decals);
@@ -2724,6 +2761,8 @@ namespace hpl {
 
 	void cRendererDeferred::RenderFullScreenFog()
 	{
+		PROFILE_ZONE(RenderFullScreenFog)
+
 		if(mpCurrentWorld->GetFogActive()==false) return;
 
 		START_RENDER_PASS(FullScreenFog);
@@ -2780,6 +2819,8 @@ namespace hpl {
 
 	void cRendererDeferred::RenderFog()
 	{
+		PROFILE_ZONE(RenderFog)
+
 		if(mpCurrentRenderList->GetFogAreaNum()==0)
 		{
 			mpCurrentSettings->mvFogRenderData.resize(0); //Make sure render data array is empty!
@@ -2877,6 +2918,8 @@ namespace hpl {
 
 	void cRendererDeferred::RenderTranslucent()
 	{
+		PROFILE_ZONE(RenderTranslucent)
+
 		if(mpCurrentRenderList->ArrayHasObjects(eRenderListType_Translucent)==false) return;
 
 		START_RENDER_PASS(Translucent);
@@ -3061,6 +3104,8 @@ namespace hpl {
 
 	void cRendererDeferred::RenderReflection(iRenderable *apObject)
 	{
+		PROFILE_ZONE(RenderReflection)
+
 		////////////////////////////////////
 		//Set up variables
 		cSubMeshEntity *pReflectionObject = static_cast<cSubMeshEntity*>(apObject);
@@ -0,0 +1,257 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "graphics/Skinning.h"
+
+#include "system/JobManager.h"
+#include "system/Platform.h"
+
+#ifdef HPL_USE_SSE
+	#include <xmmintrin.h>
+#endif
+
+namespace hpl {
+
+	//Below this many vertices, skinning is faster than adding jobs and waiting for them.
+	static const int kParallelGrainSize = 1024;
+
+	//////////////////////////////////////////////////////////////////////////
+	// SCALAR HELPERS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	static inline void MatrixFloatTransformSet(float *pDest, const cMatrixf &a_mtxA, const float* pSrc, const float fWeight)
+	{
+		pDest[0] = ( a_mtxA.m[0][0] * pSrc[0] + a_mtxA.m[0][1] * pSrc[1] + a_mtxA.m[0][2] * pSrc[2] + a_mtxA.m[0][3] ) * fWeight;
+		pDest[1] = ( a_mtxA.m[1][0] * pSrc[0] + a_mtxA.m[1][1] * pSrc[1] + a_mtxA.m[1][2] * pSrc[2] + a_mtxA.m[1][3] ) * fWeight;
+		pDest[2] = ( a_mtxA.m[2][0] * pSrc[0] + a_mtxA.m[2][1] * pSrc[1] + a_mtxA.m[2][2] * pSrc[2] + a_mtxA.m[2][3] ) * fWeight;
+	}
+
+	static inline void MatrixFloatRotateSet(float *pDest, const cMatrixf &a_mtxA, const float* pSrc, const float fWeight)
+	{
+		pDest[0] = ( a_mtxA.m[0][0] * pSrc[0] + a_mtxA.m[0][1] * pSrc[1] + a_mtxA.m[0][2] * pSrc[2] ) * fWeight;
+		pDest[1] = ( a_mtxA.m[1][0] * pSrc[0] + a_mtxA.m[1][1] * pSrc[1] + a_mtxA.m[1][2] * pSrc[2] ) * fWeight;
+		pDest[2] = ( a_mtxA.m[2][0] * pSrc[0] + a_mtxA.m[2][1] * pSrc[1] + a_mtxA.m[2][2] * pSrc[2] ) * fWeight;
+	}
+
+	//-----------------------------------------------------------------------
+
+	static inline void MatrixFloatTransformAdd(float *pDest, const cMatrixf &a_mtxA, const float* pSrc, const float fWeight)
+	{
+		pDest[0] += ( a_mtxA.m[0][0] * pSrc[0] + a_mtxA.m[0][1] * pSrc[1] + a_mtxA.m[0][2] * pSrc[2] + a_mtxA.m[0][3] ) * fWeight;
+		pDest[1] += ( a_mtxA.m[1][0] * pSrc[0] + a_mtxA.m[1][1] * pSrc[1] + a_mtxA.m[1][2] * pSrc[2] + a_mtxA.m[1][3] ) * fWeight;
+		pDest[2] += ( a_mtxA.m[2][0] * pSrc[0] + a_mtxA.m[2][1] * pSrc[1] + a_mtxA.m[2][2] * pSrc[2] + a_mtxA.m[2][3] ) * fWeight;
+	}
+
+	static inline void MatrixFloatRotateAdd(float *pDest, const cMatrixf &a_mtxA, const float* pSrc, const float fWeight)
+	{
+		pDest[0] += ( a_mtxA.m[0][0] * pSrc[0] + a_mtxA.m[0][1] * pSrc[1] + a_mtxA.m[0][2] * pSrc[2] ) * fWeight;
+		pDest[1] += ( a_mtxA.m[1][0] * pSrc[0] + a_mtxA.m[1][1] * pSrc[1] + a_mtxA.m[1][2] * pSrc[2] ) * fWeight;
+		pDest[2] += ( a_mtxA.m[2][0] * pSrc[0] + a_mtxA.m[2][1] * pSrc[1] + a_mtxA.m[2][2] * pSrc[2] ) * fWeight;
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// PUBLIC METHODS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	void cSkinning::SetupBoneColumns(const cMatrixf *apBoneMatrices, int alBoneNum, std::vector<float> &avColumns)
+	{
+		avColumns.resize(alBoneNum * 16);
+
+		float *pDest = alBoneNum > 0 ? &avColumns[0] : NULL;
+		for(int bone=0; bone<alBoneNum; ++bone)
+		{
+			const cMatrixf &mtx = apBoneMatrices[bone];
+			for(int col=0; col<4; ++col)
+			{
+				pDest[0] = mtx.m[0][col];
+				pDest[1] = mtx.m[1][col];
+				pDest[2] = mtx.m[2][col];
+				pDest[3] = 0;
+				pDest += 4;
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	static void SkinVerticesJob(void *apData, int alStart, int alEnd)
+	{
+		cSkinning::SkinVertices(*static_cast<const cSkinningData*>(apData), alStart, alEnd);
+	}
+
+	void cSkinning::SkinVerticesParallel(const cSkinningData &aData, int alVertexNum)
+	{
+		cJobManager *pJobManager = cJobManager::GetGlobal();
+		if(pJobManager==NULL || alVertexNum <= kParallelGrainSize)
+		{
+			SkinVertices(aData, 0, alVertexNum);
+			return;
+		}
+
+		//Ranges do not overlap and each vertex is only written by one job.
+		pJobManager->ParallelFor(0, alVertexNum, kParallelGrainSize, SkinVerticesJob, const_cast<cSkinningData*>(&aData));
+	}
+
+	//-----------------------------------------------------------------------
+
+	int cSkinning::GetParallelGrainSize()
+	{
+		return kParallelGrainSize;
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool cSkinning::UsesSimd()
+	{
+		#ifdef HPL_USE_SSE
+			return true;
+		#else
+			return false;
+		#endif
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cSkinning::SkinVerticesScalar(const cSkinningData &aData, int alStart, int alEnd)
+	{
+		for(int vtx=alStart; vtx < alEnd; ++vtx)
+		{
+			const float *pWeight = &aData.mpWeights[vtx*4];
+			if(pWeight[0]==0) continue;
+
+			const unsigned char *pBoneIdx = &aData.mpBones[vtx*4];
+
+			const float *pBindPos = &aData.mpBindPos[vtx*aData.mlPosStride];
+			const float *pBindNormal = &aData.mpBindNormal[vtx*3];
+			const float *pBindTangent = &aData.mpBindTangent[vtx*4];
+
+			float *pSkinPos = &aData.mpSkinPos[vtx*aData.mlPosStride];
+			float *pSkinNormal = &aData.mpSkinNormal[vtx*3];
+			float *pSkinTangent = &aData.mpSkinTangent[vtx*4];
+
+			const cMatrixf &mtxFirst = aData.mpBoneMatrices[pBoneIdx[0]];
+			MatrixFloatTransformSet(pSkinPos,mtxFirst, pBindPos, pWeight[0]);
+			MatrixFloatRotateSet(pSkinNormal,mtxFirst, pBindNormal, pWeight[0]);
+			MatrixFloatRotateSet(pSkinTangent,mtxFirst, pBindTangent, pWeight[0]);
+
+			//Iterate weights until 0 is found or all 4 are used
+			for(int i=1; i<4 && pWeight[i] != 0; ++i)
+			{
+				const cMatrixf &mtxTransform = aData.mpBoneMatrices[pBoneIdx[i]];
+
+				MatrixFloatTransformAdd(pSkinPos,mtxTransform, pBindPos, pWeight[i]);
+				MatrixFloatRotateAdd(pSkinNormal,mtxTransform, pBindNormal, pWeight[i]);
+				MatrixFloatRotateAdd(pSkinTangent,mtxTransform, pBindTangent, pWeight[i]);
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+#ifdef HPL_USE_SSE
+
+	// Only writes x,y,z so that w and the next vertex in packed arrays are left alone.
+	static inline void StoreVector3(float *apDest, __m128 aV)
+	{
+		_mm_storel_pi((__m64*)apDest, aV);
+		_mm_store_ss(apDest+2, _mm_movehl_ps(aV, aV));
+	}
+
+	void cSkinning::SkinVertices(const cSkinningData &aData, int alStart, int alEnd)
+	{
+		//The operations are done in the same order as the scalar version, which means the result is exactly the same.
+		for(int vtx=alStart; vtx < alEnd; ++vtx)
+		{
+			const float *pWeight = &aData.mpWeights[vtx*4];
+			if(pWeight[0]==0) continue;
+
+			const unsigned char *pBoneIdx = &aData.mpBones[vtx*4];
+
+			const float *pBindPos = &aData.mpBindPos[vtx*aData.mlPosStride];
+			const float *pBindNormal = &aData.mpBindNormal[vtx*3];
+			const float *pBindTangent = &aData.mpBindTangent[vtx*4];
+
+			const __m128 vPosX = _mm_set1_ps(pBindPos[0]);
+			const __m128 vPosY = _mm_set1_ps(pBindPos[1]);
+			const __m128 vPosZ = _mm_set1_ps(pBindPos[2]);
+			const __m128 vNrmX = _mm_set1_ps(pBindNormal[0]);
+			const __m128 vNrmY = _mm_set1_ps(pBindNormal[1]);
+			const __m128 vNrmZ = _mm_set1_ps(pBindNormal[2]);
+			const __m128 vTanX = _mm_set1_ps(pBindTangent[0]);
+			const __m128 vTanY = _mm_set1_ps(pBindTangent[1]);
+			const __m128 vTanZ = _mm_set1_ps(pBindTangent[2]);
+
+			__m128 vSkinPos = _mm_setzero_ps();
+			__m128 vSkinNormal = _mm_setzero_ps();
+			__m128 vSkinTangent = _mm_setzero_ps();
+
+			for(int i=0; i<4 && pWeight[i] != 0; ++i)
+			{
+				const float *pCols = &aData.mpBoneColumns[pBoneIdx[i]*16];
+				const __m128 vCol0 = _mm_loadu_ps(pCols);
+				const __m128 vCol1 = _mm_loadu_ps(pCols+4);
+				const __m128 vCol2 = _mm_loadu_ps(pCols+8);
+				const __m128 vCol3 = _mm_loadu_ps(pCols+12);
+				const __m128 vWeight = _mm_set1_ps(pWeight[i]);
+
+				__m128 vPos = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vCol0,vPosX), _mm_mul_ps(vCol1,vPosY)), _mm_mul_ps(vCol2,vPosZ)), vCol3);
+				__m128 vNormal = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vCol0,vNrmX), _mm_mul_ps(vCol1,vNrmY)), _mm_mul_ps(vCol2,vNrmZ));
+				__m128 vTangent = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vCol0,vTanX), _mm_mul_ps(vCol1,vTanY)), _mm_mul_ps(vCol2,vTanZ));
+
+				vPos = _mm_mul_ps(vPos, vWeight);
+				vNormal = _mm_mul_ps(vNormal, vWeight);
+				vTangent = _mm_mul_ps(vTangent, vWeight);
+
+				if(i==0)
+				{
+					vSkinPos = vPos;
+					vSkinNormal = vNormal;
+					vSkinTangent = vTangent;
+				}
+				else
+				{
+					vSkinPos = _mm_add_ps(vSkinPos, vPos);
+					vSkinNormal = _mm_add_ps(vSkinNormal, vNormal);
+					vSkinTangent = _mm_add_ps(vSkinTangent, vTangent);
+				}
+			}
+
+			StoreVector3(&aData.mpSkinPos[vtx*aData.mlPosStride], vSkinPos);
+			StoreVector3(&aData.mpSkinNormal[vtx*3], vSkinNormal);
+			StoreVector3(&aData.mpSkinTangent[vtx*4], vSkinTangent);
+		}
+	}
+
+#else
+
+	void cSkinning::SkinVertices(const cSkinningData &aData, int alStart, int alEnd)
+	{
+		SkinVerticesScalar(aData, alStart, alEnd);
+	}
+
+#endif
+
+	//-----------------------------------------------------------------------
+}
@@ -0,0 +1,494 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "graphics/SoftwareOcclusion.h"
+
+#include "graphics/Renderable.h"
+#include "graphics/VertexBuffer.h"
+
+#include "math/Math.h"
+#include "math/Frustum.h"
+
+#include "system/JobManager.h"
+#include "system/Profiler.h"
+#include "system/Platform.h"
+
+#include <math.h>
+
+#ifdef HPL_USE_SSE
+	#include <xmmintrin.h>
+#endif
+
+namespace hpl {
+
+	//Size in pixels of the side of the tiles that keep the farthest depth.
+	static const int glTileSize = 8;
+
+	//////////////////////////////////////////////////////////////////////////
+	// CONSTRUCTORS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	cSoftwareOcclusion::cSoftwareOcclusion(int alWidth, int alHeight)
+	{
+		mlTilesX = cMath::Max((alWidth + glTileSize-1) / glTileSize, 1);
+		mlTilesY = cMath::Max((alHeight + glTileSize-1) / glTileSize, 1);
+		mlWidth = mlTilesX * glTileSize;
+		mlHeight = mlTilesY * glTileSize;
+
+		mvDepth.resize(mlWidth * mlHeight, 0.0f);
+		mvTileDepth.resize(mlTilesX * mlTilesY, 0.0f);
+
+		mbActive = false;
+		m_mtxViewProj = cMatrixf::Identity;
+		mfNearClipW = 0;
+	}
+
+	//-----------------------------------------------------------------------
+
+	cSoftwareOcclusion::~cSoftwareOcclusion()
+	{
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// PUBLIC METHODS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	bool cSoftwareOcclusion::BeginFrame(cFrustum *apFrustum)
+	{
+		mvOccluders.resize(0);
+
+		std::fill(mvDepth.begin(), mvDepth.end(), 0.0f);
+		std::fill(mvTileDepth.begin(), mvTileDepth.end(), 0.0f);
+
+		//1/w is only a depth for perspective projections.
+		mbActive = apFrustum->GetProjectionType() == eProjectionType_Perspective;
+		if(mbActive==false) return false;
+
+		m_mtxViewProj = cMath::MatrixMul(apFrustum->GetProjectionMatrix(), apFrustum->GetViewMatrix());
+		mfNearClipW = apFrustum->GetNearPlane();
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cSoftwareOcclusion::AddOccluder(iRenderable *apObject)
+	{
+		iVertexBuffer *pVtxBuffer = apObject->GetVertexBuffer();
+		if(pVtxBuffer==NULL || pVtxBuffer->GetIndexNum() < 3) return;
+
+		const float *pPositions = pVtxBuffer->GetFloatArray(eVertexBufferElement_Position);
+		if(pPositions==NULL) return;
+
+		cMatrixf *pModelMatrix = apObject->GetModelMatrix(NULL);
+
+		AddOccluderMesh(pPositions, pVtxBuffer->GetElementNum(eVertexBufferElement_Position),
+						pVtxBuffer->GetIndices(), pVtxBuffer->GetIndexNum(),
+						pModelMatrix ? *pModelMatrix : cMatrixf::Identity);
+	}
+
+	void cSoftwareOcclusion::AddOccluderMesh(const float *apPositions, int alStride, const unsigned int *apIndices, int alIndexNum, const cMatrixf &a_mtxModel)
+	{
+		if(mbActive==false) return;
+
+		cSoftOcclusionMesh mesh;
+		mesh.mpPositions = apPositions;
+		mesh.mlStride = alStride;
+		mesh.mpIndices = apIndices;
+		mesh.mlIndexNum = alIndexNum;
+		mesh.m_mtxModel = a_mtxModel;
+
+		mvOccluders.push_back(mesh);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cSoftwareOcclusion::Rasterize()
+	{
+		PROFILE_ZONE(SoftwareOcclusionRasterize)
+
+		if(mbActive==false) return;
+
+		if((int)mvOccluderTriangles.size() < (int)mvOccluders.size())
+			mvOccluderTriangles.resize(mvOccluders.size());
+
+		cJobManager *pJobManager = cJobManager::GetGlobal();
+
+		////////////////////////////
+		//Transform and clip the occluders, each one writes its own triangle list.
+		if(pJobManager)	pJobManager->ParallelFor(0, (int)mvOccluders.size(), 4, TransformOccludersJob, this);
+		else			TransformOccludersJob(this, 0, (int)mvOccluders.size());
+
+		////////////////////////////
+		//Draw all triangles into rows of tiles, no two jobs ever touch the same pixels.
+		if(pJobManager)	pJobManager->ParallelFor(0, mlTilesY, 1, RasterizeTileRowsJob, this);
+		else			RasterizeTileRowsJob(this, 0, mlTilesY);
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool cSoftwareOcclusion::IsAABBVisible(const cVector3f &avMin, const cVector3f &avMax) const
+	{
+		if(mbActive==false) return true;
+
+		////////////////////////////
+		//Project corners, get screen rect and closest depth
+		float fMinX = 1e30f, fMinY = 1e30f;
+		float fMaxX = -1e30f, fMaxY = -1e30f;
+		float fMaxInvW = 0;
+
+		const cMatrixf &mtx = m_mtxViewProj;
+		for(int i=0; i<8; ++i)
+		{
+			float fX = (i & 1) ? avMax.x : avMin.x;
+			float fY = (i & 2) ? avMax.y : avMin.y;
+			float fZ = (i & 4) ? avMax.z : avMin.z;
+
+			float fW = mtx.m[3][0]*fX + mtx.m[3][1]*fY + mtx.m[3][2]*fZ + mtx.m[3][3];
+
+			//Box crosses the near plane, the camera might be inside.
+			if(fW < mfNearClipW) return true;
+
+			float fInvW = 1.0f / fW;
+			float fSX = ((mtx.m[0][0]*fX + mtx.m[0][1]*fY + mtx.m[0][2]*fZ + mtx.m[0][3]) * fInvW * 0.5f + 0.5f) * (float)mlWidth;
+			float fSY = ((mtx.m[1][0]*fX + mtx.m[1][1]*fY + mtx.m[1][2]*fZ + mtx.m[1][3]) * fInvW * 0.5f + 0.5f) * (float)mlHeight;
+
+			if(fSX < fMinX) fMinX = fSX;
+			if(fSX > fMaxX) fMaxX = fSX;
+			if(fSY < fMinY) fMinY = fSY;
+			if(fSY > fMaxY) fMaxY = fSY;
+			if(fInvW > fMaxInvW) fMaxInvW = fInvW;
+		}
+
+		//Outside of screen, leave that to the frustum test.
+		if(fMaxX < 0 || fMinX >= (float)mlWidth || fMaxY < 0 || fMinY >= (float)mlHeight) return true;
+
+		//Occluders only cover the pixels whose centers are inside them, so a pixel can be marked as covered while
+		//part of it is not. Growing the rect by one pixel makes sure the uncovered neighbour is checked too.
+		int lX0 = cMath::Max((int)floorf(fMinX) - 1, 0);
+		int lY0 = cMath::Max((int)floorf(fMinY) - 1, 0);
+		int lX1 = cMath::Min((int)floorf(fMaxX) + 1, mlWidth-1);
+		int lY1 = cMath::Min((int)floorf(fMaxY) + 1, mlHeight-1);
+
+		////////////////////////////
+		//Check tiles, if the farthest depth in a tile is closer than the box, it is hidden there.
+		for(int lTileY = lY0 / glTileSize; lTileY <= lY1 / glTileSize; ++lTileY)
+		for(int lTileX = lX0 / glTileSize; lTileX <= lX1 / glTileSize; ++lTileX)
+		{
+			if(mvTileDepth[lTileY*mlTilesX + lTileX] > fMaxInvW) continue;
+
+			//Tile is not hidden in full, check the pixels covered by the box.
+			int lPX0 = cMath::Max(lX0, lTileX * glTileSize);
+			int lPX1 = cMath::Min(lX1, lTileX * glTileSize + glTileSize-1);
+			int lPY0 = cMath::Max(lY0, lTileY * glTileSize);
+			int lPY1 = cMath::Min(lY1, lTileY * glTileSize + glTileSize-1);
+
+			for(int y=lPY0; y<=lPY1; ++y)
+			{
+				const float *pRow = &mvDepth[y * mlWidth];
+				for(int x=lPX0; x<=lPX1; ++x)
+				{
+					if(pRow[x] <= fMaxInvW) return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	//-----------------------------------------------------------------------
+
+	int cSoftwareOcclusion::GetTriangleNum() const
+	{
+		int lCount =0;
+		for(size_t i=0; i<mvOccluders.size(); ++i)
+			lCount += (int)mvOccluderTriangles[i].size();
+		return lCount;
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool cSoftwareOcclusion::UsesSimd()
+	{
+		#ifdef HPL_USE_SSE
+			return true;
+		#else
+			return false;
+		#endif
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// PRIVATE METHODS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	void cSoftwareOcclusion::TransformOccludersJob(void *apData, int alStart, int alEnd)
+	{
+		cSoftwareOcclusion *pOcclusion = static_cast<cSoftwareOcclusion*>(apData);
+		for(int i=alStart; i<alEnd; ++i) pOcclusion->TransformOccluder(i);
+	}
+
+	void cSoftwareOcclusion::RasterizeTileRowsJob(void *apData, int alStart, int alEnd)
+	{
+		cSoftwareOcclusion *pOcclusion = static_cast<cSoftwareOcclusion*>(apData);
+
+		for(int lTileY=alStart; lTileY<alEnd; ++lTileY)
+		{
+			int lY0 = lTileY * glTileSize;
+			int lY1 = lY0 + glTileSize;
+
+			for(size_t i=0; i<pOcclusion->mvOccluders.size(); ++i)
+			{
+				const tSoftOcclusionTriangleVec &vTriangles = pOcclusion->mvOccluderTriangles[i];
+				for(size_t j=0; j<vTriangles.size(); ++j)
+				{
+					pOcclusion->RasterizeTriangle(vTriangles[j], lY0, lY1);
+				}
+			}
+
+			pOcclusion->BuildTileDepth(lTileY);
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cSoftwareOcclusion::TransformOccluder(int alIdx)
+	{
+		const cSoftOcclusionMesh &mesh = mvOccluders[alIdx];
+		tSoftOcclusionTriangleVec &vTriangles = mvOccluderTriangles[alIdx];
+		vTriangles.resize(0);
+
+		cMatrixf mtx = cMath::MatrixMul(m_mtxViewProj, mesh.m_mtxModel);
+
+		for(int i=0; i+2 < mesh.mlIndexNum; i+=3)
+		{
+			//Clip space position, z is not needed so w is stored in it.
+			cVector3f vClipPos[3];
+			for(int j=0; j<3; ++j)
+			{
+				const float *pPos = &mesh.mpPositions[mesh.mpIndices[i+j] * mesh.mlStride];
+				vClipPos[j].x = mtx.m[0][0]*pPos[0] + mtx.m[0][1]*pPos[1] + mtx.m[0][2]*pPos[2] + mtx.m[0][3];
+				vClipPos[j].y = mtx.m[1][0]*pPos[0] + mtx.m[1][1]*pPos[1] + mtx.m[1][2]*pPos[2] + mtx.m[1][3];
+				vClipPos[j].z = mtx.m[3][0]*pPos[0] + mtx.m[3][1]*pPos[1] + mtx.m[3][2]*pPos[2] + mtx.m[3][3];
+			}
+
+			//Skip if all are outside one of the side planes
+			if(vClipPos[0].x >  vClipPos[0].z && vClipPos[1].x >  vClipPos[1].z && vClipPos[2].x >  vClipPos[2].z) continue;
+			if(vClipPos[0].x < -vClipPos[0].z && vClipPos[1].x < -vClipPos[1].z && vClipPos[2].x < -vClipPos[2].z) continue;
+			if(vClipPos[0].y >  vClipPos[0].z && vClipPos[1].y >  vClipPos[1].z && vClipPos[2].y >  vClipPos[2].z) continue;
+			if(vClipPos[0].y < -vClipPos[0].z && vClipPos[1].y < -vClipPos[1].z && vClipPos[2].y < -vClipPos[2].z) continue;
+
+			////////////////////////////
+			//Clip against near plane, gives up to 4 points.
+			int lInsideNum =0;
+			for(int j=0; j<3; ++j) if(vClipPos[j].z >= mfNearClipW) lInsideNum++;
+
+			if(lInsideNum==0) continue;
+			if(lInsideNum==3)
+			{
+				AddTriangle(vClipPos, &vTriangles);
+				continue;
+			}
+
+			cVector3f vPoly[4];
+			int lPolyNum =0;
+			for(int j=0; j<3; ++j)
+			{
+				const cVector3f &vA = vClipPos[j];
+				const cVector3f &vB = vClipPos[(j+1)%3];
+				bool bAInside = vA.z >= mfNearClipW;
+				bool bBInside = vB.z >= mfNearClipW;
+
+				if(bAInside) vPoly[lPolyNum++] = vA;
+				if(bAInside != bBInside)
+				{
+					float fT = (mfNearClipW - vA.z) / (vB.z - vA.z);
+					vPoly[lPolyNum++] = vA + (vB - vA) * fT;
+				}
+			}
+
+			AddTriangle(vPoly, &vTriangles);
+			if(lPolyNum==4)
+			{
+				cVector3f vSecond[3] = {vPoly[0], vPoly[2], vPoly[3]};
+				AddTriangle(vSecond, &vTriangles);
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cSoftwareOcclusion::AddTriangle(const cVector3f *apClipPos, tSoftOcclusionTriangleVec *apTriangles)
+	{
+		cSoftOcclusionTriangle tri;
+		for(int i=0; i<3; ++i)
+		{
+			float fInvW = 1.0f / apClipPos[i].z;
+			tri.mfX[i] = (apClipPos[i].x * fInvW * 0.5f + 0.5f) * (float)mlWidth;
+			tri.mfY[i] = (apClipPos[i].y * fInvW * 0.5f + 0.5f) * (float)mlHeight;
+			tri.mfInvW[i] = fInvW;
+		}
+
+		//Make all triangles counter clockwise, occluders are drawn from both sides.
+		float fArea = (tri.mfX[1] - tri.mfX[0]) * (tri.mfY[2] - tri.mfY[0]) - (tri.mfX[2] - tri.mfX[0]) * (tri.mfY[1] - tri.mfY[0]);
+		if(fabsf(fArea) < 1e-6f) return;
+		if(fArea < 0)
+		{
+			std::swap(tri.mfX[1], tri.mfX[2]);
+			std::swap(tri.mfY[1], tri.mfY[2]);
+			std::swap(tri.mfInvW[1], tri.mfInvW[2]);
+		}
+
+		apTriangles->push_back(tri);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cSoftwareOcclusion::RasterizeTriangle(const cSoftOcclusionTriangle &aTri, int alY0, int alY1)
+	{
+		////////////////////////////
+		//Bounds within the rows
+		float fMinX = cMath::Min(aTri.mfX[0], cMath::Min(aTri.mfX[1], aTri.mfX[2]));
+		float fMaxX = cMath::Max(aTri.mfX[0], cMath::Max(aTri.mfX[1], aTri.mfX[2]));
+		float fMinY = cMath::Min(aTri.mfY[0], cMath::Min(aTri.mfY[1], aTri.mfY[2]));
+		float fMaxY = cMath::Max(aTri.mfY[0], cMath::Max(aTri.mfY[1], aTri.mfY[2]));
+
+		if(fMaxY < (float)alY0 || fMinY >= (float)alY1) return;
+		if(fMaxX < 0 || fMinX >= (float)mlWidth) return;
+
+		int lX0 = cMath::Max((int)floorf(fMinX), 0) & ~3;
+		int lX1 = cMath::Min((int)ceilf(fMaxX), mlWidth);
+		int lY0 = cMath::Max((int)floorf(fMinY), alY0);
+		int lY1 = cMath::Min((int)ceilf(fMaxY), alY1);
+
+		////////////////////////////
+		//Edge functions E(x,y) = A*x + B*y + C, all positive inside.
+		float fA[3], fB[3], fC[3];
+		for(int i=0; i<3; ++i)
+		{
+			int lNext = (i+1)%3;
+			fA[i] = -(aTri.mfY[lNext] - aTri.mfY[i]);
+			fB[i] = aTri.mfX[lNext] - aTri.mfX[i];
+			fC[i] = -(fA[i] * aTri.mfX[i] + fB[i] * aTri.mfY[i]);
+		}
+
+		//Depth plane from the barycentric weights. Edge i is opposite to vertex (i+2)%3.
+		float fArea = fA[0] * aTri.mfX[2] + fB[0] * aTri.mfY[2] + fC[0];
+		float fInvArea = 1.0f / fArea;
+		float fDA = (fA[1] * aTri.mfInvW[0] + fA[2] * aTri.mfInvW[1] + fA[0] * aTri.mfInvW[2]) * fInvArea;
+		float fDB = (fB[1] * aTri.mfInvW[0] + fB[2] * aTri.mfInvW[1] + fB[0] * aTri.mfInvW[2]) * fInvArea;
+		float fDC = (fC[1] * aTri.mfInvW[0] + fC[2] * aTri.mfInvW[1] + fC[0] * aTri.mfInvW[2]) * fInvArea;
+
+	#ifdef HPL_USE_SSE
+		const __m128 vZero = _mm_setzero_ps();
+		const __m128 vOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+		const __m128 vA0 = _mm_set1_ps(fA[0]), vA1 = _mm_set1_ps(fA[1]), vA2 = _mm_set1_ps(fA[2]);
+		const __m128 vDA = _mm_set1_ps(fDA);
+
+		for(int y=lY0; y<lY1; ++y)
+		{
+			float fPY = (float)y + 0.5f;
+			__m128 vRow0 = _mm_set1_ps(fB[0] * fPY + fC[0]);
+			__m128 vRow1 = _mm_set1_ps(fB[1] * fPY + fC[1]);
+			__m128 vRow2 = _mm_set1_ps(fB[2] * fPY + fC[2]);
+			__m128 vRowDepth = _mm_set1_ps(fDB * fPY + fDC);
+
+			float *pRow = &mvDepth[y * mlWidth];
+			for(int x=lX0; x<lX1; x+=4)
+			{
+				__m128 vPX = _mm_add_ps(_mm_set1_ps((float)x), vOffsets);
+
+				__m128 vE0 = _mm_add_ps(_mm_mul_ps(vA0, vPX), vRow0);
+				__m128 vE1 = _mm_add_ps(_mm_mul_ps(vA1, vPX), vRow1);
+				__m128 vE2 = _mm_add_ps(_mm_mul_ps(vA2, vPX), vRow2);
+				__m128 vMask = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(vE0, vZero), _mm_cmpge_ps(vE1, vZero)), _mm_cmpge_ps(vE2, vZero));
+				if(_mm_movemask_ps(vMask)==0) continue;
+
+				__m128 vDepth = _mm_add_ps(_mm_mul_ps(vDA, vPX), vRowDepth);
+				__m128 vOld = _mm_loadu_ps(&pRow[x]);
+				__m128 vNew = _mm_max_ps(vOld, vDepth);
+				_mm_storeu_ps(&pRow[x], _mm_or_ps(_mm_and_ps(vMask, vNew), _mm_andnot_ps(vMask, vOld)));
+			}
+		}
+	#else
+		for(int y=lY0; y<lY1; ++y)
+		{
+			float fPY = (float)y + 0.5f;
+			float *pRow = &mvDepth[y * mlWidth];
+			for(int x=lX0; x<lX1; ++x)
+			{
+				float fPX = (float)x + 0.5f;
+				if(	fA[0]*fPX + fB[0]*fPY + fC[0] < 0 ||
+					fA[1]*fPX + fB[1]*fPY + fC[1] < 0 ||
+					fA[2]*fPX + fB[2]*fPY + fC[2] < 0)
+				{
+					continue;
+				}
+
+				float fDepth = fDA*fPX + fDB*fPY + fDC;
+				if(fDepth > pRow[x]) pRow[x] = fDepth;
+			}
+		}
+	#endif
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cSoftwareOcclusion::BuildTileDepth(int alTileY)
+	{
+		for(int lTileX=0; lTileX<mlTilesX; ++lTileX)
+		{
+			const float *pTile = &mvDepth[alTileY * glTileSize * mlWidth + lTileX * glTileSize];
+
+		#ifdef HPL_USE_SSE
+			__m128 vMin = _mm_loadu_ps(pTile);
+			for(int y=0; y<glTileSize; ++y)
+			{
+				const float *pRow = pTile + y * mlWidth;
+				vMin = _mm_min_ps(vMin, _mm_min_ps(_mm_loadu_ps(pRow), _mm_loadu_ps(pRow+4)));
+			}
+			vMin = _mm_min_ps(vMin, _mm_shuffle_ps(vMin, vMin, _MM_SHUFFLE(1,0,3,2)));
+			vMin = _mm_min_ps(vMin, _mm_shuffle_ps(vMin, vMin, _MM_SHUFFLE(2,3,0,1)));
+			float fMin;
+			_mm_store_ss(&fMin, vMin);
+		#else
+			float fMin = pTile[0];
+			for(int y=0; y<glTileSize; ++y)
+			for(int x=0; x<glTileSize; ++x)
+			{
+				fMin = cMath::Min(fMin, pTile[y * mlWidth + x]);
+			}
+		#endif
+
+			mvTileDepth[alTileY * mlTilesX + lTileX] = fMin;
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+}
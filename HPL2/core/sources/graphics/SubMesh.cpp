@@ -298,6 +298,7 @@ namespace hpl {
 		mpVertexWeights = hplNewArray( float, 4 * mpVtxBuffer->GetVertexNum());
 		mpVertexBones = hplNewArray( unsigned char, 4 * mpVtxBuffer->GetVertexNum()) ;
 		memset(mpVertexWeights,0,4 * mpVtxBuffer->GetVertexNum()*sizeof(float));
+		memset(mpVertexBones,0,4 * mpVtxBuffer->GetVertexNum()*sizeof(unsigned char));
 		bool bWarn = true;
 		///////////////////////////////////
 		// Iterate pairs and fill arrays
@@ -24,6 +24,8 @@
 #include "system/Platform.h"
 #include "resources/BinaryBuffer.h"
 
+#include <cstring>
+
 namespace hpl {
 
 	//////////////////////////////////////////////////////////////////////////
@@ -422,6 +424,58 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	class cNewtonMemoryReader
+	{
+	public:
+		const char *mpData;
+		size_t mlPos;
+		size_t mlSize;
+	};
+
+	static void NewtonReadFromMemory(void* apSerializeHandle, void* apNewtonBuffer, int alSize)
+	{
+		cNewtonMemoryReader *pReader = (cNewtonMemoryReader*)apSerializeHandle;
+
+		size_t lSize = (size_t)alSize;
+		if(pReader->mlPos + lSize > pReader->mlSize)
+		{
+			Error("Reading past the end of serialized collision data!\n");
+			memset(apNewtonBuffer, 0, lSize);
+			lSize = pReader->mlPos < pReader->mlSize ? pReader->mlSize - pReader->mlPos : 0;
+		}
+
+		memcpy(apNewtonBuffer, pReader->mpData + pReader->mlPos, lSize);
+		pReader->mlPos += lSize;
+	}
+
+	bool cCollideShapeNewton::CreateFromSerializedMemory(const void *apData, size_t alSize)
+	{
+		//Must at least hold the bounds
+		float vBounds[6];
+		if(alSize < sizeof(vBounds))
+		{
+			Error("Serialized collision data is too small (%d bytes)!\n", (int)alSize);
+			return false;
+		}
+
+		cNewtonMemoryReader reader;
+		reader.mpData = (const char*)apData;
+		reader.mlPos = sizeof(float)*6;
+		reader.mlSize = alSize;
+
+		//Same layout as SaveToSerializedData
+		memcpy(vBounds, apData, sizeof(vBounds));
+
+		mpNewtonCollision = NewtonCreateCollisionFromSerialization (mpNewtonWorld, NewtonReadFromMemory, (void*)&reader);
+		if(mpNewtonCollision==NULL) return false;
+
+		mBoundingVolume.SetLocalMinMax(cVector3f(vBounds[0],vBounds[1],vBounds[2]), cVector3f(vBounds[3],vBounds[4],vBounds[5]));
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------
+
 	//////////////////////////////////////////////////////////////////////////
 	// PRIVATE METHODS
 	//////////////////////////////////////////////////////////////////////////
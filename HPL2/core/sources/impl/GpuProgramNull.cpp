@@ -0,0 +1,97 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "impl/GpuProgramNull.h"
+
+#include "impl/LowLevelGraphicsNull.h"
+
+namespace hpl {
+
+	//////////////////////////////////////////////////////////////////////////
+	// CONSTRUCTORS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	cGpuProgramNull::cGpuProgramNull(const tString& asName, eGpuProgramFormat aProgramFormat, cLowLevelGraphicsNull* apLowLevelGraphics)
+		: iGpuProgram(asName, aProgramFormat)
+	{
+		mpNullGraphics = apLowLevelGraphics;
+
+		mlId = mpNullGraphics->GetNewResourceId();
+		mlLastUsedPass =0;
+	}
+
+	cGpuProgramNull::~cGpuProgramNull()
+	{
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// PUBLIC METHODS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	void cGpuProgramNull::Bind()
+	{
+		mpNullGraphics->AddCommand(eNullGfxCommand_BindProgram, 0, mlId, &mlLastUsedPass);
+	}
+
+	//-----------------------------------------------------------------------
+
+	int cGpuProgramNull::GetVariableId(const tString& asName)
+	{
+		std::map<tString, int>::iterator it = m_mapVariableIds.find(asName);
+		if(it != m_mapVariableIds.end()) return it->second;
+
+		int lId = (int)m_mapVariableIds.size();
+		m_mapVariableIds.insert(std::map<tString, int>::value_type(asName, lId));
+
+		return lId;
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool cGpuProgramNull::SetInt(int alVarId, int alX){ return RecordVariableSet(alVarId);}
+	bool cGpuProgramNull::SetFloat(int alVarId, float afX){ return RecordVariableSet(alVarId);}
+	bool cGpuProgramNull::SetVec2f(int alVarId, float afX,float afY){ return RecordVariableSet(alVarId);}
+	bool cGpuProgramNull::SetVec3f(int alVarId, float afX,float afY,float afZ){ return RecordVariableSet(alVarId);}
+	bool cGpuProgramNull::SetVec4f(int alVarId, float afX,float afY,float afZ, float afW){ return RecordVariableSet(alVarId);}
+	bool cGpuProgramNull::SetMatrixf(int alVarId, const cMatrixf& mMtx){ return RecordVariableSet(alVarId);}
+	bool cGpuProgramNull::SetMatrixf(int alVarId, eGpuShaderMatrix mType, eGpuShaderMatrixOp mOp){ return RecordVariableSet(alVarId);}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// PRIVATE METHODS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	bool cGpuProgramNull::RecordVariableSet(int alVarId)
+	{
+		if(alVarId < 0) return false;
+
+		mpNullGraphics->AddCommand(eNullGfxCommand_SetProgramVar, 0, (unsigned int)alVarId);
+		return true;
+	}
+
+	//-----------------------------------------------------------------------
+}
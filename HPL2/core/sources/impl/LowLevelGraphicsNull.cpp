@@ -0,0 +1,976 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "impl/LowLevelGraphicsNull.h"
+
+#include <string.h>
+
+#include "system/LowLevelSystem.h"
+
+#include "impl/SDLFontData.h"
+#include "impl/TextureNull.h"
+#include "impl/VertexBufferNull.h"
+#include "impl/GpuProgramNull.h"
+#include "impl/FrameBufferNull.h"
+#include "impl/OcclusionQueryNull.h"
+
+#include "graphics/Bitmap.h"
+
+namespace hpl {
+
+	//////////////////////////////////////////////////////////////////////////
+	// HELPERS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	static const unsigned int kStateHashStart = 2166136261U;
+
+	static inline unsigned int HashState(unsigned int alHash, unsigned int alX)
+	{
+		return (alHash ^ alX) * 16777619U;
+	}
+
+	static inline unsigned int HashState(unsigned int alHash, float afX)
+	{
+		unsigned int lX;
+		memcpy(&lX, &afX, sizeof(float));
+		return HashState(alHash, lX);
+	}
+
+	static inline unsigned int HashState(unsigned int alHash, const cColor& aCol)
+	{
+		alHash = HashState(alHash, aCol.r);
+		alHash = HashState(alHash, aCol.g);
+		alHash = HashState(alHash, aCol.b);
+		return HashState(alHash, aCol.a);
+	}
+
+	static inline unsigned int HashState(unsigned int alHash, const cMatrixf& a_mtxA)
+	{
+		for(int i=0; i<16; ++i) alHash = HashState(alHash, a_mtxA.v[i]);
+		return alHash;
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// PASS STATS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	cNullGfxPassStats::cNullGfxPassStats()
+	{
+		mlCommandStart =0;
+		mlCommandNum =0;
+
+		mlDrawCalls =0;
+		mlImmediateDrawCalls =0;
+		mlIndicesDrawn =0;
+
+		mlStateChanges =0;
+		mlRedundantStateChanges =0;
+
+		mlTextureBinds =0;
+		mlProgramBinds =0;
+		mlVertexBufferBinds =0;
+		mlProgramVarSets =0;
+
+		mlUniqueTextures =0;
+		mlUniquePrograms =0;
+		mlUniqueVertexBuffers =0;
+
+		mlClears =0;
+		mlOcclusionQueries =0;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cNullGfxPassStats::Add(const cNullGfxPassStats &aStats)
+	{
+		mlCommandNum += aStats.mlCommandNum;
+
+		mlDrawCalls += aStats.mlDrawCalls;
+		mlImmediateDrawCalls += aStats.mlImmediateDrawCalls;
+		mlIndicesDrawn += aStats.mlIndicesDrawn;
+
+		mlStateChanges += aStats.mlStateChanges;
+		mlRedundantStateChanges += aStats.mlRedundantStateChanges;
+
+		mlTextureBinds += aStats.mlTextureBinds;
+		mlProgramBinds += aStats.mlProgramBinds;
+		mlVertexBufferBinds += aStats.mlVertexBufferBinds;
+		mlProgramVarSets += aStats.mlProgramVarSets;
+
+		mlUniqueTextures += aStats.mlUniqueTextures;
+		mlUniquePrograms += aStats.mlUniquePrograms;
+		mlUniqueVertexBuffers += aStats.mlUniqueVertexBuffers;
+
+		mlClears += aStats.mlClears;
+		mlOcclusionQueries += aStats.mlOcclusionQueries;
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// CONSTRUCTORS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	cLowLevelGraphicsNull::cLowLevelGraphicsNull()
+	{
+		mvScreenSize = cVector2l(800,600);
+		mlMultisampling =0;
+		mGpuProgramFormat = eGpuProgramFormat_GLSL;
+		mfGammaCorrection = 1.0f;
+
+		mpFrameBuffer = NULL;
+
+		mlBatchVertexNum =0;
+		mlBatchIndexNum =0;
+
+		mbRecordCommands = true;
+		mlOcclusionQuerySampleCount = 0xFFFFFF;
+		mlResourceIdCount =0;
+
+		memset(mvLastStateValue, 0, sizeof(mvLastStateValue));
+		memset(mvLastStateIsSet, 0, sizeof(mvLastStateIsSet));
+
+		mlPassCount =0;
+		mlTotalFrameCount =0;
+
+		BeginPass(NULL);
+	}
+
+	//-----------------------------------------------------------------------
+
+	cLowLevelGraphicsNull::~cLowLevelGraphicsNull()
+	{
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// GENERAL SETUP
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	bool cLowLevelGraphicsNull::Init(	int alWidth, int alHeight, int alDisplay, int alBpp, int abFullscreen, int alMultisampling,
+										eGpuProgramFormat aGpuProgramFormat,const tString& asWindowCaption,
+										const cVector2l &avWindowPos)
+	{
+		mvScreenSize.x = alWidth;
+		mvScreenSize.y = alHeight;
+		mlMultisampling = alMultisampling;
+		mGpuProgramFormat = aGpuProgramFormat;
+
+		Log(" Using null graphics: %d x %d, nothing is drawn and all commands are recorded.\n", alWidth, alHeight);
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------
+
+	int cLowLevelGraphicsNull::GetCaps(eGraphicCaps aType)
+	{
+		switch(aType)
+		{
+		case eGraphicCaps_TextureTargetRectangle:	return 1;
+		case eGraphicCaps_VertexBufferObject:		return 1;
+		case eGraphicCaps_TwoSideStencil:			return 1;
+
+		case eGraphicCaps_MaxTextureImageUnits:		return 16;
+		case eGraphicCaps_MaxTextureCoordUnits:		return kMaxTextureUnits;
+		case eGraphicCaps_MaxUserClipPlanes:		return kMaxClipPlanes;
+
+		case eGraphicCaps_AnisotropicFiltering:		return 1;
+		case eGraphicCaps_MaxAnisotropicFiltering:	return 16;
+
+		case eGraphicCaps_Multisampling:			return 1;
+
+		case eGraphicCaps_TextureCompression:		return 1;
+		case eGraphicCaps_TextureCompression_DXTC:	return 1;
+
+		case eGraphicCaps_AutoGenerateMipMaps:		return 1;
+
+		case eGraphicCaps_RenderToTexture:			return 1;
+		case eGraphicCaps_MaxDrawBuffers:			return kMaxDrawColorBuffers;
+
+		case eGraphicCaps_PackedDepthStencil:		return 1;
+		case eGraphicCaps_TextureFloat:				return 1;
+
+		case eGraphicCaps_PolygonOffset:			return 1;
+
+		case eGraphicCaps_ShaderModel_2:			return 1;
+		case eGraphicCaps_ShaderModel_3:			return 1;
+		case eGraphicCaps_ShaderModel_4:			return 1;
+
+		case eGraphicCaps_OGL_ATIFragmentShader:	return 0;
+
+		case eGraphicCaps_MaxColorRenderTargets:	return kMaxDrawColorBuffers;
+		default: break;
+		}
+
+		return 0;
+	}
+
+	//-----------------------------------------------------------------------
+
+	cVector2f cLowLevelGraphicsNull::GetScreenSizeFloat()
+	{
+		return cVector2f((float)mvScreenSize.x, (float)mvScreenSize.y);
+	}
+
+	const cVector2l& cLowLevelGraphicsNull::GetScreenSizeInt()
+	{
+		return mvScreenSize;
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// DATA CREATION
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	iFontData* cLowLevelGraphicsNull::CreateFontData(const tString &asName)
+	{
+		return hplNew( cSDLFontData, (asName, this) );
+	}
+
+	//-----------------------------------------------------------------------
+
+	iTexture* cLowLevelGraphicsNull::CreateTexture(const tString &asName, eTextureType aType, eTextureUsage aUsage)
+	{
+		return hplNew( cTextureNull, (asName, aType, aUsage, this) );
+	}
+
+	//-----------------------------------------------------------------------
+
+	iVertexBuffer* cLowLevelGraphicsNull::CreateVertexBuffer(	eVertexBufferType aType,
+																eVertexBufferDrawType aDrawType,
+																eVertexBufferUsageType aUsageType,
+																int alReserveVtxSize,int alReserveIdxSize)
+	{
+		return hplNew( cVertexBufferNull, (this, aType, aDrawType, aUsageType, alReserveVtxSize, alReserveIdxSize) );
+	}
+
+	//-----------------------------------------------------------------------
+
+	iGpuProgram* cLowLevelGraphicsNull::CreateGpuProgram(const tString& asName)
+	{
+		return hplNew( cGpuProgramNull, (asName, mGpuProgramFormat, this) );
+	}
+
+	iGpuShader* cLowLevelGraphicsNull::CreateGpuShader(const tString& asName, eGpuShaderType aType)
+	{
+		return hplNew( cGpuShaderNull, (asName, aType, mGpuProgramFormat) );
+	}
+
+	//-----------------------------------------------------------------------
+
+	iFrameBuffer* cLowLevelGraphicsNull::CreateFrameBuffer(const tString& asName)
+	{
+		return hplNew( cFrameBufferNull, (asName, this) );
+	}
+
+	iDepthStencilBuffer* cLowLevelGraphicsNull::CreateDepthStencilBuffer(const cVector2l& avSize, int alDepthBits, int alStencilBits)
+	{
+		return hplNew( cDepthStencilBufferNull, (avSize, alDepthBits, alStencilBits) );
+	}
+
+	//-----------------------------------------------------------------------
+
+	iOcclusionQuery* cLowLevelGraphicsNull::CreateOcclusionQuery()
+	{
+		return hplNew( cOcclusionQueryNull, (this) );
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// FRAME BUFFER OPERATIONS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::ClearFrameBuffer(tClearFrameBufferFlag aFlags)
+	{
+		AddCommand(eNullGfxCommand_ClearFrameBuffer, 0, aFlags);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::CopyFrameBufferToTexure(	iTexture* apTex, const cVector2l &avPos,
+															const cVector2l &avSize, const cVector2l &avTexOffset)
+	{
+	}
+
+	//-----------------------------------------------------------------------
+
+	cBitmap* cLowLevelGraphicsNull::CopyFrameBufferToBitmap(const cVector2l &avScreenPos, const cVector2l &avScreenSize)
+	{
+		cVector2l vSize = avScreenSize;
+		if(vSize.x <= 0) vSize.x = mvScreenSize.x;
+		if(vSize.y <= 0) vSize.y = mvScreenSize.y;
+
+		//Nothing is drawn, so the bitmap is all black.
+		cBitmap *pBitmap = hplNew(cBitmap, () );
+		pBitmap->CreateData(cVector3l(vSize.x, vSize.y,1),ePixelFormat_RGBA,0,0);
+
+		return pBitmap;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::SwapBuffers()
+	{
+		EndPass();
+
+		////////////////////////////
+		// Save the frame
+		mvLastFrameCommands.swap(mvCommands);
+		mvLastFramePasses.swap(mvPasses);
+		mvCommands.clear();
+		mvPasses.clear();
+
+		mLastFrameStats = cNullGfxPassStats();
+		mLastFrameStats.msFrameBufferName = "frame";
+		for(size_t i=0; i<mvLastFramePasses.size(); ++i)
+		{
+			mLastFrameStats.Add(mvLastFramePasses[i]);
+		}
+
+		mTotalStats.Add(mLastFrameStats);
+		++mlTotalFrameCount;
+
+		////////////////////////////
+		// Start the next frame
+		BeginPass(mpFrameBuffer);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::SetCurrentFrameBuffer(iFrameBuffer* apFrameBuffer, const cVector2l &avPos, const cVector2l& avSize)
+	{
+		EndPass();
+
+		mpFrameBuffer = apFrameBuffer;
+
+		BeginPass(mpFrameBuffer);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::SetFrameBufferDrawTargets(int *apTargets, int alNumOfTargets)
+	{
+		unsigned int lHash = kStateHashStart;
+		for(int i=0; i<alNumOfTargets; ++i) lHash = HashState(lHash, (unsigned int)apTargets[i]);
+
+		AddCommand(eNullGfxCommand_SetFrameBuffer, 1, lHash);
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// RENDER STATE
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::SetColorWriteActive(bool abR,bool abG,bool abB,bool abA)
+	{
+		AddCommand(eNullGfxCommand_ColorWrite, 0, (abR ? 1 : 0) | (abG ? 2 : 0) | (abB ? 4 : 0) | (abA ? 8 : 0));
+	}
+
+	void cLowLevelGraphicsNull::SetDepthWriteActive(bool abX)
+	{
+		AddCommand(eNullGfxCommand_DepthWrite, 0, abX);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::SetCullActive(bool abX)
+	{
+		AddCommand(eNullGfxCommand_Cull, 0, abX);
+	}
+
+	void cLowLevelGraphicsNull::SetCullMode(eCullMode aMode)
+	{
+		AddCommand(eNullGfxCommand_Cull, 1, aMode);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::SetDepthTestActive(bool abX)
+	{
+		AddCommand(eNullGfxCommand_DepthTest, 0, abX);
+	}
+
+	void cLowLevelGraphicsNull::SetDepthTestFunc(eDepthTestFunc aFunc)
+	{
+		AddCommand(eNullGfxCommand_DepthTest, 1, aFunc);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::SetAlphaTestActive(bool abX)
+	{
+		AddCommand(eNullGfxCommand_AlphaTest, 0, abX);
+	}
+
+	void cLowLevelGraphicsNull::SetAlphaTestFunc(eAlphaTestFunc aFunc,float afRef)
+	{
+		AddCommand(eNullGfxCommand_AlphaTest, 1, HashState(HashState(kStateHashStart, (unsigned int)aFunc), afRef));
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::SetStencilActive(bool abX)
+	{
+		AddCommand(eNullGfxCommand_Stencil, 0, abX);
+	}
+
+	void cLowLevelGraphicsNull::SetStencilWriteMask(unsigned int alMask)
+	{
+		AddCommand(eNullGfxCommand_Stencil, 1, alMask);
+	}
+
+	void cLowLevelGraphicsNull::SetStencil(	eStencilFunc aFunc,int alRef, unsigned int aMask,
+											eStencilOp aFailOp,eStencilOp aZFailOp,eStencilOp aZPassOp)
+	{
+		unsigned int lHash = HashState(kStateHashStart, (unsigned int)aFunc);
+		lHash = HashState(lHash, (unsigned int)alRef);
+		lHash = HashState(lHash, aMask);
+		lHash = HashState(lHash, (unsigned int)aFailOp);
+		lHash = HashState(lHash, (unsigned int)aZFailOp);
+		lHash = HashState(lHash, (unsigned int)aZPassOp);
+
+		AddCommand(eNullGfxCommand_Stencil, 2, lHash);
+	}
+
+	void cLowLevelGraphicsNull::SetStencilTwoSide(	eStencilFunc aFrontFunc,eStencilFunc aBackFunc,
+													int alRef, unsigned int aMask,
+													eStencilOp aFrontFailOp,eStencilOp aFrontZFailOp,eStencilOp aFrontZPassOp,
+													eStencilOp aBackFailOp,eStencilOp aBackZFailOp,eStencilOp aBackZPassOp)
+	{
+		unsigned int lHash = HashState(kStateHashStart, (unsigned int)aFrontFunc);
+		lHash = HashState(lHash, (unsigned int)aBackFunc);
+		lHash = HashState(lHash, (unsigned int)alRef);
+		lHash = HashState(lHash, aMask);
+		lHash = HashState(lHash, (unsigned int)aFrontFailOp);
+		lHash = HashState(lHash, (unsigned int)aFrontZFailOp);
+		lHash = HashState(lHash, (unsigned int)aFrontZPassOp);
+		lHash = HashState(lHash, (unsigned int)aBackFailOp);
+		lHash = HashState(lHash, (unsigned int)aBackZFailOp);
+		lHash = HashState(lHash, (unsigned int)aBackZPassOp);
+
+		//Same target as one sided, since they replace each other.
+		AddCommand(eNullGfxCommand_Stencil, 2, ~lHash);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::SetScissorActive(bool abX)
+	{
+		AddCommand(eNullGfxCommand_Scissor, 0, abX);
+	}
+
+	void cLowLevelGraphicsNull::SetScissorRect(const cVector2l& avPos, const cVector2l& avSize)
+	{
+		unsigned int lHash = HashState(kStateHashStart, (unsigned int)avPos.x);
+		lHash = HashState(lHash, (unsigned int)avPos.y);
+		lHash = HashState(lHash, (unsigned int)avSize.x);
+		lHash = HashState(lHash, (unsigned int)avSize.y);
+
+		AddCommand(eNullGfxCommand_Scissor, 1, lHash);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::SetClipPlane(int alIdx, const cPlanef& aPlane)
+	{
+		mvClipPlanes[alIdx] = aPlane;
+
+		unsigned int lHash = HashState(kStateHashStart, aPlane.a);
+		lHash = HashState(lHash, aPlane.b);
+		lHash = HashState(lHash, aPlane.c);
+		lHash = HashState(lHash, aPlane.d);
+
+		AddCommand(eNullGfxCommand_ClipPlane, kMaxClipPlanes + alIdx, lHash);
+	}
+
+	cPlanef cLowLevelGraphicsNull::GetClipPlane(int alIdx)
+	{
+		return mvClipPlanes[alIdx];
+	}
+
+	void cLowLevelGraphicsNull::SetClipPlaneActive(int alIdx, bool abX)
+	{
+		AddCommand(eNullGfxCommand_ClipPlane, alIdx, abX);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::SetColor(const cColor &aColor)
+	{
+		AddCommand(eNullGfxCommand_Color, 0, HashState(kStateHashStart, aColor));
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::SetBlendActive(bool abX)
+	{
+		AddCommand(eNullGfxCommand_Blend, 0, abX);
+	}
+
+	void cLowLevelGraphicsNull::SetBlendFunc(eBlendFunc aSrcFactor, eBlendFunc aDestFactor)
+	{
+		SetBlendFuncSeparate(aSrcFactor, aDestFactor, aSrcFactor, aDestFactor);
+	}
+
+	void cLowLevelGraphicsNull::SetBlendFuncSeparate(	eBlendFunc aSrcFactorColor, eBlendFunc aDestFactorColor,
+														eBlendFunc aSrcFactorAlpha, eBlendFunc aDestFactorAlpha)
+	{
+		unsigned int lHash = HashState(kStateHashStart, (unsigned int)aSrcFactorColor);
+		lHash = HashState(lHash, (unsigned int)aDestFactorColor);
+		lHash = HashState(lHash, (unsigned int)aSrcFactorAlpha);
+		lHash = HashState(lHash, (unsigned int)aDestFactorAlpha);
+
+		AddCommand(eNullGfxCommand_Blend, 1, lHash);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::SetPolygonOffsetActive(bool abX)
+	{
+		AddCommand(eNullGfxCommand_PolygonOffset, 0, abX);
+	}
+
+	void cLowLevelGraphicsNull::SetPolygonOffset(float afBias,float afSlopeScaleBias)
+	{
+		AddCommand(eNullGfxCommand_PolygonOffset, 1, HashState(HashState(kStateHashStart, afBias), afSlopeScaleBias));
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// MATRIX
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	//Push and pop are never counted as redundant. Push keeps the current matrix and after a pop it is unknown.
+
+	void cLowLevelGraphicsNull::PushMatrix(eMatrix aMtxType)
+	{
+		unsigned int lLastValue = mvLastStateValue[eNullGfxCommand_Matrix][aMtxType];
+		bool bLastIsSet = mvLastStateIsSet[eNullGfxCommand_Matrix][aMtxType];
+
+		mvLastStateIsSet[eNullGfxCommand_Matrix][aMtxType] = false;
+		AddCommand(eNullGfxCommand_Matrix, aMtxType, 0);
+
+		mvLastStateValue[eNullGfxCommand_Matrix][aMtxType] = lLastValue;
+		mvLastStateIsSet[eNullGfxCommand_Matrix][aMtxType] = bLastIsSet;
+	}
+
+	void cLowLevelGraphicsNull::PopMatrix(eMatrix aMtxType)
+	{
+		mvLastStateIsSet[eNullGfxCommand_Matrix][aMtxType] = false;
+		AddCommand(eNullGfxCommand_Matrix, aMtxType, 0);
+		mvLastStateIsSet[eNullGfxCommand_Matrix][aMtxType] = false;
+	}
+
+	void cLowLevelGraphicsNull::SetIdentityMatrix(eMatrix aMtxType)
+	{
+		AddCommand(eNullGfxCommand_Matrix, aMtxType, HashState(kStateHashStart, cMatrixf::Identity));
+	}
+
+	void cLowLevelGraphicsNull::SetMatrix(eMatrix aMtxType, const cMatrixf& a_mtxA)
+	{
+		AddCommand(eNullGfxCommand_Matrix, aMtxType, HashState(kStateHashStart, a_mtxA));
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::SetOrthoProjection(const cVector2f& avSize, float afMin, float afMax)
+	{
+		SetOrthoProjection(cVector3f(0,0,afMin), cVector3f(avSize.x, avSize.y, afMax));
+	}
+
+	void cLowLevelGraphicsNull::SetOrthoProjection(const cVector3f& avMin, const cVector3f& avMax)
+	{
+		unsigned int lHash = kStateHashStart;
+		for(int i=0; i<3; ++i)
+		{
+			lHash = HashState(lHash, avMin.v[i]);
+			lHash = HashState(lHash, avMax.v[i]);
+		}
+
+		AddCommand(eNullGfxCommand_Matrix, eMatrix_Projection, lHash);
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// TEXTURE OPERATIONS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::SetTexture(unsigned int alUnit,iTexture* apTex)
+	{
+		if(apTex)
+		{
+			cTextureNull *pTex = static_cast<cTextureNull*>(apTex);
+			AddCommand(eNullGfxCommand_SetTexture, alUnit, pTex->mlId, &pTex->mlLastUsedPass);
+		}
+		else
+		{
+			AddCommand(eNullGfxCommand_SetTexture, alUnit, 0);
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::SetTextureEnv(eTextureParam aParam, int alVal)
+	{
+		AddCommand(eNullGfxCommand_TextureEnv, aParam, (unsigned int)alVal);
+	}
+
+	void cLowLevelGraphicsNull::SetTextureConstantColor(const cColor &aColor)
+	{
+		AddCommand(eNullGfxCommand_Color, 1, HashState(kStateHashStart, aColor));
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// DRAWING
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::DrawTriangle(tVertexVec& avVtx)
+	{
+		AddCommand(eNullGfxCommand_DrawImmediate, 0, 3);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::DrawQuad(const cVector3f &avPos,const cVector2f &avSize, const cColor& aColor)
+	{
+		AddCommand(eNullGfxCommand_DrawImmediate, 0, 4);
+	}
+
+	void cLowLevelGraphicsNull::DrawQuad(	const cVector3f &avPos,const cVector2f &avSize,
+											const cVector2f &avMinTexCoord,const cVector2f &avMaxTexCoord,
+											const cColor& aColor)
+	{
+		AddCommand(eNullGfxCommand_DrawImmediate, 0, 4);
+	}
+
+	void cLowLevelGraphicsNull::DrawQuad(	const cVector3f &avPos,const cVector2f &avSize,
+											const cVector2f &avMinTexCoord0,const cVector2f &avMaxTexCoord0,
+											const cVector2f &avMinTexCoord1,const cVector2f &avMaxTexCoord1,
+											const cColor& aColor)
+	{
+		AddCommand(eNullGfxCommand_DrawImmediate, 0, 4);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::DrawQuad(const tVertexVec &avVtx)
+	{
+		AddCommand(eNullGfxCommand_DrawImmediate, 0, 4);
+	}
+
+	void cLowLevelGraphicsNull::DrawQuad(const tVertexVec &avVtx, const cColor aCol)
+	{
+		AddCommand(eNullGfxCommand_DrawImmediate, 0, 4);
+	}
+
+	void cLowLevelGraphicsNull::DrawQuad(const tVertexVec &avVtx,const float afZ)
+	{
+		AddCommand(eNullGfxCommand_DrawImmediate, 0, 4);
+	}
+
+	void cLowLevelGraphicsNull::DrawQuad(const tVertexVec &avVtx,const float afZ,const cColor &aCol)
+	{
+		AddCommand(eNullGfxCommand_DrawImmediate, 0, 4);
+	}
+
+	void cLowLevelGraphicsNull::DrawQuadMultiTex(const tVertexVec &avVtx,const tVector3fVec &avExtraUvs)
+	{
+		AddCommand(eNullGfxCommand_DrawImmediate, 0, 4);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::DrawLine(const cVector3f& avBegin, const cVector3f& avEnd, cColor aCol)
+	{
+		AddCommand(eNullGfxCommand_DrawImmediate, 1, 2);
+	}
+
+	void cLowLevelGraphicsNull::DrawLine(const cVector3f& avBegin, const cColor& aBeginCol, const cVector3f& avEnd, const cColor& aEndCol)
+	{
+		AddCommand(eNullGfxCommand_DrawImmediate, 1, 2);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::DrawBoxMinMax(const cVector3f& avMin, const cVector3f& avMax, cColor aCol)
+	{
+		AddCommand(eNullGfxCommand_DrawImmediate, 1, 24);
+	}
+
+	void cLowLevelGraphicsNull::DrawSphere(const cVector3f& avPos, float afRadius, cColor aCol)
+	{
+		DrawSphere(avPos, afRadius, aCol, aCol, aCol);
+	}
+
+	void cLowLevelGraphicsNull::DrawSphere(const cVector3f& avPos, float afRadius, cColor aColX, cColor aColY, cColor aColZ)
+	{
+		AddCommand(eNullGfxCommand_DrawImmediate, 1, 3 * 2 * 20);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::DrawLineQuad(const cRect2f& aRect, float afZ, cColor aCol)
+	{
+		AddCommand(eNullGfxCommand_DrawImmediate, 1, 8);
+	}
+
+	void cLowLevelGraphicsNull::DrawLineQuad(const cVector3f &avPos,const cVector2f &avSize, cColor aCol)
+	{
+		AddCommand(eNullGfxCommand_DrawImmediate, 1, 8);
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// VERTEX BATCHING
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::FlushTriBatch(tVtxBatchFlag aTypeFlags, bool abAutoClear)
+	{
+		AddCommand(eNullGfxCommand_DrawImmediate, 2, mlBatchIndexNum);
+		if(abAutoClear) ClearBatch();
+	}
+
+	void cLowLevelGraphicsNull::FlushQuadBatch(tVtxBatchFlag aTypeFlags, bool abAutoClear)
+	{
+		AddCommand(eNullGfxCommand_DrawImmediate, 3, mlBatchVertexNum);
+		if(abAutoClear) ClearBatch();
+	}
+
+	void cLowLevelGraphicsNull::ClearBatch()
+	{
+		mlBatchVertexNum =0;
+		mlBatchIndexNum =0;
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// RECORDING
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::ResetTotalStats()
+	{
+		mTotalStats = cNullGfxPassStats();
+		mlTotalFrameCount =0;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::LogLastFrameStats()
+	{
+		Log("------ Null graphics frame %d ------\n", mlTotalFrameCount);
+		for(size_t i=0; i<mvLastFramePasses.size(); ++i)
+		{
+			const cNullGfxPassStats &pass = mvLastFramePasses[i];
+			if(pass.mlCommandNum == 0) continue;
+
+			//A single frame never gets near the int range, only the totals do.
+			Log(" Pass %d '%s': Commands: %d Draws: %d (%d immediate) Indices: %d States: %d (%d redundant) "
+				"Binds tex/prog/vb: %d/%d/%d Unique tex/prog/vb: %d/%d/%d Vars: %d Clears: %d Queries: %d\n",
+				(int)i, pass.msFrameBufferName.c_str(), (int)pass.mlCommandNum, (int)pass.mlDrawCalls, (int)pass.mlImmediateDrawCalls, (int)pass.mlIndicesDrawn,
+				(int)pass.mlStateChanges, (int)pass.mlRedundantStateChanges,
+				(int)pass.mlTextureBinds, (int)pass.mlProgramBinds, (int)pass.mlVertexBufferBinds,
+				(int)pass.mlUniqueTextures, (int)pass.mlUniquePrograms, (int)pass.mlUniqueVertexBuffers,
+				(int)pass.mlProgramVarSets, (int)pass.mlClears, (int)pass.mlOcclusionQueries);
+		}
+
+		const cNullGfxPassStats &frame = mLastFrameStats;
+		Log(" Total: Commands: %d Draws: %d (%d immediate) Indices: %d States: %d (%d redundant) Binds tex/prog/vb: %d/%d/%d\n",
+			(int)frame.mlCommandNum, (int)frame.mlDrawCalls, (int)frame.mlImmediateDrawCalls, (int)frame.mlIndicesDrawn,
+			(int)frame.mlStateChanges, (int)frame.mlRedundantStateChanges,
+			(int)frame.mlTextureBinds, (int)frame.mlProgramBinds, (int)frame.mlVertexBufferBinds);
+	}
+
+	//-----------------------------------------------------------------------
+
+	const char* cLowLevelGraphicsNull::GetCommandName(eNullGfxCommand aType)
+	{
+		switch(aType)
+		{
+		case eNullGfxCommand_ColorWrite:			return "ColorWrite";
+		case eNullGfxCommand_DepthWrite:			return "DepthWrite";
+		case eNullGfxCommand_Cull:					return "Cull";
+		case eNullGfxCommand_DepthTest:				return "DepthTest";
+		case eNullGfxCommand_AlphaTest:				return "AlphaTest";
+		case eNullGfxCommand_Stencil:				return "Stencil";
+		case eNullGfxCommand_Scissor:				return "Scissor";
+		case eNullGfxCommand_ClipPlane:				return "ClipPlane";
+		case eNullGfxCommand_Color:					return "Color";
+		case eNullGfxCommand_Blend:					return "Blend";
+		case eNullGfxCommand_PolygonOffset:			return "PolygonOffset";
+		case eNullGfxCommand_Matrix:				return "Matrix";
+		case eNullGfxCommand_TextureEnv:			return "TextureEnv";
+		case eNullGfxCommand_SetTexture:			return "SetTexture";
+		case eNullGfxCommand_BindProgram:			return "BindProgram";
+		case eNullGfxCommand_BindVertexBuffer:		return "BindVertexBuffer";
+		case eNullGfxCommand_SetProgramVar:			return "SetProgramVar";
+		case eNullGfxCommand_SetFrameBuffer:		return "SetFrameBuffer";
+		case eNullGfxCommand_ClearFrameBuffer:		return "ClearFrameBuffer";
+		case eNullGfxCommand_DrawVertexBuffer:		return "DrawVertexBuffer";
+		case eNullGfxCommand_DrawImmediate:			return "DrawImmediate";
+		case eNullGfxCommand_BeginOcclusionQuery:	return "BeginOcclusionQuery";
+		case eNullGfxCommand_EndOcclusionQuery:		return "EndOcclusionQuery";
+		default: break;
+		}
+		return "Unknown";
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::AddCommand(eNullGfxCommand aType, int alTarget, unsigned int alValue, unsigned int *apLastUsedPass)
+	{
+		cNullGfxPassStats &pass = mCurrentPass;
+		++pass.mlCommandNum;
+
+		////////////////////////////
+		// State change
+		if(aType <= eNullGfxCommand_BindVertexBuffer)
+		{
+			++pass.mlStateChanges;
+
+			int lTarget = alTarget < kNullGfxMaxCommandTargets ? alTarget : kNullGfxMaxCommandTargets-1;
+			if(mvLastStateIsSet[aType][lTarget] && mvLastStateValue[aType][lTarget] == alValue)
+			{
+				++pass.mlRedundantStateChanges;
+			}
+			mvLastStateValue[aType][lTarget] = alValue;
+			mvLastStateIsSet[aType][lTarget] = true;
+		}
+
+		////////////////////////////
+		// Type specific
+		bool bNewInPass = false;
+		if(apLastUsedPass && *apLastUsedPass != mlPassCount)
+		{
+			*apLastUsedPass = mlPassCount;
+			bNewInPass = true;
+		}
+
+		switch(aType)
+		{
+		case eNullGfxCommand_SetTexture:
+			if(alValue != 0) ++pass.mlTextureBinds;
+			if(bNewInPass) ++pass.mlUniqueTextures;
+			break;
+		case eNullGfxCommand_BindProgram:
+			++pass.mlProgramBinds;
+			if(bNewInPass) ++pass.mlUniquePrograms;
+			break;
+		case eNullGfxCommand_BindVertexBuffer:
+			++pass.mlVertexBufferBinds;
+			if(bNewInPass) ++pass.mlUniqueVertexBuffers;
+			break;
+		case eNullGfxCommand_SetProgramVar:
+			++pass.mlProgramVarSets;
+			break;
+		case eNullGfxCommand_ClearFrameBuffer:
+			++pass.mlClears;
+			break;
+		case eNullGfxCommand_DrawVertexBuffer:
+			++pass.mlDrawCalls;
+			pass.mlIndicesDrawn += alValue;
+			break;
+		case eNullGfxCommand_DrawImmediate:
+			++pass.mlImmediateDrawCalls;
+			pass.mlIndicesDrawn += alValue;
+			break;
+		case eNullGfxCommand_BeginOcclusionQuery:
+			++pass.mlOcclusionQueries;
+			break;
+		default:
+			break;
+		}
+
+		////////////////////////////
+		// Record
+		if(mbRecordCommands)
+		{
+			cNullGfxCommand command;
+			command.mType = (unsigned char)aType;
+			command.mlTarget = (unsigned char)alTarget;
+			command.mlValue = alValue;
+			mvCommands.push_back(command);
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// PRIVATE METHODS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::BeginPass(iFrameBuffer *apFrameBuffer)
+	{
+		//Resources are counted as unique once for each pass they are bound in.
+		++mlPassCount;
+
+		mCurrentPass = cNullGfxPassStats();
+		mCurrentPass.msFrameBufferName = apFrameBuffer ? apFrameBuffer->GetName() : "screen";
+		mCurrentPass.mlCommandStart = (int)mvCommands.size();
+
+		//The screen is 0, which is never used as a resource id.
+		AddCommand(eNullGfxCommand_SetFrameBuffer, 0, apFrameBuffer ? static_cast<cFrameBufferNull*>(apFrameBuffer)->mlId : 0);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cLowLevelGraphicsNull::EndPass()
+	{
+		mvPasses.push_back(mCurrentPass);
+	}
+
+	//-----------------------------------------------------------------------
+}
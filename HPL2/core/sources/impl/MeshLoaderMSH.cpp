@@ -630,6 +630,7 @@ namespace hpl {
 			int lFrameNum = apBuffer->GetInt32();
 
 			cAnimationTrack *pTrack = pAnimation->CreateTrack(sTrackName,transFlag);
+			pTrack->ResizeKeyFrames(lFrameNum);
 
 			if(gbLogMSHLoad) Log("  Track %d %s: %d %d\n", track, pTrack->GetName().c_str(), pTrack->GetTransformFlags(), lFrameNum);
 
@@ -23,6 +23,12 @@
 #include "system/LowLevelSystem.h"
 #include "system/String.h"
 
+#ifdef USE_OALWRAPPER
+# include "OALWrapper/OAL_Sample.h"
+#else
+# include "OpenAL/OAL_Sample.h"
+#endif
+
 namespace hpl {
 
 	//////////////////////////////////////////////////////////////////////////
@@ -105,6 +111,10 @@ namespace hpl {
 				OAL_Sample_SetLoop(mpSample,true);
                 //mpSample->SetLoop ( true );
 
+			//Samples are decoded in full when loaded
+			SetMemorySize(	(size_t)(mpSample->GetTotalTime() * mpSample->GetFrequency()) *
+							mpSample->GetChannels() * mpSample->GetBytesPerSample());
+
 		}
 
 		return true;
@@ -0,0 +1,95 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "impl/PhysicsRayQueryNewton.h"
+
+#include "impl/PhysicsBodyNewton.h"
+#include "physics/PhysicsWorld.h"
+
+#include "math/Math.h"
+#include "math/BoundingVolume.h"
+
+namespace hpl {
+
+	//////////////////////////////////////////////////////////////////////////
+	// CONSTRUCTORS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	cPhysicsRayQueryNewton::cPhysicsRayQueryNewton(iPhysicsWorld *apWorld, iPhysicsRayCallback *apFilter)
+	{
+		////////////////////////////
+		// Get the bodies that the filter accepts, same as the prefilter in CastRay does.
+		cPhysicsBodyIterator bodyIt = apWorld->GetBodyIterator();
+		while(bodyIt.HasNext())
+		{
+			cPhysicsBodyNewton *pBody = static_cast<cPhysicsBodyNewton*>(bodyIt.Next());
+			if(pBody->IsActive()==false) continue;
+			if(apFilter && apFilter->BeforeIntersect(pBody)==false) continue;
+
+			cPhysicsRayQueryBodyNewton queryBody;
+			queryBody.mpCollision = NewtonBodyGetCollision(pBody->GetNewtonBody());
+			queryBody.m_mtxInvWorld = cMath::MatrixInverse(pBody->GetWorldMatrix());
+			queryBody.mvMin = pBody->GetBoundingVolume()->GetMin();
+			queryBody.mvMax = pBody->GetBoundingVolume()->GetMax();
+
+			mvBodies.push_back(queryBody);
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	cPhysicsRayQueryNewton::~cPhysicsRayQueryNewton()
+	{
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// PUBLIC METHODS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	bool cPhysicsRayQueryNewton::Intersects(const cVector3f &avOrigin, const cVector3f& avEnd)
+	{
+		cVector3f vRayMin = cMath::Vector3Min(avOrigin, avEnd);
+		cVector3f vRayMax = cMath::Vector3Max(avOrigin, avEnd);
+
+		for(size_t i=0; i<mvBodies.size(); ++i)
+		{
+			const cPhysicsRayQueryBodyNewton &body = mvBodies[i];
+			if(cMath::CheckAABBIntersection(vRayMin, vRayMax, body.mvMin, body.mvMax)==false) continue;
+
+			//Collision ray casts are in the local space of the body
+			cVector3f vLocalStart = cMath::MatrixMul(body.m_mtxInvWorld, avOrigin);
+			cVector3f vLocalEnd = cMath::MatrixMul(body.m_mtxInvWorld, avEnd);
+
+			float vNormal[3];
+			int lAttribute;
+			float fT = NewtonCollisionRayCast(body.mpCollision, vLocalStart.v, vLocalEnd.v, vNormal, &lAttribute);
+			if(fT >= 0 && fT <= 1) return true;
+		}
+
+		return false;
+	}
+
+	//-----------------------------------------------------------------------
+}
@@ -24,6 +24,7 @@
 #include "impl/PhysicsMaterialNewton.h"
 #include "impl/CharacterBodyNewton.h"
 #include "impl/PhysicsRopeNewton.h"
+#include "impl/PhysicsRayQueryNewton.h"
 
 #include "impl/PhysicsJointBallNewton.h"
 #include "impl/PhysicsJointHingeNewton.h"
@@ -301,6 +302,23 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	iCollideShape* cPhysicsWorldNewton::LoadMeshShapeFromMemory(const void *apData, size_t alSize)
+	{
+		cCollideShapeNewton *pShape = hplNew( cCollideShapeNewton, (eCollideShapeType_Mesh,0, NULL, mpNewtonWorld,this) );
+
+		if(pShape->CreateFromSerializedMemory(apData, alSize)==false)
+		{
+			hplDelete(pShape);
+			return NULL;
+		}
+
+		mlstShapes.push_back(pShape);
+
+		return pShape;
+	}
+
+	//-----------------------------------------------------------------------
+
 
 	void cPhysicsWorldNewton::SaveMeshShapeToBuffer(iCollideShape* apMeshShape, cBinaryBuffer *apBuffer)
 	{
@@ -551,6 +569,13 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	iPhysicsRayQuery* cPhysicsWorldNewton::CreateRayQuery(iPhysicsRayCallback *apFilter)
+	{
+		return hplNew( cPhysicsRayQueryNewton, (this, apFilter) );
+	}
+
+	//-----------------------------------------------------------------------
+
 	static inline void CorrectNormalDirection(cVector3f& avNormal, const cVector3f& avCollidePoint, const cVector3f& avShapeACenter)
 	{
 		cVector3f vCenterToCollidePoint = avCollidePoint - avShapeACenter;
@@ -50,6 +50,23 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	uint64_t cPlatform::GetApplicationTimeNanoSec()
+	{
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+		static const uint64_t lFrequency = SDL_GetPerformanceFrequency();
+		uint64_t lCounter = SDL_GetPerformanceCounter();
+
+		//Split up to avoid overflow
+		uint64_t lSecs = lCounter / lFrequency;
+		uint64_t lRest = lCounter % lFrequency;
+		return lSecs * 1000000000 + (lRest * 1000000000) / lFrequency;
+#else
+		return (uint64_t)SDL_GetTicks() * 1000000;
+#endif
+	}
+
+	//-----------------------------------------------------------------------
+
 	void cPlatform::Sleep ( const unsigned int alMillisecs )
 	{
 		SDL_Delay ( alMillisecs );
@@ -178,4 +195,16 @@ namespace hpl {
 		return hplNew(cMutexSDL, ());
 	}
 #endif
+
+	//-----------------------------------------------------------------------
+
+	int cPlatform::GetCPUCount()
+	{
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+		int lCount = SDL_GetCPUCount();
+		return lCount > 0 ? lCount : 1;
+#else
+		return 1;
+#endif
+	}
 }
@@ -25,6 +25,8 @@
 #include "system/LowLevelSystem.h"
 
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <dirent.h>
 #include <sys/param.h>
 #include <fstream>
@@ -178,6 +180,36 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	const void* cPlatform::MapFile(const tWString& asFileName, size_t *apSize)
+	{
+		int lFile = open(cString::To8Char(asFileName).c_str(), O_RDONLY);
+		if(lFile < 0) return NULL;
+
+		struct stat statbuf;
+		if(fstat(lFile, &statbuf) != 0 || statbuf.st_size <= 0)
+		{
+			close(lFile);
+			return NULL;
+		}
+
+		void *pData = mmap(NULL, (size_t)statbuf.st_size, PROT_READ, MAP_PRIVATE, lFile, 0);
+		close(lFile); //The mapping keeps the file alive
+
+		if(pData == MAP_FAILED) return NULL;
+
+		*apSize = (size_t)statbuf.st_size;
+		return pData;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cPlatform::UnmapFile(const void *apData, size_t alSize)
+	{
+		if(apData) munmap((void*)apData, alSize);
+	}
+
+	//-----------------------------------------------------------------------
+
 	static cDate DateFromGMTime(struct tm* apClock)
 	{
 		cDate date;
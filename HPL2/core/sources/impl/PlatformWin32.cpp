@@ -90,6 +90,40 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	const void* cPlatform::MapFile(const tWString& asFileName, size_t *apSize)
+	{
+		HANDLE hFile = CreateFileW(asFileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if(hFile == INVALID_HANDLE_VALUE) return NULL;
+
+		LARGE_INTEGER lSize;
+		if(GetFileSizeEx(hFile, &lSize)==FALSE || lSize.QuadPart <= 0)
+		{
+			CloseHandle(hFile);
+			return NULL;
+		}
+
+		HANDLE hMapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		CloseHandle(hFile);
+		if(hMapping == NULL) return NULL;
+
+		//The view keeps the mapping and file alive
+		void *pData = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(hMapping);
+		if(pData == NULL) return NULL;
+
+		*apSize = (size_t)lSize.QuadPart;
+		return pData;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cPlatform::UnmapFile(const void *apData, size_t alSize)
+	{
+		if(apData) UnmapViewOfFile(apData);
+	}
+
+	//-----------------------------------------------------------------------
+
 	bool cPlatform::FileExists(const tWString& asFileName)
 	{
 		FILE *f = _wfopen(asFileName.c_str(),_W("rb"));
@@ -388,6 +422,22 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	uint64_t cPlatform::GetApplicationTimeNanoSec()
+	{
+		static LARGE_INTEGER lFrequency = {0};
+		if(lFrequency.QuadPart==0) QueryPerformanceFrequency(&lFrequency);
+
+		LARGE_INTEGER lCounter;
+		QueryPerformanceCounter(&lCounter);
+
+		//Split up to avoid overflow
+		uint64_t lSecs = lCounter.QuadPart / lFrequency.QuadPart;
+		uint64_t lRest = lCounter.QuadPart % lFrequency.QuadPart;
+		return lSecs * 1000000000 + (lRest * 1000000000) / lFrequency.QuadPart;
+	}
+
+	//-----------------------------------------------------------------------
+
 	void cPlatform::Sleep ( const unsigned int alMillisecs )
 	{
 		SDL_Delay ( alMillisecs );
@@ -689,6 +739,15 @@ namespace hpl {
 		return hplNew(cMutexWin32, ());
 	}
 
+	//-----------------------------------------------------------------------
+
+	int cPlatform::GetCPUCount()
+	{
+		SYSTEM_INFO sysInfo;
+		GetSystemInfo(&sysInfo);
+		return sysInfo.dwNumberOfProcessors > 0 ? (int)sysInfo.dwNumberOfProcessors : 1;
+	}
+
 
 	//-----------------------------------------------------------------------
 
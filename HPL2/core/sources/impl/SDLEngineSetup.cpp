@@ -32,6 +32,7 @@
 #include "impl/KeyboardSDL.h"
 #include "impl/MouseSDL.h"
 #include "impl/LowLevelGraphicsSDL.h"
+#include "impl/LowLevelGraphicsNull.h"
 #include "impl/LowLevelResourcesSDL.h"
 #include "impl/LowLevelSystemSDL.h"
 #include "impl/LowLevelInputSDL.h"
@@ -63,12 +64,12 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
-	cSDLEngineSetup::cSDLEngineSetup(tFlag alHplSetupFlags)
+	cSDLEngineSetup::cSDLEngineSetup(tFlag alHplSetupFlags, bool abNullGraphics)
 	{
 #if SDL_VERSION_ATLEAST(2,0,0)
 		SDL_SetHint(SDL_HINT_VIDEO_MAC_FULLSCREEN_SPACES, "0");
 #endif
-		if(alHplSetupFlags & (eHplSetup_Screen | eHplSetup_Video))
+		if((alHplSetupFlags & (eHplSetup_Screen | eHplSetup_Video)) && abNullGraphics==false)
 		{
 			if(SDL_Init( SDL_INIT_VIDEO | SDL_INIT_TIMER ) < 0) {
 				FatalError("Error Initializing Display: %s",SDL_GetError());
@@ -115,7 +116,8 @@ namespace hpl {
 
 		//////////////////////////
 		// Graphics
-		mpLowLevelGraphics = hplNew( cLowLevelGraphicsSDL,() );
+		if(abNullGraphics)	mpLowLevelGraphics = hplNew( cLowLevelGraphicsNull,() );
+		else				mpLowLevelGraphics = hplNew( cLowLevelGraphicsSDL,() );
 
 		//////////////////////////
 		// Input
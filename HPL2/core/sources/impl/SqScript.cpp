@@ -24,6 +24,7 @@
 #include "math/Math.h"
 #include <stdio.h>
 #include "impl/scripthelper.h"
+#include "impl/scriptstring.h"
 #include "resources/BinaryBuffer.h"
 #include "resources/Resources.h"
 
@@ -53,7 +54,10 @@ namespace hpl {
 		mpScriptOutput = apScriptOutput;
 		mlHandle = alHandle;
 
-		mpContext = mpScriptEngine->CreateContext();
+		mlContextDepth = 0;
+		mpModule = NULL;
+
+		mlStringTypeId = mpScriptEngine->GetTypeIdByDecl("string");
 
 		//Create a unique module name
 		msModuleName = "Module_"+cString::ToString(cMath::RandRectl(0,1000000))+
@@ -64,7 +68,7 @@ namespace hpl {
 	cSqScript::~cSqScript()
 	{
 		mpScriptEngine->DiscardModule(msModuleName.c_str());
-		mpContext->Release();
+		for(size_t i=0; i<mvContexts.size(); ++i) mvContexts[i]->Release();
 	}
 
 	//-----------------------------------------------------------------------
@@ -148,6 +152,7 @@ namespace hpl {
 
 		/////////////////////////////////////////
 		// Create module
+		m_mapFuncs.clear();
 		mpModule = mpScriptEngine->GetModule(msModuleName.c_str(), asGM_ALWAYS_CREATE);
 		if(mpModule->AddScriptSection("main", pCharBuffer, lLength)<0)
 		{
@@ -203,23 +208,172 @@ namespace hpl {
 
 	bool cSqScript::Run(int alHandle)
 	{
-		mpContext->Prepare(alHandle);
+		asIScriptContext *pContext = PushContext();
+		pContext->Prepare(alHandle);
 
 		/* Set all the args here */
 
-		mpContext->Execute();
+		pContext->Execute();
+		PopContext();
 
 		return true;
 	}
 
 	//-----------------------------------------------------------------------
 
+	bool cSqScript::RunCallback(const tString& asFunc, const cScriptArgs& aArgs)
+	{
+		if(aArgs.IsValid()==false)
+		{
+			Error("Could not run '%s', more than %d arguments were added!\n", asFunc.c_str(), kMaxScriptArgs);
+			return false;
+		}
+
+		////////////////////////////
+		// If the func does not exist or takes other args, let the compiler deal with it (and report errors) as before.
+		cSqScriptFunc *pFunc = GetFunc(asFunc);
+		if(pFunc==NULL || pFunc->mlParamNum != aArgs.GetNum())
+		{
+			return Run(asFunc + aArgs.ToString());
+		}
+
+		asIScriptContext *pContext = PushContext();
+		pContext->Prepare(pFunc->mlId);
+
+		CScriptString* vStrings[kMaxScriptArgs];
+		for(int i=0; i<kMaxScriptArgs; ++i) vStrings[i] = NULL;
+
+		if(SetArgs(pContext, pFunc, aArgs, vStrings)==false)
+		{
+			pContext->Unprepare();
+			PopContext();
+			for(int i=0; i<kMaxScriptArgs; ++i) if(vStrings[i]) vStrings[i]->Release();
+
+			return Run(asFunc + aArgs.ToString());
+		}
+
+		int lRet = pContext->Execute();
+		if(lRet == asEXECUTION_EXCEPTION)
+		{
+			Error("Script exception in '%s': %s\n", asFunc.c_str(), pContext->GetExceptionString());
+		}
+
+		PopContext();
+		for(int i=0; i<kMaxScriptArgs; ++i) if(vStrings[i]) vStrings[i]->Release();
+
+		return lRet == asEXECUTION_FINISHED;
+	}
+
+	//-----------------------------------------------------------------------
+
 	//////////////////////////////////////////////////////////////////////////
 	// PRIVATE METHODS
 	//////////////////////////////////////////////////////////////////////////
 
 	//-----------------------------------------------------------------------
 
+	cSqScriptFunc* cSqScript::GetFunc(const tString& asFunc)
+	{
+		tSqScriptFuncMapIt it = m_mapFuncs.find(asFunc);
+		if(it != m_mapFuncs.end())
+		{
+			return it->second.mlId >= 0 ? &it->second : NULL;
+		}
+
+		////////////////////////////
+		// Look up func and its params, a missing func is also saved so it is only looked up once.
+		cSqScriptFunc func;
+		func.mlId = mpModule ? mpModule->GetFunctionIdByName(asFunc.c_str()) : -1;
+		func.mlParamNum = 0;
+
+		asIScriptFunction *pDesc = func.mlId >= 0 ? mpModule->GetFunctionDescriptorById(func.mlId) : NULL;
+		if(pDesc==NULL || pDesc->GetParamCount() > kMaxScriptArgs)
+		{
+			func.mlId = -1;
+		}
+		else
+		{
+			func.mlParamNum = pDesc->GetParamCount();
+			for(int i=0; i<func.mlParamNum; ++i)
+			{
+				func.mvParamFlags[i] = 0;
+				func.mvParamTypeIds[i] = pDesc->GetParamTypeId(i, &func.mvParamFlags[i]);
+			}
+		}
+
+		tSqScriptFuncMapIt newIt = m_mapFuncs.insert(tSqScriptFuncMap::value_type(asFunc, func)).first;
+		return newIt->second.mlId >= 0 ? &newIt->second : NULL;
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool cSqScript::SetArgs(asIScriptContext *apContext, cSqScriptFunc *apFunc, const cScriptArgs& aArgs, CScriptString **apStrings)
+	{
+		for(int i=0; i<aArgs.GetNum(); ++i)
+		{
+			int lTypeId = apFunc->mvParamTypeIds[i];
+			asDWORD lFlags = apFunc->mvParamFlags[i];
+
+			//Only values and input references can be set.
+			if(lFlags != asTM_NONE && lFlags != asTM_INREF) return false;
+
+			switch(aArgs.GetType(i))
+			{
+			case eScriptArgType_Bool:
+				if(lTypeId != asTYPEID_BOOL || lFlags != asTM_NONE) return false;
+				apContext->SetArgByte(i, aArgs.GetBool(i) ? 1 : 0);
+				break;
+
+			case eScriptArgType_Int:
+				if(lFlags != asTM_NONE) return false;
+				if(lTypeId == asTYPEID_INT32 || lTypeId == asTYPEID_UINT32)	apContext->SetArgDWord(i, (asDWORD)aArgs.GetInt(i));
+				else if(lTypeId == asTYPEID_FLOAT)							apContext->SetArgFloat(i, (float)aArgs.GetInt(i));
+				else if(lTypeId == asTYPEID_DOUBLE)							apContext->SetArgDouble(i, (double)aArgs.GetInt(i));
+				else return false;
+				break;
+
+			case eScriptArgType_Float:
+				if(lFlags != asTM_NONE) return false;
+				if(lTypeId == asTYPEID_FLOAT)		apContext->SetArgFloat(i, aArgs.GetFloat(i));
+				else if(lTypeId == asTYPEID_DOUBLE)	apContext->SetArgDouble(i, (double)aArgs.GetFloat(i));
+				else return false;
+				break;
+
+			case eScriptArgType_String:
+				if(lTypeId != mlStringTypeId) return false;
+				apStrings[i] = new CScriptString(aArgs.GetString(i));
+				if(lFlags == asTM_INREF)	apContext->SetArgAddress(i, apStrings[i]);
+				else						apContext->SetArgObject(i, apStrings[i]); //Copied by the context
+				break;
+
+			default:
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------
+
+	asIScriptContext* cSqScript::PushContext()
+	{
+		//Callbacks can run scripts that trigger new callbacks, so each level of nesting needs a context of its own.
+		if(mlContextDepth >= (int)mvContexts.size())
+		{
+			mvContexts.push_back(mpScriptEngine->CreateContext());
+		}
+
+		return mvContexts[mlContextDepth++];
+	}
+
+	void cSqScript::PopContext()
+	{
+		--mlContextDepth;
+	}
+
+	//-----------------------------------------------------------------------
+
 	char* cSqScript::LoadCharBuffer(const tWString& asFileName, int& alLength)
 	{
 		FILE *pFile = cPlatform::OpenFile(asFileName, _W("rb"));
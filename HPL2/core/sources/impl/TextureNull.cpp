@@ -0,0 +1,188 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "impl/TextureNull.h"
+
+#include "impl/LowLevelGraphicsNull.h"
+
+#include "graphics/Bitmap.h"
+#include "math/Math.h"
+
+namespace hpl {
+
+	//////////////////////////////////////////////////////////////////////////
+	// CONSTRUCTORS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	cTextureNull::cTextureNull(const tString& asName, eTextureType aType, eTextureUsage aUsage, cLowLevelGraphicsNull* apLowLevelGraphics)
+				: iTexture(asName,_W(""),aType, aUsage, apLowLevelGraphics)
+	{
+		mlId = apLowLevelGraphics->GetNewResourceId();
+		mlLastUsedPass =0;
+
+		mvSize = cVector3l(1,1,1);
+		mlFrameNum =0;
+		mfTimeCount =0;
+		mfTimeDir =1;
+	}
+
+	//-----------------------------------------------------------------------
+
+	cTextureNull::~cTextureNull()
+	{
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// PUBLIC METHODS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	bool cTextureNull::CreateFromBitmap(cBitmap* apBmp)
+	{
+		if(mType == eTextureType_CubeMap && apBmp->GetNumOfImages()<6)
+		{
+			Error("Bitmap has to few images (%d) to create cubmap texture '%s'\n", apBmp->GetNumOfImages(),msName.c_str());
+			return false;
+		}
+
+		SetSizeFromBitmap(apBmp);
+		mlFrameNum = 1;
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool cTextureNull::CreateAnimFromBitmapVec(std::vector<cBitmap*> *avBitmaps)
+	{
+		if(avBitmaps->empty()) return false;
+
+		SetSizeFromBitmap((*avBitmaps)[0]);
+		mlFrameNum = (int)avBitmaps->size();
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool cTextureNull::CreateCubeFromBitmapVec(std::vector<cBitmap*> *avBitmaps)
+	{
+		if(mUsage == eTextureUsage_RenderTarget || mType != eTextureType_CubeMap)
+		{
+			return false;
+		}
+
+		if(avBitmaps->size()<6){
+			Error("Only %d bitmaps supplied for creation of cube map, 6 needed.",avBitmaps->size());
+			return false;
+		}
+
+		SetSizeFromBitmap((*avBitmaps)[0]);
+		mlFrameNum = 1;
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool cTextureNull::CreateFromRawData(const cVector3l &avSize,ePixelFormat aPixelFormat, unsigned char *apData)
+	{
+		mvSize = avSize;
+		mPixelFormat = aPixelFormat;
+
+		//Make sure size is now below 0
+		if(mvSize.x<1)mvSize.x=1;
+		if(mvSize.y<1)mvSize.y=1;
+		if(mvSize.z<1)mvSize.z=1;
+
+		mlFrameNum = 1;
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cTextureNull::Update(float afTimeStep)
+	{
+		if(mlFrameNum > 1) StepFrame(afTimeStep * (1.0f/mfFrameTime) * mfTimeDir);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cTextureNull::NextFrame()
+	{
+		StepFrame(mfTimeDir);
+	}
+
+	void cTextureNull::PrevFrame()
+	{
+		StepFrame(-mfTimeDir);
+	}
+
+	float cTextureNull::GetT()
+	{
+		return cMath::Modulus(mfTimeCount,1.0f);
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// PRIVATE METHODS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	void cTextureNull::SetSizeFromBitmap(cBitmap *apBmp)
+	{
+		mvSize = apBmp->GetSize();
+		mPixelFormat = apBmp->GetPixelFormat();
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cTextureNull::StepFrame(float afStep)
+	{
+		float fMax = (float)mlFrameNum;
+		mfTimeCount += afStep;
+
+		if(mfTimeCount >= fMax)
+		{
+			if(mAnimMode == eTextureAnimMode_Loop)
+			{
+				mfTimeCount =0;
+			}
+			else
+			{
+				mfTimeCount = fMax - 1.0f;
+				mfTimeDir = -1.0f;
+			}
+		}
+		else if(mfTimeCount < 0)
+		{
+			mfTimeCount =1;
+			mfTimeDir = 1.0f;
+		}
+	}
+
+	//-----------------------------------------------------------------------
+}
@@ -23,6 +23,7 @@
 #include "system/Platform.h"
 #include "system/String.h"
 
+#include "impl/XmlParser.h"
 #include "impl/tinyXML/tinyxml.h"
 #include <stdio.h>
 
@@ -51,26 +52,13 @@ namespace hpl {
 
 	bool cXmlDocumentTiny::CreateFromString(const tString& asData)
 	{
-		TiXmlDocument *pXmlDoc = hplNew( TiXmlDocument, () );
-
-		pXmlDoc->Parse(asData.c_str());
-		if(pXmlDoc->Error())
-		{
-			tString sErrorDesc = tString(pXmlDoc->ErrorDesc());
-			int lErrorRow = pXmlDoc->ErrorRow();
-			int lErrorCol = pXmlDoc->ErrorCol();
-
-			SaveErrorInfo(sErrorDesc, lErrorRow, lErrorCol);
-
-			hplDelete( pXmlDoc );
-			return false;
-		}
+		ClearData();
 
-		DestroyChildren();
-		LoadFromTinyXMLData(pXmlDoc->FirstChildElement(), this);
+		//The parser works in place, so the data is copied to the document
+		char *pData = GetStringPool()->Allocate(asData.size()+1);
+		memcpy(pData, asData.c_str(), asData.size()+1);
 
-		hplDelete( pXmlDoc );
-		return true;
+		return ParseData(pData);
 	}
 
 	//-----------------------------------------------------------------------
@@ -83,24 +71,28 @@ namespace hpl {
 
 	bool cXmlDocumentTiny::LoadDataFromFile(const tWString& asPath)
 	{
-		TiXmlDocument *pXmlDoc = hplNew( TiXmlDocument, () );
-		if(CreateTinyXMLFromFile(pXmlDoc,asPath)==false)
+		FILE *pFile = cPlatform::OpenFile(asPath, _W("rb"));
+		if(pFile==NULL)
 		{
-			tString sErrorDesc = tString(pXmlDoc->ErrorDesc());
-			int lErrorRow = pXmlDoc->ErrorRow();
-			int lErrorCol = pXmlDoc->ErrorCol();
-
-			SaveErrorInfo(sErrorDesc, lErrorRow, lErrorCol);
-
-			hplDelete( pXmlDoc );
+			SaveErrorInfo("Failed to open file", 0, 0);
 			return false;
 		}
 
-		DestroyChildren();
-		LoadFromTinyXMLData(pXmlDoc->FirstChildElement(), this);
+		fseek(pFile, 0, SEEK_END);
+		long lSize = ftell(pFile);
+		fseek(pFile, 0, SEEK_SET);
 
-        hplDelete( pXmlDoc );
-		return true;
+		ClearData();
+
+		//////////////////////////////
+		// Read the file into the string pool, attribute values are then parsed in place and point into it.
+		char *pData = GetStringPool()->Allocate(lSize > 0 ? lSize+1 : 1);
+		size_t lReadSize = lSize > 0 ? fread(pData, 1, lSize, pFile) : 0;
+		pData[lReadSize] = 0;
+
+		fclose(pFile);
+
+		return ParseData(pData);
 	}
 
 	//-----------------------------------------------------------------------
@@ -121,27 +113,18 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
-	void cXmlDocumentTiny::LoadFromTinyXMLData(TiXmlElement* apTinyElem, cXmlElement *apDestElem)
+	bool cXmlDocumentTiny::ParseData(char *apData)
 	{
-		/////////////////////////////
-		//Load the attributes
-		apDestElem->SetValue(apTinyElem->Value());
-
-        TiXmlAttribute *pAttrib = apTinyElem->FirstAttribute();
-		for(; pAttrib != NULL; pAttrib = pAttrib->Next())
+		cXmlParser parser;
+		if(parser.Parse(this, apData)==false)
 		{
-			apDestElem->SetAttribute(pAttrib->Name(), pAttrib->Value());
-		}
+			SaveErrorInfo(parser.GetErrorDesc(), parser.GetErrorRow(), parser.GetErrorCol());
 
-		/////////////////////////////
-		//Load the elements
-		TiXmlElement *pChildElem = apTinyElem->FirstChildElement();
-		for(; pChildElem != NULL; pChildElem = pChildElem->NextSiblingElement())
-		{
-			cXmlElement *pDestChild = apDestElem->CreateChildElement();
-
-            LoadFromTinyXMLData(pChildElem, pDestChild);
+			ClearData();
+			return false;
 		}
+
+		return true;
 	}
 
 	//-----------------------------------------------------------------------
@@ -152,11 +135,10 @@ namespace hpl {
 		//Save the attributes
 		apTinyElem->SetValue(apSrcElem->GetValue().c_str());
 
-		tAttributeMap *pAttributeMap = apSrcElem->GetAttributeMap();
-		tAttributeMapIt attrIt = pAttributeMap->begin();
-		for(; attrIt != pAttributeMap->end(); ++attrIt)
+		tXmlAttributeVec *pAttributes = apSrcElem->GetAttributes();
+		for(tXmlAttributeVecIt attrIt = pAttributes->begin(); attrIt != pAttributes->end(); ++attrIt)
 		{
-			apTinyElem->SetAttribute(attrIt->first.c_str(), attrIt->second.c_str());
+			apTinyElem->SetAttribute(attrIt->mpName, attrIt->mpValue);
 		}
 
 		/////////////////////////////
@@ -176,20 +158,6 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
-	bool cXmlDocumentTiny::CreateTinyXMLFromFile(TiXmlDocument* pDoc,const tWString& asPath)
-	{
-		FILE *pFile = cPlatform::OpenFile(asPath, _W("rb"));
-		if(pFile==NULL) return false;
-
-		bool bRet = pDoc->LoadFile(pFile);
-
-		if(pFile) fclose(pFile);
-
-		return bRet;
-	}
-
-	//-----------------------------------------------------------------------
-
 	bool cXmlDocumentTiny::SaveTinyXMLToFile(TiXmlDocument* pDoc,const tWString& asPath)
 	{
 		if(asPath == _W("")) return false;
@@ -0,0 +1,492 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "impl/XmlParser.h"
+
+#include "system/LowLevelSystem.h"
+
+#include <string.h>
+#include <ctype.h>
+
+namespace hpl {
+
+	//////////////////////////////////////////////////////////////////////////
+	// HELPERS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	static inline bool IsXmlSpace(char c)
+	{
+		return c==' ' || c=='\t' || c=='\n' || c=='\r';
+	}
+
+	static inline bool IsXmlNameEnd(char c)
+	{
+		return c==0 || IsXmlSpace(c) || c=='/' || c=='>' || c=='=';
+	}
+
+	static inline char* SkipXmlSpace(char *apData)
+	{
+		while(IsXmlSpace(*apData)) ++apData;
+		return apData;
+	}
+
+	/**
+	 * Case insensitive check if the alLength chars at apData start with apPrefix (lower case). Never reads past alLength.
+	 */
+	static bool StartsWithNoCase(const char *apData, size_t alLength, const char *apPrefix)
+	{
+		size_t lPrefixLength = strlen(apPrefix);
+		if(alLength < lPrefixLength) return false;
+
+		for(size_t i=0; i<lPrefixLength; ++i)
+		{
+			if(tolower((unsigned char)apData[i]) != apPrefix[i]) return false;
+		}
+		return true;
+	}
+
+	//-----------------------------------------------------------------------
+
+	class cXmlEntity
+	{
+	public:
+		const char *mpName;
+		size_t mlLength;
+		char mChar;
+	};
+
+	static const cXmlEntity gvXmlEntities[] = {
+		{"&amp;", 5, '&'},
+		{"&lt;", 4, '<'},
+		{"&gt;", 4, '>'},
+		{"&quot;", 6, '\"'},
+		{"&apos;", 6, '\''},
+	};
+	static const int glXmlEntityNum = sizeof(gvXmlEntities) / sizeof(cXmlEntity);
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// CONSTRUCTORS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	cXmlParser::cXmlParser()
+	{
+		mpDataStart = NULL;
+		mbUTF8 = false;
+		mbEncodingKnown = false;
+
+		mlErrorRow = 0;
+		mlErrorCol = 0;
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// PUBLIC METHODS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	bool cXmlParser::Parse(iXmlDocument *apDoc, char *apData)
+	{
+		mpDataStart = apData;
+		mbUTF8 = false;
+		mbEncodingKnown = false;
+		msErrorDesc = "";
+		mlErrorRow = 0;
+		mlErrorCol = 0;
+
+		char *pData = apData;
+
+		////////////////////////////
+		// Byte order mark
+		if((unsigned char)pData[0]==0xEF && (unsigned char)pData[1]==0xBB && (unsigned char)pData[2]==0xBF)
+		{
+			pData += 3;
+			mbUTF8 = true;
+			mbEncodingKnown = true;
+		}
+
+		std::vector<cXmlElement*> vOpenElements;
+		bool bRootLoaded = false;
+
+		while(pData)
+		{
+			//Skip text, it is not kept
+			while(*pData && *pData != '<') ++pData;
+			if(*pData==0) break;
+
+			////////////////////////////
+			// Declarations, comments and such
+			if(pData[1]=='?')
+			{
+				pData = ParseDeclaration(pData);
+			}
+			else if(strncmp(pData, "<!--", 4)==0)
+			{
+				pData = SkipTo(pData+4, "-->", "Error parsing Comment.");
+			}
+			else if(strncmp(pData, "<![CDATA[", 9)==0)
+			{
+				pData = SkipTo(pData+9, "]]>", "Error parsing CDATA.");
+			}
+			else if(pData[1]=='!')
+			{
+				pData = SkipTo(pData+2, ">", "Error parsing Unknown.");
+			}
+			////////////////////////////
+			// End tag
+			else if(pData[1]=='/')
+			{
+				if(vOpenElements.empty())
+				{
+					SetError("Error reading end tag.", pData);
+					return false;
+				}
+
+				char *pName = pData+2;
+				char *pNameEnd = pName;
+				while(IsXmlNameEnd(*pNameEnd)==false) ++pNameEnd;
+
+				const tString& sName = vOpenElements.back()->GetValue();
+				if(sName.size() != (size_t)(pNameEnd-pName) || strncmp(sName.c_str(), pName, pNameEnd-pName)!=0)
+				{
+					SetError("Error reading end tag.", pData);
+					return false;
+				}
+
+				pData = SkipXmlSpace(pNameEnd);
+				if(*pData != '>')
+				{
+					SetError("Error reading end tag.", pData);
+					return false;
+				}
+				++pData;
+
+				vOpenElements.pop_back();
+
+				//Anything after the root element is ignored
+				if(vOpenElements.empty()) break;
+			}
+			////////////////////////////
+			// Element, the first one is loaded into the document
+			else
+			{
+				cXmlElement *pElement = vOpenElements.empty() ? apDoc : vOpenElements.back()->CreateChildElement();
+
+				bool bEmpty = false;
+				pData = ParseElement(pData+1, pElement, &bEmpty);
+				if(pData==NULL) return false;
+
+				bRootLoaded = true;
+
+				if(bEmpty==false)			vOpenElements.push_back(pElement);
+				else if(vOpenElements.empty())	break;
+			}
+		}
+
+		if(pData==NULL) return false;
+
+		if(bRootLoaded==false)
+		{
+			SetError("Error document empty.", pData);
+			return false;
+		}
+		if(vOpenElements.empty()==false)
+		{
+			SetError("Error reading end tag.", pData);
+			return false;
+		}
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// PRIVATE METHODS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	char* cXmlParser::ParseElement(char *apData, cXmlElement *apElement, bool *apIsEmpty)
+	{
+		char *pData = apData;
+
+		////////////////////////////
+		// Name
+		char *pName = pData;
+		while(IsXmlNameEnd(*pData)==false) ++pData;
+		if(pData == pName) return SetError("Failed to read Element name.", pName);
+
+		apElement->SetValue(tString(pName, pData-pName));
+
+		cXmlStringPool *pPool = apElement->GetStringPool();
+
+		////////////////////////////
+		// Attributes
+		while(true)
+		{
+			pData = SkipXmlSpace(pData);
+			if(*pData==0) return SetError("Error reading Attributes.", pData);
+
+			if(*pData=='/')
+			{
+				if(pData[1] != '>') return SetError("Error parsing Empty tag.", pData);
+
+				*apIsEmpty = true;
+				return pData+2;
+			}
+			if(*pData=='>')
+			{
+				*apIsEmpty = false;
+				return pData+1;
+			}
+
+			//Name
+			char *pAttrName = pData;
+			while(IsXmlNameEnd(*pData)==false) ++pData;
+			if(pData == pAttrName) return SetError("Error reading Attributes.", pData);
+
+			const char *pInternedName = pPool->AddName(pAttrName, pData-pAttrName);
+
+			pData = SkipXmlSpace(pData);
+			if(*pData != '=') return SetError("Error reading Attributes.", pAttrName);
+			pData = SkipXmlSpace(pData+1);
+
+			//Value, decoded in place
+			const char *pValue = NULL;
+			if(*pData=='\"' || *pData=='\'')
+			{
+				char *pStart = pData+1;
+				char *pEnd = strchr(pStart, *pData);
+				if(pEnd==NULL) return SetError("Error reading Attributes.", pAttrName);
+
+				*DecodeText(pStart, pEnd) = 0;
+
+				pValue = pStart;
+				pData = pEnd+1;
+			}
+			else
+			{
+				//Values without quotes are not valid, but TinyXML accepts them
+				char *pStart = pData;
+				while(*pData && IsXmlSpace(*pData)==false && *pData != '/' && *pData != '>')
+				{
+					if(*pData=='\"' || *pData=='\'') return SetError("Error reading Attributes.", pAttrName);
+					++pData;
+				}
+				pValue = pPool->AddString(pStart, pData-pStart);
+			}
+
+			//Names are interned, so they can be compared by pointer
+			tXmlAttributeVec& vAttributes = apElement->mvAttributes;
+			for(size_t i=0; i<vAttributes.size(); ++i)
+			{
+				if(vAttributes[i].mpName == pInternedName) return SetError("Error parsing Element.", pAttrName);
+			}
+
+			cXmlAttribute attribute;
+			attribute.mpName = pInternedName;
+			attribute.mpValue = pValue;
+			vAttributes.push_back(attribute);
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	char* cXmlParser::ParseDeclaration(char *apData)
+	{
+		char *pEnd = SkipTo(apData+2, "?>", "Error parsing Declaration.");
+		if(pEnd==NULL) return NULL;
+
+		////////////////////////////
+		// The first xml declaration decides how character references are decoded, same as TinyXML.
+		if(mbEncodingKnown || strncmp(apData, "<?xml", 5)!=0) return pEnd;
+		mbEncodingKnown = true;
+
+		char *pEncoding = NULL;
+		for(char *pData = apData; pData < pEnd; ++pData)
+		{
+			if(strncmp(pData, "encoding", 8)==0)
+			{
+				pEncoding = pData+8;
+				break;
+			}
+		}
+		if(pEncoding==NULL)
+		{
+			mbUTF8 = true;
+			return pEnd;
+		}
+
+		pEncoding = SkipXmlSpace(pEncoding);
+		if(*pEncoding=='=') pEncoding = SkipXmlSpace(pEncoding+1);
+		if(*pEncoding=='\"' || *pEncoding=='\'') ++pEncoding;
+
+		//The name might be cut short by the end of the declaration (or the data), so only look up to there.
+		size_t lLength = pEncoding < pEnd ? (size_t)(pEnd - pEncoding) : 0;
+		mbUTF8 = StartsWithNoCase(pEncoding, lLength, "utf-8") || StartsWithNoCase(pEncoding, lLength, "utf8");
+
+		return pEnd;
+	}
+
+	//-----------------------------------------------------------------------
+
+	char* cXmlParser::SkipTo(char *apData, const char *apEnd, const char *apErrorDesc)
+	{
+		char *pFound = strstr(apData, apEnd);
+		if(pFound==NULL) return SetError(apErrorDesc, apData);
+
+		return pFound + strlen(apEnd);
+	}
+
+	//-----------------------------------------------------------------------
+
+	char* cXmlParser::DecodeText(char *apStart, char *apEnd)
+	{
+		char *pDest = apStart;
+		char *pData = apStart;
+		while(pData < apEnd)
+		{
+			if(*pData=='&')
+			{
+				pData = DecodeEntity(pData, &pDest);
+			}
+			else if(*pData=='\r')
+			{
+				//Same line ending conversion as TinyXML does when loading files
+				*pDest++ = '\n';
+				++pData;
+				if(pData < apEnd && *pData=='\n') ++pData;
+			}
+			else
+			{
+				*pDest++ = *pData++;
+			}
+		}
+
+		return pDest;
+	}
+
+	//-----------------------------------------------------------------------
+
+	char* cXmlParser::DecodeEntity(char *apData, char **apDest)
+	{
+		char *pDest = *apDest;
+
+		////////////////////////////
+		// Character reference
+		if(apData[1]=='#')
+		{
+			bool bHex = apData[2]=='x' || apData[2]=='X';
+			char *pDigit = apData + (bHex ? 3 : 2);
+
+			unsigned int lChar = 0;
+			int lDigitNum = 0;
+			for(; *pDigit != ';'; ++pDigit, ++lDigitNum)
+			{
+				char c = *pDigit;
+				if(c>='0' && c<='9')					lChar = lChar * (bHex ? 16 : 10) + (c - '0');
+				else if(bHex && c>='a' && c<='f')	lChar = lChar * 16 + (c - 'a' + 10);
+				else if(bHex && c>='A' && c<='F')	lChar = lChar * 16 + (c - 'A' + 10);
+				else								break;
+			}
+
+			if(*pDigit==';' && lDigitNum > 0)
+			{
+				//The output is never longer than the reference, so it can be written in place.
+				if(mbUTF8==false || lChar < 0x80)
+				{
+					*pDest++ = (char)lChar;
+				}
+				else if(lChar < 0x800)
+				{
+					*pDest++ = (char)(0xC0 | (lChar >> 6));
+					*pDest++ = (char)(0x80 | (lChar & 0x3F));
+				}
+				else if(lChar < 0x10000)
+				{
+					*pDest++ = (char)(0xE0 | (lChar >> 12));
+					*pDest++ = (char)(0x80 | ((lChar >> 6) & 0x3F));
+					*pDest++ = (char)(0x80 | (lChar & 0x3F));
+				}
+				else
+				{
+					*pDest++ = (char)(0xF0 | ((lChar >> 18) & 0x07));
+					*pDest++ = (char)(0x80 | ((lChar >> 12) & 0x3F));
+					*pDest++ = (char)(0x80 | ((lChar >> 6) & 0x3F));
+					*pDest++ = (char)(0x80 | (lChar & 0x3F));
+				}
+
+				*apDest = pDest;
+				return pDigit+1;
+			}
+		}
+		////////////////////////////
+		// Named entity
+		else
+		{
+			for(int i=0; i<glXmlEntityNum; ++i)
+			{
+				if(strncmp(apData, gvXmlEntities[i].mpName, gvXmlEntities[i].mlLength)==0)
+				{
+					*pDest++ = gvXmlEntities[i].mChar;
+					*apDest = pDest;
+					return apData + gvXmlEntities[i].mlLength;
+				}
+			}
+		}
+
+		////////////////////////////
+		// Unknown, the '&' is dropped like TinyXML does
+		return apData+1;
+	}
+
+	//-----------------------------------------------------------------------
+
+	char* cXmlParser::SetError(const char *apDesc, const char *apPos)
+	{
+		msErrorDesc = apDesc;
+
+		mlErrorRow = 1;
+		mlErrorCol = 1;
+		for(const char *pData = mpDataStart; pData < apPos && *pData; ++pData)
+		{
+			if(*pData=='\n')
+			{
+				++mlErrorRow;
+				mlErrorCol = 1;
+			}
+			else
+			{
+				++mlErrorCol;
+			}
+		}
+
+		return NULL;
+	}
+
+	//-----------------------------------------------------------------------
+}
@@ -33,6 +33,7 @@
 #include "graphics/LowLevelGraphics.h"
 #include "scene/World.h"
 #include "system/Platform.h"
+#include "system/Profiler.h"
 #include "scene/SoundEntity.h"
 
 namespace hpl {
@@ -65,6 +66,8 @@ namespace hpl {
 
 	void iPhysicsWorld::Update(float afTimeStep)
 	{
+		PROFILE_ZONE(PhysicsWorldUpdate)
+
 		//Clear all contact points.
 		mvContactPoints.clear();
 
@@ -88,19 +91,19 @@ namespace hpl {
 
 		////////////////////////////////////
 		//Update character bodies
-		START_TIMING(PhysicsCharacters)
+		PROFILE_BEGIN(PhysicsCharacters)
 		for(tCharacterBodyListIt CharIt = mlstCharBodies.begin(); CharIt != mlstCharBodies.end(); ++CharIt)
 		{
 			iCharacterBody *pBody = *CharIt;
 
 			pBody->Update(afTimeStep);
 		}
-		STOP_TIMING(PhysicsCharacters)
+		PROFILE_END(PhysicsCharacters)
 
 
 		////////////////////////////////////
 		//Update the rigid bodies before simulation.
-		START_TIMING(BodyBeforeSimulate)
+		PROFILE_BEGIN(BodyBeforeSimulate)
 		tPhysicsBodyList lstRemoveUpdateBodies;
 		for(tPhysicsBodySetIt BodyIt = m_setUpdateBodies.begin(); BodyIt != m_setUpdateBodies.end(); ++BodyIt)
 		{
@@ -123,14 +126,14 @@ namespace hpl {
 				RemoveBodyFromUpdateList(pBody, false);
 			}
 		}
-		STOP_TIMING(BodyBeforeSimulate)
+		PROFILE_END(BodyBeforeSimulate)
 
 
 		////////////////////////////////////
 		//Simulate the physics
-		START_TIMING(Simulate)
+		PROFILE_BEGIN(Simulate)
 		Simulate(afTimeStep);
-		STOP_TIMING(Simulate)
+		PROFILE_END(Simulate)
 
 		////////////////////////////////////
 		//Update the joints after simulation.
@@ -156,14 +159,14 @@ namespace hpl {
 		}
 		////////////////////////////////////
 		//Update the rigid bodies after simulation.
-		START_TIMING(BodyAfterSimulate)
+		PROFILE_BEGIN(BodyAfterSimulate)
 		for(tPhysicsBodySetIt BodyIt = m_setUpdateBodies.begin(); BodyIt != m_setUpdateBodies.end(); ++BodyIt)
 		{
 			iPhysicsBody *pBody = *BodyIt;
 
 			pBody->UpdateAfterSimulate(afTimeStep);
 		}
-		STOP_TIMING(BodyAfterSimulate)
+		PROFILE_END(BodyAfterSimulate)
 
 		////////////////////////////////////
 		//Update Ropes after simulate
@@ -21,6 +21,8 @@
 
 #include "system/String.h"
 #include "system/LowLevelSystem.h"
+#include "system/Platform.h"
+#include "system/Mutex.h"
 #include "resources/Resources.h"
 #include "graphics/Graphics.h"
 
@@ -40,12 +42,15 @@ namespace hpl {
 	{
 		mpResources = apResources;
 		mpGraphics = apGraphics;
+
+		mpLoadMutex = cPlatform::CreateMutEx();
 	}
 
 	//-----------------------------------------------------------------------
 
 	cBitmapLoaderHandler::~cBitmapLoaderHandler()
 	{
+		hplDelete(mpLoadMutex);
 	}
 
 	//-----------------------------------------------------------------------
@@ -62,7 +67,9 @@ namespace hpl {
 
 		if(pBitmapLoader)
 		{
+			mpLoadMutex->Lock();
 			cBitmap* pBitmap = pBitmapLoader->LoadBitmap(asFile, aFlags);
+			mpLoadMutex->Unlock();
 
 			//Set name of the file loaded.
 			if(pBitmap) pBitmap->SetFileName(cString::GetFileNameW(asFile));
@@ -83,7 +90,11 @@ namespace hpl {
 
 		if(pBitmapLoader)
 		{
-			return pBitmapLoader->SaveBitmap(apBitmap,asFile,aFlags);
+			mpLoadMutex->Lock();
+			bool bRet = pBitmapLoader->SaveBitmap(apBitmap,asFile,aFlags);
+			mpLoadMutex->Unlock();
+
+			return bRet;
 		}
 		return false;
 	}
@@ -45,7 +45,7 @@ namespace hpl {
 
 	bool cEntFile::CreateFromFile()
 	{
-		return mpXmlDoc->CreateFromFile(GetFullPath());
+		return mpXmlDoc->CreateFromFile(GetFullPath(), true);
 	}
 
 	//-----------------------------------------------------------------------
@@ -34,7 +34,6 @@
 #include "resources/LowLevelResources.h"
 #include "resources/XmlDocument.h"
 
-#include "impl/tinyXML/tinyxml.h"
 
 
 
@@ -243,30 +242,23 @@ namespace hpl {
 
 		if(pMaterial==NULL && sPath!=_W(""))
 		{
-			FILE *pFile = cPlatform::OpenFile(sPath, _W("rb"));
-			if(pFile==NULL) return "";
-
-			TiXmlDocument *pDoc = hplNew( TiXmlDocument, () );
-			if(!pDoc->LoadFile(pFile))
+			iXmlDocument* pDoc = mpResources->GetLowLevel()->CreateXmlDocument();
+			if(pDoc->CreateFromFile(sPath, true)==false)
 			{
-				fclose(pFile);
-				hplDelete(pDoc);
+				mpResources->DestroyXmlDocument(pDoc);
 				return "";
 			}
-			fclose(pFile);
-
-			TiXmlElement *pRoot = pDoc->RootElement();
 
-			TiXmlElement *pMain = pRoot->FirstChildElement("Main");
+			cXmlElement *pMain = pDoc->GetFirstElement("Main");
 			if(pMain==NULL){
-				hplDelete(pDoc);
-				Error("Main child not found in '%s'\n",sPath.c_str());
+				mpResources->DestroyXmlDocument(pDoc);
+				Error("Main child not found in '%s'\n",cString::To8Char(sPath).c_str());
 				return "";
 			}
 
-			tString sPhysicsName = cString::ToString(pMain->Attribute("PhysicsMaterial"),"Default");
+			tString sPhysicsName = pMain->GetAttributeString("PhysicsMaterial","Default");
 
-			hplDelete(pDoc);
+			mpResources->DestroyXmlDocument(pDoc);
 
 			return sPhysicsName;
 		}
@@ -299,7 +291,7 @@ namespace hpl {
 		//Log("Load material: %s\n", asName.c_str());
 
 		iXmlDocument* pDoc = mpResources->GetLowLevel()->CreateXmlDocument();
-		if(pDoc->CreateFromFile(asPath)==false)
+		if(pDoc->CreateFromFile(asPath, true)==false)
 		{
 			mpResources->DestroyXmlDocument(pDoc);
 			return NULL;
@@ -124,6 +124,7 @@ namespace hpl {
 				return NULL;
 			}
 
+			pMesh->SetMemorySize(GetMeshMemorySize(pMesh));
 			AddResource(pMesh);
 		}
 
@@ -176,6 +177,31 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	size_t cMeshManager::GetMeshMemorySize(cMesh *apMesh)
+	{
+		size_t lSize =0;
+		for(int i=0; i<apMesh->GetSubMeshNum(); ++i)
+		{
+			iVertexBuffer *pVtxBuffer = apMesh->GetSubMesh(i)->GetVertexBuffer();
+			if(pVtxBuffer==NULL) continue;
+
+			size_t lVtxNum = (size_t)pVtxBuffer->GetVertexNum();
+			for(int j=0; j<eVertexBufferElement_LastEnum; ++j)
+			{
+				eVertexBufferElement element = (eVertexBufferElement)j;
+				size_t lElementNum = (size_t)pVtxBuffer->GetElementNum(element);
+				if(lElementNum==0) continue;
+
+				size_t lElementSize = pVtxBuffer->GetElementFormat(element)==eVertexBufferElementFormat_Byte ? 1 : 4;
+				lSize += lVtxNum * lElementNum * lElementSize;
+			}
+
+			lSize += (size_t)pVtxBuffer->GetIndexNum() * sizeof(unsigned int);
+		}
+
+		return lSize;
+	}
+
 
 	//-----------------------------------------------------------------------
 }
@@ -19,6 +19,8 @@
 
 #include "resources/ResourceBase.h"
 
+#include "resources/ResourceManager.h"
+
 #include "system/LowLevelSystem.h"
 #include "system/String.h"
 
@@ -38,9 +40,16 @@ namespace hpl {
 		mlPrio = alPrio;
 		mlHandle = 0;
 		mlUserCount =0;
+		mlMemorySize = 0;
 		msName = asName;
 		mbLogDestruction = false;
 		msFullPath = asFullPath;
+
+		mpResourceManager = NULL;
+		mpPrevUnused = NULL;
+		mpNextUnused = NULL;
+		mlAccountedMemorySize = 0;
+		mlUnusedStamp = 0;
 	}
 
 	iResourceBase::~iResourceBase()
@@ -52,12 +61,24 @@ namespace hpl {
 
 	void iResourceBase::IncUserCount()
 	{
+		if(mlUserCount==0 && mpResourceManager) mpResourceManager->RemoveFromUnusedList(this);
+
 		mlUserCount++;
 		mlTime = (unsigned long)time(NULL);
 	}
 
 	//-----------------------------------------------------------------------
 
+	void iResourceBase::DecUserCount()
+	{
+		if(mlUserCount==0) return;
+
+		mlUserCount--;
+		if(mlUserCount==0 && mpResourceManager) mpResourceManager->AddToUnusedList(this);
+	}
+
+	//-----------------------------------------------------------------------
+
 	void iResourceBase::SetFullPath(const tWString& asPath)
 	{
 		msFullPath = asPath;
@@ -28,11 +28,10 @@
 
 #include "system/LowLevelSystem.h"
 
-#include <algorithm>
-
 namespace hpl {
 
 	int iResourceManager::mlTabCount=0;
+	unsigned int iResourceManager::mlUnusedStampCount=0;
 
 	//////////////////////////////////////////////////////////////////////////
 	// CONSTRUCTORS
@@ -47,6 +46,14 @@ namespace hpl {
 		mpFileSearcher = apFileSearcher;
 		mpLowLevelResources = apLowLevelResources;
 		mpLowLevelSystem = apLowLevelSystem;
+
+		mpFirstUnused = NULL;
+		mpLastUnused = NULL;
+		mlUnusedNum = 0;
+
+		mlMemoryBudget = 0;
+		mlMemoryUsage = 0;
+		mlUnusedMemoryUsage = 0;
 	}
 
 	//-----------------------------------------------------------------------
@@ -84,58 +91,56 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
-	class cSortResources
+    void iResourceManager::DestroyUnused(int alMaxToKeep)
 	{
-	public:
-		bool operator()(iResourceBase* apResourceA, iResourceBase* apResourceB)
+		//Only resources without users are in the unused list, oldest first, so just pop from the front.
+		while((int)m_mapResources.size() > alMaxToKeep && mpFirstUnused)
 		{
-			if(apResourceA->GetUserCount() != apResourceB->GetUserCount())
-			{
-				return apResourceA->GetUserCount() > apResourceB->GetUserCount();
-			}
+			DestroyOldestUnused();
+		}
+	}
+
+	//-----------------------------------------------------------------------
 
-			return apResourceA->GetTime() > apResourceB->GetTime();
+	size_t iResourceManager::DestroyUnusedMemory(size_t alMaxMemory)
+	{
+		size_t lFreed =0;
+		while(mlMemoryUsage > alMaxMemory && mpFirstUnused)
+		{
+			lFreed += mpFirstUnused->mlAccountedMemorySize;
+			DestroyOldestUnused();
 		}
-	};
+
+		return lFreed;
+	}
 
 	//-----------------------------------------------------------------------
 
-    void iResourceManager::DestroyUnused(int alMaxToKeep)
+	bool iResourceManager::DestroyOldestUnused()
 	{
-		//Log("Start Num Of: %d\n",m_mapHandleResources.size());
-		//Check if there are too many resources.
-		if((int)m_mapResources.size() <= alMaxToKeep) return;
+		iResourceBase *pRes = mpFirstUnused;
+		if(pRes==NULL) return false;
 
-		//Add resources to a vector
-		std::vector<iResourceBase*> vResources;
-		vResources.reserve(m_mapResources.size());
+		RemoveResource(pRes);
+		hplDelete(pRes);
 
-		tResourceBaseMapIt it = m_mapResources.begin();
-		for(;it != m_mapResources.end();++it)
-		{
-			vResources.push_back(it->second);
-		}
+		return true;
+	}
 
-		//Sort the sounds according to num of users and then time.
-		std::sort(vResources.begin(), vResources.end(), cSortResources());
+	//-----------------------------------------------------------------------
 
-		//Log("-------------Num: %d-----------------\n",vResources.size());
-		for(size_t i=alMaxToKeep; i<vResources.size(); ++i)
-		{
-			iResourceBase *pRes = vResources[i];
-			//Log("%s count:%d time:%d\n",pRes->GetName().c_str(),
-			//							pRes->GetUserCount(),
-			//							pRes->GetTime());
+	void iResourceManager::EnforceMemoryBudget()
+	{
+		if(mlMemoryBudget==0 || mlMemoryUsage <= mlMemoryBudget) return;
 
-			if(pRes->HasUsers()==false)
-			{
-				RemoveResource(pRes);
-				hplDelete(pRes);
-			}
-		}
-		//Log("--------------------------------------\n");
-		//Log("End Num Of: %d\n",m_mapHandleResources.size());
+		DestroyUnusedMemory(mlMemoryBudget);
+	}
+
+	//-----------------------------------------------------------------------
 
+	unsigned int iResourceManager::GetOldestUnusedStamp()
+	{
+		return mpFirstUnused ? mpFirstUnused->mlUnusedStamp : 0;
 	}
 
 	//-----------------------------------------------------------------------
@@ -209,14 +214,25 @@ namespace hpl {
 		return sTabs;
 	}
 
-	void iResourceManager::AddResource(iResourceBase* apResource, bool abLog, bool abAddToSet)
+	bool iResourceManager::IsInManager(iResourceBase* apResource)
 	{
-		tString sName = cString::ToLowerCase(apResource->GetName());
+		return apResource->mpResourceManager == this;
+	}
 
+	//-----------------------------------------------------------------------
+
+	void iResourceManager::AddResource(iResourceBase* apResource, bool abLog, bool abAddToSet)
+	{
 		if(abAddToSet)
 		{
 			int lHash = cString::GetHashW(apResource->GetFullPath());
 			m_mapResources.insert(tResourceBaseMap::value_type(lHash, apResource));
+
+			apResource->mpResourceManager = this;
+			apResource->mlAccountedMemorySize = apResource->GetMemorySize();
+			mlMemoryUsage += apResource->mlAccountedMemorySize;
+
+			if(apResource->HasUsers()==false) AddToUnusedList(apResource);
 		}
 
 		//Log("Adding %d, '%s' hash: %u\n",apResource,cString::To8Char(apResource->GetFullPath()).c_str(), lHash);
@@ -237,6 +253,10 @@ namespace hpl {
 	{
 		//Log("Removing resource name: '%s' path: '%s' ", apResource->GetName().c_str(), cString::To8Char(apResource->GetFullPath()).c_str());
 
+		//Always unlink, the resource can be in the unused list even if the map has no entry for it (like when the path changed),
+		//and a destroyed resource left in the list would be destroyed again by DestroyUnused.
+		RemoveFromUnusedList(apResource);
+
 		unsigned int lHash = cString::GetHashW(apResource->GetFullPath());
 
 		tResourceBaseMapIt it = m_mapResources.find(lHash);
@@ -257,6 +277,9 @@ namespace hpl {
 			{
 				//Log("...done!\n");
 				m_mapResources.erase(it);
+
+				mlMemoryUsage -= apResource->mlAccountedMemorySize;
+				apResource->mpResourceManager = NULL;
 				return;
 			}
 		}
@@ -264,5 +287,40 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	void iResourceManager::AddToUnusedList(iResourceBase* apResource)
+	{
+		if(apResource->mpPrevUnused || mpFirstUnused==apResource) return;
+
+		apResource->mpPrevUnused = mpLastUnused;
+		apResource->mpNextUnused = NULL;
+		if(mpLastUnused)	mpLastUnused->mpNextUnused = apResource;
+		else				mpFirstUnused = apResource;
+		mpLastUnused = apResource;
+
+		apResource->mlUnusedStamp = ++mlUnusedStampCount;
+		mlUnusedNum++;
+		mlUnusedMemoryUsage += apResource->mlAccountedMemorySize;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void iResourceManager::RemoveFromUnusedList(iResourceBase* apResource)
+	{
+		if(apResource->mpPrevUnused==NULL && mpFirstUnused!=apResource) return;
+
+		if(apResource->mpPrevUnused)	apResource->mpPrevUnused->mpNextUnused = apResource->mpNextUnused;
+		else							mpFirstUnused = apResource->mpNextUnused;
+		if(apResource->mpNextUnused)	apResource->mpNextUnused->mpPrevUnused = apResource->mpPrevUnused;
+		else							mpLastUnused = apResource->mpPrevUnused;
+
+		apResource->mpPrevUnused = NULL;
+		apResource->mpNextUnused = NULL;
+
+		mlUnusedNum--;
+		mlUnusedMemoryUsage -= apResource->mlAccountedMemorySize;
+	}
+
+	//-----------------------------------------------------------------------
+
 
 }
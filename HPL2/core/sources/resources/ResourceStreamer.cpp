@@ -0,0 +1,529 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "resources/ResourceStreamer.h"
+
+#include "resources/Resources.h"
+#include "resources/FileSearcher.h"
+#include "resources/TextureManager.h"
+#include "resources/MeshManager.h"
+#include "resources/MaterialManager.h"
+#include "resources/SoundManager.h"
+#include "resources/BitmapLoaderHandler.h"
+#include "resources/XmlCache.h"
+
+#include "graphics/Bitmap.h"
+#include "graphics/Texture.h"
+#include "graphics/Mesh.h"
+#include "graphics/Material.h"
+#include "sound/SoundData.h"
+
+#include "system/Platform.h"
+#include "system/Mutex.h"
+#include "system/Profiler.h"
+#include "system/String.h"
+#include "system/LowLevelSystem.h"
+#include "system/MemoryManager.h"
+
+namespace hpl {
+
+	//////////////////////////////////////////////////////////////////////////
+	// REQUEST BASE
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	iResourceRequest::iResourceRequest(const tString& asName, const tWString& asPath)
+	{
+		msName = asName;
+		msPath = asPath;
+
+		mState = eResourceRequestState_Pending;
+		mpResource = NULL;
+
+		mbCreatesResource = true;
+		mbLoaded = false;
+		mbLoadFailed = false;
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool iResourceRequest::PrefetchFile(const tWString& asPath)
+	{
+		FILE *pFile = cPlatform::OpenFile(asPath, _W("rb"));
+		if(pFile==NULL) return false;
+
+		const size_t lChunkSize = 256*1024;
+		std::vector<char> vBuffer(lChunkSize);
+		while(fread(&vBuffer[0], 1, lChunkSize, pFile) == lChunkSize);
+
+		fclose(pFile);
+		return true;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void iResourceRequest::Load()
+	{
+		mbLoadFailed = LoadData()==false;
+		mbLoaded = true;
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// TEXTURE REQUEST
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	class cTextureRequest : public iResourceRequest
+	{
+	public:
+		cTextureRequest(const tString& asName, const tWString& asPath, cBitmapLoaderHandler *apBitmapLoaderHandler,
+						bool abUseMipMaps, eTextureType aType, eTextureUsage aUsage, unsigned int alTextureSizeLevel)
+						: iResourceRequest(asName, asPath), mpBitmapLoaderHandler(apBitmapLoaderHandler), mpBitmap(NULL),
+						mbUseMipMaps(abUseMipMaps), mType(aType), mUsage(aUsage), mlTextureSizeLevel(alTextureSizeLevel) {}
+
+		~cTextureRequest()
+		{
+			if(mpBitmap) hplDelete(mpBitmap);
+		}
+
+	protected:
+		bool LoadData()
+		{
+			mpBitmap = mpBitmapLoaderHandler->LoadBitmap(GetPath(), 0);
+			return mpBitmap != NULL;
+		}
+
+		iResourceBase* CreateResource(cResources *apResources)
+		{
+			iTexture *pTexture = apResources->GetTextureManager()->CreateFromBitmap(GetName(), GetPath(), mpBitmap,
+																					mbUseMipMaps, mType, mUsage, mlTextureSizeLevel);
+			//Bitmap is no longer needed
+			hplDelete(mpBitmap);
+			mpBitmap = NULL;
+
+			return pTexture;
+		}
+
+		void DestroyResource(cResources *apResources, iResourceBase *apResource)
+		{
+			apResources->GetTextureManager()->Destroy(apResource);
+		}
+
+	private:
+		cBitmapLoaderHandler *mpBitmapLoaderHandler;
+		cBitmap *mpBitmap;
+
+		bool mbUseMipMaps;
+		eTextureType mType;
+		eTextureUsage mUsage;
+		unsigned int mlTextureSizeLevel;
+	};
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// FILE REQUEST
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	enum eFileRequestType
+	{
+		eFileRequestType_Prefetch,
+		eFileRequestType_Mesh,
+		eFileRequestType_Material,
+		eFileRequestType_SoundData,
+
+		eFileRequestType_LastEnum
+	};
+
+	//-----------------------------------------------------------------------
+
+	/**
+	 * Resources that the manager loads from file on the main thread. The file is read on the worker so that the loading on
+	 * the main thread does not have to wait for the disk. Meshes are read from their msh file if there is one and xml files
+	 * also get their cache read.
+	 */
+	class cFileRequest : public iResourceRequest
+	{
+	public:
+		cFileRequest(const tString& asName, const tWString& asPath, eFileRequestType aType) : iResourceRequest(asName, asPath), mType(aType)
+		{
+			mbCreatesResource = mType != eFileRequestType_Prefetch;
+		}
+
+	protected:
+		bool LoadData()
+		{
+			//The manager searches for the file itself if it was not found, so only a missing prefetch is an error.
+			if(GetPath()==_W("")) return mType != eFileRequestType_Prefetch;
+
+			tWString sExt = cString::ToLowerCaseW(cString::GetFileExtW(GetPath()));
+			if(sExt == _W("dae"))
+			{
+				if(PrefetchFile(cString::SetFileExtW(GetPath(), _W("msh")))) return true;
+			}
+			else if(sExt == _W("ent") || sExt == _W("mat") || sExt == _W("ps"))
+			{
+				PrefetchFile(cXmlCache::GetCacheFile(GetPath()));
+			}
+
+			return PrefetchFile(GetPath()) || mType != eFileRequestType_Prefetch;
+		}
+
+		iResourceBase* CreateResource(cResources *apResources)
+		{
+			switch(mType)
+			{
+			case eFileRequestType_Mesh:			return apResources->GetMeshManager()->CreateMesh(GetName());
+			case eFileRequestType_Material:		return apResources->GetMaterialManager()->CreateMaterial(GetName());
+			case eFileRequestType_SoundData:	return apResources->GetSoundManager()->CreateSoundData(GetName(), false);
+			default:							return NULL;
+			}
+		}
+
+		void DestroyResource(cResources *apResources, iResourceBase *apResource)
+		{
+			switch(mType)
+			{
+			case eFileRequestType_Mesh:			apResources->GetMeshManager()->Destroy(apResource); break;
+			case eFileRequestType_Material:		apResources->GetMaterialManager()->Destroy(apResource); break;
+			case eFileRequestType_SoundData:	apResources->GetSoundManager()->Destroy(apResource); break;
+			default:							break;
+			}
+		}
+
+	private:
+		eFileRequestType mType;
+	};
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// CONSTRUCTORS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	cResourceStreamer::cResourceStreamer(cResources *apResources)
+	{
+		mpResources = apResources;
+
+		mlUploadTimeBudget = 4;
+
+		mpLoadQueueMutex = cPlatform::CreateMutEx();
+
+		mpThread = cPlatform::CreateThread(this);
+		mpThread->SetSleepTime(1);
+		mpThread->Start();
+	}
+
+	//-----------------------------------------------------------------------
+
+	cResourceStreamer::~cResourceStreamer()
+	{
+		mpThread->Stop();
+		hplDelete(mpThread);
+
+		//Requests that are not done are cancelled, the resources of done requests belong to the managers.
+		STLDeleteAll(mlstRequests);
+		STLDeleteAll(mlstReleasedRequests);
+		mlstLoadQueue.clear();
+
+		hplDelete(mpLoadQueueMutex);
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// PUBLIC METHODS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	iResourceRequest* cResourceStreamer::RequestTexture(const tString& asName, bool abUseMipMaps, eTextureType aType,
+														eTextureUsage aUsage, unsigned int alTextureSizeLevel)
+	{
+		cTextureManager *pTextureManager = mpResources->GetTextureManager();
+
+		tWString sPath;
+		iTexture *pTexture = pTextureManager->FindTexture2D(asName, sPath);
+
+		cTextureRequest *pRequest = hplNew(cTextureRequest, (asName, sPath, mpResources->GetBitmapLoaderHandler(),
+															abUseMipMaps, aType, aUsage, alTextureSizeLevel) );
+
+		//Already loaded or missing, no need for any loading.
+		if(pTexture || sPath==_W(""))
+		{
+			if(pTexture)
+			{
+				pTexture->IncUserCount();
+				pRequest->mpResource = pTexture;
+				pRequest->mState = eResourceRequestState_Done;
+			}
+			else
+			{
+				Error("Couldn't find texture '%s'\n", asName.c_str());
+				pRequest->mState = eResourceRequestState_Failed;
+			}
+			return pRequest;
+		}
+
+		return AddRequest(pRequest);
+	}
+
+	//-----------------------------------------------------------------------
+
+	iResourceRequest* cResourceStreamer::RequestMesh(const tString& asName)
+	{
+		tWString sPath = mpResources->GetFileSearcher()->GetFilePath(asName);
+		return AddRequest(hplNew(cFileRequest, (asName, sPath, eFileRequestType_Mesh)) );
+	}
+
+	iResourceRequest* cResourceStreamer::RequestMaterial(const tString& asName)
+	{
+		tWString sPath = mpResources->GetFileSearcher()->GetFilePath(asName);
+		return AddRequest(hplNew(cFileRequest, (asName, sPath, eFileRequestType_Material)) );
+	}
+
+	iResourceRequest* cResourceStreamer::RequestSoundData(const tString& asName)
+	{
+		tWString sPath = mpResources->GetFileSearcher()->GetFilePath(asName);
+		return AddRequest(hplNew(cFileRequest, (asName, sPath, eFileRequestType_SoundData)) );
+	}
+
+	iResourceRequest* cResourceStreamer::RequestPrefetch(const tWString& asPath)
+	{
+		return AddRequest(hplNew(cFileRequest, (cString::To8Char(cString::GetFileNameW(asPath)), asPath, eFileRequestType_Prefetch)) );
+	}
+
+	//-----------------------------------------------------------------------
+
+	iResourceBase* cResourceStreamer::ReleaseRequest(iResourceRequest *apRequest)
+	{
+		if(apRequest->IsDone()==false)
+		{
+			CancelRequest(apRequest);
+			return NULL;
+		}
+
+		iResourceBase *pResource = apRequest->mpResource;
+		hplDelete(apRequest);
+
+		return pResource;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cResourceStreamer::CancelRequest(iResourceRequest *apRequest)
+	{
+		/////////////////////////
+		// Pending, might be loading so delete later if not still in the queue
+		if(apRequest->IsDone()==false)
+		{
+			mlstRequests.remove(apRequest);
+
+			if(RemoveFromLoadQueue(apRequest))
+			{
+				hplDelete(apRequest);
+			}
+			else
+			{
+				mlstReleasedRequests.push_back(apRequest);
+			}
+			return;
+		}
+
+		if(apRequest->mpResource) apRequest->DestroyResource(mpResources, apRequest->mpResource);
+		hplDelete(apRequest);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cResourceStreamer::WaitForRequest(iResourceRequest *apRequest)
+	{
+		if(apRequest->IsDone()) return;
+
+		//Load here if the loader thread has not got to it yet, else wait for it.
+		if(RemoveFromLoadQueue(apRequest))
+		{
+			apRequest->Load();
+		}
+		else
+		{
+			while(apRequest->mbLoaded==false) cPlatform::Sleep(0);
+		}
+
+		mlstRequests.remove(apRequest);
+		FinishRequest(apRequest);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cResourceStreamer::WaitForAll()
+	{
+		while(mlstRequests.empty()==false)
+		{
+			WaitForRequest(mlstRequests.front());
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cResourceStreamer::Update()
+	{
+		DestroyReleasedRequests();
+
+		if(mlstRequests.empty()) return;
+
+		unsigned long lStartTime = cPlatform::GetApplicationTime();
+
+		tResourceRequestListIt it = mlstRequests.begin();
+		while(it != mlstRequests.end())
+		{
+			iResourceRequest *pRequest = *it;
+			if(pRequest->mbLoaded==false)
+			{
+				++it;
+				continue;
+			}
+
+			it = mlstRequests.erase(it);
+			FinishRequest(pRequest);
+
+			if(cPlatform::GetApplicationTime() - lStartTime >= mlUploadTimeBudget) break;
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cResourceStreamer::UpdateThread()
+	{
+		static thread_local bool bNameSet = false;
+		if(bNameSet==false)
+		{
+			cProfiler::SetThreadName("Resource Streamer");
+			bNameSet = true;
+		}
+
+		//Load until the queue is empty, the thread then sleeps before the next update.
+		while(mpThread->IsActive())
+		{
+			mpLoadQueueMutex->Lock();
+			if(mlstLoadQueue.empty())
+			{
+				mpLoadQueueMutex->Unlock();
+				return;
+			}
+			iResourceRequest *pRequest = mlstLoadQueue.front();
+			mlstLoadQueue.pop_front();
+			mpLoadQueueMutex->Unlock();
+
+			PROFILE_ZONE(ResourceStreamerLoad);
+			pRequest->Load();
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// PRIVATE METHODS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	iResourceRequest* cResourceStreamer::AddRequest(iResourceRequest *apRequest)
+	{
+		mlstRequests.push_back(apRequest);
+
+		mpLoadQueueMutex->Lock();
+		mlstLoadQueue.push_back(apRequest);
+		mpLoadQueueMutex->Unlock();
+
+		return apRequest;
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool cResourceStreamer::RemoveFromLoadQueue(iResourceRequest *apRequest)
+	{
+		bool bRemoved = false;
+
+		mpLoadQueueMutex->Lock();
+		for(tResourceRequestListIt it = mlstLoadQueue.begin(); it != mlstLoadQueue.end(); ++it)
+		{
+			if(*it == apRequest)
+			{
+				mlstLoadQueue.erase(it);
+				bRemoved = true;
+				break;
+			}
+		}
+		mpLoadQueueMutex->Unlock();
+
+		return bRemoved;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cResourceStreamer::FinishRequest(iResourceRequest *apRequest)
+	{
+		if(apRequest->mbLoadFailed==false && apRequest->mbCreatesResource)
+		{
+			apRequest->mpResource = apRequest->CreateResource(mpResources);
+			if(apRequest->mpResource==NULL) apRequest->mbLoadFailed = true;
+		}
+
+		if(apRequest->mbLoadFailed)
+		{
+			Error("Couldn't load '%s' in the background\n", apRequest->GetName().c_str());
+			apRequest->mState = eResourceRequestState_Failed;
+		}
+		else
+		{
+			apRequest->mState = eResourceRequestState_Done;
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cResourceStreamer::DestroyReleasedRequests()
+	{
+		tResourceRequestListIt it = mlstReleasedRequests.begin();
+		while(it != mlstReleasedRequests.end())
+		{
+			iResourceRequest *pRequest = *it;
+			if(pRequest->mbLoaded==false)
+			{
+				++it;
+				continue;
+			}
+
+			it = mlstReleasedRequests.erase(it);
+			hplDelete(pRequest);
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+}
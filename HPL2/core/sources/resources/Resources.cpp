@@ -35,6 +35,7 @@
 #include "resources/AnimationManager.h"
 #include "resources/VideoManager.h"
 #include "resources/EntFileManager.h"
+#include "resources/ResourceStreamer.h"
 #include "resources/ConfigFile.h"
 #include "resources/LanguageFile.h"
 #include "resources/XmlDocument.h"
@@ -77,6 +78,9 @@ namespace hpl {
 		mpDefaultAreaLoader = NULL;
 
 		mpLanguageFile = NULL;
+		mpResourceStreamer = NULL;
+
+		mlMemoryBudget = 0;
 	}
 
 	//-----------------------------------------------------------------------
@@ -92,6 +96,9 @@ namespace hpl {
 		STLDeleteAll(mlstXmlDocuments);
 		STLDeleteAll(mlstBinBuffers);
 
+		//Must be before the managers, since pending requests might use them.
+		if(mpResourceStreamer) hplDelete(mpResourceStreamer);
+
 		hplDelete(mpFontManager);
 		hplDelete(mpScriptManager);
 		hplDelete(mpParticleManager);
@@ -118,6 +125,7 @@ namespace hpl {
 		if(mpLanguageFile) hplDelete(mpLanguageFile);
 
 		mlstManagers.clear();
+		mlstCachingManagers.clear();
 		Log("--------------------------------------------------------\n\n");
 	}
 
@@ -289,7 +297,7 @@ namespace hpl {
 		mpParticleManager = hplNew( cParticleManager,(apGraphics, this) );
 		mlstManagers.push_back(mpParticleManager);
 		mpSoundManager = hplNew( cSoundManager,(apSound, this) );
-		mlstManagers.push_back(mpParticleManager);
+		mlstManagers.push_back(mpSoundManager);
 		mpFontManager = hplNew( cFontManager,(apGraphics,apGui, this) );
 		mlstManagers.push_back(mpFontManager);
 		mpScriptManager = hplNew( cScriptManager,(apSystem, this) );
@@ -309,6 +317,14 @@ namespace hpl {
 		mpEntFileManager = hplNew( cEntFileManager,(this) );
 		mlstManagers.push_back(mpEntFileManager);
 
+		//Managers where resources without users are kept until destroyed by DestroyUnused or the budget
+		mlstCachingManagers.push_back(mpTextureManager);
+		mlstCachingManagers.push_back(mpSoundManager);
+		mlstCachingManagers.push_back(mpSoundEntityManager);
+		mlstCachingManagers.push_back(mpParticleManager);
+
+		mpResourceStreamer = hplNew( cResourceStreamer, (this) );
+
 		Log(" Adding loaders to handlers \n");
 
 		//Low level resources will load non-propitary formats.
@@ -326,6 +342,8 @@ namespace hpl {
 
 	void cResources::Update(float afTimeStep)
 	{
+		mpResourceStreamer->Update();
+
 		tResourceManagerListIt it = mlstManagers.begin();
 		for(; it != mlstManagers.end(); ++it)
 		{
@@ -333,6 +351,56 @@ namespace hpl {
 
 			pManager->Update(afTimeStep);
 		}
+
+		//////////////////////////
+		// Memory budgets
+		for(it = mlstCachingManagers.begin(); it != mlstCachingManagers.end(); ++it)
+		{
+			(*it)->EnforceMemoryBudget();
+		}
+
+		if(mlMemoryBudget==0) return;
+
+		size_t lUsage =0;
+		for(it = mlstCachingManagers.begin(); it != mlstCachingManagers.end(); ++it)
+		{
+			lUsage += (*it)->GetMemoryUsage();
+		}
+
+		//Destroy the oldest unused resource of all managers until under budget.
+		while(lUsage > mlMemoryBudget)
+		{
+			iResourceManager *pOldestManager = NULL;
+			unsigned int lOldestStamp =0;
+			for(it = mlstCachingManagers.begin(); it != mlstCachingManagers.end(); ++it)
+			{
+				unsigned int lStamp = (*it)->GetOldestUnusedStamp();
+				if(lStamp==0) continue;
+
+				if(pOldestManager==NULL || lStamp < lOldestStamp)
+				{
+					pOldestManager = *it;
+					lOldestStamp = lStamp;
+				}
+			}
+			if(pOldestManager==NULL) break;
+
+			size_t lPrevUsage = pOldestManager->GetMemoryUsage();
+			pOldestManager->DestroyOldestUnused();
+			lUsage -= lPrevUsage - pOldestManager->GetMemoryUsage();
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	size_t cResources::GetMemoryUsage()
+	{
+		size_t lUsage =0;
+		for(tResourceManagerListIt it = mlstManagers.begin(); it != mlstManagers.end(); ++it)
+		{
+			lUsage += (*it)->GetMemoryUsage();
+		}
+		return lUsage;
 	}
 
 	//-----------------------------------------------------------------------
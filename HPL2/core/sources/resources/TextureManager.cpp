@@ -47,8 +47,6 @@ namespace hpl {
 
 		mpBitmapLoaderHandler = mpResources->GetBitmapLoaderHandler();
 
-		mlMemoryUsage =0;
-
 		mvCubeSideSuffixes.push_back("_pos_x");
 		mvCubeSideSuffixes.push_back("_neg_x");
 		mvCubeSideSuffixes.push_back("_pos_y");
@@ -209,7 +207,6 @@ namespace hpl {
 			//Bitmaps no longer needed.
 			for(int j=0;j<(int)vBitmaps.size();j++) hplDelete(vBitmaps[j]);
 
-			mlMemoryUsage += pTexture->GetMemorySize();
 			AddResource(pTexture);
 		}
 
@@ -305,7 +302,6 @@ namespace hpl {
 				//Bitmaps no longer needed.
 				for(int j=0;j<(int)vBitmaps.size();j++)	hplDelete(vBitmaps[j]);
 
-				mlMemoryUsage += pTexture->GetMemorySize();
 				AddResource(pTexture);
 			}
 
@@ -331,7 +327,8 @@ namespace hpl {
 
 		if(apResource->HasUsers()==false)
 		{
-			mlMemoryUsage -= static_cast<iTexture*>(apResource)->GetMemorySize();
+			//When there is a budget, unused textures are kept in case they are used again and destroyed once the budget is exceeded.
+			if((GetMemoryBudget()>0 || mpResources->GetMemoryBudget()>0) && IsInManager(apResource)) return;
 
 			RemoveResource(apResource);
 			hplDelete(apResource);
@@ -340,6 +337,45 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	void cTextureManager::DestroyAll()
+	{
+		//Destroy does not delete textures when there is a budget, so do it here.
+		tResourceBaseMapIt it = m_mapResources.begin();
+		while(it != m_mapResources.end())
+		{
+			iResourceBase* pResource = it->second;
+
+			RemoveResource(pResource);
+			hplDelete(pResource);
+
+			it = m_mapResources.begin();
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	iTexture* cTextureManager::CreateFromBitmap(const tString& asName, const tWString& asPath, cBitmap *apBitmap,
+												bool abUseMipMaps, eTextureType aType, eTextureUsage aUsage,
+												unsigned int alTextureSizeLevel)
+	{
+		BeginLoad(asName);
+
+		//Might have been loaded while the bitmap was.
+		iTexture* pTexture = static_cast<iTexture*>(GetResource(asPath));
+		if(pTexture==NULL)
+		{
+			pTexture = CreateTextureFromBitmap(asName, asPath, apBitmap, abUseMipMaps, aType, aUsage, alTextureSizeLevel);
+		}
+
+		if(pTexture)pTexture->IncUserCount();
+		else Error("Couldn't texture '%s'\n",asName.c_str());
+
+		EndLoad();
+		return pTexture;
+	}
+
+	//-----------------------------------------------------------------------
+
 	void cTextureManager::Update(float afTimeStep)
 	{
 		tResourceBaseMapIt it = m_mapResources.begin();
@@ -384,26 +420,16 @@ namespace hpl {
 				return NULL;
 			}
 
-			//Create the texture and load from bitmap
-			pTexture = mpGraphics->GetLowLevel()->CreateTexture(asName,aType,aUsage);
-			pTexture->SetFullPath(sPath);
+			pTexture = CreateTextureFromBitmap(asName, sPath, pBmp, abUseMipMaps, aType, aUsage, alTextureSizeLevel);
 
-			pTexture->SetUseMipMaps(abUseMipMaps);
-			pTexture->SetSizeDownScaleLevel(alTextureSizeLevel);
+			//Bitmap is no longer needed so delete it.
+			hplDelete(pBmp);
 
-			if(pTexture->CreateFromBitmap(pBmp)==false)
+			if(pTexture==NULL)
 			{
-				hplDelete(pTexture);
-				hplDelete(pBmp);
 				EndLoad();
 				return NULL;
 			}
-
-			//Bitmap is no longer needed so delete it.
-			hplDelete(pBmp);
-
-			mlMemoryUsage += pTexture->GetMemorySize();
-			AddResource(pTexture);
 		}
 
 		if(pTexture)pTexture->IncUserCount();
@@ -415,6 +441,30 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	iTexture* cTextureManager::CreateTextureFromBitmap(	const tString& asName, const tWString& asPath, cBitmap *apBitmap,
+														bool abUseMipMaps, eTextureType aType, eTextureUsage aUsage,
+														unsigned int alTextureSizeLevel)
+	{
+		//Create the texture and load from bitmap
+		iTexture *pTexture = mpGraphics->GetLowLevel()->CreateTexture(asName,aType,aUsage);
+		pTexture->SetFullPath(asPath);
+
+		pTexture->SetUseMipMaps(abUseMipMaps);
+		pTexture->SetSizeDownScaleLevel(alTextureSizeLevel);
+
+		if(pTexture->CreateFromBitmap(apBitmap)==false)
+		{
+			hplDelete(pTexture);
+			return NULL;
+		}
+
+		AddResource(pTexture);
+
+		return pTexture;
+	}
+
+	//-----------------------------------------------------------------------
+
 	iTexture* cTextureManager::FindTexture2D(const tString &asName, tWString &asFilePath)
 	{
 		iTexture *pTexture=NULL;
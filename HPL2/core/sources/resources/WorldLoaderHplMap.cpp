@@ -22,6 +22,7 @@
 #include "system/String.h"
 #include "system/LowLevelSystem.h"
 #include "system/Platform.h"
+#include "system/JobManager.h"
 
 #include "resources/Resources.h"
 #include "resources/MeshManager.h"
@@ -31,6 +32,8 @@
 #include "resources/XmlDocument.h"
 #include "resources/EngineFileLoading.h"
 #include "resources/BinaryBuffer.h"
+#include "resources/ResourceStreamer.h"
+#include "resources/FileSearcher.h"
 
 #include "scene/Scene.h"
 #include "scene/World.h"
@@ -50,6 +53,8 @@
 #include "graphics/LowLevelGraphics.h"
 #include "graphics/VertexBuffer.h"
 #include "graphics/MeshCreator.h"
+#include "graphics/Material.h"
+#include "graphics/MaterialType.h"
 
 #include "physics/Physics.h"
 #include "physics/PhysicsWorld.h"
@@ -109,47 +114,12 @@ namespace hpl {
 
 		mpCurrentWorld = NULL;
 		mpCurrentPhysicsWorld = NULL;
-
-		///////////////////////////////////
-		// Generate some tables used by map loading
-		mpShortNegPosFloatTable = hplNewArray(float, 0xFFFF + 2);
-		mpByteNegPosFloatTable = hplNewArray(float, 257);
-		mpBytePosFloatTable = hplNewArray(float, 257);
-
-		///////////////////////////////////
-		// Short to float conversion
-		for(int i=0; i<=0xFFFF; ++i)
-		{
-			short lX = *((short*)&i);
-			float fX = ((float)lX);
-            mpShortNegPosFloatTable[i] = fX / 32767.0f;
-		}
-
-		///////////////////////////////////
-		// Signed char to float
-		for(int i=0; i<=255; ++i)
-		{
-			char lX = *((char*)&i);
-			float fX = ((float)lX);
-			mpByteNegPosFloatTable[i] = fX / 127.0f;
-		}
-
-		///////////////////////////////////
-		// Unsigned char to float
-		for(int i=0; i<=255; ++i)
-		{
-			float fX = (float)i;
-			mpBytePosFloatTable[i] = fX / 255.0f;
-		}
 	}
 
 	//-----------------------------------------------------------------------
 
 	cWorldLoaderHplMap::~cWorldLoaderHplMap()
 	{
-		hplDeleteArray(mpShortNegPosFloatTable);
-		hplDeleteArray(mpByteNegPosFloatTable);
-		hplDeleteArray(mpBytePosFloatTable);
 	}
 
 	//-----------------------------------------------------------------------
@@ -256,8 +226,8 @@ namespace hpl {
 		unsigned long lDeltaTime;
 
 		mlSortingTimeTotal =0;
-		mlCombineMeshTimeTotal=0;
-		mlCombineBodyTimeTotal=0;
+		mlCombineFillTimeTotal=0;
+		mlCombineCreateTimeTotal=0;
 
 
 		if(gbLogTiming) Log(" -------- Loading map '%s' ---------\n", cString::To8Char(cString::GetFileNameW(asFile)).c_str());
@@ -320,6 +290,11 @@ namespace hpl {
 		// Load File Indices
 		LoadFileIndicies(pXmlContents);
 
+		///////////////////////////////////
+		// Read the files in the background, in the order they are loaded, so they are in the file cache when needed
+		if(mbLoadedCache==false) PrefetchFiles(mvFileIndices_StaticObjects);
+		if( (mlCurrentFlags & eWorldLoadFlag_NoEntities)==0) PrefetchFiles(mvFileIndices_Entities);
+
 		///////////////////////////////////
 		// Load Static objects
 		if(mbLoadedCache==false)
@@ -355,6 +330,7 @@ namespace hpl {
 		//////////////////////////////
 		// Final clean up
 		STLDeleteAll(mlstStaticShapeBodies);
+		CancelPrefetches();
 
 		hplDelete(pDoc);
 
@@ -392,44 +368,301 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
-	static void AddBinaryBufferDataWithFormat(cBinaryBuffer* apBuffer, void *apSrcData, size_t alSize, eVertexBufferElementFormat aFormat)
+	static size_t GetVertexFormatSize(eVertexBufferElementFormat aFormat)
 	{
 		switch(aFormat)
 		{
-		case eVertexBufferElementFormat_Int:
-			apBuffer->AddInt32Array((int*)apSrcData, alSize);
-			break;
-		case eVertexBufferElementFormat_Float:
-			apBuffer->AddFloat32Array((float*)apSrcData, alSize);
-			break;
-		case eVertexBufferElementFormat_Byte:
-			apBuffer->AddCharArray((char*)apSrcData, alSize);
-			break;
-		default:
-			Error("Vertex buffer has incorrect format when adding binary data during loading of MSH file!\n");
-			break;
+		case eVertexBufferElementFormat_Int:		return sizeof(int);
+		case eVertexBufferElementFormat_Float:		return sizeof(float);
+		case eVertexBufferElementFormat_Byte:		return sizeof(char);
 		}
+		return 0;
 	}
 
 	//-----------------------------------------------------------------------
 
-	static void GetBinaryBufferDataWithFormat(cBinaryBuffer* apBuffer, void *apDestData, size_t alSize, eVertexBufferElementFormat aFormat)
+	//////////////////////////////////////////////////////////////////////////
+	// MAP CACHE FORMAT
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	/*
+	 * The cache is made to be memory mapped and read in place. It starts with a header that has the offset
+	 * (in bytes from the start of the file) and size of each section. All sections start at an aligned offset:
+	 *  - String table: zero terminated strings, records refer to these with an offset into the table.
+	 *  - Records: fixed size arrays of mesh bodies, shape bodies, shapes, meshes and vertex arrays.
+	 *  - Blobs: raw vertex arrays, indices and serialized physics shapes, offset relative to the section.
+	 * Data is stored in native byte order.
+	 */
+
+	#define kMapCacheAlignment 16
+
+	class cMapCacheHeader
 	{
-		switch(aFormat)
+	public:
+		unsigned int mlMagicNumber;
+		int mlVersion;
+		int mlFileSize;
+
+		int mlStringTableOffset;
+		int mlStringTableSize;
+
+		int mlMeshBodyOffset;
+		int mlMeshBodyNum;
+		int mlShapeBodyOffset;
+		int mlShapeBodyNum;
+		int mlShapeOffset;
+		int mlShapeNum;
+		int mlMeshOffset;
+		int mlMeshNum;
+		int mlVtxArrayOffset;
+		int mlVtxArrayNum;
+
+		int mlBlobOffset;
+		int mlBlobSize;
+	};
+
+	class cMapCacheMeshBody
+	{
+	public:
+		int mlName;
+		int mlMaterial;
+		int mlBlocksLight;
+		int mlCharCollider;
+		int mlShapeOffset;
+		int mlShapeSize;
+	};
+
+	class cMapCacheShapeBody
+	{
+	public:
+		int mlMaterial;
+		int mlCharCollider;
+		int mlBlocksLight;
+		int mlFirstShape;
+		int mlShapeNum;
+		float mfTransform[16];
+	};
+
+	class cMapCacheShape
+	{
+	public:
+		int mlType;
+		float mfSize[3];
+		float mfOffset[16];
+	};
+
+	class cMapCacheMesh
+	{
+	public:
+		int mlName;
+		int mlMaterial;
+		int mlCastShadows;
+		int mlVtxNum;
+		int mlFirstVtxArray;
+		int mlVtxArrayNum;
+		int mlIdxNum;
+		int mlIdxOffset;
+	};
+
+	class cMapCacheVtxArray
+	{
+	public:
+		int mlType;
+		int mlFormat;
+		int mlProgramVarIndex;
+		int mlElementNum;
+		int mlDataOffset;
+		int mlDataSize;
+	};
+
+	//-----------------------------------------------------------------------
+
+	static int AlignMapCacheOffset(size_t alOffset)
+	{
+		return (int)((alOffset + kMapCacheAlignment-1) & ~((size_t)kMapCacheAlignment-1));
+	}
+
+	//-----------------------------------------------------------------------
+
+	/**
+	 * Builds the string table and blob section when saving.
+	 */
+	class cMapCacheWriter
+	{
+	public:
+		int AddString(const tString& asStr)
 		{
-		case eVertexBufferElementFormat_Int:
-			apBuffer->GetInt32Array((int*)apDestData, alSize);
-			break;
-		case eVertexBufferElementFormat_Float:
-			apBuffer->GetFloat32Array((float*)apDestData, alSize);
-			break;
-		case eVertexBufferElementFormat_Byte:
-			apBuffer->GetCharArray((char*)apDestData, alSize);
-			break;
-		default:
-			Error("Vertex buffer has incorrect format when getting binary data during loading of MSH file!\n");
-			break;
+			std::map<tString, int>::iterator it = m_mapStringOffsets.find(asStr);
+			if(it != m_mapStringOffsets.end()) return it->second;
+
+			int lOffset = (int)mvStrings.size();
+			mvStrings.insert(mvStrings.end(), asStr.c_str(), asStr.c_str() + asStr.size()+1);
+			m_mapStringOffsets.insert(std::map<tString, int>::value_type(asStr, lOffset));
+			return lOffset;
+		}
+
+		int AddBlob(const void *apData, size_t alSize)
+		{
+			int lOffset = AlignMapCacheOffset(mvBlobs.size());
+			mvBlobs.resize(lOffset + alSize, 0);
+			if(alSize > 0) memcpy(&mvBlobs[lOffset], apData, alSize);
+			return lOffset;
+		}
+
+		std::vector<char> mvStrings;
+		std::vector<char> mvBlobs;
+
+	private:
+		std::map<tString, int> m_mapStringOffsets;
+	};
+
+	//-----------------------------------------------------------------------
+
+	template<class T>
+	static int AddMapCacheSection(cBinaryBuffer *apBuffer, const std::vector<T>& avData)
+	{
+		static const char vPadding[kMapCacheAlignment] = {0};
+
+		int lOffset = AlignMapCacheOffset(apBuffer->GetSize());
+		apBuffer->AddCharArray(vPadding, lOffset - apBuffer->GetSize());
+		if(avData.empty()==false) apBuffer->AddCharArray((const char*)&avData[0], avData.size() * sizeof(T));
+
+		return lOffset;
+	}
+
+	//-----------------------------------------------------------------------
+
+	static bool MapCacheSectionIsValid(const cMapCacheHeader *apHeader, int alOffset, int alNum, size_t alElementSize)
+	{
+		if(alOffset < 0 || alNum < 0 || (alOffset % kMapCacheAlignment) != 0) return false;
+		return (size_t)alOffset + (size_t)alNum * alElementSize <= (size_t)apHeader->mlFileSize;
+	}
+
+	//-----------------------------------------------------------------------
+
+	static bool MapCacheStringIsValid(const cMapCacheHeader *apHeader, int alOffset)
+	{
+		//The table is checked to end with a 0 so any offset inside it gives a terminated string.
+		return alOffset >= 0 && alOffset < apHeader->mlStringTableSize;
+	}
+
+	static bool MapCacheBlobIsValid(const cMapCacheHeader *apHeader, int alOffset, size_t alSize)
+	{
+		if(alOffset < 0) return false;
+		return (size_t)alOffset + alSize <= (size_t)apHeader->mlBlobSize;
+	}
+
+	//-----------------------------------------------------------------------
+
+	/**
+	 * Checks that every record only refers to strings, records and blobs inside their sections, so a broken
+	 * or tampered cache is never read out of bounds. Must be called after the section table has been checked.
+	 */
+	static bool MapCacheRecordsAreValid(const char *apFileData, const cMapCacheHeader *apHeader)
+	{
+		const cMapCacheMeshBody *pMeshBodies = (const cMapCacheMeshBody*)(apFileData + apHeader->mlMeshBodyOffset);
+		const cMapCacheShapeBody *pShapeBodies = (const cMapCacheShapeBody*)(apFileData + apHeader->mlShapeBodyOffset);
+		const cMapCacheShape *pShapes = (const cMapCacheShape*)(apFileData + apHeader->mlShapeOffset);
+		const cMapCacheMesh *pMeshes = (const cMapCacheMesh*)(apFileData + apHeader->mlMeshOffset);
+		const cMapCacheVtxArray *pVtxArrays = (const cMapCacheVtxArray*)(apFileData + apHeader->mlVtxArrayOffset);
+
+		////////////////////////////////////////
+		// Mesh Bodies
+		for(int i=0; i<apHeader->mlMeshBodyNum; ++i)
+		{
+			const cMapCacheMeshBody &meshBody = pMeshBodies[i];
+
+			if(	MapCacheStringIsValid(apHeader, meshBody.mlName)==false ||
+				MapCacheStringIsValid(apHeader, meshBody.mlMaterial)==false ||
+				meshBody.mlShapeSize < (int)(sizeof(float)*6) || //Must at least hold the bounds
+				MapCacheBlobIsValid(apHeader, meshBody.mlShapeOffset, (size_t)meshBody.mlShapeSize)==false)
+			{
+				return false;
+			}
+		}
+
+		////////////////////////////////////////
+		// Shape Bodies and Shapes
+		for(int i=0; i<apHeader->mlShapeBodyNum; ++i)
+		{
+			const cMapCacheShapeBody &shapeBody = pShapeBodies[i];
+
+			if(	MapCacheStringIsValid(apHeader, shapeBody.mlMaterial)==false ||
+				shapeBody.mlFirstShape < 0 || shapeBody.mlShapeNum < 0 ||
+				(size_t)shapeBody.mlFirstShape + (size_t)shapeBody.mlShapeNum > (size_t)apHeader->mlShapeNum)
+			{
+				return false;
+			}
+		}
+
+		for(int i=0; i<apHeader->mlShapeNum; ++i)
+		{
+			if(pShapes[i].mlType < 0 || pShapes[i].mlType >= eCollideShapeType_LastEnum) return false;
+		}
+
+		////////////////////////////////////////
+		// Meshes and Vertex Arrays
+		for(int i=0; i<apHeader->mlMeshNum; ++i)
+		{
+			const cMapCacheMesh &mesh = pMeshes[i];
+
+			if(	MapCacheStringIsValid(apHeader, mesh.mlName)==false ||
+				MapCacheStringIsValid(apHeader, mesh.mlMaterial)==false ||
+				mesh.mlVtxNum < 0 || mesh.mlIdxNum < 0 ||
+				mesh.mlFirstVtxArray < 0 || mesh.mlVtxArrayNum < 0 ||
+				(size_t)mesh.mlFirstVtxArray + (size_t)mesh.mlVtxArrayNum > (size_t)apHeader->mlVtxArrayNum ||
+				MapCacheBlobIsValid(apHeader, mesh.mlIdxOffset, (size_t)mesh.mlIdxNum * sizeof(unsigned int))==false ||
+				((size_t)apHeader->mlBlobOffset + (size_t)mesh.mlIdxOffset) % sizeof(unsigned int) != 0)
+			{
+				return false;
+			}
+
+			//Indices must point at existing vertices
+			const unsigned int *pIndices = (const unsigned int*)(apFileData + apHeader->mlBlobOffset + mesh.mlIdxOffset);
+			for(int j=0; j<mesh.mlIdxNum; ++j)
+			{
+				if(pIndices[j] >= (unsigned int)mesh.mlVtxNum) return false;
+			}
+
+			for(int j=0; j<mesh.mlVtxArrayNum; ++j)
+			{
+				const cMapCacheVtxArray &vtxArray = pVtxArrays[mesh.mlFirstVtxArray + j];
+
+				if(	vtxArray.mlType < 0 || vtxArray.mlType >= eVertexBufferElement_LastEnum ||
+					vtxArray.mlFormat < 0 || vtxArray.mlFormat >= eVertexBufferElementFormat_LastEnum ||
+					vtxArray.mlElementNum < 1 || vtxArray.mlElementNum > 4)
+				{
+					return false;
+				}
+
+				//The data is copied straight into the vertex buffer, so it must match the size of the array exactly.
+				size_t lDataSize = (size_t)mesh.mlVtxNum * (size_t)vtxArray.mlElementNum *
+									GetVertexFormatSize((eVertexBufferElementFormat)vtxArray.mlFormat);
+				if(	vtxArray.mlDataSize < 0 || (size_t)vtxArray.mlDataSize != lDataSize ||
+					MapCacheBlobIsValid(apHeader, vtxArray.mlDataOffset, lDataSize)==false)
+				{
+					return false;
+				}
+			}
 		}
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------
+
+	/**
+	 * Combined static geometry can be used as software occluder if nothing can be seen through it.
+	 */
+	static bool MaterialIsOccluder(cMaterial *apMaterial)
+	{
+		if(apMaterial==NULL || apMaterial->GetType()==NULL) return false;
+
+		return	apMaterial->GetType()->IsTranslucent()==false &&
+				apMaterial->GetAlphaMode() == eMaterialAlphaMode_Solid &&
+				apMaterial->GetTexture(eMaterialTexture_Alpha)==NULL;
 	}
 
 	//-----------------------------------------------------------------------
@@ -455,9 +688,10 @@ namespace hpl {
 		}
 
 		////////////////////////////////////////
-		// Load file
-		cBinaryBuffer binBuff(sCacheFile);
-		if(binBuff.Load()==false)
+		// Map file
+		size_t lFileSize = 0;
+		const char *pFileData = (const char*)cPlatform::MapFile(sCacheFile, &lFileSize);
+		if(pFileData==NULL)
 		{
 			Error("Could not map cache file '%s'.", cString::To8Char(asFile).c_str());
 			return;
@@ -465,83 +699,112 @@ namespace hpl {
 
 		/////////////////////////////////////////////////
 		// Header
-		int lMagicNum = binBuff.GetInt32();
-		int lVersion = binBuff.GetInt32();
+		const cMapCacheHeader *pHeader = (const cMapCacheHeader*)pFileData;
 
-		//Check magic number
-		if(lMagicNum != MAP_CACHE_FORMAT_MAGIC_NUMBER)
+		if(lFileSize < sizeof(cMapCacheHeader) || pHeader->mlMagicNumber != MAP_CACHE_FORMAT_MAGIC_NUMBER)
 		{
-			Error("File '%s' does not have right MAP_CACHE magic number (%X instead of %X)! Invalid header!\n", cString::To8Char(asFile).c_str(),lMagicNum,MAP_CACHE_FORMAT_MAGIC_NUMBER);
+			Error("File '%s' does not have right MAP_CACHE magic number! Invalid header!\n", cString::To8Char(asFile).c_str());
+			cPlatform::UnmapFile(pFileData, lFileSize);
 			return;
 		}
 
 		//Check so file has he right version
-		if(lVersion != MAP_CACHE_FORMAT_VERSION)
+		if(pHeader->mlVersion != MAP_CACHE_FORMAT_VERSION)
+		{
+			Error("File '%s' does not have right MAP_CACHE version! Is %d, newest is %d\n", cString::To8Char(asFile).c_str(),pHeader->mlVersion,MAP_CACHE_FORMAT_VERSION);
+			cPlatform::UnmapFile(pFileData, lFileSize);
+			return;
+		}
+
+		//Check that all sections are inside the file
+		if(	(size_t)pHeader->mlFileSize != lFileSize ||
+			MapCacheSectionIsValid(pHeader, pHeader->mlStringTableOffset, pHeader->mlStringTableSize, 1)==false ||
+			MapCacheSectionIsValid(pHeader, pHeader->mlMeshBodyOffset, pHeader->mlMeshBodyNum, sizeof(cMapCacheMeshBody))==false ||
+			MapCacheSectionIsValid(pHeader, pHeader->mlShapeBodyOffset, pHeader->mlShapeBodyNum, sizeof(cMapCacheShapeBody))==false ||
+			MapCacheSectionIsValid(pHeader, pHeader->mlShapeOffset, pHeader->mlShapeNum, sizeof(cMapCacheShape))==false ||
+			MapCacheSectionIsValid(pHeader, pHeader->mlMeshOffset, pHeader->mlMeshNum, sizeof(cMapCacheMesh))==false ||
+			MapCacheSectionIsValid(pHeader, pHeader->mlVtxArrayOffset, pHeader->mlVtxArrayNum, sizeof(cMapCacheVtxArray))==false ||
+			MapCacheSectionIsValid(pHeader, pHeader->mlBlobOffset, pHeader->mlBlobSize, 1)==false ||
+			pHeader->mlStringTableSize <= 0 || pFileData[pHeader->mlStringTableOffset + pHeader->mlStringTableSize-1] != 0)
+		{
+			Error("File '%s' has a broken MAP_CACHE section table!\n", cString::To8Char(asFile).c_str());
+			cPlatform::UnmapFile(pFileData, lFileSize);
+			return;
+		}
+
+		//Check that all records point inside their sections, else skip the cache and do a full load
+		if(MapCacheRecordsAreValid(pFileData, pHeader)==false)
 		{
-			Error("File '%s' does not have right MAP_CACHE version! Is %d, newest is %d\n", cString::To8Char(asFile).c_str(),lVersion,MAP_CACHE_FORMAT_VERSION);
+			Error("File '%s' has broken MAP_CACHE records! Loading map without cache.\n", cString::To8Char(asFile).c_str());
+			cPlatform::UnmapFile(pFileData, lFileSize);
 			return;
 		}
 
+		const char *pStrings = pFileData + pHeader->mlStringTableOffset;
+		const char *pBlobs = pFileData + pHeader->mlBlobOffset;
+
+		const cMapCacheMeshBody *pMeshBodies = (const cMapCacheMeshBody*)(pFileData + pHeader->mlMeshBodyOffset);
+		const cMapCacheShapeBody *pShapeBodies = (const cMapCacheShapeBody*)(pFileData + pHeader->mlShapeBodyOffset);
+		const cMapCacheShape *pShapes = (const cMapCacheShape*)(pFileData + pHeader->mlShapeOffset);
+		const cMapCacheMesh *pMeshes = (const cMapCacheMesh*)(pFileData + pHeader->mlMeshOffset);
+		const cMapCacheVtxArray *pVtxArrays = (const cMapCacheVtxArray*)(pFileData + pHeader->mlVtxArrayOffset);
+
 		////////////////////////////////////////
 		// General Data
 		unsigned long lStartTime = cPlatform::GetApplicationTime();
 		mbLoadedCache = true; //Cache is now loaded!
 
-		int lStaticMeshBodyNum = binBuff.GetInt32();
-		int lStaticShapeBodyNum = binBuff.GetInt32();
-		int lStaticMeshEntities = binBuff.GetInt32();
-		mlStaticMeshBodiesCreated = lStaticMeshBodyNum;
-		mlStaticMeshEntitiesCreated = lStaticMeshEntities;
+		mlStaticMeshBodiesCreated = pHeader->mlMeshBodyNum;
+		mlStaticMeshEntitiesCreated = pHeader->mlMeshNum;
 
 		////////////////////////////////////////
 		// Iterate Mesh Bodies
-		for(int i=0; i<lStaticMeshBodyNum; ++i)
+		for(int i=0; i<pHeader->mlMeshBodyNum; ++i)
 		{
-			//////////////////////////////////////
-			// General properties
-			tString sName, sMaterial;
-			binBuff.GetString(&sName);
-			binBuff.GetString(&sMaterial);
-			bool bBlocksLight = binBuff.GetBool();
-			bool bColliderCharacer = binBuff.GetBool();
-
-            //int iNewtonSize = binBuff.GetInt32();
+			const cMapCacheMeshBody &meshBody = pMeshBodies[i];
 
 			//////////////////////////////////////
 			// Load Shape
-            iCollideShape *pShape = mpCurrentPhysicsWorld->LoadMeshShapeFromBuffer(&binBuff);
+			iCollideShape *pShape = mpCurrentPhysicsWorld->LoadMeshShapeFromMemory(pBlobs + meshBody.mlShapeOffset, (size_t)meshBody.mlShapeSize);
+			if(pShape==NULL)
+			{
+				Error("Could not load collision shape of '%s' from map cache!\n", pStrings + meshBody.mlName);
+				continue;
+			}
 
 			//////////////////////////////////////
 			// Create Body
-            iPhysicsBody *pBody = mpCurrentPhysicsWorld->CreateBody(sName, pShape);
+			iPhysicsBody *pBody = mpCurrentPhysicsWorld->CreateBody(pStrings + meshBody.mlName, pShape);
 
-			pBody->SetMaterial(mpCurrentPhysicsWorld->GetMaterialFromName(sMaterial));
-			pBody->SetBlocksLight(bBlocksLight);
-			pBody->SetCollide(!bColliderCharacer); //A character collider only collides with characters
+			pBody->SetMaterial(mpCurrentPhysicsWorld->GetMaterialFromName(pStrings + meshBody.mlMaterial));
+			pBody->SetBlocksLight(meshBody.mlBlocksLight != 0);
+			pBody->SetCollide(meshBody.mlCharCollider == 0); //A character collider only collides with characters
 		}
 
 		////////////////////////////////////////
 		// Iterate Shape Bodies
-		for(int i=0; i<lStaticShapeBodyNum; ++i)
+		for(int i=0; i<pHeader->mlShapeBodyNum; ++i)
 		{
-			cHplMapShapeBody shapeBody;
+			const cMapCacheShapeBody &cacheBody = pShapeBodies[i];
 
-			binBuff.GetString(&shapeBody.msMaterial);
-			binBuff.GetMatrixf(&shapeBody.m_mtxTransform);
-			shapeBody.mbCharCollider = binBuff.GetBool();
-			shapeBody.mbBlocksLight = binBuff.GetBool();
+			cHplMapShapeBody shapeBody;
+			shapeBody.msMaterial = pStrings + cacheBody.mlMaterial;
+			memcpy(shapeBody.m_mtxTransform.v, cacheBody.mfTransform, sizeof(float)*16);
+			shapeBody.mbCharCollider = cacheBody.mlCharCollider != 0;
+			shapeBody.mbBlocksLight = cacheBody.mlBlocksLight != 0;
 
-			int lColliderNum = binBuff.GetInt32();
-			shapeBody.mvColliders.resize(lColliderNum);
+			shapeBody.mvColliders.resize(cacheBody.mlShapeNum);
 
-			for(int i=0; i<shapeBody.mvColliders.size(); ++i)
+			for(int j=0; j<cacheBody.mlShapeNum; ++j)
 			{
+				const cMapCacheShape &cacheShape = pShapes[cacheBody.mlFirstShape + j];
+
 				cHplMapShape *pShape = hplNew(cHplMapShape, ());
-				shapeBody.mvColliders[i] = pShape;
+				shapeBody.mvColliders[j] = pShape;
 
-				pShape->mType = (eCollideShapeType)binBuff.GetInt32();
-				binBuff.GetVector3f(&pShape->mvSize);
-				binBuff.GetMatrixf(&pShape->m_mtxOffset);
+				pShape->mType = (eCollideShapeType)cacheShape.mlType;
+				pShape->mvSize = cVector3f(cacheShape.mfSize[0], cacheShape.mfSize[1], cacheShape.mfSize[2]);
+				memcpy(pShape->m_mtxOffset.v, cacheShape.mfOffset, sizeof(float)*16);
 			}
 
 			CreateShapeBody(&shapeBody);
@@ -549,14 +812,14 @@ namespace hpl {
 
 		////////////////////////////////////////
 		// Iterate Meshes
-		for(int mesh=0; mesh<lStaticMeshEntities; ++mesh)
+		for(int mesh=0; mesh<pHeader->mlMeshNum; ++mesh)
 		{
+			const cMapCacheMesh &cacheMesh = pMeshes[mesh];
+
 			/////////////////////////
 			// General Data
-			tString sName, sMaterial;
-			binBuff.GetString(&sName);
-			binBuff.GetString(&sMaterial);
-			bool bCastShadows = binBuff.GetBool();
+			tString sName = pStrings + cacheMesh.mlName;
+			tString sMaterial = pStrings + cacheMesh.mlMaterial;
 
 			if(gbLogCacheLoad) Log("Mesh %d: '%s' '%s'\n", mesh, sName.c_str(), sMaterial.c_str());
 
@@ -578,98 +841,35 @@ namespace hpl {
 			}
 
 			////////////////////
-			// Vertex data
+			// Vertex data, the arrays are stored in the same format as the vertex buffer uses and are copied straight from the file.
 			iVertexBuffer* pVtxBuff = mpGraphics->GetLowLevel()->CreateVertexBuffer(eVertexBufferType_Hardware, eVertexBufferDrawType_Tri,
 																					eVertexBufferUsageType_Static, 0, 0);
+
+			if(gbLogCacheLoad) Log(" VertexBuffers num: %d typenum: %d\n",cacheMesh.mlVtxNum, cacheMesh.mlVtxArrayNum);
+
+			for(int i=0; i< cacheMesh.mlVtxArrayNum; ++i)
 			{
-				int lVtxNum = binBuff.GetInt32();
-				int lVtxTypeNum = binBuff.GetInt32();
+				const cMapCacheVtxArray &vtxArray = pVtxArrays[cacheMesh.mlFirstVtxArray + i];
 
-				if(gbLogCacheLoad) Log(" VertexBuffers num: %d typenum: %d\n",lVtxNum, lVtxTypeNum);
+				eVertexBufferElement arrayType = (eVertexBufferElement)vtxArray.mlType;
+				eVertexBufferElementFormat elementFormat = (eVertexBufferElementFormat)vtxArray.mlFormat;
 
-				////////////////////
-				// Get vertex arrays
-				for(int i=0; i< lVtxTypeNum; ++i)
-				{
-					//Get the settings
-					eVertexBufferElement arrayType = (eVertexBufferElement)binBuff.GetShort16();
-					eVertexBufferElementFormat elementFormat = (eVertexBufferElementFormat)binBuff.GetShort16();
-					int lProgramVarIndex = binBuff.GetInt32();
-					int lElementNum = binBuff.GetInt32();
-					int lCompressionType = binBuff.GetInt32();
-
-					if(gbLogCacheLoad) Log("   Vtx %d: %d %d %d\n", i, arrayType, lProgramVarIndex, lElementNum);
-
-					//Create the array
-					pVtxBuff->CreateElementArray(arrayType, elementFormat, lElementNum, lProgramVarIndex);
-					pVtxBuff->ResizeArray(arrayType, lVtxNum * lElementNum);
-
-					/////////////////////////
-					//Uncompressed: Get and fill the array data
-					if(lCompressionType ==0)
-					{
-						void *pData = GetVertexBufferWithFormat(pVtxBuff, arrayType, elementFormat);
-						GetBinaryBufferDataWithFormat(&binBuff, pData, (size_t)(lVtxNum * lElementNum), elementFormat);
-					}
-					/////////////////////////
-					// Compressed Get Data
-					else
-					{
-						float *pDestData = pVtxBuff->GetFloatArray(arrayType);
-						int lElemCount = lVtxNum * lElementNum;
-
-						//////////////////////
-						// Byte Array
-						if(lCompressionType <= 2)
-						{
-							///////////////
-							//0 - 255 -> 0-1
-							if(lCompressionType == 1)
-							{
-								while(lElemCount > 0)
-								{
-									*pDestData = mpBytePosFloatTable[binBuff.GetUnsignedChar()];
-
-									++pDestData; --lElemCount;
-								}
-							}
-							///////////////
-							//-127 - 127 -> -1 - 1
-							else
-							{
-								while(lElemCount > 0)
-								{
-									*pDestData = mpByteNegPosFloatTable[binBuff.GetUnsignedChar()];
-
-									++pDestData; --lElemCount;
-								}
-							}
-						}
-						//////////////////////
-						// Short Array
-						else
-						{
-							while(lElemCount > 0)
-							{
-								*pDestData = mpShortNegPosFloatTable[binBuff.GetUnsignedShort16()];
-
-								++pDestData; --lElemCount;
-							}
-						}
-					}
-				}
+				if(gbLogCacheLoad) Log("   Vtx %d: %d %d %d\n", i, arrayType, vtxArray.mlProgramVarIndex, vtxArray.mlElementNum);
+
+				pVtxBuff->CreateElementArray(arrayType, elementFormat, vtxArray.mlElementNum, vtxArray.mlProgramVarIndex);
+				pVtxBuff->ResizeArray(arrayType, cacheMesh.mlVtxNum * vtxArray.mlElementNum);
+
+				void *pData = GetVertexBufferWithFormat(pVtxBuff, arrayType, elementFormat);
+				if(pData && vtxArray.mlDataSize > 0) memcpy(pData, pBlobs + vtxArray.mlDataOffset, (size_t)vtxArray.mlDataSize);
 			}
 
 			////////////////////
 			//Get Indices
-			{
-				int lIdxNum =  binBuff.GetInt32();
+			if(gbLogCacheLoad) Log("Indices: %d\n", cacheMesh.mlIdxNum);
 
-				if(gbLogCacheLoad) Log("Indices: %d\n", lIdxNum);
-
-				pVtxBuff->ResizeIndices(lIdxNum);
-				binBuff.GetInt32Array((int*)pVtxBuff->GetIndices(), lIdxNum);
-			}
+			pVtxBuff->ResizeIndices(cacheMesh.mlIdxNum);
+			if(cacheMesh.mlIdxNum > 0)
+				memcpy(pVtxBuff->GetIndices(), pBlobs + cacheMesh.mlIdxOffset, sizeof(unsigned int) * cacheMesh.mlIdxNum);
 
 			///////////////////
 			//Compile vertex buffer and set to sub mesh
@@ -680,10 +880,12 @@ namespace hpl {
 
 			///////////////////
 			//Create mesh entity
-            cMeshEntity *pMeshEntity = mpCurrentWorld->CreateMeshEntity(sName, pMesh, true);
-			pMeshEntity->SetRenderFlagBit(eRenderableFlag_ShadowCaster, bCastShadows);
+			cMeshEntity *pMeshEntity = mpCurrentWorld->CreateMeshEntity(sName, pMesh, true);
+			pMeshEntity->SetRenderFlagBit(eRenderableFlag_ShadowCaster, cacheMesh.mlCastShadows != 0);
+			pMeshEntity->SetRenderFlagBit(eRenderableFlag_Occluder, MaterialIsOccluder(pSubMesh->GetMaterial()));
 		}
 
+		cPlatform::UnmapFile(pFileData, lFileSize);
 
 		////////////////////////////////////////
 		// Done loading
@@ -702,64 +904,69 @@ namespace hpl {
 
 		Log("Saving cache file for '%s'\n", cString::To8Char(asFile).c_str());
 
-        size_t iNewtonTotal = 0;
+		size_t iNewtonTotal = 0;
 		tWString sCacheFile = cString::SetFileExtW(asFile, msCacheFileExt);
-		cBinaryBuffer binBuff(sCacheFile);
 
-		////////////////////////////////////////
-		// Header
-		binBuff.AddInt32(MAP_CACHE_FORMAT_MAGIC_NUMBER);
-		binBuff.AddInt32(MAP_CACHE_FORMAT_VERSION);
-
-		////////////////////////////////////////
-		// General Data
-		binBuff.AddInt32((int)mlstStaticMeshBodies.size());
-		binBuff.AddInt32((int)mlstStaticShapeBodies.size());
-		binBuff.AddInt32((int)mlstStaticMeshEntities.size());
+		cMapCacheWriter writer;
+		std::vector<cMapCacheMeshBody> vMeshBodies;
+		std::vector<cMapCacheShapeBody> vShapeBodies;
+		std::vector<cMapCacheShape> vShapes;
+		std::vector<cMapCacheMesh> vMeshes;
+		std::vector<cMapCacheVtxArray> vVtxArrays;
 
 		////////////////////////////////////////
 		// Iterate Mesh Bodies
 		for(tPhysicsBodyListIt it = mlstStaticMeshBodies.begin(); it != mlstStaticMeshBodies.end(); ++it)
 		{
-            size_t iNewtonStart;
 			iPhysicsBody *pBody = *it;
 
-			binBuff.AddString(pBody->GetName());
-			binBuff.AddString(pBody->GetMaterial() ? pBody->GetMaterial()->GetName() : "");
-			binBuff.AddBool(pBody->GetBlocksLight());
-			binBuff.AddBool(pBody->GetCollide()==false); //If it is a character collider
+			cMapCacheMeshBody meshBody;
+			meshBody.mlName = writer.AddString(pBody->GetName());
+			meshBody.mlMaterial = writer.AddString(pBody->GetMaterial() ? pBody->GetMaterial()->GetName() : "");
+			meshBody.mlBlocksLight = pBody->GetBlocksLight() ? 1 : 0;
+			meshBody.mlCharCollider = pBody->GetCollide() ? 0 : 1;
+
+			cBinaryBuffer shapeBuff;
+			mpCurrentPhysicsWorld->SaveMeshShapeToBuffer(pBody->GetShape(), &shapeBuff);
+			meshBody.mlShapeOffset = writer.AddBlob(shapeBuff.GetDataPointer(), shapeBuff.GetSize());
+			meshBody.mlShapeSize = (int)shapeBuff.GetSize();
 
-            // Marker for size of newton blob
-            //binBuff.AddInt32(0);
-			iNewtonStart = binBuff.GetPos();
-			mpCurrentPhysicsWorld->SaveMeshShapeToBuffer(pBody->GetShape(), &binBuff);
-            //binBuff.SetInt32(binBuff.GetPos()-iNewtonStart, iNewtonStart-4);
-            iNewtonTotal += binBuff.GetPos()-iNewtonStart;
-            if (gbLog) Log("Newton: %d, %d\n", iNewtonStart, binBuff.GetPos()-iNewtonStart);
+			iNewtonTotal += shapeBuff.GetSize();
+			if (gbLog) Log("Newton: %d, %d\n", meshBody.mlShapeOffset, meshBody.mlShapeSize);
+
+			vMeshBodies.push_back(meshBody);
 		}
-        if (gbLog) Log("Newton Total: %d\n",iNewtonTotal);
+		if (gbLog) Log("Newton Total: %d\n",iNewtonTotal);
 
 		////////////////////////////////////////
-		// Iterate Mesh Bodies
+		// Iterate Shape Bodies
 		for(tHplMapShapeBodyListIt it = mlstStaticShapeBodies.begin(); it != mlstStaticShapeBodies.end(); ++it)
 		{
 			cHplMapShapeBody *pShapeBody = *it;
 
-			binBuff.AddString(pShapeBody->msMaterial);
-			binBuff.AddMatrixf(pShapeBody->m_mtxTransform);
-			binBuff.AddBool(pShapeBody->mbCharCollider);
-			binBuff.AddBool(pShapeBody->mbBlocksLight);
+			cMapCacheShapeBody shapeBody;
+			shapeBody.mlMaterial = writer.AddString(pShapeBody->msMaterial);
+			shapeBody.mlCharCollider = pShapeBody->mbCharCollider ? 1 : 0;
+			shapeBody.mlBlocksLight = pShapeBody->mbBlocksLight ? 1 : 0;
+			shapeBody.mlFirstShape = (int)vShapes.size();
+			shapeBody.mlShapeNum = (int)pShapeBody->mvColliders.size();
+			memcpy(shapeBody.mfTransform, pShapeBody->m_mtxTransform.v, sizeof(float)*16);
 
-			binBuff.AddInt32(pShapeBody->mvColliders.size());
-
-			for(int i=0; i<pShapeBody->mvColliders.size(); ++i)
+			for(size_t i=0; i<pShapeBody->mvColliders.size(); ++i)
 			{
 				cHplMapShape *pShape = pShapeBody->mvColliders[i];
 
-				binBuff.AddInt32(pShape->mType);
-				binBuff.AddVector3f(pShape->mvSize);
-				binBuff.AddMatrixf(pShape->m_mtxOffset);
+				cMapCacheShape shape;
+				shape.mlType = pShape->mType;
+				shape.mfSize[0] = pShape->mvSize.x;
+				shape.mfSize[1] = pShape->mvSize.y;
+				shape.mfSize[2] = pShape->mvSize.z;
+				memcpy(shape.mfOffset, pShape->m_mtxOffset.v, sizeof(float)*16);
+
+				vShapes.push_back(shape);
 			}
+
+			vShapeBodies.push_back(shapeBody);
 		}
 
 		////////////////////////////////////////
@@ -773,111 +980,78 @@ namespace hpl {
 			cSubMesh *pSubMesh = pSubEnt->GetSubMesh();
 			iVertexBuffer *pVtxBuff = pSubMesh->GetVertexBuffer();
 
-			////////////////////////////
-			//Add variables
-			binBuff.AddString(pEntity->GetName());
-			binBuff.AddString(pSubMesh->GetMaterialName());
-			binBuff.AddBool(pSubEnt->GetRenderFlagBit(eRenderableFlag_ShadowCaster));
-
+			cMapCacheMesh mesh;
+			mesh.mlName = writer.AddString(pEntity->GetName());
+			mesh.mlMaterial = writer.AddString(pSubMesh->GetMaterialName());
+			mesh.mlCastShadows = pSubEnt->GetRenderFlagBit(eRenderableFlag_ShadowCaster) ? 1 : 0;
+			mesh.mlVtxNum = pVtxBuff->GetVertexNum();
+			mesh.mlFirstVtxArray = (int)vVtxArrays.size();
 
 			////////////////////////////
 			//Add Vertices
+			for(int i=0; i < eVertexBufferElement_LastEnum;i++)
 			{
-				int lVtxNum =  pVtxBuff->GetVertexNum();
-				binBuff.AddInt32(lVtxNum);
+				eVertexBufferElement arrayType = (eVertexBufferElement)i;
 
-				//////////////////////////////
-				// Calculate the number of vertex buffer types
-				int lVtxTypeNum =  0;
-				for(int i=0; i < eVertexBufferElement_LastEnum;i++)
-				{
-					eVertexBufferElement arrayType = (eVertexBufferElement)i;
+				int lElementNum = pVtxBuff->GetElementNum(arrayType);
+				if(lElementNum <= 0) continue;
 
-					if(pVtxBuff->GetElementNum((eVertexBufferElement)i) > 0) ++lVtxTypeNum;
-				}
-				binBuff.AddInt32(lVtxTypeNum);
+				eVertexBufferElementFormat elementFormat = pVtxBuff->GetElementFormat(arrayType);
+				size_t lDataSize = (size_t)(mesh.mlVtxNum * lElementNum) * GetVertexFormatSize(elementFormat);
 
-				//////////////////////////////
-				// Iterate the Vertices
-				for(int i=0; i < eVertexBufferElement_LastEnum;i++)
-				{
-					eVertexBufferElement arrayType = (eVertexBufferElement)i;
+				cMapCacheVtxArray vtxArray;
+				vtxArray.mlType = arrayType;
+				vtxArray.mlFormat = elementFormat;
+				vtxArray.mlProgramVarIndex = pVtxBuff->GetElementProgramVarIndex(arrayType);
+				vtxArray.mlElementNum = lElementNum;
+				vtxArray.mlDataOffset = writer.AddBlob(GetVertexBufferWithFormat(pVtxBuff, arrayType, elementFormat), lDataSize);
+				vtxArray.mlDataSize = (int)lDataSize;
+
+				vVtxArrays.push_back(vtxArray);
+			}
+			mesh.mlVtxArrayNum = (int)vVtxArrays.size() - mesh.mlFirstVtxArray;
 
-					if(pVtxBuff->GetElementNum(arrayType) <= 0) continue;
+			////////////////////////////
+			//Add Indices
+			mesh.mlIdxNum = pVtxBuff->GetIndexNum();
+			mesh.mlIdxOffset = writer.AddBlob(pVtxBuff->GetIndices(), sizeof(unsigned int) * mesh.mlIdxNum);
 
-					int lElementNum = pVtxBuff->GetElementNum(arrayType);
-					eVertexBufferElementFormat elementFormat = pVtxBuff->GetElementFormat(arrayType);
+			vMeshes.push_back(mesh);
+		}
 
-					binBuff.AddShort16(arrayType);
-					binBuff.AddShort16(elementFormat);
-					binBuff.AddInt32(pVtxBuff->GetElementProgramVarIndex(arrayType));
-					binBuff.AddInt32(lElementNum);
+		//Make sure there is at least one string so the table always ends with a 0.
+		writer.AddString("");
 
-					////////////////////////////////////
-					//Determine compression type
-					 //0=none, 1= 0-1->byte, 2= -1-1->byte 3=-1-1->short
-					int lCompressionType =0;
-					if(arrayType == eVertexBufferElement_Color0)
-						lCompressionType = 1;
-					if(arrayType == eVertexBufferElement_Normal || arrayType == eVertexBufferElement_Texture1Tangent)
-						lCompressionType = 2;
+		////////////////////////////////////////
+		// Write the sections, the header is written first as a placeholder and then filled in.
+		cBinaryBuffer binBuff(sCacheFile);
 
-					binBuff.AddInt32(lCompressionType);
+		cMapCacheHeader header;
+		memset(&header, 0, sizeof(header));
+		binBuff.AddCharArray((const char*)&header, sizeof(header));
 
-					////////////////////////////////////
-					//Add Uncompressed data
-					if(lCompressionType ==0)
-					{
-						void *pData = GetVertexBufferWithFormat(pVtxBuff, arrayType, elementFormat);
-						AddBinaryBufferDataWithFormat(&binBuff, pData, (size_t)(lVtxNum * lElementNum), elementFormat);
-					}
-					////////////////////////////////////
-					//Add Compressed data
-					else
-					{
-						float* pData = pVtxBuff->GetFloatArray(arrayType);
-						int lElementCount = lElementNum * lVtxNum;
-
-						while(lElementCount>0)
-						{
-							switch(lCompressionType)
-							{
-							case 1:
-								{
-									unsigned char lChar = (unsigned char)cMath::FastPositiveFloatToInt(*pData * 255.0f);
-									binBuff.AddUnsignedChar(lChar);
-									break;
-								}
-							case 2:
-								{
-									char lChar = (char)cMath::FastPosAndNegFloatToInt(*pData * 127.0f);
-									binBuff.AddChar(lChar);
-									break;
-								}
-							case 3:
-								{
-									short lX = (short)cMath::FastPosAndNegFloatToInt(*pData * 32767.0f);
-									binBuff.AddShort16(lX);
-									break;
-								}
-							}
-
-							++pData;
-							--lElementCount;
-						}
-					}
-				}
-			}
+		header.mlMagicNumber = MAP_CACHE_FORMAT_MAGIC_NUMBER;
+		header.mlVersion = MAP_CACHE_FORMAT_VERSION;
 
-			////////////////////////////
-			//Add Indices
-			{
-				int lIdxNum =  pVtxBuff->GetIndexNum();
+		header.mlStringTableOffset = AddMapCacheSection(&binBuff, writer.mvStrings);
+		header.mlStringTableSize = (int)writer.mvStrings.size();
 
-				binBuff.AddInt32(lIdxNum);
-				binBuff.AddInt32Array((int*)pVtxBuff->GetIndices(), lIdxNum);
-			}
-		}
+		header.mlMeshBodyOffset = AddMapCacheSection(&binBuff, vMeshBodies);
+		header.mlMeshBodyNum = (int)vMeshBodies.size();
+		header.mlShapeBodyOffset = AddMapCacheSection(&binBuff, vShapeBodies);
+		header.mlShapeBodyNum = (int)vShapeBodies.size();
+		header.mlShapeOffset = AddMapCacheSection(&binBuff, vShapes);
+		header.mlShapeNum = (int)vShapes.size();
+		header.mlMeshOffset = AddMapCacheSection(&binBuff, vMeshes);
+		header.mlMeshNum = (int)vMeshes.size();
+		header.mlVtxArrayOffset = AddMapCacheSection(&binBuff, vVtxArrays);
+		header.mlVtxArrayNum = (int)vVtxArrays.size();
+
+		header.mlBlobOffset = AddMapCacheSection(&binBuff, writer.mvBlobs);
+		header.mlBlobSize = (int)writer.mvBlobs.size();
+
+		header.mlFileSize = (int)binBuff.GetSize();
+		memcpy(binBuff.GetDataPointer(), &header, sizeof(header));
 
 		////////////////////////////////////////
 		// Save
@@ -950,6 +1124,32 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	void cWorldLoaderHplMap::PrefetchFiles(const tStringVec& avFiles)
+	{
+		cResourceStreamer *pStreamer = mpResources->GetResourceStreamer();
+		for(size_t i=0; i<avFiles.size(); ++i)
+		{
+			tWString sPath = mpResources->GetFileSearcher()->GetFilePath(avFiles[i]);
+			if(sPath == _W("")) continue;
+
+			mvPrefetchRequests.push_back(pStreamer->RequestPrefetch(sPath));
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cWorldLoaderHplMap::CancelPrefetches()
+	{
+		cResourceStreamer *pStreamer = mpResources->GetResourceStreamer();
+		for(size_t i=0; i<mvPrefetchRequests.size(); ++i)
+		{
+			pStreamer->CancelRequest(mvPrefetchRequests[i]);
+		}
+		mvPrefetchRequests.clear();
+	}
+
+	//-----------------------------------------------------------------------
+
 	void cWorldLoaderHplMap::LoadStaticObjects(cXmlElement* apXmlContents)
 	{
 		unsigned long lStartTime;
@@ -1059,14 +1259,16 @@ namespace hpl {
 		/////////////////////////////////
 		//Go through all leaves of the container, and combine objects found there.
 		lStartTime = cPlatform::GetApplicationTime();
-		IterateLeafNodesAndBuildMeshes(pTempContainer->GetRoot());
+		tHplMapCombineBatchVec vBatches;
+		IterateLeafNodesAndAddBatches(pTempContainer->GetRoot(), vBatches);
+		BuildCombineBatches(vBatches);
 		lDeltaTime = cPlatform::GetApplicationTime() - lStartTime;
 		if(gbLogTiming)
 		{
 			Log("    Combining: %d ms\n", lDeltaTime);
 			Log("     Sorting: %d ms\n", mlSortingTimeTotal);
-			Log("     Meshes: %d ms\n", mlCombineMeshTimeTotal);
-			Log("     Bodies: %d ms\n", mlCombineBodyTimeTotal);
+			Log("     Filling (%d threads): %d ms\n", cJobManager::GetGlobal() ? cJobManager::GetGlobal()->GetWorkerNum()+1 : 1, mlCombineFillTimeTotal);
+			Log("     Creating: %d ms\n", mlCombineCreateTimeTotal);
 		}
 
 		/////////////////////////////////
@@ -1125,7 +1327,7 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
-	void cWorldLoaderHplMap::IterateLeafNodesAndBuildMeshes(iRenderableContainerNode *apNode)
+	void cWorldLoaderHplMap::IterateLeafNodesAndAddBatches(iRenderableContainerNode *apNode, tHplMapCombineBatchVec &avBatches)
 	{
 		////////////////////////
 		//Iterate children
@@ -1135,7 +1337,7 @@ namespace hpl {
 			for(; childIt != apNode->GetChildNodeList()->end(); ++childIt)
 			{
 				iRenderableContainerNode *pChildNode = *childIt;
-				IterateLeafNodesAndBuildMeshes(pChildNode);
+				IterateLeafNodesAndAddBatches(pChildNode, avBatches);
 			}
 		}
 
@@ -1143,13 +1345,22 @@ namespace hpl {
 		//Iterate objects
 		if(apNode->HasObjects())
 		{
-			CombineAndCreateMeshesAndPhysics(apNode->GetObjectList());
+			AddCombineBatches(apNode->GetObjectList(), avBatches);
 		}
 	}
 
 	//-----------------------------------------------------------------------
 
 	void cWorldLoaderHplMap::CombineAndCreateMeshesAndPhysics(tRenderableList *apObjectList)
+	{
+		tHplMapCombineBatchVec vBatches;
+		AddCombineBatches(apObjectList, vBatches);
+		BuildCombineBatches(vBatches);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cWorldLoaderHplMap::AddCombineBatches(tRenderableList *apObjectList, tHplMapCombineBatchVec &avBatches)
 	{
 		unsigned long lStartTime;
 		lStartTime = cPlatform::GetApplicationTime();
@@ -1209,12 +1420,9 @@ namespace hpl {
 		std::sort(vMeshObjects.begin(), vMeshObjects.end(), SortStaticSubMeshesForMeshes);
 		std::sort(vPhysicsObjects.begin(), vPhysicsObjects.end(), SortStaticSubMeshesForBodies);
 
-		mlSortingTimeTotal += cPlatform::GetApplicationTime() - lStartTime;
-
 		////////////////////
-		// Create Meshes
-		//  Iterate and combine when a found of combinable objects are found
-		lStartTime = cPlatform::GetApplicationTime();
+		// Mesh batches
+		//  Iterate and add a batch when a sequence of combinable objects is found
 		if(gbLog) Log(" Check for mesh combination sequences!\n");
 
 		int lFirstInSequence = 0; //Index of first object to be combined.
@@ -1243,7 +1451,7 @@ namespace hpl {
 					pNextObject->GetRenderFlagBit(eRenderableFlag_ShadowCaster) != pMeshObject->GetRenderFlagBit(eRenderableFlag_ShadowCaster) ||
 					pNextObjectUserData->mbCombine == false)
 				{
-					CombineObjectsAndCreateMeshEntity(vMeshObjects, lFirstInSequence, (int) i);
+					AddMeshCombineBatch(vMeshObjects, lFirstInSequence, (int) i, avBatches);
 					lFirstInSequence = (int)i+1;
 				}
 			}
@@ -1251,58 +1459,58 @@ namespace hpl {
 			//If last just combine all left.
 			else
 			{
-				CombineObjectsAndCreateMeshEntity(vMeshObjects, lFirstInSequence, (int)i);
+				AddMeshCombineBatch(vMeshObjects, lFirstInSequence, (int)i, avBatches);
 			}
 		}
-		mlCombineMeshTimeTotal += cPlatform::GetApplicationTime() - lStartTime;
 
 		////////////////////
-		// Create Physics Bodies
-		//  Iterate physics, combine and create!
-		if(bCreateBodies==false) return;
-
-		const int lIndexCountLimit = 50000;
-		int lIndexCount =0;
-		lStartTime = cPlatform::GetApplicationTime();
-		if(gbLog) Log(" Check for body combination sequences!\n");
-		lFirstInSequence = 0;
-		for(size_t i=0; i< vPhysicsObjects.size(); ++i)
+		// Physics batches
+		//  Iterate physics and add a batch for each sequence
+		if(bCreateBodies)
 		{
-			cHplMapPhysicsObject& physicsObject = vPhysicsObjects[i];
-
-			if(physicsObject.mpUserData->mbCollides)
-				lIndexCount += physicsObject.mpObject->GetVertexBuffer()->GetIndexNum();
+			const int lIndexCountLimit = 50000;
+			int lIndexCount =0;
+			if(gbLog) Log(" Check for body combination sequences!\n");
+			lFirstInSequence = 0;
+			for(size_t i=0; i< vPhysicsObjects.size(); ++i)
+			{
+				cHplMapPhysicsObject& physicsObject = vPhysicsObjects[i];
 
-			if(gbLog) Log("  %d Checking '%s', physics material: %d\n",i,physicsObject.mpObject->GetName().c_str(),
-				physicsObject.mpPhysicsMaterial);
+				if(physicsObject.mpUserData->mbCollides)
+					lIndexCount += physicsObject.mpObject->GetVertexBuffer()->GetIndexNum();
 
-			////////////////////////
-			//Check so this is not the last element in array
-			if(i < vMeshObjects.size()-1)
-			{
-				cHplMapPhysicsObject& nextObject = vPhysicsObjects[i+1];
+				if(gbLog) Log("  %d Checking '%s', physics material: %d\n",i,physicsObject.mpObject->GetName().c_str(),
+					physicsObject.mpPhysicsMaterial);
 
-				///////////////////////////////
-				//Check if next object is not part of sequence, if so combine current sequence.
-				//Also check if max number of polys are now reached, if so compile too!
-				if(	lIndexCount > lIndexCountLimit ||
-					nextObject.mbCharCollider != physicsObject.mbCharCollider ||
-					nextObject.mpPhysicsMaterial != physicsObject.mpPhysicsMaterial ||
-					nextObject.mpObject->GetRenderFlagBit(eRenderableFlag_ShadowCaster) != physicsObject.mpObject->GetRenderFlagBit(eRenderableFlag_ShadowCaster))
+				////////////////////////
+				//Check so this is not the last element in array
+				if(i < vMeshObjects.size()-1)
 				{
-					CombineObjectsAndCreatePhysics(vPhysicsObjects, lFirstInSequence, (int) i);
-					lFirstInSequence = (int)i+1;
-					lIndexCount = 0;
+					cHplMapPhysicsObject& nextObject = vPhysicsObjects[i+1];
+
+					///////////////////////////////
+					//Check if next object is not part of sequence, if so combine current sequence.
+					//Also check if max number of polys are now reached, if so compile too!
+					if(	lIndexCount > lIndexCountLimit ||
+						nextObject.mbCharCollider != physicsObject.mbCharCollider ||
+						nextObject.mpPhysicsMaterial != physicsObject.mpPhysicsMaterial ||
+						nextObject.mpObject->GetRenderFlagBit(eRenderableFlag_ShadowCaster) != physicsObject.mpObject->GetRenderFlagBit(eRenderableFlag_ShadowCaster))
+					{
+						AddPhysicsCombineBatch(vPhysicsObjects, lFirstInSequence, (int) i, avBatches);
+						lFirstInSequence = (int)i+1;
+						lIndexCount = 0;
+					}
+				}
+				////////////////////////
+				//If last just combine all left.
+				else
+				{
+					AddPhysicsCombineBatch(vPhysicsObjects, lFirstInSequence, (int)i, avBatches);
 				}
-			}
-			////////////////////////
-			//If last just combine all left.
-			else
-			{
-				CombineObjectsAndCreatePhysics(vPhysicsObjects, lFirstInSequence, (int)i);
 			}
 		}
-		mlCombineBodyTimeTotal += cPlatform::GetApplicationTime() - lStartTime;
+
+		mlSortingTimeTotal += cPlatform::GetApplicationTime() - lStartTime;
 	}
 
 	//-----------------------------------------------------------------------
@@ -1313,15 +1521,33 @@ namespace hpl {
 		int mlElementNum;
 	};
 
-	void cWorldLoaderHplMap::CombineObjectsAndCreateMeshEntity(tRenderableVec &avObjects, int alFirstIdx, int alLastIdx)
+	//Arrays in combined meshes (skipping extra texture coords!)
+	static const int glCombinedMeshArrayNum = 5;
+	static const cVertexDataArray gvCombinedMeshArrays[glCombinedMeshArrayNum] =
+	{
+		{eVertexBufferElement_Position, 4},
+		{eVertexBufferElement_Normal, 3},
+		{eVertexBufferElement_Color0, 4},
+		{eVertexBufferElement_Texture0, 3},
+		{eVertexBufferElement_Texture1Tangent, 4}
+	};
+
+	//-----------------------------------------------------------------------
+
+	void cWorldLoaderHplMap::AddMeshCombineBatch(tRenderableVec &avObjects, int alFirstIdx, int alLastIdx, tHplMapCombineBatchVec &avBatches)
 	{
 		if(gbLog) Log("  Combining objects %d -> %d\n", alFirstIdx, alLastIdx);
 
+		cHplMapCombineBatch *pBatch = hplNew( cHplMapCombineBatch, () );
+		pBatch->mbBody = false;
+		pBatch->mpFirstObject = static_cast<cSubMeshEntity*>(avObjects[alFirstIdx]);
+		pBatch->mpPhysicsMaterial = NULL;
+		pBatch->mbCharCollider = false;
+
 		///////////////////////////////////////////
 		//Iterate objects to get the total amount of vertex data
 		int lTotalVtxAmount =0;
 		int lTotalIdxAmount =0;
-		tString sName = "CombinedObjects"+cString::ToString(mlCombinedMeshNameCount);
 		for(int i=alFirstIdx; i<=alLastIdx; ++i)
 		{
 			//Check if the sub mesh is visible, else skip
@@ -1334,6 +1560,10 @@ namespace hpl {
 			lTotalVtxAmount += pVtxBuffer->GetVertexNum();
 			lTotalIdxAmount += pVtxBuffer->GetIndexNum();
 
+			//The world matrix is updated when fetched, so it must be done here and not in the workers.
+			pBatch->mvSrcBuffers.push_back(pVtxBuffer);
+			pBatch->mvSrcMatrices.push_back(avObjects[i]->GetWorldMatrix());
+
 			if(gbLog) Log("   '%s' has %d vtx and %d idx\n",avObjects[i]->GetName().c_str(),pVtxBuffer->GetVertexNum(),pVtxBuffer->GetIndexNum());
 		}
 		if(gbLog) Log("   Total amount %d vtx and %d idx\n",lTotalVtxAmount, lTotalIdxAmount);
@@ -1342,95 +1572,222 @@ namespace hpl {
 		//If no vertices, return and skip creation
 		if(lTotalVtxAmount<=0 || lTotalIdxAmount <=0)
 		{
+			hplDelete(pBatch);
 			return;
 		}
 
-		//Increase the name count
-		mlCombinedMeshNameCount++;
-
 		///////////////////////////////////////////
-		//Create the vertex buffer (skipping color!)
-		iVertexBuffer *pVtxBuffer = mpGraphics->GetLowLevel()->CreateVertexBuffer(eVertexBufferType_Hardware, eVertexBufferDrawType_Tri,
-																					eVertexBufferUsageType_Static,lTotalVtxAmount, lTotalIdxAmount);
+		//Create the vertex buffer, the data is filled in by the workers.
+		pBatch->mpVtxBuffer = mpGraphics->GetLowLevel()->CreateVertexBuffer(eVertexBufferType_Hardware, eVertexBufferDrawType_Tri,
+																			eVertexBufferUsageType_Static,lTotalVtxAmount, lTotalIdxAmount);
+		for(int i=0;i<glCombinedMeshArrayNum; ++i)
+		{
+			pBatch->mpVtxBuffer->CreateElementArray(gvCombinedMeshArrays[i].mType,eVertexBufferElementFormat_Float, gvCombinedMeshArrays[i].mlElementNum);
+			pBatch->mpVtxBuffer->ResizeArray(gvCombinedMeshArrays[i].mType, lTotalVtxAmount * gvCombinedMeshArrays[i].mlElementNum);
+		}
+		pBatch->mpVtxBuffer->ResizeIndices(lTotalIdxAmount);
+
+		avBatches.push_back(pBatch);
+	}
 
-		//Set up what data arrays to use
-		const int lDataArrayNum = 5;
-		cVertexDataArray lDataArrayTypes[lDataArrayNum] =
+	//-----------------------------------------------------------------------
+
+	void cWorldLoaderHplMap::AddPhysicsCombineBatch(std::vector<cHplMapPhysicsObject> &avObjects, int alFirstIdx, int alLastIdx, tHplMapCombineBatchVec &avBatches)
+	{
+		if(gbLog) Log("  Combining objects %d -> %d\n", alFirstIdx, alLastIdx);
+		const int lMaxIndices= 30;
+
+		cHplMapCombineBatch *pBatch = hplNew( cHplMapCombineBatch, () );
+		pBatch->mbBody = true;
+		pBatch->mpFirstObject = avObjects[alFirstIdx].mpObject;
+		pBatch->mpPhysicsMaterial = avObjects[alFirstIdx].mpPhysicsMaterial;
+		pBatch->mbCharCollider = avObjects[alFirstIdx].mbCharCollider;
+
+		///////////////////////////////////////////
+		//Iterate objects to get the total amount of vertex data
+		int lTotalVtxAmount =0;
+		int lTotalIdxAmount =0;
+		for(int i=alFirstIdx; i<=alLastIdx; ++i)
 		{
-			{eVertexBufferElement_Position, 4},
-			{eVertexBufferElement_Normal, 3},
-			{eVertexBufferElement_Color0, 4},
-			{eVertexBufferElement_Texture0, 3},
-			{eVertexBufferElement_Texture1Tangent, 4}
-		};
-		float *pDataArray[lDataArrayNum];
+			if(avObjects[i].mpUserData->mbCollides==false) continue;
+
+			iVertexBuffer *pVtxBuffer = avObjects[i].mpObject->GetVertexBuffer();
+
+			//Do a special debug test and skip highpoly entities, loading the map faster.
+            if((mlCurrentFlags & eWorldLoadFlag_FastPhysicsLoad) && pVtxBuffer->GetIndexNum() > lMaxIndices)	continue;
+
+
+			lTotalVtxAmount += pVtxBuffer->GetVertexNum();
+			lTotalIdxAmount += pVtxBuffer->GetIndexNum();
+
+			pBatch->mvSrcBuffers.push_back(pVtxBuffer);
+			pBatch->mvSrcMatrices.push_back(avObjects[i].mpObject->GetWorldMatrix());
 
-		//Set up the data arrays
-		for(int i=0;i<lDataArrayNum; ++i)
+			if(gbLog) Log("   '%s' has %d vtx and %d idx\n",avObjects[i].mpObject->GetName().c_str(),pVtxBuffer->GetVertexNum(),pVtxBuffer->GetIndexNum());
+		}
+		if(gbLog) Log("   Total amount %d vtx and %d idx\n",lTotalVtxAmount, lTotalIdxAmount);
+
+		///////////////////////////////////////////
+		//If no vertex buffers, then just exit
+		if(lTotalVtxAmount<=0 || lTotalIdxAmount<=0)
 		{
-			pVtxBuffer->CreateElementArray(lDataArrayTypes[i].mType,eVertexBufferElementFormat_Float, lDataArrayTypes[i].mlElementNum);
-			pVtxBuffer->ResizeArray(lDataArrayTypes[i].mType, lTotalVtxAmount * lDataArrayTypes[i].mlElementNum);
-			pDataArray[i] = pVtxBuffer->GetFloatArray(lDataArrayTypes[i].mType);
+			hplDelete(pBatch);
+			return;
 		}
 
-		//Set up and get indices
-		pVtxBuffer->ResizeIndices(lTotalIdxAmount);
+		///////////////////////////////////////////
+		//Create the vertex buffer (only positions)
+		pBatch->mpVtxBuffer = mpGraphics->GetLowLevel()->CreateVertexBuffer(eVertexBufferType_Software, eVertexBufferDrawType_Tri,
+																			eVertexBufferUsageType_Dynamic,lTotalVtxAmount, lTotalIdxAmount);
+
+		pBatch->mpVtxBuffer->CreateElementArray(eVertexBufferElement_Position,eVertexBufferElementFormat_Float, 4);
+		pBatch->mpVtxBuffer->ResizeArray(eVertexBufferElement_Position, lTotalVtxAmount * 4);
+		pBatch->mpVtxBuffer->ResizeIndices(lTotalIdxAmount);
+
+		avBatches.push_back(pBatch);
+	}
+
+	//-----------------------------------------------------------------------
+
+	/**
+	 * Copies the source buffers of a batch into its vertex buffer and transforms them. Only touches the batch
+	 * and reads the source buffers, so different batches can be filled at the same time. The math is the same as
+	 * in iVertexBuffer::Transform so the result is the same as when copying and transforming each buffer.
+	 */
+	static void FillCombineBatch(cHplMapCombineBatch *apBatch)
+	{
+		iVertexBuffer *pVtxBuffer = apBatch->mpVtxBuffer;
+		int lArrayNum = apBatch->mbBody ? 1 : glCombinedMeshArrayNum;
+
+		float *pDataArray[glCombinedMeshArrayNum];
+		for(int i=0; i<lArrayNum; ++i)
+		{
+			pDataArray[i] = pVtxBuffer->GetFloatArray(gvCombinedMeshArrays[i].mType);
+		}
 		unsigned int* pIndexArray = pVtxBuffer->GetIndices();
 
-		///////////////////////////////////////////
-		//Fill vertex buffer with data
 		int lIdxOffset =0;
-		for(int vtxbuffer=alFirstIdx; vtxbuffer<=alLastIdx; ++vtxbuffer)
+		for(size_t buffer=0; buffer<apBatch->mvSrcBuffers.size(); ++buffer)
 		{
-			//Check if the sub mesh is visible, else skip
-			cHplMapStaticUserData*pUserData = (cHplMapStaticUserData*)static_cast<cSubMeshEntity*>(avObjects[vtxbuffer])->GetUserData();
-			if(pUserData->mbVisible==false) continue;
-
-			iRenderable *pObject = avObjects[vtxbuffer];
+			iVertexBuffer *pSrcBuffer = apBatch->mvSrcBuffers[buffer];
+			const cMatrixf &mtxTransform = apBatch->mvSrcMatrices[buffer];
+			int lVtxNum = pSrcBuffer->GetVertexNum();
 
-			if(gbLog) Log("   Copying data from '%s'\n", pObject->GetName().c_str());
-
-			/////////////////////////////////////
-			// Create a copy of the vertex buffer and transform it according to object
-			iVertexBuffer *pSubVtxBuffer = pObject->GetVertexBuffer();
-			iVertexBuffer *pTransformedVtxBuffer = pSubVtxBuffer->CreateCopy(	eVertexBufferType_Software, eVertexBufferUsageType_Static,
-																				pSubVtxBuffer->GetVertexElementFlags());
-			pTransformedVtxBuffer->Transform(pObject->GetWorldMatrix());
+			//////////////////////////////////////////////////
+			//Copy to each data array
+			for(int i=0; i<lArrayNum; ++i)
+			{
+				memcpy(pDataArray[i], pSrcBuffer->GetFloatArray(gvCombinedMeshArrays[i].mType),
+						lVtxNum * gvCombinedMeshArrays[i].mlElementNum * sizeof(float));
+			}
 
 			//////////////////////////////////////////////////
-			//Copy to each data array and increase the data pointer
-            for(int i=0; i<lDataArrayNum;++i)
+			//Transform the copied data
+			cMatrixf mtxRot = mtxTransform.GetRotation();
+			cMatrixf mtxNormalRot = cMath::MatrixInverse(mtxRot).GetTranspose();
+
+			float *pPos = pDataArray[0];
+			float *pNorm = apBatch->mbBody ? NULL : pDataArray[1];
+			float *pTan = apBatch->mbBody ? NULL : pDataArray[4];
+			for(int vtx=0; vtx<lVtxNum; ++vtx)
 			{
-				int lAmount = lDataArrayTypes[i].mlElementNum * pTransformedVtxBuffer->GetVertexNum();
-				if(gbLog) Log("    copy from data %d: %d elements\n", i, lAmount);
+				cVector3f vPos = cMath::MatrixMul(mtxTransform, cVector3f(pPos[0],pPos[1],pPos[2]));
+				pPos[0] = vPos.x; pPos[1] = vPos.y; pPos[2] = vPos.z;
+				pPos += 4;
 
-				memcpy(pDataArray[i], pTransformedVtxBuffer->GetFloatArray(lDataArrayTypes[i].mType), lAmount * sizeof(float));
+				if(pNorm)
+				{
+					cVector3f vNorm = cMath::MatrixMul3x3(mtxNormalRot, cVector3f(pNorm[0],pNorm[1],pNorm[2]));
+					vNorm.Normalize();
+					pNorm[0] = vNorm.x; pNorm[1] = vNorm.y; pNorm[2] = vNorm.z;
+					pNorm += 3;
+
+					cVector3f vTan = cMath::MatrixMul3x3(mtxRot, cVector3f(pTan[0],pTan[1],pTan[2]));
+					vTan.Normalize();
+					pTan[0] = vTan.x; pTan[1] = vTan.y; pTan[2] = vTan.z;
+					pTan += 4;
+				}
+			}
 
-				pDataArray[i] += lAmount;
+			for(int i=0; i<lArrayNum; ++i)
+			{
+				pDataArray[i] += lVtxNum * gvCombinedMeshArrays[i].mlElementNum;
 			}
 
 			//////////////////////////////////////////////
 			//Copy to index array (using offset from previous max) and increase index pointer and offset
-			unsigned int* pTransIdxArray = pTransformedVtxBuffer->GetIndices();
-			for(int i=0; i<pTransformedVtxBuffer->GetIndexNum(); ++i)
+			unsigned int* pSrcIdxArray = pSrcBuffer->GetIndices();
+			int lIdxNum = pSrcBuffer->GetIndexNum();
+			for(int i=0; i<lIdxNum; ++i)
 			{
-				pIndexArray[i] = pTransIdxArray[i] + lIdxOffset;
+				pIndexArray[i] = pSrcIdxArray[i] + lIdxOffset;
 			}
 
-			lIdxOffset += pTransformedVtxBuffer->GetVertexNum();
-			pIndexArray += pTransformedVtxBuffer->GetIndexNum();
+			lIdxOffset += lVtxNum;
+			pIndexArray += lIdxNum;
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	static void FillCombineBatchesJob(void *apData, int alStart, int alEnd)
+	{
+		tHplMapCombineBatchVec *pBatches = (tHplMapCombineBatchVec*)apData;
+		for(int i=alStart; i<alEnd; ++i)
+		{
+			FillCombineBatch((*pBatches)[i]);
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cWorldLoaderHplMap::BuildCombineBatches(tHplMapCombineBatchVec &avBatches)
+	{
+		if(avBatches.empty()) return;
+
+		unsigned long lStartTime;
+
+		////////////////////
+		// Fill the vertex buffers, one batch per job. The buffers are already created so the jobs do not allocate.
+		lStartTime = cPlatform::GetApplicationTime();
+		cJobManager *pJobManager = cJobManager::GetGlobal();
+		if(pJobManager)
+			pJobManager->ParallelFor(0, (int)avBatches.size(), 1, FillCombineBatchesJob, &avBatches);
+		else
+			FillCombineBatchesJob(&avBatches, 0, (int)avBatches.size());
+		mlCombineFillTimeTotal += cPlatform::GetApplicationTime() - lStartTime;
+
+		////////////////////
+		// Create meshes and bodies in the order the batches were added, so names and cache are the same each time.
+		lStartTime = cPlatform::GetApplicationTime();
+		for(size_t i=0; i<avBatches.size(); ++i)
+		{
+			cHplMapCombineBatch *pBatch = avBatches[i];
 
-			hplDelete(pTransformedVtxBuffer);
+			if(pBatch->mbBody)	CreatePhysicsFromBatch(pBatch);
+			else				CreateMeshEntityFromBatch(pBatch);
+
+			hplDelete(pBatch);
 		}
+		avBatches.clear();
+		mlCombineCreateTimeTotal += cPlatform::GetApplicationTime() - lStartTime;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cWorldLoaderHplMap::CreateMeshEntityFromBatch(cHplMapCombineBatch *apBatch)
+	{
+		tString sName = "CombinedObjects"+cString::ToString(mlCombinedMeshNameCount);
+		mlCombinedMeshNameCount++;
 
 		///////////////////////
 		// All meshes batched into one buffer, compile it.
+		iVertexBuffer *pVtxBuffer = apBatch->mpVtxBuffer;
 		pVtxBuffer->Compile(0);
 
 		///////////////////////////////////////////
 		//Create the mesh
-		iRenderable *pFirstObject = avObjects[alFirstIdx];
-		cSubMeshEntity *pFirstSubEnt = static_cast<cSubMeshEntity*>(pFirstObject);
+		cSubMeshEntity *pFirstSubEnt = apBatch->mpFirstObject;
 		cMesh *pMesh = hplNew( cMesh, (sName, _W("") ,mpResources->GetMaterialManager(),mpResources->GetAnimationManager()) );
 
 		cSubMesh *pSubMesh = pMesh->CreateSubMesh("SubMesh");
@@ -1439,7 +1796,7 @@ namespace hpl {
 		pSubMesh->SetVertexBuffer(pVtxBuffer);
 
 		//Set material
-		cMaterial *pMaterial = pFirstObject->GetMaterial();
+		cMaterial *pMaterial = pFirstSubEnt->GetMaterial();
 		if(pMaterial)
 		{
 			pMaterial->IncUserCount();
@@ -1455,7 +1812,8 @@ namespace hpl {
 		cMeshEntity *pMeshEntity = mpCurrentWorld->CreateMeshEntity(sName,pMesh, true);
 
 		//Set up variables
-		pMeshEntity->SetRenderFlagBit(eRenderableFlag_ShadowCaster, pFirstObject->GetRenderFlagBit(eRenderableFlag_ShadowCaster));
+		pMeshEntity->SetRenderFlagBit(eRenderableFlag_ShadowCaster, pFirstSubEnt->GetRenderFlagBit(eRenderableFlag_ShadowCaster));
+		pMeshEntity->SetRenderFlagBit(eRenderableFlag_Occluder, MaterialIsOccluder(pMaterial));
 
 		//Add to list
 		mlstStaticMeshEntities.push_back(pMeshEntity);
@@ -1464,124 +1822,32 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
-	void cWorldLoaderHplMap::CombineObjectsAndCreatePhysics(std::vector<cHplMapPhysicsObject> &avObjects, int alFirstIdx, int alLastIdx)
+	void cWorldLoaderHplMap::CreatePhysicsFromBatch(cHplMapCombineBatch *apBatch)
 	{
-		if(gbLog) Log("  Combining objects %d -> %d\n", alFirstIdx, alLastIdx);
-		const int lMaxIndices= 30;
-
-		///////////////////////////////////////////
-		//Iterate objects to get the total amount of vertex data
-		int lTotalVtxAmount =0;
-		int lTotalIdxAmount =0;
 		tString sName = "CombinedObjects"+cString::ToString(mlCombinedBodyNameCount);
-		for(int i=alFirstIdx; i<=alLastIdx; ++i)
-		{
-			if(avObjects[i].mpUserData->mbCollides==false) continue;
-
-			iVertexBuffer *pVtxBuffer = avObjects[i].mpObject->GetVertexBuffer();
-
-			//Do a special debug test and skip highpoly entities, loading the map faster.
-            if((mlCurrentFlags & eWorldLoadFlag_FastPhysicsLoad) && pVtxBuffer->GetIndexNum() > lMaxIndices)	continue;
-
-
-			lTotalVtxAmount += pVtxBuffer->GetVertexNum();
-			lTotalIdxAmount += pVtxBuffer->GetIndexNum();
-
-			if(gbLog) Log("   '%s' has %d vtx and %d idx\n",avObjects[i].mpObject->GetName().c_str(),pVtxBuffer->GetVertexNum(),pVtxBuffer->GetIndexNum());
-		}
-		if(gbLog) Log("   Total amount %d vtx and %d idx\n",lTotalVtxAmount, lTotalIdxAmount);
-
-		///////////////////////////////////////////
-		//If no vertex buffers, then just exit
-		if(lTotalVtxAmount<=0 || lTotalIdxAmount<=0)
-		{
-			return;
-		}
 		mlCombinedBodyNameCount++;
 
-
-		///////////////////////////////////////////
-		//Create the vertex buffer (skipping color!)
-		iVertexBuffer *pVtxBuffer = mpGraphics->GetLowLevel()->CreateVertexBuffer(	eVertexBufferType_Software, eVertexBufferDrawType_Tri,
-																					eVertexBufferUsageType_Dynamic,lTotalVtxAmount, lTotalIdxAmount);
-
-		pVtxBuffer->CreateElementArray(eVertexBufferElement_Position,eVertexBufferElementFormat_Float, 4);
-		pVtxBuffer->ResizeArray(eVertexBufferElement_Position, lTotalVtxAmount * 4);
-		float *pDataArray = pVtxBuffer->GetFloatArray(eVertexBufferElement_Position);
-
-		//Set up and get indices
-		pVtxBuffer->ResizeIndices(lTotalIdxAmount);
-		unsigned int* pIndexArray = pVtxBuffer->GetIndices();
-
-		///////////////////////////////////////////
-		//Fill vertex buffer with data
-		int lIdxOffset =0;
-		for(int vtxbuffer=alFirstIdx; vtxbuffer<=alLastIdx; ++vtxbuffer)
-		{
-			if(avObjects[vtxbuffer].mpUserData->mbCollides==false) continue;
-
-			cSubMeshEntity *pObject = avObjects[vtxbuffer].mpObject;
-
-			////////////////////////////
-			//Add colliders if any
-			cSubMesh *pSubMesh =  avObjects[vtxbuffer].mpObject->GetSubMesh();
-
-			//Do a special debug test and skip highpoly entities, loading the map faster.
-			if((mlCurrentFlags & eWorldLoadFlag_FastPhysicsLoad) && pSubMesh->GetVertexBuffer()->GetIndexNum() > lMaxIndices) continue;
-
-			if(gbLog) Log("   Copying position data from '%s'\n", pObject->GetName().c_str());
-
-			////////////////////////
-			//Get vertex copy and transform
-			iVertexBuffer *pSubVtxBuffer = pObject->GetVertexBuffer();
-			iVertexBuffer *pTransformedVtxBuffer = pSubVtxBuffer->CreateCopy(	eVertexBufferType_Software, eVertexBufferUsageType_Static,
-																				eVertexElementFlag_Position);
-			pTransformedVtxBuffer->Transform(pObject->GetWorldMatrix());
-
-			////////////////////////
-			//Copy the data
-			int lAmount = pTransformedVtxBuffer->GetVertexNum() * 4;
-
-			if(gbLog) Log("    Amount: %d\n", lAmount);
-
-			memcpy(pDataArray, pTransformedVtxBuffer->GetFloatArray(eVertexBufferElement_Position), lAmount * sizeof(float));
-			pDataArray += lAmount;
-
-			//Copy to index array and increase index pointer
-			unsigned int* pTransIdxArray = pTransformedVtxBuffer->GetIndices();
-			for(int i=0; i<pTransformedVtxBuffer->GetIndexNum(); ++i)
-			{
-				pIndexArray[i] = pTransIdxArray[i] + lIdxOffset;
-			}
-
-			lIdxOffset += pTransformedVtxBuffer->GetVertexNum();
-			pIndexArray += pTransformedVtxBuffer->GetIndexNum();
-
-			hplDelete(pTransformedVtxBuffer);
-		}
-
+		iVertexBuffer *pVtxBuffer = apBatch->mpVtxBuffer;
 		pVtxBuffer->Compile(0);
 
-
 		///////////////////////////////////////////
 		//Create the mesh physics body
-		iRenderable *pFirstObject = avObjects[alFirstIdx].mpObject;
-
+		//The collision tree is built here and not in the workers since Newton does not allow shapes to be created from several threads.
 		iCollideShape *pShape = mpCurrentPhysicsWorld->CreateMeshShape(pVtxBuffer);
 		hplDelete(pVtxBuffer);
 
 		iPhysicsBody *pBody = mpCurrentPhysicsWorld->CreateBody(sName,pShape);
 		pBody->SetMass(0);
 
-		bool bCastShadows = pFirstObject->GetRenderFlagBit(eRenderableFlag_ShadowCaster);
+		bool bCastShadows = apBatch->mpFirstObject->GetRenderFlagBit(eRenderableFlag_ShadowCaster);
 		pBody->SetBlocksLight(bCastShadows);
 
-		pBody->SetCollide(!avObjects[alFirstIdx].mbCharCollider);
+		pBody->SetCollide(!apBatch->mbCharCollider);
 
 		mlstStaticMeshBodies.push_back(pBody);
 		mlStaticMeshBodiesCreated++;
 
-		if(avObjects[alFirstIdx].mpPhysicsMaterial) pBody->SetMaterial(avObjects[alFirstIdx].mpPhysicsMaterial);
+		if(apBatch->mpPhysicsMaterial) pBody->SetMaterial(apBatch->mpPhysicsMaterial);
 	}
 
 
@@ -0,0 +1,461 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "resources/XmlCache.h"
+
+#include "resources/XmlDocument.h"
+#include "resources/BinaryBuffer.h"
+#include "resources/Resources.h"
+
+#include "system/LowLevelSystem.h"
+#include "system/Platform.h"
+#include "system/String.h"
+
+#include <string.h>
+
+namespace hpl {
+
+	//////////////////////////////////////////////////////////////////////////
+	// CACHE FORMAT
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	/*
+	 * The whole file is read into the document and used in place. It starts with a header that has the keys of the source
+	 * file and the offset (in bytes from the start of the file) and size of each section. All sections start at an aligned offset:
+	 *  - String table: zero terminated element names and attribute values.
+	 *  - Names: string table offsets of the attribute names, attributes refer to these with an index.
+	 *  - Elements: depth first, each element is followed by its children.
+	 *  - Attributes: the attributes of an element are stored after each other.
+	 * Data is stored in native byte order.
+	 */
+
+	#define kXmlCacheAlignment 8
+
+	class cXmlCacheHeader
+	{
+	public:
+		unsigned int mlMagicNumber;
+		int mlVersion;
+		int mlFileSize;
+
+		int mlSourceSize;
+		int mvSourceDate[6];
+		unsigned int mlSourceHash;
+
+		int mlStringTableOffset;
+		int mlStringTableSize;
+		int mlNameOffset;
+		int mlNameNum;
+		int mlElementOffset;
+		int mlElementNum;
+		int mlAttributeOffset;
+		int mlAttributeNum;
+	};
+
+	class cXmlCacheElement
+	{
+	public:
+		int mlName;
+		int mlFirstAttribute;
+		int mlAttributeNum;
+		int mlChildNum;
+	};
+
+	class cXmlCacheAttribute
+	{
+	public:
+		int mlName;
+		int mlValue;
+	};
+
+	//-----------------------------------------------------------------------
+
+	static int AlignXmlCacheOffset(size_t alOffset)
+	{
+		return (int)((alOffset + kXmlCacheAlignment-1) & ~((size_t)kXmlCacheAlignment-1));
+	}
+
+	//-----------------------------------------------------------------------
+
+	template<class T>
+	static int AddXmlCacheSection(cBinaryBuffer *apBuffer, const std::vector<T>& avData)
+	{
+		static const char vPadding[kXmlCacheAlignment] = {0};
+
+		int lOffset = AlignXmlCacheOffset(apBuffer->GetSize());
+		apBuffer->AddCharArray(vPadding, lOffset - apBuffer->GetSize());
+		if(avData.empty()==false) apBuffer->AddCharArray((const char*)&avData[0], avData.size() * sizeof(T));
+
+		return lOffset;
+	}
+
+	//-----------------------------------------------------------------------
+
+	static bool XmlCacheSectionIsValid(const cXmlCacheHeader *apHeader, int alOffset, int alNum, size_t alElementSize)
+	{
+		if(alOffset < 0 || alNum < 0 || (alOffset % kXmlCacheAlignment) != 0) return false;
+		return (size_t)alOffset + (size_t)alNum * alElementSize <= (size_t)apHeader->mlFileSize;
+	}
+
+	static bool XmlCacheStringIsValid(const cXmlCacheHeader *apHeader, int alOffset)
+	{
+		return alOffset >= 0 && alOffset < apHeader->mlStringTableSize;
+	}
+
+	//-----------------------------------------------------------------------
+
+	static void GetXmlCacheDate(const cDate& aDate, int *apDest)
+	{
+		apDest[0] = aDate.seconds;
+		apDest[1] = aDate.minutes;
+		apDest[2] = aDate.hours;
+		apDest[3] = aDate.month_day;
+		apDest[4] = aDate.month;
+		apDest[5] = aDate.year;
+	}
+
+	//-----------------------------------------------------------------------
+
+	static bool GetXmlCacheSourceHash(const tWString& asFile, unsigned int *apHash)
+	{
+		FILE *pFile = cPlatform::OpenFile(asFile, _W("rb"));
+		if(pFile==NULL) return false;
+
+		//FNV-1a
+		unsigned int lHash = 2166136261u;
+		unsigned char vBuffer[4096];
+		size_t lCount;
+		while((lCount = fread(vBuffer, 1, sizeof(vBuffer), pFile)) > 0)
+		{
+			for(size_t i=0; i<lCount; ++i)
+			{
+				lHash ^= vBuffer[i];
+				lHash *= 16777619u;
+			}
+		}
+		fclose(pFile);
+
+		*apHash = lHash;
+		return true;
+	}
+
+	//-----------------------------------------------------------------------
+
+	/**
+	 * Builds the sections when saving.
+	 */
+	class cXmlCacheWriter
+	{
+	public:
+		int AddString(const char *apString)
+		{
+			std::map<tString, int>::iterator it = m_mapStringOffsets.find(apString);
+			if(it != m_mapStringOffsets.end()) return it->second;
+
+			int lOffset = (int)mvStrings.size();
+			mvStrings.insert(mvStrings.end(), apString, apString + strlen(apString)+1);
+			m_mapStringOffsets.insert(std::map<tString, int>::value_type(apString, lOffset));
+			return lOffset;
+		}
+
+		//Names are interned by the document, so the pointer can be used as key
+		int AddName(const char *apName)
+		{
+			std::map<const char*, int>::iterator it = m_mapNameIndices.find(apName);
+			if(it != m_mapNameIndices.end()) return it->second;
+
+			int lIdx = (int)mvNames.size();
+			mvNames.push_back(AddString(apName));
+			m_mapNameIndices.insert(std::map<const char*, int>::value_type(apName, lIdx));
+			return lIdx;
+		}
+
+		void AddElement(cXmlElement *apElement)
+		{
+			tXmlAttributeVec *pAttributes = apElement->GetAttributes();
+
+			size_t lElementIdx = mvElements.size();
+			mvElements.push_back(cXmlCacheElement());
+			mvElements[lElementIdx].mlName = AddString(apElement->GetValue().c_str());
+			mvElements[lElementIdx].mlFirstAttribute = (int)mvAttributes.size();
+			mvElements[lElementIdx].mlAttributeNum = (int)pAttributes->size();
+			mvElements[lElementIdx].mlChildNum = 0;
+
+			for(tXmlAttributeVecIt it = pAttributes->begin(); it != pAttributes->end(); ++it)
+			{
+				cXmlCacheAttribute attribute;
+				attribute.mlName = AddName(it->mpName);
+				attribute.mlValue = AddString(it->mpValue);
+				mvAttributes.push_back(attribute);
+			}
+
+			int lChildNum = 0;
+			cXmlNodeListIterator it = apElement->GetChildIterator();
+			while(it.HasNext())
+			{
+				cXmlElement *pChild = it.Next()->ToElement();
+				if(pChild==NULL) continue;
+
+				AddElement(pChild);
+				++lChildNum;
+			}
+			mvElements[lElementIdx].mlChildNum = lChildNum;
+		}
+
+		std::vector<char> mvStrings;
+		std::vector<int> mvNames;
+		std::vector<cXmlCacheElement> mvElements;
+		std::vector<cXmlCacheAttribute> mvAttributes;
+
+	private:
+		std::map<tString, int> m_mapStringOffsets;
+		std::map<const char*, int> m_mapNameIndices;
+	};
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// PUBLIC METHODS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	tWString cXmlCache::GetCacheFile(const tWString& asFile)
+	{
+		return asFile + _W("_cache");
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool cXmlCache::Load(iXmlDocument *apDoc, const tWString& asFile)
+	{
+#if (defined(__PPC__) || defined(__ppc__))
+		return false;
+#endif
+		tWString sCacheFile = GetCacheFile(asFile);
+
+		FILE *pFile = cPlatform::OpenFile(sCacheFile, _W("rb"));
+		if(pFile==NULL) return false;
+
+		fseek(pFile, 0, SEEK_END);
+		long lFileSize = ftell(pFile);
+		fseek(pFile, 0, SEEK_SET);
+
+		////////////////////////////////////////
+		// Header
+		cXmlCacheHeader header;
+		if(	lFileSize < (long)sizeof(cXmlCacheHeader) || fread(&header, sizeof(cXmlCacheHeader), 1, pFile) != 1 ||
+			header.mlMagicNumber != XML_CACHE_FORMAT_MAGIC_NUMBER || header.mlVersion != XML_CACHE_FORMAT_VERSION ||
+			header.mlFileSize != lFileSize)
+		{
+			fclose(pFile);
+			return false;
+		}
+
+		////////////////////////////////////////
+		// Check that the source has not changed. If only the date differs (eg the file has been copied) the contents are compared.
+		bool bUpdateHeader = false;
+		if(cResources::GetForceCacheLoadingAndSkipSaving()==false)
+		{
+			int vSourceDate[6];
+			GetXmlCacheDate(cPlatform::FileModifiedDate(asFile), vSourceDate);
+			int lSourceSize = (int)cPlatform::GetFileSize(asFile);
+
+			if(lSourceSize != header.mlSourceSize || memcmp(vSourceDate, header.mvSourceDate, sizeof(vSourceDate))!=0)
+			{
+				unsigned int lSourceHash = 0;
+				if(	lSourceSize != header.mlSourceSize ||
+					GetXmlCacheSourceHash(asFile, &lSourceHash)==false || lSourceHash != header.mlSourceHash)
+				{
+					fclose(pFile);
+					return false;
+				}
+
+				memcpy(header.mvSourceDate, vSourceDate, sizeof(vSourceDate));
+				bUpdateHeader = true;
+			}
+		}
+
+		////////////////////////////////////////
+		// Read the file into the document
+		apDoc->ClearData();
+		cXmlStringPool *pPool = apDoc->GetStringPool();
+
+		char *pData = pPool->Allocate(lFileSize, kXmlCacheAlignment);
+		fseek(pFile, 0, SEEK_SET);
+		bool bRead = fread(pData, 1, lFileSize, pFile) == (size_t)lFileSize;
+		fclose(pFile);
+
+		//Check that all sections are inside the file
+		if(	bRead==false ||
+			XmlCacheSectionIsValid(&header, header.mlStringTableOffset, header.mlStringTableSize, 1)==false ||
+			XmlCacheSectionIsValid(&header, header.mlNameOffset, header.mlNameNum, sizeof(int))==false ||
+			XmlCacheSectionIsValid(&header, header.mlElementOffset, header.mlElementNum, sizeof(cXmlCacheElement))==false ||
+			XmlCacheSectionIsValid(&header, header.mlAttributeOffset, header.mlAttributeNum, sizeof(cXmlCacheAttribute))==false ||
+			header.mlStringTableSize <= 0 || pData[header.mlStringTableOffset + header.mlStringTableSize-1] != 0 ||
+			header.mlElementNum <= 0)
+		{
+			Error("File '%s' has a broken XML cache section table!\n", cString::To8Char(sCacheFile).c_str());
+			apDoc->ClearData();
+			return false;
+		}
+
+		const char *pStrings = pData + header.mlStringTableOffset;
+		const int *pNames = (const int*)(pData + header.mlNameOffset);
+		const cXmlCacheElement *pElements = (const cXmlCacheElement*)(pData + header.mlElementOffset);
+		const cXmlCacheAttribute *pAttributes = (const cXmlCacheAttribute*)(pData + header.mlAttributeOffset);
+
+		////////////////////////////////////////
+		// Intern the names so that they can be compared by pointer, same as when parsed
+		bool bBroken = false;
+		std::vector<const char*> vNames(header.mlNameNum);
+		for(int i=0; i<header.mlNameNum && bBroken==false; ++i)
+		{
+			if(XmlCacheStringIsValid(&header, pNames[i])==false)	bBroken = true;
+			else												vNames[i] = pPool->AddName(pStrings + pNames[i]);
+		}
+
+		////////////////////////////////////////
+		// Create the elements, the first is the document itself
+		std::vector<cXmlElement*> vParents;
+		std::vector<int> vChildrenLeft;
+		for(int i=0; i<header.mlElementNum && bBroken==false; ++i)
+		{
+			const cXmlCacheElement& cacheElement = pElements[i];
+			if(	XmlCacheStringIsValid(&header, cacheElement.mlName)==false || cacheElement.mlChildNum < 0 ||
+				cacheElement.mlFirstAttribute < 0 || cacheElement.mlAttributeNum < 0 ||
+				cacheElement.mlFirstAttribute + cacheElement.mlAttributeNum > header.mlAttributeNum)
+			{
+				bBroken = true;
+				break;
+			}
+
+			cXmlElement *pElement = apDoc;
+			if(i > 0)
+			{
+				while(vChildrenLeft.empty()==false && vChildrenLeft.back()==0)
+				{
+					vParents.pop_back();
+					vChildrenLeft.pop_back();
+				}
+				if(vParents.empty())
+				{
+					bBroken = true;
+					break;
+				}
+
+				--vChildrenLeft.back();
+				pElement = vParents.back()->CreateChildElement();
+			}
+
+			pElement->SetValue(pStrings + cacheElement.mlName);
+
+			pElement->mvAttributes.resize(cacheElement.mlAttributeNum);
+			for(int j=0; j<cacheElement.mlAttributeNum; ++j)
+			{
+				const cXmlCacheAttribute& cacheAttribute = pAttributes[cacheElement.mlFirstAttribute + j];
+				if(	cacheAttribute.mlName < 0 || cacheAttribute.mlName >= header.mlNameNum ||
+					XmlCacheStringIsValid(&header, cacheAttribute.mlValue)==false)
+				{
+					bBroken = true;
+					break;
+				}
+
+				pElement->mvAttributes[j].mpName = vNames[cacheAttribute.mlName];
+				pElement->mvAttributes[j].mpValue = pStrings + cacheAttribute.mlValue;
+			}
+
+			if(cacheElement.mlChildNum > 0)
+			{
+				vParents.push_back(pElement);
+				vChildrenLeft.push_back(cacheElement.mlChildNum);
+			}
+		}
+
+		if(bBroken)
+		{
+			Error("File '%s' has broken XML cache data!\n", cString::To8Char(sCacheFile).c_str());
+			apDoc->ClearData();
+			return false;
+		}
+
+		////////////////////////////////////////
+		// Save the new date so the contents do not need to be compared the next time
+		if(bUpdateHeader)
+		{
+			FILE *pUpdateFile = cPlatform::OpenFile(sCacheFile, _W("r+b"));
+			if(pUpdateFile)
+			{
+				fwrite(&header, sizeof(cXmlCacheHeader), 1, pUpdateFile);
+				fclose(pUpdateFile);
+			}
+		}
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool cXmlCache::Save(iXmlDocument *apDoc, const tWString& asFile)
+	{
+#if (defined(__PPC__) || defined(__ppc__))
+		return false;
+#endif
+		if(cResources::GetForceCacheLoadingAndSkipSaving()) return false;
+
+		cXmlCacheHeader header;
+		memset(&header, 0, sizeof(header));
+
+		////////////////////////////////////////
+		// Source keys
+		if(GetXmlCacheSourceHash(asFile, &header.mlSourceHash)==false) return false;
+		header.mlSourceSize = (int)cPlatform::GetFileSize(asFile);
+		GetXmlCacheDate(cPlatform::FileModifiedDate(asFile), header.mvSourceDate);
+
+		cXmlCacheWriter writer;
+		writer.AddElement(apDoc);
+
+		////////////////////////////////////////
+		// Write the sections, the header is written first as a placeholder and then filled in.
+		cBinaryBuffer binBuff(GetCacheFile(asFile));
+		binBuff.AddCharArray((const char*)&header, sizeof(header));
+
+		header.mlMagicNumber = XML_CACHE_FORMAT_MAGIC_NUMBER;
+		header.mlVersion = XML_CACHE_FORMAT_VERSION;
+
+		header.mlStringTableOffset = AddXmlCacheSection(&binBuff, writer.mvStrings);
+		header.mlStringTableSize = (int)writer.mvStrings.size();
+		header.mlNameOffset = AddXmlCacheSection(&binBuff, writer.mvNames);
+		header.mlNameNum = (int)writer.mvNames.size();
+		header.mlElementOffset = AddXmlCacheSection(&binBuff, writer.mvElements);
+		header.mlElementNum = (int)writer.mvElements.size();
+		header.mlAttributeOffset = AddXmlCacheSection(&binBuff, writer.mvAttributes);
+		header.mlAttributeNum = (int)writer.mvAttributes.size();
+
+		header.mlFileSize = (int)binBuff.GetSize();
+		memcpy(binBuff.GetDataPointer(), &header, sizeof(header));
+
+		return binBuff.Save();
+	}
+
+	//-----------------------------------------------------------------------
+
+}
@@ -19,11 +19,147 @@
 
 #include "resources/XmlDocument.h"
 
+#include "resources/XmlCache.h"
+
 #include "system/LowLevelSystem.h"
 #include "system/String.h"
 
 namespace hpl {
 
+	//////////////////////////////////////////////////////////////////////////
+	// STRING POOL
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	static const size_t glXmlStringBlockSize = 16 * 1024;
+
+	static unsigned int GetXmlNameHash(const char *apName, size_t alLength)
+	{
+		unsigned int lHash = 2166136261u;
+		for(size_t i=0; i<alLength; ++i)
+		{
+			lHash ^= (unsigned char)apName[i];
+			lHash *= 16777619u;
+		}
+		return lHash;
+	}
+
+	//-----------------------------------------------------------------------
+
+	cXmlStringPool::cXmlStringPool()
+	{
+		mpBlockData = NULL;
+		mlBlockPos = 0;
+		mlBlockSize = 0;
+
+		mlNameNum = 0;
+	}
+
+	cXmlStringPool::~cXmlStringPool()
+	{
+		Clear();
+	}
+
+	//-----------------------------------------------------------------------
+
+	char* cXmlStringPool::Allocate(size_t alSize, size_t alAlignment)
+	{
+		////////////////////////////
+		// Large allocations get a block of their own, so the current block can still be used.
+		if(alSize > glXmlStringBlockSize / 4)
+		{
+			char *pData = hplNewArray(char, alSize);
+			mvBlocks.push_back(pData);
+			return pData;
+		}
+
+		size_t lPos = (mlBlockPos + alAlignment-1) & ~(alAlignment-1);
+		if(mpBlockData==NULL || lPos + alSize > mlBlockSize)
+		{
+			mpBlockData = hplNewArray(char, glXmlStringBlockSize);
+			mvBlocks.push_back(mpBlockData);
+			lPos = 0;
+			mlBlockSize = glXmlStringBlockSize;
+		}
+
+		char *pData = mpBlockData + lPos;
+		mlBlockPos = lPos + alSize;
+
+		return pData;
+	}
+
+	//-----------------------------------------------------------------------
+
+	const char* cXmlStringPool::AddString(const char *apString, size_t alLength)
+	{
+		char *pData = Allocate(alLength+1);
+		memcpy(pData, apString, alLength);
+		pData[alLength] = 0;
+
+		return pData;
+	}
+
+	//-----------------------------------------------------------------------
+
+	const char* cXmlStringPool::AddName(const char *apName, size_t alLength)
+	{
+		if(mlNameNum*2 >= mvNameTable.size()) GrowNameTable();
+
+		size_t lMask = mvNameTable.size()-1;
+		size_t lPos = GetXmlNameHash(apName, alLength) & lMask;
+		while(mvNameTable[lPos])
+		{
+			const char *pName = mvNameTable[lPos];
+			if(strncmp(pName, apName, alLength)==0 && pName[alLength]==0) return pName;
+
+			lPos = (lPos+1) & lMask;
+		}
+
+		const char *pName = AddString(apName, alLength);
+		mvNameTable[lPos] = pName;
+		++mlNameNum;
+
+		return pName;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cXmlStringPool::Clear()
+	{
+		for(size_t i=0; i<mvBlocks.size(); ++i) hplDeleteArray(mvBlocks[i]);
+		mvBlocks.clear();
+		mpBlockData = NULL;
+		mlBlockPos = 0;
+		mlBlockSize = 0;
+
+		mvNameTable.clear();
+		mlNameNum = 0;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cXmlStringPool::GrowNameTable()
+	{
+		std::vector<const char*> vOldTable;
+		vOldTable.swap(mvNameTable);
+
+		mvNameTable.resize(vOldTable.empty() ? 64 : vOldTable.size()*2, NULL);
+
+		size_t lMask = mvNameTable.size()-1;
+		for(size_t i=0; i<vOldTable.size(); ++i)
+		{
+			const char *pName = vOldTable[i];
+			if(pName==NULL) continue;
+
+			size_t lPos = GetXmlNameHash(pName, strlen(pName)) & lMask;
+			while(mvNameTable[lPos]) lPos = (lPos+1) & lMask;
+			mvNameTable[lPos] = pName;
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
 	//////////////////////////////////////////////////////////////////////////
 	// NODE
 	//////////////////////////////////////////////////////////////////////////
@@ -143,20 +279,23 @@ namespace hpl {
 
 	cXmlElement::cXmlElement(const tString& asName, iXmlNode* apParent) : iXmlNode(eXmlNodeType_Element,apParent,asName)
 	{
+		mpStringPool = apParent ? apParent->ToElement()->GetStringPool() : NULL;
+		mbOwnsStringPool = false;
 	}
 
 	cXmlElement::~cXmlElement()
 	{
-
+		//Children only point to the pool and do not use it when destroyed
+		if(mbOwnsStringPool) hplDelete(mpStringPool);
 	}
 	//-----------------------------------------------------------------------
 
 	const char* cXmlElement::GetAttribute(const tString& asName)
 	{
-		tAttributeMapIt it = m_mapAttributes.find(asName);
-		if(it != m_mapAttributes.end())
+		const char *pName = asName.c_str();
+		for(size_t i=0; i<mvAttributes.size(); ++i)
 		{
-			return it->second.c_str();
+			if(strcmp(mvAttributes[i].mpName, pName)==0) return mvAttributes[i].mpValue;
 		}
 		return NULL;
 	}
@@ -206,15 +345,42 @@ namespace hpl {
 
 	void cXmlElement::SetAttribute(const tString& asName, const char* asVal)
 	{
-		tAttributeMapIt it = m_mapAttributes.find(asName);
-		if(it != m_mapAttributes.end())
-		{
-			it->second = asVal;
-		}
-		else
+		cXmlStringPool *pPool = GetStringPool();
+		size_t lSize = strlen(asVal)+1;
+
+		const char *pName = pPool->AddName(asName.c_str(), asName.size());
+		for(size_t i=0; i<mvAttributes.size(); ++i)
 		{
-			m_mapAttributes.insert(tAttributeMap::value_type(asName, asVal));
+			cXmlAttribute &attribute = mvAttributes[i];
+			if(attribute.mpName != pName) continue;
+
+			//////////////////////////
+			// Pool memory is only freed with the document, so values that are set over and over (like in the editors)
+			// are written over the old value when they fit. Else the size is at least doubled, so at most as much memory
+			// as the largest value is left unused.
+			if(lSize > attribute.mlValueSize)
+			{
+				attribute.mlValueSize = lSize > attribute.mlValueSize*2 ? lSize : attribute.mlValueSize*2;
+				char *pValue = pPool->Allocate(attribute.mlValueSize);
+				memcpy(pValue, asVal, lSize);
+				attribute.mpValue = pValue;
+			}
+			else
+			{
+				//Only values allocated here have a size, so this is not shared with anything
+				memmove(const_cast<char*>(attribute.mpValue), asVal, lSize);
+			}
+			return;
 		}
+
+		char *pValue = pPool->Allocate(lSize);
+		memcpy(pValue, asVal, lSize);
+
+		cXmlAttribute attribute;
+		attribute.mpName = pName;
+		attribute.mpValue = pValue;
+		attribute.mlValueSize = lSize;
+		mvAttributes.push_back(attribute);
 	}
 
 	//-----------------------------------------------------------------------
@@ -254,6 +420,26 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	void cXmlElement::DestroyAttributes()
+	{
+		mvAttributes.clear();
+	}
+
+	//-----------------------------------------------------------------------
+
+	cXmlStringPool* cXmlElement::GetStringPool()
+	{
+		//Elements not created by a document get a pool of their own
+		if(mpStringPool==NULL)
+		{
+			mpStringPool = hplNew(cXmlStringPool, ());
+			mbOwnsStringPool = true;
+		}
+		return mpStringPool;
+	}
+
+	//-----------------------------------------------------------------------
+
 
 	//////////////////////////////////////////////////////////////////////////
 	// CONSTRUCTORS
@@ -264,6 +450,9 @@ namespace hpl {
 	iXmlDocument::iXmlDocument(const tString& asName) : cXmlElement(asName, NULL)
 	{
 		msFile = _W("");
+
+		mpStringPool = hplNew(cXmlStringPool, ());
+		mbOwnsStringPool = true;
 	}
 
 	iXmlDocument::~iXmlDocument()
@@ -278,16 +467,22 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
-	bool iXmlDocument::CreateFromFile(const tWString& asPath)
+	bool iXmlDocument::CreateFromFile(const tWString& asPath, bool abUseCache)
 	{
+		msFile = asPath;
+
+		if(abUseCache && cXmlCache::Load(this, asPath)) return true;
+
 		bool bRet = LoadDataFromFile(asPath);
 		if(bRet==false)
 		{
 			Log("Failed parsing of XML document %s in line %d, column %d: %s\n", cString::To8Char(asPath).c_str(),
 																					mlErrorRow, mlErrorCol, msErrorDesc.c_str());
 		}
-
-		msFile = asPath;
+		else if(abUseCache)
+		{
+			cXmlCache::Save(this, asPath);
+		}
 
 		return bRet;
 	}
@@ -307,11 +502,17 @@ namespace hpl {
 	//-----------------------------------------------------------------------
 
 	//////////////////////////////////////////////////////////////////////////
-	// PRIVATE METHODS
+	// PROTECTED METHODS
 	//////////////////////////////////////////////////////////////////////////
 
 	//-----------------------------------------------------------------------
 
+	void iXmlDocument::ClearData()
+	{
+		DestroyChildren();
+		DestroyAttributes();
+		mpStringPool->Clear();
+	}
 
 	//-----------------------------------------------------------------------
 }
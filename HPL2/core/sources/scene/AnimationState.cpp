@@ -59,6 +59,9 @@ namespace hpl {
 		mfSpecialEventTime =0;
 
 		mfFadeStep=0;
+
+		mvTrackNodeIndices.resize(mpAnimation->GetTrackNum(), -1);
+		mvTrackKeyFrameCursors.resize(mpAnimation->GetTrackNum(), 0);
 	}
 
 	//-----------------------------------------------------------------------
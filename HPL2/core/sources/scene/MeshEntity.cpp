@@ -27,6 +27,7 @@
 #include "graphics/Material.h"
 #include "graphics/Mesh.h"
 #include "graphics/SubMesh.h"
+#include "graphics/Skinning.h"
 
 #include "resources/MeshLoaderHandler.h"
 #include "resources/FileSearcher.h"
@@ -87,6 +88,7 @@ namespace hpl {
 		mlBoneMatricesTransformCount = -1;
 
 		mbBoneMatricesNeedUpdate = true;
+		mbBoneMatricesFromPose = false;
 
 		mbStatic = false;
 
@@ -191,8 +193,12 @@ namespace hpl {
 				}
 			}
 
+			//Set up the pose arrays, with parents ordered before their children.
+			SetupBonePose();
+
 			//Create an array to fill with bone matrices
 			mvBoneMatrices.resize(pSkeleton->GetBoneNum());
+			cSkinning::SetupBoneColumns(&mvBoneMatrices[0], (int)mvBoneMatrices.size(), mvBoneColumns);
 
 			//////////////////////////////////
 			//Reset all bones states
@@ -251,6 +257,13 @@ namespace hpl {
 				AddChild(pSubEnt);
 			}
 		}
+
+		////////////////////////////////////////////////
+		// Bind animation tracks to bone or node states
+		for(size_t i=0; i<mvAnimationStates.size(); ++i)
+		{
+			BindAnimationState(mvAnimationStates[i]);
+		}
 	}
 
 	//-----------------------------------------------------------------------
@@ -401,6 +414,7 @@ namespace hpl {
 		}
 		/////////////////////////////////////////////
 		//Update animations and skeleton physics
+		bool bBonePoseUpdated = false;
 		if(mvAnimationStates.empty()==false || mbSkeletonPhysics)
 		{
 			////////////////////////
@@ -421,122 +435,119 @@ namespace hpl {
 				//If transform needs to be updated.
 				bool bUpdateTransform = false;
 
-				//////////
-				//Reset all bones states
-				if(	bAnimationActive || mbUpdatedBones == false ||
-					(mbSkeletonPhysics && !mbSkeletonPhysicsSleeping))
+				//////////////////////////////////
+				//Only animations, evaluate the pose in flat arrays
+				if(bAnimationActive && mbSkeletonPhysics==false)
 				{
-					for(size_t i=0;i < mvBoneStates.size(); i++)
+					UpdateBonePose(afTimeStep);
+					bUpdateTransform = true;
+					bBonePoseUpdated = true;
+				}
+				else
+				{
+					//////////
+					//Reset all bones states
+					if(	bAnimationActive || mbUpdatedBones == false ||
+						(mbSkeletonPhysics && !mbSkeletonPhysicsSleeping))
 					{
-						cNode3D *pState = mvBoneStates[i];
-						cBone* pBone = mpMesh->GetSkeleton()->GetBoneByIndex((int)i);
-
-						if(pState->IsActive())
+						for(size_t i=0;i < mvBoneStates.size(); i++)
 						{
-							pState->SetMatrix(pBone->GetLocalTransform(),false);
-						}
+							cNode3D *pState = mvBoneStates[i];
+							cBone* pBone = mpMesh->GetSkeleton()->GetBoneByIndex((int)i);
 
-						//can optimize this by doing it in the order of the tree
-						//and using recursive. (should be enough as is...)
-						if(mbSkeletonPhysics && mfSkeletonPhysicsWeight!=1.0f)
-						{
-							mvTempBoneStates[i]->SetMatrix(pBone->GetLocalTransform(),false);
+							if(pState->IsActive())
+							{
+								pState->SetMatrix(pBone->GetLocalTransform(),false);
+							}
+
+							//can optimize this by doing it in the order of the tree
+							//and using recursive. (should be enough as is...)
+							if(mbSkeletonPhysics && mfSkeletonPhysicsWeight!=1.0f)
+							{
+								mvTempBoneStates[i]->SetMatrix(pBone->GetLocalTransform(),false);
+							}
 						}
-					}
 
-					bUpdateTransform = true;
-				}
+						bUpdateTransform = true;
+					}
 
-				///////////////////////////
-				// Update skeleton physics
-				if(	mbSkeletonPhysics && (!mbSkeletonPhysicsSleeping || mbUpdatedBones==false))
-				{
-					mbUpdatedBones = true;
-					cNode3DIterator BoneIt = mpBoneStateRoot->GetChildIterator();
-					while(BoneIt.HasNext())
+					///////////////////////////
+					// Update skeleton physics
+					if(	mbSkeletonPhysics && (!mbSkeletonPhysicsSleeping || mbUpdatedBones==false))
 					{
-						cBoneState *pBoneState = static_cast<cBoneState*>(BoneIt.Next());
+						mbUpdatedBones = true;
+						cNode3DIterator BoneIt = mpBoneStateRoot->GetChildIterator();
+						while(BoneIt.HasNext())
+						{
+							cBoneState *pBoneState = static_cast<cBoneState*>(BoneIt.Next());
 	
-						SetBoneMatrixFromBodyRec(mpBoneStateRoot->GetWorldMatrix(),pBoneState);
-					}
+							SetBoneMatrixFromBodyRec(mpBoneStateRoot->GetWorldMatrix(),pBoneState);
+						}
 
-					//Interpolate matrices
-					if(mfSkeletonPhysicsWeight!=1.0f)
-					{
-						for(size_t i=0;i < mvBoneStates.size(); i++)
+						//Interpolate matrices
+						if(mfSkeletonPhysicsWeight!=1.0f)
 						{
-							cMatrixf mtxMixLocal = cMath::MatrixSlerp(	mfSkeletonPhysicsWeight,
-																		mvTempBoneStates[i]->GetLocalMatrix(),
-																		mvBoneStates[i]->GetLocalMatrix(),
-																		true);
+							for(size_t i=0;i < mvBoneStates.size(); i++)
+							{
+								cMatrixf mtxMixLocal = cMath::MatrixSlerp(	mfSkeletonPhysicsWeight,
+																			mvTempBoneStates[i]->GetLocalMatrix(),
+																			mvBoneStates[i]->GetLocalMatrix(),
+																			true);
 
-							mvBoneStates[i]->SetMatrix(mtxMixLocal, false);
+								mvBoneStates[i]->SetMatrix(mtxMixLocal, false);
+							}
 						}
 					}
-				}
 
-				//////////////////////////////////
-				//Go the weight mul (in case weights are normalized!)
-				float fAnimationWeightMul = GetAnimationWeightMul();
-
-				//////////////////////////////////
-				//Go through all animations states and update the bones
-				for(size_t i=0; i< mvAnimationStates.size(); i++)
-				{
-					cAnimationState *pAnimState = mvAnimationStates[i];
+					//////////////////////////////////
+					//Go the weight mul (in case weights are normalized!)
+					float fAnimationWeightMul = GetAnimationWeightMul();
 
-					if(pAnimState->IsActive())
+					//////////////////////////////////
+					//Go through all animations states and update the bones
+					for(size_t i=0; i< mvAnimationStates.size(); i++)
 					{
-						cAnimation *pAnim = pAnimState->GetAnimation();
+						cAnimationState *pAnimState = mvAnimationStates[i];
 
-						/////////////////////////////////////
-						//Go through all tracks in animation and apply to nodes
-						for(int i=0; i<pAnim->GetTrackNum(); i++)
+						if(pAnimState->IsActive())
 						{
-							cAnimationTrack *pTrack = pAnim->GetTrack(i);
+							cAnimation *pAnim = pAnimState->GetAnimation();
 
-							///////////////////////////////////
-							//If index not yet set, get it!
-							if(pTrack->GetNodeIndex()==-1)
+							/////////////////////////////////////
+							//Go through all tracks in animation and apply to nodes
+							for(int i=0; i<pAnim->GetTrackNum(); i++)
 							{
-								int lBoneIdx = mpMesh->GetSkeleton()->GetBoneIndexByName(pTrack->GetName());
-								if(lBoneIdx==-1)
+								cAnimationTrack *pTrack = pAnim->GetTrack(i);
+
+								cNode3D* pState = GetBoneState(pAnimState->GetTrackNodeIndex(i));
+
+								///////////////////////////////////
+								//Apply the animation track to node.
+								if(pState && pState->IsActive())
 								{
-									// XXX: This line is commented to avoid log clutter
-									//Error("Track '%s' in '%s' does not have a corresponding bone! Skeleton bone name mismatch?\n", pTrack->GetName().c_str(), mpMesh->GetName().c_str());
-									pTrack->SetNodeIndex(-2);
+									pTrack->ApplyToNode(pState,pAnimState->GetTimePosition(),pAnimState->GetWeight() * fAnimationWeightMul, pAnimState->IsLooping(),
+														pAnimState->GetTrackKeyFrameCursor(i));
 								}
-								else
-									pTrack->SetNodeIndex(lBoneIdx);
 							}
 
-							cNode3D* pState = GetBoneState(pTrack->GetNodeIndex());
 
-							///////////////////////////////////
-							//Apply the animation track to node.
-							if(pState && pState->IsActive())
-							{
-								pTrack->ApplyToNode(pState,pAnimState->GetTimePosition(),pAnimState->GetWeight() * fAnimationWeightMul, pAnimState->IsLooping());
-							}
+							pAnimState->Update(afTimeStep);
 						}
-
-
-						pAnimState->Update(afTimeStep);
 					}
-				}
 
-				//////////////////////////////////
-				//Go through all states and update the matrices (and thereby adding the animations together).
-				if(bAnimationActive)
-				{
-					cNode3DIterator NodeIt = mpBoneStateRoot->GetChildIterator();
-					while(NodeIt.HasNext())
+					//////////////////////////////////
+					//Go through all states and update the matrices (and thereby adding the animations together).
+					if(bAnimationActive)
 					{
-						cNode3D *pBoneState = static_cast<cNode3D*>(NodeIt.Next());
-						UpdateNodeMatrixRec(pBoneState);
-					}
+						cNode3DIterator NodeIt = mpBoneStateRoot->GetChildIterator();
+						while(NodeIt.HasNext())
+						{
+							cNode3D *pBoneState = static_cast<cNode3D*>(NodeIt.Next());
+							UpdateNodeMatrixRec(pBoneState);
+						}
 
-					//Entities are updated after BV is calculated, as the entity has the rootnode attached to it.
+						//Entities are updated after BV is calculated, as the entity has the rootnode attached to it.
+					}
 				}
 
 				////////////////////////////
@@ -610,14 +621,14 @@ namespace hpl {
 							{
 								cAnimationTrack *pTrack = pAnim->GetTrack(i);
 
-								if(pTrack->GetNodeIndex()<0)
-								{
-									pTrack->SetNodeIndex(GetNodeStateIndex(pTrack->GetName()));
-								}
-								cNode3D* pNodeState = GetNodeState(pTrack->GetNodeIndex());
+								int lNodeIdx = pAnimState->GetTrackNodeIndex(i);
+								if(lNodeIdx < 0) continue;
+
+								cNode3D* pNodeState = GetNodeState(lNodeIdx);
 
 								if(pNodeState->IsActive())
-									pTrack->ApplyToNode(pNodeState,pAnimState->GetTimePosition(),pAnimState->GetWeight() * fAnimationWeightMul);
+									pTrack->ApplyToNode(pNodeState,pAnimState->GetTimePosition(),pAnimState->GetWeight() * fAnimationWeightMul, true,
+														pAnimState->GetTrackKeyFrameCursor(i));
 							}
 
 							pAnimState->Update(afTimeStep);
@@ -691,7 +702,12 @@ namespace hpl {
 
 		/////////////////////////////////////////
 		/// Final things
-		if(mpMesh->GetSkeleton()) mbBoneMatricesNeedUpdate = true;
+		//The pose has the bone matrices already, unless the callback might have changed the bone states.
+		if(mpMesh->GetSkeleton())
+		{
+			mbBoneMatricesFromPose = bBonePoseUpdated && mpCallback==NULL;
+			mbBoneMatricesNeedUpdate = !mbBoneMatricesFromPose;
+		}
 	}
 
 	//-----------------------------------------------------------------------
@@ -708,6 +724,8 @@ namespace hpl {
 
 		pAnimState->SetBaseSpeed(afBaseSpeed);
 
+		BindAnimationState(pAnimState);
+
 		mvAnimationStates.push_back(pAnimState);
 
 		tAnimationStateIndexMap::value_type value(pAnimState->GetName(), (int)mvAnimationStates.size()-1);
@@ -1169,7 +1187,8 @@ namespace hpl {
 	void cMeshEntity::UpdateGraphicsForFrame(float afFrameTime)
 	{
 		//////////////////////////////////////////
-		//Check so update is needed
+		//Check so update is needed (bone matrices from the pose do not depend on the entity transform)
+		if(mbBoneMatricesFromPose) return;
 		if(	mbBoneMatricesNeedUpdate == false &&
 			mlBoneMatricesTransformCount == GetTransformUpdateCount())
 		{
@@ -1201,6 +1220,8 @@ namespace hpl {
 
 				mvBoneMatrices[i] = cMath::MatrixMul(mtxLocal,pBone->GetInvWorldTransform());
 			}
+
+			cSkinning::SetupBoneColumns(&mvBoneMatrices[0], (int)mvBoneMatrices.size(), mvBoneColumns);
 		}
 	}
 
@@ -1353,6 +1374,131 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	void cMeshEntity::BindAnimationState(cAnimationState *apAnimState)
+	{
+		cAnimation *pAnim = apAnimState->GetAnimation();
+		cSkeleton *pSkeleton = mpMesh->GetSkeleton();
+
+		for(int i=0; i<pAnim->GetTrackNum(); i++)
+		{
+			cAnimationTrack *pTrack = pAnim->GetTrack(i);
+
+			//Tracks without a corresponding bone or node are skipped when updating.
+			if(pSkeleton)	apAnimState->SetTrackNodeIndex(i, pSkeleton->GetBoneIndexByName(pTrack->GetName()));
+			else			apAnimState->SetTrackNodeIndex(i, GetNodeStateIndex(pTrack->GetName()));
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cMeshEntity::SetupBonePose()
+	{
+		const int lBoneNum = (int)mvBoneStates.size();
+
+		mvBonePoseRotations.resize(lBoneNum);
+		mvBonePoseTranslations.resize(lBoneNum);
+		mvBonePoseMatrices.resize(lBoneNum);
+
+		////////////////////////////////
+		//Get parent index and depth of each bone state
+		mvBoneParentIndices.resize(lBoneNum);
+		tIntVec vDepths(lBoneNum);
+		for(int i=0; i<lBoneNum; ++i)
+		{
+			cNode3D *pParent = mvBoneStates[i]->GetParent();
+			mvBoneParentIndices[i] = pParent==mpBoneStateRoot ? -1 : GetBoneStateIndex(pParent->GetName());
+
+			int lDepth=0;
+			for(int lIdx = mvBoneParentIndices[i]; lIdx>=0; lIdx = mvBoneParentIndices[lIdx]) ++lDepth;
+			vDepths[i] = lDepth;
+		}
+
+		////////////////////////////////
+		//Order by depth, so parents are always before their children.
+		mvBonePoseOrder.clear();
+		mvBonePoseOrder.reserve(lBoneNum);
+		for(int lDepth=0; (int)mvBonePoseOrder.size() < lBoneNum; ++lDepth)
+		{
+			for(int i=0; i<lBoneNum; ++i)
+			{
+				if(vDepths[i] == lDepth) mvBonePoseOrder.push_back(i);
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cMeshEntity::UpdateBonePose(float afTimeStep)
+	{
+		cSkeleton *pSkeleton = mpMesh->GetSkeleton();
+		const int lBoneNum = (int)mvBoneStates.size();
+
+		////////////////////////////////
+		//Reset the pose
+		for(int i=0; i<lBoneNum; ++i)
+		{
+			mvBonePoseRotations[i] = cQuaternion::Identity;
+			mvBonePoseTranslations[i] = cVector3f(0);
+		}
+
+		////////////////////////////////
+		//Blend all active animations into the pose
+		float fAnimationWeightMul = GetAnimationWeightMul();
+
+		for(size_t i=0; i< mvAnimationStates.size(); i++)
+		{
+			cAnimationState *pAnimState = mvAnimationStates[i];
+			if(pAnimState->IsActive()==false) continue;
+
+			cAnimation *pAnim = pAnimState->GetAnimation();
+			float fTime = pAnimState->GetTimePosition();
+			float fWeight = pAnimState->GetWeight() * fAnimationWeightMul;
+
+			for(int track=0; track<pAnim->GetTrackNum(); ++track)
+			{
+				int lBoneIdx = pAnimState->GetTrackNodeIndex(track);
+				if(lBoneIdx < 0) continue;
+
+				pAnim->GetTrack(track)->ApplyToPose(mvBonePoseRotations[lBoneIdx], mvBonePoseTranslations[lBoneIdx], fTime, fWeight,
+													pAnimState->GetTrackKeyFrameCursor(track));
+			}
+
+			pAnimState->Update(afTimeStep);
+		}
+
+		////////////////////////////////
+		//Calculate local and model space matrices, and the bone matrices from them.
+		//Bone states that are not active keep their matrix (they are set from elsewhere).
+		const cMatrixf& mtxRoot = mpBoneStateRoot->GetLocalMatrix();
+		for(int i=0; i<lBoneNum; ++i)
+		{
+			const int lBoneIdx = mvBonePoseOrder[i];
+			cBoneState *pState = mvBoneStates[lBoneIdx];
+			cBone *pBone = pSkeleton->GetBoneByIndex(lBoneIdx);
+
+			if(pState->IsActive())
+			{
+				//The animation rotation is applied before the local (same as cNode3D::UpdateMatrix)
+				cMatrixf mtxLocal = pBone->GetLocalTransform().GetRotation();
+				mtxLocal = cMath::MatrixMul(mtxLocal, cMath::MatrixQuaternion(mvBonePoseRotations[lBoneIdx]));
+				mtxLocal.SetTranslation(pBone->GetLocalTransform().GetTranslation() + mvBonePoseTranslations[lBoneIdx]);
+
+				pState->SetMatrix(mtxLocal, false);
+			}
+			pState->ApplyPreAnimTransform(false);
+			pState->ApplyPostAnimTransform(false);
+
+			const int lParentIdx = mvBoneParentIndices[lBoneIdx];
+			mvBonePoseMatrices[lBoneIdx] = cMath::MatrixMul(lParentIdx>=0 ? mvBonePoseMatrices[lParentIdx] : mtxRoot, pState->GetLocalMatrix());
+
+			mvBoneMatrices[lBoneIdx] = cMath::MatrixMul(mvBonePoseMatrices[lBoneIdx], pBone->GetInvWorldTransform());
+		}
+
+		cSkinning::SetupBoneColumns(&mvBoneMatrices[0], (int)mvBoneMatrices.size(), mvBoneColumns);
+	}
+
+	//-----------------------------------------------------------------------
+
 	void cMeshEntity::CreateNodes()
 	{
 		/////////////////////////////////
@@ -20,6 +20,7 @@
 #include "scene/ParticleEmitter.h"
 
 #include "system/LowLevelSystem.h"
+#include "system/Platform.h"
 
 #include "resources/Resources.h"
 #include "resources/MaterialManager.h"
@@ -38,9 +39,178 @@
 
 #include "scene/ParticleSystem.h"
 
+#include <string.h>
+
+#ifdef HPL_USE_SSE
+	#include <xmmintrin.h>
+#endif
 
 namespace hpl {
 
+	//////////////////////////////////////////////////////////////////////////
+	// PARTICLE POOL
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	void cParticlePool::Setup(int alMaxParticles)
+	{
+		mvPos.resize(alMaxParticles);
+		mvLastPos.resize(alMaxParticles);
+		mvVel.resize(alMaxParticles);
+		mvAcc.resize(alMaxParticles);
+
+		mvColor.resize(alMaxParticles);
+		mvStartColor.resize(alMaxParticles);
+
+		mvSize.resize(alMaxParticles);
+		mvStartSize.resize(alMaxParticles);
+
+		mvLife.resize(alMaxParticles);
+		mvStartLife.resize(alMaxParticles);
+
+		mvSpin.resize(alMaxParticles, 0);
+		mvSubDivNum.resize(alMaxParticles, 0);
+
+		mvData.resize(alMaxParticles);
+
+		mvDrawPos.resize(alMaxParticles*4);
+		mvDrawLastPos.resize(alMaxParticles*4);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cParticlePool::MoveParticle(int alDest, int alSrc)
+	{
+		mvPos[alDest] = mvPos[alSrc];
+		mvLastPos[alDest] = mvLastPos[alSrc];
+		mvVel[alDest] = mvVel[alSrc];
+		mvAcc[alDest] = mvAcc[alSrc];
+
+		mvColor[alDest] = mvColor[alSrc];
+		mvStartColor[alDest] = mvStartColor[alSrc];
+
+		mvSize[alDest] = mvSize[alSrc];
+		mvStartSize[alDest] = mvStartSize[alSrc];
+
+		mvLife[alDest] = mvLife[alSrc];
+		mvStartLife[alDest] = mvStartLife[alSrc];
+
+		mvSpin[alDest] = mvSpin[alSrc];
+		mvSubDivNum[alDest] = mvSubDivNum[alSrc];
+
+		std::swap(mvData[alDest], mvData[alSrc]);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cParticlePool::Integrate(int alNum, float afTimeStep, const cVector3f& avVelAdd)
+	{
+		if(alNum <= 0) return;
+
+		memcpy(&mvLastPos[0].x, &mvPos[0].x, sizeof(cVector3f)*alNum);
+
+		//cVector3f is 3 packed floats, so the vector streams can be treated as one float array.
+		float *pPos = &mvPos[0].x;
+		float *pVel = &mvVel[0].x;
+		const float *pAcc = &mvAcc[0].x;
+		float *pLife = &mvLife[0];
+
+		const int lFloatNum = alNum*3;
+		int i=0, lLife=0;
+
+	#ifdef HPL_USE_SSE
+		const __m128 vStep = _mm_set1_ps(afTimeStep);
+
+		//The add repeats every 3 floats, which is every 12 floats in 4 wide registers.
+		const __m128 vAdd0 = _mm_setr_ps(avVelAdd.x, avVelAdd.y, avVelAdd.z, avVelAdd.x);
+		const __m128 vAdd1 = _mm_setr_ps(avVelAdd.y, avVelAdd.z, avVelAdd.x, avVelAdd.y);
+		const __m128 vAdd2 = _mm_setr_ps(avVelAdd.z, avVelAdd.x, avVelAdd.y, avVelAdd.z);
+
+		for(; i+12 <= lFloatNum; i+=12)
+		{
+			__m128 vVel0 = _mm_loadu_ps(pVel+i);
+			__m128 vVel1 = _mm_loadu_ps(pVel+i+4);
+			__m128 vVel2 = _mm_loadu_ps(pVel+i+8);
+
+			_mm_storeu_ps(pPos+i,   _mm_add_ps(_mm_loadu_ps(pPos+i),   _mm_mul_ps(vVel0, vStep)));
+			_mm_storeu_ps(pPos+i+4, _mm_add_ps(_mm_loadu_ps(pPos+i+4), _mm_mul_ps(vVel1, vStep)));
+			_mm_storeu_ps(pPos+i+8, _mm_add_ps(_mm_loadu_ps(pPos+i+8), _mm_mul_ps(vVel2, vStep)));
+
+			_mm_storeu_ps(pVel+i,   _mm_add_ps(_mm_add_ps(vVel0, _mm_mul_ps(_mm_loadu_ps(pAcc+i),   vStep)), vAdd0));
+			_mm_storeu_ps(pVel+i+4, _mm_add_ps(_mm_add_ps(vVel1, _mm_mul_ps(_mm_loadu_ps(pAcc+i+4), vStep)), vAdd1));
+			_mm_storeu_ps(pVel+i+8, _mm_add_ps(_mm_add_ps(vVel2, _mm_mul_ps(_mm_loadu_ps(pAcc+i+8), vStep)), vAdd2));
+		}
+
+		for(; lLife+4 <= alNum; lLife+=4)
+		{
+			_mm_storeu_ps(pLife+lLife, _mm_sub_ps(_mm_loadu_ps(pLife+lLife), vStep));
+		}
+	#endif
+
+		for(; i<lFloatNum; ++i)
+		{
+			pPos[i] += pVel[i] * afTimeStep;
+			pVel[i] = (pVel[i] + pAcc[i] * afTimeStep) + avVelAdd.v[i%3];
+		}
+
+		for(; lLife<alNum; ++lLife)
+		{
+			pLife[lLife] -= afTimeStep;
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cParticlePool::TransformPositions(int alNum, const cMatrixf* apMtx, bool abLastPos)
+	{
+		if(alNum <= 0) return;
+
+		const cVector3f *pSrc = abLastPos ? &mvLastPos[0] : &mvPos[0];
+		float *pDest = abLastPos ? &mvDrawLastPos[0] : &mvDrawPos[0];
+
+		if(apMtx==NULL)
+		{
+			for(int i=0; i<alNum; ++i)
+			{
+				pDest[i*4+0] = pSrc[i].x;
+				pDest[i*4+1] = pSrc[i].y;
+				pDest[i*4+2] = pSrc[i].z;
+				pDest[i*4+3] = 1;
+			}
+			return;
+		}
+
+		const cMatrixf &mtx = *apMtx;
+
+	#ifdef HPL_USE_SSE
+		const __m128 vCol0 = _mm_setr_ps(mtx.m[0][0], mtx.m[1][0], mtx.m[2][0], 0);
+		const __m128 vCol1 = _mm_setr_ps(mtx.m[0][1], mtx.m[1][1], mtx.m[2][1], 0);
+		const __m128 vCol2 = _mm_setr_ps(mtx.m[0][2], mtx.m[1][2], mtx.m[2][2], 0);
+		const __m128 vCol3 = _mm_setr_ps(mtx.m[0][3], mtx.m[1][3], mtx.m[2][3], 1);
+
+		for(int i=0; i<alNum; ++i)
+		{
+			__m128 vPos = _mm_add_ps(_mm_add_ps(_mm_add_ps(	_mm_mul_ps(vCol0, _mm_set1_ps(pSrc[i].x)),
+															_mm_mul_ps(vCol1, _mm_set1_ps(pSrc[i].y))),
+															_mm_mul_ps(vCol2, _mm_set1_ps(pSrc[i].z))),
+															vCol3);
+			_mm_storeu_ps(pDest + i*4, vPos);
+		}
+	#else
+		for(int i=0; i<alNum; ++i)
+		{
+			const cVector3f &vPos = pSrc[i];
+			pDest[i*4+0] = mtx.m[0][0] * vPos.x + mtx.m[0][1] * vPos.y + mtx.m[0][2] * vPos.z + mtx.m[0][3];
+			pDest[i*4+1] = mtx.m[1][0] * vPos.x + mtx.m[1][1] * vPos.y + mtx.m[1][2] * vPos.z + mtx.m[1][3];
+			pDest[i*4+2] = mtx.m[2][0] * vPos.x + mtx.m[2][1] * vPos.y + mtx.m[2][2] * vPos.z + mtx.m[2][3];
+			pDest[i*4+3] = 1;
+		}
+	#endif
+	}
+
+	//-----------------------------------------------------------------------
+
 	//////////////////////////////////////////////////////////////////////////
 	// DATA LOADER
 	//////////////////////////////////////////////////////////////////////////
@@ -93,11 +263,7 @@ namespace hpl {
 
 		/////////////////////////////////////
 		//Create and set up particle data
-		mvParticles.resize(alMaxParticles);
-		for(int i=0;i<(int)alMaxParticles;i++)
-		{
-			mvParticles[i] = hplNew( cParticle, () );
-		}
+		mParticles.Setup(alMaxParticles);
 		mlMaxParticles = alMaxParticles;
 		mlNumOfParticles =0;
 
@@ -176,11 +342,6 @@ namespace hpl {
 
 	iParticleEmitter::~iParticleEmitter()
 	{
-		for(int i=0;i<(int)mvParticles.size();i++)
-		{
-			hplDelete(mvParticles[i]);
-		}
-
 		hplDelete(mpVtxBuffer);
 	}
 
@@ -283,26 +444,34 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
-	static inline void SetCol(float *apCol, const cColor &aCol)
+	/**
+	 * Writes the 4 corners of a quad. apCenter is x,y,z,1 and apAdd is the 4 corner offsets as x,y,z,0.
+	 */
+	static inline void SetQuad(float *apPos, int alVtxStride, float *apCol, const float *apCenter, const float *apAdd, const cColor &aCol)
 	{
-		apCol[0] = aCol.r;
-		apCol[1] = aCol.g;
-		apCol[2] = aCol.b;
-		apCol[3] = aCol.a;
-	}
-
-	static inline void SetPos(float *apPos, const cVector3f &aPos)
-	{
-		apPos[0] = aPos.x;
-		apPos[1] = aPos.y;
-		apPos[2] = aPos.z;
+	#ifdef HPL_USE_SSE
+		const __m128 vCenter = _mm_loadu_ps(apCenter);
+		const __m128 vCol = _mm_loadu_ps(aCol.v);
+		for(int i=0; i<4; ++i)
+		{
+			_mm_storeu_ps(&apPos[i*alVtxStride], _mm_add_ps(vCenter, _mm_loadu_ps(&apAdd[i*4])));
+			_mm_storeu_ps(&apCol[i*4], vCol);
+		}
+	#else
+		for(int i=0; i<4; ++i)
+		{
+			for(int j=0; j<4; ++j) apPos[i*alVtxStride + j] = apCenter[j] + apAdd[i*4 + j];
+			for(int j=0; j<4; ++j) apCol[i*4 + j] = aCol.v[j];
+		}
+	#endif
 	}
 
-	static inline void SetTex(float *apTex, const cVector3f &aPos)
+	static inline void SetOffset(float *apAdd, const cVector3f &avAdd)
 	{
-		apTex[0] = aPos.x;
-		apTex[1] = aPos.y;
-		apTex[2] = aPos.z;
+		apAdd[0] = avAdd.x;
+		apAdd[1] = avAdd.y;
+		apAdd[2] = avAdd.z;
+		apAdd[3] = 0;
 	}
 
 	bool iParticleEmitter::UpdateGraphicsForViewport(cFrustum *apFrustum,float afFrameTime)
@@ -391,182 +560,125 @@ namespace hpl {
 		}
 		else
 		{
+			const int lNum = (int)mlNumOfParticles;
+			const int lVtxStride = mpVtxBuffer->GetElementNum(eVertexBufferElement_Position);
+			const int lVtxQuadSize = lVtxStride*4;
+
 			//////////////////////////////////////////////////
 			// SUB DIVISION SET UP
 			if(mvSubDivUV.size() > 1)
 			{
 				float *pTexArray = mpVtxBuffer->GetFloatArray(eVertexBufferElement_Texture0);
+				const int *pSubDivNum = lNum > 0 ? &mParticles.mvSubDivNum[0] : NULL;
 
-				for(int i=0;i<(int)mlNumOfParticles;i++)
+				for(int i=0;i<lNum;i++)
 				{
-					cParticle *pParticle = mvParticles[i];
-
-					cPESubDivision &subDiv = mvSubDivUV[pParticle->mlSubDivNum];
-
-					SetTex(&pTexArray[i*12 + 0*3],subDiv.mvUV[0]);
-					SetTex(&pTexArray[i*12 + 1*3],subDiv.mvUV[1]);
-					SetTex(&pTexArray[i*12 + 2*3],subDiv.mvUV[2]);
-					SetTex(&pTexArray[i*12 + 3*3],subDiv.mvUV[3]);
-
-					/*SetTex(&pTexArray[i*12 + 0*3], cVector3f(1,1,0));
-					SetTex(&pTexArray[i*12 + 1*3], cVector3f(0,1,0));
-					SetTex(&pTexArray[i*12 + 2*3], cVector3f(0,0,0));
-					SetTex(&pTexArray[i*12 + 3*3], cVector3f(1,0,0));*/
+					memcpy(&pTexArray[i*12], mvSubDivUV[pSubDivNum[i]].mvUV, sizeof(float)*12);
 				}
 			}
 
 			//////////////////////////////////////////////////
-			// FIXED POINT
-			if(mDrawType == eParticleEmitterType_FixedPoint)
+			// Transform all positions at once, axis particles are drawn in world space and the rest in view space.
+			cMatrixf mtxPos;
+			const cMatrixf *pMtxPos = NULL;
+			if(mDrawType == eParticleEmitterType_Axis)
 			{
-				cVector3f vAdd[4] = {
-					cVector3f( mvDrawSize.x,-mvDrawSize.y,0),
-						cVector3f(-mvDrawSize.x,-mvDrawSize.y,0),
-						cVector3f(-mvDrawSize.x, mvDrawSize.y,0),
-						cVector3f( mvDrawSize.x, mvDrawSize.y,0)
-				};
-
-				//If this is a reflection, need to invert the ordering.
-				if(apFrustum->GetInvertsCullMode())
+				if(mCoordSystem == eParticleEmitterCoordSystem_Local)
 				{
-					for(int i=0; i<4; ++i)	vAdd[i].y = -vAdd[i].y;
+					mtxPos = mpParentSystem->GetWorldMatrix();
+					pMtxPos = &mtxPos;
 				}
-
-				// NEW
-
-				// ---
-
-
-				int lVtxStride = mpVtxBuffer->GetElementNum(eVertexBufferElement_Position);
-				int lVtxQuadSize = lVtxStride*4;
-
-				for(int i=0;i<(int)mlNumOfParticles;i++)
+			}
+			else
+			{
+				mtxPos = apFrustum->GetViewMatrix();
+				if(mCoordSystem == eParticleEmitterCoordSystem_Local)
 				{
-					cParticle *pParticle = mvParticles[i];
-
-					//This is not the fastest thing possible...
-					cVector3f vParticlePos = pParticle->mvPos;
+					mtxPos = cMath::MatrixMul(mtxPos, mpParentSystem->GetWorldMatrix());
+				}
+				pMtxPos = &mtxPos;
+			}
 
-					if(mCoordSystem == eParticleEmitterCoordSystem_Local){
-						vParticlePos = cMath::MatrixMul(mpParentSystem->GetWorldMatrix(), vParticlePos);
-					}
+			mParticles.TransformPositions(lNum, pMtxPos);
 
-					cVector3f vPos = cMath::MatrixMul(apFrustum->GetViewMatrix(), vParticlePos);
-					cColor finalColor = pParticle->mColor * colorMul;
+			const float *pDrawPos = lNum > 0 ? &mParticles.mvDrawPos[0] : NULL;
+			const cColor *pColor = lNum > 0 ? &mParticles.mvColor[0] : NULL;
+			const cVector2f *pSize = lNum > 0 ? &mParticles.mvSize[0] : NULL;
 
-					SetPos(&pPosArray[i*lVtxQuadSize + 0*lVtxStride], vPos + vAdd[0]);
-					SetCol(&pColArray[i*16 + 0*4], finalColor);
+			float vAdd[16];
 
-					SetPos(&pPosArray[i*lVtxQuadSize + 1*lVtxStride], vPos + vAdd[1]);
-					SetCol(&pColArray[i*16 + 1*4], finalColor);
+			//////////////////////////////////////////////////
+			// FIXED POINT
+			if(mDrawType == eParticleEmitterType_FixedPoint)
+			{
+				//If this is a reflection, need to invert the ordering.
+				float fSizeY = apFrustum->GetInvertsCullMode() ? -mvDrawSize.y : mvDrawSize.y;
 
-					SetPos(&pPosArray[i*lVtxQuadSize + 2*lVtxStride], vPos + vAdd[2]);
-					SetCol(&pColArray[i*16 + 2*4], finalColor);
+				SetOffset(&vAdd[0*4], cVector3f( mvDrawSize.x,-fSizeY,0));
+				SetOffset(&vAdd[1*4], cVector3f(-mvDrawSize.x,-fSizeY,0));
+				SetOffset(&vAdd[2*4], cVector3f(-mvDrawSize.x, fSizeY,0));
+				SetOffset(&vAdd[3*4], cVector3f( mvDrawSize.x, fSizeY,0));
 
-					SetPos(&pPosArray[i*lVtxQuadSize + 3*lVtxStride], vPos + vAdd[3]);
-					SetCol(&pColArray[i*16 + 3*4], finalColor);
+				for(int i=0;i<lNum;i++)
+				{
+					SetQuad(&pPosArray[i*lVtxQuadSize], lVtxStride, &pColArray[i*16], &pDrawPos[i*4], vAdd, pColor[i] * colorMul);
 				}
 			}
 			//////////////////////////////////////////////////
 			// DYNAMIC POINT
 			else if(mDrawType == eParticleEmitterType_DynamicPoint)
 			{
-				cVector3f vAdd[4] = {
-						cVector3f( mvDrawSize.x,-mvDrawSize.y,0),
-						cVector3f(-mvDrawSize.x,-mvDrawSize.y,0),
-						cVector3f(-mvDrawSize.x, mvDrawSize.y,0),
-						cVector3f( mvDrawSize.x, mvDrawSize.y,0)
+				const cVector2f vCorner[4] = {
+						cVector2f( mvDrawSize.x,-mvDrawSize.y),
+						cVector2f(-mvDrawSize.x,-mvDrawSize.y),
+						cVector2f(-mvDrawSize.x, mvDrawSize.y),
+						cVector2f( mvDrawSize.x, mvDrawSize.y)
 				};
 
 				//If this is a reflection, need to invert the ordering.
-				if(apFrustum->GetInvertsCullMode())
-				{
-					for(int i=0; i<4; ++i)	vAdd[i].y = -vAdd[i].y;
-				}
+				float fInvertY = apFrustum->GetInvertsCullMode() ? -1.0f : 1.0f;
 
-				int lVtxStride = mpVtxBuffer->GetElementNum(eVertexBufferElement_Position);
-				int lVtxQuadSize = lVtxStride*4;
+				const float *pSpin = lNum > 0 ? &mParticles.mvSpin[0] : NULL;
 
-				for(int i=0;i<(int)mlNumOfParticles;i++)
+				for(int i=0;i<lNum;i++)
 				{
-					cParticle *pParticle = mvParticles[i];
-
-					//This is not the fastest thing possible
-					cVector3f vParticlePos = pParticle->mvPos;
-
-
-					if(mCoordSystem == eParticleEmitterCoordSystem_Local){
-						vParticlePos = cMath::MatrixMul(mpParentSystem->GetWorldMatrix(), vParticlePos);
-					}
-
-					cVector3f vPos = cMath::MatrixMul(apFrustum->GetViewMatrix(), vParticlePos);
-
-
-					// NEW
-
-					cVector3f vParticleSize = pParticle->mvSize;
-					cColor finalColor = pParticle->mColor * colorMul;
+					const cVector2f &vSize = pSize[i];
 
 					if ( mbUsePartSpin )
 					{
-						cMatrixf mtxRotationMatrix = cMath::MatrixRotateZ(pParticle->mfSpin);
-
-
-						SetPos(&pPosArray[i*lVtxQuadSize + 0*lVtxStride], vPos + cMath::MatrixMul(mtxRotationMatrix, vAdd[0]*vParticleSize));
-						SetCol(&pColArray[i*16 + 0*4], finalColor);
-
-						SetPos(&pPosArray[i*lVtxQuadSize + 1*lVtxStride], vPos + cMath::MatrixMul(mtxRotationMatrix, vAdd[1]*vParticleSize));
-						SetCol(&pColArray[i*16 + 1*4], finalColor);
-
-						SetPos(&pPosArray[i*lVtxQuadSize + 2*lVtxStride], vPos + cMath::MatrixMul(mtxRotationMatrix, vAdd[2]*vParticleSize));
-						SetCol(&pColArray[i*16 + 2*4], finalColor);
-
-						SetPos(&pPosArray[i*lVtxQuadSize + 3*lVtxStride], vPos + cMath::MatrixMul(mtxRotationMatrix, vAdd[3]*vParticleSize));
-						SetCol(&pColArray[i*16 + 3*4], finalColor);
-
+						//Same as a rotation around z
+						float fCos = cos(pSpin[i]);
+						float fSin = sin(pSpin[i]);
+
+						for(int j=0; j<4; ++j)
+						{
+							float fX = vCorner[j].x * vSize.x;
+							float fY = vCorner[j].y * fInvertY * vSize.y;
+							SetOffset(&vAdd[j*4], cVector3f(fCos*fX - fSin*fY, fSin*fX + fCos*fY, 0));
+						}
 					}
 					else
 					{
-						//--
-
-						SetPos(&pPosArray[i*lVtxQuadSize + 0*lVtxStride], vPos + vAdd[0]*vParticleSize);
-						SetCol(&pColArray[i*16 + 0*4], finalColor);
-
-						SetPos(&pPosArray[i*lVtxQuadSize + 1*lVtxStride], vPos + vAdd[1]*vParticleSize);
-						SetCol(&pColArray[i*16 + 1*4], finalColor);
-
-						SetPos(&pPosArray[i*lVtxQuadSize + 2*lVtxStride], vPos + vAdd[2]*vParticleSize);
-						SetCol(&pColArray[i*16 + 2*4], finalColor);
-
-						SetPos(&pPosArray[i*lVtxQuadSize + 3*lVtxStride], vPos + vAdd[3]*vParticleSize);
-						SetCol(&pColArray[i*16 + 3*4], finalColor);
-
+						for(int j=0; j<4; ++j)
+						{
+							SetOffset(&vAdd[j*4], cVector3f(vCorner[j].x * vSize.x, vCorner[j].y * fInvertY * vSize.y, 0));
+						}
 					}
+
+					SetQuad(&pPosArray[i*lVtxQuadSize], lVtxStride, &pColArray[i*16], &pDrawPos[i*4], vAdd, pColor[i] * colorMul);
 				}
 			}
 			//////////////////////////////////////////////////
 			// LINE
 			else if(mDrawType == eParticleEmitterType_Line)
 			{
-				int lVtxStride = mpVtxBuffer->GetElementNum(eVertexBufferElement_Position);
-				int lVtxQuadSize = lVtxStride*4;
+				mParticles.TransformPositions(lNum, pMtxPos, true);
+				const float *pDrawLastPos = lNum > 0 ? &mParticles.mvDrawLastPos[0] : NULL;
 
-				for(int i=0;i<(int)mlNumOfParticles;i++)
+				for(int i=0;i<lNum;i++)
 				{
-					cParticle *pParticle = mvParticles[i];
-
-					//This is not the fastest thing possible...
-
-					cVector3f vParticlePos1 = pParticle->mvPos;
-					cVector3f vParticlePos2 = pParticle->mvLastPos;
-
-					if(mCoordSystem == eParticleEmitterCoordSystem_Local){
-						vParticlePos1 = cMath::MatrixMul(mpParentSystem->GetWorldMatrix(), vParticlePos1);
-						vParticlePos2 = cMath::MatrixMul(mpParentSystem->GetWorldMatrix(), vParticlePos2);
-					}
-
-					cVector3f vPos1 = cMath::MatrixMul(apFrustum->GetViewMatrix(), vParticlePos1);
-					cVector3f vPos2 = cMath::MatrixMul(apFrustum->GetViewMatrix(), vParticlePos2);
+					cVector3f vPos1(pDrawPos[i*4+0], pDrawPos[i*4+1], pDrawPos[i*4+2]);
+					cVector3f vPos2(pDrawLastPos[i*4+0], pDrawLastPos[i*4+1], pDrawLastPos[i*4+2]);
 
 					cVector3f vDirY;
 					cVector2f vDirX;
@@ -584,24 +696,21 @@ namespace hpl {
 						vDirX.Normalize();
 					}
 
-					vDirX = vDirX * mvDrawSize.x * pParticle->mvSize.x;
-					vDirY = vDirY * mvDrawSize.y * pParticle->mvSize.y;
+					vDirX = vDirX * mvDrawSize.x * pSize[i].x;
+					vDirY = vDirY * mvDrawSize.y * pSize[i].y;
 
 					if(apFrustum->GetInvertsCullMode()) vDirY = vDirY*-1;
 
-					cColor finalColor = pParticle->mColor * colorMul;
-
-					SetPos(&pPosArray[i*lVtxQuadSize + 0*lVtxStride], vPos2 + vDirY*-1 + vDirX);
-					SetCol(&pColArray[i*16 + 0*4], finalColor);
-
-					SetPos(&pPosArray[i*lVtxQuadSize + 1*lVtxStride], vPos2 + vDirY*-1 + vDirX*-1);
-					SetCol(&pColArray[i*16 + 1*4], finalColor);
+					//Offsets are relative to the current position
+					cVector3f vBack = vPos2 - vPos1;
+					cVector3f vDirX3(vDirX.x, vDirX.y, 0);
 
-					SetPos(&pPosArray[i*lVtxQuadSize + 2*lVtxStride], vPos1 + vDirY + vDirX*-1);
-					SetCol(&pColArray[i*16 + 2*4], finalColor);
+					SetOffset(&vAdd[0*4], vBack + vDirY*-1 + vDirX3);
+					SetOffset(&vAdd[1*4], vBack + vDirY*-1 + vDirX3*-1);
+					SetOffset(&vAdd[2*4], vDirY + vDirX3*-1);
+					SetOffset(&vAdd[3*4], vDirY + vDirX3);
 
-					SetPos(&pPosArray[i*lVtxQuadSize + 3*lVtxStride], vPos1 + vDirY + vDirX);
-					SetCol(&pColArray[i*16 + 3*4], finalColor);
+					SetQuad(&pPosArray[i*lVtxQuadSize], lVtxStride, &pColArray[i*16], &pDrawPos[i*4], vAdd, pColor[i] * colorMul);
 				}
 			}
 			//////////////////////////////////////////////////
@@ -616,51 +725,16 @@ namespace hpl {
 					mvForward = mtxInv.GetForward();
 				}
 
-				cVector3f vAdd[4];
-				/*=
+				for(int i=0;i<lNum;i++)
 				{
-				mvRight		 +	mvForward * 1,
-				mvRight * -1 +	mvForward * 1,
-				mvRight * -1 +	mvForward * -1,
-				mvRight		 +	mvForward * -1
-				};*/
-
-				int lVtxStride = mpVtxBuffer->GetElementNum(eVertexBufferElement_Position);
-				int lVtxQuadSize = lVtxStride*4;
-
-				for(int i=0;i<(int)mlNumOfParticles;i++)
-				{
-					cParticle *pParticle = mvParticles[i];
-
-					//This is not the fastest thing possible
-					cVector3f vParticlePos = pParticle->mvPos;
+					const cVector2f &vSize = pSize[i];
 
+					SetOffset(&vAdd[0*4], mvRight	* vSize.x	 +	mvForward * vSize.y);
+					SetOffset(&vAdd[1*4], mvRight * -vSize.x	 +	mvForward * vSize.y);
+					SetOffset(&vAdd[2*4], mvRight * -vSize.x	 +	mvForward * -vSize.y);
+					SetOffset(&vAdd[3*4], mvRight	* vSize.x	 +	mvForward * -vSize.y);
 
-					if(mCoordSystem == eParticleEmitterCoordSystem_Local){
-						vParticlePos = cMath::MatrixMul(mpParentSystem->GetWorldMatrix(), vParticlePos);
-					}
-
-					cVector3f vPos = vParticlePos;//cMath::MatrixMul(apCamera->GetViewMatrix(), vParticlePos);
-					cVector2f &vSize = pParticle->mvSize;
-
-					vAdd[0] = mvRight	* vSize.x	 +	mvForward * vSize.y;
-					vAdd[1] = mvRight * -vSize.x	 +	mvForward * vSize.y;
-					vAdd[2] = mvRight * -vSize.x	 +	mvForward * -vSize.y;
-					vAdd[3] = mvRight	* vSize.x	 +	mvForward * -vSize.y;
-
-					cColor finalColor = pParticle->mColor * colorMul;
-
-					SetPos(&pPosArray[i*lVtxQuadSize + 0*lVtxStride], vPos + vAdd[0]);
-					SetCol(&pColArray[i*16 + 0*4], finalColor);
-
-					SetPos(&pPosArray[i*lVtxQuadSize + 1*lVtxStride], vPos + vAdd[1]);
-					SetCol(&pColArray[i*16 + 1*4], finalColor);
-
-					SetPos(&pPosArray[i*lVtxQuadSize + 2*lVtxStride], vPos + vAdd[2]);
-					SetCol(&pColArray[i*16 + 2*4], finalColor);
-
-					SetPos(&pPosArray[i*lVtxQuadSize + 3*lVtxStride], vPos + vAdd[3]);
-					SetCol(&pColArray[i*16 + 3*4], finalColor);
+					SetQuad(&pPosArray[i*lVtxQuadSize], lVtxStride, &pColArray[i*16], &pDrawPos[i*4], vAdd, pColor[i] * colorMul);
 				}
 			}
 
@@ -708,21 +782,20 @@ namespace hpl {
 				vMin = GetWorldPosition();
 				vMax = GetWorldPosition();
 
+				const cVector3f *pPos = &mParticles.mvPos[0];
 				for(int i=0;i<(int)mlNumOfParticles;i++)
 				{
-					cParticle *pParticle = mvParticles[i];
-
 					//X
-					if(pParticle->mvPos.x < vMin.x)		 vMin.x = pParticle->mvPos.x;
-					else if(pParticle->mvPos.x > vMax.x) vMax.x = pParticle->mvPos.x;
+					if(pPos[i].x < vMin.x)		vMin.x = pPos[i].x;
+					else if(pPos[i].x > vMax.x) vMax.x = pPos[i].x;
 
 					//Y
-					if(pParticle->mvPos.y < vMin.y)		 vMin.y = pParticle->mvPos.y;
-					else if(pParticle->mvPos.y > vMax.y) vMax.y = pParticle->mvPos.y;
+					if(pPos[i].y < vMin.y)		vMin.y = pPos[i].y;
+					else if(pPos[i].y > vMax.y) vMax.y = pPos[i].y;
 
 					//Z
-					if(pParticle->mvPos.z < vMin.z)		 vMin.z = pParticle->mvPos.z;
-					else if(pParticle->mvPos.z > vMax.z) vMax.z = pParticle->mvPos.z;
+					if(pPos[i].z < vMin.z)		vMin.z = pPos[i].z;
+					else if(pPos[i].z > vMax.z) vMax.z = pPos[i].z;
 				}
 			}
 			else
@@ -817,11 +890,11 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
-	cParticle* iParticleEmitter::CreateParticle()
+	int iParticleEmitter::CreateParticle()
 	{
-		if(mlNumOfParticles == mlMaxParticles) return NULL;
+		if(mlNumOfParticles == mlMaxParticles) return -1;
 		++mlNumOfParticles;
-		return mvParticles[mlNumOfParticles-1];
+		return mlNumOfParticles-1;
 	}
 
 	//-----------------------------------------------------------------------
@@ -830,9 +903,7 @@ namespace hpl {
 	{
 		if(alIndex < mlNumOfParticles-1)
 		{
-			cParticle* pTemp = mvParticles[alIndex];
-			mvParticles[alIndex] = mvParticles[mlNumOfParticles-1];
-			mvParticles[mlNumOfParticles-1] = pTemp;
+			mParticles.MoveParticle(alIndex, mlNumOfParticles-1);
 		}
 		mlNumOfParticles--;
 	}
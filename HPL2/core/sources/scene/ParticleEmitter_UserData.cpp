@@ -654,21 +654,24 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
-	void cParticleEmitter_UserData::SetParticleDefaults(cParticle *apParticle)
+	void cParticleEmitter_UserData::SetParticleDefaults(int alIdx)
 	{
+		cParticlePool &particles = mParticles;
+		cParticle *pParticle = &particles.mvData[alIdx];
+
 		///////////////////////////////////
 		//Start Color
-		apParticle->mStartColor = cMath::RandRectColor(mpData->mMinStartColor,mpData->mMaxStartColor);
-		apParticle->mColor = apParticle->mStartColor * mpData->mStartRelColor;
+		particles.mvStartColor[alIdx] = cMath::RandRectColor(mpData->mMinStartColor,mpData->mMaxStartColor);
+		particles.mvColor[alIdx] = particles.mvStartColor[alIdx] * mpData->mStartRelColor;
 
 
 		///////////////////////////////////
 		//Start Size
 		if(mpData->mvMinStartSize.y == 0 && mpData->mvMaxStartSize.y==0)
-			apParticle->mvStartSize = cMath::RandRectf(mpData->mvMinStartSize.x,mpData->mvMaxStartSize.x);
+			particles.mvStartSize[alIdx] = cMath::RandRectf(mpData->mvMinStartSize.x,mpData->mvMaxStartSize.x);
 		else
-			apParticle->mvStartSize = cMath::RandRectVector2f(mpData->mvMinStartSize,mpData->mvMaxStartSize);
-		apParticle->mvSize = apParticle->mvStartSize * mpData->mfStartRelSize;
+			particles.mvStartSize[alIdx] = cMath::RandRectVector2f(mpData->mvMinStartSize,mpData->mvMaxStartSize);
+		particles.mvSize[alIdx] = particles.mvStartSize[alIdx] * mpData->mfStartRelSize;
 
 		////////////////////////////////////
 		//Start sub division
@@ -676,18 +679,18 @@ namespace hpl {
 		{
 			if(mpData->mSubDivType == ePESubDivType_Animation)
 			{
-				apParticle->mlSubDivNum = 0;
+				particles.mvSubDivNum[alIdx] = 0;
 			}
 			else
 			{
-				apParticle->mlSubDivNum = cMath::RandRectl(0,(int)mvSubDivUV.size()-1);
+				particles.mvSubDivNum[alIdx] = cMath::RandRectl(0,(int)mvSubDivUV.size()-1);
 			}
 		}
 
 		////////////////////////////////////
 		//Start collision
-		apParticle->mfBounceAmount = cMath::RandRectf(mpData->mfMinBounceAmount, mpData->mfMaxBounceAmount);
-		apParticle->mlBounceCount = cMath::RandRectl(mpData->mlMinCollisionMax, mpData->mlMaxCollisionMax);
+		pParticle->mfBounceAmount = cMath::RandRectf(mpData->mfMinBounceAmount, mpData->mfMaxBounceAmount);
+		pParticle->mlBounceCount = cMath::RandRectl(mpData->mlMinCollisionMax, mpData->mlMaxCollisionMax);
 
 
 		////////////////////////////////////
@@ -706,7 +709,7 @@ namespace hpl {
 		//Sphere or box start
 		if(mpData->mStartPosType == ePEStartPosType_Box)
 		{
-			apParticle->mvPos = mtxStart.GetTranslation() +
+			particles.mvPos[alIdx] = mtxStart.GetTranslation() +
 								cMath::RandRectVector3f(mpData->mvMinStartPos,mpData->mvMaxStartPos);
 		}
 		else if(mpData->mStartPosType == ePEStartPosType_Sphere)
@@ -716,7 +719,7 @@ namespace hpl {
 			cMatrixf mtxRot = cMath::MatrixRotate(vRot,eEulerRotationOrder_XYZ);
 			cVector3f vPos = cVector3f(0,cMath::RandRectf(mpData->mfMinStartRadius,mpData->mfMaxStartRadius),0);
 
-			apParticle->mvPos = mtxStart.GetTranslation() + cMath::MatrixMul(mtxRot,vPos);
+			particles.mvPos[alIdx] = mtxStart.GetTranslation() + cMath::MatrixMul(mtxRot,vPos);
 		}
 
 // NEW
@@ -730,9 +733,9 @@ namespace hpl {
 			vTrans.y += mpData->mpfMeshVtxData[posI*4 + 1];
 			vTrans.z += mpData->mpfMeshVtxData[posI*4 + 2];
 
-			apParticle->mvPos = vTrans;
+			particles.mvPos[alIdx] = vTrans;
 			*/
-//			apParticle->mvPos = mtxStart.GetTranslation() + mpData->mVBMeshData->GetVector3( eVertexElementFlag_Position, cMath::RandRectl(0,mpData->mVBMeshData->GetVertexNum()-1) );
+//			particles.mvPos[alIdx] = mtxStart.GetTranslation() + mpData->mVBMeshData->GetVector3( eVertexElementFlag_Position, cMath::RandRectl(0,mpData->mVBMeshData->GetVertexNum()-1) );
 //			++posI;
 	//		if ( posI == mpData->mVBMeshData->GetVertexNum() )
 	//			posI = 0;
@@ -741,8 +744,8 @@ namespace hpl {
 // ---
 
 
-		apParticle->mvLastPos = apParticle->mvPos;
-		apParticle->mvLastCollidePos = apParticle->mvPos;
+		particles.mvLastPos[alIdx] = particles.mvPos[alIdx];
+		pParticle->mvLastCollidePos = particles.mvPos[alIdx];
 
 
 		////////////////////////////////////
@@ -751,7 +754,7 @@ namespace hpl {
 		//Sphere or box start
 		if(mpData->mStartVelType == ePEStartPosType_Box)
 		{
-			apParticle->mvVel = cMath::RandRectVector3f(mpData->mvMinStartVel,mpData->mvMaxStartVel);
+			particles.mvVel[alIdx] = cMath::RandRectVector3f(mpData->mvMinStartVel,mpData->mvMaxStartVel);
 		}
 		else if(mpData->mStartVelType == ePEStartPosType_Sphere)
 		{
@@ -760,40 +763,40 @@ namespace hpl {
 			cMatrixf mtxRot = cMath::MatrixRotate(vRot,eEulerRotationOrder_XYZ);
 			cVector3f vPos = cVector3f(0,cMath::RandRectf(mpData->mfMinStartVelSpeed,mpData->mfMaxStartVelSpeed),0);
 
-			apParticle->mvVel = cMath::MatrixMul(mtxRot,vPos);
+			particles.mvVel[alIdx] = cMath::MatrixMul(mtxRot,vPos);
 		}
 
 		//If it uses the direction,
 		if(mpData->mbUsesDirection && mpData->mCoordSystem == eParticleEmitterCoordSystem_World)
 		{
-			apParticle->mvVel = cMath::MatrixMul(mtxStart.GetRotation(), apParticle->mvVel);
+			particles.mvVel[alIdx] = cMath::MatrixMul(mtxStart.GetRotation(), particles.mvVel[alIdx]);
 		}
 
-		apParticle->mfMaxSpeed = cMath::RandRectf(mpData->mfMinVelMaximum,mpData->mfMaxVelMaximum);
+		pParticle->mfMaxSpeed = cMath::RandRectf(mpData->mfMinVelMaximum,mpData->mfMaxVelMaximum);
 
-		apParticle->mfSpeedMul = cMath::RandRectf(mpData->mfMinSpeedMultiply,mpData->mfMaxSpeedMultiply);
+		pParticle->mfSpeedMul = cMath::RandRectf(mpData->mfMinSpeedMultiply,mpData->mfMaxSpeedMultiply);
 
 		////////////////////////////////////
 		//Start Acceleration
-		apParticle->mvAcc = cMath::RandRectVector3f(mpData->mvMinStartAcc,mpData->mvMaxStartAcc);
+		particles.mvAcc[alIdx] = cMath::RandRectVector3f(mpData->mvMinStartAcc,mpData->mvMaxStartAcc);
 
 		// NEW
 		////////////////////////////////////
 		//Start Spin Velocity
 		if ( mpData->mPartSpinType == ePEPartSpinType_Constant )
 		{
-			apParticle->mfSpinVel = cMath::RandRectf (mpData->mfMinSpinRange, mpData->mfMaxSpinRange);
+			pParticle->mfSpinVel = cMath::RandRectf (mpData->mfMinSpinRange, mpData->mfMaxSpinRange);
 		}
 		else if ( mpData->mPartSpinType == ePEPartSpinType_Movement )
 		{
-			apParticle->mfSpinFactor = cMath::RandRectf (mpData->mfMinSpinRange, mpData->mfMaxSpinRange);
-			apParticle->mfSpinVel = 0.0f;
+			pParticle->mfSpinFactor = cMath::RandRectf (mpData->mfMinSpinRange, mpData->mfMaxSpinRange);
+			pParticle->mfSpinVel = 0.0f;
 		}
-		apParticle->mfSpin = apParticle->mfSpin = cMath::RandRectf ( 0.0f, k2Pif );
+		particles.mvSpin[alIdx] = cMath::RandRectf ( 0.0f, k2Pif );
 
 		////////////////////////////////////
 		//Start Revolution Velocity
-		apParticle->mvRevolutionVel = cMath::RandRectVector3f ( mpData->mvMinRevVel, mpData->mvMaxRevVel );
+		pParticle->mvRevolutionVel = cMath::RandRectVector3f ( mpData->mvMinRevVel, mpData->mvMaxRevVel );
 
 		// ---
 
@@ -801,64 +804,54 @@ namespace hpl {
 
 		///////////////////////////////////
 		//Life Span
-		apParticle->mfStartLife = cMath::RandRectf(mpData->mfMinLifeSpan,mpData->mfMaxLifeSpan );
-		apParticle->mfLife = apParticle->mfStartLife;
-
-		apParticle->mfLifeSize_MiddleStart = apParticle->mfLife * (1 - mpData->mfMiddleRelSizeTime);
-		apParticle->mfLifeSize_MiddleEnd  = apParticle->mfLife * (1 - (mpData->mfMiddleRelSizeTime +
-																		mpData->mfMiddleRelSizeLength));
-
-		apParticle->mfLifeColor_MiddleStart  = apParticle->mfLife * (1 - mpData->mfMiddleRelColorTime);
-		apParticle->mfLifeColor_MiddleEnd  = apParticle->mfLife * (1 - (mpData->mfMiddleRelColorTime +
-																		mpData->mfMiddleRelColorLength));
-
-		/*Log("Created particle with Pos: (%s) Color: (%s) Size (%s) Vel: (%s) Acc: (%s) Life: %f SizeMiddleStart: %f SizeMiddleEnd: %f\n",
-					apParticle->mvPos.ToString().c_str(),
-					apParticle->mColor.ToString().c_str(),
-					apParticle->mvSize.ToString().c_str(),
-					apParticle->mvVel.ToString().c_str(),
-					apParticle->mvAcc.ToString().c_str(),
-					apParticle->mfLife,
-					apParticle->mfLifeSize_MiddleStart,
-					apParticle->mfLifeSize_MiddleEnd);*/
+		particles.mvStartLife[alIdx] = cMath::RandRectf(mpData->mfMinLifeSpan,mpData->mfMaxLifeSpan );
+		particles.mvLife[alIdx] = particles.mvStartLife[alIdx];
+
+		/*Log("Created particle with Pos: (%s) Color: (%s) Size (%s) Vel: (%s) Acc: (%s) Life: %f\n",
+					particles.mvPos[alIdx].ToString().c_str(),
+					particles.mvColor[alIdx].ToString().c_str(),
+					particles.mvSize[alIdx].ToString().c_str(),
+					particles.mvVel[alIdx].ToString().c_str(),
+					particles.mvAcc[alIdx].ToString().c_str(),
+					particles.mvLife[alIdx]);*/
 		// NEW
 		/////////////////////////////////////
 		//Beam Specific
 		if (mPEType == ePEType_Beam )
 		{
 			/*
-			if (apParticle->mvBeamPoints.size() == 0 )
+			if (pParticle->mvBeamPoints.size() == 0 )
 			{
 				for (int i = 0; i < (int) mpData->mvBeamNoisePoints.size(); ++i)
-					apParticle->mvBeamPoints.push_back(cVector(0.0f));
+					pParticle->mvBeamPoints.push_back(cVector(0.0f));
 			}
 
 
 			int j = 1;
-			cVector3f vLFPointPos = apParticle->mvPos + apParticle->mvVel * mpData->mvBeamNoisePoints.at(mpData->mvLFIndices[j]).fRelToBeamPos;
-			cVector3f vLastLFPointPos = apParticle->mvPos;
+			cVector3f vLFPointPos = particles.mvPos[alIdx] + particles.mvVel[alIdx] * mpData->mvBeamNoisePoints.at(mpData->mvLFIndices[j]).fRelToBeamPos;
+			cVector3f vLastLFPointPos = particles.mvPos[alIdx];
 			cVector3f vDir;
 			for ( int i = 1; i < (int) mpData->mvBeamNoisePoints.size(); ++i )
 			{
-				apParticle->mvBeamPoints[i] = vLastLFPointPos + vDir * mpData->mvBeamNoisePoints[i].fRelToBendPos;
+				pParticle->mvBeamPoints[i] = vLastLFPointPos + vDir * mpData->mvBeamNoisePoints[i].fRelToBendPos;
 
 				switch (mpData->mvBeamNoisePoints[i].noiseType)
 				{
 
 				case ePENoiseType_HighFreq:
-					apParticle->mvBeamPoints[i] += cMath::RandRectVector3f(mpData->mvMinHighFreqNoise, mpData->mvMaxHighFreqNoise);
+					pParticle->mvBeamPoints[i] += cMath::RandRectVector3f(mpData->mvMinHighFreqNoise, mpData->mvMaxHighFreqNoise);
 					break;
 				case ePENoiseType_LowFreq:
 					++j;
 					vLastLFPointPos = vLFPointPos;
-					vLFPointPos = apParticle->mvPos + apParticle->mvVel * mpData->mvBeamNoisePoints.at(mpData->mvLFIndices[j]).fRelToBeamPos + cMath::RandRectVector3f(mpData->mvMinLowFreqNoise, mpData->mvMaxLowFreqNoise);
+					vLFPointPos = particles.mvPos[alIdx] + particles.mvVel[alIdx] * mpData->mvBeamNoisePoints.at(mpData->mvLFIndices[j]).fRelToBeamPos + cMath::RandRectVector3f(mpData->mvMinLowFreqNoise, mpData->mvMaxLowFreqNoise);
 					vDir = vLFPointPos - vLastLFPointPos;
 					break;
 				case ePENoiseType_Both:
-					apParticle->mvBeamPoints[i] += cMath::RandRectVector3f(mpData->mvMinHighFreqNoise, mpData->mvMaxHighFreqNoise);
+					pParticle->mvBeamPoints[i] += cMath::RandRectVector3f(mpData->mvMinHighFreqNoise, mpData->mvMaxHighFreqNoise);
 					++j;
 					vLastLFPointPos = vLFPointPos;
-					vLFPointPos = apParticle->mvPos + apParticle->mvVel * mpData->mvBeamNoisePoints.at(mpData->mvLFIndices[j]).fRelToBeamPos + cMath::RandRectVector3f(mpData->mvMinLowFreqNoise, mpData->mvMaxLowFreqNoise);
+					vLFPointPos = particles.mvPos[alIdx] + particles.mvVel[alIdx] * mpData->mvBeamNoisePoints.at(mpData->mvLFIndices[j]).fRelToBeamPos + cMath::RandRectVector3f(mpData->mvMinLowFreqNoise, mpData->mvMaxLowFreqNoise);
 					vDir = vLFPointPos - vLastLFPointPos;
 					break;
 				default:
@@ -934,223 +927,255 @@ namespace hpl {
 
 		///////////////////////////////////////////
 		//Particle update
-		for(unsigned int i=0; i< mlNumOfParticles; ++i)
-		{
-			cParticle *pParticle = mvParticles[i];
+		cParticlePool &particles = mParticles;
+		int lNum = (int)mlNumOfParticles;
+
+		////////////
+		//Position, speed and life update
+		cVector3f vVelAdd(0);
+		if(mpData->mGravityType == ePEGravityType_Vector) vVelAdd = mpData->mvGravityAcc * afTimeStep;
 
-			////////////
-            //Position Update
-			pParticle->mvLastPos = pParticle->mvPos;
+		particles.Integrate(lNum, afTimeStep, vVelAdd);
 
-			pParticle->mvPos += pParticle->mvVel * afTimeStep;
+		////////////
+		//Per particle motion, only done for the features that are used
+		bool bCenterGravity = mpData->mGravityType == ePEGravityType_Center;
+		bool bMaxSpeed = mpData->mfMinVelMaximum > 0 || mpData->mfMaxVelMaximum > 0;
+		bool bSpeedMul = (mpData->mfMinSpeedMultiply != 0 || mpData->mfMaxSpeedMultiply != 0) &&
+						 (mpData->mfMinSpeedMultiply != 1 || mpData->mfMaxSpeedMultiply != 1);
 
-			////////////
-			//Speed Update
-			pParticle->mvVel += pParticle->mvAcc * afTimeStep;
+		if(bCenterGravity || bMaxSpeed || bSpeedMul || mpData->mbUsePartSpin || mbUseRevolution || bColliding)
+		{
+			cVector3f vCenter;
+			if(mpData->mCoordSystem == eParticleEmitterCoordSystem_World){
+				vCenter = GetWorldMatrix().GetTranslation();
+			}
+			else {
+				//Perhaps on mvPos is needed.. and no substraction.
+				vCenter = GetLocalMatrix().GetTranslation();
+			}
 
-			//gravity
-			switch(mpData->mGravityType)
+			for(int i=0; i<lNum; ++i)
 			{
-			case ePEGravityType_None:
+				cParticle *pParticle = &particles.mvData[i];
+				cVector3f &vPos = particles.mvPos[i];
+				cVector3f &vVel = particles.mvVel[i];
+
+				//gravity
+				if(bCenterGravity)
 				{
-					break;
+					cVector3f vDir = vPos - vCenter;
+					vDir.Normalize();
+
+					vVel += vDir * mpData->mvGravityAcc.y * afTimeStep;
 				}
-			case ePEGravityType_Vector:
+
+				if(pParticle->mfMaxSpeed > 0)
 				{
-					pParticle->mvVel += mpData->mvGravityAcc * afTimeStep;
-					break;
+					float fSpeed = vVel.Length();
+					if(fSpeed > pParticle->mfMaxSpeed)
+					{
+						vVel = (vVel / fSpeed) * pParticle->mfMaxSpeed;
+					}
 				}
-			case ePEGravityType_Center:
+
+				if(pParticle->mfSpeedMul!=0 && pParticle->mfSpeedMul!=1)
 				{
-					cVector3f vDir;
-					cMatrixf mtxStart;
-					if(mpData->mCoordSystem == eParticleEmitterCoordSystem_World){
-						vDir = pParticle->mvPos - GetWorldMatrix().GetTranslation();
-					}
-					else {
-						//Perhaps on mvPos is needed.. and no substraction.
-						vDir = pParticle->mvPos - GetLocalMatrix().GetTranslation();
-					}
+					vVel = vVel * pow(pParticle->mfSpeedMul,afTimeStep);
+				}
 
-					vDir.Normalize();
+				// NEW
+				///////////
+				//Spin Update
+				if (mpData->mbUsePartSpin)
+				{
+					float &fSpin = particles.mvSpin[i];
+					fSpin += pParticle->mfSpinVel * afTimeStep;
 
-					pParticle->mvVel += vDir * mpData->mvGravityAcc.y * afTimeStep;
+					if(mpData->mPartSpinType == ePEPartSpinType_Movement)
+						pParticle->mfSpinVel = vVel.Length() * pParticle->mfSpinFactor;
 
-					break;
+					if (fSpin >= k2Pif)
+						fSpin -= k2Pif;
+					else if (fSpin <= -k2Pif)
+						fSpin += k2Pif;
 				}
-			}
 
+				// ---
 
-			if(pParticle->mfMaxSpeed > 0)
-			{
-				float fSpeed = pParticle->mvVel.Length();
-				if(fSpeed > pParticle->mfMaxSpeed)
+				// NEW
+				// Revolution
+				if ( mbUseRevolution )
 				{
-					pParticle->mvVel = (pParticle->mvVel / fSpeed) * pParticle->mfMaxSpeed;
+					cMatrixf mtxRotationMatrix = cMath::MatrixRotate( pParticle->mvRevolutionVel * afTimeStep,  eEulerRotationOrder_XYZ );
+					vPos = cMath::MatrixMul(mtxRotationMatrix, vPos);
+					vVel = cMath::MatrixMul(mtxRotationMatrix, vVel);
 				}
-			}
 
-			if(pParticle->mfSpeedMul!=0 && pParticle->mfSpeedMul!=1)
-			{
-				pParticle->mvVel = pParticle->mvVel * pow(pParticle->mfSpeedMul,afTimeStep);
-			}
+				// ---
 
-			// NEW
-            ///////////
-			//Spin Update
-			if (mpData->mbUsePartSpin)
-			{
-				pParticle->mfSpin += pParticle->mfSpinVel * afTimeStep;
+				////////////
+				//Collison update
+				if(bColliding)
+				{
+					cVector3f vCollidePos, vNormal;
 
-				if (mpData->mPartSpinType == ePEPartSpinType_Movement)
-					pParticle->mfSpinVel = pParticle->mvVel.Length() * pParticle->mfSpinFactor;
+					if(mpData->CheckCollision(pParticle->mvLastCollidePos, vPos,
+												mpWorld->GetPhysicsWorld(),
+												&vNormal, &vCollidePos))
+					{
+						vPos = vCollidePos;
 
-				if (pParticle->mfSpin >= k2Pif)
-					pParticle->mfSpin -= k2Pif;
-				else if (pParticle->mfSpin <= -k2Pif)
-					pParticle->mfSpin += k2Pif;
+						float fSpeed = vVel.Length();
 
-			}
+						cVector3f vReflection = vVel - (vNormal * 2* cMath::Vector3Dot(vVel,vNormal));
+						vReflection.Normalize();
 
-			// ---
+						vVel = vReflection * (fSpeed * pParticle->mfBounceAmount);
 
-			// NEW
-			// Revolution
-			if ( mbUseRevolution )
+						pParticle->mlBounceCount--;
+						if(pParticle->mlBounceCount<=0)
+						{
+							particles.mvLife[i] =0;
+						}
+					}
+
+					pParticle->mvLastCollidePos = vPos;
+				}
+			}
+		}
+
+		////////////
+		//Dead particles are respawned or removed. Removed ones are replaced by the last particle, which is then checked too.
+		for(int i=0; i<(int)mlNumOfParticles; )
+		{
+			if(particles.mvLife[i] > 0)
 			{
-				//pParticle->mvRevolution += pParticle->mvRevolutionVel * afTimeStep;
-				cMatrixf mtxRotationMatrix = cMath::MatrixRotate( pParticle->mvRevolutionVel * afTimeStep,  eEulerRotationOrder_XYZ );
-				pParticle->mvPos = cMath::MatrixMul(mtxRotationMatrix, pParticle->mvPos);
-				pParticle->mvVel = cMath::MatrixMul(mtxRotationMatrix, pParticle->mvVel);
+				++i;
+				continue;
 			}
 
-			// ---
+			if(mbRespawn && mbPaused==false)
+			{
+				SetParticleDefaults(i);
+				++i;
+				continue;
+			}
 
+			SwapRemove(i);
 
-			////////////
-			//Collison update
-			if(bColliding)
+			if(mbRespawn==false)
 			{
-				cVector3f vPos, vNormal;
+				mlMaxParticles--;
 
-				if(mpData->CheckCollision(pParticle->mvLastCollidePos, pParticle->mvPos,
-											mpWorld->GetPhysicsWorld(),
-											&vNormal, &vPos))
+				if(mlMaxParticles <=0)
 				{
-					//Log("Coll pos: %s\n",vPos.ToString().c_str());
-					//Log("Coll normal: %s\n",vNormal.ToString().c_str());
-
-					pParticle->mvPos = vPos;
-
-					float fSpeed = pParticle->mvVel.Length();
-
-					cVector3f vReflection = pParticle->mvVel -
-											(vNormal * 2* cMath::Vector3Dot(pParticle->mvVel,vNormal));
-					vReflection.Normalize();
+					mbDying = true;
+				}
+			}
+		}
+		lNum = (int)mlNumOfParticles;
 
-					pParticle->mvVel = vReflection * (fSpeed * pParticle->mfBounceAmount);
+		////////////
+		//Subdiv, color and size update. The life based curves use the part of the life left, so the
+		//break points are the same for all particles.
+		const float *pLife = lNum > 0 ? &particles.mvLife[0] : NULL;
+		const float *pStartLife = lNum > 0 ? &particles.mvStartLife[0] : NULL;
 
-					pParticle->mlBounceCount--;
-					if(pParticle->mlBounceCount<=0)
-					{
-						pParticle->mfLife =0;
-					}
-				}
+		if(mpData->mSubDivType == ePESubDivType_Animation)
+		{
+			int *pSubDivNum = lNum > 0 ? &particles.mvSubDivNum[0] : NULL;
+			float fSubDivNum = (float)mvSubDivUV.size();
 
-				pParticle->mvLastCollidePos = pParticle->mvPos;
+			for(int i=0; i<lNum; ++i)
+			{
+				float fLifePercent = (1.0f - (pLife[i] / pStartLife[i]));
+				pSubDivNum[i] = (int)(fLifePercent * fSubDivNum - 0.0001f);
 			}
+		}
 
-			////////////
-			//Life Update
-			pParticle->mfLife -= afTimeStep;
+		////////////
+		//Color Update
+		{
+			const float fMiddleStart = 1 - mpData->mfMiddleRelColorTime;
+			const float fMiddleEnd = 1 - (mpData->mfMiddleRelColorTime + mpData->mfMiddleRelColorLength);
+			const cColor &startRel = mpData->mStartRelColor;
+			const cColor &middleRel = mpData->mMiddleRelColor;
+			const cColor &endRel = mpData->mEndRelColor;
+
+			const cColor *pStartColor = lNum > 0 ? &particles.mvStartColor[0] : NULL;
+			cColor *pColor = lNum > 0 ? &particles.mvColor[0] : NULL;
 
-			if(pParticle->mfLife <=0)
+			for(int i=0; i<lNum; ++i)
 			{
-				if(mbRespawn)
+				float fLeft = pLife[i] / pStartLife[i];
+
+				cColor relColor;
+				//Start
+				if(fLeft > fMiddleStart)
 				{
-					if(mbPaused)
-						SwapRemove(i);
-					else
-						SetParticleDefaults(pParticle);
+					float fT = (fLeft - fMiddleStart) / (1 - fMiddleStart);
+					relColor = startRel * fT + middleRel * (1-fT);
 				}
+				//Middle
+				else if(fLeft > fMiddleEnd)
+				{
+					relColor = middleRel;
+				}
+				//End
 				else
 				{
-					SwapRemove(i);
-					mlMaxParticles--;
-
-					if(mlMaxParticles <=0)
-					{
-						mbDying = true;
-					}
+					float fT = fLeft / fMiddleEnd;
+					relColor = middleRel * fT + endRel * (1-fT);
 				}
-			}
-
-			////////////
-			//Subdiv Update
-
-			if(mpData->mSubDivType == ePESubDivType_Animation)
-			{
-				float fLifePercent = (1.0f - (pParticle->mfLife / pParticle->mfStartLife));
-				pParticle->mlSubDivNum = (int)(fLifePercent * (float)mvSubDivUV.size() - 0.0001f);
-			}
-
-			////////////
-			//Color Update
-
-			//Start
-			if(pParticle->mfLife > pParticle->mfLifeColor_MiddleStart)
-			{
-				float fT = (pParticle->mfLife - pParticle->mfLifeColor_MiddleStart) /
-					       (pParticle->mfStartLife - pParticle->mfLifeColor_MiddleStart);
 
-				pParticle->mColor = (pParticle->mStartColor * mpData->mStartRelColor * fT) +
-									(pParticle->mStartColor * mpData->mMiddleRelColor * (1-fT));
-			}
-			//Middle
-			else if(pParticle->mfLife > pParticle->mfLifeColor_MiddleEnd)
-			{
-				pParticle->mColor = pParticle->mStartColor * mpData->mMiddleRelColor;
-			}
-			//End
-			else
-			{
-				float fT =	pParticle->mfLife / pParticle->mfLifeColor_MiddleEnd;
-
-				pParticle->mColor = (pParticle->mStartColor * mpData->mMiddleRelColor * fT) +
-									(pParticle->mStartColor * mpData->mEndRelColor * (1-fT));
+				pColor[i] = pStartColor[i] * relColor;
 			}
 
 			if(mpData->mbMultiplyRGBWithAlpha)
 			{
-				pParticle->mColor.r *= pParticle->mColor.a;
-				pParticle->mColor.g *= pParticle->mColor.a;
-				pParticle->mColor.b *= pParticle->mColor.a;
+				for(int i=0; i<lNum; ++i)
+				{
+					pColor[i].r *= pColor[i].a;
+					pColor[i].g *= pColor[i].a;
+					pColor[i].b *= pColor[i].a;
+				}
 			}
+		}
 
-			////////////
-			//Size Update
+		////////////
+		//Size Update
+		{
+			const float fMiddleStart = 1 - mpData->mfMiddleRelSizeTime;
+			const float fMiddleEnd = 1 - (mpData->mfMiddleRelSizeTime + mpData->mfMiddleRelSizeLength);
 
-			//Start
-			if(pParticle->mfLife > pParticle->mfLifeSize_MiddleStart)
-			{
-				float fT = (pParticle->mfLife - pParticle->mfLifeSize_MiddleStart) /
-							(pParticle->mfStartLife - pParticle->mfLifeSize_MiddleStart);
+			const cVector2f *pStartSize = lNum > 0 ? &particles.mvStartSize[0] : NULL;
+			cVector2f *pSize = lNum > 0 ? &particles.mvSize[0] : NULL;
 
-				pParticle->mvSize = (pParticle->mvStartSize * mpData->mfStartRelSize * fT) +
-									(pParticle->mvStartSize * mpData->mfMiddleRelSize * (1-fT));
-			}
-			//Middle
-			else if(pParticle->mfLife > pParticle->mfLifeSize_MiddleEnd)
+			for(int i=0; i<lNum; ++i)
 			{
-				pParticle->mvSize = pParticle->mvStartSize * mpData->mfMiddleRelSize;
-			}
-			//End
-			else
-			{
-				float fT =	pParticle->mfLife / pParticle->mfLifeSize_MiddleEnd;
+				float fLeft = pLife[i] / pStartLife[i];
+
+				float fRelSize;
+				//Start
+				if(fLeft > fMiddleStart)
+				{
+					float fT = (fLeft - fMiddleStart) / (1 - fMiddleStart);
+					fRelSize = mpData->mfStartRelSize * fT + mpData->mfMiddleRelSize * (1-fT);
+				}
+				//Middle
+				else if(fLeft > fMiddleEnd)
+				{
+					fRelSize = mpData->mfMiddleRelSize;
+				}
+				//End
+				else
+				{
+					float fT = fLeft / fMiddleEnd;
+					fRelSize = mpData->mfMiddleRelSize * fT + mpData->mfEndRelSize * (1-fT);
+				}
 
-				pParticle->mvSize = (pParticle->mvStartSize * mpData->mfMiddleRelSize * fT) +
-									(pParticle->mvStartSize * mpData->mfEndRelSize * (1-fT));
+				pSize[i] = pStartSize[i] * fRelSize;
 			}
 		}
 
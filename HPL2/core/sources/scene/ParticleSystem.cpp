@@ -96,7 +96,7 @@ namespace hpl {
 		SetFullPath(asFile);
 
 		iXmlDocument* pXmlDoc = mpResources->GetLowLevel()->CreateXmlDocument();
-		if(pXmlDoc->CreateFromFile(asFile)==false)
+		if(pXmlDoc->CreateFromFile(asFile, true)==false)
 		{
 			hplDelete(pXmlDoc);
 			return false;
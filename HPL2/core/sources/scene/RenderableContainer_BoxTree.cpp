@@ -24,9 +24,16 @@
 #include "graphics/LowLevelGraphics.h"
 
 #include "system/LowLevelSystem.h"
+#include "system/Platform.h"
+
+#include "math/Frustum.h"
 
 #include <algorithm>
 
+#ifdef HPL_USE_SSE
+	#include <xmmintrin.h>
+#endif
+
 namespace hpl {
 
 	//////////////////////////////////////////////////////////////////////////
@@ -142,6 +149,16 @@ namespace hpl {
 		//////////////////////////////
 		//Build the actual node tree from temp nodes
 		BuildNodeFromTemp(&tempRoot, mpRoot,0);
+
+		//////////////////////////////
+		//Build the flat packets used for culling, root is alone in the first one.
+		mvFlatPackets.clear();
+		mvFlatObjects.clear();
+		mvFlatObjects.reserve(m_mlstTempObjects.size());
+
+		tRenderableContainerNodeList lstRoot;
+		lstRoot.push_back(mpRoot);
+		BuildFlatPacket(&lstRoot);
 	}
 
 	//-----------------------------------------------------------------------
@@ -173,6 +190,148 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	/**
+	 * Tests all nodes in the packet against the planes. Returns a mask with a bit set for each node that is outside of
+	 * any plane, alIntersectMask gets a bit set for each node that is crossed by any plane.
+	 */
+	static int CollidePacketWithPlanes(const cBoxTreeFlatPacket &aPacket, const cPlanef *apPlanes, int alPlaneNum, int &alIntersectMask)
+	{
+		int lOutsideMask =0;
+		int lIntersectMask =0;
+
+	#ifdef HPL_USE_SSE
+		const __m128 vZero = _mm_setzero_ps();
+		const __m128 vMinX = _mm_loadu_ps(aPacket.mvMinX), vMinY = _mm_loadu_ps(aPacket.mvMinY), vMinZ = _mm_loadu_ps(aPacket.mvMinZ);
+		const __m128 vMaxX = _mm_loadu_ps(aPacket.mvMaxX), vMaxY = _mm_loadu_ps(aPacket.mvMaxY), vMaxZ = _mm_loadu_ps(aPacket.mvMaxZ);
+
+		for(int i=0; i<alPlaneNum; ++i)
+		{
+			const cPlanef &plane = apPlanes[i];
+
+			//The corner furthest along the normal (P) decides outside, the closest one (N) decides intersection.
+			__m128 vA = _mm_set1_ps(plane.a);
+			__m128 vB = _mm_set1_ps(plane.b);
+			__m128 vC = _mm_set1_ps(plane.c);
+			__m128 vD = _mm_set1_ps(plane.d);
+
+			__m128 vDistP = _mm_add_ps(	_mm_add_ps(_mm_mul_ps(vA, plane.a > 0 ? vMaxX : vMinX), _mm_mul_ps(vB, plane.b > 0 ? vMaxY : vMinY)),
+										_mm_add_ps(_mm_mul_ps(vC, plane.c > 0 ? vMaxZ : vMinZ), vD));
+			__m128 vDistN = _mm_add_ps(	_mm_add_ps(_mm_mul_ps(vA, plane.a > 0 ? vMinX : vMaxX), _mm_mul_ps(vB, plane.b > 0 ? vMinY : vMaxY)),
+										_mm_add_ps(_mm_mul_ps(vC, plane.c > 0 ? vMinZ : vMaxZ), vD));
+
+			lOutsideMask |= _mm_movemask_ps(_mm_cmplt_ps(vDistP, vZero));
+			lIntersectMask |= _mm_movemask_ps(_mm_cmplt_ps(vDistN, vZero));
+		}
+	#else
+		for(int i=0; i<alPlaneNum; ++i)
+		{
+			const cPlanef &plane = apPlanes[i];
+
+			for(int lNode=0; lNode<aPacket.mlNodeNum; ++lNode)
+			{
+				float fDistP = plane.a * (plane.a > 0 ? aPacket.mvMaxX[lNode] : aPacket.mvMinX[lNode]) +
+								plane.b * (plane.b > 0 ? aPacket.mvMaxY[lNode] : aPacket.mvMinY[lNode]) +
+								plane.c * (plane.c > 0 ? aPacket.mvMaxZ[lNode] : aPacket.mvMinZ[lNode]) + plane.d;
+				float fDistN = plane.a * (plane.a > 0 ? aPacket.mvMinX[lNode] : aPacket.mvMaxX[lNode]) +
+								plane.b * (plane.b > 0 ? aPacket.mvMinY[lNode] : aPacket.mvMaxY[lNode]) +
+								plane.c * (plane.c > 0 ? aPacket.mvMinZ[lNode] : aPacket.mvMaxZ[lNode]) + plane.d;
+
+				if(fDistP < 0) lOutsideMask |= 1 << lNode;
+				if(fDistN < 0) lIntersectMask |= 1 << lNode;
+			}
+		}
+	#endif
+
+		alIntersectMask = lIntersectMask;
+		return lOutsideMask;
+	}
+
+	//-----------------------------------------------------------------------
+
+	class cBoxTreeFlatStackEntry
+	{
+	public:
+		cBoxTreeFlatStackEntry(int alPacket, eCollision aCollision) : mlPacket(alPacket), mCollision(aCollision){}
+
+		int mlPacket;
+		eCollision mCollision;
+	};
+
+	bool cRenderableContainer_BoxTree::GetFrustumObjectRanges(cFrustum *apFrustum, const cPlanef *apCullPlanes, int alCullPlaneNum,
+															tRenderableContainerObjectRangeVec &avRanges,
+															iRenderableContainerNodeFilter *apNodeFilter)
+	{
+		avRanges.resize(0);
+		if(mvFlatPackets.empty()) return false;
+
+		cPlanef vFrustumPlanes[eFrustumPlane_LastEnum];
+		int lFrustumPlaneNum = apFrustum->GetInfFarPlane() ? 5 : 6;
+		for(int i=0; i<lFrustumPlaneNum; ++i) vFrustumPlanes[i] = apFrustum->GetPlane((eFrustumPlane)i);
+
+		std::vector<cBoxTreeFlatStackEntry> vStack;
+		vStack.reserve(64);
+		vStack.push_back(cBoxTreeFlatStackEntry(0, eCollision_Intersect));
+
+		while(vStack.empty()==false)
+		{
+			cBoxTreeFlatStackEntry entry = vStack.back();
+			vStack.pop_back();
+
+			for(int lPacket = entry.mlPacket; lPacket >= 0; lPacket = mvFlatPackets[lPacket].mlNextPacket)
+			{
+				const cBoxTreeFlatPacket &packet = mvFlatPackets[lPacket];
+				int lUsedMask = (1 << packet.mlNodeNum) -1;
+
+				////////////////////////////
+				//Frustum test, skipped if parent was inside
+				int lIntersectMask =0;
+				int lOutsideMask =0;
+				if(entry.mCollision != eCollision_Inside)
+					lOutsideMask = CollidePacketWithPlanes(packet, vFrustumPlanes, lFrustumPlaneNum, lIntersectMask);
+
+				/////////////////////////////
+				//Cull plane test, only removes nodes.
+				if(alCullPlaneNum > 0 && (lOutsideMask & lUsedMask) != lUsedMask)
+				{
+					int lCullIntersectMask;
+					lOutsideMask |= CollidePacketWithPlanes(packet, apCullPlanes, alCullPlaneNum, lCullIntersectMask);
+				}
+
+				/////////////////////////////
+				//Add objects and children of nodes not outside
+				for(int lNode=0; lNode<packet.mlNodeNum; ++lNode)
+				{
+					if(lOutsideMask & (1 << lNode)) continue;
+
+					if(apNodeFilter && apNodeFilter->IsNodeVisible(
+											cVector3f(packet.mvMinX[lNode], packet.mvMinY[lNode], packet.mvMinZ[lNode]),
+											cVector3f(packet.mvMaxX[lNode], packet.mvMaxY[lNode], packet.mvMaxZ[lNode]))==false)
+					{
+						continue;
+					}
+
+					eCollision collision = (lIntersectMask & (1 << lNode)) ? eCollision_Intersect : eCollision_Inside;
+
+					if(packet.mvObjectNum[lNode] > 0)
+					{
+						cRenderableContainerObjectRange range;
+						range.mpObjects = &mvFlatObjects[packet.mvObjectStart[lNode]];
+						range.mlObjectNum = packet.mvObjectNum[lNode];
+						range.mFrustumCollision = collision;
+						avRanges.push_back(range);
+					}
+
+					if(packet.mvChildPacket[lNode] >= 0)
+						vStack.push_back(cBoxTreeFlatStackEntry(packet.mvChildPacket[lNode], collision));
+				}
+			}
+		}
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------
+
 	//////////////////////////////////////////////////////////////////////////
 	// PRIVATE METHODS
 	//////////////////////////////////////////////////////////////////////////
@@ -700,6 +859,73 @@ namespace hpl {
 	   }
 	}
 
+	//-----------------------------------------------------------------------
+
+	/**
+	 * Creates packets for the nodes in the list (more than one if there are more than four nodes) and returns index of the first.
+	 */
+	int cRenderableContainer_BoxTree::BuildFlatPacket(tRenderableContainerNodeList *apNodeList)
+	{
+		int lFirstPacket = -1;
+		int lPacket = -1;
+
+		tRenderableContainerNodeListIt it = apNodeList->begin();
+		for(int lCount=0; it != apNodeList->end(); ++it, ++lCount)
+		{
+			iRenderableContainerNode *pNode = *it;
+
+			////////////////////////////
+			//Start a new packet, unused slots get an inverted box that is outside of any plane.
+			int lNode = lCount % 4;
+			if(lNode==0)
+			{
+				cBoxTreeFlatPacket packet;
+				for(int i=0; i<4; ++i)
+				{
+					packet.mvMinX[i] = packet.mvMinY[i] = packet.mvMinZ[i] = 1e30f;
+					packet.mvMaxX[i] = packet.mvMaxY[i] = packet.mvMaxZ[i] = -1e30f;
+					packet.mvChildPacket[i] = -1;
+					packet.mvObjectStart[i] =0;
+					packet.mvObjectNum[i] =0;
+				}
+				packet.mlNodeNum =0;
+				packet.mlNextPacket = -1;
+
+				int lNewPacket = (int)mvFlatPackets.size();
+				mvFlatPackets.push_back(packet);
+
+				if(lPacket >= 0)	mvFlatPackets[lPacket].mlNextPacket = lNewPacket;
+				else				lFirstPacket = lNewPacket;
+				lPacket = lNewPacket;
+			}
+
+			////////////////////////////
+			//Bounds and objects
+			const cVector3f& vMin = pNode->GetMin();
+			const cVector3f& vMax = pNode->GetMax();
+			int lObjectStart = (int)mvFlatObjects.size();
+
+			tRenderableListIt objIt = pNode->GetObjectList()->begin();
+			for(; objIt != pNode->GetObjectList()->end(); ++objIt)
+			{
+				mvFlatObjects.push_back(*objIt);
+			}
+
+			//Build children first, the vector might grow so do not hold any reference to the packet.
+			int lChildPacket = pNode->HasChildNodes() ? BuildFlatPacket(pNode->GetChildNodeList()) : -1;
+
+			cBoxTreeFlatPacket &packet = mvFlatPackets[lPacket];
+			packet.mvMinX[lNode] = vMin.x; packet.mvMinY[lNode] = vMin.y; packet.mvMinZ[lNode] = vMin.z;
+			packet.mvMaxX[lNode] = vMax.x; packet.mvMaxY[lNode] = vMax.y; packet.mvMaxZ[lNode] = vMax.z;
+			packet.mvChildPacket[lNode] = lChildPacket;
+			packet.mvObjectStart[lNode] = lObjectStart;
+			packet.mvObjectNum[lNode] = (int)mvFlatObjects.size() - lObjectStart;
+			packet.mlNodeNum = lNode+1;
+		}
+
+		return lFirstPacket;
+	}
+
 	//-----------------------------------------------------------------------
 	static cColor LevelColor[10] = {cColor(1,1,1),cColor(1,0,1),cColor(1,1,0),cColor(0,1,1),cColor(0,0,1),cColor(0,1,0),cColor(1,0,0),cColor(1,0.5f,1),
 									cColor(1,1,0.5f), cColor(1,0.5f,0.5f)};
@@ -16,7 +16,6 @@
  * You should have received a copy of the GNU General Public License
  * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
  */
-
 #include "scene/RenderableContainer_DynBoxTree.h"
 
 #include "graphics/Renderable.h"
@@ -27,8 +26,6 @@
 
 #include "math/Math.h"
 
-#include <algorithm>
-
 namespace hpl {
 
 	//////////////////////////////////////////////////////////////////////////
@@ -46,88 +43,63 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
-	static tString gsTempSpaces="";
-
-	static const char *GetSpaces(int alNum)
+	/**
+	 * Half the surface area, only used for comparisons so the factor does not matter.
+	 */
+	static inline float SurfaceArea(const cVector3f& avMin, const cVector3f& avMax)
 	{
-		gsTempSpaces.resize(alNum,'\t');
-		return gsTempSpaces.c_str();
+		cVector3f vSize = avMax - avMin;
+		return vSize.x*vSize.y + vSize.y*vSize.z + vSize.z*vSize.x;
 	}
 
-	//-----------------------------------------------------------------------
-
-	static bool TestAndExpandNodeAABB(iRenderable *apObject, cVector3f& avNodeMin,cVector3f& avNodeMax)
+	static inline float CombinedSurfaceArea(const cVector3f& avMinA, const cVector3f& avMaxA, const cVector3f& avMinB, const cVector3f& avMaxB)
 	{
-		const cVector3f &vMin = apObject->GetBoundingVolume()->GetMin();
-		const cVector3f &vMax = apObject->GetBoundingVolume()->GetMax();
+		cVector3f vMin = avMinA;
+		cVector3f vMax = avMaxA;
+		cMath::ExpandAABB(vMin, vMax, avMinB, avMaxB);
 
-		//////////////////////////////////
-		//Check if object is inside
-		if(cMath::CheckAABBInside(vMin,vMax, avNodeMin, avNodeMax)) return false;
+		return SurfaceArea(vMin, vMax);
+	}
 
-		//////////////////////////////////
-		//Calculate the new AABB
-		cMath::ExpandAABB(avNodeMin, avNodeMax, vMin, vMax);
+	//-----------------------------------------------------------------------
 
-		return true;
+	/**
+	 * Checks if moving a grand child up and a child down keeps the node within a height difference of one.
+	 */
+	static inline bool RotationKeepsBalance(int alUpHeight, int alDownHeight, int alStayHeight)
+	{
+		int lNewChildHeight = 1 + cMath::Max(alDownHeight, alStayHeight);
+		return cMath::Abs(alUpHeight - lNewChildHeight) <= 1;
 	}
 
 	//-----------------------------------------------------------------------
 
-	static bool CheckObjectIsAtEdgeOfAABB(iRenderable *apObject, const cVector3f& avNodeMin, const cVector3f& avNodeMax)
+	static void CalculateFatAABB(	const cVector3f& avMin, const cVector3f& avMax, float afMargin, float afSizeMul,
+									cVector3f& avFatMin, cVector3f& avFatMax)
 	{
-		const cVector3f &vMin = apObject->GetBoundingVolume()->GetMin();
-		const cVector3f &vMax = apObject->GetBoundingVolume()->GetMax();
-
-		//if(	vMin.x == avNodeMin.x || vMin.y == avNodeMin.y || vMin.z == avNodeMin.z ||
-		//	vMax.x == avNodeMax.x || vMax.y == avNodeMax.y || vMax.z == avNodeMax.z)
-		if(	cMath::Abs(vMin.x - avNodeMin.x)<kEpsilonf ||
-			cMath::Abs(vMin.y - avNodeMin.y)<kEpsilonf ||
-			cMath::Abs(vMin.z - avNodeMin.z)<kEpsilonf ||
-
-			cMath::Abs(vMax.x - avNodeMax.x)<kEpsilonf ||
-			cMath::Abs(vMax.y - avNodeMax.y)<kEpsilonf ||
-			cMath::Abs(vMax.z - avNodeMax.z)<kEpsilonf)
-		{
-			return true;
-		}
+		cVector3f vMargin = (avMax - avMin) * afSizeMul + cVector3f(afMargin);
 
-		return false;
+		avFatMin = avMin - vMargin;
+		avFatMax = avMax + vMargin;
 	}
 
 	//-----------------------------------------------------------------------
 
-	//0=x, 1=y, 2=z
-	static float GetAxisFromVec(const cVector3f& avVec, int alAxis)
+	static void PushUpNeedPropertyUpdate(iRenderableContainerNode *apNode)
 	{
-		switch(alAxis)
+		for(; apNode; apNode = apNode->GetParent())
 		{
-		case 0: return avVec.x;
-		case 1: return avVec.y;
-		case 2: return avVec.z;
+			apNode->SetNeedPropertyUpdate(true);
 		}
-
-		return 0;
 	}
 
 	//-----------------------------------------------------------------------
 
-	static bool SortFunc_X(iRenderable* apObjectA, iRenderable *apObjectB)
+	static inline void SetSphereFromAABB(const cVector3f& avMin, const cVector3f& avMax, cVector3f& avCenter, float& afRadius)
 	{
-		return apObjectA->GetBoundingVolume()->GetWorldCenter().x < apObjectB->GetBoundingVolume()->GetWorldCenter().x;
+		avCenter = (avMax + avMin) *0.5f;
+		afRadius = (avMax - avMin).Length()*0.5f;
 	}
-	static bool SortFunc_Y(iRenderable* apObjectA, iRenderable *apObjectB)
-	{
-		return apObjectA->GetBoundingVolume()->GetWorldCenter().y < apObjectB->GetBoundingVolume()->GetWorldCenter().y;
-	}
-	static bool SortFunc_Z(iRenderable* apObjectA, iRenderable *apObjectB)
-	{
-		return apObjectA->GetBoundingVolume()->GetWorldCenter().z < apObjectB->GetBoundingVolume()->GetWorldCenter().z;
-	}
-
-	typedef bool (*tSortFunc)(iRenderable*,iRenderable*);
-	static tSortFunc gvSortFunctions[3] = {SortFunc_X, SortFunc_Y,SortFunc_Z};
-
 
 	//-----------------------------------------------------------------------
 
@@ -165,453 +137,65 @@ namespace hpl {
 	cRCNode_DynBoxTree::cRCNode_DynBoxTree()
 	{
 		mpParent = NULL;
-		mbRecalculateSplit = false;
-		mbRecalculateAABB = false;
+		mpContainer = NULL;
 
-		mbIsSplit = false;
-		mbObjectMoved = false;
+		mpChild[0] = NULL;
+		mpChild[1] = NULL;
+		mpObject = NULL;
 
-		mbRecalculateSplitAxis = true;
-		mlSplitAxis = -1;
-		mfSplitPlane =0;
+		mvFatMin =0;
+		mvFatMax =0;
+		mlHeight =0;
 
 		mbUsesFlagsAndVisibility = false;
-
-		mlGarbageCollectCount =0;
-		mlIgnoreSplitCount =0;
-
-		mvMeanPosition =0;
 	}
 
 	//-----------------------------------------------------------------------
 
 	cRCNode_DynBoxTree::~cRCNode_DynBoxTree()
 	{
-		//Log("Deleting %d\n", this);
-		STLDeleteAll(mlstChildNodes);
+		//Nodes are owned by the pool in the container
 	}
 
 	//-----------------------------------------------------------------------
 
-	void cRCNode_DynBoxTree::UpdateBeforeUse()
+	void cRCNode_DynBoxTree::SetChild(int alIdx, cRCNode_DynBoxTree *apChild)
 	{
-		//////////////////////////////////
-		// Garbage collect check
-		//  Use the var mbRecalculateSplit to see if anything has changed, else there is no use in a garbage collection.
-		if(mbObjectMoved)
-		{
-			//////////////
-			//Time for collection, counter is done
-			if(mlGarbageCollectCount <=0)
-			{
-				if(gbLog){
-					Log(" Check garbage collecion for node %d\n", this);
-				}
-
-				mlGarbageCollectCount = mpContainer->mlMaxGarbageCollectCount;
-
-				////////////////////////////////////////
-				// Make sure AABB is updated and as tight as possible
-				mbRecalculateAABB = true;
-
-				///////////////////////////////////////////
-				//Check if any child nodes are leaves and if so the total number of objects are
-				// less then split threshold. If so, delete that node.
-				if(HasChildNodes())
-				{
-					cRCNode_DynBoxTree *pChild1 = static_cast<cRCNode_DynBoxTree*>(mlstChildNodes.front());
-					cRCNode_DynBoxTree *pChild2 = static_cast<cRCNode_DynBoxTree*>(mlstChildNodes.back());
-
-					//What lower limit is best really?
-					int lLowerObjectLimit = mpContainer->mlSplitThreshold;
-					//int lLowerObjectLimit = (mpContainer->mlSplitThreshold*2)/3;
-					//int lLowerObjectLimit = mpContainer->mlSplitThreshold - 2;
-
-					//Check if nodes are leaves and if they have few enough objects
-					if(	pChild1->HasChildNodes()==false && pChild2->HasChildNodes()==false &&
-						(pChild1->GetObjectNum() + pChild2->GetObjectNum() + GetObjectNum() < lLowerObjectLimit))
-					{
-						if(gbLog){
-							Log("  Collection garbage!\n");
-						}
-
-						//Iterate child nodes
-						tRenderableContainerNodeListIt nodeIt = mlstChildNodes.begin();
-						for(; nodeIt != mlstChildNodes.end(); ++nodeIt)
-						{
-							//Copy child object to this node
-							cRCNode_DynBoxTree *pChildNode = static_cast<cRCNode_DynBoxTree*>(*nodeIt);
-
-							tRenderableListIt objIt = pChildNode->mlstObjects.begin();
-							for(; objIt != pChildNode->mlstObjects.end(); ++objIt)
-							{
-								iRenderable *pObject = *objIt;
-
-								pObject->SetRenderContainerNode(this);
-								mlstObjects.push_back(pObject);
-							}
-						}
-
-						STLDeleteAll(mlstChildNodes);
-						mbIsSplit = false;	//Reset that it is split;
-						mbRecalculateSplitAxis = true;	//Need a new split axis!
-					}
-				}
-
-
-				/////////////////////////////
-				//Recalculate the split axis this time if there is enough objects
-				// or if a node was deleted.
-				if((int)mlstObjects.size() >= mpContainer->mlSplitThreshold)
-				{
-					mbRecalculateSplitAxis = true;
-				}
-			}
-			////////////////
-			//Just decrement the counter.
-			else
-			{
-				--mlGarbageCollectCount;
-			}
-		}
-
-
-		//////////////////////////////////
-		// AABB update
-		if(mbRecalculateAABB)
-		{
-			if(gbLog){
-				Log(" Recalculating AABB for node %d\n", this);
-			}
-
-			mbRecalculateAABB = false;
-
-			//Calculate the AABB based on the objects (if any)
-			if(HasObjects()) CalculateMinMaxFromObjects();
-
-			//Increase the AABB based on children.
-			if(HasChildNodes())
-			{
-				cRCNode_DynBoxTree* pNodeA = static_cast<cRCNode_DynBoxTree*>(mlstChildNodes.front());
-				cRCNode_DynBoxTree* pNodeB = static_cast<cRCNode_DynBoxTree*>(mlstChildNodes.back());
-
-				cMath::ExpandAABB(mvMin,mvMax, pNodeA->GetMin(), pNodeA->GetMax());
-				cMath::ExpandAABB(mvMin,mvMax, pNodeB->GetMin(), pNodeB->GetMax());
-			}
-
-			//Sphere center and radius
-			mvCenter = (mvMax + mvMin) *0.5f;
-			mfRadius = (mvMax - mvMin).Length()*0.5f;
-		}
+		mpChild[alIdx] = apChild;
+		apChild->mpParent = this;
 
-		//////////////////////////////////
-		// Check if a recalculate of split axis is really needed.
-		if(mbRecalculateSplit)
+		//////////////////////////
+		// Keep the list used by the renderer in the same order. New nodes always get child 0 first.
+		if((int)mlstChildNodes.size() > alIdx)
 		{
-			if(GetObjectNum() < mpContainer->mlSplitThreshold && HasChildNodes()==false)
-			{
-				mbRecalculateSplit = false;
-			}
+			tRenderableContainerNodeListIt it = mlstChildNodes.begin();
+			if(alIdx==1) ++it;
+			*it = apChild;
 		}
 		else
 		{
-			//Always recalculate the split plane before a split
-			if(mbIsSplit==false && GetObjectNum() >= mpContainer->mlSplitThreshold)
-			{
-				mbRecalculateSplit = true;
-			}
-		}
-
-		//////////////////////////////////
-		// Recalculate the split properties
-		if(mbRecalculateSplit)
-		{
-			if(gbLog){
-				Log(" Recalculating split for node %d\n", this);
-			}
-
-			mbRecalculateSplit = false;
-
-			////////////////////////////////////////
-			// Get the split axis (only do once or else the tree will become a mess!)
-			if(mbRecalculateSplitAxis)
-			{
-				mbRecalculateSplitAxis = false;
-
-				cVector3f vNodeSize = mvMax - mvMin;
-
-				float fLongestSide = vNodeSize.x;
-				mlSplitAxis =0;
-				if(fLongestSide < vNodeSize.y){
-					fLongestSide = vNodeSize.y;
-					mlSplitAxis = 1;
-				}
-				if(fLongestSide < vNodeSize.z){
-					fLongestSide = vNodeSize.z;
-					mlSplitAxis = 2;
-				}
-			}
-
-			////////////////////////////////////////
-			// Calculate the split plane by taking the average of all objects's centers
-			// and the nodes split planes (but with more weight(.
-
-			/*cVector3f vPosSum=0;
-			float fWeightSum=0;
-
-			//Objects
-			if(mlstObjects.empty()==false)
-			{
-				tRenderableListIt it = mlstObjects.begin();
-				for(; it != mlstObjects.end(); ++it)
-				{
-					iRenderable *pObject = *it;
-
-					vPosSum += 	pObject->GetBoundingVolume()->GetPosition();
-					fWeightSum += 1;
-				}
-			}
-
-			//Nodes
-			if(HasChildNodes())
-			{
-				tRenderableContainerNodeListIt it = mlstChildNodes.begin();
-				for(; it != mlstChildNodes.end(); ++it)
-				{
-					cRCNode_DynBoxTree *pChildNode = static_cast<cRCNode_DynBoxTree*>(*it);
-
-					float fObjNum = (float)pChildNode->mlstObjects.size();
-					vPosSum += pChildNode->mvMeanPosition * fObjNum;
-                    fWeightSum += fObjNum;
-				}
-			}
-
-			mvMeanPosition = vPosSum / fWeightSum;
-            mfSplitPlane = mvMeanPosition.v[mlSplitAxis];*/
-
-
-
-			float fPosSum =0;
-			float fWeightSum = 0;
-
-			//Objects
-			if(mlstObjects.empty()==false)
-			{
-				tRenderableListIt it = mlstObjects.begin();
-				for(; it != mlstObjects.end(); ++it)
-				{
-					iRenderable *pObject = *it;
-
-					fPosSum += 	GetAxisFromVec(pObject->GetBoundingVolume()->GetPosition(), mlSplitAxis);
-					fWeightSum += 1;
-				}
-			}
-
-			//Nodes
-			if(HasChildNodes())
-			{
-				float fPosMul = (float)mpContainer->mlSplitThreshold;
-				tRenderableContainerNodeListIt it = mlstChildNodes.begin();
-                for(; it != mlstChildNodes.end(); ++it)
-				{
-					cRCNode_DynBoxTree *pChildNode = static_cast<cRCNode_DynBoxTree*>(*it);
-
-					//Use split plane if axes are the same
-                    if(pChildNode->mlSplitAxis == mlSplitAxis)
-					{
-						fPosSum += pChildNode->mfSplitPlane * fPosMul;
-						fWeightSum += fPosMul;
-					}
-					//Else just use AABB center
-					else
-					{
-						fPosSum += pChildNode->mvCenter.v[mlSplitAxis] * fPosMul;
-						fWeightSum += fPosMul;
-					}
-				}
-			}
-
-            mfSplitPlane = fPosSum / fWeightSum;
-		}
-
-
-		//////////////////////////////////
-		// If enough objects, create children and objects to them.
-		// Also make sure that the node does not already have childe nodes!
-        if(	(int)mlstObjects.size() >= mpContainer->mlSplitThreshold &&
-			HasChildNodes()==false)
-		{
-			/////////////
-			//Check if tree has already been split
-			if(mbIsSplit)
-			{
-				//There has been any object changes in thenode, lower the ignore split count
-				// this will mean that split can be recalculated later on, but not very often.
-                if(mbObjectMoved)
-				{
-					mlIgnoreSplitCount--;
-					if(mlIgnoreSplitCount <=0)
-					{
-						mbIsSplit = false;
-					}
-				}
-			}
-			/////////////
-			// Tree is really in need of split
-			else
-			{
-				if(gbLog){
-					Log(" Splitting node %d\n", this);
-					Log(" --------------------\n", this);
-				}
-
-				mbIsSplit = true;
-				mlIgnoreSplitCount = mpContainer->mlMaxIgnoreSplitCount;
-
-				///////////////////////////////////
-				// Setup before objects are added
-				cVector3f vNodeSize = GetMax() - GetMin();
-
-				std::vector<iRenderable*> vTempObjects;
-				vTempObjects.resize(mlstObjects.size());
-
-				int lCount =0;
-				for(tRenderableListIt it = mlstObjects.begin(); it != mlstObjects.end(); ++it,++lCount)
-				{
-					vTempObjects[lCount] = *it;
-				}
-
-				mlstObjects.clear();
-
-				tRenderableList lstChildObjects[2];
-
-
-				///////////////////////////////////
-				// Iterate
-				for(size_t i=0; i<vTempObjects.size(); ++i)
-				{
-					iRenderable *pObject = vTempObjects[i];
-
-					int lSplitGroup = mpContainer->GetSplitGroup(pObject,mfSplitPlane, mlSplitAxis ,vNodeSize);
-
-					/////////////////////////////
-					// If object is intersecting then add to this node, else add to a child.
-					if(lSplitGroup == 2)
-					{
-						mlstObjects.push_back(pObject);
-						if(gbLog){
-							Log("  Object '%s'/%d stay put\n", pObject->GetName().c_str(), pObject);
-						}
-					}
-					else
-					{
-						//Add to child list
-						lstChildObjects[lSplitGroup].push_back(pObject);
-						if(gbLog){
-							Log("  Object '%s'/%d moved to node %d\n", pObject->GetName().c_str(), pObject, lSplitGroup);
-						}
-					}
-				}
-
-				//////////////////////////////////
-				// If either child object list is empty, add objects back to node
-				if(lstChildObjects[0].empty() ||  lstChildObjects[1].empty())
-				{
-					for(int i=0; i<2; ++i)
-					for(tRenderableListIt it = lstChildObjects[i].begin(); it != lstChildObjects[i].end(); ++it)
-					{
-						mlstObjects.push_back(*it);
-					}
-				}
-				//////////////////////////////////
-				// If split worked, create child nodes and add objects to them
-				else
-				{
-					///////////////////////////////////
-					// Create and setup child nodes
-					// Make sure to create mean position here too! ( can remove later on?)
-					for(int i=0; i<2; ++i)
-					{
-						cRCNode_DynBoxTree* pChildNode = hplNew( cRCNode_DynBoxTree, () );
-						pChildNode->mpContainer = mpContainer;
-						pChildNode->mpParent = this;
-
-						mlstChildNodes.push_back(pChildNode);
-
-                        pChildNode->mvMeanPosition =0;
-						for(tRenderableListIt it = lstChildObjects[i].begin(); it != lstChildObjects[i].end(); ++it)
-						{
-							iRenderable *pObject = *it;
-
-							pChildNode->mlstObjects.push_back(pObject);
-
-							pChildNode->mvMeanPosition += pObject->GetBoundingVolume()->GetWorldCenter();
-
-							//Set new node to object
-							pObject->SetRenderContainerNode(pChildNode);
-						}
-
-						pChildNode->mvMeanPosition = pChildNode->mvMeanPosition / (float)lstChildObjects[i].size();
-
-						pChildNode->RecalculateSplit();
-						pChildNode->RecalculateAABB();
-
-						/////////////////////////////////////
-						//Just to be extra sure, caclulate proper AABB directly!
-						pChildNode->CalculateMinMaxFromObjects();
-						//Sphere center and radius
-						pChildNode->mvCenter = (pChildNode->mvMax + pChildNode->mvMin) *0.5f;
-						pChildNode->mfRadius = (pChildNode->mvMax - pChildNode->mvMin).Length()*0.5f;
-					}
-				}
-
-				if(gbLog){
-					Log(" --------------------\n", this);
-				}
-			}
+			mlstChildNodes.push_back(apChild);
 		}
-
-		//////////////////////////////////
-		// Reset variables
-		mbObjectMoved = false;
 	}
 
 	//-----------------------------------------------------------------------
 
-	void cRCNode_DynBoxTree::RemoveObject(iRenderable *apObject)
+	void cRCNode_DynBoxTree::UpdateFromChildren()
 	{
-		/////////////////////////////////
-		// Remove object from list and clears node list
-		STLFindAndRemove(mlstObjects, apObject);
-	}
+		cRCNode_DynBoxTree *pChildA = mpChild[0];
+		cRCNode_DynBoxTree *pChildB = mpChild[1];
 
-	//-----------------------------------------------------------------------
+		mvFatMin = pChildA->mvFatMin;
+		mvFatMax = pChildA->mvFatMax;
+		cMath::ExpandAABB(mvFatMin, mvFatMax, pChildB->mvFatMin, pChildB->mvFatMax);
 
-	void cRCNode_DynBoxTree::RecalculateSplit()
-	{
-		mbRecalculateSplit = true;
+		mvMin = pChildA->mvMin;
+		mvMax = pChildA->mvMax;
+		cMath::ExpandAABB(mvMin, mvMax, pChildB->mvMin, pChildB->mvMax);
 
-		//No need to push up, since recalculation is called on all nodes where AABB is changed.
-	}
-
-	//-----------------------------------------------------------------------
+		SetSphereFromAABB(mvMin, mvMax, mvCenter, mfRadius);
 
-	void cRCNode_DynBoxTree::RecalculateAABB()
-	{
-		mbRecalculateAABB = true;
-
-		//Do calculation in BeforeUse()...
-	}
-
-	//-----------------------------------------------------------------------
-
-	void cRCNode_DynBoxTree::ObjectMoved()
-	{
-		if(mbObjectMoved) return;
-
-		mbObjectMoved = true;
-		cRCNode_DynBoxTree* pParentNode = static_cast<cRCNode_DynBoxTree*>(mpParent);
-		if(pParentNode) pParentNode->ObjectMoved();
+		mlHeight = 1 + cMath::Max(pChildA->mlHeight, pChildB->mlHeight);
 	}
 
 	//-----------------------------------------------------------------------
@@ -624,26 +208,14 @@ namespace hpl {
 
 	cRenderableContainer_DynBoxTree::cRenderableContainer_DynBoxTree()
 	{
-		mlSplitThreshold = 30;		//Number of objects a node should have before split.
-
-		mlMaxGarbageCollectCount = 60;		//How often (measured in accesses with change, meaning when the renderer checks the node and there has been some movement)
-											//certain a "garbage check should be made. This means:
-											//- If node has leaves as children, check so that the child objects contained is equal or greater then then split threshold
-											//  else move all the objects in the child nodes to the node.
-											//- Recalculate the split axis.
+		mfFatMargin = 0.1f;			//Distance (in meters) the fat AABB of a leaf is larger than the object on each side.
+		mfFatSizeMul = 0.1f;		//Extra margin added in proportion to the size of the object, so large objects do not get reinserted all the time.
+		mfMaxFatAreaMul = 2.0f;		//If the fat AABB has this many times larger area than a new one would have (object shrunk), the object is reinserted.
 
-		mlMaxIgnoreSplitCount = 30;			//How often new splits should be done, after the first split has been made.
-											//If objects are removed from child nodes they may be deleted and an already split
-											//node is without child nodes. If the object here grows to split size a new split can happen
-											//but only after a number of checks determined by this variable.
-											//Node: IsSplit variable cannot be reseted since there are cases when there are enough objects but all
-											//will go into the same child node and eternal iteration ensues.
+		mlNodeNum =0;
+		mlNodeBlockSize = 128;
 
-		mfMaxIntersectionAmount = 0.2f;		//The amount (1=100%) an object can be over the splitting line and still not be an intersecting object
-											//Also is the amount by which a new AABB can be expanded.
-
-		mlMaxRebuildCount = 600;			//The number changes the need to occur in the tree before it is rebuilt from scratch.
-		mlRebuildCount = mlMaxRebuildCount;
+		mpTreeRoot = NULL;
 
 		mRoot.mpContainer = this;
 		mRoot.mpParent = NULL;
@@ -656,6 +228,11 @@ namespace hpl {
 	cRenderableContainer_DynBoxTree::~cRenderableContainer_DynBoxTree()
 	{
 		hplDelete( mpObjectCalllback );
+
+		for(size_t i=0; i<mvNodeBlocks.size(); ++i)
+		{
+			hplDeleteArray(mvNodeBlocks[i]);
+		}
 	}
 
 	//-----------------------------------------------------------------------
@@ -673,11 +250,14 @@ namespace hpl {
 		}
 
 		///////////////////////////////////////////
-		//Get the node where object is to be added and then add it there.
-		cRCNode_DynBoxTree *pNode = GetAddNode(&mRoot, apRenderable);
+		//Create a leaf for the object and insert it into the tree
+		cRCNode_DynBoxTree *pLeaf = CreateNode();
+		pLeaf->mpObject = apRenderable;
+		pLeaf->mlstObjects.push_back(apRenderable);
+		apRenderable->SetRenderContainerNode(pLeaf);
 
-		pNode->mlstObjects.push_back(apRenderable);
-		apRenderable->SetRenderContainerNode(pNode);
+		SetLeafAABB(pLeaf);
+		InsertLeaf(pLeaf);
 
 		/////////////////////////
 		//Add callbacks
@@ -685,20 +265,8 @@ namespace hpl {
 		apRenderable->AddCallback(mpObjectCalllback);
 
 		if(gbLog || HasDebug(apRenderable)){
-			Log("Added object '%s' / %d to Node %d\n",apRenderable->GetName().c_str(), apRenderable, pNode);
-
-			Log("Objects:\n");
-			tRenderableList *pObjList = pNode->GetObjectList();
-			for(tRenderableListIt it = pObjList->begin(); it != pObjList->end(); ++it)
-			{
-				iRenderable *pObj = *it;
-				tString sParent = pObj->GetEntityParent() ? pObj->GetEntityParent()->GetName() : "NULL";
-				Log(" '%s'id: %d  parent: '%s' size: %s\n", pObj->GetName().c_str(),pObj->GetUniqueID(),sParent.c_str(), pObj->GetBoundingVolume()->GetSize().ToString().c_str());
-			}
+			Log("Added object '%s' / %d to leaf %d, tree height: %d\n",apRenderable->GetName().c_str(), apRenderable, pLeaf, GetTreeHeight());
 		}
-
-		//Increase rebuild count.
-		mlRebuildCount--;
 	}
 
 	//-----------------------------------------------------------------------
@@ -713,44 +281,24 @@ namespace hpl {
 		}
 
 		//////////////////////////////////
-		// Get the node where the object is
-		cRCNode_DynBoxTree *pNode = static_cast<cRCNode_DynBoxTree*>(apRenderable->GetRenderContainerNode());	//Assume one node only
-		if(pNode==NULL) return;
+		// Get the leaf where the object is
+		cRCNode_DynBoxTree *pLeaf = static_cast<cRCNode_DynBoxTree*>(apRenderable->GetRenderContainerNode());
+		if(pLeaf==NULL) return;
 
 		if(gbLog  || HasDebug(apRenderable)){
-			Log("Removing object '%s' / %d from node %d\n",apRenderable->GetName().c_str(), apRenderable, pNode);
+			Log("Removing object '%s' / %d from leaf %d\n",apRenderable->GetName().c_str(), apRenderable, pLeaf);
 		}
 
 		//////////////////////////////////
-		// Remove object from node.
-        pNode->RemoveObject(apRenderable);
-
-		//////////////////////////////////
-		// If nodes is leaf, has no objects left and is not the root, delete it.
-		if(	pNode->HasChildNodes()==false && pNode->HasObjects()==false && pNode->GetParent() != NULL)
-		{
-			if(gbLog || HasDebug(apRenderable)){
-				Log(" Remove node %d\n", pNode);
-			}
-			RemoveNode(pNode);
-		}
-		// If not, check if AABB update is needed.
-		else
-		{
-			if(gbLog || HasDebug(apRenderable)){
-				Log(" Iterate AABB update for node %d\n", pNode);
-			}
-			CheckNodeAABBNeedsUpdateIterative(pNode,apRenderable);
-		}
+		// Remove leaf from tree and give it back to the pool
+		RemoveLeaf(pLeaf);
+		ReleaseNode(pLeaf);
 
 		////////////////////////
 		//Remove callbacks
 		apRenderable->SetRenderContainerNode(NULL);
 		apRenderable->SetRenderCallback(NULL);
 		apRenderable->RemoveCallback(mpObjectCalllback);
-
-		//Increase rebuild count.
-		mlRebuildCount--;
 	}
 
 	//-----------------------------------------------------------------------
@@ -764,15 +312,33 @@ namespace hpl {
 
 	void cRenderableContainer_DynBoxTree::Compile()
 	{
-		//When doing a compile, wait a little while and then do a rebuild. So all particle system and usch have come into place.
-		mlRebuildCount = 10;
+		//Objects were inserted in load order, so insert them again now that all are in place to get a better tree.
+		RebuildNodes();
 	}
 
 	//-----------------------------------------------------------------------
 
 	void cRenderableContainer_DynBoxTree::RebuildNodes()
 	{
-		mlRebuildCount = 0;
+		if(mpTreeRoot==NULL) return;
+
+		tRCNode_DynBoxTreeVec vLeaves;
+		vLeaves.reserve(mlNodeNum/2 + 1);
+		GetLeavesIterative(mpTreeRoot, vLeaves);
+
+		ReleaseInternalNodesIterative(mpTreeRoot);
+		ReplaceChild(&mRoot, mpTreeRoot, NULL);
+
+		for(size_t i=0; i<vLeaves.size(); ++i)
+		{
+			cRCNode_DynBoxTree *pLeaf = vLeaves[i];
+			pLeaf->mpParent = NULL;
+
+			SetLeafAABB(pLeaf);
+			InsertLeaf(pLeaf);
+		}
+
+		m_setObjectsToUpdate.clear();
 	}
 
 	//-----------------------------------------------------------------------
@@ -799,28 +365,6 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
-	void cRenderableContainer_DynBoxTree::AddNodeObjectsToRoot(cRCNode_DynBoxTree *apNode)
-	{
-		tRenderableListIt objIt = apNode->mlstObjects.begin();
-		for(; objIt != apNode->mlstObjects.end(); ++objIt)
-		{
-			iRenderable *pObject = *objIt;
-
-			pObject->SetRenderContainerNode(&mRoot);
-			mRoot.mlstObjects.push_back(pObject);
-		}
-
-		tRenderableContainerNodeListIt nodeIt = apNode->mlstChildNodes.begin();
-		for(; nodeIt != apNode->mlstChildNodes.end(); ++nodeIt)
-		{
-			cRCNode_DynBoxTree *pChildNode = static_cast<cRCNode_DynBoxTree*>(*nodeIt);
-
-			AddNodeObjectsToRoot(pChildNode);
-		}
-	}
-
-	//-----------------------------------------------------------------------
-
 	void cRenderableContainer_DynBoxTree::SpecificUpdateBeforeRendering()
 	{
 		///////////////////////////////////
@@ -836,28 +380,6 @@ namespace hpl {
 			}
             m_setObjectsToUpdate.clear();
 		}
-
-
-		///////////////////////////////////
-		// Rebuild tree if needed
-		if(mlRebuildCount >0) return;
-
-		mlRebuildCount = mlMaxRebuildCount;
-
-		tRenderableContainerNodeListIt it = mRoot.mlstChildNodes.begin();
-		for(; it != mRoot.mlstChildNodes.end(); ++it)
-		{
-			cRCNode_DynBoxTree *pNode = static_cast<cRCNode_DynBoxTree*>(*it);
-
-            AddNodeObjectsToRoot(pNode);
-		}
-
-		STLDeleteAll(mRoot.mlstChildNodes);
-
-		mRoot.mbIsSplit = false;
-		mRoot.mbRecalculateAABB = true;
-		mRoot.mbRecalculateSplitAxis = true;
-		mRoot.mbRecalculateSplit = true;
 	}
 
 	//-----------------------------------------------------------------------
@@ -870,19 +392,6 @@ namespace hpl {
 		//AABB
 		apFunctions->GetLowLevelGfx()->DrawBoxMinMax(apNode->GetMin(),apNode->GetMax(),LevelColor[alLevel % 10]);
 
-		//Split plane
-		if(apNode->HasChildNodes())
-		{
-			cVector3f vMin = apNode->GetMin();
-			cVector3f vMax = apNode->GetMax();
-			vMin.v[apNode->mlSplitAxis] = apNode->mfSplitPlane;
-			vMax.v[apNode->mlSplitAxis] = apNode->mfSplitPlane;
-
-			apFunctions->GetLowLevelGfx()->DrawBoxMinMax(vMin, vMax,LevelColor[alLevel % 10]);
-
-		}
-
-
 		tRenderableContainerNodeListIt childIt = apNode->GetChildNodeList()->begin();
 		for(; childIt != apNode->GetChildNodeList()->end(); ++childIt)
 		{
@@ -893,349 +402,396 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
-	void cRenderableContainer_DynBoxTree::RemoveNode(cRCNode_DynBoxTree *apRemoveNode)
+	cRCNode_DynBoxTree* cRenderableContainer_DynBoxTree::CreateNode()
 	{
-		cRCNode_DynBoxTree *pParent = static_cast<cRCNode_DynBoxTree*>(apRemoveNode->GetParent());
-		if(pParent == NULL) return;
-
+		////////////////////////
+		//Allocate a new block if the pool is empty
+		if(mvFreeNodes.empty())
+		{
+			cRCNode_DynBoxTree *pBlock = hplNewArray(cRCNode_DynBoxTree, mlNodeBlockSize);
+			mvNodeBlocks.push_back(pBlock);
 
-		if(gbLog){
-			Log(" Remove node %d from parent %d\n", apRemoveNode, pParent);
+			for(int i=mlNodeBlockSize-1; i>=0; --i) mvFreeNodes.push_back(&pBlock[i]);
 		}
 
-		////////////////////////////////////
-		// Remove the node from the parent
-		STLFindAndDelete(pParent->mlstChildNodes, apRemoveNode);
-
-		////////////////////////////////////
-		// Get Remaining child node and then clear child node list
-		cRCNode_DynBoxTree *pChild = static_cast<cRCNode_DynBoxTree*>(pParent->mlstChildNodes.front());
-
-        pParent->mlstChildNodes.clear();
+		cRCNode_DynBoxTree *pNode = mvFreeNodes.back();
+		mvFreeNodes.pop_back();
 
-		////////////////////////////////////
-		// Move the objects from the remaining child in parent to parent
-		if(pChild->HasObjects())
-		{
-			if(gbLog){
-				Log("  Moving objects from node %d to parent %d\n", pChild, pParent);
-			}
-
-			tRenderableListIt it = pChild->mlstObjects.begin();
-			for(; it != pChild->mlstObjects.end(); ++it)
-			{
-				iRenderable *pChildObject = *it;
-				if(gbLog) Log("   %s / %d\n", pChildObject->GetName().c_str(), pChildObject);
+		////////////////////////
+		//Reset the node
+		pNode->mpContainer = this;
+		pNode->mlHeight =0;
+		pNode->mlRenderFlags =0;
+		pNode->mbVisibleObjects = false;
+		pNode->SetNeedPropertyUpdate(true);
+		pNode->SetPrevFrustumCollision(eCollision_Outside);
+		pNode->SetViewDistance(0);
+		pNode->SetInsideView(false);
 
-				//Set new node
-				pChildObject->SetRenderContainerNode(pParent);
+		++mlNodeNum;
 
-				pParent->mlstObjects.push_back(pChildObject);
-			}
-		}
+		return pNode;
+	}
 
-		////////////////////////////////////
-		// Move the child nodes from the remaining child in parent to parent
-		if(pChild->HasChildNodes())
-		{
-			if(gbLog){
-				Log("  Moving children from node %d to parent %d\n", pChild, pParent);
-			}
+	//-----------------------------------------------------------------------
 
-			tRenderableContainerNodeListIt it = pChild->mlstChildNodes.begin();
-			for(; it != pChild->mlstChildNodes.end(); ++it)
-			{
-				iRenderableContainerNode *pChild_ChildNode = *it;
+	void cRenderableContainer_DynBoxTree::ReleaseNode(cRCNode_DynBoxTree *apNode)
+	{
+		apNode->mpParent = NULL;
+		apNode->mpChild[0] = NULL;
+		apNode->mpChild[1] = NULL;
+		apNode->mpObject = NULL;
+		apNode->mlstChildNodes.clear();
+		apNode->mlstObjects.clear();
 
-				if(gbLog) Log("   %d\n", pChild_ChildNode);
+		mvFreeNodes.push_back(apNode);
 
-				//Set new parent and add to parents child node list
-                pChild_ChildNode->SetParent(pParent);
-                pParent->mlstChildNodes.push_back(pChild_ChildNode);
-			}
+		--mlNodeNum;
+	}
 
-			//Clear all nodes, else they will be deleted later on
-			pChild->mlstChildNodes.clear();
-		}
+	//-----------------------------------------------------------------------
 
-		if(gbLog){
-			Log(" Deleting other node %d and recalculating AABB for parent %d\n", pChild, pParent);
-		}
+	void cRenderableContainer_DynBoxTree::SetLeafAABB(cRCNode_DynBoxTree *apLeaf)
+	{
+		cBoundingVolume *pBV = apLeaf->mpObject->GetBoundingVolume();
 
-		////////////////////////////////////
-		// Delete the remaining child node.
-		hplDelete(pChild);
+		apLeaf->mvMin = pBV->GetMin();
+		apLeaf->mvMax = pBV->GetMax();
+		SetSphereFromAABB(apLeaf->mvMin, apLeaf->mvMax, apLeaf->mvCenter, apLeaf->mfRadius);
 
-		////////////////////////////////////
-		// Recalculate the AABB of parent and set as not split
-        pParent->RecalculateAABB();
-        pParent->mbIsSplit = false;
+		CalculateFatAABB(apLeaf->mvMin, apLeaf->mvMax, mfFatMargin, mfFatSizeMul, apLeaf->mvFatMin, apLeaf->mvFatMax);
 	}
 
 	//-----------------------------------------------------------------------
 
-	void cRenderableContainer_DynBoxTree::CheckNodeAABBNeedsUpdateIterative(cRCNode_DynBoxTree *apNode, iRenderable *apObject)
+	void cRenderableContainer_DynBoxTree::InsertLeaf(cRCNode_DynBoxTree *apLeaf)
 	{
-		if(CheckObjectIsAtEdgeOfAABB(apObject, apNode->GetMin(), apNode->GetMax()))
+		apLeaf->mlHeight =0;
+
+		////////////////////////////////
+		// First object is the whole tree
+		if(mpTreeRoot==NULL)
+		{
+			ReplaceChild(&mRoot, NULL, apLeaf);
+			UpdateRootAABB();
+			PushUpNeedPropertyUpdate(apLeaf);
+			return;
+		}
+
+		////////////////////////////////
+		// Find the best sibling by going down the tree, picking the cheapest child until it is cheaper to
+		// make a new parent for the current node and the leaf. The cost is the area of the new node plus the area
+		// that is added to the nodes above it.
+		cRCNode_DynBoxTree *pNode = mpTreeRoot;
+		while(pNode->IsLeaf()==false)
 		{
-			if(gbLog){
-				Log("  Updating AABB for node %d\n", apNode);
+			float fArea = SurfaceArea(pNode->mvFatMin, pNode->mvFatMax);
+			float fCombinedArea = CombinedSurfaceArea(pNode->mvFatMin, pNode->mvFatMax, apLeaf->mvFatMin, apLeaf->mvFatMax);
+
+			float fCost = 2*fCombinedArea;
+			float fInheritanceCost = 2*(fCombinedArea - fArea);
+
+			float vChildCost[2];
+			for(int i=0; i<2; ++i)
+			{
+				cRCNode_DynBoxTree *pChild = pNode->mpChild[i];
+
+				float fNewArea = CombinedSurfaceArea(pChild->mvFatMin, pChild->mvFatMax, apLeaf->mvFatMin, apLeaf->mvFatMax);
+				if(pChild->IsLeaf())	vChildCost[i] = fNewArea + fInheritanceCost;
+				else					vChildCost[i] = fNewArea - SurfaceArea(pChild->mvFatMin, pChild->mvFatMax) + fInheritanceCost;
 			}
 
-			//Calculate a new AABB size
-			apNode->RecalculateAABB();
+			if(fCost < vChildCost[0] && fCost < vChildCost[1]) break;
 
-			//Check if parent needs update too
-			cRCNode_DynBoxTree *pParent = static_cast<cRCNode_DynBoxTree*>(apNode->GetParent());
-			if(pParent)
-				CheckNodeAABBNeedsUpdateIterative(pParent, apObject);
+			//On a tie (e.g. objects at the same spot) go to the lowest child, so the tree does not turn into a list.
+			if(vChildCost[0] < vChildCost[1])		pNode = pNode->mpChild[0];
+			else if(vChildCost[1] < vChildCost[0])	pNode = pNode->mpChild[1];
+			else									pNode = pNode->mpChild[0]->mlHeight <= pNode->mpChild[1]->mlHeight ? pNode->mpChild[0] : pNode->mpChild[1];
 		}
-	}
 
-	//-----------------------------------------------------------------------
+		////////////////////////////////
+		// Create a new parent for sibling and leaf
+		cRCNode_DynBoxTree *pSibling = pNode;
+		cRCNode_DynBoxTree *pOldParent = static_cast<cRCNode_DynBoxTree*>(pSibling->mpParent);
 
+		cRCNode_DynBoxTree *pNewParent = CreateNode();
+		ReplaceChild(pOldParent, pSibling, pNewParent);
 
-	cRCNode_DynBoxTree *cRenderableContainer_DynBoxTree::GetAddNode(cRCNode_DynBoxTree *apStartNode, iRenderable *apObject)
-	{
-		mpTempNode = NULL; //Where the node is placed.
-		AddObjectToNodeIterative(apStartNode, apObject);
+		pNewParent->SetChild(0, pSibling);
+		pNewParent->SetChild(1, apLeaf);
 
-		return mpTempNode;
+		////////////////////////////////
+		// Update nodes above
+		RefitAndRotateUpwards(pNewParent);
+		PushUpNeedPropertyUpdate(apLeaf);
 	}
 
 	//-----------------------------------------------------------------------
 
-	void cRenderableContainer_DynBoxTree::AddObjectToNodeIterative(cRCNode_DynBoxTree *apNode, iRenderable *apObject)
+	void cRenderableContainer_DynBoxTree::RemoveLeaf(cRCNode_DynBoxTree *apLeaf)
 	{
-		if(gbLog || HasDebug(apObject) ){
-			cBoundingVolume *pBV = apObject->GetBoundingVolume();
-			Log(" Testing node %d. Inside: %d Intersect: %d (%s)-(%s) vs (%s)-(%s)\n",	apNode,
-																			cMath::CheckAABBInside(pBV->GetMin(),pBV->GetMax(), apNode->mvMin, apNode->mvMax)?1:0,
-																			cMath::CheckAABBIntersection(pBV->GetMin(),pBV->GetMax(), apNode->mvMin, apNode->mvMax)?1:0,
-																			pBV->GetMin().ToString().c_str(), pBV->GetMax().ToString().c_str(),
-																			apNode->mvMin.ToString().c_str(), apNode->mvMax.ToString().c_str());
-		}
-		/////////////////////////////
-		// Expand the AABB of node if needed
-		if( TestAndExpandNodeAABB(apObject, apNode->mvMin, apNode->mvMax) )
+		cRCNode_DynBoxTree *pParent = static_cast<cRCNode_DynBoxTree*>(apLeaf->mpParent);
+
+		////////////////////////////////
+		// Leaf is the whole tree
+		if(pParent == &mRoot)
 		{
-			//TODO: Perhaps sphere calc can be skipped here and done in UpdateBeforeUse instead.
-			apNode->mvCenter = (apNode->mvMax + apNode->mvMin) *0.5f;
-			apNode->mfRadius = (apNode->mvMax - apNode->mvMin).Length()*0.5f;
+			ReplaceChild(&mRoot, apLeaf, NULL);
+			UpdateRootAABB();
+			PushUpNeedPropertyUpdate(&mRoot);
+			apLeaf->mpParent = NULL;
+			return;
+		}
 
-			apNode->RecalculateSplit();
+		////////////////////////////////
+		// Replace the parent with the sibling
+		cRCNode_DynBoxTree *pGrandParent = static_cast<cRCNode_DynBoxTree*>(pParent->mpParent);
+		cRCNode_DynBoxTree *pSibling = pParent->mpChild[0]==apLeaf ? pParent->mpChild[1] : pParent->mpChild[0];
 
-			if(gbLog || HasDebug(apObject)) Log("  Expanded AABB\n");
-		}
+		ReplaceChild(pGrandParent, pParent, pSibling);
+		ReleaseNode(pParent);
+		apLeaf->mpParent = NULL;
+
+		////////////////////////////////
+		// Update nodes above
+		RefitAndRotateUpwards(pGrandParent);
+		PushUpNeedPropertyUpdate(pGrandParent);
+	}
 
-		/////////////////////////////
-		// If node has no children, add it here.
-		if(apNode->HasChildNodes()==false)
+	//-----------------------------------------------------------------------
+
+	void cRenderableContainer_DynBoxTree::ReplaceChild(cRCNode_DynBoxTree *apParent, cRCNode_DynBoxTree *apOldChild, cRCNode_DynBoxTree *apNewChild)
+	{
+		////////////////////////////////
+		// Container root only has the tree root as child
+		if(apParent == &mRoot)
 		{
-			mpTempNode = apNode;
+			mpTreeRoot = apNewChild;
+
+			mRoot.mlstChildNodes.clear();
+			if(apNewChild)
+			{
+				mRoot.mlstChildNodes.push_back(apNewChild);
+				apNewChild->mpParent = &mRoot;
+			}
 			return;
 		}
 
-		/////////////////////////////
-		// Calculate what group the new object belongs to
-		cVector3f vNodeSize = apNode->GetMax() - apNode->GetMin();
-		int lSplitGroup = GetSplitGroup(apObject,apNode->mfSplitPlane, apNode->mlSplitAxis ,vNodeSize);
+		apParent->SetChild(apParent->mpChild[0]==apOldChild ? 0 : 1, apNewChild);
+	}
 
+	//-----------------------------------------------------------------------
 
-		/////////////////////////////
-		// If object is intersecting then add to this node, else add to a child.
-		if(lSplitGroup == 2)
-		{
-			mpTempNode = apNode;
-		}
-		else
+	void cRenderableContainer_DynBoxTree::RefitAndRotateUpwards(cRCNode_DynBoxTree *apNode)
+	{
+		while(apNode != &mRoot)
 		{
-			//Assuming always two children!
-			if(lSplitGroup==0)	AddObjectToNodeIterative(static_cast<cRCNode_DynBoxTree*>(apNode->mlstChildNodes.front()),apObject);
-			if(lSplitGroup==1)	AddObjectToNodeIterative(static_cast<cRCNode_DynBoxTree*>(apNode->mlstChildNodes.back()),apObject);
+			apNode->UpdateFromChildren();
+			RotateNode(apNode);
+
+			apNode = static_cast<cRCNode_DynBoxTree*>(apNode->mpParent);
 		}
+
+		UpdateRootAABB();
 	}
 
 	//-----------------------------------------------------------------------
 
 	/**
-	 * Returns 0=above, 1=below, 2=intersection
+	 * Swaps one child with a grand child on the other side. If the children differ more than one in height, the taller
+	 * grand child is moved up (like an AVL rotation), so the tree stays balanced even when the areas do not help, e.g. when
+	 * many objects are at the same spot. Else the swap is done if it makes the child that gets the new node smaller
+	 * and does not unbalance the node. The node itself keeps the same objects and AABB.
 	 */
-	int cRenderableContainer_DynBoxTree::GetSplitGroup(iRenderable *apObject, float afSplitPlane, int alAxis, const cVector3f &avNodeSize)
+	void cRenderableContainer_DynBoxTree::RotateNode(cRCNode_DynBoxTree *apNode)
 	{
-		float fMinVal =   GetAxisFromVec(apObject->GetBoundingVolume()->GetMin(),alAxis);
-		float fMaxVal =   GetAxisFromVec(apObject->GetBoundingVolume()->GetMax(),alAxis);
+		cRCNode_DynBoxTree *pB = apNode->mpChild[0];
+		cRCNode_DynBoxTree *pC = apNode->mpChild[1];
+		if(pB->IsLeaf() && pC->IsLeaf()) return;
 
-		//////////////////////////
-		//Above cut plane
-		if(fMinVal >= afSplitPlane)
+		// 1: B<->F, 2: B<->G, 3: C<->D, 4: C<->E
+		int lBestRotation =0;
+
+		////////////////////////////////
+		// Balance by height
+		int lBalance = pC->mlHeight - pB->mlHeight;
+		if(lBalance > 1)
 		{
-			return 0;
+			lBestRotation = pC->mpChild[0]->mlHeight > pC->mpChild[1]->mlHeight ? 1 : 2;
 		}
-		//////////////////////////
-		//Below cut plane
-		else if(fMaxVal <= afSplitPlane)
+		else if(lBalance < -1)
 		{
-			return 1;
+			lBestRotation = pB->mpChild[0]->mlHeight > pB->mpChild[1]->mlHeight ? 3 : 4;
 		}
-		//////////////////////////
-		//Intersection
+		////////////////////////////////
+		// Find the rotation that lowers the area the most
 		else
 		{
-			////////////////////////
-			//Calculate how much the object crosses over on each side
-			float fAboveDist = fMaxVal - afSplitPlane;
-			float fBelowDist = afSplitPlane - fMinVal;
-
-			float fNodeSize = GetAxisFromVec(avNodeSize, alAxis);	//Using the size of entire node since it one side might be very small.
-
-			/////////////////////
-			//Get the least amount of cross over, and on which side it is.
-			float fMinDist = fAboveDist;
-			int lDestDir = 1;	//If above is smallest, object should be below and vice verce.
-			if(fBelowDist < fMinDist)
+			float fBestDiff =0;
+
+			if(pC->IsLeaf()==false)
 			{
-				fMinDist = fBelowDist;
-				lDestDir =0;
+				cRCNode_DynBoxTree *pF = pC->mpChild[0];
+				cRCNode_DynBoxTree *pG = pC->mpChild[1];
+				float fAreaC = SurfaceArea(pC->mvFatMin, pC->mvFatMax);
+
+				float fDiffBF = CombinedSurfaceArea(pB->mvFatMin, pB->mvFatMax, pG->mvFatMin, pG->mvFatMax) - fAreaC;
+				float fDiffBG = CombinedSurfaceArea(pB->mvFatMin, pB->mvFatMax, pF->mvFatMin, pF->mvFatMax) - fAreaC;
+
+				if(fDiffBF < fBestDiff && RotationKeepsBalance(pF->mlHeight, pB->mlHeight, pG->mlHeight)){ lBestRotation = 1; fBestDiff = fDiffBF;}
+				if(fDiffBG < fBestDiff && RotationKeepsBalance(pG->mlHeight, pB->mlHeight, pF->mlHeight)){ lBestRotation = 2; fBestDiff = fDiffBG;}
 			}
 
-			/////////////////////
-			//Check if the amount of cross over is small enough to not treat it as an intersection.
-			float fMinCrossOverAmount = fMinDist / fNodeSize;
-			if(fMinCrossOverAmount <= mfMaxIntersectionAmount) return lDestDir;
+			if(pB->IsLeaf()==false)
+			{
+				cRCNode_DynBoxTree *pD = pB->mpChild[0];
+				cRCNode_DynBoxTree *pE = pB->mpChild[1];
+				float fAreaB = SurfaceArea(pB->mvFatMin, pB->mvFatMax);
+
+				float fDiffCD = CombinedSurfaceArea(pC->mvFatMin, pC->mvFatMax, pE->mvFatMin, pE->mvFatMax) - fAreaB;
+				float fDiffCE = CombinedSurfaceArea(pC->mvFatMin, pC->mvFatMax, pD->mvFatMin, pD->mvFatMax) - fAreaB;
 
-			return 2;
+				if(fDiffCD < fBestDiff && RotationKeepsBalance(pD->mlHeight, pC->mlHeight, pE->mlHeight)){ lBestRotation = 3; fBestDiff = fDiffCD;}
+				if(fDiffCE < fBestDiff && RotationKeepsBalance(pE->mlHeight, pC->mlHeight, pD->mlHeight)){ lBestRotation = 4; fBestDiff = fDiffCE;}
+			}
 		}
-	}
 
-	//-----------------------------------------------------------------------
+		if(lBestRotation==0) return;
 
+		////////////////////////////////
+		// Do the swap
+		cRCNode_DynBoxTree *pChanged = NULL;
+		if(lBestRotation <= 2)
+		{
+			int lGrandChild = lBestRotation==1 ? 0 : 1;
+			cRCNode_DynBoxTree *pGrandChild = pC->mpChild[lGrandChild];
 
-	void cRenderableContainer_DynBoxTree::UpdateObjectInContainer(iRenderable* apObject)
-	{
-		const bool bUpdateLog=false;
-		//bool bUpdateLog= HasDebug(apObject);
+			apNode->SetChild(0, pGrandChild);
+			pC->SetChild(lGrandChild, pB);
+			pChanged = pC;
+		}
+		else
+		{
+			int lGrandChild = lBestRotation==3 ? 0 : 1;
+			cRCNode_DynBoxTree *pGrandChild = pB->mpChild[lGrandChild];
 
+			apNode->SetChild(1, pGrandChild);
+			pB->SetChild(lGrandChild, pC);
+			pChanged = pB;
+		}
 
-		////////////////////////////////////////////
-		//Get Node of correct type
-		cRCNode_DynBoxTree *pNode =  static_cast<cRCNode_DynBoxTree*>(apObject->GetRenderContainerNode());
-		if(pNode==NULL) return;
+		pChanged->UpdateFromChildren();
+		apNode->UpdateFromChildren();
 
-		pNode->ObjectMoved();	//Notify the node that an object moved inside it.
+		PushUpNeedPropertyUpdate(pChanged);
+	}
 
-		if(bUpdateLog)
-			Log("------- Updating %s. Node: %d -------\n",apObject->GetName().c_str(), pNode);
+	//-----------------------------------------------------------------------
 
+	void cRenderableContainer_DynBoxTree::RefitTightAABBUpwards(cRCNode_DynBoxTree *apLeaf)
+	{
+		cBoundingVolume *pBV = apLeaf->mpObject->GetBoundingVolume();
 
-		////////////////////////////////////////////
-		//Get bounding volume and see if still contained in node
-		cBoundingVolume *pBV = apObject->GetBoundingVolume();
+		apLeaf->mvMin = pBV->GetMin();
+		apLeaf->mvMax = pBV->GetMax();
+		SetSphereFromAABB(apLeaf->mvMin, apLeaf->mvMax, apLeaf->mvCenter, apLeaf->mfRadius);
 
-		if(cMath::CheckAABBInside(pBV->GetMin(), pBV->GetMax(), pNode->GetMin(), pNode->GetMax()))
+		////////////////////////////////
+		// Update parents until one does not change
+		cRCNode_DynBoxTree *pNode = static_cast<cRCNode_DynBoxTree*>(apLeaf->mpParent);
+		while(pNode != &mRoot)
 		{
-			//Do not Check if AABB of node needs updating, since it will only take time and not gain much since the garbaage collection will fix it after a while.
+			cVector3f vMin = pNode->mpChild[0]->mvMin;
+			cVector3f vMax = pNode->mpChild[0]->mvMax;
+			cMath::ExpandAABB(vMin, vMax, pNode->mpChild[1]->mvMin, pNode->mpChild[1]->mvMax);
 
-			//The node is still inside the same node
-			if(bUpdateLog) {
-				Log(" Still inside AABB, not doing anything!\n");
-				Log("---------------------\n");
-			}
-			return;
-		}
+			if(vMin == pNode->mvMin && vMax == pNode->mvMax) return;
 
-		////////////////////////////////////////////
-		// Iterate through the parent nodes of the current and try and find one that fits the node, stopping at root
-		mpCheckForFitTempNode = pNode; //Node with fit will be placed here
-		cRCNode_DynBoxTree *pParent =  static_cast<cRCNode_DynBoxTree*>(pNode->GetParent());
-		if(pParent) CheckForFitIterative(pParent, pBV);
+			pNode->mvMin = vMin;
+			pNode->mvMax = vMax;
+			SetSphereFromAABB(vMin, vMax, pNode->mvCenter, pNode->mfRadius);
 
-		if(bUpdateLog) Log(" Found fit in %d (by starting in parent %d)\n", mpCheckForFitTempNode, pParent);
+			pNode = static_cast<cRCNode_DynBoxTree*>(pNode->mpParent);
+		}
 
-		////////////////////////////////////////////
-		// Get the node where the object is to be added
-		cRCNode_DynBoxTree *pNewNode = GetAddNode(mpCheckForFitTempNode, apObject);
+		UpdateRootAABB();
+	}
 
-		if(bUpdateLog) Log("  Node to add object in: %d (leaf: %d)\n", pNewNode, pNewNode->HasChildNodes()==false ? 1:0);
+	//-----------------------------------------------------------------------
 
-		////////////////////////////////////////////
-		// If the new node is not the same, then the the object needs removed from the old node and added to new.
-		if(pNewNode != pNode)
+	void cRenderableContainer_DynBoxTree::UpdateRootAABB()
+	{
+		if(mpTreeRoot)
 		{
-			if(bUpdateLog) Log("  Moving node\n");
-
-			//Notify the new node that an object moved inside it.
-			pNewNode->ObjectMoved();
-
-			//Decrease container rebuild count.
-			mlRebuildCount--;
+			mRoot.mvMin = mpTreeRoot->mvMin;
+			mRoot.mvMax = mpTreeRoot->mvMax;
+			mRoot.mvCenter = mpTreeRoot->mvCenter;
+			mRoot.mfRadius = mpTreeRoot->mfRadius;
+		}
+		else
+		{
+			mRoot.mvMin =0;
+			mRoot.mvMax =0;
+			mRoot.mvCenter =0;
+			mRoot.mfRadius =0;
+		}
+	}
 
-			/////////////////////////////////////
-			//If the object is not inside new node need to recalc AABB
-			cBoundingVolume *pObjBV = apObject->GetBoundingVolume();
-			//if(CheckObjectIsAtEdgeOfAABB(apObject,pNewNode->mvMin,pNewNode->mvMax)) //<- Old bad code! Just have for future reference!
-			if(cMath::CheckAABBInside(pObjBV->GetMin(), pObjBV->GetMax(), pNewNode->mvMin,pNewNode->mvMax)==false)
-			{
-				pNewNode->PushUpNeedAABBUpdate();
-			}
+	//-----------------------------------------------------------------------
 
-			/////////////////////////////////////
-			//Remove the node and set new one from node list
-			apObject->SetRenderContainerNode(pNewNode);
+	void cRenderableContainer_DynBoxTree::UpdateObjectInContainer(iRenderable* apObject)
+	{
+		cRCNode_DynBoxTree *pLeaf =  static_cast<cRCNode_DynBoxTree*>(apObject->GetRenderContainerNode());
+		if(pLeaf==NULL) return;
 
-			/////////////////////////////////////
-			//Add to new node
-			pNewNode->mlstObjects.push_back(apObject);
+		cBoundingVolume *pBV = apObject->GetBoundingVolume();
 
-			/////////////////////////////////////
-			//Remove from old
-			pNode->RemoveObject(apObject);
+		////////////////////////////////////////////
+		// If still inside the fat AABB and that is not too large for the object, only the tight AABBs need updating.
+		if(cMath::CheckAABBInside(pBV->GetMin(), pBV->GetMax(), pLeaf->mvFatMin, pLeaf->mvFatMax))
+		{
+			cVector3f vFatMin, vFatMax;
+			CalculateFatAABB(pBV->GetMin(), pBV->GetMax(), mfFatMargin, mfFatSizeMul, vFatMin, vFatMax);
 
-			// If old node is leaf and has no objects left, delete it.
-			if(pNode->HasChildNodes()==false && pNode->HasObjects()==false)
-			{
-				RemoveNode(pNode);
-			}
-			// If not, set that AABB update is needed.
-			else
+			if(SurfaceArea(pLeaf->mvFatMin, pLeaf->mvFatMax) <= SurfaceArea(vFatMin, vFatMax) * mfMaxFatAreaMul)
 			{
-				pNode->PushUpNeedAABBUpdate();
+				RefitTightAABBUpwards(pLeaf);
+				return;
 			}
 		}
-		///////////
-		//If the same node, then we want to recalculate AABB
-		else
-		{
-			if(bUpdateLog) Log("  Same node %d\n", pNode);
-
-			pNode->PushUpNeedAABBUpdate();
-		}
 
-		if(bUpdateLog) Log("---------------------\n");
+		////////////////////////////////////////////
+		// Reinsert the leaf with a new fat AABB
+		RemoveLeaf(pLeaf);
+		SetLeafAABB(pLeaf);
+		InsertLeaf(pLeaf);
 	}
 
 	//-----------------------------------------------------------------------
 
-	void cRenderableContainer_DynBoxTree::CheckForFitIterative(cRCNode_DynBoxTree *apNode, cBoundingVolume *apBV)
+	void cRenderableContainer_DynBoxTree::GetLeavesIterative(cRCNode_DynBoxTree *apNode, tRCNode_DynBoxTreeVec &avLeaves)
 	{
-		///////////////////////////////////
-		//Check if there is a fit or node is root, if so set the temp var and continue
-		if(	apNode->GetParent() == NULL ||
-			cMath::CheckAABBInside(apBV->GetMin(), apBV->GetMax(), apNode->GetMin(), apNode->GetMax()))
+		if(apNode->IsLeaf())
 		{
-			mpCheckForFitTempNode = apNode;
+			avLeaves.push_back(apNode);
 			return;
 		}
 
-		///////////////////////////////////////////
-		//If no fit in curremt, check parent
-		cRCNode_DynBoxTree *pParent =  static_cast<cRCNode_DynBoxTree*>(apNode->GetParent());
-		CheckForFitIterative(pParent, apBV);
+		GetLeavesIterative(apNode->mpChild[0], avLeaves);
+		GetLeavesIterative(apNode->mpChild[1], avLeaves);
 	}
 
-
 	//-----------------------------------------------------------------------
 
+	void cRenderableContainer_DynBoxTree::ReleaseInternalNodesIterative(cRCNode_DynBoxTree *apNode)
+	{
+		if(apNode->IsLeaf()) return;
+
+		ReleaseInternalNodesIterative(apNode->mpChild[0]);
+		ReleaseInternalNodesIterative(apNode->mpChild[1]);
 
+		ReleaseNode(apNode);
+	}
 
+	//-----------------------------------------------------------------------
 }
@@ -27,6 +27,7 @@
 #include "system/String.h"
 #include "system/Script.h"
 #include "system/Platform.h"
+#include "system/Profiler.h"
 
 #include "resources/Resources.h"
 #include "resources/ScriptManager.h"
@@ -212,13 +213,13 @@ namespace hpl {
 
 				if(pRenderer && pViewPort->GetWorld() && pFrustum)
 				{
-					START_TIMING(RenderWorld)
+					PROFILE_BEGIN(RenderWorld)
 					pRenderer->Render(	afFrameTime,pFrustum,
 										pViewPort->GetWorld(),pViewPort->GetRenderSettings(),
 										pViewPort->GetRenderTarget(),
 										bPostEffects,
 										pViewPort->GetRendererCallbackList());
-					STOP_TIMING(RenderWorld)
+					PROFILE_END(RenderWorld)
 				}
 				else
 				{
@@ -233,9 +234,9 @@ namespace hpl {
 				//////////////////////////////////////////////
 				//Render 3D GuiSets
 				// Should this really be here? Or perhaps send in a frame buffer depending on the renderer.
-				START_TIMING(Render3DGui)
+				PROFILE_BEGIN(Render3DGui)
 				Render3DGui(pViewPort,pFrustum, afFrameTime);
-				STOP_TIMING(Render3DGui)
+				PROFILE_END(Render3DGui)
 			}
 
 			//////////////////////////////////////////////
@@ -246,18 +247,18 @@ namespace hpl {
 				//		Or this is solved?
 				iTexture *pInputTexture = pRenderer->GetPostEffectTexture();
 
-				START_TIMING(RenderPostEffects)
+				PROFILE_BEGIN(RenderPostEffects)
 				pPostEffectComposite->Render(afFrameTime, pFrustum, pInputTexture,pViewPort->GetRenderTarget());
-				STOP_TIMING(RenderPostEffects)
+				PROFILE_END(RenderPostEffects)
 			}
 
 			//////////////////////////////////////////////
 			//Render Screen GUI
 			if(alFlags & tSceneRenderFlag_Gui)
 			{
-				START_TIMING(RenderGUI)
+				PROFILE_BEGIN(RenderGUI)
 				RenderScreenGui(pViewPort, afFrameTime);
-				STOP_TIMING(RenderGUI)
+				PROFILE_END(RenderGUI)
 			}
 		}
 	}
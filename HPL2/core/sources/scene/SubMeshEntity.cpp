@@ -27,6 +27,7 @@
 #include "graphics/Material.h"
 #include "graphics/Mesh.h"
 #include "graphics/SubMesh.h"
+#include "graphics/Skinning.h"
 
 #include "graphics/Animation.h"
 #include "graphics/AnimationTrack.h"
@@ -150,40 +151,6 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
-	// Set Src as private variable to give this a little boost! Or?
-	static inline void MatrixFloatTransformSet(float *pDest, const cMatrixf &a_mtxA, const float* pSrc, const float fWeight)
-	{
-		pDest[0] = ( a_mtxA.m[0][0] * pSrc[0] + a_mtxA.m[0][1] * pSrc[1] + a_mtxA.m[0][2] * pSrc[2] + a_mtxA.m[0][3] ) * fWeight;
-		pDest[1] = ( a_mtxA.m[1][0] * pSrc[0] + a_mtxA.m[1][1] * pSrc[1] + a_mtxA.m[1][2] * pSrc[2] + a_mtxA.m[1][3] ) * fWeight;
-		pDest[2] = ( a_mtxA.m[2][0] * pSrc[0] + a_mtxA.m[2][1] * pSrc[1] + a_mtxA.m[2][2] * pSrc[2] + a_mtxA.m[2][3] ) * fWeight;
-	}
-
-	static inline void MatrixFloatRotateSet(float *pDest, const cMatrixf &a_mtxA, const float* pSrc, const float fWeight)
-	{
-		pDest[0] = ( a_mtxA.m[0][0] * pSrc[0] + a_mtxA.m[0][1] * pSrc[1] + a_mtxA.m[0][2] * pSrc[2] ) * fWeight;
-		pDest[1] = ( a_mtxA.m[1][0] * pSrc[0] + a_mtxA.m[1][1] * pSrc[1] + a_mtxA.m[1][2] * pSrc[2] ) * fWeight;
-		pDest[2] = ( a_mtxA.m[2][0] * pSrc[0] + a_mtxA.m[2][1] * pSrc[1] + a_mtxA.m[2][2] * pSrc[2] ) * fWeight;
-	}
-
-	//-----------------------------------------------------------------------
-
-	// Set Src as private variable to give this a little boost!Or?
-	static inline void MatrixFloatTransformAdd(float *pDest, const cMatrixf &a_mtxA, const float* pSrc, const float fWeight)
-	{
-		pDest[0] += ( a_mtxA.m[0][0] * pSrc[0] + a_mtxA.m[0][1] * pSrc[1] + a_mtxA.m[0][2] * pSrc[2] + a_mtxA.m[0][3] ) * fWeight;
-		pDest[1] += ( a_mtxA.m[1][0] * pSrc[0] + a_mtxA.m[1][1] * pSrc[1] + a_mtxA.m[1][2] * pSrc[2] + a_mtxA.m[1][3] ) * fWeight;
-		pDest[2] += ( a_mtxA.m[2][0] * pSrc[0] + a_mtxA.m[2][1] * pSrc[1] + a_mtxA.m[2][2] * pSrc[2] + a_mtxA.m[2][3] ) * fWeight;
-	}
-
-	static inline void MatrixFloatRotateAdd(float *pDest, const cMatrixf &a_mtxA, const float* pSrc, const float fWeight)
-	{
-		pDest[0] += ( a_mtxA.m[0][0] * pSrc[0] + a_mtxA.m[0][1] * pSrc[1] + a_mtxA.m[0][2] * pSrc[2] ) * fWeight;
-		pDest[1] += ( a_mtxA.m[1][0] * pSrc[0] + a_mtxA.m[1][1] * pSrc[1] + a_mtxA.m[1][2] * pSrc[2] ) * fWeight;
-		pDest[2] += ( a_mtxA.m[2][0] * pSrc[0] + a_mtxA.m[2][1] * pSrc[1] + a_mtxA.m[2][2] * pSrc[2] ) * fWeight;
-	}
-
-	//-----------------------------------------------------------------------
-
 	void cSubMeshEntity::UpdateGraphicsForFrame(float afFrameTime)
 	{
 		////////////////////////////////////
@@ -201,63 +168,24 @@ namespace hpl {
 
 			mbGraphicsUpdated = true;
 
-			const float *pBindPos = mpSubMesh->GetVertexBuffer()->GetFloatArray(eVertexBufferElement_Position);
-			const float *pBindNormal = mpSubMesh->GetVertexBuffer()->GetFloatArray(eVertexBufferElement_Normal);
-			const float *pBindTangent = mpSubMesh->GetVertexBuffer()->GetFloatArray(eVertexBufferElement_Texture1Tangent);
+			cSkinningData skinData;
+			skinData.mpBindPos = mpSubMesh->GetVertexBuffer()->GetFloatArray(eVertexBufferElement_Position);
+			skinData.mpBindNormal = mpSubMesh->GetVertexBuffer()->GetFloatArray(eVertexBufferElement_Normal);
+			skinData.mpBindTangent = mpSubMesh->GetVertexBuffer()->GetFloatArray(eVertexBufferElement_Texture1Tangent);
 
-			float *pSkinPos = mpDynVtxBuffer->GetFloatArray(eVertexBufferElement_Position);
-			float *pSkinNormal = mpDynVtxBuffer->GetFloatArray(eVertexBufferElement_Normal);
-			float *pSkinTangent = mpDynVtxBuffer->GetFloatArray(eVertexBufferElement_Texture1Tangent);
+			skinData.mpSkinPos = mpDynVtxBuffer->GetFloatArray(eVertexBufferElement_Position);
+			skinData.mpSkinNormal = mpDynVtxBuffer->GetFloatArray(eVertexBufferElement_Normal);
+			skinData.mpSkinTangent = mpDynVtxBuffer->GetFloatArray(eVertexBufferElement_Texture1Tangent);
 
-			const int lVtxStride = mpDynVtxBuffer->GetElementNum(eVertexBufferElement_Position);
-			const int lVtxNum = mpDynVtxBuffer->GetVertexNum();
+			skinData.mlPosStride = mpDynVtxBuffer->GetElementNum(eVertexBufferElement_Position);
 
-			for(int vtx=0; vtx < lVtxNum; vtx++)
-			{
-				//To count the bone bindings
-				int lCount = 0;
-				//Get pointer to weights and bone index.
-				const float *pWeight = &mpSubMesh->mpVertexWeights[vtx*4];
-				if(*pWeight==0) continue;
+			skinData.mpWeights = mpSubMesh->mpVertexWeights;
+			skinData.mpBones = mpSubMesh->mpVertexBones;
 
-				const unsigned char *pBoneIdx = &mpSubMesh->mpVertexBones[vtx*4];
+			skinData.mpBoneMatrices = &mpMeshEntity->mvBoneMatrices[0];
+			skinData.mpBoneColumns = &mpMeshEntity->mvBoneColumns[0];
 
-				const cMatrixf &mtxTransform = mpMeshEntity->mvBoneMatrices[*pBoneIdx];
-
-
-				MatrixFloatTransformSet(pSkinPos,mtxTransform, pBindPos, *pWeight);
-
-				MatrixFloatRotateSet(pSkinNormal,mtxTransform, pBindNormal, *pWeight);
-
-				MatrixFloatRotateSet(pSkinTangent,mtxTransform, pBindTangent, *pWeight);
-
-				++pWeight; ++pBoneIdx; ++lCount;
-
-				//Iterate weights until 0 is found or count < 4
-				while(*pWeight != 0 && lCount < 4)
-				{
-					//Log("Boneidx: %d Count %d Weight: %f\n",(int)*pBoneIdx,lCount, *pWeight);
-					const cMatrixf &mtxTransform = mpMeshEntity->mvBoneMatrices[*pBoneIdx];
-
-					//Transform with the local movement of the bone.
-					MatrixFloatTransformAdd(pSkinPos,mtxTransform, pBindPos, *pWeight);
-
-					MatrixFloatRotateAdd(pSkinNormal,mtxTransform, pBindNormal, *pWeight);
-
-					MatrixFloatRotateAdd(pSkinTangent,mtxTransform, pBindTangent, *pWeight);
-
-					++pWeight; ++pBoneIdx; ++lCount;
-				}
-
-				pBindPos += lVtxStride;
-				pSkinPos += lVtxStride;
-
-				pBindNormal += 3;
-				pSkinNormal += 3;
-
-				pBindTangent += 4;
-				pSkinTangent += 4;
-			}
+			cSkinning::SkinVerticesParallel(skinData, mpDynVtxBuffer->GetVertexNum());
 
 			//No stencil shadows:
 			/*float *pSkinPosArray = mpDynVtxBuffer->GetArray(eVertexElementFlag_Position);
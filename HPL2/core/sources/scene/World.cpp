@@ -71,6 +71,7 @@
 
 #include "system/System.h"
 #include "system/Platform.h"
+#include "system/Profiler.h"
 
 #include "sound/SoundEntityData.h"
 #include "sound/Sound.h"
@@ -85,6 +86,7 @@
 #include "ai/AINodeContainer.h"
 #include "ai/AINodeGenerator.h"
 #include "ai/AStar.h"
+#include "ai/AIPathRequestQueue.h"
 
 #include "haptic/Haptic.h"
 #include "haptic/LowLevelHaptic.h"
@@ -129,6 +131,9 @@ namespace hpl {
 		mpPhysicsWorld = NULL;
 		mbAutoDeletePhysicsWorld = false;
 
+		mlAIStaticBodiesHash = 0;
+		mbAIStaticBodiesHashValid = false;
+
 		//////////////////////////////
 		//Sky box
 		mpSkyBoxVtxBuffer = mpGraphics->GetMeshCreator()->CreateSkyBoxVertexBuffer(1);
@@ -200,6 +205,7 @@ namespace hpl {
 		STLMapDeleteAll(m_mapAreaEntities);
 
 
+		STLDeleteAll(mlstAIPathRequestQueues);
 		STLDeleteAll(mlstAINodeContainers);
 		STLDeleteAll(mlstAStarHandlers);
 		STLMapDeleteAll(m_mapTempNodes);
@@ -219,26 +225,30 @@ namespace hpl {
 
 	void cWorld::Update(float afTimeStep)
 	{
-		START_TIMING(Physics);
+		PROFILE_BEGIN(Physics)
 		if(mpPhysicsWorld) mpPhysicsWorld->Update(afTimeStep);
-		STOP_TIMING(Physics);
+		PROFILE_END(Physics)
 
 
-		START_TIMING(Entities);
+		PROFILE_BEGIN(Entities)
 		UpdateEntities(afTimeStep);
-		STOP_TIMING(Entities);
+		PROFILE_END(Entities)
 
-		START_TIMING(Particles);
+		PROFILE_BEGIN(Particles)
 		UpdateParticles(afTimeStep);
-		STOP_TIMING(Particles);
+		PROFILE_END(Particles)
 
-		START_TIMING(Lights);
+		PROFILE_BEGIN(Lights)
 		UpdateLights(afTimeStep);
-		STOP_TIMING(Lights);
+		PROFILE_END(Lights)
 
-		START_TIMING(SoundEntities);
+		PROFILE_BEGIN(SoundEntities)
 		UpdateSoundEntities(afTimeStep);
-		STOP_TIMING(SoundEntities);
+		PROFILE_END(SoundEntities)
+
+		PROFILE_BEGIN(AIPathRequests)
+		UpdateAIPathRequests();
+		PROFILE_END(AIPathRequests)
 	}
 
 	//-----------------------------------------------------------------------
@@ -271,6 +281,7 @@ namespace hpl {
 	{
 		mpPhysicsWorld = apWorld;
 		mbAutoDeletePhysicsWorld = abAutoDelete;
+		mbAIStaticBodiesHashValid = false;
 		if(mpPhysicsWorld)
 			mpPhysicsWorld->SetWorld(this);
 	}
@@ -1162,17 +1173,12 @@ namespace hpl {
 				pContainer->AddNode(pNode.msName,pNode.mlID,pNode.mvPos,NULL);
 			}
 
+			//The saved edges are used as long as nodes and static geometry are unchanged, even if the map file is newer.
 			bool bLoadedFromFile=false;
 			if(cPlatform::FileExists(sAiFileName))
 			{
-				cDate dateMapFile = cPlatform::FileModifiedDate(sMapPath);
-				cDate dateAIFile = cPlatform::FileModifiedDate(sAiFileName);
-
-				if(dateAIFile > dateMapFile || cResources::GetForceCacheLoadingAndSkipSaving())
-				{
-					bLoadedFromFile = true;
-					pContainer->LoadFromFile(sAiFileName);
-				}
+				bool bCheckHash = cResources::GetForceCacheLoadingAndSkipSaving()==false;
+				bLoadedFromFile = pContainer->LoadFromFile(sAiFileName, bCheckHash);
 			}
 
 			if(bLoadedFromFile==false)
@@ -1215,6 +1221,33 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	cAIPathRequestQueue* cWorld::GetAIPathRequestQueue(cAINodeContainer* apContainer)
+	{
+		for(tAIPathRequestQueueListIt it = mlstAIPathRequestQueues.begin(); it != mlstAIPathRequestQueues.end(); ++it)
+		{
+			if((*it)->GetContainer() == apContainer) return *it;
+		}
+
+		cAIPathRequestQueue *pQueue = hplNew( cAIPathRequestQueue, (apContainer) );
+		mlstAIPathRequestQueues.push_back(pQueue);
+
+		return pQueue;
+	}
+
+	//-----------------------------------------------------------------------
+
+	uint64_t cWorld::GetAIStaticBodiesHash()
+	{
+		if(mbAIStaticBodiesHashValid==false)
+		{
+			mlAIStaticBodiesHash = cAINodeContainer::GetStaticBodiesHash(mpPhysicsWorld);
+			mbAIStaticBodiesHashValid = true;
+		}
+		return mlAIStaticBodiesHash;
+	}
+
+	//-----------------------------------------------------------------------
+
 	void cWorld::AddAINode(const tString &asName, int alID, const tString &asType, const cVector3f &avPosition)
 	{
 		cTempNodeContainer *pContainer = NULL;
@@ -1364,11 +1397,11 @@ namespace hpl {
 			cMeshEntity *pEntity = *MeshIt;
 
 			if(pEntity->IsActive()){
-				//if(pEntity->IsStatic()==false) START_TIMING_EX(pEntity->GetName().c_str(),entity);
+				//if(pEntity->IsStatic()==false) PROFILE_BEGIN(entity)
 				pEntity->UpdateLogic(afTimeStep);
 				//if(bRenderDebug) Log("Enitity '%s'. Pos: (%s), Matrix: (%s)\n", pEntity->GetName().c_str(), pEntity->GetWorldPosition().ToString().c_str(),
 																			//pEntity->GetWorldMatrix().ToString().c_str());
-				//if(pEntity->IsStatic()==false) STOP_TIMING(entity);
+				//if(pEntity->IsStatic()==false) PROFILE_END(entity)
 			}
 		}
 		//if(bRenderDebug)Log("----\n");
@@ -1376,6 +1409,16 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	void cWorld::UpdateAIPathRequests()
+	{
+		for(tAIPathRequestQueueListIt it = mlstAIPathRequestQueues.begin(); it != mlstAIPathRequestQueues.end(); ++it)
+		{
+			(*it)->Update();
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
 	void cWorld::UpdateLights(float afTimeStep)
 	{
 		tLightListIt it = mlstLights.begin();
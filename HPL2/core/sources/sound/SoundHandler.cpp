@@ -34,6 +34,7 @@
 #include "physics/PhysicsWorld.h"
 #include "physics/PhysicsBody.h"
 
+#include <algorithm>
 
 namespace hpl {
 
@@ -75,51 +76,28 @@ namespace hpl {
 	const bool gbLogEntry = false;
 	//-----------------------------------------------------------------------
 
-	cSoundEntry::cSoundEntry(	const tString& asName, iSoundChannel* apSound, float afVolume,
-								eSoundEntryType aType, bool ab3D,
-								bool abStream, int alId,
-								cSoundHandler *apSoundHandler)
+	cSoundEntry::cSoundEntry()
 	{
-		msName = cString::ToLowerCase(asName);
-		mpSound = apSound;
-		mfNormalVolume = afVolume;
-		mType = aType;
-		mbStream = abStream;
-		mlId = alId;
-		mpSoundHandler = apSoundHandler;
-		mb3D = ab3D;
-
-		////////////////////////
-		// Set up defaults
-		mfVolumeMul = 1;
-		mfVolumeFadeDest = 1;
-		mfVolumeFadeSpeed =0;
-		mbStopAfterFadeOut = false;
-
-		mbStopDisabled = false;
-
-		mfNormalSpeed = 1;
-
-		mfSpeedMul = 1;
-		mfSpeedFadeDest = 1;
-		mfSpeedFadeSpeed = 0;
-
-		mbFirstTime = true;
-
-		mfBlockMul = 1;
-		mfBlockFadeDest = 1;
-		mfBlockFadeSpeed = 0;
-
+		mpSound = NULL;
+		mpSoundHandler = NULL;
 		mpCallback = NULL;
+		mpNextWithName = NULL;
+		mlId = -1;
+	}
 
-		if(gbLogEntry)Log("Creating sound entry %d id: %d\n", this, mlId);
+	//-----------------------------------------------------------------------
+
+	cSoundEntry::~cSoundEntry()
+	{
+		Release();
 	}
 
-	///////////////////////////////////////
-	//DEBUG when using pooling test
-	/*void cSoundEntry::Setup(const tString& asName, iSoundChannel* apSound, float afVolume,
-		eSoundEntryType aType, bool ab3D,
-		bool abStream,int alId)
+	//-----------------------------------------------------------------------
+
+	void cSoundEntry::Setup(const tString& asName, iSoundChannel* apSound, float afVolume,
+							eSoundEntryType aType, bool ab3D,
+							bool abStream, int alId,
+							cSoundHandler *apSoundHandler)
 	{
 		msName = cString::ToLowerCase(asName);
 		mpSound = apSound;
@@ -127,6 +105,7 @@ namespace hpl {
 		mType = aType;
 		mbStream = abStream;
 		mlId = alId;
+		mpSoundHandler = apSoundHandler;
 		mb3D = ab3D;
 
 		////////////////////////
@@ -136,6 +115,8 @@ namespace hpl {
 		mfVolumeFadeSpeed =0;
 		mbStopAfterFadeOut = false;
 
+		mbStopDisabled = false;
+
 		mfNormalSpeed = 1;
 
 		mfSpeedMul = 1;
@@ -148,19 +129,14 @@ namespace hpl {
 		mfBlockFadeDest = 1;
 		mfBlockFadeSpeed = 0;
 
-		mpCallback = NULL;
-	}*/
+		mbBlocked = false;
+		mbBlockCheckNeeded = false;
+		mlBlockCheckCount = -1;
 
-	//-----------------------------------------------------------------------
+		mpCallback = NULL;
+		mpNextWithName = NULL;
 
-	cSoundEntry::~cSoundEntry()
-	{
-		if(gbLogEntry)Log("Destroying sound entry %d id: %d\n", this, mlId);
-		if(mpSound)
-		{
-			mpSound->Stop();
-			hplDelete( mpSound );
-		}
+		if(gbLogEntry)Log("Setting up sound entry %d id: %d\n", this, mlId);
 	}
 
 	//-----------------------------------------------------------------------
@@ -313,12 +289,13 @@ namespace hpl {
 		{
 			mpSound->SetVolume(0);
 			mpSound->SetPriority(0);
+			mbBlockCheckNeeded = false;
 			return;
 		}
 
 		////////////////////////////////////////
 		// Check if sound is blocked
-		if(mpSoundHandler->CheckSoundIsBlocked(mpSound->GetPosition()))
+		if(CheckIsBlocked(vListnerPos))
 		{
 			mfBlockFadeDest = 0.0f;
 			mfBlockFadeSpeed = -1.0f / 0.55f;
@@ -376,6 +353,52 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	float cSoundEntry::GetUnblockedVolume(const cVector3f& avListenerPos)
+	{
+		//Same distance fall off as in Update3DSpecifics
+		float fDistVolumeMul = 1.0f;
+		float fDist = cMath::Vector3Dist(mpSound->GetPosition(), avListenerPos);
+		if(fDist >= mpSound->GetMaxDistance())
+		{
+			fDistVolumeMul = 0.0f;
+		}
+		else if(fDist > mpSound->GetMinDistance())
+		{
+			fDistVolumeMul = 1 - (fDist - mpSound->GetMinDistance()) / (mpSound->GetMaxDistance() - mpSound->GetMinDistance());
+		}
+
+		return mfNormalVolume * mfVolumeMul * fDistVolumeMul;
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool cSoundEntry::CheckIsBlocked(const cVector3f& avListenerPos)
+	{
+		///////////////////////////////
+		//Never checked, cast ray right away so the sound starts out right.
+		if(mlBlockCheckCount < 0)
+		{
+			mpSoundHandler->CastBlockRay(this, avListenerPos);
+			return mbBlocked;
+		}
+
+		///////////////////////////////
+		//Use the last result and ask for a new check if needed. The check is done at the start of the next update.
+		float fMaxMoveSqr = mpSoundHandler->mfBlockCheckMoveThreshold * mpSoundHandler->mfBlockCheckMoveThreshold;
+		if(	cMath::Vector3DistSqr(mpSound->GetPosition(), mvBlockCheckSoundPos) > fMaxMoveSqr ||
+			cMath::Vector3DistSqr(avListenerPos, mvBlockCheckListenerPos) > fMaxMoveSqr ||
+			mpSoundHandler->mlCount - mlBlockCheckCount >= mpSoundHandler->mlBlockCheckInterval)
+		{
+			mbBlockCheckNeeded = true;
+		}
+
+		mpSoundHandler->mlBlockRaysSavedCount++;
+
+		return mbBlocked;
+	}
+
+	//-----------------------------------------------------------------------
+
 	void cSoundEntry::Stop()
 	{
 		if(mbStopDisabled) return;
@@ -458,6 +481,22 @@ namespace hpl {
 
 	//-----------------------------------------------------------------------
 
+	void cSoundEntry::Release()
+	{
+		if(mpSound==NULL) return;
+
+		if(gbLogEntry)Log("Releasing sound entry %d id: %d\n", this, mlId);
+
+		mpSound->Stop();
+		hplDelete( mpSound );
+		mpSound = NULL;
+
+		mpCallback = NULL;
+		mpNextWithName = NULL;
+	}
+
+	//-----------------------------------------------------------------------
+
 
 	//////////////////////////////////////////////////////////////////////////
 	// CONSTRUCTORS
@@ -475,19 +514,36 @@ namespace hpl {
 		mlCount =0;
 		mlIdCount = 0;
 
+		mlBlockRayBudget = 8;
+		mfBlockCheckMoveThreshold = 0.25f;
+		mlBlockCheckInterval = 10;
+		mlBlockRayCount = 0;
+		mlBlockRaysSavedCount = 0;
+
 		mbSilent = false;
 
 		mfGlobalVolume[0] = 1;
 		mfGlobalVolume[1] = 1;
 		mfGlobalSpeed[0] = 1;
 		mfGlobalSpeed[1] = 1;
+
+		mvSoundEntryTypeNum[0] = 0;
+		mvSoundEntryTypeNum[1] = 0;
 	}
 
 	//-----------------------------------------------------------------------
 
 	cSoundHandler::~cSoundHandler()
 	{
-		STLDeleteAll(m_lstSoundEntries);
+		for(size_t i=0; i<mvSoundEntries.size(); ++i)
+		{
+			mvSoundEntries[i]->Release();
+		}
+
+		for(size_t i=0; i<mvSoundEntryBlocks.size(); ++i)
+		{
+			hplDeleteArray(mvSoundEntryBlocks[i]);
+		}
 	}
 
 	//-----------------------------------------------------------------------
@@ -513,23 +569,29 @@ namespace hpl {
 		mGlobalSpeedHandler.Update(afTimeStep);
 
 		///////////////////////////////////////////////
-		// Update entries
-		tSoundEntryListIt it = m_lstSoundEntries.begin();
-		for(; it != m_lstSoundEntries.end();)
+		// Cast rays for sounds asking to be checked for blocking
+		mlBlockRayCount = 0;
+		mlBlockRaysSavedCount = 0;
+		UpdateBlockChecks();
+
+		///////////////////////////////////////////////
+		// Update entries and release the ones that are done, keeping the rest in order.
+		// Callbacks might play new sounds, so use indices.
+		size_t lEntryNum = 0;
+		for(size_t i=0; i<mvSoundEntries.size(); ++i)
 		{
-			cSoundEntry *pEntry = *it;
+			cSoundEntry *pEntry = mvSoundEntries[i];
 
 			if(pEntry->Update(afTimeStep) == false)
 			{
-				hplDelete( pEntry );
-				//m_lstSoundEntriesPool.push_back(pEntry);
-				it = m_lstSoundEntries.erase(it);
+				ReleaseEntry(pEntry);
 			}
 			else
 			{
-				++it;
+				mvSoundEntries[lEntryNum++] = pEntry;
 			}
 		}
+		mvSoundEntries.resize(lEntryNum);
 
 		mlCount++;
 	}
@@ -635,21 +697,20 @@ namespace hpl {
 
 		////////////////////////
 		// Create entry
-		cSoundEntry *pEntry = hplNew( cSoundEntry, (asName,pSound,afVolume,aEntryType, ab3D, false,mlIdCount,this) );
-		/*cSoundEntry *pEntry = NULL;
-		if(m_lstSoundEntriesPool.empty())
-		{
-			pEntry = hplNew( cSoundEntry, (asName,pSound,afVolume,aEntryType, ab3D, false,mlIdCount,this) );
-		}
-		else
-		{
-			pEntry = m_lstSoundEntriesPool.back();
-			m_lstSoundEntriesPool.pop_back();
+		cSoundEntry *pEntry = CreateEntry();
+		pEntry->Setup(asName,pSound,afVolume,aEntryType, ab3D, false,mlIdCount,this);
 
-			pEntry->Setup(asName,pSound,afVolume,aEntryType, ab3D, false,mlIdCount);
-		}*/
+		mvSoundEntries.push_back(pEntry);
+		mvSoundEntryTypeNum[aEntryType == eSoundEntryType_World ? 0 : 1]++;
 
-		m_lstSoundEntries.push_back(pEntry);
+		//Add to the name index, after entries with the same name
+		std::pair<tSoundEntryNameMapIt, bool> ret = m_mapSoundEntryNames.insert(tSoundEntryNameMap::value_type(pEntry->GetName(), pEntry));
+		if(ret.second==false)
+		{
+			cSoundEntry *pLast = ret.first->second;
+			while(pLast->mpNextWithName) pLast = pLast->mpNextWithName;
+			pLast->mpNextWithName = pEntry;
+		}
 
 		mlIdCount++;
 
@@ -732,10 +793,11 @@ namespace hpl {
 
 	void cSoundHandler::StopAll(tFlag mTypes)
 	{
-		tSoundEntryListIt it = m_lstSoundEntries.begin();
-		for(; it != m_lstSoundEntries.end(); ++it)
+		if(HasEntriesOfTypes(mTypes)==false) return;
+
+		for(size_t i=0; i<mvSoundEntries.size(); ++i)
 		{
-			cSoundEntry *pEntry = *it;
+			cSoundEntry *pEntry = mvSoundEntries[i];
 
             if(pEntry->GetType() & mTypes)
 			{
@@ -748,10 +810,11 @@ namespace hpl {
 
 	void cSoundHandler::PauseAll(tFlag mTypes)
 	{
-		tSoundEntryListIt it = m_lstSoundEntries.begin();
-		for(; it != m_lstSoundEntries.end(); ++it)
+		if(HasEntriesOfTypes(mTypes)==false) return;
+
+		for(size_t i=0; i<mvSoundEntries.size(); ++i)
 		{
-			cSoundEntry *pEntry = *it;
+			cSoundEntry *pEntry = mvSoundEntries[i];
 
 			if(pEntry->GetType() & mTypes)
 			{
@@ -763,10 +826,11 @@ namespace hpl {
 
 	void cSoundHandler::ResumeAll(tFlag mTypes)
 	{
-		tSoundEntryListIt it = m_lstSoundEntries.begin();
-		for(; it != m_lstSoundEntries.end(); ++it)
+		if(HasEntriesOfTypes(mTypes)==false) return;
+
+		for(size_t i=0; i<mvSoundEntries.size(); ++i)
 		{
-			cSoundEntry *pEntry = *it;
+			cSoundEntry *pEntry = mvSoundEntries[i];
 
 			if(pEntry->GetType() & mTypes)
 			{
@@ -779,10 +843,11 @@ namespace hpl {
 
 	void cSoundHandler::FadeOutAll(tFlag mTypes,float afFadeSpeed, bool abDisableStop)
 	{
-		tSoundEntryListIt it = m_lstSoundEntries.begin();
-		for(; it != m_lstSoundEntries.end(); ++it)
+		if(HasEntriesOfTypes(mTypes)==false) return;
+
+		for(size_t i=0; i<mvSoundEntries.size(); ++i)
 		{
-			cSoundEntry *pEntry = *it;
+			cSoundEntry *pEntry = mvSoundEntries[i];
 
 			if(pEntry->GetType() & mTypes)
 			{
@@ -806,19 +871,8 @@ namespace hpl {
 
 	bool cSoundHandler::IsValid(cSoundEntry *apEntry, int alID)
 	{
-		tSoundEntryListIt it = m_lstSoundEntries.begin();
-		for(; it != m_lstSoundEntries.end(); ++it)
-		{
-			cSoundEntry *pEntry = *it;
-
-			if(pEntry == apEntry)
-			{
-				if(pEntry->GetId() == alID)	return true;
-				else						return false;
-			}
-		}
-
-		return false;
+		//Released entries have no channel and reused ones have a new id.
+		return apEntry && apEntry->mpSound && apEntry->GetId() == alID;
 	}
 
 	//-----------------------------------------------------------------------
@@ -900,7 +954,7 @@ namespace hpl {
 
 	tSoundEntryList* cSoundHandler::GetEntryList()
 	{
-		return &m_lstSoundEntries;
+		return &mvSoundEntries;
 	}
 
 	//-----------------------------------------------------------------------
@@ -930,20 +984,122 @@ namespace hpl {
 
 	cSoundEntry* cSoundHandler::GetEntry(const tString& asName)
 	{
-		tString sLowName = cString::ToLowerCase(asName);
+		tSoundEntryNameMapIt it = m_mapSoundEntryNames.find(cString::ToLowerCase(asName));
+		if(it == m_mapSoundEntryNames.end()) return NULL;
+
+		return it->second;
+	}
 
-		tSoundEntryListIt it = m_lstSoundEntries.begin();
-		for(; it != m_lstSoundEntries.end(); ++it)
+	//-----------------------------------------------------------------------
+
+	cSoundEntry* cSoundHandler::CreateEntry()
+	{
+		////////////////////////
+		//Allocate a new block if the pool is empty
+		if(mvFreeSoundEntries.empty())
 		{
-			cSoundEntry *pEntry = *it;
+			const int lBlockSize = 32;
+			cSoundEntry *pBlock = hplNewArray(cSoundEntry, lBlockSize);
+			mvSoundEntryBlocks.push_back(pBlock);
+
+			for(int i=lBlockSize-1; i>=0; --i) mvFreeSoundEntries.push_back(&pBlock[i]);
+		}
+
+		cSoundEntry *pEntry = mvFreeSoundEntries.back();
+		mvFreeSoundEntries.pop_back();
+
+		return pEntry;
+	}
 
-			if(pEntry->GetName() == sLowName)
+	//-----------------------------------------------------------------------
+
+	void cSoundHandler::ReleaseEntry(cSoundEntry *apEntry)
+	{
+		////////////////////////
+		//Remove from name index
+		tSoundEntryNameMapIt it = m_mapSoundEntryNames.find(apEntry->GetName());
+		if(it != m_mapSoundEntryNames.end())
+		{
+			if(it->second == apEntry)
 			{
-				return pEntry;
+				if(apEntry->mpNextWithName)	it->second = apEntry->mpNextWithName;
+				else						m_mapSoundEntryNames.erase(it);
 			}
+			else
+			{
+				cSoundEntry *pPrev = it->second;
+				while(pPrev->mpNextWithName && pPrev->mpNextWithName != apEntry) pPrev = pPrev->mpNextWithName;
+				if(pPrev->mpNextWithName) pPrev->mpNextWithName = apEntry->mpNextWithName;
+			}
+		}
+
+		mvSoundEntryTypeNum[apEntry->GetType() == eSoundEntryType_World ? 0 : 1]--;
+
+		apEntry->Release();
+		mvFreeSoundEntries.push_back(apEntry);
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool cSoundHandler::HasEntriesOfTypes(tFlag aTypes)
+	{
+		return	((aTypes & eSoundEntryType_World) && mvSoundEntryTypeNum[0] > 0) ||
+				((aTypes & eSoundEntryType_Gui) && mvSoundEntryTypeNum[1] > 0);
+	}
+
+	//-----------------------------------------------------------------------
+
+	static bool SortBlockChecks(const std::pair<float, cSoundEntry*>& aA, const std::pair<float, cSoundEntry*>& aB)
+	{
+		return aA.first > aB.first;
+	}
+
+	void cSoundHandler::UpdateBlockChecks()
+	{
+		cVector3f vListenerPos = mpLowLevelSound->GetListenerPosition();
+
+		///////////////////////////////
+		//Gather entries that want a check. Score is number of updates waited, so all get checked in the end, scaled by priority
+		//and by how loud the sound is at the listener, since a wrong block state is heard the most on close and loud sounds.
+		//The small base volume keeps quiet sounds from waiting much longer than the rest.
+		mvBlockCheckQueue.clear();
+		for(size_t i=0; i<mvSoundEntries.size(); ++i)
+		{
+			cSoundEntry *pEntry = mvSoundEntries[i];
+			if(pEntry->mbBlockCheckNeeded==false) continue;
+
+			float fScore = (float)(mlCount - pEntry->mlBlockCheckCount) * (float)(1 + cMath::Max(pEntry->mpSound->GetPriority(), 0)) *
+							(0.1f + pEntry->GetUnblockedVolume(vListenerPos));
+			mvBlockCheckQueue.push_back(std::pair<float, cSoundEntry*>(fScore, pEntry));
+		}
+		if(mvBlockCheckQueue.empty()) return;
+
+		///////////////////////////////
+		//Cast rays for the most important ones
+		int lNum = (int)mvBlockCheckQueue.size();
+		if(mlBlockRayBudget > 0 && lNum > mlBlockRayBudget)
+		{
+			lNum = mlBlockRayBudget;
+			std::partial_sort(mvBlockCheckQueue.begin(), mvBlockCheckQueue.begin() + lNum, mvBlockCheckQueue.end(), SortBlockChecks);
+		}
+
+		for(int i=0; i<lNum; ++i)
+		{
+			CastBlockRay(mvBlockCheckQueue[i].second, vListenerPos);
 		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cSoundHandler::CastBlockRay(cSoundEntry *apEntry, const cVector3f& avListenerPos)
+	{
+		apEntry->mbBlocked = CheckSoundIsBlocked(apEntry->mpSound->GetPosition());
+		apEntry->mbBlockCheckNeeded = false;
+		apEntry->mlBlockCheckCount = mlCount;
+		apEntry->mvBlockCheckSoundPos = apEntry->mpSound->GetPosition();
+		apEntry->mvBlockCheckListenerPos = avListenerPos;
 
-		return NULL;
+		mlBlockRayCount++;
 	}
 
 	//-----------------------------------------------------------------------
@@ -0,0 +1,395 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "system/JobManager.h"
+
+#include "system/Platform.h"
+#include "system/Mutex.h"
+#include "system/Profiler.h"
+#include "system/LowLevelSystem.h"
+#include "system/String.h"
+#include "system/MemoryManager.h"
+
+namespace hpl {
+
+	//////////////////////////////////////////////////////////////////////////
+	// STATIC DATA
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	cJobManager* cJobManager::mpGlobal = NULL;
+
+	//The queue the current thread owns, only set for workers.
+	static thread_local cJobManager *gpThreadJobManager = NULL;
+	static thread_local int glThreadJobQueue = -1;
+
+	//Number of times an idle worker yields before going to sleep.
+	static const int glJobWorkerSpinNum = 64;
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// JOB QUEUE
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	cJobQueue::cJobQueue()
+	{
+		mpMutex = cPlatform::CreateMutEx();
+	}
+
+	cJobQueue::~cJobQueue()
+	{
+		hplDelete(mpMutex);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cJobQueue::PushBack(const cJob& aJob)
+	{
+		mpMutex->Lock();
+		mdqJobs.push_back(aJob);
+		mpMutex->Unlock();
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool cJobQueue::PopBack(cJob* apJob, cJobCounter *apCounter)
+	{
+		bool bFound = false;
+
+		mpMutex->Lock();
+		for(std::deque<cJob>::iterator it = mdqJobs.end(); it != mdqJobs.begin(); )
+		{
+			--it;
+			if(apCounter && it->mpCounter != apCounter) continue;
+
+			*apJob = *it;
+			mdqJobs.erase(it);
+			bFound = true;
+			break;
+		}
+		mpMutex->Unlock();
+
+		return bFound;
+	}
+
+	bool cJobQueue::StealFront(cJob* apJob, cJobCounter *apCounter)
+	{
+		bool bFound = false;
+
+		mpMutex->Lock();
+		for(std::deque<cJob>::iterator it = mdqJobs.begin(); it != mdqJobs.end(); ++it)
+		{
+			if(apCounter && it->mpCounter != apCounter) continue;
+
+			*apJob = *it;
+			mdqJobs.erase(it);
+			bFound = true;
+			break;
+		}
+		mpMutex->Unlock();
+
+		return bFound;
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// JOB WORKER
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	cJobWorker::cJobWorker(cJobManager *apManager, int alQueue)
+	{
+		mpManager = apManager;
+		mlQueue = alQueue;
+
+		mpThread = cPlatform::CreateThread(this);
+		mpThread->SetSleepTime(1);
+	}
+
+	cJobWorker::~cJobWorker()
+	{
+		hplDelete(mpThread);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cJobWorker::UpdateThread()
+	{
+		if(glThreadJobQueue != mlQueue)
+		{
+			gpThreadJobManager = mpManager;
+			glThreadJobQueue = mlQueue;
+			cProfiler::SetThreadName("Job Worker "+cString::ToString(mlQueue));
+		}
+
+		////////////////////////////
+		// Run jobs until there has been nothing to do for a while, the thread then sleeps before the next update.
+		int lIdleCount = 0;
+		while(lIdleCount < glJobWorkerSpinNum && mpThread->IsActive())
+		{
+			if(mpManager->RunJob(mlQueue))
+			{
+				lIdleCount = 0;
+			}
+			else
+			{
+				++lIdleCount;
+				cPlatform::Sleep(0);
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// CONSTRUCTORS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	cJobManager::cJobManager(int alWorkerNum)
+	{
+		if(alWorkerNum < 0) alWorkerNum = cPlatform::GetCPUCount() - 1;
+		if(alWorkerNum < 0) alWorkerNum = 0;
+
+		mpPendingMutex = cPlatform::CreateMutEx();
+		mlPendingNum = 0;
+
+		Log(" Creating job manager with %d workers\n", alWorkerNum);
+
+		mvQueues.resize(alWorkerNum+1);
+		for(size_t i=0; i<mvQueues.size(); ++i) mvQueues[i] = hplNew(cJobQueue, ());
+
+		mvWorkers.resize(alWorkerNum);
+		for(int i=0; i<alWorkerNum; ++i)
+		{
+			mvWorkers[i] = hplNew(cJobWorker, (this, i));
+			mvWorkers[i]->mpThread->Start();
+		}
+
+		if(mpGlobal==NULL) mpGlobal = this;
+	}
+
+	//-----------------------------------------------------------------------
+
+	cJobManager::~cJobManager()
+	{
+		//Finish all jobs still queued so no one is left waiting
+		while(RunJob());
+
+		for(size_t i=0; i<mvWorkers.size(); ++i)
+		{
+			mvWorkers[i]->mpThread->Stop();
+			hplDelete(mvWorkers[i]);
+		}
+		STLDeleteAll(mvQueues);
+		hplDelete(mpPendingMutex);
+
+		if(mpGlobal==this) mpGlobal = NULL;
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// PUBLIC METHODS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	void cJobManager::AddJob(tJobFunc apFunc, void *apData, int alStart, int alEnd, cJobCounter *apCounter, cJobCounter *apWaitCounter)
+	{
+		cJob job;
+		job.mpFunc = apFunc;
+		job.mpData = apData;
+		job.mlStart = alStart;
+		job.mlEnd = alEnd;
+		job.mpCounter = apCounter;
+		job.mpWaitCounter = apWaitCounter;
+
+		if(apCounter) apCounter->mlCount.fetch_add(1);
+
+		if(apWaitCounter && apWaitCounter->IsDone()==false)
+		{
+			mpPendingMutex->Lock();
+			mlstPendingJobs.push_back(job);
+			mlPendingNum.fetch_add(1);
+			mpPendingMutex->Unlock();
+			return;
+		}
+
+		mvQueues[GetCurrentQueue()]->PushBack(job);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cJobManager::AddParallelFor(int alStart, int alEnd, int alGrainSize, tJobFunc apFunc, void *apData, cJobCounter *apCounter, cJobCounter *apWaitCounter)
+	{
+		if(alEnd <= alStart) return;
+		if(alGrainSize < 1) alGrainSize = 1;
+
+		for(int lStart = alStart; lStart < alEnd; lStart += alGrainSize)
+		{
+			int lEnd = lStart + alGrainSize < alEnd ? lStart + alGrainSize : alEnd;
+			AddJob(apFunc, apData, lStart, lEnd, apCounter, apWaitCounter);
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cJobManager::ParallelFor(int alStart, int alEnd, int alGrainSize, tJobFunc apFunc, void *apData)
+	{
+		if(alEnd <= alStart) return;
+
+		//Nothing to gain from the job overhead, just run it.
+		if(mvWorkers.empty() || alEnd - alStart <= alGrainSize)
+		{
+			apFunc(apData, alStart, alEnd);
+			return;
+		}
+
+		cJobCounter counter;
+		AddParallelFor(alStart, alEnd, alGrainSize, apFunc, apData, &counter);
+		Wait(&counter);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cJobManager::Wait(cJobCounter *apCounter)
+	{
+		int lQueue = GetCurrentQueue();
+		while(apCounter->IsDone()==false)
+		{
+			//Only help with the group, an unrelated long job would hold up the wait.
+			if(RunJob(lQueue, apCounter)) continue;
+
+			//Jobs of the group that wait for another counter need other jobs to run first.
+			if(HasPendingJobs(apCounter) && RunJob(lQueue)) continue;
+
+			cPlatform::Sleep(0);
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool cJobManager::RunJob()
+	{
+		return RunJob(GetCurrentQueue());
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// PRIVATE METHODS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	int cJobManager::GetCurrentQueue()
+	{
+		if(gpThreadJobManager == this) return glThreadJobQueue;
+		return (int)mvQueues.size()-1;
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool cJobManager::FindJob(int alQueue, cJob* apJob, cJobCounter *apCounter)
+	{
+		QueuePendingJobs();
+
+		//Newest job in the own queue first, it is most likely to have its data in the cache.
+		if(mvQueues[alQueue]->PopBack(apJob, apCounter)) return true;
+
+		//Steal the oldest job from the others, starting with the queue after our own so not all go for the same one.
+		int lQueueNum = (int)mvQueues.size();
+		for(int i=1; i<lQueueNum; ++i)
+		{
+			int lQueue = (alQueue + i) % lQueueNum;
+			if(mvQueues[lQueue]->StealFront(apJob, apCounter)) return true;
+		}
+
+		return false;
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool cJobManager::RunJob(int alQueue, cJobCounter *apCounter)
+	{
+		cJob job;
+		if(FindJob(alQueue, &job, apCounter)==false) return false;
+
+		job.mpFunc(job.mpData, job.mlStart, job.mlEnd);
+
+		if(job.mpCounter) job.mpCounter->mlCount.fetch_sub(1);
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cJobManager::QueuePendingJobs()
+	{
+		if(mlPendingNum.load()==0) return;
+
+		mpPendingMutex->Lock();
+		for(tJobListIt it = mlstPendingJobs.begin(); it != mlstPendingJobs.end(); )
+		{
+			if(it->mpWaitCounter->IsDone())
+			{
+				mvQueues.back()->PushBack(*it);
+				it = mlstPendingJobs.erase(it);
+				mlPendingNum.fetch_sub(1);
+			}
+			else
+			{
+				++it;
+			}
+		}
+		mpPendingMutex->Unlock();
+	}
+
+	//-----------------------------------------------------------------------
+
+	bool cJobManager::HasPendingJobs(cJobCounter *apCounter)
+	{
+		if(mlPendingNum.load()==0) return false;
+
+		bool bFound = false;
+		mpPendingMutex->Lock();
+		for(tJobListIt it = mlstPendingJobs.begin(); it != mlstPendingJobs.end(); ++it)
+		{
+			if(it->mpCounter == apCounter)
+			{
+				bFound = true;
+				break;
+			}
+		}
+		mpPendingMutex->Unlock();
+
+		return bFound;
+	}
+
+	//-----------------------------------------------------------------------
+
+}
@@ -0,0 +1,444 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "system/Profiler.h"
+
+#include "system/Platform.h"
+#include "system/Mutex.h"
+#include "system/LowLevelSystem.h"
+#include "system/String.h"
+#include "system/MemoryManager.h"
+
+#include <algorithm>
+#include <stdio.h>
+
+namespace hpl {
+
+	//////////////////////////////////////////////////////////////////////////
+	// STATIC DATA
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	bool cProfiler::mbActive = true;
+	int cProfiler::mlBufferSize = 0;
+	int cProfiler::mlFrame = 0;
+	uint64_t cProfiler::mlFrameStart = 0;
+
+	iMutex* cProfiler::mpMutex = NULL;
+	tProfilerThreadBufferVec cProfiler::mvThreadBuffers;
+	tStringSet cProfiler::m_setZoneNames;
+
+	tProfilerZoneStatsVec cProfiler::mvLastFrameStats;
+	double cProfiler::mfLastFrameTime = 0;
+	double cProfiler::mfSpikeLogLimit = 0;
+
+	//Increased on each Init, so buffers from a previous init are not used.
+	static int glProfilerGeneration = 0;
+
+	static thread_local cProfilerThreadBuffer* gpProfilerThreadBuffer = NULL;
+	static thread_local int glProfilerThreadGeneration = -1;
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// THREAD BUFFER
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	cProfilerThreadBuffer::cProfilerThreadBuffer(int alId, int alSize)
+	{
+		mlId = alId;
+		msName = "Thread "+cString::ToString(alId);
+
+		mvZones.resize(alSize);
+		mlWritePos = 0;
+		mlZoneNum = 0;
+
+		mlDepth = 0;
+		mvStartTimes.resize(64);
+		mvStartNames.resize(64);
+
+		mpMutex = cPlatform::CreateMutEx();
+	}
+
+	cProfilerThreadBuffer::~cProfilerThreadBuffer()
+	{
+		hplDelete(mpMutex);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cProfilerThreadBuffer::Add(const cProfilerZoneData& aZone)
+	{
+		mpMutex->Lock();
+
+		mvZones[mlWritePos] = aZone;
+		mlWritePos++;
+		if(mlWritePos >= mvZones.size()) mlWritePos = 0;
+		mlZoneNum++;
+
+		mpMutex->Unlock();
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// PUBLIC METHODS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	void cProfiler::Init(int alBufferSize)
+	{
+		if(mpMutex) return;
+
+		mpMutex = cPlatform::CreateMutEx();
+		mlBufferSize = alBufferSize;
+		mlFrame = 0;
+		mlFrameStart = cPlatform::GetApplicationTimeNanoSec();
+		glProfilerGeneration++;
+
+		SetThreadName("Main");
+	}
+
+	void cProfiler::Exit()
+	{
+		if(mpMutex==NULL) return;
+
+		STLDeleteAll(mvThreadBuffers);
+		m_setZoneNames.clear();
+		mvLastFrameStats.clear();
+
+		hplDelete(mpMutex);
+		mpMutex = NULL;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cProfiler::BeginZone(const char *apName)
+	{
+		cProfilerThreadBuffer *pBuffer = GetThreadBuffer();
+		if(pBuffer==NULL) return;
+
+		if(pBuffer->mlDepth >= (int)pBuffer->mvStartTimes.size())
+		{
+			pBuffer->mvStartTimes.resize(pBuffer->mvStartTimes.size()*2);
+			pBuffer->mvStartNames.resize(pBuffer->mvStartNames.size()*2);
+		}
+
+		//Zones started while not active are still pushed, so begin and end always match up. 0 means skip.
+		pBuffer->mvStartNames[pBuffer->mlDepth] = apName;
+		pBuffer->mvStartTimes[pBuffer->mlDepth] = mbActive ? cPlatform::GetApplicationTimeNanoSec() : 0;
+		pBuffer->mlDepth++;
+
+		if(mbActive && GetUpdateLogActive()) LogUpdate("Updating %s\n", apName);
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cProfiler::EndZone()
+	{
+		cProfilerThreadBuffer *pBuffer = GetThreadBuffer();
+		if(pBuffer==NULL || pBuffer->mlDepth<=0) return;
+
+		pBuffer->mlDepth--;
+		uint64_t lStart = pBuffer->mvStartTimes[pBuffer->mlDepth];
+		if(lStart==0 || mbActive==false) return;
+
+		cProfilerZoneData zone;
+		zone.mpName = pBuffer->mvStartNames[pBuffer->mlDepth];
+		zone.mlStart = lStart;
+		zone.mlEnd = cPlatform::GetApplicationTimeNanoSec();
+		zone.mlDepth = pBuffer->mlDepth;
+		zone.mlFrame = mlFrame;
+
+		pBuffer->Add(zone);
+
+		if(GetUpdateLogActive()) LogUpdate(" Time spent in %s: %f ms\n", zone.mpName, (double)(zone.mlEnd - zone.mlStart) / 1000000.0);
+	}
+
+	//-----------------------------------------------------------------------
+
+	const char* cProfiler::GetZoneName(const tString& asName)
+	{
+		if(mpMutex==NULL) return "";
+
+		mpMutex->Lock();
+		const char *pName = m_setZoneNames.insert(asName).first->c_str();
+		mpMutex->Unlock();
+
+		return pName;
+	}
+
+	//-----------------------------------------------------------------------
+
+	int cProfiler::GetGeneration()
+	{
+		return mpMutex ? glProfilerGeneration : 0;
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cProfiler::SetThreadName(const tString& asName)
+	{
+		cProfilerThreadBuffer *pBuffer = GetThreadBuffer();
+		if(pBuffer==NULL) return;
+
+		pBuffer->mpMutex->Lock();
+		pBuffer->msName = asName;
+		pBuffer->mpMutex->Unlock();
+	}
+
+	//-----------------------------------------------------------------------
+
+	void cProfiler::NewFrame()
+	{
+		if(mpMutex==NULL) return;
+
+		uint64_t lTime = cPlatform::GetApplicationTimeNanoSec();
+		mfLastFrameTime = (double)(lTime - mlFrameStart) / 1000000.0;
+		mlFrameStart = lTime;
+
+		int lFrame = mlFrame;
+		mlFrame++;
+
+		if(mbActive==false) return;
+
+		AggregateFrame(lFrame);
+
+		if(mfSpikeLogLimit > 0 && mfLastFrameTime > mfSpikeLogLimit)
+		{
+			Log("Frame %d took %f ms (limit %f ms):\n", lFrame, mfLastFrameTime, mfSpikeLogLimit);
+			LogLastFrame();
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	static void LogZoneStats(const tProfilerZoneStatsVec& avStats, int alParent, int alIndent)
+	{
+		tString sIndent(alIndent*2, ' ');
+		for(size_t i=0; i<avStats.size(); ++i)
+		{
+			const cProfilerZoneStats& stats = avStats[i];
+			if(stats.mlParent != alParent) continue;
+
+			Log(" %s%s: %f ms (%d calls, max %f ms)\n", sIndent.c_str(), stats.mpName, stats.mfTotalTime, stats.mlCalls, stats.mfMaxTime);
+
+			LogZoneStats(avStats, (int)i, alIndent+1);
+		}
+	}
+
+	void cProfiler::LogLastFrame()
+	{
+		int lThread = -1;
+		for(size_t i=0; i<mvLastFrameStats.size(); ++i)
+		{
+			const cProfilerZoneStats& stats = mvLastFrameStats[i];
+			if(stats.mlParent != -1) continue;
+
+			if(stats.mlThread != lThread)
+			{
+				lThread = stats.mlThread;
+				Log(" Thread %d:\n", lThread);
+			}
+
+			Log("  %s: %f ms (%d calls, max %f ms)\n", stats.mpName, stats.mfTotalTime, stats.mlCalls, stats.mfMaxTime);
+			LogZoneStats(mvLastFrameStats, (int)i, 2);
+		}
+	}
+
+	//-----------------------------------------------------------------------
+
+	static void WriteJsonString(FILE *apFile, const char *apString)
+	{
+		fputc('"', apFile);
+		for(const char *pChar = apString; *pChar; ++pChar)
+		{
+			if(*pChar == '"' || *pChar == '\\')	fputc('\\', apFile);
+			if((unsigned char)*pChar < 0x20)	continue;
+			fputc(*pChar, apFile);
+		}
+		fputc('"', apFile);
+	}
+
+	bool cProfiler::SaveChromeTrace(const tWString& asFile)
+	{
+		if(mpMutex==NULL) return false;
+
+		FILE *pFile = cPlatform::OpenFile(asFile, _W("w"));
+		if(pFile==NULL)
+		{
+			Error("Could not open '%s' for writing profiler trace!\n", cString::To8Char(asFile).c_str());
+			return false;
+		}
+
+		fprintf(pFile, "{\"traceEvents\":[\n");
+		bool bFirst = true;
+
+		mpMutex->Lock();
+		for(size_t i=0; i<mvThreadBuffers.size(); ++i)
+		{
+			cProfilerThreadBuffer *pBuffer = mvThreadBuffers[i];
+			pBuffer->mpMutex->Lock();
+
+			////////////////////////////
+			// Thread name
+			if(bFirst==false) fprintf(pFile, ",\n");
+			bFirst = false;
+			fprintf(pFile, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":", pBuffer->mlId);
+			WriteJsonString(pFile, pBuffer->msName.c_str());
+			fprintf(pFile, "}}");
+
+			////////////////////////////
+			// Zones, oldest first
+			size_t lSize = pBuffer->mvZones.size();
+			size_t lNum = pBuffer->mlZoneNum < lSize ? pBuffer->mlZoneNum : lSize;
+			size_t lFirst = pBuffer->mlZoneNum < lSize ? 0 : pBuffer->mlWritePos;
+			for(size_t zone=0; zone<lNum; ++zone)
+			{
+				const cProfilerZoneData& data = pBuffer->mvZones[(lFirst + zone) % lSize];
+
+				fprintf(pFile, ",\n{\"name\":");
+				WriteJsonString(pFile, data.mpName);
+				fprintf(pFile, ",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%d}}",
+						pBuffer->mlId, (double)data.mlStart / 1000.0, (double)(data.mlEnd - data.mlStart) / 1000.0, data.mlFrame);
+			}
+
+			pBuffer->mpMutex->Unlock();
+		}
+		mpMutex->Unlock();
+
+		fprintf(pFile, "\n]}\n");
+		fclose(pFile);
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------
+
+	//////////////////////////////////////////////////////////////////////////
+	// PRIVATE METHODS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	cProfilerThreadBuffer* cProfiler::GetThreadBuffer()
+	{
+		if(mpMutex==NULL) return NULL;
+		if(glProfilerThreadGeneration == glProfilerGeneration) return gpProfilerThreadBuffer;
+
+		mpMutex->Lock();
+		gpProfilerThreadBuffer = hplNew( cProfilerThreadBuffer, ((int)mvThreadBuffers.size(), mlBufferSize) );
+		mvThreadBuffers.push_back(gpProfilerThreadBuffer);
+		mpMutex->Unlock();
+
+		glProfilerThreadGeneration = glProfilerGeneration;
+
+		return gpProfilerThreadBuffer;
+	}
+
+	//-----------------------------------------------------------------------
+
+	static bool SortZonesByStart(const cProfilerZoneData& aZoneA, const cProfilerZoneData& aZoneB)
+	{
+		if(aZoneA.mlStart != aZoneB.mlStart) return aZoneA.mlStart < aZoneB.mlStart;
+		return aZoneA.mlDepth < aZoneB.mlDepth;
+	}
+
+	void cProfiler::AggregateFrame(int alFrame)
+	{
+		mvLastFrameStats.clear();
+
+		std::vector<cProfilerZoneData> vZones;
+		std::vector<int> vStack;
+
+		mpMutex->Lock();
+		for(size_t thread=0; thread<mvThreadBuffers.size(); ++thread)
+		{
+			cProfilerThreadBuffer *pBuffer = mvThreadBuffers[thread];
+
+			////////////////////////////
+			// Get the zones of the frame, newest zones are last so go backwards until an older frame is found.
+			vZones.clear();
+			pBuffer->mpMutex->Lock();
+			size_t lSize = pBuffer->mvZones.size();
+			size_t lNum = pBuffer->mlZoneNum < lSize ? pBuffer->mlZoneNum : lSize;
+			for(size_t i=0; i<lNum; ++i)
+			{
+				const cProfilerZoneData& data = pBuffer->mvZones[(pBuffer->mlWritePos + lSize - 1 - i) % lSize];
+				if(data.mlFrame < alFrame) break;
+				if(data.mlFrame == alFrame) vZones.push_back(data);
+			}
+			pBuffer->mpMutex->Unlock();
+
+			////////////////////////////
+			// Build tree, parents start before children
+			std::sort(vZones.begin(), vZones.end(), SortZonesByStart);
+
+			vStack.clear();
+			for(size_t i=0; i<vZones.size(); ++i)
+			{
+				const cProfilerZoneData& data = vZones[i];
+
+				//Parents that are not part of the frame are skipped
+				if((int)vStack.size() > data.mlDepth) vStack.resize(data.mlDepth);
+				int lParent = vStack.empty() ? -1 : vStack.back();
+
+				int lNode = -1;
+				for(size_t node = lParent+1; node<mvLastFrameStats.size(); ++node)
+				{
+					cProfilerZoneStats& stats = mvLastFrameStats[node];
+					if(stats.mlParent == lParent && stats.mlThread == pBuffer->mlId && stats.mpName == data.mpName)
+					{
+						lNode = (int)node;
+						break;
+					}
+				}
+				if(lNode < 0)
+				{
+					cProfilerZoneStats stats;
+					stats.mpName = data.mpName;
+					stats.mlThread = pBuffer->mlId;
+					stats.mlDepth = (int)vStack.size();
+					stats.mlParent = lParent;
+					stats.mlCalls = 0;
+					stats.mfTotalTime = 0;
+					stats.mfMaxTime = 0;
+
+					lNode = (int)mvLastFrameStats.size();
+					mvLastFrameStats.push_back(stats);
+				}
+
+				cProfilerZoneStats& stats = mvLastFrameStats[lNode];
+				double fTime = (double)(data.mlEnd - data.mlStart) / 1000000.0;
+				stats.mlCalls++;
+				stats.mfTotalTime += fTime;
+				if(fTime > stats.mfMaxTime) stats.mfMaxTime = fTime;
+
+				vStack.push_back(lNode);
+			}
+		}
+		mpMutex->Unlock();
+	}
+
+	//-----------------------------------------------------------------------
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "system/Script.h"
+
+#include "system/String.h"
+
+namespace hpl {
+
+	//////////////////////////////////////////////////////////////////////////
+	// SCRIPT ARGS
+	//////////////////////////////////////////////////////////////////////////
+
+	//-----------------------------------------------------------------------
+
+	tString cScriptArgs::ToString() const
+	{
+		tString sArgs = "(";
+		for(int i=0; i<mlNum; ++i)
+		{
+			if(i>0) sArgs += ", ";
+
+			switch(mvTypes[i])
+			{
+			case eScriptArgType_Bool:	sArgs += mvInts[i] ? "true" : "false"; break;
+			case eScriptArgType_Int:	sArgs += cString::ToString(mvInts[i]); break;
+			case eScriptArgType_Float:	sArgs += cString::ToString(mvFloats[i]); break;
+			case eScriptArgType_String:	sArgs += "\""+mvStrings[i]+"\""; break;
+			default: break;
+			}
+		}
+		sArgs += ")";
+
+		return sArgs;
+	}
+
+	//-----------------------------------------------------------------------
+
+}
@@ -20,6 +20,7 @@
 #include "system/String.h"
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 
 #include "system/LowLevelSystem.h"
 
@@ -730,21 +731,51 @@ namespace hpl {
 	{
 		if(asString==NULL)return abDefault;
 
-		tString asTempString = ToLowerCase(asString);
-		return asTempString == "true"?true:false;
+		const char *pTrue = "true";
+		for(; *pTrue; ++pTrue, ++asString)
+		{
+			if(tolower(*asString) != *pTrue) return false;
+		}
+		return *asString==0;
 	}
 
 	//-----------------------------------------------------------------------
 
-	cColor cString::ToColor(const char* asString, const cColor& aDefault)
+	/**
+	 * Parses floats separated the same way as GetStringVec does by default, without any temporary strings.
+	 * Returns the number of values in the string, only the first alMaxNum are written.
+	 */
+	static int ParseFloatArray(const char* asString, float *apValues, int alMaxNum)
 	{
-		if(asString==NULL)return aDefault;
+		int lNum = 0;
+		const char *pChar = asString;
+		while(*pChar)
+		{
+			char c = *pChar;
+			if(c==' ' || c=='\n' || c=='\r' || c=='\t' || c==',')
+			{
+				++pChar;
+				continue;
+			}
 
-		tFloatVec vValues;
+			if(lNum < alMaxNum) apValues[lNum] = (float)atof(pChar);
+			++lNum;
 
-		GetFloatVec(asString,vValues,NULL);
+			//Skip to the end of the word
+			while(*pChar && *pChar!=' ' && *pChar!='\n' && *pChar!='\r' && *pChar!='\t' && *pChar!=',') ++pChar;
+		}
+
+		return lNum;
+	}
+
+	//-----------------------------------------------------------------------
 
-		if(vValues.size() != 4) return aDefault;
+	cColor cString::ToColor(const char* asString, const cColor& aDefault)
+	{
+		if(asString==NULL)return aDefault;
+
+		float vValues[4];
+		if(ParseFloatArray(asString, vValues, 4) != 4) return aDefault;
 
 		return cColor(vValues[0],vValues[1],vValues[2],vValues[3]);
 	}
@@ -755,11 +786,8 @@ namespace hpl {
 	{
 		if(asString==NULL) return avDefault;
 
-		tFloatVec vValues;
-
-		GetFloatVec(asString,vValues,NULL);
-
-		if(vValues.size() != 2) return avDefault;
+		float vValues[2];
+		if(ParseFloatArray(asString, vValues, 2) != 2) return avDefault;
 
 		return cVector2f(vValues[0],vValues[1]);
 	}
@@ -770,11 +798,8 @@ namespace hpl {
 	{
 		if(asString==NULL) return avDefault;
 
-		tFloatVec vValues;
-
-		GetFloatVec(asString,vValues,NULL);
-
-		if(vValues.size() != 3) return avDefault;
+		float vValues[3];
+		if(ParseFloatArray(asString, vValues, 3) != 3) return avDefault;
 
 		return cVector3f(vValues[0],vValues[1],vValues[2]);
 	}
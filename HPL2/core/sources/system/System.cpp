@@ -20,6 +20,7 @@
 #include "system/System.h"
 #include "system/LowLevelSystem.h"
 #include "system/LogicTimer.h"
+#include "system/JobManager.h"
 #include "system/String.h"
 
 namespace hpl {
@@ -33,6 +34,8 @@ namespace hpl {
 	cSystem::cSystem(iLowLevelSystem *apLowLevelSystem)
 	{
 		mpLowLevelSystem = apLowLevelSystem;
+
+		mpJobManager = NULL;
 	}
 
 	//-----------------------------------------------------------------------
@@ -42,6 +45,8 @@ namespace hpl {
 		Log("Exiting System Module\n");
 		Log("--------------------------------------------------------\n");
 
+		if(mpJobManager) hplDelete(mpJobManager);
+
 		Log("--------------------------------------------------------\n\n");
 	}
 
@@ -51,6 +56,16 @@ namespace hpl {
 	// PUBLIC METHODS
 	//////////////////////////////////////////////////////////////////////////
 
+	//-----------------------------------------------------------------------
+
+	void cSystem::Init(int alJobWorkerNum)
+	{
+		if(mpJobManager) return;
+
+		//The first job manager created becomes the global one.
+		mpJobManager = hplNew( cJobManager, (alJobWorkerNum) );
+	}
+
 	//-----------------------------------------------------------------------
 	cLogicTimer * cSystem::CreateLogicTimer(unsigned int alUpdatesPerSec)
 	{
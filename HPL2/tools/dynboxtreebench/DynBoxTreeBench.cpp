@@ -0,0 +1,324 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Stress benchmark for the dynamic renderable container (cRenderableContainer_DynBoxTree). Thousands of box props
+ * are dropped into a walled pit with the null graphics backend, and a part of them is kicked each frame so they
+ * keep moving. Each frame the physics is stepped, the container is updated and a few frustum queries are run.
+ * The container update time is printed as average and worst frame, since spikes were the problem with rebuilds.
+ * The props are created at the origin before they are placed, just like map entities, so the insert time and the
+ * tree depth after it show how the tree copes with many objects at the same spot.
+ * Only the iRenderableContainer interface is used, so the same tool can be run against older trees.
+ *
+ *   DynBoxTreeBench [-props <num>] [-frames <num>] [-kick <percent of props per frame>]
+ */
+
+#include "hpl.h"
+
+using namespace hpl;
+
+cEngine *gpEngine=NULL;
+
+//------------------------------------------
+
+int glPropNum = 4000;
+int glFrames = 1000;
+float gfKickPercent = 5;
+
+//------------------------------------------
+
+void ParseCommandLine(const tString &asCommandLine)
+{
+	tStringVec args;
+	tString sSepp = " ";
+	cString::GetStringVec(asCommandLine, args,&sSepp);
+
+	for(size_t i=0; i<args.size(); ++i)
+	{
+		const tString &sArg = args[i];
+
+		if(sArg == "-props" && i+1 < args.size())
+		{
+			glPropNum = cMath::Max(cString::ToInt(args[++i].c_str(), glPropNum), 1);
+		}
+		else if(sArg == "-frames" && i+1 < args.size())
+		{
+			glFrames = cMath::Max(cString::ToInt(args[++i].c_str(), glFrames), 1);
+		}
+		else if(sArg == "-kick" && i+1 < args.size())
+		{
+			gfKickPercent = cMath::Clamp(cString::ToFloat(args[++i].c_str(), gfKickPercent), 0.0f, 100.0f);
+		}
+	}
+}
+
+//------------------------------------------
+
+//Fixed seed, so each run moves the props the same way
+unsigned int glRandSeed = 12345;
+
+float RandFloat(float afMin, float afMax)
+{
+	glRandSeed = glRandSeed * 1664525u + 1013904223u;
+	return afMin + (afMax-afMin) * ((float)(glRandSeed >> 8) / (float)(1 << 24));
+}
+
+//------------------------------------------
+
+//////////////////////////////////////////////////////////////////////////
+// TREE QUERIES
+//////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------
+
+int CountVisibleObjectsInNode(iRenderableContainerNode *apNode, cFrustum *apFrustum)
+{
+	if(apFrustum->CollideNode(apNode) == eCollision_Outside) return 0;
+
+	int lCount = 0;
+	for(tRenderableListIt it = apNode->GetObjectList()->begin(); it != apNode->GetObjectList()->end(); ++it)
+	{
+		if((*it)->CollidesWithFrustum(apFrustum)) ++lCount;
+	}
+
+	for(tRenderableContainerNodeListIt it = apNode->GetChildNodeList()->begin(); it != apNode->GetChildNodeList()->end(); ++it)
+	{
+		lCount += CountVisibleObjectsInNode(*it, apFrustum);
+	}
+
+	return lCount;
+}
+
+//------------------------------------------
+
+void GetTreeSize(iRenderableContainerNode *apNode, int alDepth, int *apNodeNum, int *apMaxDepth)
+{
+	++(*apNodeNum);
+	if(alDepth > *apMaxDepth) *apMaxDepth = alDepth;
+
+	for(tRenderableContainerNodeListIt it = apNode->GetChildNodeList()->begin(); it != apNode->GetChildNodeList()->end(); ++it)
+	{
+		GetTreeSize(*it, alDepth+1, apNodeNum, apMaxDepth);
+	}
+}
+
+//------------------------------------------
+
+//////////////////////////////////////////////////////////////////////////
+// BENCHMARK
+//////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------
+
+class cFrameTime
+{
+public:
+	cFrameTime() : mlTotal(0), mlMax(0) {}
+
+	void Add(uint64_t alTime)
+	{
+		mlTotal += alTime;
+		if(alTime > mlMax) mlMax = alTime;
+	}
+
+	void Print(const char *apName)
+	{
+		printf(" %-20s avg %8.3f ms  worst %8.3f ms\n", apName,
+				(double)mlTotal / 1000000.0 / (double)glFrames, (double)mlMax / 1000000.0);
+	}
+
+	uint64_t mlTotal;
+	uint64_t mlMax;
+};
+
+//------------------------------------------
+
+bool RunBenchmark()
+{
+	////////////////////////////
+	// World and physics
+	cWorld *pWorld = gpEngine->GetScene()->CreateWorld("DynBoxTreeBench");
+	iPhysicsWorld *pPhysicsWorld = gpEngine->GetPhysics()->CreateWorld(false);
+	pWorld->SetPhysicsWorld(pPhysicsWorld);
+
+	//The pit is sized so the props can be dropped from a grid with some space between them
+	float fPitSize = cMath::Max(sqrtf((float)glPropNum) * 1.2f, 10.0f);
+	pPhysicsWorld->SetWorldSize(cVector3f(-fPitSize, -10, -fPitSize), cVector3f(fPitSize, 200, fPitSize));
+
+	////////////////////////////
+	// Floor and walls
+	cVector3f vWallPos[5] = {	cVector3f(0,-0.5f,0), cVector3f(fPitSize*0.5f+0.5f,5,0), cVector3f(-fPitSize*0.5f-0.5f,5,0),
+								cVector3f(0,5,fPitSize*0.5f+0.5f), cVector3f(0,5,-fPitSize*0.5f-0.5f)};
+	cVector3f vWallSize[5] = {	cVector3f(fPitSize+2,1,fPitSize+2), cVector3f(1,10,fPitSize+2), cVector3f(1,10,fPitSize+2),
+								cVector3f(fPitSize+2,10,1), cVector3f(fPitSize+2,10,1)};
+	for(int i=0; i<5; ++i)
+	{
+		iCollideShape *pShape = pPhysicsWorld->CreateBoxShape(vWallSize[i], NULL);
+		iPhysicsBody *pBody = pPhysicsWorld->CreateBody("Wall"+cString::ToString(i), pShape);
+		pBody->SetMass(0);
+		pBody->SetPosition(vWallPos[i]);
+	}
+
+	////////////////////////////
+	// Props, a box body with a box mesh attached, dropped from a grid above the pit.
+	cVector3f vPropSize(0.5f);
+	cMesh *pPropMesh = gpEngine->GetGraphics()->GetMeshCreator()->CreateBox("PropBox", vPropSize, "");
+
+	std::vector<iPhysicsBody*> vProps;
+	vProps.reserve(glPropNum);
+
+	int lSide = (int)ceilf(sqrtf((float)glPropNum)); //Props per row, one prop per grid cell
+	float fSpacing = (fPitSize - 2.0f) / (float)lSide;
+	uint64_t lInsertTime = 0;
+	for(int i=0; i<glPropNum; ++i)
+	{
+		tString sName = "Prop"+cString::ToString(i);
+		iCollideShape *pShape = pPhysicsWorld->CreateBoxShape(vPropSize, NULL);
+		iPhysicsBody *pBody = pPhysicsWorld->CreateBody(sName, pShape);
+		pBody->SetMass(1);
+
+		cVector3f vPos(	-fPitSize*0.5f + 1.0f + fSpacing * ((float)(i % lSide) + 0.5f),
+						2.0f + RandFloat(0, 8),
+						-fPitSize*0.5f + 1.0f + fSpacing * ((float)(i / lSide) + 0.5f));
+		pBody->SetPosition(vPos);
+
+		//Added to the container at the origin, it is moved when attached to the body
+		uint64_t lStartTime = cPlatform::GetApplicationTimeNanoSec();
+		cMeshEntity *pEntity = pWorld->CreateMeshEntity(sName, pPropMesh, false);
+		lInsertTime += cPlatform::GetApplicationTimeNanoSec() - lStartTime;
+
+		pBody->AddChild(pEntity);
+
+		vProps.push_back(pBody);
+	}
+
+	iRenderableContainer *pContainer = pWorld->GetRenderableContainer(eWorldContainerType_Dynamic);
+
+	int lNodeNum = 0, lInsertDepth = 0, lCompileDepth = 0;
+	GetTreeSize(pContainer->GetRoot(), 1, &lNodeNum, &lInsertDepth);
+
+	uint64_t lStartTime = cPlatform::GetApplicationTimeNanoSec();
+	pContainer->Compile();
+	uint64_t lCompileTime = cPlatform::GetApplicationTimeNanoSec() - lStartTime;
+
+	lNodeNum = 0;
+	GetTreeSize(pContainer->GetRoot(), 1, &lNodeNum, &lCompileDepth);
+
+	////////////////////////////
+	// Cameras looking into the pit from the sides
+	cCamera *pCamera = gpEngine->GetScene()->CreateCamera(eCameraMoveMode_Fly);
+	pCamera->SetRotateMode(eCameraRotateMode_EulerAngles);
+	pCamera->SetPosition(cVector3f(0, 3, 0));
+
+	////////////////////////////
+	// Frames
+	cFrameTime physicsTime, updateTime, queryTime;
+	int lKickNum = (int)((float)glPropNum * gfKickPercent / 100.0f);
+	size_t lVisibleNum = 0;
+	float fTimeStep = 1.0f / 60.0f;
+
+	for(int frame=0; frame<glFrames; ++frame)
+	{
+		//Kick some props so that the pile never settles
+		for(int i=0; i<lKickNum; ++i)
+		{
+			iPhysicsBody *pBody = vProps[(size_t)RandFloat(0, (float)glPropNum - 0.001f)];
+			pBody->SetLinearVelocity(cVector3f(RandFloat(-3,3), RandFloat(4,9), RandFloat(-3,3)));
+		}
+
+		uint64_t lStartTime = cPlatform::GetApplicationTimeNanoSec();
+		pPhysicsWorld->Update(fTimeStep);
+		physicsTime.Add(cPlatform::GetApplicationTimeNanoSec() - lStartTime);
+
+		lStartTime = cPlatform::GetApplicationTimeNanoSec();
+		pContainer->UpdateBeforeRendering();
+		updateTime.Add(cPlatform::GetApplicationTimeNanoSec() - lStartTime);
+
+		lStartTime = cPlatform::GetApplicationTimeNanoSec();
+		for(int lDir=0; lDir<4; ++lDir)
+		{
+			pCamera->SetYaw(kPi2f * (float)lDir);
+			lVisibleNum += CountVisibleObjectsInNode(pContainer->GetRoot(), pCamera->GetFrustum());
+		}
+		queryTime.Add(cPlatform::GetApplicationTimeNanoSec() - lStartTime);
+	}
+
+	int lMaxDepth = 0;
+	lNodeNum = 0;
+	GetTreeSize(pContainer->GetRoot(), 1, &lNodeNum, &lMaxDepth);
+
+	gpEngine->GetScene()->DestroyCamera(pCamera);
+	gpEngine->GetScene()->DestroyWorld(pWorld);
+	hplDelete(pPropMesh);
+
+	////////////////////////////
+	// Print result
+	printf("Props: %d Frames: %d Kicked per frame: %d\n", glPropNum, glFrames, lKickNum);
+	printf("Insert at origin: %.3f ms Depth: %d\n", (double)lInsertTime / 1000000.0, lInsertDepth);
+	printf("Compile: %.3f ms Depth: %d\n", (double)lCompileTime / 1000000.0, lCompileDepth);
+	printf("Tree nodes: %d Depth: %d Visible per query (avg): %.1f\n", lNodeNum, lMaxDepth, (double)lVisibleNum / (double)(glFrames*4));
+	physicsTime.Print("Physics step:");
+	updateTime.Print("Container update:");
+	queryTime.Print("4 frustum queries:");
+
+	return true;
+}
+
+//------------------------------------------
+
+#ifdef WIN32
+	int main(int argc, const char* argv[] )
+	{
+		tString asCommandLine;
+		for(int i=1; i<argc; ++i)
+		{
+			asCommandLine += argv[i];
+			if(i!=argc-1) asCommandLine += " ";
+		}
+
+#else
+	int hplMain(const tString &asCommandLine)
+	{
+#endif
+
+	SetLogFile(_W("DynBoxTreeBench.log"));
+
+	ParseCommandLine(asCommandLine);
+
+	//Null graphics, so meshes get vertex buffers but no window or context is needed.
+	cEngineInitVars vars;
+	gpEngine = CreateHPLEngine(eHplAPI_Null, eHplSetup_Screen, &vars);
+
+	bool bRet = RunBenchmark();
+
+	DestroyHPLEngine(gpEngine);
+
+	return bRet ? 0 : 1;
+}
+
+#ifdef WIN32
+	int hplMain(const tString &asCommandLine){return -1;}
+#endif
+
+#ifdef __APPLE__
+extern "C" int SDL_main(int argc, char *argv[]);
+int main(int argc, char * argv[]) {
+    return SDL_main(argc, argv);
+}
+#endif
@@ -0,0 +1,227 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Bakes .map_cache files for all maps in a directory without opening a window.
+ * Run from the game directory (resources.cfg and materials.cfg are loaded from there):
+ *
+ *   MapCacheBaker [-subdirs] [-force] [-threads <num>] <map dir>
+ *
+ * -threads sets the number of job manager workers used when combining static geometry.
+ */
+
+#include "hpl.h"
+
+#include "resources/WorldLoaderHplMap.h"
+
+using namespace hpl;
+
+cEngine *gpEngine=NULL;
+
+//------------------------------------------
+
+bool gbSubDirs = false;
+bool gbForce = false;
+int glThreadNum = 3;
+tWString gsDir = _W("");
+
+int glNumOfBaked = 0;
+int glNumOfSkipped = 0;
+int glNumOfProblems = 0;
+
+//------------------------------------------
+
+void ParseCommandLine(const tString &asCommandLine)
+{
+	tStringVec args;
+	tString sSepp = " ";
+	cString::GetStringVec(asCommandLine, args,&sSepp);
+
+	for(size_t i=0; i<args.size(); ++i)
+	{
+		const tString &sArg = args[i];
+
+		if(sArg == "-subdirs")
+		{
+			gbSubDirs = true;
+		}
+		else if(sArg == "-force")
+		{
+			gbForce = true;
+		}
+		else if(sArg == "-threads" && i+1 < args.size())
+		{
+			glThreadNum = cString::ToInt(args[++i].c_str(), glThreadNum);
+		}
+		else
+		{
+			gsDir = cString::To16Char(sArg);
+		}
+	}
+}
+
+//------------------------------------------
+
+int GetFileVersion(const tWString &asFile)
+{
+	FILE *pFile = cPlatform::OpenFile(asFile, _W("rb"));
+	if(pFile==NULL) return -1;
+
+	int lOut;
+	fread(&lOut, sizeof(int), 1, pFile); //Magic number
+	fread(&lOut, sizeof(int), 1, pFile); // File version
+	fclose(pFile);
+
+	return lOut;
+}
+
+//------------------------------------------
+
+void BakeMap(const tWString &asFile)
+{
+	//Check if cache file exists, is newer and correct version. If so, skip it
+	tWString sCachePath = cString::SetFileExtW(asFile, _W("map_cache"));
+	if(	gbForce == false &&
+		cPlatform::FileExists(sCachePath) &&
+		cPlatform::FileModifiedDate(sCachePath) > cPlatform::FileModifiedDate(asFile) &&
+		GetFileVersion(sCachePath) == MAP_CACHE_FORMAT_VERSION)
+	{
+		glNumOfSkipped++;
+		return;
+	}
+
+	//Remove previous cache file, else the loader would just use it
+	if(cPlatform::FileExists(sCachePath))
+	{
+		cPlatform::RemoveFile(sCachePath);
+	}
+
+	printf(" Baking '%s'....", cString::To8Char(cString::GetFileNameW(asFile)).c_str());
+	fflush(stdout);
+	unsigned long lStartTime = cPlatform::GetApplicationTime();
+
+	cWorld *pWorld = gpEngine->GetResources()->GetWorldLoaderHandler()->LoadWorld(asFile, eWorldLoadFlag_NoEntities);
+	if(pWorld)
+	{
+		gpEngine->GetScene()->DestroyWorld(pWorld);
+	}
+
+	if(pWorld==NULL || cPlatform::FileExists(sCachePath)==false)
+	{
+		printf(" failed!\n");
+		glNumOfProblems++;
+		return;
+	}
+
+	printf(" done! (%lums)\n", cPlatform::GetApplicationTime()-lStartTime);
+	glNumOfBaked++;
+}
+
+//------------------------------------------
+
+void BakeMapsInDir(const tWString &asDir)
+{
+	tWStringList lstFiles;
+	cPlatform::FindFilesInDir(lstFiles, asDir, _W("*.map"));
+
+	//////////////////////////
+	//Iterate files and bake
+	if(lstFiles.empty()==false) printf("Current Dir: '%s'\n", cString::To8Char(asDir).c_str());
+	for(tWStringListIt it = lstFiles.begin(); it != lstFiles.end(); ++it)
+	{
+		BakeMap(cString::SetFilePathW(*it, asDir));
+	}
+
+	if(gbSubDirs==false) return;
+
+	//////////////////////////
+	//Iterate folders
+	tWStringList lstFolders;
+	cPlatform::FindFoldersInDir(lstFolders, asDir, false);
+	for(tWStringListIt it = lstFolders.begin(); it != lstFolders.end(); ++it)
+	{
+		BakeMapsInDir(cString::SetFilePathW(*it, asDir));
+	}
+}
+
+//------------------------------------------
+
+void Init()
+{
+	gpEngine->GetPhysics()->LoadSurfaceData("materials.cfg");
+
+	gpEngine->GetResources()->LoadResourceDirsFile("resources.cfg");
+	gpEngine->GetResources()->GetMaterialManager()->SetDisableRenderDataLoading(true);
+}
+
+//------------------------------------------
+
+#ifdef WIN32
+	int main(int argc, const char* argv[] )
+	{
+		tString asCommandLine;
+		for(int i=1; i<argc; ++i)
+		{
+			asCommandLine += argv[i];
+			if(i!=argc-1) asCommandLine += " ";
+		}
+
+#else
+	int hplMain(const tString &asCommandLine)
+	{
+#endif
+
+	SetLogFile(_W("MapCacheBaker.log"));
+
+	ParseCommandLine(asCommandLine);
+	if(gsDir == _W(""))
+	{
+		printf("Usage: MapCacheBaker [-subdirs] [-force] [-threads <num>] <map dir>\n");
+		return 1;
+	}
+
+	//No setup flags, so no window or sound is created. The job manager of the system module is used when combining static geometry.
+	cEngineInitVars vars;
+	vars.mSystem.mlJobWorkerNum = glThreadNum;
+	gpEngine = CreateHPLEngine(eHplAPI_OpenGL, 0, &vars);
+
+	Init();
+
+	printf("-------- MAP CACHE BAKING STARTED! -----------\n\n");
+
+	BakeMapsInDir(gsDir);
+
+	printf("\nBaked: %d Skipped: %d Problems: %d\n", glNumOfBaked, glNumOfSkipped, glNumOfProblems);
+	printf("-------- MAP CACHE BAKING DONE! -----------\n");
+
+	DestroyHPLEngine(gpEngine);
+
+	return glNumOfProblems > 0 ? 1 : 0;
+}
+
+#ifdef WIN32
+	int hplMain(const tString &asCommandLine){return -1;}
+#endif
+
+#ifdef __APPLE__
+extern "C" int SDL_main(int argc, char *argv[]);
+int main(int argc, char * argv[]) {
+    return SDL_main(argc, argv);
+}
+#endif
@@ -0,0 +1,366 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Benchmark for the whole render path. A map is loaded with the null graphics backend and a camera is flown
+ * along a scripted path: it visits a grid of spots over the static geometry and turns a full circle at each
+ * spot. Every frame is rendered by the main renderer and ended with a buffer swap, just like in the game loop.
+ * The CPU time of each frame is timed and the calls recorded by the null backend are summed up.
+ * With -softocclusion the path is flown twice more, with only frustum culling and with the software occlusion
+ * culler, and the number of objects in the render list is compared.
+ * Run from the game directory (resources.cfg and materials.cfg are loaded from there):
+ *
+ *   RenderBench [-views <num per axis>] [-frames <num per spot>] [-warmup <num>] [-softocclusion] <map file>
+ */
+
+#include "hpl.h"
+#include "impl/LowLevelGraphicsNull.h"
+
+#include <algorithm>
+
+using namespace hpl;
+
+cEngine *gpEngine=NULL;
+
+//------------------------------------------
+
+int glViewsPerAxis = 4;
+int glFramesPerSpot = 32;
+int glWarmupFrames = 16;
+bool gbCompareSoftOcclusion = false;
+tString gsMapFile = "";
+
+//------------------------------------------
+
+class cSimpleObjectLoader : public cEntityLoader_Object
+{
+public:
+	cSimpleObjectLoader(const tString &asName) : cEntityLoader_Object(asName){}
+
+	void BeforeLoad(cXmlElement *apRootElem, const cMatrixf &a_mtxTransform,cWorld *apWorld, cResourceVarsObject *apInstanceVars){}
+	void AfterLoad(cXmlElement *apRootElem, const cMatrixf &a_mtxTransform,cWorld *apWorld, cResourceVarsObject *apInstanceVars){}
+};
+
+//------------------------------------------
+
+void ParseCommandLine(const tString &asCommandLine)
+{
+	tStringVec args;
+	tString sSepp = " ";
+	cString::GetStringVec(asCommandLine, args,&sSepp);
+
+	for(size_t i=0; i<args.size(); ++i)
+	{
+		const tString &sArg = args[i];
+
+		if(sArg == "-views" && i+1 < args.size())
+		{
+			glViewsPerAxis = cMath::Max(cString::ToInt(args[++i].c_str(), glViewsPerAxis), 1);
+		}
+		else if(sArg == "-frames" && i+1 < args.size())
+		{
+			glFramesPerSpot = cMath::Max(cString::ToInt(args[++i].c_str(), glFramesPerSpot), 1);
+		}
+		else if(sArg == "-warmup" && i+1 < args.size())
+		{
+			glWarmupFrames = cMath::Max(cString::ToInt(args[++i].c_str(), glWarmupFrames), 0);
+		}
+		else if(sArg == "-softocclusion")
+		{
+			gbCompareSoftOcclusion = true;
+		}
+		else
+		{
+			gsMapFile = sArg;
+		}
+	}
+}
+
+//------------------------------------------
+
+//////////////////////////////////////////////////////////////////////////
+// BENCHMARK
+//////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------
+
+std::vector<uint64_t> gvFrameTimes;
+
+int glWorstFrame = -1;
+cNullGfxPassStats gWorstFrameStats;
+
+//Summed over all frames of the last flight.
+double gfRenderListObjects = 0;
+double gfSoftwareOccluders = 0;
+
+//------------------------------------------
+
+static float gfFrameTime = 1.0f/60.0f;
+
+uint64_t RenderFrame(cLowLevelGraphicsNull *apLowLevel)
+{
+	uint64_t lStartTime = cPlatform::GetApplicationTimeNanoSec();
+
+	gpEngine->GetScene()->Render(gfFrameTime, tSceneRenderFlag_All);
+	apLowLevel->SwapBuffers();
+
+	return cPlatform::GetApplicationTimeNanoSec() - lStartTime;
+}
+
+//------------------------------------------
+
+void PrintStats(const char *asName, const cNullGfxPassStats &aStats, double afFrameNum)
+{
+	printf("%s\n", asName);
+	printf(" Draw calls: %8.1f (immediate: %.1f) Indices: %10.1f\n", (double)aStats.mlDrawCalls / afFrameNum,
+																	(double)aStats.mlImmediateDrawCalls / afFrameNum,
+																	(double)aStats.mlIndicesDrawn / afFrameNum);
+	printf(" State changes: %8.1f (redundant: %.1f)\n", (double)aStats.mlStateChanges / afFrameNum, (double)aStats.mlRedundantStateChanges / afFrameNum);
+	printf(" Binds - textures: %.1f programs: %.1f vertex buffers: %.1f Program vars: %.1f\n",
+																	(double)aStats.mlTextureBinds / afFrameNum,
+																	(double)aStats.mlProgramBinds / afFrameNum,
+																	(double)aStats.mlVertexBufferBinds / afFrameNum,
+																	(double)aStats.mlProgramVarSets / afFrameNum);
+	printf(" Clears: %.1f Occlusion queries: %.1f Commands: %.1f\n",	(double)aStats.mlClears / afFrameNum,
+																	(double)aStats.mlOcclusionQueries / afFrameNum,
+																	(double)aStats.mlCommandNum / afFrameNum);
+}
+
+//------------------------------------------
+
+/**
+ * Flies the grid of spots and returns the number of frames rendered. Frame times are only saved if abRecordTimes is true.
+ */
+int FlyPath(cCamera *apCamera, cViewport *apViewport, cLowLevelGraphicsNull *apLowLevel, const cVector3f &avMin, const cVector3f &avMax,
+			bool abRecordTimes)
+{
+	gfRenderListObjects = 0;
+	gfSoftwareOccluders = 0;
+
+	cRenderSettings *pSettings = apViewport->GetRenderSettings();
+	int lFrameNum = 0;
+
+	// The grid is walked back and forth along z, so the camera never jumps across the map.
+	for(int x=0; x<glViewsPerAxis; ++x)
+	for(int lZCount=0; lZCount<glViewsPerAxis; ++lZCount)
+	{
+		int z = (x % 2)==0 ? lZCount : glViewsPerAxis-1-lZCount;
+
+		cVector3f vPos(	avMin.x + (avMax.x-avMin.x) * ((float)x+0.5f) / (float)glViewsPerAxis,
+						(avMin.y + avMax.y)*0.5f,
+						avMin.z + (avMax.z-avMin.z) * ((float)z+0.5f) / (float)glViewsPerAxis);
+		apCamera->SetPosition(vPos);
+
+		for(int i=0; i<glFramesPerSpot; ++i)
+		{
+			apCamera->SetYaw(k2Pif * (float)i / (float)glFramesPerSpot);
+
+			uint64_t lTime = RenderFrame(apLowLevel);
+			++lFrameNum;
+
+			//The list is cleared at the start of the next frame, so it still holds what was rendered.
+			gfRenderListObjects += (double)(pSettings->mpRenderList->GetSolidObjectNum() + pSettings->mpRenderList->GetTransObjectNum());
+			gfSoftwareOccluders += (double)pSettings->mlNumberOfSoftwareOccluders;
+
+			if(abRecordTimes==false) continue;
+
+			if(glWorstFrame < 0 || lTime > gvFrameTimes[glWorstFrame])
+			{
+				glWorstFrame = (int)gvFrameTimes.size();
+				gWorstFrameStats = apLowLevel->GetLastFrameStats();
+			}
+			gvFrameTimes.push_back(lTime);
+		}
+	}
+
+	return lFrameNum;
+}
+
+//------------------------------------------
+
+/**
+ * Flies the path with frustum culling only and then with the software occlusion culler and prints how many objects
+ * the culler removes.
+ */
+void CompareSoftOcclusion(cCamera *apCamera, cViewport *apViewport, cLowLevelGraphicsNull *apLowLevel, const cVector3f &avMin, const cVector3f &avMax)
+{
+	cRenderSettings *pSettings = apViewport->GetRenderSettings();
+	bool bOldOcclusion = pSettings->mbUseOcclusionCulling;
+	bool bOldSoftOcclusion = pSettings->mbUseSoftwareOcclusionCulling;
+
+	pSettings->mbUseOcclusionCulling = false;
+	pSettings->mbUseSoftwareOcclusionCulling = false;
+	double fFrameNum = (double)cMath::Max(FlyPath(apCamera, apViewport, apLowLevel, avMin, avMax, false), 1);
+	double fFrustumObjects = gfRenderListObjects / fFrameNum;
+
+	pSettings->mbUseSoftwareOcclusionCulling = true;
+	FlyPath(apCamera, apViewport, apLowLevel, avMin, avMax, false);
+	double fSoftObjects = gfRenderListObjects / fFrameNum;
+	double fOccluders = gfSoftwareOccluders / fFrameNum;
+
+	pSettings->mbUseOcclusionCulling = bOldOcclusion;
+	pSettings->mbUseSoftwareOcclusionCulling = bOldSoftOcclusion;
+
+	double fCulled = fFrustumObjects - fSoftObjects;
+	printf("Software occlusion culling (per frame avg):\n");
+	printf(" Rendered objects - frustum only: %.1f software culler: %.1f\n", fFrustumObjects, fSoftObjects);
+	printf(" Culled by software culler: %.1f (%.1f%%) Occluders: %.1f\n", fCulled,
+										fFrustumObjects > 0 ? 100.0 * fCulled / fFrustumObjects : 0.0, fOccluders);
+}
+
+//------------------------------------------
+
+bool RunBenchmark()
+{
+	cLowLevelGraphicsNull *pLowLevel = static_cast<cLowLevelGraphicsNull*>(gpEngine->GetGraphics()->GetLowLevel());
+	pLowLevel->SetRecordCommands(false);
+
+	cWorld *pWorld = gpEngine->GetScene()->LoadWorld(gsMapFile, 0);
+	if(pWorld==NULL)
+	{
+		printf("Could not load map '%s'!\n", gsMapFile.c_str());
+		return false;
+	}
+
+	iRenderableContainerNode *pStaticRoot = pWorld->GetRenderableContainer(eWorldContainerType_Static)->GetRoot();
+	pStaticRoot->UpdateBeforeUse();
+	cVector3f vMin = pStaticRoot->GetMin();
+	cVector3f vMax = pStaticRoot->GetMax();
+
+	cCamera *pCamera = gpEngine->GetScene()->CreateCamera(eCameraMoveMode_Fly);
+	pCamera->SetRotateMode(eCameraRotateMode_EulerAngles);
+
+	cViewport *pViewport = gpEngine->GetScene()->CreateViewport(pCamera, pWorld);
+
+	////////////////////////////
+	// Warm up at the first spot, so loading on first use is not part of the timing.
+	pCamera->SetPosition(cVector3f(	vMin.x + (vMax.x-vMin.x) * 0.5f / (float)glViewsPerAxis,
+									(vMin.y + vMax.y)*0.5f,
+									vMin.z + (vMax.z-vMin.z) * 0.5f / (float)glViewsPerAxis));
+	for(int i=0; i<glWarmupFrames; ++i)
+	{
+		pCamera->SetYaw(k2Pif * (float)i / (float)cMath::Max(glWarmupFrames,1));
+		RenderFrame(pLowLevel);
+	}
+	pLowLevel->ResetTotalStats();
+
+	////////////////////////////
+	// Fly the path
+	FlyPath(pCamera, pViewport, pLowLevel, vMin, vMax, true);
+
+	////////////////////////////
+	// Print result
+	if(gvFrameTimes.empty())
+	{
+		gpEngine->GetScene()->DestroyViewport(pViewport);
+		gpEngine->GetScene()->DestroyCamera(pCamera);
+		gpEngine->GetScene()->DestroyWorld(pWorld);
+		return false;
+	}
+
+	std::vector<uint64_t> vSortedTimes = gvFrameTimes;
+	std::sort(vSortedTimes.begin(), vSortedTimes.end());
+
+	uint64_t lTotalTime = 0;
+	for(size_t i=0; i<gvFrameTimes.size(); ++i) lTotalTime += gvFrameTimes[i];
+
+	double fFrameNum = (double)pLowLevel->GetTotalFrameCount();
+	size_t lP99 = std::min((vSortedTimes.size() * 99) / 100, vSortedTimes.size()-1);
+
+	printf("Spots: %d Frames: %d\n", glViewsPerAxis*glViewsPerAxis, (int)gvFrameTimes.size());
+	printf(" CPU frame time: avg %8.3f ms median %8.3f ms 99%% %8.3f ms worst %8.3f ms (frame %d)\n",
+										(double)lTotalTime / (double)gvFrameTimes.size() / 1000000.0,
+										(double)vSortedTimes[vSortedTimes.size()/2] / 1000000.0,
+										(double)vSortedTimes[lP99] / 1000000.0,
+										(double)vSortedTimes.back() / 1000000.0, glWorstFrame);
+
+	PrintStats("Per frame (avg):", pLowLevel->GetTotalStats(), std::max(fFrameNum, 1.0));
+	PrintStats("Worst frame:", gWorstFrameStats, 1.0);
+
+	////////////////////////////
+	// Culling comparison, after the print since it changes the total stats.
+	if(gbCompareSoftOcclusion) CompareSoftOcclusion(pCamera, pViewport, pLowLevel, vMin, vMax);
+
+	gpEngine->GetScene()->DestroyViewport(pViewport);
+	gpEngine->GetScene()->DestroyCamera(pCamera);
+	gpEngine->GetScene()->DestroyWorld(pWorld);
+
+	return true;
+}
+
+//------------------------------------------
+
+void Init()
+{
+	gpEngine->GetPhysics()->LoadSurfaceData("materials.cfg");
+
+	gpEngine->GetResources()->LoadResourceDirsFile("resources.cfg");
+	gpEngine->GetResources()->AddEntityLoader(hplNew(cSimpleObjectLoader,("Object")),true);
+}
+
+//------------------------------------------
+
+#ifdef WIN32
+	int main(int argc, const char* argv[] )
+	{
+		tString asCommandLine;
+		for(int i=1; i<argc; ++i)
+		{
+			asCommandLine += argv[i];
+			if(i!=argc-1) asCommandLine += " ";
+		}
+
+#else
+	int hplMain(const tString &asCommandLine)
+	{
+#endif
+
+	SetLogFile(_W("RenderBench.log"));
+
+	ParseCommandLine(asCommandLine);
+	if(gsMapFile == "")
+	{
+		printf("Usage: RenderBench [-views <num per axis>] [-frames <num per spot>] [-warmup <num>] [-softocclusion] <map file>\n");
+		return 1;
+	}
+
+	//Null graphics, so the renderer does all of its CPU work, but no window or context is needed.
+	cEngineInitVars vars;
+	gpEngine = CreateHPLEngine(eHplAPI_Null, eHplSetup_Screen, &vars);
+
+	Init();
+
+	bool bRet = RunBenchmark();
+
+	DestroyHPLEngine(gpEngine);
+
+	return bRet ? 0 : 1;
+}
+
+#ifdef WIN32
+	int hplMain(const tString &asCommandLine){return -1;}
+#endif
+
+#ifdef __APPLE__
+extern "C" int SDL_main(int argc, char *argv[]);
+int main(int argc, char * argv[]) {
+    return SDL_main(argc, argv);
+}
+#endif
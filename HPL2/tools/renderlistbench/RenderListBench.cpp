@@ -0,0 +1,444 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Micro-benchmark for cRenderList::Compile. A map is loaded with the null graphics backend and the objects
+ * visible from a grid of camera views are added to a render list. The key based radix sort is then timed
+ * against the comparator std::sort the render list used before.
+ * Run from the game directory (resources.cfg and materials.cfg are loaded from there):
+ *
+ *   RenderListBench [-views <num per axis>] [-iterations <num>] <map file>
+ */
+
+#include "hpl.h"
+
+#include <algorithm>
+
+using namespace hpl;
+
+cEngine *gpEngine=NULL;
+
+//------------------------------------------
+
+int glViewsPerAxis = 4;
+int glIterations = 200;
+tString gsMapFile = "";
+
+//------------------------------------------
+
+class cSimpleObjectLoader : public cEntityLoader_Object
+{
+public:
+	cSimpleObjectLoader(const tString &asName) : cEntityLoader_Object(asName){}
+
+	void BeforeLoad(cXmlElement *apRootElem, const cMatrixf &a_mtxTransform,cWorld *apWorld, cResourceVarsObject *apInstanceVars){}
+	void AfterLoad(cXmlElement *apRootElem, const cMatrixf &a_mtxTransform,cWorld *apWorld, cResourceVarsObject *apInstanceVars){}
+};
+
+//------------------------------------------
+
+void ParseCommandLine(const tString &asCommandLine)
+{
+	tStringVec args;
+	tString sSepp = " ";
+	cString::GetStringVec(asCommandLine, args,&sSepp);
+
+	for(size_t i=0; i<args.size(); ++i)
+	{
+		const tString &sArg = args[i];
+
+		if(sArg == "-views" && i+1 < args.size())
+		{
+			glViewsPerAxis = cMath::Max(cString::ToInt(args[++i].c_str(), glViewsPerAxis), 1);
+		}
+		else if(sArg == "-iterations" && i+1 < args.size())
+		{
+			glIterations = cMath::Max(cString::ToInt(args[++i].c_str(), glIterations), 1);
+		}
+		else
+		{
+			gsMapFile = sArg;
+		}
+	}
+}
+
+//------------------------------------------
+
+//////////////////////////////////////////////////////////////////////////
+// OLD COMPARATORS
+//////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------
+
+// These are the comparators cRenderList sorted with before the sort keys, kept here as the reference.
+
+static bool SortFunc_Z(iRenderable* apObjectA, iRenderable *apObjectB)
+{
+	cMaterial *pMatA = apObjectA->GetMaterial();
+	cMaterial *pMatB = apObjectB->GetMaterial();
+
+	if(pMatA->GetAlphaMode() != pMatB->GetAlphaMode())
+	{
+		return pMatA->GetAlphaMode() < pMatB->GetAlphaMode();
+	}
+
+	if(	pMatA->GetAlphaMode() == eMaterialAlphaMode_Trans )
+	{
+		if(pMatA->GetProgram(0,eMaterialRenderMode_Z) != pMatB->GetProgram(0,eMaterialRenderMode_Z))
+		{
+			return pMatA->GetProgram(0,eMaterialRenderMode_Z) < pMatB->GetProgram(0,eMaterialRenderMode_Z);
+		}
+
+		if(pMatA->GetTexture(eMaterialTexture_Diffuse) != pMatB->GetTexture(eMaterialTexture_Diffuse))
+		{
+			return pMatA->GetTexture(eMaterialTexture_Diffuse) < pMatB->GetTexture(eMaterialTexture_Diffuse);
+		}
+	}
+
+	return apObjectA->GetViewSpaceZ() > apObjectB->GetViewSpaceZ();
+}
+
+//------------------------------------------
+
+static bool SortFunc_Diffuse(iRenderable* apObjectA, iRenderable *apObjectB)
+{
+	cMaterial *pMatA = apObjectA->GetMaterial();
+	cMaterial *pMatB = apObjectB->GetMaterial();
+
+	if(pMatA->GetProgram(0,eMaterialRenderMode_Diffuse) != pMatB->GetProgram(0,eMaterialRenderMode_Diffuse))
+	{
+		return pMatA->GetProgram(0,eMaterialRenderMode_Diffuse) < pMatB->GetProgram(0,eMaterialRenderMode_Diffuse);
+	}
+
+	for(int i=0;i<kMaxTextureUnits; ++i)
+	{
+		iTexture *pTexA = pMatA->GetTextureInUnit(eMaterialRenderMode_Diffuse,i);
+		iTexture *pTexB = pMatB->GetTextureInUnit(eMaterialRenderMode_Diffuse,i);
+		if(pTexA != pTexB) return pTexA < pTexB;
+	}
+
+	if(apObjectA->GetVertexBuffer() != apObjectB->GetVertexBuffer())
+	{
+		return apObjectA->GetVertexBuffer() < apObjectB->GetVertexBuffer();
+	}
+
+	if(apObjectA->GetModelMatrixPtr() != apObjectB->GetModelMatrixPtr())
+	{
+		return apObjectA->GetModelMatrixPtr() < apObjectB->GetModelMatrixPtr();
+	}
+
+	return apObjectA < apObjectB;
+}
+
+//------------------------------------------
+
+static bool SortFunc_Translucent(iRenderable* apObjectA, iRenderable *apObjectB)
+{
+	if(apObjectA->GetLargePlaneSurfacePlacement() != apObjectB->GetLargePlaneSurfacePlacement())
+	{
+		return apObjectA->GetLargePlaneSurfacePlacement() < apObjectB->GetLargePlaneSurfacePlacement();
+	}
+
+	return apObjectA->GetViewSpaceZ() < apObjectB->GetViewSpaceZ();
+}
+
+//------------------------------------------
+
+static bool SortFunc_Decal(iRenderable* apObjectA, iRenderable *apObjectB)
+{
+	cMaterial *pMatA = apObjectA->GetMaterial();
+	cMaterial *pMatB = apObjectB->GetMaterial();
+
+	if(pMatA->GetTexture(eMaterialTexture_Illumination) != pMatB->GetTexture(eMaterialTexture_Illumination))
+	{
+		return pMatA->GetTexture(eMaterialTexture_Illumination) < pMatB->GetTexture(eMaterialTexture_Illumination);
+	}
+
+	if(apObjectA->GetVertexBuffer() != apObjectB->GetVertexBuffer())
+	{
+		return apObjectA->GetVertexBuffer() < apObjectB->GetVertexBuffer();
+	}
+
+	if(apObjectA->GetModelMatrixPtr() != apObjectB->GetModelMatrixPtr())
+	{
+		return apObjectA->GetModelMatrixPtr() < apObjectB->GetModelMatrixPtr();
+	}
+
+	return apObjectA->GetWorldPosition()  < apObjectB->GetWorldPosition();
+}
+
+//------------------------------------------
+
+static bool SortFunc_Illumination(iRenderable* apObjectA, iRenderable *apObjectB)
+{
+	cMaterial *pMatA = apObjectA->GetMaterial();
+	cMaterial *pMatB = apObjectB->GetMaterial();
+
+	if(pMatA->GetTexture(eMaterialTexture_Illumination) != pMatB->GetTexture(eMaterialTexture_Illumination))
+	{
+		return pMatA->GetTexture(eMaterialTexture_Illumination) < pMatB->GetTexture(eMaterialTexture_Illumination);
+	}
+
+	if(apObjectA->GetVertexBuffer() != apObjectB->GetVertexBuffer())
+	{
+		return apObjectA->GetVertexBuffer() < apObjectB->GetVertexBuffer();
+	}
+
+	if(apObjectA->GetModelMatrixPtr() != apObjectB->GetModelMatrixPtr())
+	{
+		return apObjectA->GetModelMatrixPtr() < apObjectB->GetModelMatrixPtr();
+	}
+
+	return apObjectA->GetIlluminationAmount() < apObjectB->GetIlluminationAmount();
+}
+
+//------------------------------------------
+
+typedef bool (*tSortRenderableFunc)(iRenderable*,iRenderable*);
+
+static tSortRenderableFunc gvSortFunctions[eRenderListType_LastEnum] = {SortFunc_Z,SortFunc_Diffuse,SortFunc_Translucent,SortFunc_Decal,SortFunc_Illumination};
+
+//------------------------------------------
+
+//////////////////////////////////////////////////////////////////////////
+// BENCHMARK
+//////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------
+
+tRenderableVec gvVisibleObjects;
+
+uint64_t glNewSortTime = 0;
+uint64_t glOldSortTime = 0;
+size_t glSortedObjectNum = 0;
+
+//------------------------------------------
+
+void AddVisibleObjectsInNode(iRenderableContainerNode *apNode, cFrustum *apFrustum)
+{
+	if(apFrustum->CollideNode(apNode) == eCollision_Outside) return;
+
+	for(tRenderableListIt it = apNode->GetObjectList()->begin(); it != apNode->GetObjectList()->end(); ++it)
+	{
+		iRenderable *pObject = *it;
+		if(pObject->IsVisible()==false) continue;
+		if(pObject->CollidesWithFrustum(apFrustum)==false) continue;
+
+		gvVisibleObjects.push_back(pObject);
+	}
+
+	for(tRenderableContainerNodeListIt it = apNode->GetChildNodeList()->begin(); it != apNode->GetChildNodeList()->end(); ++it)
+	{
+		AddVisibleObjectsInNode(*it, apFrustum);
+	}
+}
+
+//------------------------------------------
+
+void BenchmarkView(cWorld *apWorld, cFrustum *apFrustum, cRenderList *apRenderList)
+{
+	////////////////////////////
+	// Find visible objects
+	gvVisibleObjects.resize(0);
+	for(int i=0; i<eWorldContainerType_LastEnum; ++i)
+	{
+		iRenderableContainer *pContainer = apWorld->GetRenderableContainer((eWorldContainerType)i);
+		pContainer->UpdateBeforeRendering();
+		AddVisibleObjectsInNode(pContainer->GetRoot(), apFrustum);
+	}
+
+	tRenderListCompileFlag lAllFlags =	eRenderListCompileFlag_Z | eRenderListCompileFlag_Diffuse | eRenderListCompileFlag_Translucent |
+										eRenderListCompileFlag_Decal | eRenderListCompileFlag_Illumination;
+
+	////////////////////////////
+	// New: sort keys and radix sort.
+	// The list is filled again each iteration, just like each frame, so the id maps start out empty.
+	tRenderableVec vSourceArrays[eRenderListType_LastEnum];
+	for(int i=0; i<glIterations; ++i)
+	{
+		iRenderer::IncRenderFrameCount();
+
+		apRenderList->Clear();
+		apRenderList->Setup(1.0f/60.0f, apFrustum);
+		for(size_t j=0; j<gvVisibleObjects.size(); ++j)
+		{
+			apRenderList->AddObject(gvVisibleObjects[j]);
+		}
+
+		uint64_t lStartTime = cPlatform::GetApplicationTimeNanoSec();
+		apRenderList->Compile(lAllFlags);
+		glNewSortTime += cPlatform::GetApplicationTimeNanoSec() - lStartTime;
+	}
+
+	////////////////////////////
+	// Get the unsorted input of each list, classified the same way as in cRenderList::AddObject.
+	for(int i=0; i<apRenderList->GetSolidObjectNum(); ++i)
+	{
+		iRenderable *pObject = apRenderList->GetSolidObject(i);
+		vSourceArrays[eRenderListType_Z].push_back(pObject);
+		vSourceArrays[eRenderListType_Diffuse].push_back(pObject);
+		if(pObject->GetMaterial()->GetTexture(eMaterialTexture_Illumination) && pObject->GetIlluminationAmount()>0)
+			vSourceArrays[eRenderListType_Illumination].push_back(pObject);
+	}
+	for(int i=0; i<apRenderList->GetTransObjectNum(); ++i)
+	{
+		vSourceArrays[eRenderListType_Translucent].push_back(apRenderList->GetTransObject(i));
+	}
+	for(cRenderableVecIterator it = apRenderList->GetArrayIterator(eRenderListType_Decal); it.HasNext(); )
+	{
+		vSourceArrays[eRenderListType_Decal].push_back(it.Next());
+	}
+
+	////////////////////////////
+	// Old: copy and comparator sort
+	tRenderableVec vSortedArrays[eRenderListType_LastEnum];
+	for(int i=0; i<glIterations; ++i)
+	{
+		uint64_t lStartTime = cPlatform::GetApplicationTimeNanoSec();
+		for(int type=0; type<eRenderListType_LastEnum; ++type)
+		{
+			vSortedArrays[type] = vSourceArrays[type];
+			std::sort(vSortedArrays[type].begin(), vSortedArrays[type].end(), gvSortFunctions[type]);
+		}
+		glOldSortTime += cPlatform::GetApplicationTimeNanoSec() - lStartTime;
+	}
+
+	for(int type=0; type<eRenderListType_LastEnum; ++type)
+	{
+		glSortedObjectNum += vSourceArrays[type].size();
+	}
+}
+
+//------------------------------------------
+
+bool RunBenchmark()
+{
+	cWorld *pWorld = gpEngine->GetScene()->LoadWorld(gsMapFile, 0);
+	if(pWorld==NULL)
+	{
+		printf("Could not load map '%s'!\n", gsMapFile.c_str());
+		return false;
+	}
+
+	////////////////////////////
+	// Place cameras on a grid over the static geometry, looking in four directions from each spot.
+	iRenderableContainerNode *pStaticRoot = pWorld->GetRenderableContainer(eWorldContainerType_Static)->GetRoot();
+	pStaticRoot->UpdateBeforeUse();
+	cVector3f vMin = pStaticRoot->GetMin();
+	cVector3f vMax = pStaticRoot->GetMax();
+
+	cCamera *pCamera = gpEngine->GetScene()->CreateCamera(eCameraMoveMode_Fly);
+	pCamera->SetRotateMode(eCameraRotateMode_EulerAngles);
+
+	cRenderList renderList;
+
+	int lViewNum = 0;
+	for(int x=0; x<glViewsPerAxis; ++x)
+	for(int z=0; z<glViewsPerAxis; ++z)
+	{
+		cVector3f vPos(	vMin.x + (vMax.x-vMin.x) * ((float)x+0.5f) / (float)glViewsPerAxis,
+						(vMin.y + vMax.y)*0.5f,
+						vMin.z + (vMax.z-vMin.z) * ((float)z+0.5f) / (float)glViewsPerAxis);
+		pCamera->SetPosition(vPos);
+
+		for(int lDir=0; lDir<4; ++lDir)
+		{
+			pCamera->SetYaw(kPi2f * (float)lDir);
+
+			BenchmarkView(pWorld, pCamera->GetFrustum(), &renderList);
+			++lViewNum;
+		}
+	}
+
+	gpEngine->GetScene()->DestroyCamera(pCamera);
+	gpEngine->GetScene()->DestroyWorld(pWorld);
+
+	////////////////////////////
+	// Print result
+	double fSortCalls = (double)lViewNum * (double)glIterations;
+	double fNewMs = (double)glNewSortTime / 1000000.0;
+	double fOldMs = (double)glOldSortTime / 1000000.0;
+
+	printf("Views: %d Iterations: %d Sorted objects per iteration (all lists, avg): %.1f\n", lViewNum, glIterations, (double)glSortedObjectNum / (double)lViewNum);
+	printf(" Key + radix sort:  %10.3f ms total %8.2f us per compile\n", fNewMs, fNewMs*1000.0 / fSortCalls);
+	printf(" Comparator sort:   %10.3f ms total %8.2f us per compile\n", fOldMs, fOldMs*1000.0 / fSortCalls);
+	if(glNewSortTime > 0) printf(" Speedup: %.2fx\n", (double)glOldSortTime / (double)glNewSortTime);
+
+	return true;
+}
+
+//------------------------------------------
+
+void Init()
+{
+	gpEngine->GetPhysics()->LoadSurfaceData("materials.cfg");
+
+	gpEngine->GetResources()->LoadResourceDirsFile("resources.cfg");
+	gpEngine->GetResources()->AddEntityLoader(hplNew(cSimpleObjectLoader,("Object")),true);
+}
+
+//------------------------------------------
+
+#ifdef WIN32
+	int main(int argc, const char* argv[] )
+	{
+		tString asCommandLine;
+		for(int i=1; i<argc; ++i)
+		{
+			asCommandLine += argv[i];
+			if(i!=argc-1) asCommandLine += " ";
+		}
+
+#else
+	int hplMain(const tString &asCommandLine)
+	{
+#endif
+
+	SetLogFile(_W("RenderListBench.log"));
+
+	ParseCommandLine(asCommandLine);
+	if(gsMapFile == "")
+	{
+		printf("Usage: RenderListBench [-views <num per axis>] [-iterations <num>] <map file>\n");
+		return 1;
+	}
+
+	//Null graphics, so materials load with programs and textures, but no window or context is needed.
+	cEngineInitVars vars;
+	gpEngine = CreateHPLEngine(eHplAPI_Null, eHplSetup_Screen, &vars);
+
+	Init();
+
+	bool bRet = RunBenchmark();
+
+	DestroyHPLEngine(gpEngine);
+
+	return bRet ? 0 : 1;
+}
+
+#ifdef WIN32
+	int hplMain(const tString &asCommandLine){return -1;}
+#endif
+
+#ifdef __APPLE__
+extern "C" int SDL_main(int argc, char *argv[]);
+int main(int argc, char * argv[]) {
+    return SDL_main(argc, argv);
+}
+#endif
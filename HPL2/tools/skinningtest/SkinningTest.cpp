@@ -0,0 +1,359 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Unit test for cSkinning. Skins random meshes with the SIMD kernel, the scalar kernel and split over a job manager,
+ * and checks that all of them are bit-exact with the skinning loop cSubMeshEntity used before cSkinning.
+ * Returns 0 if all tests pass. No engine is created, so it can be run from anywhere:
+ *
+ *   SkinningTest [-threads <num>]
+ */
+
+#include "hpl.h"
+
+#include "graphics/Skinning.h"
+#include "system/JobManager.h"
+
+#include <string.h>
+
+using namespace hpl;
+
+//------------------------------------------
+
+int glThreadNum = 3;
+
+int glNumOfTests = 0;
+int glNumOfFailed = 0;
+
+//------------------------------------------
+
+void ParseCommandLine(const tString &asCommandLine)
+{
+	tStringVec args;
+	tString sSepp = " ";
+	cString::GetStringVec(asCommandLine, args,&sSepp);
+
+	for(size_t i=0; i<args.size(); ++i)
+	{
+		if(args[i] == "-threads" && i+1 < args.size())
+		{
+			glThreadNum = cString::ToInt(args[++i].c_str(), glThreadNum);
+		}
+	}
+}
+
+//------------------------------------------
+
+//////////////////////////////////////////////////////////////////////////
+// OLD SKINNING LOOP
+//////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------
+
+// This is the loop from cSubMeshEntity::UpdateGraphicsForFrame before cSkinning, kept here as the reference.
+// Note that it does not step the array pointers for vertices without weights, so the vertices after such a vertex
+// got the wrong data. cSkinning does not do this, so the test meshes have at least one weight for every vertex.
+
+static inline void MatrixFloatTransformSet(float *pDest, const cMatrixf &a_mtxA, const float* pSrc, const float fWeight)
+{
+	pDest[0] = ( a_mtxA.m[0][0] * pSrc[0] + a_mtxA.m[0][1] * pSrc[1] + a_mtxA.m[0][2] * pSrc[2] + a_mtxA.m[0][3] ) * fWeight;
+	pDest[1] = ( a_mtxA.m[1][0] * pSrc[0] + a_mtxA.m[1][1] * pSrc[1] + a_mtxA.m[1][2] * pSrc[2] + a_mtxA.m[1][3] ) * fWeight;
+	pDest[2] = ( a_mtxA.m[2][0] * pSrc[0] + a_mtxA.m[2][1] * pSrc[1] + a_mtxA.m[2][2] * pSrc[2] + a_mtxA.m[2][3] ) * fWeight;
+}
+
+static inline void MatrixFloatRotateSet(float *pDest, const cMatrixf &a_mtxA, const float* pSrc, const float fWeight)
+{
+	pDest[0] = ( a_mtxA.m[0][0] * pSrc[0] + a_mtxA.m[0][1] * pSrc[1] + a_mtxA.m[0][2] * pSrc[2] ) * fWeight;
+	pDest[1] = ( a_mtxA.m[1][0] * pSrc[0] + a_mtxA.m[1][1] * pSrc[1] + a_mtxA.m[1][2] * pSrc[2] ) * fWeight;
+	pDest[2] = ( a_mtxA.m[2][0] * pSrc[0] + a_mtxA.m[2][1] * pSrc[1] + a_mtxA.m[2][2] * pSrc[2] ) * fWeight;
+}
+
+static inline void MatrixFloatTransformAdd(float *pDest, const cMatrixf &a_mtxA, const float* pSrc, const float fWeight)
+{
+	pDest[0] += ( a_mtxA.m[0][0] * pSrc[0] + a_mtxA.m[0][1] * pSrc[1] + a_mtxA.m[0][2] * pSrc[2] + a_mtxA.m[0][3] ) * fWeight;
+	pDest[1] += ( a_mtxA.m[1][0] * pSrc[0] + a_mtxA.m[1][1] * pSrc[1] + a_mtxA.m[1][2] * pSrc[2] + a_mtxA.m[1][3] ) * fWeight;
+	pDest[2] += ( a_mtxA.m[2][0] * pSrc[0] + a_mtxA.m[2][1] * pSrc[1] + a_mtxA.m[2][2] * pSrc[2] + a_mtxA.m[2][3] ) * fWeight;
+}
+
+static inline void MatrixFloatRotateAdd(float *pDest, const cMatrixf &a_mtxA, const float* pSrc, const float fWeight)
+{
+	pDest[0] += ( a_mtxA.m[0][0] * pSrc[0] + a_mtxA.m[0][1] * pSrc[1] + a_mtxA.m[0][2] * pSrc[2] ) * fWeight;
+	pDest[1] += ( a_mtxA.m[1][0] * pSrc[0] + a_mtxA.m[1][1] * pSrc[1] + a_mtxA.m[1][2] * pSrc[2] ) * fWeight;
+	pDest[2] += ( a_mtxA.m[2][0] * pSrc[0] + a_mtxA.m[2][1] * pSrc[1] + a_mtxA.m[2][2] * pSrc[2] ) * fWeight;
+}
+
+//------------------------------------------
+
+static void SkinVerticesOld(const cSkinningData &aData, int lVtxNum)
+{
+	const float *pBindPos = aData.mpBindPos;
+	const float *pBindNormal = aData.mpBindNormal;
+	const float *pBindTangent = aData.mpBindTangent;
+
+	float *pSkinPos = aData.mpSkinPos;
+	float *pSkinNormal = aData.mpSkinNormal;
+	float *pSkinTangent = aData.mpSkinTangent;
+
+	const int lVtxStride = aData.mlPosStride;
+
+	for(int vtx=0; vtx < lVtxNum; vtx++)
+	{
+		//To count the bone bindings
+		int lCount = 0;
+		//Get pointer to weights and bone index.
+		const float *pWeight = &aData.mpWeights[vtx*4];
+		if(*pWeight==0) continue;
+
+		const unsigned char *pBoneIdx = &aData.mpBones[vtx*4];
+
+		const cMatrixf &mtxTransform = aData.mpBoneMatrices[*pBoneIdx];
+
+		MatrixFloatTransformSet(pSkinPos,mtxTransform, pBindPos, *pWeight);
+		MatrixFloatRotateSet(pSkinNormal,mtxTransform, pBindNormal, *pWeight);
+		MatrixFloatRotateSet(pSkinTangent,mtxTransform, pBindTangent, *pWeight);
+
+		++pWeight; ++pBoneIdx; ++lCount;
+
+		//Iterate weights until 0 is found or count < 4
+		while(*pWeight != 0 && lCount < 4)
+		{
+			const cMatrixf &mtxTransform = aData.mpBoneMatrices[*pBoneIdx];
+
+			MatrixFloatTransformAdd(pSkinPos,mtxTransform, pBindPos, *pWeight);
+			MatrixFloatRotateAdd(pSkinNormal,mtxTransform, pBindNormal, *pWeight);
+			MatrixFloatRotateAdd(pSkinTangent,mtxTransform, pBindTangent, *pWeight);
+
+			++pWeight; ++pBoneIdx; ++lCount;
+		}
+
+		pBindPos += lVtxStride;
+		pSkinPos += lVtxStride;
+
+		pBindNormal += 3;
+		pSkinNormal += 3;
+
+		pBindTangent += 4;
+		pSkinTangent += 4;
+	}
+}
+
+//------------------------------------------
+
+//////////////////////////////////////////////////////////////////////////
+// TEST MESH
+//////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------
+
+unsigned int glRandSeed = 12345;
+
+float RandFloat(float afMin, float afMax)
+{
+	//Own generator so that every run and platform uses the same data.
+	glRandSeed = glRandSeed * 1664525u + 1013904223u;
+	return afMin + (afMax-afMin) * ((float)(glRandSeed >> 8) / (float)(1 << 24));
+}
+
+//------------------------------------------
+
+class cTestMesh
+{
+public:
+	cTestMesh(int alVertexNum, int alBoneNum)
+	{
+		mlVertexNum = alVertexNum;
+
+		mvBindPos.resize(alVertexNum*4);
+		mvBindNormal.resize(alVertexNum*3);
+		mvBindTangent.resize(alVertexNum*4);
+		mvWeights.resize(alVertexNum*4 + 4, 0); //The old loop reads the weight after the last one
+		mvBones.resize(alVertexNum*4, 0);
+
+		for(size_t i=0; i<mvBindPos.size(); ++i) mvBindPos[i] = RandFloat(-2, 2);
+		for(size_t i=0; i<mvBindNormal.size(); ++i) mvBindNormal[i] = RandFloat(-1, 1);
+		for(size_t i=0; i<mvBindTangent.size(); ++i) mvBindTangent[i] = RandFloat(-1, 1);
+
+		for(int vtx=0; vtx<alVertexNum; ++vtx)
+		{
+			int lWeightNum = (int)RandFloat(1, 4.999f);
+			float fTotal = 0;
+			for(int i=0; i<lWeightNum; ++i)
+			{
+				mvWeights[vtx*4+i] = RandFloat(0.05f, 1);
+				mvBones[vtx*4+i] = (unsigned char)RandFloat(0, (float)alBoneNum - 0.001f);
+				fTotal += mvWeights[vtx*4+i];
+			}
+			for(int i=0; i<lWeightNum; ++i) mvWeights[vtx*4+i] /= fTotal;
+		}
+
+		mvBoneMatrices.resize(alBoneNum);
+		for(int bone=0; bone<alBoneNum; ++bone)
+		{
+			cMatrixf mtxBone = cMath::MatrixRotate(cVector3f(RandFloat(-kPif,kPif), RandFloat(-kPif,kPif), RandFloat(-kPif,kPif)), eEulerRotationOrder_XYZ);
+			mtxBone.SetTranslation(cVector3f(RandFloat(-5,5), RandFloat(-5,5), RandFloat(-5,5)));
+			mvBoneMatrices[bone] = mtxBone;
+		}
+		cSkinning::SetupBoneColumns(&mvBoneMatrices[0], alBoneNum, mvBoneColumns);
+	}
+
+	/**
+	 * Sets up skinning into the output arrays. They are filled with a pattern first so that unwritten values are checked too.
+	 */
+	void SetupSkinning(cSkinningData &aData, std::vector<float> &avPos, std::vector<float> &avNormal, std::vector<float> &avTangent)
+	{
+		avPos.assign(mvBindPos.size(), -123.0f);
+		avNormal.assign(mvBindNormal.size(), -123.0f);
+		avTangent.assign(mvBindTangent.size(), -123.0f);
+
+		aData.mpBindPos = &mvBindPos[0];
+		aData.mpBindNormal = &mvBindNormal[0];
+		aData.mpBindTangent = &mvBindTangent[0];
+		aData.mpSkinPos = &avPos[0];
+		aData.mpSkinNormal = &avNormal[0];
+		aData.mpSkinTangent = &avTangent[0];
+		aData.mlPosStride = 4;
+		aData.mpWeights = &mvWeights[0];
+		aData.mpBones = &mvBones[0];
+		aData.mpBoneMatrices = &mvBoneMatrices[0];
+		aData.mpBoneColumns = &mvBoneColumns[0];
+	}
+
+	int mlVertexNum;
+
+	std::vector<float> mvBindPos;
+	std::vector<float> mvBindNormal;
+	std::vector<float> mvBindTangent;
+	std::vector<float> mvWeights;
+	std::vector<unsigned char> mvBones;
+
+	std::vector<cMatrixf> mvBoneMatrices;
+	std::vector<float> mvBoneColumns;
+};
+
+//------------------------------------------
+
+//////////////////////////////////////////////////////////////////////////
+// TESTS
+//////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------
+
+enum eSkinMethod
+{
+	eSkinMethod_Scalar,
+	eSkinMethod_Simd,
+	eSkinMethod_Parallel,
+	eSkinMethod_LastEnum
+};
+
+static const char* gvMethodNames[eSkinMethod_LastEnum] = {"Scalar", "Simd", "Parallel"};
+
+//------------------------------------------
+
+bool ArraysAreEqual(const std::vector<float> &avA, const std::vector<float> &avB)
+{
+	//Compare bits, not values, so that -0 and 0 count as different.
+	return memcmp(&avA[0], &avB[0], avA.size()*sizeof(float)) == 0;
+}
+
+//------------------------------------------
+
+void RunTest(int alVertexNum, int alBoneNum)
+{
+	cTestMesh mesh(alVertexNum, alBoneNum);
+
+	std::vector<float> vRefPos, vRefNormal, vRefTangent;
+	cSkinningData refData;
+	mesh.SetupSkinning(refData, vRefPos, vRefNormal, vRefTangent);
+	SkinVerticesOld(refData, alVertexNum);
+
+	for(int method=0; method<eSkinMethod_LastEnum; ++method)
+	{
+		std::vector<float> vPos, vNormal, vTangent;
+		cSkinningData data;
+		mesh.SetupSkinning(data, vPos, vNormal, vTangent);
+
+		if(method == eSkinMethod_Scalar)		cSkinning::SkinVerticesScalar(data, 0, alVertexNum);
+		else if(method == eSkinMethod_Simd)		cSkinning::SkinVertices(data, 0, alVertexNum);
+		else									cSkinning::SkinVerticesParallel(data, alVertexNum);
+
+		bool bPassed =	ArraysAreEqual(vPos, vRefPos) &&
+						ArraysAreEqual(vNormal, vRefNormal) &&
+						ArraysAreEqual(vTangent, vRefTangent);
+
+		++glNumOfTests;
+		if(bPassed==false) ++glNumOfFailed;
+
+		printf(" %-8s vertices: %6d bones: %3d ... %s\n", gvMethodNames[method], alVertexNum, alBoneNum, bPassed ? "ok" : "FAILED");
+	}
+}
+
+//------------------------------------------
+
+#ifdef WIN32
+	int main(int argc, const char* argv[] )
+	{
+		tString asCommandLine;
+		for(int i=1; i<argc; ++i)
+		{
+			asCommandLine += argv[i];
+			if(i!=argc-1) asCommandLine += " ";
+		}
+
+#else
+	int hplMain(const tString &asCommandLine)
+	{
+#endif
+
+	SetLogFile(_W("SkinningTest.log"));
+
+	ParseCommandLine(asCommandLine);
+
+	//Becomes the global manager, so SkinVerticesParallel uses it.
+	cJobManager *pJobManager = hplNew( cJobManager, (glThreadNum) );
+
+	printf("-------- SKINNING TEST STARTED (SIMD: %s) -----------\n\n", cSkinning::UsesSimd() ? "yes" : "no");
+
+	//Sizes around the grain size check that the ranges are split and joined right.
+	int lGrainSize = cSkinning::GetParallelGrainSize();
+	RunTest(1, 1);
+	RunTest(37, 4);
+	RunTest(lGrainSize, 16);
+	RunTest(lGrainSize+1, 16);
+	RunTest(lGrainSize*3 - 7, 32);
+	RunTest(20000, 64);
+
+	printf("\nTests: %d Failed: %d\n", glNumOfTests, glNumOfFailed);
+	printf("-------- SKINNING TEST DONE! -----------\n");
+
+	hplDelete(pJobManager);
+
+	return glNumOfFailed > 0 ? 1 : 0;
+}
+
+#ifdef WIN32
+	int hplMain(const tString &asCommandLine){return -1;}
+#endif
+
+#ifdef __APPLE__
+extern "C" int SDL_main(int argc, char *argv[]);
+int main(int argc, char * argv[]) {
+    return SDL_main(argc, argv);
+}
+#endif
@@ -0,0 +1,303 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Unit test for cSoftwareOcclusion. A wall quad is drawn as occluder in front of a camera looking down -z and boxes
+ * with known results are tested against it: behind the wall, in front of it, beside it, through it and around the
+ * camera. Two tiny boxes right at the edge of the wall check that boxes within a pixel whose center is covered are
+ * still visible if they are outside of the wall. Then many walls and boxes are timed.
+ * Returns 0 if all tests pass. No engine is created, so it can be run from anywhere:
+ *
+ *   SoftOcclusionTest [-threads <num, 0 for no job manager>] [-queries <num>]
+ */
+
+#include "hpl.h"
+
+#include "graphics/SoftwareOcclusion.h"
+#include "system/JobManager.h"
+
+using namespace hpl;
+
+//------------------------------------------
+
+int glThreadNum = 3;
+int glQueryNum = 100000;
+
+int glNumOfTests = 0;
+int glNumOfFailed = 0;
+
+//------------------------------------------
+
+void ParseCommandLine(const tString &asCommandLine)
+{
+	tStringVec args;
+	tString sSepp = " ";
+	cString::GetStringVec(asCommandLine, args,&sSepp);
+
+	for(size_t i=0; i<args.size(); ++i)
+	{
+		if(args[i] == "-threads" && i+1 < args.size())
+		{
+			glThreadNum = cString::ToInt(args[++i].c_str(), glThreadNum);
+		}
+		else if(args[i] == "-queries" && i+1 < args.size())
+		{
+			glQueryNum = cString::ToInt(args[++i].c_str(), glQueryNum);
+		}
+	}
+}
+
+//------------------------------------------
+
+//////////////////////////////////////////////////////////////////////////
+// VIEW
+//////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------
+
+static const float gfNearPlane = 0.1f;
+static const float gfFarPlane = 100.0f;
+static const float gfFOV = cMath::ToRad(60.0f);
+static const float gfAspect = 2.0f;
+
+static const int glBufferWidth = 256;
+static const int glBufferHeight = 128;
+
+//------------------------------------------
+
+void SetupFrustum(cFrustum *apFrustum)
+{
+	//Camera at the origin looking down -z, so the view matrix is identity.
+	cMatrixf mtxProj = cMath::MatrixPerspectiveProjection(gfNearPlane, gfFarPlane, gfFOV, gfAspect, false);
+	apFrustum->SetupPerspectiveProj(mtxProj, cMatrixf::Identity, gfFarPlane, gfNearPlane, gfFOV, gfAspect, 0, false);
+}
+
+//------------------------------------------
+
+/**
+ * Returns the world x at distance afDepth in front of the camera that ends up at afScreenX in the buffer.
+ */
+float WorldXAtScreenX(float afScreenX, float afDepth)
+{
+	float fNdcX = (afScreenX / (float)glBufferWidth - 0.5f) * 2.0f;
+	return fNdcX * tanf(gfFOV*0.5f) * gfAspect * afDepth;
+}
+
+//------------------------------------------
+
+class cTestQuad
+{
+public:
+	/**
+	 * A quad facing the camera at distance afDepth.
+	 */
+	cTestQuad(float afMinX, float afMinY, float afMaxX, float afMaxY, float afDepth)
+	{
+		float vPos[12] = {	afMinX, afMinY, -afDepth,
+							afMaxX, afMinY, -afDepth,
+							afMaxX, afMaxY, -afDepth,
+							afMinX, afMaxY, -afDepth};
+		unsigned int vIdx[6] = {0,1,2, 0,2,3};
+
+		mvPositions.assign(vPos, vPos+12);
+		mvIndices.assign(vIdx, vIdx+6);
+	}
+
+	void AddTo(cSoftwareOcclusion *apOcclusion)
+	{
+		apOcclusion->AddOccluderMesh(&mvPositions[0], 3, &mvIndices[0], (int)mvIndices.size(), cMatrixf::Identity);
+	}
+
+	std::vector<float> mvPositions;
+	std::vector<unsigned int> mvIndices;
+};
+
+//------------------------------------------
+
+//////////////////////////////////////////////////////////////////////////
+// TESTS
+//////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------
+
+void TestBox(cSoftwareOcclusion *apOcclusion, const char *asName, const cVector3f &avMin, const cVector3f &avMax, bool abExpectVisible)
+{
+	bool bVisible = apOcclusion->IsAABBVisible(avMin, avMax);
+	bool bPassed = bVisible == abExpectVisible;
+
+	++glNumOfTests;
+	if(bPassed==false) ++glNumOfFailed;
+
+	printf(" %-28s expected: %-7s got: %-7s ... %s\n", asName, abExpectVisible ? "visible" : "hidden",
+															bVisible ? "visible" : "hidden", bPassed ? "ok" : "FAILED");
+}
+
+//------------------------------------------
+
+void RunWallTests()
+{
+	cFrustum frustum;
+	SetupFrustum(&frustum);
+
+	cSoftwareOcclusion occlusion(glBufferWidth, glBufferHeight);
+	occlusion.BeginFrame(&frustum);
+
+	//The right edge of the wall lands at 0.6 into a pixel, so the center of that pixel is covered.
+	const float fWallDepth = 10.0f;
+	const float fEdgeScreenX = 172.6f;
+	float fWallMaxX = WorldXAtScreenX(fEdgeScreenX, fWallDepth);
+
+	cTestQuad wall(-4, -3, fWallMaxX, 3, fWallDepth);
+	wall.AddTo(&occlusion);
+	occlusion.Rasterize();
+
+	TestBox(&occlusion, "Behind wall", cVector3f(-1,-1,-15), cVector3f(1,1,-13), false);
+	TestBox(&occlusion, "In front of wall", cVector3f(-1,-1,-6), cVector3f(1,1,-5), true);
+	TestBox(&occlusion, "Beside wall", cVector3f(6,-1,-15), cVector3f(7,1,-13), true);
+	TestBox(&occlusion, "Partly behind wall", cVector3f(2,-1,-15), cVector3f(7,1,-13), true);
+	TestBox(&occlusion, "Through wall", cVector3f(-1,-1,-11), cVector3f(1,1,-9), true);
+	TestBox(&occlusion, "Around camera", cVector3f(-1,-1,-1), cVector3f(1,1,1), true);
+	TestBox(&occlusion, "Behind camera", cVector3f(-1,-1,5), cVector3f(1,1,6), true);
+
+	//Both boxes are much smaller than a pixel and are in the pixel rows in the middle of the wall.
+	const float fBoxDepth = 15.0f;
+	float fInsideX0 = WorldXAtScreenX(fEdgeScreenX - 2.4f, fBoxDepth);
+	float fInsideX1 = WorldXAtScreenX(fEdgeScreenX - 2.2f, fBoxDepth);
+	TestBox(&occlusion, "Sub pixel, inside edge", cVector3f(fInsideX0,-0.01f,-fBoxDepth-0.01f), cVector3f(fInsideX1,0.01f,-fBoxDepth), false);
+
+	float fOutsideX0 = WorldXAtScreenX(fEdgeScreenX + 0.1f, fBoxDepth);
+	float fOutsideX1 = WorldXAtScreenX(fEdgeScreenX + 0.3f, fBoxDepth);
+	TestBox(&occlusion, "Sub pixel, outside edge", cVector3f(fOutsideX0,-0.01f,-fBoxDepth-0.01f), cVector3f(fOutsideX1,0.01f,-fBoxDepth), true);
+
+	////////////////////////////
+	//Without a frame set up nothing may be culled.
+	cSoftwareOcclusion inactiveOcclusion(glBufferWidth, glBufferHeight);
+	TestBox(&inactiveOcclusion, "No frame", cVector3f(-1,-1,-15), cVector3f(1,1,-13), true);
+}
+
+//------------------------------------------
+
+//////////////////////////////////////////////////////////////////////////
+// TIMING
+//////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------
+
+unsigned int glRandSeed = 12345;
+
+float RandFloat(float afMin, float afMax)
+{
+	//Own generator so that every run and platform uses the same data.
+	glRandSeed = glRandSeed * 1664525u + 1013904223u;
+	return afMin + (afMax-afMin) * ((float)(glRandSeed >> 8) / (float)(1 << 24));
+}
+
+//------------------------------------------
+
+void RunTiming()
+{
+	cFrustum frustum;
+	SetupFrustum(&frustum);
+
+	//Same number of occluders as the renderer uses by default.
+	std::vector<cTestQuad*> vWalls;
+	for(int i=0; i<64; ++i)
+	{
+		float fX = RandFloat(-30, 30);
+		float fY = RandFloat(-10, 10);
+		vWalls.push_back(hplNew( cTestQuad, (fX, fY, fX + RandFloat(1,6), fY + RandFloat(1,4), RandFloat(5, 40)) ));
+	}
+
+	cSoftwareOcclusion occlusion(glBufferWidth, glBufferHeight);
+
+	uint64_t lStartTime = cPlatform::GetApplicationTimeNanoSec();
+	occlusion.BeginFrame(&frustum);
+	for(size_t i=0; i<vWalls.size(); ++i) vWalls[i]->AddTo(&occlusion);
+	occlusion.Rasterize();
+	uint64_t lRasterizeTime = cPlatform::GetApplicationTimeNanoSec() - lStartTime;
+
+	int lHiddenNum = 0;
+	lStartTime = cPlatform::GetApplicationTimeNanoSec();
+	for(int i=0; i<glQueryNum; ++i)
+	{
+		cVector3f vMin(RandFloat(-40, 40), RandFloat(-15, 15), -RandFloat(5, 60));
+		cVector3f vMax = vMin + cVector3f(RandFloat(0.1f,2), RandFloat(0.1f,2), RandFloat(0.1f,2));
+		if(occlusion.IsAABBVisible(vMin, vMax)==false) ++lHiddenNum;
+	}
+	uint64_t lQueryTime = cPlatform::GetApplicationTimeNanoSec() - lStartTime;
+
+	printf(" Occluders: %d Triangles: %d Rasterize: %.3f ms\n", occlusion.GetOccluderNum(), occlusion.GetTriangleNum(),
+																(double)lRasterizeTime / 1000000.0);
+	printf(" Queries: %d Hidden: %d Time: %.3f ms (%.1f ns per query)\n", glQueryNum, lHiddenNum, (double)lQueryTime / 1000000.0,
+																		glQueryNum > 0 ? (double)lQueryTime / (double)glQueryNum : 0.0);
+
+	STLDeleteAll(vWalls);
+}
+
+//------------------------------------------
+
+#ifdef WIN32
+	int main(int argc, const char* argv[] )
+	{
+		tString asCommandLine;
+		for(int i=1; i<argc; ++i)
+		{
+			asCommandLine += argv[i];
+			if(i!=argc-1) asCommandLine += " ";
+		}
+
+#else
+	int hplMain(const tString &asCommandLine)
+	{
+#endif
+
+	SetLogFile(_W("SoftOcclusionTest.log"));
+
+	ParseCommandLine(asCommandLine);
+
+	//Becomes the global manager, so Rasterize splits the work over it.
+	cJobManager *pJobManager = NULL;
+	if(glThreadNum > 0) pJobManager = hplNew( cJobManager, (glThreadNum) );
+
+	printf("-------- SOFTWARE OCCLUSION TEST STARTED (SIMD: %s Threads: %d) -----------\n\n", cSoftwareOcclusion::UsesSimd() ? "yes" : "no", glThreadNum);
+
+	RunWallTests();
+
+	printf("\n");
+	RunTiming();
+
+	printf("\nTests: %d Failed: %d\n", glNumOfTests, glNumOfFailed);
+	printf("-------- SOFTWARE OCCLUSION TEST DONE! -----------\n");
+
+	if(pJobManager) hplDelete(pJobManager);
+
+	return glNumOfFailed > 0 ? 1 : 0;
+}
+
+#ifdef WIN32
+	int hplMain(const tString &asCommandLine){return -1;}
+#endif
+
+#ifdef __APPLE__
+extern "C" int SDL_main(int argc, char *argv[]);
+int main(int argc, char * argv[]) {
+    return SDL_main(argc, argv);
+}
+#endif
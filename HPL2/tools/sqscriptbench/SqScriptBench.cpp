@@ -0,0 +1,222 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Micro-benchmark for script callbacks. A small script is compiled with the null graphics backend and the same
+ * callbacks are run with iScript::Run, which compiles the call line each time, and with iScript::RunCallback,
+ * which looks the func up once and passes the arguments directly.
+ * Run from any directory, the script is written to SqScriptBench.hps in the current directory:
+ *
+ *   SqScriptBench [-iterations <num>]
+ */
+
+#include "hpl.h"
+
+using namespace hpl;
+
+cEngine *gpEngine=NULL;
+
+//------------------------------------------
+
+int glIterations = 20000;
+
+//------------------------------------------
+
+static const char *gsBenchScript =
+	"int glCalls = 0;\n"
+	"void OnUpdate()\n"
+	"{\n"
+	"	glCalls++;\n"
+	"}\n"
+	"void OnCollide(string &in asParent, string &in asChild, int alState)\n"
+	"{\n"
+	"	if(alState == 1) glCalls++;\n"
+	"}\n"
+	"void OnInteract(string &in asEntity, float afAmount, bool abFlag)\n"
+	"{\n"
+	"	if(abFlag) glCalls++;\n"
+	"}\n";
+
+//------------------------------------------
+
+void ParseCommandLine(const tString &asCommandLine)
+{
+	tStringVec args;
+	tString sSepp = " ";
+	cString::GetStringVec(asCommandLine, args,&sSepp);
+
+	for(size_t i=0; i<args.size(); ++i)
+	{
+		const tString &sArg = args[i];
+
+		if(sArg == "-iterations" && i+1 < args.size())
+		{
+			glIterations = cMath::Max(cString::ToInt(args[++i].c_str(), glIterations), 1);
+		}
+	}
+}
+
+//------------------------------------------
+
+//////////////////////////////////////////////////////////////////////////
+// BENCHMARK
+//////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------
+
+class cCallbackTest
+{
+public:
+	tString msFunc;
+	cScriptArgs mArgs;
+};
+
+//------------------------------------------
+
+void BenchmarkCallback(iScript *apScript, const cCallbackTest& aTest)
+{
+	tString sFuncLine = aTest.msFunc + aTest.mArgs.ToString();
+
+	////////////////////////////
+	// Old: the call line is compiled each time
+	bool bRunOk = true;
+	uint64_t lStartTime = cPlatform::GetApplicationTimeNanoSec();
+	for(int i=0; i<glIterations; ++i)
+	{
+		if(apScript->Run(sFuncLine)==false) bRunOk = false;
+	}
+	uint64_t lRunTime = cPlatform::GetApplicationTimeNanoSec() - lStartTime;
+
+	////////////////////////////
+	// New: the func is looked up once and args are set directly
+	bool bCallbackOk = true;
+	lStartTime = cPlatform::GetApplicationTimeNanoSec();
+	for(int i=0; i<glIterations; ++i)
+	{
+		if(apScript->RunCallback(aTest.msFunc, aTest.mArgs)==false) bCallbackOk = false;
+	}
+	uint64_t lCallbackTime = cPlatform::GetApplicationTimeNanoSec() - lStartTime;
+
+	////////////////////////////
+	// Print result
+	double fRunUs = (double)lRunTime / 1000.0 / (double)glIterations;
+	double fCallbackUs = (double)lCallbackTime / 1000.0 / (double)glIterations;
+
+	printf("%s\n", sFuncLine.c_str());
+	printf(" Run:          %8.3f us per call%s\n", fRunUs, bRunOk ? "" : " (FAILED)");
+	printf(" RunCallback:  %8.3f us per call%s\n", fCallbackUs, bCallbackOk ? "" : " (FAILED)");
+	if(lCallbackTime > 0) printf(" Speedup: %.2fx\n", (double)lRunTime / (double)lCallbackTime);
+}
+
+//------------------------------------------
+
+bool RunBenchmark()
+{
+	////////////////////////////
+	// Write and compile the script
+	tWString sScriptFile = _W("SqScriptBench.hps");
+	FILE *pFile = cPlatform::OpenFile(sScriptFile, _W("wb"));
+	if(pFile==NULL)
+	{
+		printf("Could not write '%s'!\n", cString::To8Char(sScriptFile).c_str());
+		return false;
+	}
+	fputs(gsBenchScript, pFile);
+	fclose(pFile);
+
+	iScript *pScript = gpEngine->GetSystem()->GetLowLevel()->CreateScript("SqScriptBench");
+	tString sCompileMessages;
+	if(pScript->CreateFromFile(sScriptFile, &sCompileMessages)==false)
+	{
+		printf("Could not compile bench script:\n%s\n", sCompileMessages.c_str());
+		hplDelete(pScript);
+		return false;
+	}
+
+	printf("Iterations: %d\n", glIterations);
+
+	////////////////////////////
+	// Callbacks with the kinds of args used by the game
+	cCallbackTest vTests[3];
+	vTests[0].msFunc = "OnUpdate";
+	vTests[1].msFunc = "OnCollide";
+	vTests[1].mArgs.AddString("player").AddString("door_1").AddInt(1);
+	vTests[2].msFunc = "OnInteract";
+	vTests[2].mArgs.AddString("lever_1").AddFloat(0.5f).AddBool(true);
+
+	for(int i=0; i<3; ++i)
+	{
+		BenchmarkCallback(pScript, vTests[i]);
+	}
+
+	////////////////////////////
+	// More args than kMaxScriptArgs must be rejected, not written past the arrays.
+	cScriptArgs tooManyArgs;
+	for(int i=0; i<kMaxScriptArgs+1; ++i) tooManyArgs.AddInt(i);
+
+	bool bRejected = tooManyArgs.IsValid()==false && pScript->RunCallback("OnUpdate", tooManyArgs)==false;
+	printf("%d args rejected: %s\n", kMaxScriptArgs+1, bRejected ? "yes" : "NO");
+
+	hplDelete(pScript);
+
+	return bRejected;
+}
+
+//------------------------------------------
+
+#ifdef WIN32
+	int main(int argc, const char* argv[] )
+	{
+		tString asCommandLine;
+		for(int i=1; i<argc; ++i)
+		{
+			asCommandLine += argv[i];
+			if(i!=argc-1) asCommandLine += " ";
+		}
+
+#else
+	int hplMain(const tString &asCommandLine)
+	{
+#endif
+
+	SetLogFile(_W("SqScriptBench.log"));
+
+	ParseCommandLine(asCommandLine);
+
+	//Only the script engine is needed, so no window or sound is created.
+	cEngineInitVars vars;
+	gpEngine = CreateHPLEngine(eHplAPI_Null, 0, &vars);
+
+	bool bRet = RunBenchmark();
+
+	DestroyHPLEngine(gpEngine);
+
+	return bRet ? 0 : 1;
+}
+
+#ifdef WIN32
+	int hplMain(const tString &asCommandLine){return -1;}
+#endif
+
+#ifdef __APPLE__
+extern "C" int SDL_main(int argc, char *argv[]);
+int main(int argc, char * argv[]) {
+    return SDL_main(argc, argv);
+}
+#endif
@@ -0,0 +1,289 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Micro-benchmark for XML loading. All .map and .ent files in a directory are parsed with TinyXML, which the
+ * documents were loaded with before, and with cXmlDocumentTiny, which now uses the single pass cXmlParser. Both
+ * trees are compared so the new parser can be checked against the old one on real data.
+ *
+ *   XmlBench [-subdirs] [-iterations <num>] <dir>
+ */
+
+#include "hpl.h"
+
+#include "impl/XmlDocumentTiny.h"
+#include "impl/tinyXML/tinyxml.h"
+
+using namespace hpl;
+
+//------------------------------------------
+
+bool gbSubDirs = false;
+int glIterations = 5;
+tWString gsDir = _W("");
+
+tWStringVec gvFiles;
+
+//------------------------------------------
+
+void ParseCommandLine(const tString &asCommandLine)
+{
+	tStringVec args;
+	tString sSepp = " ";
+	cString::GetStringVec(asCommandLine, args,&sSepp);
+
+	for(size_t i=0; i<args.size(); ++i)
+	{
+		const tString &sArg = args[i];
+
+		if(sArg == "-subdirs")
+		{
+			gbSubDirs = true;
+		}
+		else if(sArg == "-iterations" && i+1 < args.size())
+		{
+			glIterations = cMath::Max(cString::ToInt(args[++i].c_str(), glIterations), 1);
+		}
+		else
+		{
+			gsDir = cString::To16Char(sArg);
+		}
+	}
+}
+
+//------------------------------------------
+
+void FindFilesInDir(const tWString &asDir)
+{
+	const wchar_t* vMasks[] = {_W("*.map"), _W("*.ent")};
+	for(int i=0; i<2; ++i)
+	{
+		tWStringList lstFiles;
+		cPlatform::FindFilesInDir(lstFiles, asDir, vMasks[i]);
+		for(tWStringListIt it = lstFiles.begin(); it != lstFiles.end(); ++it)
+		{
+			gvFiles.push_back(cString::SetFilePathW(*it, asDir));
+		}
+	}
+
+	if(gbSubDirs==false) return;
+
+	tWStringList lstFolders;
+	cPlatform::FindFoldersInDir(lstFolders, asDir, false);
+	for(tWStringListIt it = lstFolders.begin(); it != lstFolders.end(); ++it)
+	{
+		FindFilesInDir(cString::SetFilePathW(*it, asDir));
+	}
+}
+
+//------------------------------------------
+
+//////////////////////////////////////////////////////////////////////////
+// COMPARE
+//////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------
+
+bool ElementsAreEqual(TiXmlElement *apTinyElem, cXmlElement *apElem)
+{
+	if(apElem->GetValue() != apTinyElem->Value()) return false;
+
+	////////////////////////////
+	// Attributes, in file order for both
+	tXmlAttributeVec *pAttributes = apElem->GetAttributes();
+	size_t lAttr = 0;
+	for(TiXmlAttribute *pTinyAttr = apTinyElem->FirstAttribute(); pTinyAttr; pTinyAttr = pTinyAttr->Next(), ++lAttr)
+	{
+		if(lAttr >= pAttributes->size()) return false;
+
+		const cXmlAttribute &attribute = (*pAttributes)[lAttr];
+		if(strcmp(attribute.mpName, pTinyAttr->Name())!=0 || strcmp(attribute.mpValue, pTinyAttr->Value())!=0) return false;
+	}
+	if(lAttr != pAttributes->size()) return false;
+
+	////////////////////////////
+	// Child elements
+	cXmlNodeListIterator it = apElem->GetChildIterator();
+	for(TiXmlElement *pTinyChild = apTinyElem->FirstChildElement(); pTinyChild; pTinyChild = pTinyChild->NextSiblingElement())
+	{
+		if(it.HasNext()==false) return false;
+		if(ElementsAreEqual(pTinyChild, it.Next()->ToElement())==false) return false;
+	}
+	return it.HasNext()==false;
+}
+
+//------------------------------------------
+
+/**
+ * Setting a value over and over must not use more pool memory once the value has room.
+ */
+bool SetAttributeReusesValue()
+{
+	cXmlDocumentTiny doc("Test");
+	doc.SetAttributeString("Name", "short");
+	doc.SetAttributeString("Name", "a longer value than before");
+
+	const char *pValue = doc.GetAttribute("Name");
+	for(int i=0; i<10000; ++i)
+	{
+		doc.SetAttributeInt("Name", i);
+		doc.SetAttributeString("Name", "a longer value than before");
+	}
+
+	return doc.GetAttribute("Name") == pValue && tString(pValue) == "a longer value than before";
+}
+
+//------------------------------------------
+
+//////////////////////////////////////////////////////////////////////////
+// BENCHMARK
+//////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------
+
+bool RunBenchmark()
+{
+	FindFilesInDir(gsDir);
+	if(gvFiles.empty())
+	{
+		printf("No .map or .ent files found in '%s'!\n", cString::To8Char(gsDir).c_str());
+		return false;
+	}
+
+	uint64_t lTinyTime = 0;
+	uint64_t lNewTime = 0;
+	size_t lTotalSize = 0;
+	int lFailedNum = 0;
+
+	for(size_t i=0; i<gvFiles.size(); ++i)
+	{
+		const tWString& sFile = gvFiles[i];
+
+		////////////////////////////
+		// Old: TinyXML
+		TiXmlDocument *pTinyDoc = NULL;
+		bool bTinyOk = true;
+		for(int j=0; j<glIterations && bTinyOk; ++j)
+		{
+			if(pTinyDoc) delete pTinyDoc;
+			pTinyDoc = new TiXmlDocument();
+
+			uint64_t lStartTime = cPlatform::GetApplicationTimeNanoSec();
+			FILE *pFile = cPlatform::OpenFile(sFile, _W("rb"));
+			bTinyOk = pFile && pTinyDoc->LoadFile(pFile);
+			if(pFile) fclose(pFile);
+			lTinyTime += cPlatform::GetApplicationTimeNanoSec() - lStartTime;
+		}
+
+		////////////////////////////
+		// New: cXmlParser
+		cXmlDocumentTiny *pDoc = NULL;
+		bool bNewOk = true;
+		for(int j=0; j<glIterations && bNewOk; ++j)
+		{
+			if(pDoc) hplDelete(pDoc);
+			pDoc = hplNew( cXmlDocumentTiny, ("") );
+
+			uint64_t lStartTime = cPlatform::GetApplicationTimeNanoSec();
+			bNewOk = pDoc->CreateFromFile(sFile);
+			lNewTime += cPlatform::GetApplicationTimeNanoSec() - lStartTime;
+		}
+
+		////////////////////////////
+		// Compare
+		bool bEqual = bTinyOk==bNewOk;
+		if(bTinyOk && bNewOk)
+		{
+			bEqual = pTinyDoc->RootElement() && ElementsAreEqual(pTinyDoc->RootElement(), pDoc);
+		}
+		if(bEqual==false)
+		{
+			printf(" Results differ for '%s'!\n", cString::To8Char(sFile).c_str());
+			lFailedNum++;
+		}
+
+		FILE *pFile = cPlatform::OpenFile(sFile, _W("rb"));
+		if(pFile)
+		{
+			fseek(pFile, 0, SEEK_END);
+			lTotalSize += (size_t)ftell(pFile);
+			fclose(pFile);
+		}
+
+		delete pTinyDoc;
+		hplDelete(pDoc);
+	}
+
+	bool bReuseOk = SetAttributeReusesValue();
+
+	////////////////////////////
+	// Print result
+	double fTinyMs = (double)lTinyTime / 1000000.0 / (double)glIterations;
+	double fNewMs = (double)lNewTime / 1000000.0 / (double)glIterations;
+	double fMB = (double)lTotalSize / (1024.0*1024.0);
+
+	printf("Files: %d (%.2f MB) Iterations: %d\n", (int)gvFiles.size(), fMB, glIterations);
+	printf(" TinyXML:     %10.3f ms per pass %8.1f MB/s\n", fTinyMs, fTinyMs > 0 ? fMB * 1000.0 / fTinyMs : 0.0);
+	printf(" cXmlParser:  %10.3f ms per pass %8.1f MB/s\n", fNewMs, fNewMs > 0 ? fMB * 1000.0 / fNewMs : 0.0);
+	if(lNewTime > 0) printf(" Speedup: %.2fx\n", (double)lTinyTime / (double)lNewTime);
+	printf("Files with different results: %d\n", lFailedNum);
+	printf("SetAttribute reuses value memory: %s\n", bReuseOk ? "yes" : "NO");
+
+	return lFailedNum == 0 && bReuseOk;
+}
+
+//------------------------------------------
+
+#ifdef WIN32
+	int main(int argc, const char* argv[] )
+	{
+		tString asCommandLine;
+		for(int i=1; i<argc; ++i)
+		{
+			asCommandLine += argv[i];
+			if(i!=argc-1) asCommandLine += " ";
+		}
+
+#else
+	int hplMain(const tString &asCommandLine)
+	{
+#endif
+
+	SetLogFile(_W("XmlBench.log"));
+
+	ParseCommandLine(asCommandLine);
+	if(gsDir == _W(""))
+	{
+		printf("Usage: XmlBench [-subdirs] [-iterations <num>] <dir>\n");
+		return 1;
+	}
+
+	return RunBenchmark() ? 0 : 1;
+}
+
+#ifdef WIN32
+	int hplMain(const tString &asCommandLine){return -1;}
+#endif
+
+#ifdef __APPLE__
+extern "C" int SDL_main(int argc, char *argv[]);
+int main(int argc, char * argv[]) {
+    return SDL_main(argc, argv);
+}
+#endif
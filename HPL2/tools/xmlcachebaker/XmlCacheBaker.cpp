@@ -0,0 +1,178 @@
+/*
+ * Copyright © 2009-2020 Frictional Games
+ *
+ * This file is part of Amnesia: The Dark Descent.
+ *
+ * Amnesia: The Dark Descent is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * Amnesia: The Dark Descent is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Amnesia: The Dark Descent.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Bakes XML caches (.ent_cache, .mat_cache and .ps_cache) for all entity, material and particle files in a directory.
+ * No engine is created, so it can be run from anywhere:
+ *
+ *   XmlCacheBaker [-subdirs] [-force] <dir>
+ */
+
+#include "hpl.h"
+
+#include "impl/XmlDocumentTiny.h"
+#include "resources/XmlCache.h"
+
+using namespace hpl;
+
+//------------------------------------------
+
+bool gbSubDirs = false;
+bool gbForce = false;
+tWString gsDir = _W("");
+
+const wchar_t* gvExtensions[] = { _W("*.ent"), _W("*.mat"), _W("*.ps") };
+const int glExtensionNum = sizeof(gvExtensions) / sizeof(gvExtensions[0]);
+
+int glNumOfBaked = 0;
+int glNumOfSkipped = 0;
+int glNumOfProblems = 0;
+
+//------------------------------------------
+
+void ParseCommandLine(const tString &asCommandLine)
+{
+	tStringVec args;
+	tString sSepp = " ";
+	cString::GetStringVec(asCommandLine, args,&sSepp);
+
+	for(size_t i=0; i<args.size(); ++i)
+	{
+		const tString &sArg = args[i];
+
+		if(sArg == "-subdirs")
+		{
+			gbSubDirs = true;
+		}
+		else if(sArg == "-force")
+		{
+			gbForce = true;
+		}
+		else
+		{
+			gsDir = cString::To16Char(sArg);
+		}
+	}
+}
+
+//------------------------------------------
+
+void BakeFile(const tWString &asFile)
+{
+	tWString sCachePath = cXmlCache::GetCacheFile(asFile);
+
+	//Loading with the cache creates it if it is missing or out of date, so if it is there first check if it can be used as is.
+	if(gbForce==false && cPlatform::FileExists(sCachePath))
+	{
+		cXmlDocumentTiny doc("");
+		if(cXmlCache::Load(&doc, asFile))
+		{
+			glNumOfSkipped++;
+			return;
+		}
+	}
+
+	cXmlDocumentTiny doc("");
+	if(doc.CreateFromFile(asFile)==false || cXmlCache::Save(&doc, asFile)==false)
+	{
+		printf(" Failed '%s'\n", cString::To8Char(cString::GetFileNameW(asFile)).c_str());
+		glNumOfProblems++;
+		return;
+	}
+
+	glNumOfBaked++;
+}
+
+//------------------------------------------
+
+void BakeFilesInDir(const tWString &asDir)
+{
+	//////////////////////////
+	//Iterate files and bake
+	for(int i=0; i<glExtensionNum; ++i)
+	{
+		tWStringList lstFiles;
+		cPlatform::FindFilesInDir(lstFiles, asDir, gvExtensions[i]);
+
+		for(tWStringListIt it = lstFiles.begin(); it != lstFiles.end(); ++it)
+		{
+			BakeFile(cString::SetFilePathW(*it, asDir));
+		}
+	}
+
+	if(gbSubDirs==false) return;
+
+	//////////////////////////
+	//Iterate folders
+	tWStringList lstFolders;
+	cPlatform::FindFoldersInDir(lstFolders, asDir, false);
+	for(tWStringListIt it = lstFolders.begin(); it != lstFolders.end(); ++it)
+	{
+		BakeFilesInDir(cString::SetFilePathW(*it, asDir));
+	}
+}
+
+//------------------------------------------
+
+#ifdef WIN32
+	int main(int argc, const char* argv[] )
+	{
+		tString asCommandLine;
+		for(int i=1; i<argc; ++i)
+		{
+			asCommandLine += argv[i];
+			if(i!=argc-1) asCommandLine += " ";
+		}
+
+#else
+	int hplMain(const tString &asCommandLine)
+	{
+#endif
+
+	SetLogFile(_W("XmlCacheBaker.log"));
+
+	ParseCommandLine(asCommandLine);
+	if(gsDir == _W(""))
+	{
+		printf("Usage: XmlCacheBaker [-subdirs] [-force] <dir>\n");
+		return 1;
+	}
+
+	printf("-------- XML CACHE BAKING STARTED! -----------\n\n");
+
+	unsigned long lStartTime = cPlatform::GetApplicationTime();
+
+	BakeFilesInDir(gsDir);
+
+	printf("\nBaked: %d Skipped: %d Problems: %d (%lums)\n", glNumOfBaked, glNumOfSkipped, glNumOfProblems, cPlatform::GetApplicationTime()-lStartTime);
+	printf("-------- XML CACHE BAKING DONE! -----------\n");
+
+	return glNumOfProblems > 0 ? 1 : 0;
+}
+
+#ifdef WIN32
+	int hplMain(const tString &asCommandLine){return -1;}
+#endif
+
+#ifdef __APPLE__
+extern "C" int SDL_main(int argc, char *argv[]);
+int main(int argc, char * argv[]) {
+    return SDL_main(argc, argv);
+}
+#endif
@@ -148,7 +148,7 @@ void cLuxArea_SlimeDamage::OnUpdate(float afTimeStep)
 		//Run Callback
 		if(msCallback != "")
 		{
-			mpMap->RunScript(msCallback+"(\""+msName+"\")");
+			mpMap->RunCallback(msCallback, cScriptArgs().AddString(msName));
 		}
 
 		/////////////////////////
@@ -211,7 +211,7 @@ void cLuxArea_Sticky::DetachBody()
 	//Callback function
 	if(msDetachFunction!="")
 	{
-		mpMap->RunScript(GetCallbackFunc(msDetachFunction,mpAttachedBody));
+		mpMap->RunCallback(msDetachFunction, cScriptArgs().AddString(msName).AddString(mpAttachedBody->GetName()));
 	}
 
 	//Sound
@@ -401,7 +401,7 @@ void cLuxArea_Sticky::UpdateCollision(float afTimeStep)
 		// Call callback and see if it should be attached.
 		if(msAttachFunction!="")
 		{
-			mpMap->RunScript(GetCallbackFunc(msAttachFunction,pBody));
+			mpMap->RunCallback(msAttachFunction, cScriptArgs().AddString(msName).AddString(pBody->GetName()));
 
 			if(mbAllowAttachment==false) continue;
 		}
@@ -414,13 +414,6 @@ void cLuxArea_Sticky::UpdateCollision(float afTimeStep)
 }
 
 
-//-----------------------------------------------------------------------
-
-tString cLuxArea_Sticky::GetCallbackFunc(const tString &asFunc,iPhysicsBody *apBody)
-{
-	return asFunc + "(\"" + msName + "\",\"" + apBody->GetName() + "\")";
-}
-
 //-----------------------------------------------------------------------
 
 //////////////////////////////////////////////////////////////////////////
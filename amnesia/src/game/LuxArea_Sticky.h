@@ -102,7 +102,6 @@ private:
 	void UpdateCollision(float afTimeStep);
 
 
-	tString GetCallbackFunc(const tString &asFunc,iPhysicsBody *apBody);
 
 	/////////////////////////
 	// Data
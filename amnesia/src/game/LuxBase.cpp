@@ -1188,8 +1188,15 @@ bool cLuxBase::InitEngine()
 	pMatMgr->SetTextureFilter((eTextureFilter)mpConfigHandler->mlTextureFilter);
 	pMatMgr->SetTextureAnisotropy(mpConfigHandler->mfTextureAnisotropy);
 
+	//Memory budgets in MB, 0 means no budget.
+	cResources *pResources = mpEngine->GetResources();
+	pResources->GetTextureManager()->SetMemoryBudget((size_t)mpMainConfig->GetInt("Graphics","TextureMemoryBudget", 0) * 1024*1024);
+	pResources->GetSoundManager()->SetMemoryBudget((size_t)mpMainConfig->GetInt("Sound","SampleMemoryBudget", 0) * 1024*1024);
+	pResources->SetMemoryBudget((size_t)mpMainConfig->GetInt("Engine","ResourceMemoryBudget", 0) * 1024*1024);
+
 	cSound *pSound = mpEngine->GetSound();
 	pSound->GetLowLevel()->SetVolume(mpMainConfig->GetFloat("Sound","Volume",1.0f));
+	pSound->GetSoundHandler()->SetBlockRayBudget(mpMainConfig->GetInt("Sound","OcclusionRayBudget", 8));
 
 	/////////////////////////
 	//Load configurations
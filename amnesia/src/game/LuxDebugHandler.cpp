@@ -1347,7 +1347,7 @@ void cLuxDebugHandler::TestChangeMapSave()
 
 	pSavedMaps->LoadMap(pMap);
 
-	pMap->RunScript("OnEnter()");
+	pMap->RunCallback("OnEnter");
 
 	///////////////////
 	// Destroy mesh and animation cache
@@ -37,8 +37,11 @@ cLuxEnemyPathfinder::cLuxEnemyPathfinder(iLuxEnemy *apEnemy, cLuxEnemyMover *apM
 	mpMover = apMover;
 
 	mbMoving = false;
+	mbFollowingPath = false;
+	mbPathFound = false;
 
-	mpAStar = NULL;
+	mpPathRequests = NULL;
+	mlPathRequest = -1;
 	mpNodeContainer = NULL;
 }
 
@@ -46,8 +49,8 @@ cLuxEnemyPathfinder::cLuxEnemyPathfinder(iLuxEnemy *apEnemy, cLuxEnemyMover *apM
 
 cLuxEnemyPathfinder::~cLuxEnemyPathfinder()
 {
-	cWorld *pWorld = mpEnemy->mpMap->GetWorld();
-	if(mpAStar) pWorld->DestroyAStarHandler(mpAStar);
+	//The queue is owned by the world
+	CancelPathRequest();
 }
 
 //-----------------------------------------------------------------------
@@ -75,32 +78,35 @@ void cLuxEnemyPathfinder::AfterWorldLoad()
 		Error("No node container found for enemy '%s'\n", mpEnemy->GetName().c_str());
 
 	if(mpNodeContainer)
-		mpAStar = pWorld->CreateAStarHandler(mpNodeContainer);
+		mpPathRequests = pWorld->GetAIPathRequestQueue(mpNodeContainer);
 	else
-		mpAStar = NULL;
+		mpPathRequests = NULL;
 }
 
 //-----------------------------------------------------------------------
 
-bool cLuxEnemyPathfinder::MoveTo(const cVector3f& avPos)
+bool cLuxEnemyPathfinder::MoveTo(const cVector3f& avPos, bool abWaitForPath)
 {
 	///////////////////////
 	// Set up data
 	iCharacterBody *pCharBody = mpEnemy->mpCharBody;
 
-	mlstPathNodeDistances.clear();
-	mlstPathNodes.clear();
 	mbMoving = true;
+	CancelPathRequest();
 
 	/////////////////////////////////////
-	//Get the start and goal position
+	//Get the start position
 	cVector3f vStartPos = pCharBody->GetPosition();
-	mvMoveGoalPos = avPos;
 
 	/////////////////////////////////////
 	//No path finding just go straight to goal.
-	if(mpAStar==NULL)
+	if(mpPathRequests==NULL)
 	{
+		mlstPathNodeDistances.clear();
+		mlstPathNodes.clear();
+		mvMoveGoalPos = avPos;
+		mbFollowingPath = true;
+		mbPathFound = false;
 		return false;
 	}
 
@@ -114,24 +120,34 @@ bool cLuxEnemyPathfinder::MoveTo(const cVector3f& avPos)
 	vStartPos.y += 0.01f;
 
 	/////////////////////////////////
-	//Get the nodes of the path
-	bool bRet = mpAStar->GetPath(vStartPos,mvMoveGoalPos,&mlstPathNodes);
-
-	if(bRet==false)
+	//Get the nodes of the path right away
+	if(abWaitForPath)
 	{
-		//Log("Could not find path!\n");
-		//TODO: Debug output
+		mlstPathNodeDistances.clear();
+		mlstPathNodes.clear();
+		mvMoveGoalPos = avPos;
+		mbFollowingPath = true;
+		mbPathFound = mpPathRequests->GetPath(vStartPos,mvMoveGoalPos,&mlstPathNodes);
+
+		return mbPathFound;
 	}
 
+	/////////////////////////////////
+	//Request the nodes of the path, these are collected in OnUpdate once solved.
+	//Until then any current path is followed, so enemies that move to new positions often do not stop each time.
+	mvRequestGoalPos = avPos;
+	mlPathRequest = mpPathRequests->RequestPath(vStartPos,mvRequestGoalPos);
 
-	return bRet;
+	return true;
 }
 
 //-----------------------------------------------------------------------
 
 void cLuxEnemyPathfinder::Stop()
 {
+	CancelPathRequest();
 	mbMoving = false;
+	mbFollowingPath = false;
 	mlstPathNodes.clear();
 	mlstPathNodeDistances.clear();
 }
@@ -233,6 +249,7 @@ void cLuxEnemyPathfinder::OnUpdate(float afTimeStep)
 {
 	//TODO: Check if goal position is reached!
 	//TODO: Check if Path end is reached. If so notify higher level
+	UpdatePathRequest();
 	UpdateMoving(afTimeStep);
 }
 
@@ -320,6 +337,8 @@ cVector3f  cLuxEnemyPathfinder::GetNextGoalPos()
 
 const cVector3f& cLuxEnemyPathfinder::GetFinalGoalPos()
 {
+	if(mlPathRequest >= 0) return mvRequestGoalPos;
+
 	return mvMoveGoalPos;
 }
 
@@ -331,10 +350,48 @@ const cVector3f& cLuxEnemyPathfinder::GetFinalGoalPos()
 
 //-----------------------------------------------------------------------
 
+void cLuxEnemyPathfinder::UpdatePathRequest()
+{
+	if(mlPathRequest < 0) return;
+
+	eAIPathRequestState state = mpPathRequests->GetRequestState(mlPathRequest);
+	if(state == eAIPathRequestState_Pending) return;
+
+	//Switch over to the new path
+	mlstPathNodeDistances.clear();
+	mlstPathNodes.clear();
+	mvMoveGoalPos = mvRequestGoalPos;
+	mbFollowingPath = true;
+
+	mbPathFound = mpPathRequests->GetRequestResult(mlPathRequest, &mlstPathNodes);
+	mlPathRequest = -1;
+
+	if(mbPathFound==false)
+	{
+		//Log("Could not find path!\n");
+		//TODO: Debug output
+	}
+}
+
+//-----------------------------------------------------------------------
+
+void cLuxEnemyPathfinder::CancelPathRequest()
+{
+	if(mlPathRequest < 0) return;
+
+	mpPathRequests->CancelRequest(mlPathRequest);
+	mlPathRequest = -1;
+}
+
+//-----------------------------------------------------------------------
+
 void cLuxEnemyPathfinder::UpdateMoving(float afTimeStep)
 {
 	if(mbMoving==false) return;
 
+	//Wait for the first path before moving, else the enemy walks straight towards the goal.
+	if(mbFollowingPath==false) return;
+
 	iCharacterBody *pCharBody = mpEnemy->mpCharBody;
 	cAINode *pCurrentNode = NULL;
 
@@ -392,8 +449,16 @@ void cLuxEnemyPathfinder::UpdateMoving(float afTimeStep)
 	{
 		if(mlstPathNodes.empty())
 		{
-			mbMoving = false;
-			mpEnemy->SendMessage(eLuxEnemyMessage_EndOfPath);
+			//The end of the old path was reached while waiting for a new one, wait for it instead of stopping.
+			if(mlPathRequest >= 0)
+			{
+				mbFollowingPath = false;
+			}
+			else
+			{
+				mbMoving = false;
+				mpEnemy->SendMessage(eLuxEnemyMessage_EndOfPath);
+			}
 		}
 		else
 		{
@@ -436,7 +501,7 @@ kEndSerialize()
 void cLuxEnemyPathfinder_SaveData::FromPathfinder(cLuxEnemyPathfinder *apPathfinder)
 {
 	mbMoving = apPathfinder->mbMoving;
-	mvMoveGoalPos = apPathfinder->mvMoveGoalPos;
+	mvMoveGoalPos = apPathfinder->GetFinalGoalPos();
 
 	for(tAINodeListIt it = apPathfinder->mlstPathNodes.begin(); it != apPathfinder->mlstPathNodes.end(); ++it)
 	{
@@ -451,6 +516,7 @@ void cLuxEnemyPathfinder_SaveData::FromPathfinder(cLuxEnemyPathfinder *apPathfin
 void cLuxEnemyPathfinder_SaveData::ToPathfinder(cLuxEnemyPathfinder *apPathfinder)
 {
 	apPathfinder->mbMoving = mbMoving;
+	apPathfinder->mbFollowingPath = mbMoving;
 	apPathfinder->mvMoveGoalPos = mvMoveGoalPos;
 }
 
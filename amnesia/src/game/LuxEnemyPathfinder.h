@@ -47,7 +47,12 @@ public:
 
 	//////////////////////
 	//Actions
-	bool MoveTo(const cVector3f& avPos);
+	/**
+	 * Starts moving to a position. The path is searched for in the background and any current path is followed until it is done.
+	 * \param abWaitForPath if true, the path is searched for right away and the return value is if one was found.
+	 * \return false if there is no path finding, true otherwise (unless abWaitForPath is set). Use IsWaitingForPath and GetPathFound for the result.
+	 */
+	bool MoveTo(const cVector3f& avPos, bool abWaitForPath=false);
 	void Stop();
 
 	cAINode* GetNodeAtPos(	const cVector3f &avPos,float afMinDistance,float afMaxDistance, bool abGetClosest,
@@ -61,6 +66,8 @@ public:
 	tAINodeList* GetNodeList(){ return &mlstPathNodes;}
 
 	bool IsMoving(){ return mbMoving;}
+	bool IsWaitingForPath(){ return mlPathRequest >= 0;}
+	bool GetPathFound(){ return mbPathFound;}
 	cVector3f GetNextGoalPos();
 	const cVector3f& GetFinalGoalPos();
 
@@ -78,16 +85,22 @@ public:
 	//Save data stuff
 
 private:
+	void UpdatePathRequest();
+	void CancelPathRequest();
 	void UpdateMoving(float afTimeStep);
 
 	iLuxEnemy *mpEnemy;
 	cLuxEnemyMover *mpMover;
 
 	cAINodeContainer *mpNodeContainer;
-	cAStarHandler *mpAStar;
+	cAIPathRequestQueue *mpPathRequests;
+	int mlPathRequest;
 
     bool mbMoving;
+	bool mbFollowingPath;
+	bool mbPathFound;
 	cVector3f mvMoveGoalPos;
+	cVector3f mvRequestGoalPos;
 
 	tAINodeList mlstPathNodes;
 	std::list<float> mlstPathNodeDistances;
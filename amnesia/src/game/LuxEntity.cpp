@@ -124,7 +124,7 @@ void iLuxEntity::RunCallbackFunc(const tString& asType)
 {
 	if(msCallbackFunc=="")return;
 
-	mpMap->RunScript(msCallbackFunc + "(\""+msName+"\", \""+asType+"\")" );
+	mpMap->RunCallback(msCallbackFunc, cScriptArgs().AddString(msName).AddString(asType));
 }
 
 //-----------------------------------------------------------------------
@@ -133,7 +133,7 @@ void iLuxEntity::RunInteractCallbackFunc()
 {
 	if(msInteractCallback=="")return;
 
-	mpMap->RunScript(msInteractCallback + "(\""+msName+"\")");
+	mpMap->RunCallback(msInteractCallback, cScriptArgs().AddString(msName));
 
 	if(mbInteractCallbackRemove) msInteractCallback = "";
 }
@@ -289,11 +289,11 @@ void iLuxEntity::UpdatePlayerLookAt(float afTimeStep)
 		tString sTempCallback = msLookAtCallback;
 		if(mbLookAtCallbackRemove) msLookAtCallback = "";
 
-		mpMap->RunScript(sTempCallback + "(\""+msName+"\", 1)" );
+		mpMap->RunCallback(sTempCallback, cScriptArgs().AddString(msName).AddInt(1));
 	}
 	else if(bLookingAt==false && mbIsLookedAt)
 	{
-		mpMap->RunScript(msLookAtCallback + "(\""+msName+"\", -1)" );
+		mpMap->RunCallback(msLookAtCallback, cScriptArgs().AddString(msName).AddInt(-1));
 	}
 
 	mbIsLookedAt = bLookingAt;
@@ -307,8 +307,7 @@ void iLuxEntity::ConnectionStateChange(int alState)
 	// Callback
 	if(msConnectionStateChangeCallback != "")
 	{
-		mpMap->RunScript(	msConnectionStateChangeCallback +
-							"(\""+msName+"\", "+ cString::ToString(alState) + ")");
+		mpMap->RunCallback(msConnectionStateChangeCallback, cScriptArgs().AddString(msName).AddInt(alState));
 	}
 
     //////////////////////////////////
@@ -333,11 +332,9 @@ void iLuxEntity::ConnectionStateChange(int alState)
 		if(pConn->GetCallbackFunc()!="")
 		{
 			//Syntax: ConnectionName,ParentEnt, ChildEnt, state
-			tString sCommand = pConn->GetCallbackFunc() + "(\"" + pConn->GetName() + "\"," +
-															"\"" + msName +  + "\"," +
-															"\"" + pConn->GetEntity()->GetName() + "\"," +
-															cString::ToString(lState) + ")";
-			mpMap->RunScript(sCommand);
+			cScriptArgs args;
+			args.AddString(pConn->GetName()).AddString(msName).AddString(pConn->GetEntity()->GetName()).AddInt(lState);
+			mpMap->RunCallback(pConn->GetCallbackFunc(), args);
 		}
 	}
 }
@@ -61,7 +61,7 @@ void cLuxGlobalDataHandler::LoadAndInitGlobalScript()
 {
 	LoadScript();
 
-	RunScript("OnGameStart()");
+	RunCallback("OnGameStart");
 }
 
 //-----------------------------------------------------------------------
@@ -155,6 +155,13 @@ void cLuxGlobalDataHandler::RunScript(const tString& asCommand)
 	mpScript->Run(asCommand);
 }
 
+void cLuxGlobalDataHandler::RunCallback(const tString& asFunc, const cScriptArgs& aArgs)
+{
+	if(mpScript==NULL) return;
+
+	mpScript->RunCallback(asFunc, aArgs);
+}
+
 //-----------------------------------------------------------------------
 
 cLuxScriptVar* cLuxGlobalDataHandler::GetVar(const tString &asName)
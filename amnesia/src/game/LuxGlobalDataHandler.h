@@ -46,6 +46,7 @@ public:
 	bool RecompileScript(tString *apOutput);
 
 	void RunScript(const tString& asCommand);
+	void RunCallback(const tString& asFunc, const cScriptArgs& aArgs=cScriptArgs());
 
 	cLuxScriptVar* GetVar(const tString &asName);
 
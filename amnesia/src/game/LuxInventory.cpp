@@ -325,7 +325,7 @@ bool cLuxInventory_Slot::OnMouseUp(iWidget* apWidget, const cGuiMessageData& aDa
 			{
 				bool bAutoDestroy = pComb->mbAutoDestroy;
 				tString sCombName = pComb->msName;
-				mpInventory->RunScript(pComb->msFunction+ "(\"" + pComb->msItemA + "\", \"" + pComb->msItemB + "\")" );
+				mpInventory->RunCallback(pComb->msFunction, cScriptArgs().AddString(pComb->msItemA).AddString(pComb->msItemB));
 
 				if(bAutoDestroy)
 				{
@@ -648,7 +648,7 @@ void cLuxInventory::OnGameStart()
 {
 	LoadScript();
 
-	RunScript("OnGameStart()");
+	RunCallback("OnGameStart");
 }
 
 //-----------------------------------------------------------------------
@@ -1324,6 +1324,13 @@ void cLuxInventory::RunScript(const tString& asCommand)
     mpScript->Run(asCommand);
 }
 
+void cLuxInventory::RunCallback(const tString& asFunc, const cScriptArgs& aArgs)
+{
+	if(mpScript==NULL) return;
+
+	mpScript->RunCallback(asFunc, aArgs);
+}
+
 bool cLuxInventory::RecompileScript(tString *apOutput)
 {
 	if(mpScript)
@@ -222,6 +222,7 @@ public:
 	cLuxCombineItemsCallback* GetCombineCallback(const tString& asItemA, const tString& asItemB);
 
 	void RunScript(const tString& asCommand);
+	void RunCallback(const tString& asFunc, const cScriptArgs& aArgs=cScriptArgs());
 	bool RecompileScript(tString *apOutput);
 
 	void SetDescTextFromItem(cLuxInventory_Item *apItem);
@@ -210,7 +210,7 @@ bool cLuxItemType_Diary::BeforeAddItem(cLuxInventory_Item *apItem)
 	{
 		cLuxMap *pMap = gpBase->mpMapHandler->GetCurrentMap();
 
-		pMap->RunScript(sCallbackFunc+"(\""+apItem->GetName()+ "\","+ cString::ToString(lDiaryIdx)+")" );
+		pMap->RunCallback(sCallbackFunc, cScriptArgs().AddString(apItem->GetName()).AddInt(lDiaryIdx));
 	}
 
 	if(mbShowJournalOnPickup)
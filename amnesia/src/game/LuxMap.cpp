@@ -350,11 +350,11 @@ void cLuxMap::OnEnter(bool abRunScript, bool abFirstTime)
 		{
 			if(abFirstTime)
 			{
-				mpScript->Run("OnStart()");
+				mpScript->RunCallback("OnStart", cScriptArgs());
 				CalculateTotalCompletionAmount();
 			}
 
-			mpScript->Run("OnEnter()");
+			mpScript->RunCallback("OnEnter", cScriptArgs());
 		}
 	}
 
@@ -367,7 +367,7 @@ void cLuxMap::OnLeave(bool abRunScript)
 {
 	if(abRunScript)
 	{
-		if(mpScript) mpScript->Run("OnLeave()");
+		if(mpScript) mpScript->RunCallback("OnLeave", cScriptArgs());
 	}
 }
 
@@ -407,6 +407,14 @@ void cLuxMap::RunScript(const tString& asCommand)
     mpScript->Run(asCommand);
 }
 
+void cLuxMap::RunCallback(const tString& asFunc, const cScriptArgs& aArgs)
+{
+	if(mpScript==NULL) return;
+	if(this != gpBase->mpMapHandler->GetCurrentMap()) return;
+
+	mpScript->RunCallback(asFunc, aArgs);
+}
+
 bool cLuxMap::RecompileScript(tString *apOutput)
 {
 	if(mpScript)
@@ -538,7 +546,7 @@ void cLuxMap::LoadCheckPoint()
 
 	//////////////////////////////
 	// Run script (last thing done!)
-	RunScript(msCheckPointCallback + "(\""+ msCheckPointName + "\", "+cString::ToString(mlCheckPointCount)+")"  );
+	RunCallback(msCheckPointCallback, cScriptArgs().AddString(msCheckPointName).AddInt(mlCheckPointCount));
 
 	mlCheckPointCount++;
 }
@@ -889,29 +897,7 @@ iPhysicsBody* cLuxMap::GetBodyFromEntityBodyIdPair(const cLuxIdPair &aIdPair)
 
 bool cLuxMap::CheckCollision(iLuxCollideCallbackContainer *apCollider1, iLuxCollideCallbackContainer* apCollider2)
 {
-	cCollideData collideData;
-	collideData.SetMaxSize(1);
-
-	for(int body1=0; body1<apCollider1->GetBodyNum(); ++body1)
-	for(int body2=0; body2<apCollider2->GetBodyNum(); ++body2)
-	{
-		iPhysicsBody *pBody1 = apCollider1->GetBody(body1);
-		iPhysicsBody *pBody2 = apCollider2->GetBody(body2);
-
-		if(cMath::CheckBVIntersection(*pBody1->GetBoundingVolume(), *pBody2->GetBoundingVolume())==false)
-		{
-			continue;
-		}
-
-		if(mpPhysicsWorld->CheckShapeCollision(pBody1->GetShape(), pBody1->GetLocalMatrix(),
-											pBody2->GetShape(), pBody2->GetLocalMatrix(),
-											collideData,1,false))
-		{
-			return true;
-		}
-	}
-
-	return false;
+	return apCollider1->CheckContainerCollision(apCollider2, mpPhysicsWorld);
 }
 
 //-----------------------------------------------------------------------
@@ -1341,7 +1327,7 @@ void cLuxMap::UpdateTimers(float afTimeStep)
 
 		if(pTimer->mfCount <=0 && pTimer->mbDestroyMe==false)
 		{
-			RunScript(pTimer->msFunction+"(\""+pTimer->msName+"\")");
+			RunCallback(pTimer->msFunction, cScriptArgs().AddString(pTimer->msName));
 			it = mlstTimers.erase(it);
 			hplDelete(pTimer);
 
@@ -89,6 +89,10 @@ public:
 	void Update(float afTimeStep);
 
 	void RunScript(const tString& asCommand);
+	/**
+	 * Runs a script function with arguments without compiling any code, use for callbacks.
+	 */
+	void RunCallback(const tString& asFunc, const cScriptArgs& aArgs=cScriptArgs());
 	bool RecompileScript(tString *apOutput);
 
 	void OnRenderSolid(cRendererCallbackFunctions* apFunctions);
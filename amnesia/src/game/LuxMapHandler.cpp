@@ -554,6 +554,7 @@ void cLuxMapHandler::LoadMainConfig()
 
 	cRenderSettings *pRenderSettings = mpViewport->GetRenderSettings();
 	pRenderSettings->mbUseEdgeSmooth = gpBase->mpConfigHandler->mbEdgeSmooth; //This is saved in config handler!
+	pRenderSettings->mbUseSoftwareOcclusionCulling = gpBase->mpMainConfig->GetBool("Graphics", "SoftwareOcclusionCulling", false);
 }
 
 void cLuxMapHandler::SaveMainConfig()
@@ -562,6 +563,9 @@ void cLuxMapHandler::SaveMainConfig()
 	gpBase->mpMainConfig->SetBool("Graphics", "PostEffectImageTrail", mpPostEffect_ImageTrail->IsDisabled()==false);
 	gpBase->mpMainConfig->SetBool("Graphics", "PostEffectSepia", mpPostEffect_Sepia->IsDisabled()==false);
 	gpBase->mpMainConfig->SetBool("Graphics", "PostEffectRadialBlur", mpPostEffect_RadialBlur->IsDisabled()==false);
+
+	cRenderSettings *pRenderSettings = mpViewport->GetRenderSettings();
+	gpBase->mpMainConfig->SetBool("Graphics", "SoftwareOcclusionCulling", pRenderSettings->mbUseSoftwareOcclusionCulling);
 }
 
 //-----------------------------------------------------------------------
@@ -620,7 +624,7 @@ void cLuxMapHandler::CheckMapChange(float afTimeStep)
 
 		//////////////////////
 		// Run onleave before saving!
-		mpCurrentMap->RunScript("OnLeave()");//since script is not run in SetCurrenMap
+		mpCurrentMap->RunCallback("OnLeave");//since script is not run in SetCurrenMap
 
 		///////////////////////////////////////
 		// Draw loading screen
@@ -679,8 +683,8 @@ void cLuxMapHandler::CheckMapChange(float afTimeStep)
 
 		//////////////////////
 		// Run enter script! (otherwise a save in oneter will not be correct!)
-		if(bFirstTime) mpCurrentMap->RunScript("OnStart()");
-		mpCurrentMap->RunScript("OnEnter()");
+		if(bFirstTime) mpCurrentMap->RunCallback("OnStart");
+		mpCurrentMap->RunCallback("OnEnter");
 
 
 		mpSavedGameMutex->Unlock();
@@ -979,7 +979,7 @@ void cLuxPlayerFlashback::Update(float afTimeStep)
 
 			cLuxMap *pMap = gpBase->mpMapHandler->GetCurrentMap();
 			if(msCallback != "")
-				pMap->RunScript(msCallback + "()");
+				pMap->RunCallback(msCallback);
 		}
 	}
 
@@ -1084,7 +1084,7 @@ void cLuxPlayerLookAt::Update(float afTimeStep)
 	float fTotalDist = vDist.x*vDist.x + vDist.y*vDist.y;
 	if(fTotalDist < 0.01)
 	{
-		gpBase->mpMapHandler->GetCurrentMap()->RunScript(msAtTargetCallback+"()");
+		gpBase->mpMapHandler->GetCurrentMap()->RunCallback(msAtTargetCallback);
 	}
 }
 
@@ -1832,7 +1832,7 @@ void cLuxPlayerLantern::SetActive(bool abX, bool abUseEffects, bool abCheckForOi
 	cLuxMap *pMap = gpBase->mpMapHandler->GetCurrentMap();
 	if(pMap->GetLanternLitCallback()!="")
 	{
-		pMap->RunScript(pMap->GetLanternLitCallback()+"(" + (mbActive ? "true" : "false") + ")" );
+		pMap->RunCallback(pMap->GetLanternLitCallback(), cScriptArgs().AddBool(mbActive));
 	}
 }
 
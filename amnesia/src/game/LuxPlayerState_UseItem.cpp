@@ -205,7 +205,7 @@ void cLuxPlayerState_UseItem::UseItem()
             // Running the script MAY destroy this item so "Backup" the check flag.
             bool bAutoDestroy = pCallback->mbAutoDestroy;
 			tString sName = pCallback->msName;
-            pMap->RunScript(pCallback->msFunction+ "(\"" + pCallback->msItem + "\", \"" + pCallback->msEntity + "\")" );
+            pMap->RunCallback(pCallback->msFunction, cScriptArgs().AddString(pCallback->msItem).AddString(pCallback->msEntity));
 
 			if(bAutoDestroy)
 			{
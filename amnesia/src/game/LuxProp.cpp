@@ -1208,7 +1208,7 @@ void iLuxProp::UpdateAnimation(float afTimeStep)
 	{
 		mlCurrentNonLoopAnimIndex = -1;
 		if(msAnimCallback !="")
-			mpMap->RunScript(msAnimCallback + "(\""+ msName + "\")");
+			mpMap->RunCallback(msAnimCallback, cScriptArgs().AddString(msName));
 	}
 }
 
@@ -368,7 +368,7 @@ void cLuxProp_MultiSlider::ChangeState(int alState, bool abEffects)
 	//Callback
 	if(msChangeStateCallback!="")
 	{
-		mpMap->RunScript(msChangeStateCallback + "(\""+msName+"\", "+cString::ToString(mlCurrentState)+")");
+		mpMap->RunCallback(msChangeStateCallback, cScriptArgs().AddString(msName).AddInt(mlCurrentState));
 	}
 }
 
@@ -132,6 +132,7 @@ iFontData* iLuxUpdateable::LoadFont(const tString& asFile)
 iLuxCollideCallbackContainer::iLuxCollideCallbackContainer()
 {
 	mbUpdatingCollideCallbacks = false;
+	mlCollideBoundsCount = 0;
 }
 
 void iLuxCollideCallbackContainer::DestroyCollideCallbacks()
@@ -152,8 +153,14 @@ void iLuxCollideCallbackContainer::DestroyCollideCallbacks()
 
 void iLuxCollideCallbackContainer::CheckCollisionCallback(const tString& asName, cLuxMap *apMap)
 {
+	if(mlstCollideCallbacks.empty()) return;
+
+	PROFILE_ZONE(CollideCallbacks);
+
 	mbUpdatingCollideCallbacks = true;
 
+	UpdateCollideBounds();
+
 	/////////////////////
 	//Iterate the collide callbacks
 	for(tLuxCollideCallbackListIt it = mlstCollideCallbacks.begin(); it != mlstCollideCallbacks.end(); ++it)
@@ -165,7 +172,20 @@ void iLuxCollideCallbackContainer::CheckCollisionCallback(const tString& asName,
 		if(pEntity==NULL) continue;
 		if(pEntity->IsActive()==false) continue;
 
-		bCollide = CheckEntityCollision(pEntity, apMap);
+		/////////////////////
+		//Only check again if something has moved since last time
+		pEntity->UpdateCollideBounds();
+		if(	pCallback->mlCheckedBoundsCount == mlCollideBoundsCount &&
+			pCallback->mlCheckedEntityBoundsCount == pEntity->GetCollideBoundsCount())
+		{
+			bCollide = pCallback->mbColliding;
+		}
+		else
+		{
+			bCollide = CheckEntityCollision(pEntity, apMap);
+			pCallback->mlCheckedBoundsCount = mlCollideBoundsCount;
+			pCallback->mlCheckedEntityBoundsCount = pEntity->GetCollideBoundsCount();
+		}
 
 		/////////////////////
 		//Handle collision
@@ -175,8 +195,7 @@ void iLuxCollideCallbackContainer::CheckCollisionCallback(const tString& asName,
             pCallback->mbColliding = bCollide;
 			if(lState == pCallback->mlStates || pCallback->mlStates==0)
 			{
-				tString sCommand = pCallback->msCallbackFunc+"(\"" + asName + "\", \""+ pEntity->GetName()+"\", "+cString::ToString(lState)+")" ;
-				apMap->RunScript(sCommand);
+				apMap->RunCallback(pCallback->msCallbackFunc, cScriptArgs().AddString(asName).AddString(pEntity->GetName()).AddInt(lState));
 
 				///////////////////////
 				// Auto remove
@@ -223,27 +242,51 @@ void iLuxCollideCallbackContainer::CheckCollisionCallback(const tString& asName,
 
 bool iLuxCollideCallbackContainer::CheckEntityCollision(iLuxEntity*apEntity, cLuxMap *apMap)
 {
-	iPhysicsWorld *pPhysicsWorld =apMap->GetPhysicsWorld();
+	return CheckContainerCollision(apEntity, apMap->GetPhysicsWorld());
+}
+
+//-----------------------------------------------------------------------
+
+bool iLuxCollideCallbackContainer::CheckContainerCollision(iLuxCollideCallbackContainer *apContainer, iPhysicsWorld *apPhysicsWorld)
+{
+	UpdateCollideBounds();
+	apContainer->UpdateCollideBounds();
+
+	/////////////////////
+	//Check the bounds of all bodies first
+	if(mvCollideBodies.empty() || apContainer->mvCollideBodies.empty()) return false;
+	if(cMath::CheckAABBIntersection(mvCollideMin, mvCollideMax, apContainer->mvCollideMin, apContainer->mvCollideMax)==false)
+	{
+		return false;
+	}
 
 	cCollideData collideData;
 	collideData.SetMaxSize(1);
 
     /////////////////////
 	//Iterate bodies and check for collision
-	for(int i=0; i<GetBodyNum(); ++i)
+	for(size_t i=0; i<mvCollideBodies.size(); ++i)
 	{
-		for(int j=0; j<apEntity->GetBodyNum(); ++j)
+		if(cMath::CheckAABBIntersection(mvCollideBodyMin[i], mvCollideBodyMax[i], apContainer->mvCollideMin, apContainer->mvCollideMax)==false)
 		{
-			iPhysicsBody *pBodyA = GetBody(i);
-			iPhysicsBody *pBodyB = apEntity->GetBody(i);
+			continue;
+		}
 
-			if(cMath::CheckBVIntersection(*pBodyA->GetBoundingVolume(), *pBodyB->GetBoundingVolume()))
+		for(size_t j=0; j<apContainer->mvCollideBodies.size(); ++j)
+		{
+			if(cMath::CheckAABBIntersection(mvCollideBodyMin[i], mvCollideBodyMax[i],
+											apContainer->mvCollideBodyMin[j], apContainer->mvCollideBodyMax[j])==false)
 			{
-				bool bCollide = pPhysicsWorld->CheckShapeCollision(	pBodyA->GetShape(), pBodyA->GetLocalMatrix(),
-																	pBodyB->GetShape(), pBodyB->GetLocalMatrix(),
-																	collideData,1,false);
-				if(bCollide) return true;
+				continue;
 			}
+
+			iPhysicsBody *pBodyA = mvCollideBodies[i];
+			iPhysicsBody *pBodyB = apContainer->mvCollideBodies[j];
+
+			bool bCollide = apPhysicsWorld->CheckShapeCollision(pBodyA->GetShape(), pBodyA->GetLocalMatrix(),
+																pBodyB->GetShape(), pBodyB->GetLocalMatrix(),
+																collideData,1,false);
+			if(bCollide) return true;
 		}
 	}
 
@@ -252,6 +295,52 @@ bool iLuxCollideCallbackContainer::CheckEntityCollision(iLuxEntity*apEntity, cLu
 
 //-----------------------------------------------------------------------
 
+void iLuxCollideCallbackContainer::UpdateCollideBounds()
+{
+	int lBodyNum = GetBodyNum();
+
+	/////////////////////
+	//Check if any body has changed
+	bool bChanged = lBodyNum != (int)mvCollideBodies.size();
+	for(int i=0; i<lBodyNum && bChanged==false; ++i)
+	{
+		iPhysicsBody *pBody = GetBody(i);
+		if(pBody != mvCollideBodies[i] || (pBody && pBody->GetTransformUpdateCount() != mvCollideBodyTransformCounts[i]))
+		{
+			bChanged = true;
+		}
+	}
+	if(bChanged==false) return;
+
+	/////////////////////
+	//Get the bounds of all bodies
+	mvCollideBodies.clear();
+	mvCollideBodyTransformCounts.clear();
+	mvCollideBodyMin.clear();
+	mvCollideBodyMax.clear();
+	mvCollideMin = cVector3f(100000.0f);
+	mvCollideMax = cVector3f(-100000.0f);
+
+	for(int i=0; i<lBodyNum; ++i)
+	{
+		iPhysicsBody *pBody = GetBody(i);
+		if(pBody==NULL) continue;
+
+		cBoundingVolume *pBV = pBody->GetBoundingVolume();
+
+		mvCollideBodies.push_back(pBody);
+		mvCollideBodyTransformCounts.push_back(pBody->GetTransformUpdateCount());
+		mvCollideBodyMin.push_back(pBV->GetMin());
+		mvCollideBodyMax.push_back(pBV->GetMax());
+
+		cMath::ExpandAABB(mvCollideMin, mvCollideMax, pBV->GetMin(), pBV->GetMax());
+	}
+
+	++mlCollideBoundsCount;
+}
+
+//-----------------------------------------------------------------------
+
 void iLuxCollideCallbackContainer::AddCollideCallback(iLuxEntity *apEntity, const tString& asCallbackFunc, bool abRemoveAtCollide, int alStates)
 {
 	////////////////////////////////
@@ -649,12 +649,18 @@ class cLuxMap;
 class cLuxCollideCallback
 {
 public:
+	cLuxCollideCallback() : mlCheckedBoundsCount(-1), mlCheckedEntityBoundsCount(-1) {}
+
 	iLuxEntity* mpCollideEntity;
 	tString msCallbackFunc;
 	bool mbDeleteWhenColliding;
 	int mlStates;
 
 	bool mbColliding;
+
+	//Bounds counts of both sides at the last check, mbColliding is kept until one of them changes.
+	int mlCheckedBoundsCount;
+	int mlCheckedEntityBoundsCount;
 };
 
 typedef std::list<cLuxCollideCallback*> tLuxCollideCallbackList;
@@ -672,6 +678,13 @@ public:
 
 	void CheckCollisionCallback(const tString& asName, cLuxMap *apMap);
 	bool CheckEntityCollision(iLuxEntity*apEntity, cLuxMap *apMap);
+	bool CheckContainerCollision(iLuxCollideCallbackContainer *apContainer, iPhysicsWorld *apPhysicsWorld);
+
+	/**
+	 * Updates the cached body bounds if any body has moved or the bodies have changed. The count is increased each time they are updated.
+	 */
+	void UpdateCollideBounds();
+	int GetCollideBoundsCount(){ return mlCollideBoundsCount;}
 
 	bool HasCollideCallbacks(){ return mlstCollideCallbacks.empty() == false;}
 	tLuxCollideCallbackList* GetCollideCallbackList(){ return &mlstCollideCallbacks;}
@@ -684,6 +697,14 @@ protected:
 	tLuxCollideCallbackList mlstCollideCallbacks;
 	tLuxCollideCallbackList mlstDeleteCallbacks;
 	bool mbUpdatingCollideCallbacks;
+
+	std::vector<iPhysicsBody*> mvCollideBodies;
+	std::vector<int> mvCollideBodyTransformCounts;
+	std::vector<cVector3f> mvCollideBodyMin;
+	std::vector<cVector3f> mvCollideBodyMax;
+	cVector3f mvCollideMin;
+	cVector3f mvCollideMax;
+	int mlCollideBoundsCount;
 };
 
 typedef std::list<iLuxCollideCallbackContainer*> tLuxCollideCallbackContainerList;